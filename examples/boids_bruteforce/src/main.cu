@@ -161,7 +161,8 @@ FLAMEGPU_AGENT_FUNCTION(inputdata, flamegpu::MessageBruteForce, flamegpu::Messag
     const float INTERACTION_RADIUS = FLAMEGPU->environment.getProperty<float>("INTERACTION_RADIUS");
     const float SEPARATION_RADIUS = FLAMEGPU->environment.getProperty<float>("SEPARATION_RADIUS");
     // Iterate location messages, accumulating relevant data and counts.
-    for (const auto &message : FLAMEGPU->message_in) {
+    // Every boid reads every message, so each block stages tiles of messages within shared memory.
+    for (const auto &message : FLAMEGPU->message_in.tiled()) {
         // Ignore self messages.
         if (message.getVariable<flamegpu::id_t>("id") != id) {
             // Get the message location and velocity.
@@ -18,7 +18,7 @@ FLAMEGPU_AGENT_FUNCTION(move, flamegpu::MessageBruteForce, flamegpu::MessageNone
     const float y1 = FLAMEGPU->getVariable<float>("y");
     const float z1 = FLAMEGPU->getVariable<float>("z");
     int count = 0;
-    for (const auto &message : FLAMEGPU->message_in) {
+    for (const auto &message : FLAMEGPU->message_in.tiled()) {
         if (message.getVariable<flamegpu::id_t>("id") != ID) {
             const float x2 = message.getVariable<float>("x");
             const float y2 = message.getVariable<float>("y");
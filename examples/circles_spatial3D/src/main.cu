@@ -166,15 +166,10 @@ int main(int argc, const char ** argv) {
      */
     if (cudaSimulation.getSimulationConfig().input_file.empty()) {
         // Currently population has not been init, so generate an agent population on the fly
-        std::default_random_engine rng;
-        std::uniform_real_distribution<float> dist(0.0f, ENV_MAX);
-        flamegpu::AgentVector population(model.Agent("Circle"), AGENT_COUNT);
-        for (unsigned int i = 0; i < AGENT_COUNT; i++) {
-            flamegpu::AgentVector::Agent instance = population[i];
-            instance.setVariable<float>("x", dist(rng));
-            instance.setVariable<float>("y", dist(rng));
-            instance.setVariable<float>("z", dist(rng));
-        }
+        flamegpu::PopulationGenerator generator;
+        generator.uniformBox<float>({"x", "y", "z"}, {0.0f, 0.0f, 0.0f}, {ENV_MAX, ENV_MAX, ENV_MAX});
+        flamegpu::AgentVector population(model.Agent("Circle"));
+        generator.generate(population, AGENT_COUNT, cudaSimulation.getSimulationConfig().random_seed);
         cudaSimulation.setPopulationData(population);
     }
 
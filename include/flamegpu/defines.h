@@ -17,6 +17,19 @@ constexpr const char* ID_VARIABLE_NAME = "_id";
  * If this value is changed, things may break
  */
 constexpr id_t ID_NOT_SET = 0;
+/**
+ * Internal variable name used to hold the step at which a sleeping agent wakes
+ * This variable is only present if sleeping has been enabled for the agent
+ * @see AgentDescription::setSleepEnabled(bool)
+ */
+constexpr const char* WAKE_STEP_VARIABLE_NAME = "_wake_step";
+/**
+ * Internal variable name used to hold the key of an agent's random stream
+ * This variable is only present if the agent can be output by an agent function
+ * It is 0 unless the agent was born on the device, in which case it is derived from its parent's key
+ * @see AgentFunctionDescription::setAgentOutput(AgentDescription &, const std::string)
+ */
+constexpr const char* RNG_KEY_VARIABLE_NAME = "_rng_key";
 
 }  // namespace flamegpu
 
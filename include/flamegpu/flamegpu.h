@@ -24,6 +24,7 @@
 #include "flamegpu/model/SubEnvironmentDescription.h"
 #include "flamegpu/pop/AgentVector.h"
 #include "flamegpu/pop/AgentInstance.h"
+#include "flamegpu/pop/PopulationGenerator.h"
 #include "flamegpu/gpu/CUDASimulation.h"
 #include "flamegpu/runtime/messaging.h"
 #include "flamegpu/runtime/AgentFunction_shim.cuh"
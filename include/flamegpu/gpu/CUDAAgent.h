@@ -8,6 +8,7 @@
 #include <mutex>
 #include <unordered_map>
 #include <list>
+#include <vector>
 
 // include sub classes
 #include "flamegpu/util/detail/JitifyCache.h"
@@ -15,7 +16,9 @@
 #include "flamegpu/model/AgentFunctionData.cuh"
 #include "flamegpu/model/SubAgentData.h"
 #include "flamegpu/runtime/detail/curve/curve_rtc.cuh"
+#include "flamegpu/runtime/detail/DeviceBirthBuffer.cuh"
 #include "flamegpu/sim/AgentInterface.h"
+#include "flamegpu/util/detail/CalendarQueue.cuh"
 
 namespace flamegpu {
 
@@ -61,6 +64,11 @@ class CUDAAgent : public AgentInterface {
         const CUDASimulation &_cudaSimulation,
         const std::unique_ptr<CUDAAgent> &master_agent,
         const std::shared_ptr<SubAgentData> &mapping);
+    /**
+     * Destructor
+     * Releases compact birth buffer counters, awake agent index lists and wake calendars
+     */
+    ~CUDAAgent();
     /** 
      * Uses the cuRVE runtime to map the variables used by the agent function to the cuRVE
      * library so that can be accessed by name within a n agent function
@@ -101,6 +109,11 @@ class CUDAAgent : public AgentInterface {
      * @param state The state to return information about
      */
     unsigned int getStateSize(const std::string &state) const override;
+    /**
+     * Returns the number of alive agents in the named state, including agents disabled by an agent function condition
+     * @param state The state to return information about
+     */
+    unsigned int getStateSizeWithDisabled(const std::string &state) const;
     /**
      * Returns the number of alive and active agents in the named state
      * @param state The state to return information about
@@ -115,6 +128,13 @@ class CUDAAgent : public AgentInterface {
      * @note This returns data_condition, such that the buffer does not include disabled agents
      */
     void *getStateVariablePtr(const std::string &state_name, const std::string &variable_name) override;
+    /**
+     * Returns the device pointer to the buffer for the associated state and variable, for read only access
+     * Unlike getStateVariablePtr(), this does not invalidate the wake calendars, so the caller must not write to the buffer
+     * @note Unlike getStateVariablePtr(), the buffer includes agents disabled by an agent function condition
+     * @see getStateSizeWithDisabled()
+     */
+    void *getStateVariableReadPtr(const std::string &state_name, const std::string &variable_name) const;
     /**
      * Processes agent death, this call is forwarded to the fat agent
      * All disabled agents are scattered to swap
@@ -173,6 +193,7 @@ class CUDAAgent : public AgentInterface {
     /**
      * Allocates a buffer for storing new agents into and
      * uses the cuRVE runtime to map variables for use with an agent function that has device agent birth
+     * If the agent function has an agent output birth rate below 1, births are allocated slots within the buffer as they occur (compact birth buffer)
      * @param func_agent The Cuda agent which the agent function belongs to (required so that RTC function instances can be obtained)
      * @param func The agent function being processed
      * @param maxLen The maximum number of new agents (this will be the size of the agent state executing func)
@@ -188,9 +209,21 @@ class CUDAAgent : public AgentInterface {
      * @param instance_id The CUDASimulation instance_id of the parent instance. This is added to the hash, to differentiate instances
      */
     void unmapNewRuntimeVariables(const AgentFunctionData& func, const unsigned int &instance_id);
+    /**
+     * If the agent function used a compact birth buffer, reads back the number of births
+     * Births which exceeded the buffer's capacity were spilled into the executing state's swap buffers,
+     * so the birth buffer is grown to hold every birth and the spilled births are copied into it
+     * This must be called after the agent function, before its agent death is processed (which reuses the swap buffers)
+     * @param func The agent function being processed
+     * @param scatter Scatter instance and scan arrays to be used (CUDASimulation::singletons->scatter)
+     * @param streamId The stream index to use for accessing stream specific resources such as scan compaction arrays and buffers
+     * @param stream CUDA stream to be used for async CUDA operations
+     */
+    void gatherSpilledBirths(const AgentFunctionData& func, CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream);
     /**
      * Scatters agents from the currently assigned device agent birth buffer (see member variable newBuffs)
      * The device buffer must be packed in the same format as mapNewRuntimeVariables(const AgentFunctionData&, const unsigned int &, const unsigned int &)
+     * If a compact birth buffer is in use, gatherSpilledBirths() must have been called first
      * @param func The agent function being processed
      * @param newSize The maximum number of new agents (this will be the size of the agent state executing func)
      * @param scatter Scatter instance and scan arrays to be used (CUDASimulation::singletons->scatter)
@@ -282,6 +315,40 @@ class CUDAAgent : public AgentInterface {
      * If the device value is changed, then the internal ID counter must be updated via CUDAAgent::scatterNew()
      */
     id_t* getDeviceNextID();
+    /**
+     * Returns a device pointer to the metadata of the compact birth buffer mapped for the agent function by mapNewRuntimeVariables()
+     * @param func The agent function which outputs this agent type
+     * @return nullptr if the agent function is using a full size birth buffer
+     */
+    detail::DeviceBirthBuffer *getDeviceBirthBuffer(const AgentFunctionData& func);
+    /**
+     * If the agent function only executes over awake agents, builds the list of indices of awake agents which will execute it
+     * Agents are awake if their wake step is not greater than stepCount
+     * @param func The agent function being processed
+     * @param stepCount The current step count of the simulation
+     * @param d_deathFlags If not nullptr, the agent death scan flags of the function's initial state, sleeping agents will be marked alive
+     * @param stream CUDA stream to be used for async CUDA operations
+     * @return The number of agents which will execute the agent function
+     * @note Whilst the state's wake calendar is valid, this only selects from the agents which have woken since it was built,
+     * and the number of awake agents is known without synchronising the stream. Otherwise the calendar is rebuilt, which synchronises the stream.
+     * @see AgentDescription::setSleepEnabled(bool)
+     */
+    unsigned int mapAwakeIndex(const AgentFunctionData& func, const unsigned int &stepCount, unsigned int *d_deathFlags, const cudaStream_t &stream);
+    /**
+     * Reinserts the agents which executed the agent function into their state's wake calendar, as they may have changed their wake step
+     * This only visits the agents which have woken since the calendar was built, the result is read back asynchronously
+     * @param func The agent function which has executed
+     * @param stepCount The current step count of the simulation
+     * @param stream CUDA stream to be used for async CUDA operations
+     * @see mapAwakeIndex()
+     */
+    void updateWakeCalendar(const AgentFunctionData& func, const unsigned int &stepCount, const cudaStream_t &stream);
+    /**
+     * Returns a device pointer to the list of awake agent indices built by mapAwakeIndex()
+     * @param func The agent function being processed
+     * @return nullptr if the agent function executes over all agents
+     */
+    const unsigned int *getDeviceAwakeIndex(const AgentFunctionData& func) const;
     /**
      * Assigns IDs to any agents who's ID has the value ID_NOT_SET
      * @param hostapi HostAPI object, this is used to provide cub temp storage
@@ -352,9 +419,175 @@ class CUDAAgent : public AgentInterface {
      */
     std::unordered_map<std::string, void*> newBuffs;
     /**
-     * Mutex for writing to newBuffs
+     * Mutex for writing to newBuffs and birthBuffers
      */
     std::mutex newBuffsMutex;
+    /**
+     * Tracks the compact birth buffer of an agent function which outputs this agent type
+     * @see AgentFunctionDescription::setAgentOutputBirthRate(const float &)
+     */
+    struct BirthBuffer {
+        /**
+         * Device copy of the buffer's metadata, this holds the counter of slots claimed during the agent function
+         */
+        detail::DeviceBirthBuffer *d_meta = nullptr;
+        /**
+         * Device array of the spill variables referenced by d_meta
+         */
+        detail::DeviceBirthBuffer::Variable *d_variables = nullptr;
+        /**
+         * Device buffer holding the default value of each spill variable
+         */
+        char *d_defaults = nullptr;
+        /**
+         * Host copy of the spill variables, their spill pointers are updated each time the buffer is mapped
+         */
+        std::vector<detail::DeviceBirthBuffer::Variable> variables;
+        /**
+         * Number of slots within the currently mapped buffer, 0 if a compact buffer is not mapped
+         */
+        unsigned int capacity = 0;
+        /**
+         * Number of births output by the last execution of the agent function, set by gatherSpilledBirths()
+         */
+        unsigned int count = 0;
+        /**
+         * Highest number of births output by a single execution of the agent function
+         * This is the learned statistic, used alongside the birth rate to size the buffer
+         */
+        unsigned int high_water = 0;
+    };
+    /**
+     * Returns the key of birthBuffers for an agent function
+     */
+    static std::string birthBufferKey(const AgentFunctionData& func);
+    /**
+     * Compact birth buffer state of each agent function which outputs this agent type
+     * key: birthBufferKey(), val: birth buffer state
+     */
+    std::unordered_map<std::string, BirthBuffer> birthBuffers;
+    /**
+     * Tracks the list of awake agents built for an agent function of this agent
+     * @see AgentDescription::setSleepEnabled(bool)
+     */
+    struct AwakeIndex {
+        /**
+         * Device buffer of the indices of awake agents
+         */
+        unsigned int *d_index = nullptr;
+        /**
+         * Number of indices d_index can hold
+         */
+        unsigned int capacity = 0;
+        /**
+         * Device counter for the number of awake agents
+         */
+        unsigned int *d_count = nullptr;
+        /**
+         * Cub temporary storage used to select the awake agents
+         */
+        void *d_cub_temp = nullptr;
+        /**
+         * Size of the allocation pointed to by d_cub_temp
+         */
+        size_t cub_temp_size = 0;
+        /**
+         * True if d_index was built for the current execution of the agent function
+         */
+        bool mapped = false;
+    };
+    /**
+     * Awake agent index list of each agent function of this agent
+     * key: agent function name, val: awake index state
+     */
+    std::unordered_map<std::string, AwakeIndex> awakeIndices;
+    /**
+     * Calendar queue of the wake steps of the agents within a state, built by mapAwakeIndex()
+     * The agent indices are held on the device, sorted by wake step, so each step pops the next bucket from the front of d_order.
+     * Popped agents may change their wake step, so they are counted into popped_calendar by updateWakeCalendar(), and selected from on each later step.
+     * It remains valid whilst agent indices are stable, and only agent functions which skip sleeping agents execute the state.
+     */
+    struct WakeCalendar {
+        /**
+         * Counts of the agents which were asleep when the calendar was built
+         * Each bucket is a segment of d_order, following the build_awake agents which were awake
+         */
+        util::detail::CalendarQueue calendar;
+        /**
+         * Counts of the popped agents which are asleep, relative to popped_step
+         */
+        util::detail::CalendarQueue popped_calendar;
+        /**
+         * Number of agents which were awake when the calendar was built
+         */
+        unsigned int build_awake = 0;
+        /**
+         * Number of popped agents which were awake at popped_step
+         */
+        unsigned int popped_awake = 0;
+        /**
+         * The step of the most recent pop
+         */
+        unsigned int popped_step = 0;
+        /**
+         * Number of agents at the front of d_order which have been popped
+         */
+        unsigned int popped_count = 0;
+        /**
+         * Number of agents in the state when the calendar was built
+         */
+        unsigned int size = 0;
+        /**
+         * Device buffer of agent indices, sorted by wake step, followed by the unsorted agent indices
+         */
+        unsigned int *d_order = nullptr;
+        /**
+         * Device buffer of the sort keys of d_order
+         */
+        unsigned int *d_keys = nullptr;
+        /**
+         * Number of agent indices d_order and d_keys each hold half of
+         */
+        unsigned int capacity = 0;
+        /**
+         * Cub temporary storage used to sort the agent indices
+         */
+        void *d_cub_temp = nullptr;
+        /**
+         * Size of the allocation pointed to by d_cub_temp
+         */
+        size_t cub_temp_size = 0;
+        /**
+         * Device resident form of calendar or popped_calendar, followed by the number of agents awake
+         */
+        unsigned int *d_counts = nullptr;
+        /**
+         * Pinned host buffer which d_counts is read back to
+         */
+        unsigned int *h_counts = nullptr;
+        /**
+         * Recorded once the read back of popped_calendar to h_counts has been issued
+         */
+        cudaEvent_t readback = nullptr;
+        /**
+         * True if h_counts must be copied to popped_calendar once readback has completed
+         */
+        bool readback_pending = false;
+        /**
+         * True if the calendar describes the current contents of the state
+         */
+        bool valid = false;
+    };
+    /**
+     * Wake calendar of each state of this agent
+     * key: state name, val: wake calendar
+     */
+    std::unordered_map<std::string, WakeCalendar> wakeCalendars;
+    /**
+     * Marks the wake calendar of every state invalid
+     * This must be called by any method which may modify the agent data, or reorder the agents
+     */
+    void invalidateWakeCalendars();
 };
 
 }  // namespace flamegpu
@@ -62,6 +62,10 @@ class CUDAAgentStateList {
      * Returns the number of alive and active agents in the state list
      */
     unsigned int getSize() const;
+    /**
+     * Returns the number of alive agents in the state list, including agents disabled by an agent function condition
+     */
+    unsigned int getSizeWithDisabled() const;
     /**
      * Returns the maximum number of agents that can be stored based on the current buffer allocations
      */
@@ -70,6 +74,15 @@ class CUDAAgentStateList {
      * Returns the device pointer for the named variable
      */
     void *getVariablePointer(const std::string &variable_name);
+    /**
+     * Returns the device pointer for the named variable, including agents disabled by an agent function condition
+     */
+    void *getVariablePointerWithDisabled(const std::string &variable_name);
+    /**
+     * Returns the device pointer for the named variable's swap buffer
+     * This is only safe to use as scratch memory whilst no operations which sort or compact the state list are in progress
+     */
+    void *getVariableSwapPointer(const std::string &variable_name);
     /**
      * Store agent data from agent state memory into state list
      * @param data data Source for agent data
@@ -113,6 +126,18 @@ class CUDAAgentStateList {
      * @return The number of newly birthed agents
      */
     unsigned int scatterNew(void * d_newBuff, const unsigned int &newSize, CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream);
+    /**
+     * Scatters agents from a compact device agent birth buffer, where new agents occupy the first newCount slots of the buffer
+     * The device buffer must be packed in the same format as CUDAAgent::mapNewRuntimeVariables(const AgentFunctionData&, const unsigned int &, const unsigned int &)
+     * @param d_newBuff The buffer holding the new agent data
+     * @param bufferLen The capacity of the buffer, used to locate each variable's sub-buffer
+     * @param newCount The number of new agents held in the buffer
+     * @param scatter Scatter instance and scan arrays to be used
+     * @param streamId The stream index to use for accessing stream specific resources such as scan compaction arrays and buffers
+     * @param stream CUDA stream to be used for async CUDA operations
+     * @return The number of newly birthed agents
+     */
+    unsigned int scatterNewCompact(void * d_newBuff, const unsigned int &bufferLen, const unsigned int &newCount, CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream);
     /**
      * Returns true if the state list is not the primary statelist (and is mapped to a master agent state)
      */
@@ -0,0 +1,294 @@
+#ifndef INCLUDE_FLAMEGPU_GPU_CUDAMACROENVIRONMENT_H_
+#define INCLUDE_FLAMEGPU_GPU_CUDAMACROENVIRONMENT_H_
+
+#include <array>
+#include <map>
+#include <memory>
+#include <string>
+#include <typeindex>
+#include <vector>
+
+#include <cuda_runtime.h>
+
+#include "flamegpu/exception/FLAMEGPUException.h"
+#include "flamegpu/runtime/utility/HostMacroProperty.cuh"
+#include "flamegpu/runtime/utility/EnvironmentTableCache.h"
+#include "flamegpu/util/detail/FieldStencil.cuh"
+
+namespace flamegpu {
+
+class EnvironmentDescription;
+class CUDASimulation;
+namespace detail {
+namespace curve {
+class Curve;
+class CurveRTCHost;
+}  // namespace curve
+}  // namespace detail
+
+/**
+ * This class is CUDASimulation's internal handler for environment macro properties, read-only tables and fields
+ * Unlike regular environment properties, which are stored in constant memory by EnvironmentManager,
+ * each macro property is a separate allocation in global memory, which is registered with curve
+ * Tables are likewise registered with curve, however their allocations are owned by detail::EnvironmentTableCache
+ * so that they are shared with other simulations on the same device
+ * Fields are double buffered allocations, which are registered with curve and updated by stepFields()
+ * @see EnvironmentDescription::newMacroProperty()
+ * @see EnvironmentDescription::newTable()
+ * @see EnvironmentDescription::newField()
+ */
+class CUDAMacroEnvironment {
+ public:
+    /**
+     * Namespace string used to build the curve hash of macro properties
+     */
+    static const char CURVE_NAMESPACE_STRING[29];
+    /**
+     * Runtime properties of a macro property
+     */
+    struct MacroEnvProp {
+        /**
+         * @param _type The type index of the base type (e.g. typeid(float))
+         * @param _type_size The size of the base type (e.g. sizeof(float))
+         * @param _elements Length of each of the macro property's 4 dimensions
+         */
+        MacroEnvProp(const std::type_index &_type, const size_t &_type_size, const std::array<unsigned int, 4> &_elements)
+            : type(_type)
+            , type_size(_type_size)
+            , elements(_elements)
+            , d_ptr(nullptr) { }
+        std::type_index type;
+        size_t type_size;
+        std::array<unsigned int, 4> elements;
+        /**
+         * Pointer to the macro property within device memory, nullptr until init() has been called
+         */
+        void *d_ptr;
+        /**
+         * The host copy of the macro property, if any HostMacroProperty handles are currently alive
+         */
+        std::weak_ptr<HostMacroProperty_MetaData> host_cache;
+        /**
+         * Returns the total number of elements
+         */
+        size_t elementCount() const { return static_cast<size_t>(elements[0]) * elements[1] * elements[2] * elements[3]; }
+    };
+    /**
+     * Runtime properties of a read-only table
+     */
+    struct TableProp {
+        /**
+         * @param _type_size The size of the table's element type (e.g. sizeof(float))
+         * @param _file_path Path to the binary file which holds the table
+         */
+        TableProp(const size_t &_type_size, const std::string &_file_path)
+            : type_size(_type_size)
+            , file_path(_file_path) { }
+        size_t type_size;
+        std::string file_path;
+        /**
+         * The table's device copy, empty until init() has been called
+         */
+        std::shared_ptr<const detail::EnvironmentTable> data;
+        /**
+         * Returns the total number of elements
+         */
+        unsigned int elementCount() const { return data ? static_cast<unsigned int>(data->length / type_size) : 0; }
+    };
+    /**
+     * Runtime properties of a field
+     */
+    struct FieldProp {
+        /**
+         * @param _stencil The stencil of a single sub-step, which also holds the field's dimensions
+         * @param _sub_steps Number of sub-steps applied per step
+         * @param _initial_value Value of every cell after init() and reset()
+         */
+        FieldProp(const util::detail::FieldStencil &_stencil, const unsigned int &_sub_steps, const float &_initial_value)
+            : stencil(_stencil)
+            , sub_steps(_sub_steps)
+            , initial_value(_initial_value)
+            , d_header(nullptr)
+            , d_back(nullptr) { }
+        util::detail::FieldStencil stencil;
+        unsigned int sub_steps;
+        float initial_value;
+        /**
+         * Pointer to the field's header (DeviceEnvironmentField::HEADER_SIZE bytes holding its dimensions), which is followed by its cells
+         * This is the pointer registered with curve, nullptr until init() has been called
+         */
+        void *d_header;
+        /**
+         * Scratch buffer of the same number of cells, which sub-steps alternate with
+         */
+        float *d_back;
+        /**
+         * Returns a pointer to the field's cells within device memory
+         */
+        float *cells() const;
+        /**
+         * Returns the total number of cells
+         */
+        unsigned int cellCount() const { return stencil.cellCount(); }
+    };
+    /**
+     * Constructor, builds the macro property, table and field maps from the model's environment description
+     * No device memory is allocated until init() is called
+     * @param description Environment description of the model
+     * @param cudaSimulation The owning simulation, whose instance id is used to build the curve hash of each macro property
+     */
+    CUDAMacroEnvironment(const EnvironmentDescription &description, const CUDASimulation &cudaSimulation);
+    CUDAMacroEnvironment(const CUDAMacroEnvironment &) = delete;
+    CUDAMacroEnvironment &operator=(const CUDAMacroEnvironment &) = delete;
+    /**
+     * Allocates and zeroes the device memory of each macro property, acquires each table, allocates and fills each field, and registers them with curve
+     * Does nothing if already initialised
+     * @throws exception::InvalidFilePath If a table's file cannot be opened
+     * @throws exception::InvalidInputFile If a table's file cannot be mapped, or its length is not a multiple of the table's type size
+     */
+    void init();
+    /**
+     * Unregisters each macro property, table and field from curve, and releases their device memory
+     * @param curve The Curve singleton instance to use, it is important that we purge curve for the correct device
+     */
+    void free(detail::curve::Curve &curve);
+    /**
+     * Zeroes every macro property, and returns every field to its initial value
+     */
+    void reset();
+    /**
+     * Applies each active field's stencil once, as a sequence of sub_steps kernels
+     * This synchronises the stream before returning
+     * @param stream The CUDA stream to launch the kernels in
+     */
+    void stepFields(cudaStream_t stream);
+    /**
+     * Registers each macro property, table and field with an RTC agent function's dynamic curve header
+     * @param curve_header The dynamic curve header of an RTC agent function (or condition)
+     */
+    void mapRTCVariables(detail::curve::CurveRTCHost &curve_header) const;
+    /**
+     * Returns a host handle to the named macro property
+     * @param name Name of the macro property
+     * @tparam T Type of the macro property
+     * @tparam I Length of the macro property's 1st dimension
+     * @tparam J Length of the macro property's 2nd dimension
+     * @tparam K Length of the macro property's 3rd dimension
+     * @tparam W Length of the macro property's 4th dimension
+     * @throws exception::InvalidEnvProperty If a macro property of the name does not exist
+     * @throws exception::InvalidEnvPropertyType If T or the dimensions do not match the macro property
+     */
+    template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W>
+    HostMacroProperty<T, I, J, K, W> getProperty(const std::string &name);
+    /**
+     * Copies every element of the named macro property to dst
+     * If the macro property has not yet been allocated, dst is zeroed
+     * @param name Name of the macro property
+     * @param dst Host buffer of at least type_size * elementCount() bytes
+     * @throws exception::InvalidEnvProperty If a macro property of the name does not exist
+     */
+    void getPropertyData(const std::string &name, void *dst) const;
+    /**
+     * Copies every element of the named macro property from src
+     * @param name Name of the macro property
+     * @param src Host buffer of at least type_size * elementCount() bytes
+     * @throws exception::InvalidEnvProperty If a macro property of the name does not exist
+     * @throws exception::InvalidOperation If the macro property has not yet been allocated
+     */
+    void setPropertyData(const std::string &name, const void *src);
+    /**
+     * Returns the named macro property's runtime properties
+     * @param name Name of the macro property
+     * @throws exception::InvalidEnvProperty If a macro property of the name does not exist
+     */
+    const MacroEnvProp &getPropertyInfo(const std::string &name) const;
+    /**
+     * Returns the full map of macro properties
+     */
+    const std::map<std::string, MacroEnvProp> &getPropertiesMap() const { return properties; }
+    /**
+     * Copies every cell of the named field to dst
+     * If the field has not yet been allocated, dst is filled with the field's initial value
+     * @param name Name of the field
+     * @param dst Host buffer of at least cellCount() floats
+     * @throws exception::InvalidEnvProperty If a field of the name does not exist
+     */
+    void getFieldData(const std::string &name, float *dst) const;
+    /**
+     * Copies every cell of the named field from src
+     * @param name Name of the field
+     * @param src Host buffer of at least cellCount() floats
+     * @throws exception::InvalidEnvProperty If a field of the name does not exist
+     * @throws exception::InvalidOperation If the field has not yet been allocated
+     */
+    void setFieldData(const std::string &name, const float *src);
+    /**
+     * Returns the named field's runtime properties
+     * @param name Name of the field
+     * @throws exception::InvalidEnvProperty If a field of the name does not exist
+     */
+    const FieldProp &getFieldInfo(const std::string &name) const;
+
+ private:
+    /**
+     * Returns the curve hash of the named macro property
+     */
+    unsigned int toHash(const std::string &name) const;
+    /**
+     * Macro properties, ordered by name
+     */
+    std::map<std::string, MacroEnvProp> properties;
+    /**
+     * Read-only tables, ordered by name
+     */
+    std::map<std::string, TableProp> tables;
+    /**
+     * Fields, ordered by name
+     */
+    std::map<std::string, FieldProp> fields;
+    /**
+     * Instance id of the owning simulation
+     */
+    const unsigned int instance_id;
+    /**
+     * Set by init(), cleared by free()
+     */
+    bool initialised;
+};
+
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W>
+HostMacroProperty<T, I, J, K, W> CUDAMacroEnvironment::getProperty(const std::string &name) {
+    const auto it = properties.find(name);
+    if (it == properties.end()) {
+        THROW exception::InvalidEnvProperty("Environment macro property with name '%s' does not exist, "
+            "in CUDAMacroEnvironment::getProperty().",
+            name.c_str());
+    }
+    MacroEnvProp &prop = it->second;
+    if (prop.type != std::type_index(typeid(T))) {
+        THROW exception::InvalidEnvPropertyType("Environment macro property ('%s') type (%s) does not match template argument T (%s), "
+            "in CUDAMacroEnvironment::getProperty().",
+            name.c_str(), prop.type.name(), typeid(T).name());
+    }
+    if (prop.elements != std::array<unsigned int, 4>{ I, J, K, W }) {
+        THROW exception::InvalidEnvPropertyType("Environment macro property ('%s') dimensions (%u, %u, %u, %u) do not match template arguments (%u, %u, %u, %u), "
+            "in CUDAMacroEnvironment::getProperty().",
+            name.c_str(), prop.elements[0], prop.elements[1], prop.elements[2], prop.elements[3], I, J, K, W);
+    }
+    if (!prop.d_ptr) {
+        THROW exception::InvalidOperation("Environment macro property '%s' has not been allocated, "
+            "in CUDAMacroEnvironment::getProperty().",
+            name.c_str());
+    }
+    // Handles alive at the same time share a host copy
+    std::shared_ptr<HostMacroProperty_MetaData> cache = prop.host_cache.lock();
+    if (!cache) {
+        cache = std::make_shared<HostMacroProperty_MetaData>(prop.d_ptr, prop.elements, prop.type_size, name);
+        prop.host_cache = cache;
+    }
+    return HostMacroProperty<T, I, J, K, W>(cache);
+}
+
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_GPU_CUDAMACROENVIRONMENT_H_
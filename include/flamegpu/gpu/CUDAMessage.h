@@ -15,6 +15,7 @@ namespace flamegpu {
 
 class CUDAScatter;
 struct AgentFunctionData;
+struct LayerData;
 struct MessageData;
 namespace detail {
 namespace curve {
@@ -28,6 +29,28 @@ class CUDAAgent;
  */
 class CUDAMessage {
  public:
+    /**
+     * Memory usage of a message list
+     * @see getMemoryStats()
+     */
+    struct MemoryStats {
+        /**
+         * The number of messages the allocated buffers can hold
+         */
+        unsigned int capacity;
+        /**
+         * The most messages the message list has held
+         */
+        unsigned int peak_message_count;
+        /**
+         * The number of times the buffers have been allocated, including the first allocation
+         */
+        unsigned int allocations;
+        /**
+         * Device memory held by the read and write buffers, in bytes
+         */
+        size_t allocated_bytes;
+    };
      /**
       * Constructs a CUDAMessage object
       * Allocates enough memory for each variable within the provided MessageData
@@ -43,6 +66,11 @@ class CUDAMessage {
      * Return an immutable reference to the message description represented by the CUDAMessage instance
      */
     const MessageBruteForce::Data& getMessageDescription() const;
+    /**
+     * Return the subset of the message's variables which are read, either by an agent function or when building the index
+     * Variables outside of this subset are neither reordered nor mapped for agent functions to read
+     */
+    const VariableMap& getReadVariables() const { return read_variables; }
     /**
      * @return The currently allocated length of the message array (in the number of messages)
      */
@@ -57,6 +85,15 @@ class CUDAMessage {
      * @note Required by array message types
      */
     void setMessageCount(const unsigned int &_message_count);
+    /**
+     * @return The memory usage of the message list
+     */
+    MemoryStats getMemoryStats() const;
+    /**
+     * @return The number of messages at the start of the message list, which were present when the index was last built
+     * @note Required by combined message types, as these messages have already been combined
+     */
+    unsigned int getIndexedMessageCount() const { return indexed_message_count; }
     /**
      * Initialise the CUDAMessagelist
      * This allocates and initialises any CUDA data structures for reading the messagelist, and sets them asthough the messagelist were empty.
@@ -65,7 +102,8 @@ class CUDAMessage {
      */
     void init(CUDAScatter &scatter, const unsigned int &streamId);
     /**
-     * Updates message_count to equal newSize, internally reallocates buffer space if more space is required
+     * Internally reallocates buffer space if more space is required, existing messages are retained
+     * The first allocation is at least the message's capacity hint, subsequent allocations grow by 1.5x
      * @param newSize The number of messages that the buffer should be capable of storing
      * @param scatter Scatter instance and scan arrays to be used (CUDASimulation::singletons->scatter)
      * @param streamId Index of stream specific structures used
@@ -126,18 +164,60 @@ class CUDAMessage {
      */
     void buildIndex(CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream);
     const void *getMetaDataDevicePtr() const;
+    /**
+     * Returns the message specialisation's handler, this allows specialisations to expose host functionality
+     */
+    MessageSpecialisationHandler *getSpecialisationHander() const { return specialisation_handler.get(); }
+    /**
+     * @return True if the message list is a view over an agent state's variables, rather than being output by agent functions
+     */
+    bool isAgentView() const { return message_description.isAgentView(); }
+    /**
+     * Updates the message count of an agent view to the size of the viewed agent state
+     * The index is marked as requiring construction, as the agent variables may have changed since it was last built
+     * This should be called before each function which reads the message list
+     * If the layer contains an agent function which may write the viewed agent variables, they are copied to the message list,
+     * so that functions within the layer read the variables as they were before the layer
+     * @param layer The layer containing the function which reads the message list
+     * @param scatter Scatter instance and scan arrays to be used (CUDASimulation::singletons->scatter)
+     * @param streamId The stream index to use for accessing stream specific resources such as scan compaction arrays and buffers
+     * @param stream CUDA stream to be used for async CUDA operations
+     */
+    void refreshAgentView(const LayerData &layer, CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream);
 
  protected:
     /** 
      * Zero all message variable data.
      */
     void zeroAllMessageData();
+    /**
+     * Validates that the agent state viewed by the message list provides each of the message's variables
+     * and that no agent function outputs the message list
+     * @throw exception::InvalidMessage If the agent view is not valid
+     */
+    void validateAgentView() const;
+    /**
+     * @return True if an agent function within the layer executes over the viewed agent state, so may write the viewed agent variables
+     */
+    bool isAgentViewWritten(const LayerData &layer) const;
+    /**
+     * Builds read_variables from the agent functions which input the message
+     * Functions which have declared their message input variables read only those variables,
+     * RTC functions read the variables whose names are quoted within their source,
+     * otherwise all variables are assumed to be read
+     */
+    void initReadVariables();
 
  private:
      /**
       * Holds the definition of the message type represented by this CUDAMessage
       */
     const MessageBruteForce::Data& message_description;
+    /**
+     * The subset of the message's variables which are read
+     * @see getReadVariables()
+     */
+    VariableMap read_variables;
     /**
      * Holds/Manages the cuda memory for each of the message variables
      */
@@ -148,10 +228,23 @@ class CUDAMessage {
      * and may be reduced downwards after (e.g. optional messages)
      */
     unsigned int message_count;
+    /**
+     * The number of messages at the start of the message list, which were present when the index was last built
+     * Reset to 0 when message output truncates the message list
+     */
+    unsigned int indexed_message_count;
     /**
      * The current number of messages that can be represented by the allocated space
      */
     unsigned int max_list_size;
+    /**
+     * The most messages the message list has held
+     */
+    unsigned int peak_message_count;
+    /**
+     * The number of times message_list has been allocated
+     */
+    unsigned int allocations;
     /**
      * When this flag is set to True before message output, 
      * message output truncates the messagelist rather than appending
@@ -171,6 +264,11 @@ class CUDAMessage {
      * Set to False before messages are read
      */
     bool pbm_construction_required;
+    /**
+     * Set by refreshAgentView() if the viewed agent variables have been copied to the message list,
+     * in which case messages are read from the message list rather than the agent's buffers
+     */
+    bool agent_view_copied;
     std::unique_ptr<MessageSpecialisationHandler> specialisation_handler;
 
     /**
@@ -27,8 +27,12 @@ class CUDAMessageList {
  public:
      /**
       * Initially allocates message lists based on cuda_message.getMaximumListSize()
+      * @param cuda_message The message which owns the list
+      * @param scatter Scatter instance and scan arrays to be used (CUDASimulation::singletons->scatter)
+      * @param streamId The stream index to use for accessing stream specific resources such as scan compaction arrays and buffers
+      * @param retain_count The number of messages to copy from cuda_message's existing read list, this must be 0 if it has no list
       */
-    explicit CUDAMessageList(CUDAMessage& cuda_message, CUDAScatter &scatter, const unsigned int &streamId);
+    explicit CUDAMessageList(CUDAMessage& cuda_message, CUDAScatter &scatter, const unsigned int &streamId, const unsigned int &retain_count);
     /**
      * Frees all message list memory
      */
@@ -91,13 +95,15 @@ class CUDAMessageList {
      /**
       * Allocates device memory for the provided message list
       * @param memory_map Message list to perform operation on
+      * @param shared_map If provided, variables which are not read by any agent function share this list's buffer, rather than being allocated
       */
-     void allocateDeviceMessageList(CUDAMessageMap &memory_map);
+     void allocateDeviceMessageList(CUDAMessageMap &memory_map, const CUDAMessageMap *shared_map);
      /**
       * Frees device memory for the provided message list
       * @param memory_map Message list to perform operation on
+      * @param shared If true, buffers of variables which are not read by any agent function are shared with the other list, so are not freed
       */
-     void releaseDeviceMessageList(CUDAMessageMap &memory_map);
+     void releaseDeviceMessageList(CUDAMessageMap &memory_map, const bool &shared);
      /**
       * Zeros device memory for the provided message list
       * @param memory_map Message list to perform operation on
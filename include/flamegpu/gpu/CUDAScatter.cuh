@@ -10,6 +10,7 @@
 
 #include "flamegpu/model/Variable.h"
 #include "flamegpu/gpu/CUDAScanCompaction.h"
+#include "flamegpu/runtime/messaging/MessageBruteForce.h"
 
 namespace flamegpu {
 
@@ -68,10 +69,16 @@ class CUDAScatter {
         friend class std::array<StreamData, CUDAScanCompaction::MAX_STREAMS>;
         ScatterData *d_data;
         unsigned int data_len;
+        /**
+         * Scratch memory used by pbm_stable_sort()
+         */
+        void *d_sort_storage;
+        size_t sort_storage_bytes;
         StreamData();
         ~StreamData();
         void purge();
         void resize(const unsigned int &newLen);
+        void resizeSortStorage(const size_t &newBytes);
     };
     std::array<StreamData, CUDAScanCompaction::MAX_STREAMS> streamResources;
 
@@ -218,6 +225,71 @@ class CUDAScatter {
         const unsigned int *d_bin_index,
         const unsigned int *d_bin_sub_index,
         const unsigned int *d_pbm);
+    /**
+     * Alternative to pbm_reorder(), which sorts the indices of items rather than their data
+     * Used by spatial messages which are views over agent variables, so that the agent data is not copied
+     * @param stream CUDA stream to be used for async CUDA operations
+     * @param itemCount Total number of items in input array to consider
+     * @param d_bin_index This idenitifies which bin each index should be sorted to
+     * @param d_bin_sub_index This indentifies where within it's bin, an index should be sorted to
+     * @param d_pbm This is the PBM, it identifies at which index a bin's storage begins
+     * @param d_permutation Output, the original index of the item at each sorted position
+     */
+    void pbm_permutation(
+        const cudaStream_t &stream,
+        const unsigned int &itemCount,
+        const unsigned int *d_bin_index,
+        const unsigned int *d_bin_sub_index,
+        const unsigned int *d_pbm,
+        unsigned int *d_permutation);
+    /**
+     * Deterministic alternative to building a PBM with an atomic histogram
+     * Items are stably sorted by bin index with a radix sort, so items within a bin retain their original relative order
+     * The resulting sub index and PBM can be passed to pbm_reorder()
+     * No atomics are used, so the result is identical regardless of scheduling
+     * @param streamResourceId The stream index to use for accessing stream specific resources such as scan compaction arrays and buffers
+     * @param stream CUDA stream to be used for async CUDA operations
+     * @param itemCount Total number of items in input array to consider
+     * @param binCount The number of bins, d_pbm must have binCount + 1 elements
+     * @param d_bin_index This idenitifies which bin each index should be sorted to
+     * @param d_bin_sub_index Output, this indentifies where within it's bin, an index should be sorted to
+     * @param d_pbm Output, the PBM, it identifies at which index a bin's storage begins
+     */
+    void pbm_stable_sort(
+        const unsigned int &streamResourceId,
+        const cudaStream_t &stream,
+        const unsigned int &itemCount,
+        const unsigned int &binCount,
+        const unsigned int *d_bin_index,
+        unsigned int *d_bin_sub_index,
+        unsigned int *d_pbm);
+    /**
+     * Reduces the items within each bin of a PBM to a single item, according to each variable's combine operator
+     * Used by message types which combine the messages output to the same element
+     * @param streamResourceId The stream index to use for accessing stream specific resources such as scan compaction arrays and buffers
+     * @param stream CUDA stream to be used for async CUDA operations
+     * @param vars Variable description map from ModelData hierarchy
+     * @param ops Combine operator of each variable, variables not present take the value of the first item within the bin
+     * @param in Input variable name:ptr map
+     * @param out Output variable name:ptr map, this must not alias in
+     * @param binCount The number of bins, d_pbm must have binCount + 1 elements
+     * @param d_pbm The PBM, it identifies at which sorted index a bin's items begin
+     * @param d_permutation The index within in of the item at each sorted index, as output by pbm_permutation()
+     * @param d_out_index If provided, the index within out of each non-empty bin's item, otherwise bin i is output to index i and empty bins are zeroed
+     * @param countBegin Items with an index within in below this value have previously been combined, later items each contribute 1 to MessageCombine::Count variables
+     */
+    void pbm_combine(
+        const unsigned int &streamResourceId,
+        const cudaStream_t &stream,
+        const VariableMap &vars,
+        const std::map<std::string, MessageCombine> &ops,
+        const std::map<std::string, void*> &in,
+        const std::map<std::string, void*> &out,
+        const unsigned int &binCount,
+        const unsigned int *d_pbm,
+        const unsigned int *d_permutation,
+        const unsigned int *d_out_index,
+        const unsigned int &countBegin);
     /**
      * Scatters agents from AoS to SoA
      * Used by host agent creation
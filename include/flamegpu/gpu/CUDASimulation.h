@@ -12,6 +12,7 @@
 #include "flamegpu/runtime/detail/curve/curve.cuh"
 #include "flamegpu/gpu/CUDAScatter.cuh"
 #include "flamegpu/gpu/CUDAEnsemble.h"
+#include "flamegpu/gpu/CUDAMacroEnvironment.h"
 #include "flamegpu/runtime/utility/RandomManager.cuh"
 #include "flamegpu/runtime/HostNewAgentAPI.h"
 
@@ -79,6 +80,15 @@ class CUDASimulation : public Simulation {
          * Defaults to enabled.
          */
         bool inLayerConcurrency = true;
+        /**
+         * Enable / disable folding the values of const environment properties into the source of RTC agent functions.
+         * Folded values are compile time constants, so NVRTC can propagate them (e.g. fully unrolling loops bounded by them),
+         * rather than reading them from constant memory at runtime.
+         * As the values form part of the dynamic header, a different value produces a different entry in the RTC kernel cache.
+         * Defaults to disabled.
+         * @note This has no impact on non-RTC agent functions, and is not applied to CUDAEnsemble runs, as RunPlan may override const properties
+         */
+        bool foldRTCConstants = false;
     };
     /**
      * Initialise cuda runner
@@ -265,6 +275,11 @@ class CUDASimulation : public Simulation {
      * @note This value is used internally for environment property storage
      */
     using Simulation::getInstanceID;
+    /**
+     * Returns the handler of this instance's environment macro properties
+     * @note Device memory for macro properties is not allocated until the simulation's singletons have been initialised
+     */
+    CUDAMacroEnvironment &getMacroEnvironment() const { return *macro_env; }
 
  protected:
     /**
@@ -478,6 +493,10 @@ class CUDASimulation : public Simulation {
      * One instance of host api is used for entire model
      */
     std::unique_ptr<HostAPI> host_api;
+    /**
+     * Environment macro properties of this instance, stored in global memory
+     */
+    std::unique_ptr<CUDAMacroEnvironment> macro_env;
     /**
      * Adds any agents stored in agentData to the device
      * Clears agent storage in agentData
@@ -5,6 +5,7 @@
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "flamegpu/model/ModelDescription.h"
 #include "flamegpu/util/StringPair.h"
@@ -30,6 +31,8 @@ class StateReader {
      * @param _model_name Name from the model description hierarchy of the model to be loaded
      * @param _env_desc Environment description for validating property data on load
      * @param _env_init Dictionary of loaded values map:<{name, index}, value>
+     * @param _macro_env_desc Environment macro property description for validating macro property data on load
+     * @param _macro_env_init Dictionary of loaded macro property data map:<name, raw data>
      * @param _model_state Map of AgentVector to load the agent data into per agent, key should be agent name
      * @param input Filename of the input file (This will be used to determine which reader to return)
      * @param _sim_instance Instance of the simulation (for configuration data IO)
@@ -38,6 +41,8 @@ class StateReader {
         const std::string& _model_name,
         const std::unordered_map<std::string, EnvironmentDescription::PropData>& _env_desc,
         util::StringUint32PairUnorderedMap<util::Any>& _env_init,
+        const std::unordered_map<std::string, EnvironmentDescription::MacroPropData>& _macro_env_desc,
+        std::unordered_map<std::string, std::vector<char>>& _macro_env_init,
         util::StringPairUnorderedMap<std::shared_ptr<AgentVector>>& _model_state,
         const std::string& input,
         Simulation* _sim_instance)
@@ -46,6 +51,8 @@ class StateReader {
     , model_name(_model_name)
     , env_desc(_env_desc)
     , env_init(_env_init)
+    , macro_env_desc(_macro_env_desc)
+    , macro_env_init(_macro_env_init)
     , sim_instance(_sim_instance) {}
     /**
      * Virtual destructor for correct inheritance behaviour
@@ -68,6 +75,8 @@ class StateReader {
     const std::string model_name;
     const std::unordered_map<std::string, EnvironmentDescription::PropData> &env_desc;
     util::StringUint32PairUnorderedMap<util::Any> &env_init;
+    const std::unordered_map<std::string, EnvironmentDescription::MacroPropData> &macro_env_desc;
+    std::unordered_map<std::string, std::vector<char>> &macro_env_init;
     Simulation *sim_instance;
 };
 }  // namespace io
@@ -5,6 +5,7 @@
 #include <string>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 #include <algorithm>
 
 #include "flamegpu/io/StateReader.h"
@@ -31,6 +32,8 @@ class StateReaderFactory {
      * @param model_name Name from the model description hierarchy of the model to be loaded
      * @param env_desc Environment description for validating property data on load
      * @param env_init Dictionary of loaded values map:<{name, index}, value>
+     * @param macro_env_desc Environment macro property description for validating macro property data on load
+     * @param macro_env_init Dictionary of loaded macro property data map:<name, raw data>
      * @param model_state Map of AgentVector to load the agent data into per agent, key should be agent name
      * @param input Filename of the input file (This will be used to determine which reader to return)
      * @param sim_instance Instance of the Simulation object (This is used for setting/getting config)
@@ -40,15 +43,17 @@ class StateReaderFactory {
         const std::string& model_name,
         const std::unordered_map<std::string, EnvironmentDescription::PropData>& env_desc,
         util::StringUint32PairUnorderedMap<util::Any>& env_init,
+        const std::unordered_map<std::string, EnvironmentDescription::MacroPropData>& macro_env_desc,
+        std::unordered_map<std::string, std::vector<char>>& macro_env_init,
         util::StringPairUnorderedMap<std::shared_ptr<AgentVector>>& model_state,
         const std::string& input,
         Simulation* sim_instance) {
         const std::string extension = util::detail::filesystem::getFileExt(input);
 
         if (extension == "xml") {
-            return new XMLStateReader(model_name, env_desc, env_init, model_state, input, sim_instance);
+            return new XMLStateReader(model_name, env_desc, env_init, macro_env_desc, macro_env_init, model_state, input, sim_instance);
         } else if (extension == "json") {
-            return new JSONStateReader(model_name, env_desc, env_init, model_state, input, sim_instance);
+            return new JSONStateReader(model_name, env_desc, env_init, macro_env_desc, macro_env_init, model_state, input, sim_instance);
         }
         THROW exception::UnsupportedFileType("File '%s' is not a type which can be read "
             "by StateReaderFactory::createReader().",
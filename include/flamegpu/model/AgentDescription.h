@@ -106,6 +106,17 @@ class AgentDescription {
      * @throws exception::InvalidStateName If the named state is not found within the agent
      */
     void setInitialState(const std::string &initial_state);
+    /**
+     * Enables or disables sleeping for agents of this type
+     * When enabled, the internal agent variable _wake_step is added to the agent.
+     * Agents may then be put to sleep with DeviceAPI::sleep(), and woken with DeviceAPI::wake() or when their scheduled wake step is reached.
+     * Agent functions of this agent launch only over awake agents, via a compact index list, so sleeping agents are neither moved nor executed.
+     * @param enabled True to enable sleeping
+     * @note Function conditions are still evaluated for all agents
+     * @note Agent functions which change the state of agents, or have been configured with AgentFunctionDescription::setIncludeSleeping(), execute over all agents
+     * @see AgentFunctionDescription::setIncludeSleeping(bool)
+     */
+    void setSleepEnabled(bool enabled);
 
     /**
      * Adds a new variable array to the agent
@@ -259,6 +270,11 @@ class AgentDescription {
      * @see AgentDescription::getAgentOutputsCount()
      */
     bool isOutputOnDevice() const;
+    /**
+     * @return True if sleeping has been enabled for agents of this type
+     * @see AgentDescription::setSleepEnabled(bool)
+     */
+    bool isSleepEnabled() const;
     /**
      * Get the set of possible states for an agent of this type
      * @return An immutable reference to the set of states agents of this type can enter
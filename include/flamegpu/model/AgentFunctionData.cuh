@@ -3,6 +3,7 @@
 #define INCLUDE_FLAMEGPU_MODEL_AGENTFUNCTIONDATA_CUH_
 
 #include <memory>
+#include <set>
 #include <string>
 
 #include "flamegpu/model/ModelData.h"
@@ -52,6 +53,16 @@ struct AgentFunctionData {
      * If set, this type of message is input to the function
      */
     std::weak_ptr<MessageBruteForce::Data> message_input;
+    /**
+     * The message input variables which are read by the function
+     * Only used if message_input_variables_declared is set
+     */
+    std::set<std::string> message_input_variables;
+    /**
+     * If set, the function only reads the message input variables within message_input_variables
+     * Otherwise, the function is assumed to read every message input variable
+     */
+    bool message_input_variables_declared = false;
     /**
      * If set, this type of message is output by the function
      */
@@ -60,6 +71,11 @@ struct AgentFunctionData {
      * If set, message outputs from this function are optional
      */
     bool message_output_optional;
+    /**
+     * The maximum number of messages each agent may output, each agent is allocated this many slots within the message output buffers
+     * If greater than 1, message output is compacted as though it were optional
+     */
+    unsigned int message_output_max;
     /**
      * If set, this is the agent type which is output by the function
      */
@@ -68,11 +84,22 @@ struct AgentFunctionData {
      * If set, this is the agent type which is output by the function
      */
     std::string agent_output_state;
+    /**
+     * Expected fraction of agents executing this function which will output an agent, in the range (0, 1]
+     * When less than 1, device agent birth uses a compact birth buffer sized by the rate, where births claim slots as they occur,
+     * rather than marking births with a scan flag per agent executing the function
+     */
+    float agent_output_birth_rate;
     /**
      * This must be marked to true if the agent function can return DEAD
      * Enabling this tells FLAMEGPU to sort agents to remove those which have died from the population
      */
     bool has_agent_death = false;
+    /**
+     * If true, this function executes over sleeping agents too
+     * Otherwise, if the agent has sleeping enabled, the function only executes over awake agents
+     */
+    bool include_sleeping = false;
     /**
      * The cuda kernel entry point for executing the agent function condition
      * @see void agent_function_condition_wrapper(detail::curve::Curve::NamespaceHash, detail::curve::Curve::NamespaceHash, const int, const unsigned int, const unsigned int)
@@ -114,6 +114,17 @@ class AgentFunctionDescription : public DependencyNode {
      * @see AgentFunctionDescription::setMessageInput(const std::string &)
      */
     void setMessageInput(MessageBruteForce::Description &message);
+    /**
+     * Declares the subset of the input message's variables which are read by this agent function
+     * Message variables which are not read by any function that inputs the message are not reordered when the message list is built,
+     * nor mapped for the agent function to read
+     * If not declared, all message variables are assumed to be read, this includes RTC agent functions
+     * @param variable_names Names of the message variables read by the agent function
+     * @throws exception::InvalidMessageName If the message input has not been set
+     * @throws exception::InvalidMessageVar If a named variable is not found within the message input
+     * @note Calling setMessageInput() clears the declaration
+     */
+    void setMessageInputVariables(const std::vector<std::string> &variable_names);
     /**
      * Sets the message type that can be output during this agent function
      * This is optional, and only one type of message can be output per agent function
@@ -143,6 +154,15 @@ class AgentFunctionDescription : public DependencyNode {
      * @note Defaults to false
      */
     void setMessageOutputOptional(const bool &output_is_optional);
+    /**
+     * Sets the maximum number of messages each agent may output during a single call of this agent function
+     * Agents complete each message with message_out.emit(), so that subsequent variables are written to their next message
+     * If greater than 1, message output is compacted as though it were optional, as agents may output fewer messages than the maximum
+     * @param max_messages The maximum number of messages per agent, the message output buffers are sized by this value
+     * @throws exception::InvalidArgument If max_messages is 0
+     * @note Defaults to 1
+     */
+    void setMessageOutputMax(const unsigned int &max_messages);
     /**
      * Sets the agent type that can be output during this agent function
      * This is optional, and only one type of agent can be output per agent function
@@ -164,6 +184,19 @@ class AgentFunctionDescription : public DependencyNode {
      * @see AgentFunctionDescription::setAgentOutput(AgentDescription &)
      */
     void setAgentOutput(AgentDescription &agent, const std::string state = ModelData::DEFAULT_STATE);
+    /**
+     * Sets the expected fraction of agents executing this function which will output an agent
+     * When less than 1.0, device agent birth will use a compact birth buffer, where new agents claim the next free slot as they are born
+     * The births are then already packed, so they are copied into the population directly, rather than scanning a flag per executing agent
+     * The buffer holds slots for ceil(birth_rate * executing agents), or the most births previously output by the function if that is larger
+     * Births beyond the buffer's capacity are written to the executing agent's swap buffers and gathered after the function, so births are never lost
+     * @note The rate only has an effect when the function outputs agents of the same type as the executing agent, otherwise every executing agent is allocated a slot
+     * @param birth_rate Fraction of agents expected to output an agent, in the range (0.0, 1.0]
+     * @throws exception::InvalidArgument If birth_rate is not in the range (0.0, 1.0]
+     * @note Defaults to 1.0, which marks births with a scan flag per executing agent
+     * @note Agents born via a compact birth buffer are not guaranteed to be ordered by the index of their parent
+     */
+    void setAgentOutputBirthRate(const float &birth_rate);
     /**
      * Configures whether agents can die during execution of this function
      * (e.g. by returning AGENT_STATUS::DEAD from the agent function)
@@ -173,6 +206,15 @@ class AgentFunctionDescription : public DependencyNode {
      * @note Defaults to false
      */
     void setAllowAgentDeath(const bool &has_death);
+    /**
+     * Configures whether this function also executes over sleeping agents
+     * This only affects agents which have sleeping enabled, by default their functions only execute over awake agents
+     * Functions which include sleeping agents can wake them with DeviceAPI::wake()
+     * @param include_sleeping True if sleeping agents should also execute this agent function
+     * @see AgentDescription::setSleepEnabled(bool)
+     * @note Defaults to false
+     */
+    void setIncludeSleeping(const bool &include_sleeping);
     /**
      * Sets the function condition for the agent function
      * This is an FLAMEGPU_AGENT_FUNCTION_CONDITION which returns a boolean value (true or false)
@@ -245,6 +287,11 @@ class AgentFunctionDescription : public DependencyNode {
      * @return True if message output from this agent function is optional
      */
     bool getMessageOutputOptional() const;
+    /**
+     * @return The maximum number of messages each agent may output
+     * @see AgentFunctionDescription::setMessageOutputMax(const unsigned int &)
+     */
+    unsigned int getMessageOutputMax() const;
     /**
      * @return An immutable reference to the agent output of this agent function
      * @throw exception::OutOfBoundsException If the agent output has not been set
@@ -255,10 +302,30 @@ class AgentFunctionDescription : public DependencyNode {
      * @throw exception::OutOfBoundsException If the agent output has not been set
      */
     std::string getAgentOutputState() const;
+    /**
+     * @return The expected fraction of agents executing this function which will output an agent
+     * @see AgentFunctionDescription::setAgentOutputBirthRate(const float &)
+     */
+    float getAgentOutputBirthRate() const;
     /**
      * @return True if this agent function can kill agents
      */
     bool getAllowAgentDeath() const;
+    /**
+     * @return True if this agent function also executes over sleeping agents
+     * @see AgentFunctionDescription::setIncludeSleeping(const bool &)
+     */
+    bool getIncludeSleeping() const;
+    /**
+     * @return The names of the message input variables declared to be read by this agent function
+     * @see AgentFunctionDescription::setMessageInputVariables(const std::vector<std::string> &)
+     */
+    std::vector<std::string> getMessageInputVariables() const;
+    /**
+     * @return True if setMessageInputVariables() has been called since the message input was last set
+     * @see AgentFunctionDescription::setMessageInputVariables(const std::vector<std::string> &)
+     */
+    bool hasMessageInputVariables() const;
     /**
      * @return True if setMessageInput() has been called successfully
      * @see AgentFunctionDescription::setMessageInput(const std::string &)
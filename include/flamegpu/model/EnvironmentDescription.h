@@ -12,6 +12,7 @@
 #include "flamegpu/exception/FLAMEGPUException.h"
 #include "flamegpu/runtime/utility/HostEnvironment.cuh"
 #include "flamegpu/util/Any.h"
+#include "flamegpu/util/detail/FieldStencil.cuh"
 #include "flamegpu/gpu/CUDAEnsemble.h"
 
 namespace flamegpu {
@@ -70,6 +71,111 @@ class EnvironmentDescription {
             return true;
         }
     };
+    /**
+     * Holds all of the properties required to add a macro property to CUDAMacroEnvironment
+     */
+    struct MacroPropData {
+        /**
+         * @param _type The type index of the base type (e.g. typeid(float))
+         * @param _type_size The size of the base type (e.g. sizeof(float))
+         * @param _elements Length of each of the macro property's 4 dimensions
+         */
+        MacroPropData(const std::type_index &_type, const size_t &_type_size, const std::array<unsigned int, 4> &_elements)
+            : type(_type)
+            , type_size(_type_size)
+            , elements(_elements) { }
+        std::type_index type;
+        size_t type_size;
+        std::array<unsigned int, 4> elements;
+        bool operator==(const MacroPropData &rhs) const {
+            return this->type == rhs.type
+                && this->type_size == rhs.type_size
+                && this->elements == rhs.elements;
+        }
+    };
+    /**
+     * Holds all of the properties required to add a read-only table to CUDAMacroEnvironment
+     */
+    struct TableData {
+        /**
+         * @param _type The type index of the table's element type (e.g. typeid(float))
+         * @param _type_size The size of the table's element type (e.g. sizeof(float))
+         * @param _file_path Path to the binary file which holds the table
+         */
+        TableData(const std::type_index &_type, const size_t &_type_size, const std::string &_file_path)
+            : type(_type)
+            , type_size(_type_size)
+            , file_path(_file_path) { }
+        std::type_index type;
+        size_t type_size;
+        std::string file_path;
+        bool operator==(const TableData &rhs) const {
+            return this->type == rhs.type
+                && this->type_size == rhs.type_size
+                && this->file_path == rhs.file_path;
+        }
+    };
+    /**
+     * Configuration of an environment field, a 2D or 3D grid of floats which is updated by a built-in stencil after each step's layers
+     * The default configuration is a static zero initialised field, which agents may sample and deposit into
+     * @see newField()
+     */
+    struct FieldData {
+        /**
+         * @param _dimensions Length of the field's x, y and z axes, the z axis of a 2D field has length 1
+         */
+        explicit FieldData(const std::array<unsigned int, 3> &_dimensions)
+            : dimensions(_dimensions) { }
+        std::array<unsigned int, 3> dimensions;
+        /**
+         * Value of every cell at the start of the simulation, and after reset
+         */
+        float initial_value = 0.0f;
+        /**
+         * Diffusion coefficient, in cells^2 per step
+         */
+        float diffusion = 0.0f;
+        /**
+         * Fraction of each cell's value which decays per step
+         */
+        float decay = 0.0f;
+        /**
+         * Advection velocity along each axis, in cells per step
+         */
+        std::array<float, 3> velocity = { 0.0f, 0.0f, 0.0f };
+        /**
+         * Number of explicit sub-steps the stencil is split into per step, larger values permit larger coefficients
+         */
+        unsigned int sub_steps = 1;
+        /**
+         * Boundary condition applied to every axis
+         */
+        FieldBoundary boundary = FieldBoundary::ZeroFlux;
+        /**
+         * Value of cells beyond the edge, only used by FieldBoundary::Fixed
+         */
+        float boundary_value = 0.0f;
+        /**
+         * Returns the stencil of a single sub-step
+         */
+        util::detail::FieldStencil getStencil() const {
+            return util::detail::FieldStencil{
+                { dimensions[0], dimensions[1], dimensions[2] },
+                diffusion, decay,
+                { velocity[0], velocity[1], velocity[2] },
+                1.0f / sub_steps, boundary, boundary_value };
+        }
+        bool operator==(const FieldData &rhs) const {
+            return this->dimensions == rhs.dimensions
+                && this->initial_value == rhs.initial_value
+                && this->diffusion == rhs.diffusion
+                && this->decay == rhs.decay
+                && this->velocity == rhs.velocity
+                && this->sub_steps == rhs.sub_steps
+                && this->boundary == rhs.boundary
+                && this->boundary_value == rhs.boundary_value;
+        }
+    };
     /**
      * Default destruction
      */
@@ -98,6 +204,50 @@ class EnvironmentDescription {
      */
     template<typename T, EnvironmentManager::size_type N>
     void newProperty(const std::string &name, const std::array<T, N> &value, const bool &isConst = false);
+    /**
+     * Adds a new environment macro property
+     * Macro properties are multi-dimensional arrays stored in device global memory, so they are not limited by the size of the constant cache
+     * They are zero initialised, can be read and atomically updated within agent functions, and read and written within host functions
+     * @param name Name used for accessing the macro property
+     * @tparam T Type of the macro property
+     * @tparam I Length of the macro property's 1st dimension
+     * @tparam J Length of the macro property's 2nd dimension
+     * @tparam K Length of the macro property's 3rd dimension
+     * @tparam W Length of the macro property's 4th dimension
+     * @throws exception::ReservedName If name begins with '_'
+     * @throws exception::DuplicateEnvProperty If a property or macro property of the same name already exists
+     * @see DeviceEnvironment::getMacroProperty()
+     * @see HostEnvironment::getMacroProperty()
+     */
+    template<typename T, unsigned int I = 1, unsigned int J = 1, unsigned int K = 1, unsigned int W = 1>
+    void newMacroProperty(const std::string &name);
+    /**
+     * Adds a new read-only environment table
+     * Tables are flat arrays stored in device global memory, which are loaded from a binary file of raw T
+     * The file is memory mapped and uploaded once per device, the upload is shared by every simulation which uses the same file,
+     * so large static lookup data (e.g. rasters) does not need to be parsed or copied per run
+     * @param name Name used for accessing the table
+     * @param file_path Path to the binary file, its length must be a multiple of sizeof(T)
+     * @tparam T Type of the table's elements
+     * @throws exception::ReservedName If name begins with '_'
+     * @throws exception::DuplicateEnvProperty If a property, macro property or table of the same name already exists
+     * @note The file is not read until the table is first required by a CUDASimulation
+     * @see DeviceEnvironment::getTable()
+     */
+    template<typename T>
+    void newTable(const std::string &name, const std::string &file_path);
+    /**
+     * Adds a new environment field
+     * Fields are 2D or 3D grids of floats stored in device global memory, agents may sample and deposit into them (DeviceEnvironment::getField())
+     * After each step's layers have executed, every field with non-zero diffusion, decay or velocity is updated by an explicit stencil
+     * @param name Name used for accessing the field
+     * @param field Dimensions and configuration of the field
+     * @throws exception::ReservedName If name begins with '_'
+     * @throws exception::DuplicateEnvProperty If a property, macro property, table or field of the same name already exists
+     * @throws exception::InvalidArgument If any dimension or sub_steps is 0, or the stencil would be unstable with the configured sub_steps
+     * @see HostEnvironment::getFieldData()
+     */
+    void newField(const std::string &name, const FieldData &field);
 #ifdef SWIG
     /**
      * Adds a new environment property array
@@ -203,6 +353,9 @@ class EnvironmentDescription {
 #endif
 
     const std::unordered_map<std::string, PropData> getPropertiesMap() const;
+    const std::unordered_map<std::string, MacroPropData> &getMacroPropertiesMap() const;
+    const std::unordered_map<std::string, TableData> &getTablesMap() const;
+    const std::unordered_map<std::string, FieldData> &getFieldsMap() const;
 
  private:
     /**
@@ -215,10 +368,26 @@ class EnvironmentDescription {
      * @param type value returned by typeid()
      */
     void newProperty(const std::string &name, const char *ptr, const size_t &len, const bool &isConst, const EnvironmentManager::size_type &elements, const std::type_index &type);
+    /**
+     * Returns whether a property, macro property, table or field of the name already exists
+     */
+    bool hasName(const std::string &name) const;
     /**
      * Main storage of all properties
      */
     std::unordered_map<std::string, PropData> properties{};
+    /**
+     * Main storage of all macro properties
+     */
+    std::unordered_map<std::string, MacroPropData> macro_properties{};
+    /**
+     * Main storage of all tables
+     */
+    std::unordered_map<std::string, TableData> tables{};
+    /**
+     * Main storage of all fields
+     */
+    std::unordered_map<std::string, FieldData> fields{};
 };
 
 
@@ -235,7 +404,7 @@ void EnvironmentDescription::newProperty(const std::string &name, const T &value
     // Compound types would allow host pointers inside structs to be passed
     static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
         "Only arithmetic types can be used as environmental properties");
-    if (properties.find(name) != properties.end()) {
+    if (hasName(name)) {
         THROW exception::DuplicateEnvProperty("Environmental property with name '%s' already exists, "
             "in EnvironmentDescription::add().",
             name.c_str());
@@ -253,13 +422,48 @@ void EnvironmentDescription::newProperty(const std::string &name, const std::arr
     // Compound types would allow host pointers inside structs to be passed
     static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
         "Only arithmetic types can be used as environmental properties");
-    if (properties.find(name) != properties.end()) {
+    if (hasName(name)) {
         THROW exception::DuplicateEnvProperty("Environmental property with name '%s' already exists, "
             "in EnvironmentDescription::add().",
             name.c_str());
     }
     newProperty(name, reinterpret_cast<const char*>(value.data()), N * sizeof(T), isConst, N, typeid(T));
 }
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W>
+void EnvironmentDescription::newMacroProperty(const std::string &name) {
+    if (!name.empty() && name[0] == '_') {
+        THROW exception::ReservedName("Environment macro property names cannot begin with '_', this is reserved for internal usage, "
+            "in EnvironmentDescription::newMacroProperty().");
+    }
+    static_assert(I > 0 && J > 0 && K > 0 && W > 0, "Environment macro property dimensions must have a length greater than 0.");
+    // Limited to Arithmetic types
+    // Compound types would allow host pointers inside structs to be passed
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+        "Only arithmetic types can be used as environmental properties");
+    if (hasName(name)) {
+        THROW exception::DuplicateEnvProperty("Environmental property with name '%s' already exists, "
+            "in EnvironmentDescription::newMacroProperty().",
+            name.c_str());
+    }
+    macro_properties.emplace(name, MacroPropData(typeid(T), sizeof(T), { I, J, K, W }));
+}
+template<typename T>
+void EnvironmentDescription::newTable(const std::string &name, const std::string &file_path) {
+    if (!name.empty() && name[0] == '_') {
+        THROW exception::ReservedName("Environment table names cannot begin with '_', this is reserved for internal usage, "
+            "in EnvironmentDescription::newTable().");
+    }
+    // Limited to Arithmetic types
+    // Compound types would allow host pointers inside structs to be passed
+    static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
+        "Only arithmetic types can be used as environmental properties");
+    if (hasName(name)) {
+        THROW exception::DuplicateEnvProperty("Environmental property with name '%s' already exists, "
+            "in EnvironmentDescription::newTable().",
+            name.c_str());
+    }
+    tables.emplace(name, TableData(typeid(T), sizeof(T), file_path));
+}
 #ifdef SWIG
 template<typename T>
 void EnvironmentDescription::newPropertyArray(const std::string &name, const EnvironmentManager::size_type &N, const std::vector<T> &value, const bool& isConst) {
@@ -279,7 +483,7 @@ void EnvironmentDescription::newPropertyArray(const std::string &name, const Env
     // Compound types would allow host pointers inside structs to be passed
     static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value,
         "Only arithmetic types can be used as environmental properties");
-    if (properties.find(name) != properties.end()) {
+    if (hasName(name)) {
         THROW exception::DuplicateEnvProperty("Environmental property with name '%s' already exists, "
             "in EnvironmentDescription::addArray().",
             name.c_str());
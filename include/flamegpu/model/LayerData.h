@@ -57,6 +57,19 @@ struct LayerData {
      * (Eventually this will be replaced when we move to a more durable mode of layers, e.g. dependency analysis)
      */
     ModelData::size_type index;
+    /**
+     * The layer executes during steps where (step % execution_interval) == execution_phase
+     */
+    unsigned int execution_interval;
+    /**
+     * The step offset within execution_interval at which the layer executes
+     */
+    unsigned int execution_phase;
+    /**
+     * Returns whether the layer should execute during the specified step
+     * @param step The current step count of the simulation
+     */
+    bool executesAtStep(const unsigned int &step) const { return step % execution_interval == execution_phase; }
     /**
      * Equality operator, checks whether LayerData hierarchies are functionally the same
      * @returns True when layers are the same
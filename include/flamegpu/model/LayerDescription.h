@@ -136,6 +136,16 @@ class LayerDescription {
      * @see addSubModel(const std::string &)
      */
     void addSubModel(const SubModelDescription &submodel);
+    /**
+     * Sets how frequently the layer executes
+     * The layer (its agent functions, host functions or submodel) only executes during steps where (step % every_n) == phase
+     * Steps where the layer does not execute incur no cost for the layer, it is not mapped, launched or synchronised
+     * @param every_n The number of steps between executions of the layer
+     * @param phase The step offset within every_n at which the layer executes
+     * @throw exception::InvalidArgument If every_n is 0, or phase is not less than every_n
+     * @note Defaults to executing every step (every_n 1, phase 0)
+     */
+    void setExecutionInterval(unsigned int every_n, unsigned int phase = 0);
     /**
      * Adds a host function to this layer, similar to addHostFunction
      * however the runnable function is encapsulated within an object which permits cross language support in swig.
@@ -155,6 +165,16 @@ class LayerDescription {
      * @return The index of the layer within the model's execution
      */
     ModelData::size_type getIndex() const;
+    /**
+     * @return The number of steps between executions of the layer
+     * @see LayerDescription::setExecutionInterval(unsigned int, unsigned int)
+     */
+    unsigned int getExecutionInterval() const;
+    /**
+     * @return The step offset within the execution interval at which the layer executes
+     * @see LayerDescription::setExecutionInterval(unsigned int, unsigned int)
+     */
+    unsigned int getExecutionPhase() const;
     /**
      * @return The total number of agent functions within the layer
      */
@@ -0,0 +1,325 @@
+#ifndef INCLUDE_FLAMEGPU_POP_POPULATIONGENERATOR_H_
+#define INCLUDE_FLAMEGPU_POP_POPULATIONGENERATOR_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <typeindex>
+#include <vector>
+
+#include "flamegpu/pop/AgentVector.h"
+#include "flamegpu/exception/FLAMEGPUException.h"
+#include "flamegpu/util/detail/Philox.cuh"
+
+namespace flamegpu {
+
+/**
+ * Declarative initial population generator
+ *
+ * Rather than building a population with a serial loop of AgentVector::push_back() and HostRandom,
+ * the distribution of each agent variable is described once, and then applied to many agents in bulk.
+ * Generation is split across host threads, each random value is produced by the counter-based Philox generator,
+ * keyed by the seed and counted by (agent index, array element, generator index).
+ * Therefore the generated population is identical regardless of the number of threads used.
+ *
+ * Generators are applied in the order they were added, if multiple generators target the same variable the last will take effect.
+ * Variables which are not targeted by a generator retain their default value.
+ * @code
+ * PopulationGenerator gen;
+ * gen.uniformBox<float>({"x", "y", "z"}, {0, 0, 0}, {100, 100, 100})
+ *    .normal<float>("speed", 1.0f, 0.1f)
+ *    .uniform<int>("type", 0, 3);
+ * AgentVector population(agent);
+ * gen.generate(population, 1000000, 12);
+ * @endcode
+ */
+class PopulationGenerator {
+ public:
+    typedef AgentVector::size_type size_type;
+    /**
+     * Internal representation of a single variable generator
+     */
+    struct Generator {
+        /**
+         * Fills the variable data of agents [begin, end) with generated values
+         * @param data Pointer to the start of the variable's buffer within the AgentVector
+         * @param elements Number of array elements of the variable
+         * @param offset Index within the AgentVector of the first generated agent
+         * @param begin Index of the first agent to fill (relative to offset)
+         * @param end Index after the last agent to fill (relative to offset)
+         * @param key Philox key derived from the seed
+         * @param stream Index of the generator, ensures each generator samples an independent stream
+         */
+        typedef std::function<void(void *data, unsigned int elements, size_type offset, size_type begin, size_type end,
+            util::detail::Philox::uint32x2 key, uint32_t stream)> FillFn;
+        std::string variable_name;
+        std::type_index type;
+        FillFn fill;
+        /**
+         * The maximum number of agents which can be generated, 0 if unlimited (this is used by lattice generators)
+         */
+        size_type max_count;
+    };
+    /**
+     * Minimum number of agents assigned to a single host thread
+     * Below this, the overhead of launching threads outweighs the benefit
+     */
+    static const size_type MIN_AGENTS_PER_THREAD;
+    /**
+     * Construct an empty generator, which will assign default values to all variables
+     */
+    PopulationGenerator();
+    /**
+     * Generate the named variable from a uniform distribution
+     * Integer types have a range [min, max]
+     * Floating point types have a range [min, max)
+     * If the variable is an array variable, each element is generated independently
+     * @param variable_name Name of the agent variable
+     * @param min Lower bound of the distribution
+     * @param max Upper bound of the distribution
+     * @tparam T Type of the agent variable
+     * @throws exception::InvalidArgument If min > max
+     */
+    template<typename T>
+    PopulationGenerator &uniform(const std::string &variable_name, T min, T max);
+    /**
+     * Generate the named variable from a normal distribution
+     * Only floating point types are supported
+     * If the variable is an array variable, each element is generated independently
+     * @param variable_name Name of the agent variable
+     * @param mean Mean of the distribution
+     * @param stddev Standard deviation of the distribution
+     * @tparam T Type of the agent variable
+     * @throws exception::InvalidArgument If stddev < 0
+     */
+    template<typename T>
+    PopulationGenerator &normal(const std::string &variable_name, T mean, T stddev);
+    /**
+     * Place agents uniformly at random within an axis aligned box
+     * @param axis_variables Names of the agent variables which hold each axis of position (e.g. {"x", "y", "z"})
+     * @param min Lower corner of the box
+     * @param max Upper corner of the box
+     * @tparam T Floating point type of the position variables
+     * @throws exception::InvalidArgument If the lengths of the provided vectors do not match, or min > max
+     */
+    template<typename T>
+    PopulationGenerator &uniformBox(const std::vector<std::string> &axis_variables, const std::vector<T> &min, const std::vector<T> &max);
+    /**
+     * Place agents according to a normal distribution around mean, clamped to an axis aligned box
+     * @param axis_variables Names of the agent variables which hold each axis of position (e.g. {"x", "y", "z"})
+     * @param mean Centre of the distribution
+     * @param stddev Standard deviation of the distribution on each axis
+     * @param min Lower corner of the box
+     * @param max Upper corner of the box
+     * @tparam T Floating point type of the position variables
+     * @throws exception::InvalidArgument If the lengths of the provided vectors do not match, stddev < 0 or min > max
+     */
+    template<typename T>
+    PopulationGenerator &normalBox(const std::vector<std::string> &axis_variables, const std::vector<T> &mean, const std::vector<T> &stddev,
+        const std::vector<T> &min, const std::vector<T> &max);
+    /**
+     * Place agents on a regular lattice, filled with the first axis varying fastest
+     * Agent i is placed at origin + spacing * (i % dims[0], (i / dims[0]) % dims[1], ...)
+     * @param axis_variables Names of the agent variables which hold each axis of position (e.g. {"x", "y", "z"})
+     * @param origin Position of the first lattice point
+     * @param spacing Distance between lattice points on each axis
+     * @param dims Number of lattice points on each axis
+     * @tparam T Type of the position variables
+     * @throws exception::InvalidArgument If the lengths of the provided vectors do not match, or any dimension is 0
+     * @note generate() will throw exception::OutOfBoundsException if more agents are requested than there are lattice points
+     */
+    template<typename T>
+    PopulationGenerator &lattice(const std::vector<std::string> &axis_variables, const std::vector<T> &origin, const std::vector<T> &spacing,
+        const std::vector<unsigned int> &dims);
+    /**
+     * Set the number of host threads used by generate()
+     * @param threads Number of threads, 0 selects std::thread::hardware_concurrency() (default)
+     * @note The generated population does not depend on the thread count
+     */
+    void setThreadCount(unsigned int threads);
+    /**
+     * Returns the number of host threads that will be used by generate()
+     */
+    unsigned int getThreadCount() const;
+    /**
+     * Append count new agents to population, initialised by the configured generators
+     * @param population The vector to append agents to
+     * @param count The number of agents to generate
+     * @param seed The random seed, the same seed will always produce the same population
+     * @throws exception::InvalidAgentVar If a generator targets a variable which the agent does not have
+     * @throws exception::ReservedName If a generator targets an internal variable
+     * @throws exception::InvalidVarType If a generator targets a variable of a different type
+     * @throws exception::OutOfBoundsException If count exceeds the capacity of a lattice generator
+     */
+    void generate(AgentVector &population, size_type count, uint64_t seed) const;
+
+ private:
+    /**
+     * Validates vector argument lengths for multi-axis generators
+     */
+    static void validateAxes(size_t axes, size_t a, size_t b, const char *caller);
+    /**
+     * Sample the uniform distribution [min, max) or [min, max], depending on whether T is floating point or integral
+     * Rejection sampling is used to avoid bias, rejected blocks are replaced via resample()
+     */
+    template<typename T>
+    static typename std::enable_if<std::is_floating_point<T>::value, T>::type sampleUniform(util::detail::Philox::uint32x4 r, T min, T max);
+    template<typename T>
+    static typename std::enable_if<std::is_integral<T>::value, T>::type sampleUniform(util::detail::Philox::uint32x4 r, T min, T max);
+    /**
+     * Returns a fresh random block derived from a rejected block
+     * The rejected block is itself random, so it is reused as the counter under a fixed key
+     */
+    static util::detail::Philox::uint32x4 resample(const util::detail::Philox::uint32x4 &r) {
+        return util::detail::Philox::generate(r, util::detail::Philox::uint32x2{0x9E3779B9u, 0x7F4A7C15u});
+    }
+    /**
+     * Sample the standard normal distribution
+     */
+    static float sampleNormal(const util::detail::Philox::uint32x4 &r, float);
+    static double sampleNormal(const util::detail::Philox::uint32x4 &r, double);
+    /**
+     * Add a generator which calls sample(index, r) for each element of each agent
+     * @tparam Random If false, the sampler is deterministic so the Philox block is not generated
+     */
+    template<typename T, bool Random = true, typename Sampler>
+    PopulationGenerator &addGenerator(const std::string &variable_name, Sampler sample);
+    /**
+     * Returns the counter for a given agent/element/stream
+     */
+    static util::detail::Philox::uint32x4 counter(const size_type index, const unsigned int element, const uint32_t stream) {
+        return {static_cast<uint32_t>(index), static_cast<uint32_t>(static_cast<uint64_t>(index) >> 32), element, stream};
+    }
+    std::vector<Generator> generators;
+    unsigned int thread_count;
+};
+
+template<typename T>
+typename std::enable_if<std::is_floating_point<T>::value, T>::type PopulationGenerator::sampleUniform(util::detail::Philox::uint32x4 r, T min, T max) {
+    if (!(min < max))
+        return min;
+    while (true) {
+        // Philox conversions return (0, 1], flip to [0, 1)
+        const T u = std::is_same<T, float>::value ? static_cast<T>(1.0f - util::detail::Philox::toFloat(r.x))
+            : static_cast<T>(1.0 - util::detail::Philox::toDouble(r.x, r.y));
+        const T t = min + u * (max - min);
+        // Rounding may land on max, resample rather than remap so the distribution remains uniform
+        if (t < max)
+            return t;
+        r = resample(r);
+    }
+}
+template<typename T>
+typename std::enable_if<std::is_integral<T>::value, T>::type PopulationGenerator::sampleUniform(util::detail::Philox::uint32x4 r, T min, T max) {
+    const uint64_t range = static_cast<uint64_t>(max) - static_cast<uint64_t>(min) + 1;
+    // range == 0 implies the full 64 bit range was requested
+    if (!range)
+        return static_cast<T>((static_cast<uint64_t>(r.x) << 32) | static_cast<uint64_t>(r.y));
+    // Reject the lowest (2^64 % range) values, so that every residue is equally likely
+    const uint64_t threshold = (0 - range) % range;
+    while (true) {
+        const uint64_t bits[2] = {(static_cast<uint64_t>(r.x) << 32) | static_cast<uint64_t>(r.y),
+            (static_cast<uint64_t>(r.z) << 32) | static_cast<uint64_t>(r.w)};
+        for (const uint64_t &b : bits) {
+            if (b >= threshold)
+                return static_cast<T>(static_cast<uint64_t>(min) + b % range);
+        }
+        r = resample(r);
+    }
+}
+template<typename T, bool Random, typename Sampler>
+PopulationGenerator &PopulationGenerator::addGenerator(const std::string &variable_name, Sampler sample) {
+    Generator::FillFn fn = [sample](void *data, unsigned int elements, size_type offset, size_type begin, size_type end,
+        util::detail::Philox::uint32x2 key, uint32_t stream) {
+        T *t_data = static_cast<T*>(data) + offset * elements;
+        for (size_type i = begin; i < end; ++i) {
+            for (unsigned int e = 0; e < elements; ++e) {
+                t_data[i * elements + e] = sample(i, Random ? util::detail::Philox::generate(counter(i, e, stream), key) : util::detail::Philox::uint32x4{0, 0, 0, 0});
+            }
+        }
+    };
+    generators.push_back(Generator{variable_name, std::type_index(typeid(T)), fn, 0});
+    return *this;
+}
+template<typename T>
+PopulationGenerator &PopulationGenerator::uniform(const std::string &variable_name, T min, T max) {
+    static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "Invalid template argument for PopulationGenerator::uniform()");
+    if (min > max) {
+        THROW exception::InvalidArgument("Uniform distribution for variable '%s' has min > max, "
+            "in PopulationGenerator::uniform().", variable_name.c_str());
+    }
+    return addGenerator<T>(variable_name, [min, max](size_type, const util::detail::Philox::uint32x4 &r) {
+        return sampleUniform<T>(r, min, max);
+    });
+}
+template<typename T>
+PopulationGenerator &PopulationGenerator::normal(const std::string &variable_name, T mean, T stddev) {
+    static_assert(std::is_floating_point<T>::value, "Invalid template argument for PopulationGenerator::normal(), only floating point types are supported");
+    if (stddev < 0) {
+        THROW exception::InvalidArgument("Normal distribution for variable '%s' has a negative standard deviation, "
+            "in PopulationGenerator::normal().", variable_name.c_str());
+    }
+    return addGenerator<T>(variable_name, [mean, stddev](size_type, const util::detail::Philox::uint32x4 &r) {
+        return static_cast<T>(mean + stddev * sampleNormal(r, T()));
+    });
+}
+template<typename T>
+PopulationGenerator &PopulationGenerator::uniformBox(const std::vector<std::string> &axis_variables, const std::vector<T> &min, const std::vector<T> &max) {
+    static_assert(std::is_floating_point<T>::value, "Invalid template argument for PopulationGenerator::uniformBox(), only floating point types are supported");
+    validateAxes(axis_variables.size(), min.size(), max.size(), "PopulationGenerator::uniformBox()");
+    for (size_t i = 0; i < axis_variables.size(); ++i) {
+        uniform<T>(axis_variables[i], min[i], max[i]);
+    }
+    return *this;
+}
+template<typename T>
+PopulationGenerator &PopulationGenerator::normalBox(const std::vector<std::string> &axis_variables, const std::vector<T> &mean, const std::vector<T> &stddev,
+    const std::vector<T> &min, const std::vector<T> &max) {
+    static_assert(std::is_floating_point<T>::value, "Invalid template argument for PopulationGenerator::normalBox(), only floating point types are supported");
+    validateAxes(axis_variables.size(), mean.size(), stddev.size(), "PopulationGenerator::normalBox()");
+    validateAxes(axis_variables.size(), min.size(), max.size(), "PopulationGenerator::normalBox()");
+    for (size_t i = 0; i < axis_variables.size(); ++i) {
+        if (min[i] > max[i] || stddev[i] < 0) {
+            THROW exception::InvalidArgument("Axis %u has min > max or a negative standard deviation, "
+                "in PopulationGenerator::normalBox().", static_cast<unsigned int>(i));
+        }
+        const T m = mean[i], s = stddev[i], lo = min[i], hi = max[i];
+        addGenerator<T>(axis_variables[i], [m, s, lo, hi](size_type, const util::detail::Philox::uint32x4 &r) {
+            return std::min(std::max(static_cast<T>(m + s * sampleNormal(r, T())), lo), hi);
+        });
+    }
+    return *this;
+}
+template<typename T>
+PopulationGenerator &PopulationGenerator::lattice(const std::vector<std::string> &axis_variables, const std::vector<T> &origin, const std::vector<T> &spacing,
+    const std::vector<unsigned int> &dims) {
+    static_assert(std::is_arithmetic<T>::value, "Invalid template argument for PopulationGenerator::lattice()");
+    validateAxes(axis_variables.size(), origin.size(), spacing.size(), "PopulationGenerator::lattice()");
+    validateAxes(axis_variables.size(), dims.size(), dims.size(), "PopulationGenerator::lattice()");
+    size_type stride = 1;
+    size_type total = 1;
+    for (const unsigned int &d : dims) {
+        if (d == 0) {
+            THROW exception::InvalidArgument("Lattice dimensions must be greater than 0, "
+                "in PopulationGenerator::lattice().");
+        }
+        total *= d;
+    }
+    for (size_t i = 0; i < axis_variables.size(); ++i) {
+        const T o = origin[i], s = spacing[i];
+        const size_type axis_stride = stride, axis_dim = dims[i];
+        addGenerator<T, false>(axis_variables[i], [o, s, axis_stride, axis_dim](size_type index, const util::detail::Philox::uint32x4 &) {
+            return static_cast<T>(o + s * static_cast<T>((index / axis_stride) % axis_dim));
+        });
+        generators.back().max_count = total;
+        stride *= dims[i];
+    }
+    return *this;
+}
+
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_POP_POPULATIONGENERATOR_H_
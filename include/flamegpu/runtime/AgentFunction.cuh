@@ -2,11 +2,12 @@
 #define INCLUDE_FLAMEGPU_RUNTIME_AGENTFUNCTION_CUH_
 
 #include <cuda_runtime.h>
-#include <curand_kernel.h>
 
 #include "flamegpu/defines.h"
 #include "flamegpu/exception/FLAMEGPUDeviceException.cuh"
 #include "flamegpu/runtime/AgentFunction_shim.cuh"
+#include "flamegpu/runtime/detail/DeviceBirthBuffer.cuh"
+#include "flamegpu/runtime/utility/AgentRandom.cuh"
 
 namespace flamegpu {
 
@@ -23,12 +24,15 @@ typedef void(AgentFunctionWrapper)(
     detail::curve::Curve::NamespaceHash messagename_outp_hash,
     detail::curve::Curve::NamespaceHash agent_output_hash,
     id_t *d_agent_output_nextID,
+    detail::DeviceBirthBuffer *d_agent_output_birth_buffer,
     const unsigned int popNo,
+    const unsigned int *d_awake_index,
     const void *in_messagelist_metadata,
     const void *out_messagelist_metadata,
-    curandState *d_rng,
+    const AgentRandom::Stream rng_stream,
     unsigned int *scanFlag_agentDeath,
     unsigned int *scanFlag_messageOutput,
+    const unsigned int messageOutput_max,
     unsigned int *scanFlag_agentOutput);  // Can't put __global__ in a typedef
 
 /**
@@ -41,12 +45,15 @@ typedef void(AgentFunctionWrapper)(
  * @param messagename_outp_hash CURVE hash of the output message's name
  * @param agent_output_hash CURVE hash of "_agent_birth" or 0 if agent birth not present
  * @param d_agent_output_nextID If agent output is enabled, this points to a global memory src of the next suitable agent id, this will be atomically incremented at birth
+ * @param d_agent_output_birth_buffer If agent output uses a compact birth buffer, this points to its metadata in global memory, used to allocate slots within the buffer, else nullptr
  * @param popNo Total number of agents executing the function (number of threads launched)
+ * @param d_awake_index If only awake agents execute the function, this maps each thread to the index of the agent it executes, else nullptr
  * @param in_messagelist_metadata Pointer to the MessageIn metadata struct, it is interpreted by MessageIn
  * @param out_messagelist_metadata Pointer to the MessageOut metadata struct, it is interpreted by MessageOut
- * @param d_rng Array of curand states for this kernel
+ * @param rng_stream Identifies the random streams of this agent function launch
  * @param scanFlag_agentDeath Scanflag array for agent death
  * @param scanFlag_messageOutput Scanflag array for optional message output
+ * @param messageOutput_max The maximum number of messages each agent may output, each agent has this many slots within the message output buffers
  * @param scanFlag_agentOutput Scanflag array for optional agent output
  * @tparam AgentFunction The modeller defined agent function (defined as FLAMEGPU_AGENT_FUNCTION in model code)
  * @tparam MessageIn Message handler for input messages (e.g. MessageNone, MessageBruteForce, MessageSpatial3D)
@@ -63,12 +70,15 @@ __global__ void agent_function_wrapper(
     detail::curve::Curve::NamespaceHash messagename_outp_hash,
     detail::curve::Curve::NamespaceHash agent_output_hash,
     id_t *d_agent_output_nextID,
+    detail::DeviceBirthBuffer *d_agent_output_birth_buffer,
     const unsigned int popNo,
+    const unsigned int *d_awake_index,
     const void *in_messagelist_metadata,
     const void *out_messagelist_metadata,
-    curandState *d_rng,
+    const AgentRandom::Stream rng_stream,
     unsigned int *scanFlag_agentDeath,
     unsigned int *scanFlag_messageOutput,
+    const unsigned int messageOutput_max,
     unsigned int *scanFlag_agentOutput) {
 #if !defined(SEATBELTS) || SEATBELTS
     // We place this at the start of shared memory, so we can locate it anywhere in device code without a reference
@@ -82,25 +92,29 @@ __global__ void agent_function_wrapper(
     __syncthreads();
     #endif  // __CUDACC__
 #endif
-    // Must be terminated here, else AgentRandom has bounds issues inside DeviceAPI constructor
+    // Threads beyond the population have no agent to execute
     if (DeviceAPI<MessageIn, MessageOut>::getThreadIndex() >= popNo)
         return;
+    // Sleeping agents are skipped by launching over the index list of awake agents
+    const unsigned int agent_index = d_awake_index ? d_awake_index[DeviceAPI<MessageIn, MessageOut>::getThreadIndex()] : DeviceAPI<MessageIn, MessageOut>::getThreadIndex();
     // create a new device FLAME_GPU instance
     DeviceAPI<MessageIn, MessageOut> api = DeviceAPI<MessageIn, MessageOut>(
         instance_id_hash,
         agent_func_name_hash,
+        agent_index,
         agent_output_hash,
         d_agent_output_nextID,
-        d_rng,
+        d_agent_output_birth_buffer,
+        rng_stream,
         scanFlag_agentOutput,
         MessageIn::In(agent_func_name_hash, messagename_inp_hash, in_messagelist_metadata),
-        MessageOut::Out(agent_func_name_hash, messagename_outp_hash, out_messagelist_metadata, scanFlag_messageOutput));
+        MessageOut::Out(agent_func_name_hash, messagename_outp_hash, out_messagelist_metadata, scanFlag_messageOutput, messageOutput_max));
 
     // call the user specified device function
     AGENT_STATUS flag = AgentFunction()(&api);
     if (scanFlag_agentDeath) {
         // (scan flags will not be processed unless agent death has been requested in model definition)
-        scanFlag_agentDeath[DeviceAPI<MessageIn, MessageOut>::getThreadIndex()] = flag;
+        scanFlag_agentDeath[agent_index] = flag;
 #if !defined(SEATBELTS) || SEATBELTS
     } else if (flag == DEAD) {
         DTHROW("Agent death must be enabled per agent function when defining the model.\n");
@@ -16,7 +16,7 @@ typedef void(AgentFunctionConditionWrapper)(
     detail::curve::Curve::NamespaceHash instance_id_hash,
     detail::curve::Curve::NamespaceHash agent_func_name_hash,
     const unsigned int popNo,
-    curandState *d_rng,
+    const AgentRandom::Stream rng_stream,
     unsigned int *scanFlag_conditionResult);  // Can't put __global__ in a typedef
 
 /**
@@ -26,7 +26,7 @@ typedef void(AgentFunctionConditionWrapper)(
  * @param instance_id_hash CURVE hash of the CUDASimulation's instance id
  * @param agent_func_name_hash CURVE hash of the agent + function's names
  * @param popNo Total number of agents exeucting the function (number of threads launched)
- * @param d_rng Array of curand states for this kernel
+ * @param rng_stream Identifies the random streams of this agent function condition launch
  * @param scanFlag_conditionResult Scanflag array for condition result (this uses same buffer as agent death)
  * @tparam AgentFunctionCondition The modeller defined agent function condition (defined as FLAMEGPU_AGENT_FUNCTION_CONDITION in model code)
  * @note This is basically a cutdown version of agent_function_wrapper
@@ -39,7 +39,7 @@ __global__ void agent_function_condition_wrapper(
     detail::curve::Curve::NamespaceHash instance_id_hash,
     detail::curve::Curve::NamespaceHash agent_func_name_hash,
     const unsigned int popNo,
-    curandState *d_rng,
+    const AgentRandom::Stream rng_stream,
     unsigned int *scanFlag_conditionResult) {
 #if !defined(SEATBELTS) || SEATBELTS
     // We place this at the start of shared memory, so we can locate it anywhere in device code without a reference
@@ -52,14 +52,15 @@ __global__ void agent_function_condition_wrapper(
         __syncthreads();
     #endif
 #endif
-    // Must be terminated here, else AgentRandom has bounds issues inside DeviceAPI constructor
+    // Threads beyond the population have no agent to execute
     if (ReadOnlyDeviceAPI::getThreadIndex() >= popNo)
         return;
     // create a new device FLAME_GPU instance
     ReadOnlyDeviceAPI api = ReadOnlyDeviceAPI(
         instance_id_hash,
         agent_func_name_hash,
-        d_rng);
+        ReadOnlyDeviceAPI::getThreadIndex(),
+        rng_stream);
 
     // call the user specified device function
     {
@@ -42,22 +42,25 @@ class ReadOnlyDeviceAPI {
         detail::curve::Curve::NamespaceHash,
         detail::curve::Curve::NamespaceHash,
         const unsigned int,
-        curandState *,
+        const AgentRandom::Stream,
         unsigned int *);
 
  public:
     /**
      * @param instance_id_hash CURVE hash of the CUDASimulation's instance id
      * @param agentfuncname_hash CURVE hash of the agent function
-     * @param d_rng Pointer to the device random state buffer to be used
+     * @param _agent_index Index of the executing agent within the agent state list
+     * @param rng_stream Identifies the random streams of the agent function launch
      */
     __device__ ReadOnlyDeviceAPI(
         const detail::curve::Curve::NamespaceHash &instance_id_hash,
         const detail::curve::Curve::NamespaceHash &agentfuncname_hash,
-        curandState *&d_rng)
-        : random(AgentRandom(&d_rng[getThreadIndex()]))
+        const unsigned int &_agent_index,
+        const AgentRandom::Stream &rng_stream)
+        : random(AgentRandom(rng_stream, agentfuncname_hash, _agent_index))
         , environment(DeviceEnvironment(instance_id_hash))
-        , agent_func_name_hash(agentfuncname_hash) { }
+        , agent_func_name_hash(agentfuncname_hash)
+        , agent_index(_agent_index) { }
     /**
      * Returns the specified variable from the currently executing agent
      * @param variable_name name used for accessing the variable, this value should be a string literal e.g. "foobar"
@@ -87,10 +90,20 @@ class ReadOnlyDeviceAPI {
     __device__ id_t getID() {
         return getVariable<id_t>("_id");
     }
+    /**
+     * Returns whether the agent is currently asleep
+     * Only agent functions which include sleeping agents can observe a sleeping agent
+     * @throws exception::DeviceError If sleeping has not been enabled for the agent (flamegpu must be built with SEATBELTS enabled for device error checking)
+     * @see AgentDescription::setSleepEnabled(bool)
+     * @see AgentFunctionDescription::setIncludeSleeping(const bool &)
+     */
+    __device__ bool isAsleep() const {
+        return getVariable<unsigned int>("_wake_step") > getStepCounter();  // Can't use WAKE_STEP_VARIABLE_NAME inline, as it isn't of char[N] type
+    }
 
     /**
      * Provides access to random functionality inside agent functions
-     * @note random state isn't stored within the object, so it can be const
+     * @note random only tracks the number of values drawn, which is mutable, so it can be const
      */
     const AgentRandom random;
     /**
@@ -132,6 +145,11 @@ class ReadOnlyDeviceAPI {
 
  protected:
     detail::curve::Curve::NamespaceHash agent_func_name_hash;
+    /**
+     * Index of the executing agent within the agent state list
+     * This only differs from getThreadIndex() if the agent function is executing over awake agents only
+     */
+    const unsigned int agent_index;
 };
 
 /** @brief    A flame gpu api class for the device runtime only
@@ -157,12 +175,16 @@ class DeviceAPI : public ReadOnlyDeviceAPI{
         detail::curve::Curve::NamespaceHash,
         detail::curve::Curve::NamespaceHash,
         id_t*,
+        unsigned int *,
+        const unsigned int,
         const unsigned int,
+        const unsigned int *,
         const void *,
         const void *,
-        curandState *,
+        const AgentRandom::Stream,
         unsigned int *,
         unsigned int *,
+        const unsigned int,
         unsigned int *);
 
  public:
@@ -175,12 +197,16 @@ class DeviceAPI : public ReadOnlyDeviceAPI{
          * Constructor
          * @param aoh Agent output hash (as required for accessing Curve)
          * @param d_agent_output_nextID Pointer to global memory holding the IDs to be assigned to new agents (selected via atomic inc)
+         * @param d_agent_output_birth_buffer Pointer to global memory holding the metadata of a compact birth buffer, nullptr if a compact birth buffer is not in use
          * @param scan_flag_agentOutput Pointer to (the start of) buffer of scan flags to be set true if this thread outputs an agent
+         * @param parent_random The executing agent's random, used to derive the new agent's random key
          */
-        __device__ AgentOut(const detail::curve::Curve::NamespaceHash &aoh, id_t *&d_agent_output_nextID, unsigned int *&scan_flag_agentOutput)
+        __device__ AgentOut(const detail::curve::Curve::NamespaceHash &aoh, id_t *&d_agent_output_nextID, detail::DeviceBirthBuffer *&d_agent_output_birth_buffer, unsigned int *&scan_flag_agentOutput, const AgentRandom &parent_random)
             : agent_output_hash(aoh)
             , scan_flag(scan_flag_agentOutput)
-            , nextID(d_agent_output_nextID) { }
+            , nextID(d_agent_output_nextID)
+            , birthBuffer(d_agent_output_birth_buffer)
+            , random(parent_random) { }
         /**
          * Sets a variable in a new agent to be output after the agent function has completed
          * @param variable_name The name of the variable
@@ -218,9 +244,24 @@ class DeviceAPI : public ReadOnlyDeviceAPI{
 
      private:
         /**
-         * Sets scan flag and id
+         * Allocates the new agent's slot within the birth buffer, then sets scan flag and id
+         * @return The index of the new agent within the birth buffer
+         */
+        __device__ unsigned int genID() const;
+        /**
+         * Sets a variable of a new agent which spilled beyond the capacity of the compact birth buffer
+         * @param variable_name The name of the variable
+         * @param value The value to set the variable or array element
+         * @param array_index The index of the array element to set
+         * @param is_array If true, value is a single element of an array variable, else it is the whole variable
+         * @throws exception::DeviceError If name is not a valid variable within the agent, or the size of T or array_index does not match the variable (flamegpu must be built with SEATBELTS enabled for device error checking)
          */
-        __device__ void genID() const;
+        template<typename T>
+        __device__ void setSpilledVariable(const char *variable_name, const T &value, const unsigned int &array_index, const bool &is_array) const;
+        /**
+         * Slot value denoting that a slot has not yet been allocated
+         */
+        static constexpr unsigned int UNSET_SLOT = 0xffffffff;
         /**
          * Curve hash used for accessing new agent variables
          */
@@ -238,14 +279,35 @@ class DeviceAPI : public ReadOnlyDeviceAPI{
          * Ptr to global address storing a counter to track the next available agent ID for the agent type being output
          */
         id_t *nextID;
+        /**
+         * Ptr to global address storing the metadata of the compact birth buffer
+         * nullptr if the birth buffer has a slot per thread
+         */
+        detail::DeviceBirthBuffer *birthBuffer;
+        /**
+         * The executing agent's random, the new agent's random key is derived from its key
+         */
+        const AgentRandom &random;
+        /**
+         * Index of the new agent within the birth buffer, or within the spill buffers if spilled is set
+         * @note mutable, because this object is always const
+         */
+        mutable unsigned int slot = UNSET_SLOT;
+        /**
+         * True if the new agent did not fit within the compact birth buffer, so is written to its spill buffers
+         * @note mutable, because this object is always const
+         */
+        mutable bool spilled = false;
     };
     /**
      * Constructs the device-only API class instance.
      * @param instance_id_hash CURVE hash of the CUDASimulation's instance id
      * @param agentfuncname_hash Combined CURVE hashes of agent name and func name
+     * @param _agent_index Index of the executing agent within the agent state list
      * @param _agent_output_hash Combined CURVE hashes for agent output
      * @param d_agent_output_nextID If agent birth is enabled, a pointer to the next available ID in global memory. Device agent birth will atomically increment this value to allocate IDs.
-     * @param d_rng Device pointer to curand state for this kernel, index 0 should for TID()==0
+     * @param d_agent_output_birth_buffer If agent birth uses a compact birth buffer, a pointer to its metadata in global memory, else nullptr
+     * @param rng_stream Identifies the random streams of the agent function launch
      * @param scanFlag_agentOutput Array for agent output scan flag
      * @param message_in Input message handler
      * @param message_out Output message handler
@@ -253,16 +315,18 @@ class DeviceAPI : public ReadOnlyDeviceAPI{
     __device__ DeviceAPI(
         const detail::curve::Curve::NamespaceHash &instance_id_hash,
         const detail::curve::Curve::NamespaceHash &agentfuncname_hash,
+        const unsigned int &_agent_index,
         const detail::curve::Curve::NamespaceHash &_agent_output_hash,
         id_t *&d_agent_output_nextID,
-        curandState *&d_rng,
+        detail::DeviceBirthBuffer *&d_agent_output_birth_buffer,
+        const AgentRandom::Stream &rng_stream,
         unsigned int *&scanFlag_agentOutput,
         typename MessageIn::In &&message_in,
         typename MessageOut::Out &&message_out)
-        : ReadOnlyDeviceAPI(instance_id_hash, agentfuncname_hash, d_rng)
+        : ReadOnlyDeviceAPI(instance_id_hash, agentfuncname_hash, _agent_index, rng_stream)
         , message_in(message_in)
         , message_out(message_out)
-        , agent_out(AgentOut(_agent_output_hash, d_agent_output_nextID, scanFlag_agentOutput))
+        , agent_out(AgentOut(_agent_output_hash, d_agent_output_nextID, d_agent_output_birth_buffer, scanFlag_agentOutput, this->random))
     { }
     /**
      * Sets a variable within the currently executing agent
@@ -289,6 +353,29 @@ class DeviceAPI : public ReadOnlyDeviceAPI{
      */
     template<typename T, unsigned int N, unsigned int M>
     __device__ void setVariable(const char(&variable_name)[M], const unsigned int &index, const T &value);
+    /**
+     * Puts the currently executing agent to sleep
+     * Sleeping agents do not execute agent functions for the remainder of the current step, or the following number of steps
+     * @param steps The number of steps after the current step that the agent should sleep for
+     * @throws exception::DeviceError If sleeping has not been enabled for the agent (flamegpu must be built with SEATBELTS enabled for device error checking)
+     * @see AgentDescription::setSleepEnabled(bool)
+     */
+    __device__ void sleep(const unsigned int &steps);
+    /**
+     * Schedules the next activation of the currently executing agent
+     * The agent sleeps until the step counter reaches the specified step, if this step has already been reached the agent remains awake
+     * @param step The step at which the agent should next execute agent functions
+     * @throws exception::DeviceError If sleeping has not been enabled for the agent (flamegpu must be built with SEATBELTS enabled for device error checking)
+     * @see AgentDescription::setSleepEnabled(bool)
+     */
+    __device__ void sleepUntil(const unsigned int &step);
+    /**
+     * Wakes the currently executing agent, so that it executes all following agent functions
+     * This is only useful within agent functions which include sleeping agents
+     * @throws exception::DeviceError If sleeping has not been enabled for the agent (flamegpu must be built with SEATBELTS enabled for device error checking)
+     * @see AgentFunctionDescription::setIncludeSleeping(const bool &)
+     */
+    __device__ void wake();
 
     /**
      * Provides access to message read functionality inside agent functions
@@ -309,8 +396,7 @@ class DeviceAPI : public ReadOnlyDeviceAPI{
 
 template<typename T, unsigned int N>
 __device__ T ReadOnlyDeviceAPI::getVariable(const char(&variable_name)[N]) const {
-    // simple indexing assumes index is the thread number (this may change later)
-    const unsigned int index = (blockDim.x * blockIdx.x) + threadIdx.x;
+    const unsigned int index = this->agent_index;
 
     // get the value from curve
     T value = detail::curve::Curve::getAgentVariable<T>(variable_name, agent_func_name_hash , index);
@@ -325,16 +411,14 @@ __device__ void DeviceAPI<MessageIn, MessageOut>::setVariable(const char(&variab
     if (variable_name[0] == '_') {
         return;  // Fail silently
     }
-    // simple indexing assumes index is the thread number (this may change later)
-    const unsigned int index = (blockDim.x * blockIdx.x) + threadIdx.x;
+    const unsigned int index = this->agent_index;
     // set the variable using curve
     detail::curve::Curve::setAgentVariable<T>(variable_name, agent_func_name_hash,  value, index);
 }
 
 template<typename T, unsigned int N, unsigned int M>
 __device__ T ReadOnlyDeviceAPI::getVariable(const char(&variable_name)[M], const unsigned int &array_index) const {
-    // simple indexing assumes index is the thread number (this may change later)
-    const unsigned int index = (blockDim.x * blockIdx.x) + threadIdx.x;
+    const unsigned int index = this->agent_index;
 
     // get the value from curve
     T value = detail::curve::Curve::getAgentArrayVariable<T, N>(variable_name, agent_func_name_hash , index, array_index);
@@ -349,13 +433,29 @@ __device__ void DeviceAPI<MessageIn, MessageOut>::setVariable(const char(&variab
     if (variable_name[0] == '_') {
         return;  // Fail silently
     }
-    // simple indexing assumes index is the thread number (this may change later)
-    const unsigned int index = (blockDim.x * blockIdx.x) + threadIdx.x;
+    const unsigned int index = this->agent_index;
 
     // set the variable using curve
     detail::curve::Curve::setAgentArrayVariable<T, N>(variable_name , agent_func_name_hash,  value, index, array_index);
 }
 
+template<typename MessageIn, typename MessageOut>
+__device__ void DeviceAPI<MessageIn, MessageOut>::sleep(const unsigned int &steps) {
+    // Agents are awake once the step counter reaches their wake step
+    const unsigned int wake_step = getStepCounter() + steps + 1;
+    detail::curve::Curve::setAgentVariable<unsigned int>("_wake_step", agent_func_name_hash, wake_step, this->agent_index);
+}
+
+template<typename MessageIn, typename MessageOut>
+__device__ void DeviceAPI<MessageIn, MessageOut>::sleepUntil(const unsigned int &step) {
+    detail::curve::Curve::setAgentVariable<unsigned int>("_wake_step", agent_func_name_hash, step, this->agent_index);
+}
+
+template<typename MessageIn, typename MessageOut>
+__device__ void DeviceAPI<MessageIn, MessageOut>::wake() {
+    detail::curve::Curve::setAgentVariable<unsigned int>("_wake_step", agent_func_name_hash, 0u, this->agent_index);
+}
+
 template<typename MessageIn, typename MessageOut>
 template<typename T, unsigned int N>
 __device__ void DeviceAPI<MessageIn, MessageOut>::AgentOut::setVariable(const char(&variable_name)[N], T value) const {
@@ -364,14 +464,15 @@ __device__ void DeviceAPI<MessageIn, MessageOut>::AgentOut::setVariable(const ch
             return;  // Fail silently
         }
         if (agent_output_hash) {
-            // simple indexing assumes index is the thread number (this may change later)
-            const unsigned int index = (blockDim.x * blockIdx.x) + threadIdx.x;
-
-            // set the variable using curve
-            detail::curve::Curve::setNewAgentVariable<T>(variable_name, agent_output_hash, value, index);
-
-            // Mark scan flag
-            genID();
+            // Allocate the new agent's slot within the birth buffer, and mark scan flag
+            const unsigned int index = genID();
+
+            if (spilled) {
+                setSpilledVariable<T>(variable_name, value, 0, false);
+            } else {
+                // set the variable using curve
+                detail::curve::Curve::setNewAgentVariable<T>(variable_name, agent_output_hash, value, index);
+            }
         }
 #if !defined(SEATBELTS) || SEATBELTS
     } else {
@@ -386,14 +487,15 @@ __device__ void DeviceAPI<MessageIn, MessageOut>::AgentOut::setVariable(const ch
         if (variable_name[0] == '_') {
             return;  // Fail silently
         }
-        // simple indexing assumes index is the thread number (this may change later)
-        const unsigned int index = (blockDim.x * blockIdx.x) + threadIdx.x;
-
-        // set the variable using curve
-        detail::curve::Curve::setNewAgentArrayVariable<T, N>(variable_name, agent_output_hash, value, index, array_index);
+        // Allocate the new agent's slot within the birth buffer, and mark scan flag
+        const unsigned int index = genID();
 
-        // Mark scan flag
-        genID();
+        if (spilled) {
+            setSpilledVariable<T>(variable_name, value, array_index, true);
+        } else {
+            // set the variable using curve
+            detail::curve::Curve::setNewAgentArrayVariable<T, N>(variable_name, agent_output_hash, value, index, array_index);
+        }
 #if !defined(SEATBELTS) || SEATBELTS
     } else {
         DTHROW("Agent output must be enabled per agent function when defining the model.\n");
@@ -414,14 +516,62 @@ __device__ id_t DeviceAPI<MessageIn, MessageOut>::AgentOut::getID() const {
 }
 #ifdef __CUDACC__
 template<typename MessageIn, typename MessageOut>
-__device__ void DeviceAPI<MessageIn, MessageOut>::AgentOut::genID() const {
-    // Only assign id and scan flag once
-    if (this->id == ID_NOT_SET) {
+__device__ unsigned int DeviceAPI<MessageIn, MessageOut>::AgentOut::genID() const {
+    // Only assign slot, id and scan flag once
+    if (this->slot == UNSET_SLOT) {
+        if (this->birthBuffer) {
+            // Compact birth buffer, slots are allocated in order of birth
+            this->slot = atomicAdd(&this->birthBuffer->count, 1u);
+            if (this->slot >= this->birthBuffer->capacity) {
+                // The buffer is full, so the birth spills, it is initialised to default values as buffer slots are
+                // Each thread outputs at most one agent, so the spill buffers (sized by the executing population) can not overflow
+                this->slot -= this->birthBuffer->capacity;
+                this->spilled = true;
+                for (unsigned int i = 0; i < this->birthBuffer->variable_count; ++i) {
+                    const detail::DeviceBirthBuffer::Variable &v = this->birthBuffer->variables[i];
+                    const unsigned int var_size = v.type_size * v.elements;
+                    memcpy(v.spill + this->slot * var_size, v.default_value, var_size);
+                }
+            }
+        } else {
+            // Full birth buffer, simple indexing assumes index is the thread number
+            this->slot = (blockDim.x * blockIdx.x) + threadIdx.x;
+            this->scan_flag[this->slot] = 1;
+        }
         this->id = atomicInc(this->nextID, std::numeric_limits<id_t>().max());
-        const unsigned int index = (blockDim.x * blockIdx.x) + threadIdx.x;
-        detail::curve::Curve::setNewAgentVariable<id_t>("_id", agent_output_hash, this->id, index);  // Can't use ID_VARIABLE_NAME inline, as it isn't of char[N] type
-        this->scan_flag[index] = 1;
+        // IDs depend on scheduling, so the new agent's random stream is keyed by its parent instead
+        const uint64_t rng_key = this->random.birthKey();
+        // Can't use ID_VARIABLE_NAME or RNG_KEY_VARIABLE_NAME inline, as they aren't of char[N] type
+        if (this->spilled) {
+            setSpilledVariable<id_t>("_id", this->id, 0, false);
+            setSpilledVariable<uint64_t>("_rng_key", rng_key, 0, false);
+        } else {
+            detail::curve::Curve::setNewAgentVariable<id_t>("_id", agent_output_hash, this->id, this->slot);
+            detail::curve::Curve::setNewAgentVariable<uint64_t>("_rng_key", agent_output_hash, rng_key, this->slot);
+        }
     }
+    return this->slot;
+}
+template<typename MessageIn, typename MessageOut>
+template<typename T>
+__device__ void DeviceAPI<MessageIn, MessageOut>::AgentOut::setSpilledVariable(const char *variable_name, const T &value, const unsigned int &array_index, const bool &is_array) const {
+    const unsigned int hash = detail::DeviceBirthBuffer::hash(variable_name);
+    for (unsigned int i = 0; i < this->birthBuffer->variable_count; ++i) {
+        const detail::DeviceBirthBuffer::Variable &v = this->birthBuffer->variables[i];
+        if (v.hash == hash) {
+#if !defined(SEATBELTS) || SEATBELTS
+            if (is_array ? (sizeof(T) != v.type_size || array_index >= v.elements) : sizeof(T) != v.type_size * v.elements) {
+                DTHROW("New agent variable '%s' type mismatch or array index out of bounds during setVariable().\n", variable_name);
+                return;
+            }
+#endif
+            memcpy(v.spill + (this->slot * v.elements + array_index) * v.type_size, &value, sizeof(T));
+            return;
+        }
+    }
+#if !defined(SEATBELTS) || SEATBELTS
+    DTHROW("New agent variable '%s' was not found during setVariable().\n", variable_name);
+#endif
 }
 #endif
 
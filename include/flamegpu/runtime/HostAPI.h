@@ -13,6 +13,7 @@
 #include "flamegpu/runtime/utility/HostEnvironment.cuh"
 #include "flamegpu/runtime/HostAPI_macros.h"
 #include "flamegpu/runtime/HostNewAgentAPI.h"
+#include "flamegpu/runtime/messaging/MessageGraph.h"
 
 namespace flamegpu {
 
@@ -61,6 +62,13 @@ class HostAPI {
      * Returns methods that work on all agents of a certain type currently in a given state
      */
     HostAgentAPI agent(const std::string &agent_name, const std::string &stateName = ModelData::DEFAULT_STATE);
+    /**
+     * Returns a handle for editing the topology of a graph message list
+     * @param message_name Name of the graph message list
+     * @throws exception::InvalidCudaMessage If the named message list does not exist
+     * @throws exception::InvalidMessageType If the named message list is not of type MessageGraph
+     */
+    MessageGraph::Topology graph(const std::string &message_name);
     /**
      * Host API access to seeded random number generation
      */
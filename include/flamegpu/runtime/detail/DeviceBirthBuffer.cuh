@@ -0,0 +1,73 @@
+#ifndef INCLUDE_FLAMEGPU_RUNTIME_DETAIL_DEVICEBIRTHBUFFER_CUH_
+#define INCLUDE_FLAMEGPU_RUNTIME_DETAIL_DEVICEBIRTHBUFFER_CUH_
+
+namespace flamegpu {
+namespace detail {
+
+/**
+ * Device metadata of a compact birth buffer, which only holds slots for the expected number of births
+ * Births which claim a slot beyond the buffer's capacity spill into the executing agent's swap buffers,
+ * which are idle whilst the agent function executes, and are gathered into the birth buffer after the function
+ * @see AgentFunctionDescription::setAgentOutputBirthRate(const float &)
+ */
+struct DeviceBirthBuffer {
+    /**
+     * A variable of the output agent, used to write births which spill beyond the buffer's capacity
+     */
+    struct Variable {
+        /**
+         * DeviceBirthBuffer::hash() of the variable's name
+         */
+        unsigned int hash;
+        /**
+         * Size of a single element of the variable in bytes
+         */
+        unsigned int type_size;
+        /**
+         * Number of elements, this will be 1 unless the variable is an array
+         */
+        unsigned int elements;
+        /**
+         * Buffer which spilled births write the variable to, indexed by slot - capacity
+         */
+        char *spill;
+        /**
+         * The variable's default value, copied to a spilled birth before any variables are set
+         */
+        const char *default_value;
+    };
+    /**
+     * Number of slots claimed by births during the agent function, this may exceed capacity
+     */
+    unsigned int count;
+    /**
+     * Number of slots within the compact birth buffer
+     */
+    unsigned int capacity;
+    /**
+     * Number of items within variables
+     */
+    unsigned int variable_count;
+    /**
+     * The output agent's variables, used to write spilled births
+     */
+    Variable *variables;
+    /**
+     * Hashes a variable name, to locate it within variables
+     * @param name The null terminated variable name
+     */
+    __host__ __device__ static unsigned int hash(const char *name) {
+        // FNV-1a
+        unsigned int h = 2166136261u;
+        while (*name) {
+            h ^= static_cast<unsigned char>(*name++);
+            h *= 16777619u;
+        }
+        return h;
+    }
+};
+
+}  // namespace detail
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_RUNTIME_DETAIL_DEVICEBIRTHBUFFER_CUH_
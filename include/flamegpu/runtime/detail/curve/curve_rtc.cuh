@@ -6,6 +6,8 @@
 #include <cstdio>
 #include <typeindex>
 #include <map>
+#include <array>
+#include <vector>
 
 namespace jitify {
 namespace experimental {
@@ -133,15 +135,43 @@ class CurveRTCHost {
      * @param type The name of the property's type (%std::type_index::name())
      * @param type_size The type size of the property's base type (sizeof()), this is the size of a single element if the property is an array property.
      * @param elements The number of elements in the property (1 unless the property is an array property)
+     * @param const_value If provided, the property's value is folded into the dynamic header as a compile time constant, rather than read from the RTC cache
      * @throws exception::UnknownInternalError If an environment property with the same name is already registered
+     * @note const_value must point to type_size * elements bytes, it is ignored if the property is not of an arithmetic type, or holds a non-finite value
      */
-    void registerEnvVariable(const char* propertyName, ptrdiff_t offset, const char* type, size_t type_size, unsigned int elements = 1);
+    void registerEnvVariable(const char* propertyName, ptrdiff_t offset, const char* type, size_t type_size, unsigned int elements = 1, const void *const_value = nullptr);
     /**
      * Unregister an environment property, so that it is nolonger included in the dynamic header
      * @param propertyName The property's name
      * @throws exception::UnknownInternalError If the specified property is not registered
      */
     void unregisterEnvVariable(const char* propertyName);
+    /**
+     * Specify an environment macro property to be included in the dynamic header
+     * @param propertyName The property's name
+     * @param d_ptr Pointer to the property's buffer in device memory
+     * @param type The name of the property's type (%std::type_index::name())
+     * @param type_size The type size of the property's base type (sizeof())
+     * @param dimensions The number of elements in each of the property's 4 dimensions
+     * @throws exception::UnknownInternalError If an environment macro property with the same name is already registered
+     */
+    void registerEnvMacroProperty(const char* propertyName, void *d_ptr, const char* type, size_t type_size, const std::array<unsigned int, 4> &dimensions);
+    /**
+     * Specify a read-only environment table to be included in the dynamic header
+     * @param tableName The table's name
+     * @param d_ptr Pointer to the table's buffer in device memory
+     * @param type_size The size of the table's element type (sizeof())
+     * @param length The number of elements in the table
+     * @throws exception::UnknownInternalError If an environment table with the same name is already registered
+     */
+    void registerEnvTable(const char* tableName, const void *d_ptr, size_t type_size, unsigned int length);
+    /**
+     * Specify an environment field to be included in the dynamic header
+     * @param fieldName The field's name
+     * @param d_ptr Pointer to the field's header in device memory, which is followed by its cells
+     * @throws exception::UnknownInternalError If an environment field with the same name is already registered
+     */
+    void registerEnvField(const char* fieldName, void *d_ptr);
     /**
      * Generates and returns the dynamic header based on the currently registered variables and properties
      * @return The dynamic Curve header
@@ -236,6 +266,69 @@ class CurveRTCHost {
          * Size of the property's base type (e.g. size of an individual element if array property)
          */
         size_t type_size;
+        /**
+         * Bytes of the property's value if it is folded into the dynamic header, otherwise empty
+         */
+        std::vector<char> const_value;
+    };
+    /**
+     * Properties for a registered environment macro property
+     */
+    struct RTCEnvMacroPropertyProperties {
+        /**
+         * Name of the property's base type
+         */
+        std::string type;
+        /**
+         * Number of elements in each of the property's 4 dimensions
+         */
+        std::array<unsigned int, 4> dimensions;
+        /**
+         * Size of the property's base type
+         */
+        size_t type_size;
+        /**
+         * Pointer to the property's buffer in device memory
+         */
+        void *d_ptr;
+        /**
+         * Pointer to a location in host memory where the device pointer to this property's buffer must be stored
+         */
+        void *h_data_ptr;
+    };
+    /**
+     * Properties for a registered environment table
+     */
+    struct RTCEnvTableProperties {
+        /**
+         * Size of the table's element type
+         */
+        size_t type_size;
+        /**
+         * Number of elements in the table
+         */
+        unsigned int length;
+        /**
+         * Pointer to the table's buffer in device memory
+         */
+        const void *d_ptr;
+        /**
+         * Pointer to a location in host memory where the device pointer to this table's buffer must be stored
+         */
+        void *h_data_ptr;
+    };
+    /**
+     * Properties for a registered environment field
+     */
+    struct RTCEnvFieldProperties {
+        /**
+         * Pointer to the field's header in device memory
+         */
+        void *d_ptr;
+        /**
+         * Pointer to a location in host memory where the device pointer to this field's header must be stored
+         */
+        void *h_data_ptr;
     };
 
  private:
@@ -251,6 +344,25 @@ class CurveRTCHost {
      * Sub-method for setting up the variable/property get methods
      */
     void initHeaderGetters();
+    /**
+     * Returns the name of the type used to declare a folded environment property
+     * @param type The demangled name of the property's type
+     * @return An empty string if properties of the type cannot be folded
+     */
+    static std::string getFoldedEnvType(const std::string &type);
+    /**
+     * Returns a literal which reproduces an element of a folded environment property exactly
+     * @param props The folded environment property, props.const_value must not be empty
+     * @param index The index of the element
+     * @return An empty string if the element has no literal (e.g. it is not finite)
+     */
+    static std::string getFoldedEnvLiteral(const RTCEnvVariableProperties &props, unsigned int index);
+    /**
+     * Returns the namespace scope declaration of a constexpr device array of the property's type, holding a folded environment property
+     * @param symbol The name of the array
+     * @param props The folded environment property, props.const_value must not be empty
+     */
+    static std::string getFoldedEnvValue(const std::string &symbol, const RTCEnvVariableProperties &props);
     /**
      * Initialise all the variable h_data_ptr properties
      * This should only be called once during the init chain
@@ -282,6 +394,18 @@ class CurveRTCHost {
      * Offset into h_data_buffer where output agent (device agent birth) variable data begins
      */
     size_t newAgent_data_offset = 0;
+    /**
+     * Offset into h_data_buffer where environment macro property data begins
+     */
+    size_t envMacro_data_offset = 0;
+    /**
+     * Offset into h_data_buffer where environment table data begins
+     */
+    size_t envTable_data_offset = 0;
+    /**
+     * Offset into h_data_buffer where environment field data begins
+     */
+    size_t envField_data_offset = 0;
     /**
      * Size of the allocation pointed to by h_data_buffer
      */
@@ -315,6 +439,21 @@ class CurveRTCHost {
      * <name, RTCVariableProperties>
      */
     std::map<std::string, RTCEnvVariableProperties> RTCEnvVariables;
+    /**
+     * Registered environment macro property properties
+     * <name, RTCEnvMacroPropertyProperties>
+     */
+    std::map<std::string, RTCEnvMacroPropertyProperties> RTCEnvMacroProperties;
+    /**
+     * Registered environment table properties
+     * <name, RTCEnvTableProperties>
+     */
+    std::map<std::string, RTCEnvTableProperties> RTCEnvTables;
+    /**
+     * Registered environment field properties
+     * <name, RTCEnvFieldProperties>
+     */
+    std::map<std::string, RTCEnvFieldProperties> RTCEnvFields;
 };
 
 }  // namespace curve
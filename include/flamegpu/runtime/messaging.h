@@ -10,10 +10,13 @@
 #include "flamegpu/runtime/messaging/MessageBruteForce/MessageBruteForceHost.h"
 #include "flamegpu/runtime/messaging/MessageSpatial2D/MessageSpatial2DHost.h"
 #include "flamegpu/runtime/messaging/MessageSpatial3D/MessageSpatial3DHost.h"
+#include "flamegpu/runtime/messaging/MessageSparseSpatial3D/MessageSparseSpatial3DHost.h"
+#include "flamegpu/runtime/messaging/MessageKNN/MessageKNNHost.h"
 #include "flamegpu/runtime/messaging/MessageArray/MessageArrayHost.h"
 #include "flamegpu/runtime/messaging/MessageArray2D/MessageArray2DHost.h"
 #include "flamegpu/runtime/messaging/MessageArray3D/MessageArray3DHost.h"
 #include "flamegpu/runtime/messaging/MessageBucket/MessageBucketHost.h"
+#include "flamegpu/runtime/messaging/MessageGraph/MessageGraphHost.h"
 
 /**
  * ######################################################
@@ -609,11 +609,14 @@ class MessageArray2D::Out {
      * @param message_hash Added to agentfn_hash to produce combined_hash
      * @param _metadata Message specialisation specific metadata struct (of type MessageArray2D::MetaData)
      * @param scan_flag_messageOutput Scan flag array for optional message output
+     * @param message_output_max The maximum number of messages each agent may output
      */
-    __device__ Out(detail::curve::Curve::NamespaceHash agentfn_hash, detail::curve::Curve::NamespaceHash message_hash, const void *_metadata, unsigned int *scan_flag_messageOutput)
+    __device__ Out(detail::curve::Curve::NamespaceHash agentfn_hash, detail::curve::Curve::NamespaceHash message_hash, const void *_metadata, unsigned int *scan_flag_messageOutput, const unsigned int message_output_max)
         : combined_hash(agentfn_hash + message_hash)
         , scan_flag(scan_flag_messageOutput)
         , metadata(reinterpret_cast<const MetaData*>(_metadata))
+        , max_messages(message_output_max)
+        , emitted(0)
     { }
     /**
      * Sets the array index to store the message in
@@ -644,7 +647,29 @@ class MessageArray2D::Out {
     template<typename T, unsigned int N, unsigned int M>
     __device__ void setVariable(const char(&variable_name)[M], const unsigned int& index, T value) const;
 
+    /**
+     * Completes the agent's current message, so that subsequent calls to setIndex() and setVariable() begin the agent's next message
+     * Only messages which have had their index set are output, so it is safe to call this after the final message
+     * @note The agent function must be configured to permit multiple messages per agent
+     * @see AgentFunctionDescription::setMessageOutputMax(const unsigned int &)
+     */
+    __device__ void emit() const { ++emitted; }
+
  protected:
+    /**
+     * Returns the index within the message output buffers of the agent's current message
+     * @return The index, or 0xffffffff if the agent has already output the maximum number of messages
+     * @see MessageBruteForce::Out::getOutputIndex()
+     */
+    __device__ unsigned int getOutputIndex() const {
+        if (emitted >= max_messages) {
+#if !defined(SEATBELTS) || SEATBELTS
+            DTHROW("Agent attempted to output more than the maximum of %u messages.\n", max_messages);
+#endif
+            return 0xffffffff;
+        }
+        return (((blockDim.x * blockIdx.x) + threadIdx.x) * max_messages) + emitted;
+    }
     /**
      * CURVE hash for accessing message data
      * agentfn_hash + message_hash
@@ -658,6 +683,14 @@ class MessageArray2D::Out {
      * Metadata struct for accessing messages
      */
     const MetaData * const metadata;
+    /**
+     * The maximum number of messages each agent may output
+     */
+    unsigned int max_messages;
+    /**
+     * The number of messages the agent has completed via emit()
+     */
+    mutable unsigned int emitted;
 };
 
 
@@ -743,7 +776,10 @@ __device__ void MessageArray2D::Out::setVariable(const char(&variable_name)[N],
     if (variable_name[0] == '_') {
         return;  // Fail silently
     }
-    unsigned int index = (blockDim.x * blockIdx.x) + threadIdx.x;
+    const unsigned int index = getOutputIndex();
+    if (index == 0xffffffff) {
+        return;
+    }
 
     // set the variable using curve
     detail::curve::Curve::setMessageVariable<T>(variable_name, combined_hash, value, index);
@@ -755,7 +791,10 @@ __device__ void MessageArray2D::Out::setVariable(const char(&variable_name)[M],
     if (variable_name[0] == '_') {
         return;  // Fail silently
     }
-    unsigned int index = (blockDim.x * blockIdx.x) + threadIdx.x;
+    const unsigned int index = getOutputIndex();
+    if (index == 0xffffffff) {
+        return;
+    }
 
     // set the variable using curve
     detail::curve::Curve::setMessageArrayVariable<T, N>(variable_name, combined_hash, value, index, array_index);
@@ -768,7 +807,10 @@ __device__ void MessageArray2D::Out::setVariable(const char(&variable_name)[M],
  * Sets the array index to store the message in
  */
 __device__ void MessageArray2D::Out::setIndex(const size_type &x, const size_type &y) const {
-    unsigned int index = (blockDim.x * blockIdx.x) + threadIdx.x;
+    const unsigned int index = getOutputIndex();
+    if (index == 0xffffffff) {
+        return;
+    }
     size_type index_1d =
         y * metadata->dimensions[0] +
         x;
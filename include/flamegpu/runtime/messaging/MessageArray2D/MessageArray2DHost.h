@@ -39,6 +39,7 @@ class MessageArray2D::CUDAModelHandler : public MessageSpecialisationHandler {
     /**
      * Sort messages according to index
      * Detect and report any duplicate indicies/gaps
+     * If any variables are combined, messages output to the same index are instead reduced to a single message
      * @param scatter Scatter instance and scan arrays to be used (CUDASimulation::singletons->scatter)
      * @param streamId The stream index to use for accessing stream specific resources such as scan compaction arrays and buffers
      * @param stream CUDA stream to be used for async CUDA operations
@@ -79,6 +80,29 @@ class MessageArray2D::CUDAModelHandler : public MessageSpecialisationHandler {
      * Allocated length of d_write_flag (in number of uint, not bytes)
      */
     size_type d_write_flag_len;
+    /**
+     * If true, messages output to the same index are combined when the index is built
+     */
+    bool combined;
+    /**
+     * Arrays used to sort messages by index when combining, and the original index of each message in sorted order
+     */
+    unsigned int *d_keys, *d_vals, *d_permutation;
+    /**
+     * Allocated length of d_keys, d_vals and d_permutation (in number of uint, not bytes)
+     */
+    size_type d_keys_vals_len;
+    /**
+     * PBM used when combining messages, it has a bin per index and a final bin for messages with an out of bounds index
+     */
+    unsigned int *d_pbm;
+    /**
+     * Reduces the messages output to each index into a single message
+     * @param scatter Scatter instance and scan arrays to be used (CUDASimulation::singletons->scatter)
+     * @param streamId The stream index to use for accessing stream specific resources such as scan compaction arrays and buffers
+     * @param stream CUDA stream to be used for async CUDA operations
+     */
+    void combine(CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream);
 };
 
 /**
@@ -151,6 +175,26 @@ class MessageArray2D::Description : public MessageBruteForce::Description {
     std::array<size_type, 2> getDimensions() const;
     size_type getDimX() const;
     size_type getDimY() const;
+    /**
+     * Sets the operator used to combine the named variable, when multiple messages are output to the same index
+     * If any variable is combined, messages output to the same index are reduced to a single message, rather than raising exception::ArrayMessageWriteConflict
+     * Variables without an operator take the value of the first message output to the index
+     * Messages are combined in the order they were output, so floating point results are reproducible
+     * @note Messages are reduced when the index is built, not as they are output, so the message list still stores every message output,
+     *       memory remains O(messages) rather than O(elements), only the work of message readers is reduced
+     * @see MessageCombine
+     * @param variable_name Name of the variable to be combined
+     * @param op The operator used to combine the variable
+     * @throws exception::InvalidMessageVar If a variable with the name does not exist within the message
+     * @throws exception::InvalidArgument If the variable's type is not int32_t, uint32_t, int64_t, uint64_t, float or double
+     */
+    void setCombine(const std::string &variable_name, const MessageCombine &op);
+    /**
+     * @param variable_name Name of the variable
+     * @return The operator used to combine the named variable
+     * @throws exception::InvalidMessageVar If a variable with the name does not exist within the message
+     */
+    MessageCombine getCombine(const std::string &variable_name) const;
 };
 
 }  // namespace flamegpu
@@ -2,11 +2,44 @@
 #define INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEBRUTEFORCE_H_
 
 #include "flamegpu/runtime/messaging/MessageNone.h"
+#include "flamegpu/util/detail/MessageTile.cuh"
 
 namespace flamegpu {
 
 struct ModelData;
 
+/**
+ * Operators which may be declared per message variable, to reduce all messages output to the same array element or bucket into a single message
+ * Messages are combined when the message list's index is built, not as they are output (reduce-on-read, not reduce-on-write)
+ * Message output is unchanged, so the message list still stores every message output, and memory remains O(messages) rather than O(elements)
+ * Readers then access a single message per element, so their work is O(1) per element
+ * Reducing as messages are output is not supported, as message variables may be set before setIndex()/setKey(), so the destination element is not known when a value is written
+ * @see MessageArray2D::Description::setCombine()
+ * @see MessageBucket::Description::setCombine()
+ */
+enum class MessageCombine {
+    /**
+     * The variable is not combined, the value of the first message is retained
+     */
+    None,
+    /**
+     * The sum of the variable's values
+     */
+    Sum,
+    /**
+     * The minimum of the variable's values
+     */
+    Min,
+    /**
+     * The maximum of the variable's values
+     */
+    Max,
+    /**
+     * The number of messages combined, the value output to the variable is ignored
+     */
+    Count
+};
+
 /**
  * Brute force messaging functionality
  *
@@ -27,11 +60,33 @@ class MessageBruteForce {
     // Device
     class In;  // Forward declare inner classes
     class Out;  // Forward declare inner classes
+    /**
+     * Size of the shared memory buffer used by each block for tiled message iteration
+     * @see In::tiled()
+     */
+    static constexpr unsigned int TILE_BYTES = 8192;
+    /**
+     * The maximum number of read variables which can be staged for tiled message iteration
+     * If more variables are read, tiled iteration reads directly from global memory
+     */
+    static constexpr unsigned int MAX_TILE_VARIABLES = 8;
     /**
      * MetaData required by brute force during message reads
      */
     struct MetaData {
         unsigned int length = 0;
+        /**
+         * The number of messages per tile, 0 if the read variables are not staged
+         */
+        unsigned int tile_length = 0;
+        /**
+         * The number of items in tile_variables
+         */
+        unsigned int tile_variable_count = 0;
+        /**
+         * The read variables, which are staged within each tile
+         */
+        util::detail::tile::Variable tile_variables[MAX_TILE_VARIABLES];
     };
 };
 
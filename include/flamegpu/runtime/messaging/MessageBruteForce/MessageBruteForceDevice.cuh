@@ -22,17 +22,19 @@ class MessageBruteForce::In {
  public:
     class Message;      // Forward declare inner classes
     class iterator;     // Forward declare inner classes
+    class Tiled;        // Forward declare inner classes
 
     /**
      * Constructer
      * Initialises member variables
      * @param agentfn_hash Added to message_hash to produce combined_hash
      * @param message_hash Added to agentfn_hash to produce combined_hash
-     * @param metadata Reinterpreted as type MessageBruteForce::MetaData to extract length
+     * @param _metadata Reinterpreted as type MessageBruteForce::MetaData to extract length and the tile schedule
      */
-    __device__ In(detail::curve::Curve::NamespaceHash agentfn_hash, detail::curve::Curve::NamespaceHash message_hash, const void *metadata)
+    __device__ In(detail::curve::Curve::NamespaceHash agentfn_hash, detail::curve::Curve::NamespaceHash message_hash, const void *_metadata)
         : combined_hash(agentfn_hash + message_hash)
-        , len(reinterpret_cast<const MetaData*>(metadata)->length)
+        , len(reinterpret_cast<const MetaData*>(_metadata)->length)
+        , metadata(reinterpret_cast<const MetaData*>(_metadata))
     { }
     /**
      * Returns the number of elements in the message list.
@@ -53,6 +55,16 @@ class MessageBruteForce::In {
         // If there can be many begin, each with diff end, we need a middle layer to host the iterator/s
         return iterator(*this, len);
     }
+    /**
+     * Returns an alternate range over the message list, in which each block cooperatively stages tiles of messages within shared memory
+     * The message variables read by the agent function are staged, each thread then reads messages from the tile rather than global memory
+     * This reduces global memory traffic when many agents read every message
+     * @note Every agent within the block must iterate the full message list, the loop must not be exited early or only entered by some agents
+     * @note If the read variables do not fit within a tile (see MessageBruteForce::TILE_BYTES, MessageBruteForce::MAX_TILE_VARIABLES), messages are read from global memory
+     * @note The final block of the launch may be partially populated, so it always reads messages from global memory
+     * @see AgentFunctionDescription::setMessageInputVariables(const std::vector<std::string> &)
+     */
+    __device__ Tiled tiled() const;
 
     /**
      * Provides access to a specific message
@@ -174,8 +186,197 @@ class MessageBruteForce::In {
      * Total number of messages in the message list
      */
     size_type len;
+    /**
+     * Device pointer to metadata required for accessing data structure
+     * e.g. tile schedule
+     */
+    const MetaData *metadata;
+};
+
+/**
+ * Range over the brute force message list, which stages tiles of messages within shared memory
+ * Returned by MessageBruteForce::In::tiled()
+ */
+class MessageBruteForce::In::Tiled {
+ public:
+    /**
+     * Provides access to a specific message
+     * Returned by the iterator
+     * @see In::Tiled::iterator
+     */
+    class Message {
+        /**
+         * Paired Tiled class which created the iterator
+         */
+        const Tiled &_parent;
+        /**
+         * Position within the message list
+         */
+        size_type index;
+        /**
+         * Position within the message list of the first message in the currently staged tile
+         */
+        size_type tile_first;
+
+     public:
+        /**
+         * Constructs a message and directly initialises all of it's member variables
+         * @note See member variable documentation for their purposes
+         */
+        __device__ Message(const Tiled &parent, size_type _index) : _parent(parent), index(_index), tile_first(0) {}
+        /**
+         * Equality operator
+         * Compares all internal member vars for equality
+         * @note Does not compare _parent
+         */
+        __device__ bool operator==(const Message& rhs) const { return this->index == rhs.index; }
+        /**
+         * Inequality operator
+         * Returns inverse of equality operator
+         * @see operator==(const Message&)
+         */
+        __device__ bool operator!=(const Message& rhs) const { return this->index != rhs.index; }
+        /**
+         * Updates the message to return variables from the next message in the message list
+         * If the message is beyond the current tile, the block stages the next tile
+         * @return Returns itself
+         */
+        __device__ Message& operator++() {
+            ++index;
+            const unsigned int tile_length = _parent.tile_length;
+            if (tile_length && index - tile_first == tile_length && index < _parent._parent.len) {
+                tile_first = index;
+                _parent.stage(tile_first);
+            }
+            return *this;
+        }
+        /**
+         * Returns the index of the message within the full message list
+         */
+        __device__ size_type getIndex() const { return this->index; }
+        /**
+         * Returns the value for the current message attached to the named variable
+         * @param variable_name Name of the variable
+         * @tparam T type of the variable
+         * @tparam N Length of variable name (this should be implicit if a string literal is passed to variable name)
+         * @return The specified variable, else 0x0 if an error occurs
+         * @throws exception::DeviceError If name is not a valid variable within the agent (flamegpu must be built with SEATBELTS enabled for device error checking)
+         * @throws exception::DeviceError If T is not the type of variable 'name' within the agent (flamegpu must be built with SEATBELTS enabled for device error checking)
+         */
+        template<typename T, unsigned int N> __device__
+        T getVariable(const char(&variable_name)[N]) const;
+        /**
+         * Returns the specified variable array element from the current message attached to the named variable
+         * @param variable_name name used for accessing the variable, this value should be a string literal e.g. "foobar"
+         * @param index Index of the element within the variable array to return
+         * @tparam T Type of the message variable being accessed
+         * @tparam N The length of the array variable, as set within the model description hierarchy
+         * @tparam M Length of variable_name, this should always be implicit if passing a string literal
+         * @throws exception::DeviceError If name is not a valid variable within the agent (flamegpu must be built with SEATBELTS enabled for device error checking)
+         * @throws exception::DeviceError If T is not the type of variable 'name' within the message (flamegpu must be built with SEATBELTS enabled for device error checking)
+         * @throws exception::DeviceError If index is out of bounds for the variable array specified by name (flamegpu must be built with SEATBELTS enabled for device error checking)
+         */
+        template<typename T, MessageNone::size_type N, unsigned int M> __device__
+        T getVariable(const char(&variable_name)[M], const unsigned int &index) const;
+    };
+    /**
+     * Stock iterator for iterating MessageBruteForce::In::Tiled::Message objects
+     */
+    class iterator {
+        /**
+         * The message returned to the user
+         */
+        Message _message;
+
+     public:
+        /**
+         * Constructor
+         * This iterator is constructed by MessageBruteForce::In::Tiled::begin()
+         * @see MessageBruteForce::In::Tiled::begin()
+         */
+        __device__ iterator(const Tiled &parent, size_type index) : _message(parent, index) {}
+        /**
+         * Moves to the next message
+         */
+        __device__ iterator& operator++() { ++_message;  return *this; }
+        /**
+         * Equality operator
+         * Compares message
+         */
+        __device__ bool operator==(const iterator& rhs) const { return  _message == rhs._message; }
+        /**
+         * Inequality operator
+         * Compares message
+         */
+        __device__ bool operator!=(const iterator& rhs) const { return  _message != rhs._message; }
+        /**
+         * Dereferences the iterator to return the message object, for accessing variables
+         */
+        __device__  Message& operator*() { return _message; }
+    };
+    /**
+     * Constructor
+     * @param parent The message list being iterated
+     * @param _tile The block's shared memory tile buffer, of MessageBruteForce::TILE_BYTES
+     */
+    __device__ Tiled(const In &parent, char *_tile)
+        : _parent(parent)
+        // Threads beyond the population exit before the agent function, so only the final block may be partial
+        // Staging requires every thread of the block to synchronise, so the final block reads from global memory instead
+        , tile_length(blockIdx.x + 1 < gridDim.x ? parent.metadata->tile_length : 0)
+        , tile(_tile) {}
+    /**
+     * Returns the number of elements in the message list.
+     */
+    __device__ size_type size(void) const { return _parent.len; }
+    /**
+     * Stages the first tile, and returns an iterator to the start of the message list
+     */
+    __device__ iterator begin(void) const {
+        if (tile_length && _parent.len)
+            stage(0);
+        return iterator(*this, 0);
+    }
+    /**
+     * Returns an iterator to the position beyond the end of the message list
+     */
+    __device__ iterator end(void) const {
+        return iterator(*this, _parent.len);
+    }
+
+ private:
+    /**
+     * Cooperatively stages the tile beginning at the specified message
+     * The block synchronises before staging, so that the previous tile has been consumed, and after staging
+     * @param first Index of the tile's first message within the message list
+     */
+    __device__ void stage(const size_type &first) const {
+        const MetaData *md = _parent.metadata;
+        const unsigned int remaining = _parent.len - first;
+        __syncthreads();
+        util::detail::tile::stage(md->tile_variables, md->tile_variable_count, tile_length,
+            first, remaining < tile_length ? remaining : tile_length, threadIdx.x, blockDim.x, tile);
+        __syncthreads();
+    }
+    /**
+     * The message list being iterated
+     */
+    const In &_parent;
+    /**
+     * The number of messages per tile, 0 if messages are read from global memory
+     */
+    const unsigned int tile_length;
+    /**
+     * The block's shared memory tile buffer
+     */
+    char *tile;
 };
 
+__device__ inline MessageBruteForce::In::Tiled MessageBruteForce::In::tiled() const {
+    __shared__ __align__(16) char tile[TILE_BYTES];
+    return Tiled(*this, tile);
+}
+
 
 
 /**
@@ -190,10 +391,13 @@ class MessageBruteForce::Out {
      * @param agentfn_hash Added to message_hash to produce combined_hash
      * @param message_hash Added to agentfn_hash to produce combined_hash
      * @param scan_flag_messageOutput Scan flag array for optional message output
+     * @param message_output_max The maximum number of messages each agent may output
      */
-    __device__ Out(detail::curve::Curve::NamespaceHash agentfn_hash, detail::curve::Curve::NamespaceHash message_hash, const void *, unsigned int *scan_flag_messageOutput)
+    __device__ Out(detail::curve::Curve::NamespaceHash agentfn_hash, detail::curve::Curve::NamespaceHash message_hash, const void *, unsigned int *scan_flag_messageOutput, const unsigned int message_output_max)
         : combined_hash(agentfn_hash + message_hash)
         , scan_flag(scan_flag_messageOutput)
+        , max_messages(message_output_max)
+        , emitted(0)
     { }
     /**
      * Sets the specified variable for this agents message
@@ -219,8 +423,29 @@ class MessageBruteForce::Out {
      */
     template<typename T, unsigned int N, unsigned int M>
     __device__ void setVariable(const char(&variable_name)[M], const unsigned int& index, T value) const;
+    /**
+     * Completes the agent's current message, so that subsequent calls to setVariable() begin the agent's next message
+     * Only messages which have had a variable set are output, so it is safe to call this after the final message
+     * @note The agent function must be configured to permit multiple messages per agent
+     * @see AgentFunctionDescription::setMessageOutputMax(const unsigned int &)
+     */
+    __device__ void emit() const { ++emitted; }
 
  protected:
+    /**
+     * Returns the index within the message output buffers of the agent's current message
+     * Each agent has max_messages consecutive slots, so compaction preserves the order in which messages were emitted
+     * @return The index, or 0xffffffff if the agent has already output the maximum number of messages
+     */
+    __device__ unsigned int getOutputIndex() const {
+        if (emitted >= max_messages) {
+#if !defined(SEATBELTS) || SEATBELTS
+            DTHROW("Agent attempted to output more than the maximum of %u messages.\n", max_messages);
+#endif
+            return 0xffffffff;
+        }
+        return (((blockDim.x * blockIdx.x) + threadIdx.x) * max_messages) + emitted;
+    }
     /**
      * CURVE hash for accessing message data
      * agentfn_hash + message_hash
@@ -230,6 +455,14 @@ class MessageBruteForce::Out {
      * Scan flag array for optional message output
      */
     unsigned int *scan_flag;
+    /**
+     * The maximum number of messages each agent may output
+     */
+    unsigned int max_messages;
+    /**
+     * The number of messages the agent has completed via emit()
+     */
+    mutable unsigned int emitted;
 };
 
 template<typename T, unsigned int N>
@@ -261,14 +494,68 @@ T MessageBruteForce::In::Message::getVariable(const char(&variable_name)[M], con
     return value;
 }
 
+template<typename T, unsigned int N>
+__device__ T MessageBruteForce::In::Tiled::Message::getVariable(const char(&variable_name)[N]) const {
+    const In &in = this->_parent._parent;
+#if !defined(SEATBELTS) || SEATBELTS
+    // Ensure that the message is within bounds.
+    if (index >= in.len) {
+        DTHROW("Brute force message index exceeds messagelist length, unable to get variable '%s'.\n", variable_name);
+        return static_cast<T>(0);
+    }
+#endif
+    const int v = this->_parent.tile_length ? util::detail::tile::find(in.metadata->tile_variables, in.metadata->tile_variable_count, util::detail::tile::hash(variable_name)) : -1;
+    if (v < 0) {
+        // The variable is not staged, so read it from global memory
+        return detail::curve::Curve::getMessageVariable_ldg<T>(variable_name, in.combined_hash, index);
+    }
+    const util::detail::tile::Variable &var = in.metadata->tile_variables[v];
+#if !defined(SEATBELTS) || SEATBELTS
+    if (var.size != sizeof(T)) {
+        DTHROW("Brute force message variable '%s' type size mismatch %u != %llu.\n", variable_name, var.size, static_cast<unsigned long long>(sizeof(T)));  // NOLINT(runtime/int)
+        return static_cast<T>(0);
+    }
+#endif
+    return *reinterpret_cast<const T*>(util::detail::tile::element(var, this->_parent.tile, this->_parent.tile_length, index - tile_first));
+}
+template<typename T, MessageNone::size_type N, unsigned int M> __device__
+T MessageBruteForce::In::Tiled::Message::getVariable(const char(&variable_name)[M], const unsigned int& array_index) const {
+    const In &in = this->_parent._parent;
+#if !defined(SEATBELTS) || SEATBELTS
+    // Ensure that the message is within bounds.
+    if (index >= in.len) {
+        DTHROW("Brute force message index exceeds messagelist length, unable to get variable '%s'.\n", variable_name);
+        return static_cast<T>(0);
+    }
+#endif
+    const int v = this->_parent.tile_length ? util::detail::tile::find(in.metadata->tile_variables, in.metadata->tile_variable_count, util::detail::tile::hash(variable_name)) : -1;
+    if (v < 0) {
+        // The variable is not staged, so read it from global memory
+        return detail::curve::Curve::getMessageArrayVariable_ldg<T, N>(variable_name, in.combined_hash, index, array_index);
+    }
+    const util::detail::tile::Variable &var = in.metadata->tile_variables[v];
+#if !defined(SEATBELTS) || SEATBELTS
+    if (var.size != sizeof(T) * N) {
+        DTHROW("Brute force message array variable '%s' type size mismatch %u != %llu.\n", variable_name, var.size, static_cast<unsigned long long>(sizeof(T) * N));  // NOLINT(runtime/int)
+        return static_cast<T>(0);
+    }
+    if (array_index >= N) {
+        DTHROW("Brute force message array variable '%s' index %u is out of bounds [0, %u).\n", variable_name, array_index, N);
+        return static_cast<T>(0);
+    }
+#endif
+    return reinterpret_cast<const T*>(util::detail::tile::element(var, this->_parent.tile, this->_parent.tile_length, index - tile_first))[array_index];
+}
+
 template<typename T, unsigned int N>
 __device__ void MessageBruteForce::Out::setVariable(const char(&variable_name)[N], T value) const {  // message name or variable name
     if (variable_name[0] == '_') {
         return;  // Fail silently
     }
-    unsigned int index = (blockDim.x * blockIdx.x) + threadIdx.x;  // + d_message_count;
-
-    // Todo: checking if the output message type is single or optional?  (d_message_type)
+    const unsigned int index = getOutputIndex();
+    if (index == 0xffffffff) {
+        return;
+    }
 
     // set the variable using curve
     detail::curve::Curve::setMessageVariable<T>(variable_name, combined_hash, value, index);
@@ -281,9 +568,10 @@ __device__ void MessageBruteForce::Out::setVariable(const char(&variable_name)[M
     if (variable_name[0] == '_') {
         return;  // Fail silently
     }
-    unsigned int index = (blockDim.x * blockIdx.x) + threadIdx.x;
-
-    // Todo: checking if the output message type is single or optional?  (d_message_type)
+    const unsigned int index = getOutputIndex();
+    if (index == 0xffffffff) {
+        return;
+    }
 
     // set the variable using curve
     detail::curve::Curve::setMessageArrayVariable<T, N>(variable_name, combined_hash, value, index, array_index);
@@ -3,6 +3,8 @@
 
 #include <typeindex>
 #include <memory>
+#include <map>
+#include <set>
 #include <unordered_map>
 #include <string>
 #include <vector>
@@ -19,7 +21,7 @@ namespace flamegpu {
 
 /**
  * Blank handler, brute force requires no index or special allocations
- * Only stores the length on device
+ * Only stores the length, and the read variables staged by tiled iteration, on device
  */
 class MessageBruteForce::CUDAModelHandler : public MessageSpecialisationHandler {
  public:
@@ -46,7 +48,7 @@ class MessageBruteForce::CUDAModelHandler : public MessageSpecialisationHandler
      */
     void init(CUDAScatter &scatter, const unsigned int &streamId) override;
     /**
-     * Updates the length of the messagelist stored on device
+     * Updates the length of the messagelist stored on device, and the read variables staged by tiled iteration
      * @param scatter Scatter instance and scan arrays to be used (CUDASimulation::singletons->scatter)
      * @param streamId The stream index to use for accessing stream specific resources such as scan compaction arrays and buffers
      * @param stream CUDA stream to be used for async CUDA operations
@@ -68,11 +70,11 @@ class MessageBruteForce::CUDAModelHandler : public MessageSpecialisationHandler
 
  private:
     /**
-     * Host copy of metadata struct (message list length)
+     * Host copy of metadata struct (message list length, tile schedule)
      */
     MetaData hd_metadata;
     /**
-     * Pointer to device copy of metadata struct (message list length)
+     * Pointer to device copy of metadata struct (message list length, tile schedule)
      */
     MetaData *d_metadata;
     /**
@@ -95,6 +97,21 @@ struct MessageBruteForce::Data {
      * Holds all of the message's variable definitions
      */
     VariableMap variables;
+    /**
+     * Message variables which are read when building the message list's index
+     * These are always reordered and mapped, regardless of which variables are read by agent functions
+     */
+    std::set<std::string> index_variables;
+    /**
+     * Operators used to combine the messages output to the same element, for each variable which is combined
+     * Variables not present are not combined
+     * Only supported by message types which expose setCombine()
+     */
+    std::map<std::string, MessageCombine> combine_ops;
+    /**
+     * @return True if any of the message's variables are combined, so that only a single message is stored per element
+     */
+    bool isCombined() const { return !combine_ops.empty(); }
     /**
      * Description class which provides convenient accessors
      */
@@ -103,11 +120,29 @@ struct MessageBruteForce::Data {
      * Name of the message, used to refer to the message in many functions
      */
     std::string name;
+    /**
+     * The number of messages the message list is initially allocated to hold
+     * @see Description::setCapacityHint(const unsigned int &)
+     */
+    unsigned int capacity_hint;
     /**
      * The number of functions that have optional output of this message type
      * This value is modified by AgentFunctionDescription
      */
     unsigned int optional_outputs;
+    /**
+     * If set, the message list is a view over the variables of this agent, rather than being output by agent functions
+     * Only supported by message types which expose setAgentView()
+     */
+    std::string view_agent;
+    /**
+     * The state of view_agent which the message list is a view over
+     */
+    std::string view_state;
+    /**
+     * @return True if the message list is a view over an agent state's variables
+     */
+    bool isAgentView() const { return !view_agent.empty(); }
     /**
      * Equality operator, checks whether MessageData hierarchies are functionally the same
      * @returns True when messages are the same
@@ -254,8 +289,35 @@ class MessageBruteForce::Description {
      * @return True when a variable with the specified name exists within the message
      */
     bool hasVariable(const std::string &variable_name) const;
+    /**
+     * Sets the number of messages the message list is expected to hold
+     * The message list is allocated with at least this capacity when it is first used, rather than growing to fit the messages output
+     * Beyond this capacity, the message list grows by 1.5x, retaining existing messages
+     * @param capacity The expected number of messages, 0 to disable
+     */
+    void setCapacityHint(const unsigned int &capacity);
+    /**
+     * @return The number of messages the message list is expected to hold
+     * @see setCapacityHint(const unsigned int &)
+     */
+    unsigned int getCapacityHint() const;
 
  protected:
+    /**
+     * Sets the operator used to combine the named variable, when multiple messages are output to the same element
+     * Used by message types which support combined messages, these reduce messages when the index is built, not as they are output
+     * @param variable_name Name of the variable to be combined
+     * @param op The operator used to combine the variable, MessageCombine::None removes a previously set operator
+     * @throws exception::InvalidMessageVar If a variable with the name does not exist within the message, or it is reserved for internal usage
+     * @throws exception::InvalidArgument If the variable's type is not int32_t, uint32_t, int64_t, uint64_t, float or double
+     */
+    void setVariableCombine(const std::string &variable_name, const MessageCombine &op);
+    /**
+     * @param variable_name Name of the variable
+     * @return The operator used to combine the named variable
+     * @throws exception::InvalidMessageVar If a variable with the name does not exist within the message
+     */
+    MessageCombine getVariableCombine(const std::string &variable_name) const;
     /**
      * Root of the model hierarchy
      */
@@ -267,9 +267,10 @@ class MessageBucket::Out : public MessageBruteForce::Out {
     * @param message_hash Added to agentfn_hash to produce combined_hash
     * @param _metadata Message specialisation specific metadata struct (of type MessageBucket::MetaData)
     * @param scan_flag_messageOutput Scan flag array for optional message output
+    * @param message_output_max The maximum number of messages each agent may output
     */
-    __device__ Out(detail::curve::Curve::NamespaceHash agentfn_hash, detail::curve::Curve::NamespaceHash message_hash, const void *_metadata, unsigned int *scan_flag_messageOutput)
-        : MessageBruteForce::Out(agentfn_hash, message_hash, nullptr, scan_flag_messageOutput)
+    __device__ Out(detail::curve::Curve::NamespaceHash agentfn_hash, detail::curve::Curve::NamespaceHash message_hash, const void *_metadata, unsigned int *scan_flag_messageOutput, const unsigned int message_output_max)
+        : MessageBruteForce::Out(agentfn_hash, message_hash, nullptr, scan_flag_messageOutput, message_output_max)
 #if !defined(SEATBELTS) || SEATBELTS
         , metadata(reinterpret_cast<const MetaData*>(_metadata))
 #else
@@ -301,7 +302,10 @@ __device__ MessageBucket::In::Filter::Filter(const MetaData* _metadata, const de
 }
 
 __device__ void MessageBucket::Out::setKey(const IntT &key) const {
-    unsigned int index = (blockDim.x * blockIdx.x) + threadIdx.x;  // + d_message_count;
+    const unsigned int index = getOutputIndex();
+    if (index == 0xffffffff) {
+        return;
+    }
 
 #if !defined(SEATBELTS) || SEATBELTS
     if (key < metadata->min || key >= metadata->max) {
@@ -77,6 +77,14 @@ class MessageBucket::CUDAModelHandler : public MessageSpecialisationHandler {
     */
     unsigned int bucketCount;
     /**
+    * If true, the index is built with a stable sort rather than an atomic histogram
+    */
+    bool deterministic = false;
+    /**
+    * If true, the messages within each bucket are combined into a single message when the index is built
+    */
+    bool combined = false;
+    /**
     * Size of currently allocated temp storage memory for cub
     */
     size_t d_CUB_temp_storage_bytes = 0;
@@ -93,7 +101,15 @@ class MessageBucket::CUDAModelHandler : public MessageSpecialisationHandler {
     */
     unsigned int *d_keys = nullptr, *d_vals = nullptr;
     /**
-    * Size currently allocated to d_keys, d_vals arrays
+    * Array used to store the original index of each message in bucket order, only allocated if combined
+    */
+    unsigned int *d_permutation = nullptr;
+    /**
+    * Array used to build the PBM of combined messages, only allocated if combined
+    */
+    unsigned int *d_combined_pbm = nullptr;
+    /**
+    * Size currently allocated to d_keys, d_vals (and d_permutation) arrays
     */
     size_t d_keys_vals_storage_bytes = 0;
     /**
@@ -127,6 +143,10 @@ struct MessageBucket::Data : public MessageBruteForce::Data {
     * Max must be set to the last valid key
     */
     IntT upperBound;
+    /**
+    * If true, the index is built with a stable sort, so the order of messages within a bucket is reproducible
+    */
+    bool deterministic;
     virtual ~Data() = default;
 
     std::unique_ptr<MessageSpecialisationHandler> getSpecialisationHander(CUDAMessage &owner) const override;
@@ -194,6 +214,32 @@ class MessageBucket::Description : public MessageBruteForce::Description {
     void setUpperBound(const IntT &key);
     void setBounds(const IntT &min, const IntT &max);
     /**
+    * Sets whether the message list's index is built deterministically
+    * By default, the order of messages within a bucket depends on the scheduling of atomic operations, so varies between runs
+    * When deterministic, messages are stably sorted, so they retain the order in which they were output within each bucket
+    * This makes floating point reductions over messages reproducible, at the cost of a radix sort per index build
+    * This includes the reductions performed when a variable is combined, see setCombine()
+    * @param deterministic True to build the index deterministically
+    * @note Defaults to false
+    */
+    void setDeterministic(const bool &deterministic);
+    /**
+    * Sets the operator used to combine the named variable, when multiple messages are output to the same bucket
+    * If any variable is combined, each non-empty bucket holds a single combined message when read, rather than every message output to it
+    * Variables without an operator take the value of the first message output to the bucket
+    * @param variable_name Name of the variable to be combined
+    * @param op The operator used to combine the variable
+    * @throws exception::InvalidMessageVar If a variable with the name does not exist within the message
+    * @throws exception::InvalidArgument If the variable's type is not int32_t, uint32_t, int64_t, uint64_t, float or double
+    * @note Unless the index is built deterministically, the order in which a bucket's messages are combined depends on the scheduling of atomic operations,
+    *       so floating point sums, and the values of variables without an operator, may vary between runs
+    * @note Messages are reduced when the index is built, not as they are output, so the message list still stores every message output,
+    *       memory remains O(messages) rather than O(buckets), only the work of message readers is reduced
+    * @see setDeterministic(const bool &)
+    * @see MessageCombine
+    */
+    void setCombine(const std::string &variable_name, const MessageCombine &op);
+    /**
     * Return the currently set (inclusive) lower bound, this is the first valid key
     */
     IntT getLowerBound() const;
@@ -201,6 +247,15 @@ class MessageBucket::Description : public MessageBruteForce::Description {
     * Return the currently set (inclusive) upper bound, this is the last valid key
     */
     IntT getUpperBound() const;
+    /**
+    * Return whether the message list's index is built deterministically
+    */
+    bool getDeterministic() const;
+    /**
+    * Return the operator used to combine the named variable
+    * @throws exception::InvalidMessageVar If a variable with the name does not exist within the message
+    */
+    MessageCombine getCombine(const std::string &variable_name) const;
 };
 
 }  // namespace flamegpu
@@ -0,0 +1,62 @@
+#ifndef INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEGRAPH_H_
+#define INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEGRAPH_H_
+
+#include "flamegpu/runtime/messaging/MessageArray.h"
+
+namespace flamegpu {
+
+/**
+ * Graph messaging functionality
+ *
+ * Each message is output by a vertex of a directed graph, like an array message the vertex is set as the message's index
+ * Agent functions access the messages output by the neighbours of a vertex, by iterating the vertex's edges
+ * The topology is held on the device in compressed sparse row (CSR) form, it is uploaded once and only edited vertices are re-uploaded
+ *
+ * Algorithm:
+ * Messages are sorted by vertex as with MessageArray, so the message of a vertex is found directly from its index
+ * The edges of a vertex are a contiguous range of the CSR edge list, each edge holding the index of the neighbouring vertex
+ */
+class MessageGraph {
+ public:
+    /**
+     * Common size type
+     */
+    typedef MessageNone::size_type size_type;
+
+    // Host
+    struct Data;        // Forward declare inner classes
+    class Description;  // Forward declare inner classes
+    class CUDAModelHandler;
+    class Topology;
+
+    // Device
+    class In;
+    class Out;
+
+    /**
+     * MetaData required by graph messages during message reads
+     */
+    struct MetaData {
+        /**
+         * Array metadata, the message list length is the vertex count
+         * This must be the first member, as it is read by MessageArray::Out
+         */
+        MessageArray::MetaData array;
+        /**
+         * Slot offset of each vertex's edges, vertex count + 1 elements
+         */
+        const unsigned int *offsets;
+        /**
+         * Number of edges leaving each vertex, vertex count elements
+         */
+        const unsigned int *degrees;
+        /**
+         * Destination vertex of each edge slot
+         */
+        const unsigned int *edges;
+    };
+};
+
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEGRAPH_H_
@@ -0,0 +1,279 @@
+#ifndef INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEGRAPH_MESSAGEGRAPHDEVICE_CUH_
+#define INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEGRAPH_MESSAGEGRAPHDEVICE_CUH_
+
+#include "flamegpu/runtime/messaging/MessageGraph.h"
+#include "flamegpu/runtime/messaging/MessageArray/MessageArrayDevice.cuh"
+#include "flamegpu/util/detail/CSRGraph.cuh"
+
+namespace flamegpu {
+
+/**
+ * This class is accessible via DeviceAPI.message_in if MessageGraph is specified in FLAMEGPU_AGENT_FUNCTION
+ * It gives access to functionality for reading the messages output by the neighbours of a vertex
+ */
+class MessageGraph::In {
+ public:
+    /**
+     * This class is created when a vertex is provided to MessageGraph::In::operator()(size_type)
+     * It provides iterator access to the messages output by the destination vertices of the vertex's edges
+     */
+    class Filter {
+     public:
+        /**
+         * Provides access to a specific message
+         * Returned by the iterator
+         * @see In::Filter::iterator
+         */
+        class Message {
+            /**
+             * Paired Filter class which created the iterator
+             */
+            const Filter &_parent;
+            /**
+             * Edge slot within the CSR edge list
+             */
+            unsigned int slot;
+
+         public:
+            /**
+             * Constructs a message and directly initialises all of it's member variables
+             * @note See member variable documentation for their purposes
+             */
+            __device__ Message(const Filter &parent, const unsigned int &_slot)
+                : _parent(parent)
+                , slot(_slot) { }
+            /**
+             * Equality operator
+             * Compares all internal member vars for equality
+             * @note Does not compare _parent
+             */
+            __device__ bool operator==(const Message &rhs) const { return slot == rhs.slot; }
+            /**
+             * Inequality operator
+             * Returns inverse of equality operator
+             * @see operator==(const Message&)
+             */
+            __device__ bool operator!=(const Message &rhs) const { return slot != rhs.slot; }
+            /**
+             * Updates the message to return variables from the next neighbour
+             * @return Returns itself
+             */
+            __device__ Message& operator++() { ++slot; return *this; }
+            /**
+             * Returns the neighbouring vertex which output the current message, this is also its index within the message list
+             */
+            __device__ size_type getIndex() const { return _parent.metadata->edges[slot]; }
+            /**
+             * Returns the value for the current message attached to the named variable
+             * @param variable_name Name of the variable
+             * @tparam T type of the variable
+             * @tparam N Length of variable name (this should be implicit if a string literal is passed to variable name)
+             * @return The specified variable, else 0x0 if an error occurs
+             */
+            template<typename T, unsigned int N>
+            __device__ T getVariable(const char(&variable_name)[N]) const;
+            /**
+             * Returns the specified variable array element from the current message attached to the named variable
+             * @param variable_name name used for accessing the variable, this value should be a string literal e.g. "foobar"
+             * @param index Index of the element within the variable array to return
+             * @tparam T Type of the message variable being accessed
+             * @tparam N The length of the array variable, as set within the model description hierarchy
+             * @tparam M Length of variable_name, this should always be implicit if passing a string literal
+             * @throws exception::DeviceError If name is not a valid variable within the agent (flamegpu must be built with SEATBELTS enabled for device error checking)
+             * @throws exception::DeviceError If T is not the type of variable 'name' within the message (flamegpu must be built with SEATBELTS enabled for device error checking)
+             * @throws exception::DeviceError If index is out of bounds for the variable array specified by name (flamegpu must be built with SEATBELTS enabled for device error checking)
+             */
+            template<typename T, MessageNone::size_type N, unsigned int M>
+            __device__ T getVariable(const char(&variable_name)[M], const unsigned int& index) const;
+        };
+        /**
+         * Stock iterator for iterating MessageGraph::In::Filter::Message objects
+         */
+        class iterator {
+            /**
+             * The message returned to the user
+             */
+            Message _message;
+
+         public:
+            /**
+             * Constructor
+             * This iterator is constructed by MessageGraph::In::Filter::begin()
+             * @see MessageGraph::In::Operator()(size_type)
+             */
+            __device__ iterator(const Filter &parent, const unsigned int &slot)
+                : _message(parent, slot) { }
+            /**
+             * Moves to the next neighbour's message
+             */
+            __device__ iterator& operator++() { ++_message;  return *this; }
+            /**
+             * Moves to the next neighbour's message
+             */
+            __device__ iterator operator++(int) {
+                iterator temp = *this;
+                ++*this;
+                return temp;
+            }
+            /**
+             * Equality operator
+             * Compares message
+             */
+            __device__ bool operator==(const iterator& rhs) const { return  _message == rhs._message; }
+            /**
+             * Inequality operator
+             * Compares message
+             */
+            __device__ bool operator!=(const iterator& rhs) const { return  _message != rhs._message; }
+            /**
+             * Dereferences the iterator to return the message object, for accessing variables
+             */
+            __device__ Message& operator*() { return _message; }
+            /**
+             * Dereferences the iterator to return the message object, for accessing variables
+             */
+            __device__ Message* operator->() { return &_message; }
+        };
+        /**
+         * Constructor, takes the search parameters requried
+         * @param _metadata Pointer to message list metadata
+         * @param _combined_hash agentfn+message hash for accessing message data
+         * @param vertex The vertex whose neighbours' messages are iterated
+         */
+        __device__ Filter(const MetaData *_metadata, const detail::curve::Curve::NamespaceHash &_combined_hash, const size_type &vertex)
+            : metadata(_metadata)
+            , combined_hash(_combined_hash) {
+            util::detail::csr::adjacency(_metadata->offsets, _metadata->degrees, vertex, first, last);
+        }
+        /**
+         * Returns an iterator to the first neighbour's message
+         */
+        inline __device__ iterator begin(void) const { return iterator(*this, first); }
+        /**
+         * Returns an iterator to the position beyond the last neighbour's message
+         */
+        inline __device__ iterator end(void) const { return iterator(*this, last); }
+        /**
+         * Returns the number of neighbours, which is the number of edges leaving the vertex
+         */
+        inline __device__ size_type size(void) const { return last - first; }
+
+     private:
+        /**
+         * Range of edge slots [first, last) which hold the vertex's edges
+         */
+        unsigned int first, last;
+        /**
+         * Pointer to message list metadata, e.g. CSR topology
+         */
+        const MetaData *metadata;
+        /**
+         * CURVE hash for accessing message data
+         * agent function hash + message hash
+         */
+        detail::curve::Curve::NamespaceHash combined_hash;
+    };
+
+    /**
+     * Constructer
+     * Initialises member variables
+     * @param agentfn_hash Added to message_hash to produce combined_hash
+     * @param message_hash Added to agentfn_hash to produce combined_hash
+     * @param _metadata Reinterpreted as type MessageGraph::MetaData
+     */
+    __device__ In(detail::curve::Curve::NamespaceHash agentfn_hash, detail::curve::Curve::NamespaceHash message_hash, const void *_metadata)
+        : combined_hash(agentfn_hash + message_hash)
+        , metadata(reinterpret_cast<const MetaData*>(_metadata))
+    { }
+    /**
+     * Returns a Filter object which provides access to the messages output by the neighbours of a vertex
+     * @param vertex The vertex whose edges are walked
+     * @throws exception::DeviceError If vertex is out of bounds (flamegpu must be built with SEATBELTS enabled for device error checking)
+     */
+    inline __device__ Filter operator() (const size_type &vertex) const {
+#if !defined(SEATBELTS) || SEATBELTS
+        if (vertex >= metadata->array.length) {
+            DTHROW("Graph message vertex %u is out of bounds [0, %u).\n", vertex, metadata->array.length);
+            // Vertex 0 is used in place of the invalid vertex
+            return Filter(metadata, combined_hash, 0);
+        }
+#endif
+        return Filter(metadata, combined_hash, vertex);
+    }
+    /**
+     * Returns the number of edges leaving a vertex
+     * @param vertex The vertex to query
+     */
+    __forceinline__ __device__ size_type degree(const size_type &vertex) const {
+        return metadata->degrees[vertex];
+    }
+    /**
+     * Returns the number of vertices in the graph, as defined in the model description
+     */
+    __forceinline__ __device__ size_type vertexCount() const {
+        return metadata->array.length;
+    }
+
+ private:
+    /**
+     * CURVE hash for accessing message data
+     * agentfn_hash + message_hash
+     */
+    detail::curve::Curve::NamespaceHash combined_hash;
+    /**
+     * Device pointer to metadata required for accessing data structure
+     * e.g. CSR topology
+     */
+    const MetaData *metadata;
+};
+
+/**
+ * This class is accessible via DeviceAPI.message_out if MessageGraph is specified in FLAMEGPU_AGENT_FUNCTION
+ * It gives access to functionality for outputting graph messages
+ * The vertex of the message is set with setIndex()
+ */
+class MessageGraph::Out : public MessageArray::Out {
+ public:
+    /**
+     * Constructer
+     * Initialises member variables
+     * @param agentfn_hash Added to message_hash to produce combined_hash
+     * @param message_hash Added to agentfn_hash to produce combined_hash
+     * @param _metadata Message specialisation specific metadata struct (of type MessageGraph::MetaData)
+     * @param scan_flag_messageOutput Scan flag array for optional message output
+     * @param message_output_max The maximum number of messages each agent may output
+     */
+    __device__ Out(detail::curve::Curve::NamespaceHash agentfn_hash, detail::curve::Curve::NamespaceHash message_hash, const void *_metadata, unsigned int *scan_flag_messageOutput, const unsigned int message_output_max)
+        : MessageArray::Out(agentfn_hash, message_hash, _metadata, scan_flag_messageOutput, message_output_max)
+    { }
+};
+
+template<typename T, unsigned int N>
+__device__ T MessageGraph::In::Filter::Message::getVariable(const char(&variable_name)[N]) const {
+#if !defined(SEATBELTS) || SEATBELTS
+    // Ensure that the message is within bounds.
+    if (slot >= _parent.last) {
+        DTHROW("Invalid Graph message, unable to get variable '%s'.\n", variable_name);
+        return static_cast<T>(0);
+    }
+#endif
+    // get the value from curve using the stored hashes and message index.
+    return detail::curve::Curve::getMessageVariable<T>(variable_name, this->_parent.combined_hash, getIndex());
+}
+template<typename T, MessageNone::size_type N, unsigned int M> __device__
+T MessageGraph::In::Filter::Message::getVariable(const char(&variable_name)[M], const unsigned int& array_index) const {
+#if !defined(SEATBELTS) || SEATBELTS
+    // Ensure that the message is within bounds.
+    if (slot >= _parent.last) {
+        DTHROW("Invalid Graph message, unable to get variable '%s'.\n", variable_name);
+        return static_cast<T>(0);
+    }
+#endif
+    // get the value from curve using the stored hashes and message index.
+    T value = detail::curve::Curve::getMessageArrayVariable<T, N>(variable_name, this->_parent.combined_hash, getIndex(), array_index);
+    return value;
+}
+
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEGRAPH_MESSAGEGRAPHDEVICE_CUH_
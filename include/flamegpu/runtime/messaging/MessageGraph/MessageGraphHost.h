@@ -0,0 +1,266 @@
+#ifndef INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEGRAPH_MESSAGEGRAPHHOST_H_
+#define INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEGRAPH_MESSAGEGRAPHHOST_H_
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "flamegpu/gpu/CUDAMessage.h"
+#include "flamegpu/runtime/messaging/MessageGraph.h"
+#include "flamegpu/runtime/messaging/MessageArray/MessageArrayHost.h"
+#include "flamegpu/util/detail/CSRGraph.cuh"
+
+namespace flamegpu {
+
+/**
+ * CUDA host side handler of graph messages
+ * Messages are sorted by vertex by an owned MessageArray handler, this holds the CSR topology on the device
+ */
+class MessageGraph::CUDAModelHandler : public MessageSpecialisationHandler {
+ public:
+    /**
+     * Constructor
+     * Copies the topology from the model description
+     * @param a Parent CUDAMessage, used to access message settings, data ptrs etc
+     */
+    explicit CUDAModelHandler(CUDAMessage &a);
+    /**
+     * Destructor.
+     * Should free any local host memory (device memory cannot be freed in destructors)
+     */
+    ~CUDAModelHandler() override { }
+    /**
+     * Allocates memory for the constructed index.
+     * Allocates message buffers, and memsets data to 0
+     * @param scatter Scatter instance and scan arrays to be used (CUDASimulation::singletons->scatter)
+     * @param streamId The stream index to use for accessing stream specific resources such as scan compaction arrays and buffers
+     */
+    void init(CUDAScatter &scatter, const unsigned int &streamId) override;
+    /**
+     * Sort messages according to vertex
+     * @param scatter Scatter instance and scan arrays to be used (CUDASimulation::singletons->scatter)
+     * @param streamId The stream index to use for accessing stream specific resources such as scan compaction arrays and buffers
+     * @param stream CUDA stream to be used for async CUDA operations
+     */
+    void buildIndex(CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream) override;
+    /**
+     * Allocates memory for the metadata and topology, and uploads the full topology
+     */
+    void allocateMetaDataDevicePtr() override;
+    /**
+     * Releases memory for the metadata and topology
+     */
+    void freeMetaDataDevicePtr() override;
+    /**
+     * Returns a pointer to the metadata struct, this is required for reading the message data
+     */
+    const void *getMetaDataDevicePtr() const override { return d_data; }
+    /**
+     * Returns the host copy of the topology, edits are not visible to the device until uploadTopology() is called
+     */
+    util::detail::CSRGraph &getTopology() { return topology; }
+    /**
+     * Uploads the parts of the topology which have been edited since the previous upload
+     * If the layout of the topology has changed, the full topology is uploaded
+     * @note Does nothing if device memory has not yet been allocated, the full topology is uploaded on allocation
+     */
+    void uploadTopology();
+
+ private:
+    /**
+     * Sorts messages by vertex
+     */
+    MessageArray::CUDAModelHandler array;
+    /**
+     * Host copy of the topology
+     */
+    util::detail::CSRGraph topology;
+    /**
+     * Number of edge slots currently allocated on the device
+     */
+    size_t d_edges_len = 0;
+    /**
+     * Host copy of metadata struct
+     */
+    MetaData hd_data;
+    /**
+     * Pointer to device copy of metadata struct
+     */
+    MetaData *d_data = nullptr;
+};
+
+/**
+ * Host handle for editing the topology of a graph message list during a simulation
+ * Edits are uploaded to the device at the end of each call, only the vertices edited by the call are uploaded
+ * @see HostAPI::graph(const std::string &)
+ */
+class MessageGraph::Topology {
+ public:
+    /**
+     * Constructor, only to be called by HostAPI
+     * @param _handler Handler of the graph message list
+     */
+    explicit Topology(CUDAModelHandler &_handler);
+    /**
+     * @return The number of vertices in the graph
+     */
+    size_type getVertexCount() const;
+    /**
+     * @return The total number of edges in the graph
+     */
+    size_type getEdgeCount() const;
+    /**
+     * @param vertex The vertex to query
+     * @return The number of edges leaving the vertex
+     * @throws exception::OutOfBoundsException If vertex is not a valid vertex
+     */
+    size_type getDegree(const size_type &vertex) const;
+    /**
+     * @param vertex The vertex to query
+     * @return The destination vertices of the edges leaving the vertex, in the order they are iterated on the device
+     * @throws exception::OutOfBoundsException If vertex is not a valid vertex
+     */
+    std::vector<size_type> getNeighbours(const size_type &vertex) const;
+    /**
+     * Adds a directed edge, so that source reads the message output by destination
+     * @param source The vertex which the edge leaves
+     * @param destination The vertex which the edge enters
+     * @return True if the edge was added, false if it already existed
+     * @throws exception::OutOfBoundsException If either vertex is not a valid vertex
+     */
+    bool addEdge(const size_type &source, const size_type &destination);
+    /**
+     * Adds a batch of directed edges, the device topology is updated once for the whole batch
+     * @param sources The vertex which each edge leaves
+     * @param destinations The vertex which each edge enters
+     * @return The number of edges added, edges which already existed are skipped
+     * @throws exception::InvalidArgument If sources and destinations differ in length
+     * @throws exception::OutOfBoundsException If any vertex is not a valid vertex, no edges are added
+     */
+    size_type addEdges(const std::vector<size_type> &sources, const std::vector<size_type> &destinations);
+    /**
+     * Removes a directed edge
+     * @param source The vertex which the edge leaves
+     * @param destination The vertex which the edge enters
+     * @return True if the edge was removed, false if it did not exist
+     * @throws exception::OutOfBoundsException If either vertex is not a valid vertex
+     */
+    bool removeEdge(const size_type &source, const size_type &destination);
+    /**
+     * Removes a batch of directed edges, the device topology is updated once for the whole batch
+     * @param sources The vertex which each edge leaves
+     * @param destinations The vertex which each edge enters
+     * @return The number of edges removed, edges which did not exist are skipped
+     * @throws exception::InvalidArgument If sources and destinations differ in length
+     * @throws exception::OutOfBoundsException If any vertex is not a valid vertex, no edges are removed
+     */
+    size_type removeEdges(const std::vector<size_type> &sources, const std::vector<size_type> &destinations);
+
+ private:
+    /**
+     * Throws if any vertex is not a valid vertex, or the lists differ in length
+     */
+    void validate(const std::vector<size_type> &sources, const std::vector<size_type> &destinations) const;
+    /**
+     * Handler of the graph message list
+     */
+    CUDAModelHandler &handler;
+};
+
+/**
+ * Internal data representation of Graph messages within model description hierarchy
+ * The message list length is the vertex count
+ * @see Description
+ */
+struct MessageGraph::Data : public MessageArray::Data {
+    friend class ModelDescription;
+    friend struct ModelData;
+    /**
+     * The initial topology of the graph
+     */
+    util::detail::CSRGraph topology;
+    virtual ~Data() = default;
+
+    std::unique_ptr<MessageSpecialisationHandler> getSpecialisationHander(CUDAMessage &owner) const override;
+
+    /**
+     * Used internally to validate that the corresponding Message type is attached via the agent function shim.
+     * @return The std::type_index of the Message type which must be used.
+     */
+    std::type_index getType() const override;
+
+ protected:
+    Data *clone(const std::shared_ptr<const ModelData> &newParent) override;
+    /**
+     * Copy constructor
+     * This is unsafe, should only be used internally, use clone() instead
+     */
+    Data(const std::shared_ptr<const ModelData> &, const Data &other);
+    /**
+     * Normal constructor, only to be called by ModelDescription
+     */
+    Data(const std::shared_ptr<const ModelData> &, const std::string &message_name);
+};
+
+/**
+ * User accessible interface to Graph messages within mode description hierarchy
+ * @see Data
+ */
+class MessageGraph::Description : public MessageBruteForce::Description {
+    /**
+     * Data store class for this description, constructs instances of this class
+     */
+    friend struct Data;
+
+ protected:
+    /**
+     * Constructors
+     */
+    Description(const std::shared_ptr<const ModelData> &_model, Data *const data);
+    /**
+     * Default copy constructor, not implemented
+     */
+    Description(const Description &other_message) = delete;
+    /**
+     * Default move constructor, not implemented
+     */
+    Description(Description &&other_message) noexcept = delete;
+    /**
+     * Default copy assignment, not implemented
+     */
+    Description& operator=(const Description &other_message) = delete;
+    /**
+     * Default move assignment, not implemented
+     */
+    Description& operator=(Description &&other_message) noexcept = delete;
+
+ public:
+    /**
+     * Sets the number of vertices in the graph, this removes all edges
+     * @param count The number of vertices
+     * @throws exception::InvalidArgument If count is 0
+     */
+    void setVertexCount(const size_type &count);
+    /**
+     * Adds a directed edge to the initial topology, so that source reads the message output by destination
+     * Undirected graphs require an edge in each direction
+     * @param source The vertex which the edge leaves
+     * @param destination The vertex which the edge enters
+     * @return True if the edge was added, false if it already existed
+     * @throws exception::OutOfBoundsException If either vertex is not less than the vertex count
+     */
+    bool addEdge(const size_type &source, const size_type &destination);
+
+    size_type getVertexCount() const;
+    size_type getEdgeCount() const;
+    /**
+     * @param vertex The vertex to query
+     * @return The destination vertices of the edges leaving the vertex in the initial topology
+     * @throws exception::OutOfBoundsException If vertex is not less than the vertex count
+     */
+    std::vector<size_type> getNeighbours(const size_type &vertex) const;
+};
+
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEGRAPH_MESSAGEGRAPHHOST_H_
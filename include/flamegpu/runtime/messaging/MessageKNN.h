@@ -0,0 +1,61 @@
+#ifndef INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEKNN_H_
+#define INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEKNN_H_
+
+#include "flamegpu/runtime/messaging/MessageSpatial3D.h"
+
+namespace flamegpu {
+
+/**
+ * 3D k-nearest-neighbour messaging functionality
+ *
+ * Messages are partitioned into the same grid of bins as MessageSpatial3D, the radius sets the width of the bins
+ * When accessing messages, a search origin is specified
+ * The k nearest messages within the maximum radius of the search origin are returned, in order of distance
+ * Bins are searched in rings of increasing distance about the search origin's bin, until no unsearched bin can hold a nearer message
+ * Therefore the maximum radius may be much larger than the bin width, without visiting distant bins in dense regions
+ * Ties in distance are broken by message location, so the selected messages do not depend on the order of the message list
+ * Periodic environment bounds are not supported.
+ */
+class MessageKNN {
+    /**
+     * Common size type
+     */
+    typedef MessageNone::size_type size_type;
+
+ public:
+    // Host
+    struct Data;        // Forward declare inner classes
+    class Description;  // Forward declare inner classes
+    class CUDAModelHandler;
+    // Device
+    class In;
+    class Out;
+
+    /**
+     * The maximum number of neighbours which may be returned by a search
+     * The neighbours of each search are held in local memory
+     */
+    static constexpr unsigned int MAX_K = 32;
+
+    /**
+     * MetaData required by k-nearest-neighbour messages during message reads
+     */
+    struct MetaData {
+        /**
+         * Spatial partitioning metadata, this is maintained by the underlying spatial index
+         */
+        MessageSpatial3D::MetaData spatial;
+        /**
+         * The maximum number of neighbours returned by a search
+         */
+        unsigned int k;
+        /**
+         * The maximum distance of a neighbour from the search origin
+         */
+        float maxRadius;
+    };
+};
+
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEKNN_H_
@@ -0,0 +1,393 @@
+#ifndef INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEKNN_MESSAGEKNNDEVICE_CUH_
+#define INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEKNN_MESSAGEKNNDEVICE_CUH_
+
+#include "flamegpu/runtime/messaging/MessageKNN.h"
+#include "flamegpu/runtime/messaging/MessageSpatial3D/MessageSpatial3DDevice.cuh"
+#include "flamegpu/util/detail/NearestNeighbours.cuh"
+
+namespace flamegpu {
+
+/**
+ * This class is accessible via DeviceAPI.message_in if MessageKNN is specified in FLAMEGPU_AGENT_FUNCTION
+ * It gives access to functionality for reading the nearest messages to a search origin
+ */
+class MessageKNN::In {
+ public:
+    /**
+     * This class is created when a search origin is provided to MessageKNN::In::operator()(float, float, float)
+     * The nearest messages are found when the Filter is constructed, iteration visits them in order of distance
+     */
+    class Filter {
+     public:
+        /**
+         * Provides access to a specific message
+         * Returned by the iterator
+         * @see In::Filter::iterator
+         */
+        class Message {
+            /**
+             * Paired Filter class which created the iterator
+             */
+            const Filter &_parent;
+            /**
+             * Position of the message within the Filter's list of neighbours
+             */
+            unsigned int position;
+
+         public:
+            /**
+             * Constructs a message and directly initialises all of it's member variables
+             * @note See member variable documentation for their purposes
+             */
+            __device__ Message(const Filter &parent, const unsigned int &_position)
+                : _parent(parent)
+                , position(_position) { }
+            /**
+             * Equality operator
+             * Compares all internal member vars for equality
+             * @note Does not compare _parent
+             */
+            __device__ bool operator==(const Message &rhs) const { return position == rhs.position; }
+            /**
+             * Inequality operator
+             * Returns inverse of equality operator
+             * @see operator==(const Message&)
+             */
+            __device__ bool operator!=(const Message &rhs) const { return position != rhs.position; }
+            /**
+             * Updates the message to return variables from the next nearest message
+             * @return Returns itself
+             */
+            __device__ Message& operator++() { ++position; return *this; }
+            /**
+             * Returns the index of the current message within the message list
+             * If the message list is a view over agent variables, this is the index of the agent which the message represents
+             */
+            __device__ unsigned int getIndex() const { return _parent.neighbours[position].index; }
+            /**
+             * Returns the value for the current message attached to the named variable
+             * @param variable_name Name of the variable
+             * @tparam T type of the variable
+             * @tparam N Length of variable name (this should be implicit if a string literal is passed to variable name)
+             * @return The specified variable, else 0x0 if an error occurs
+             */
+            template<typename T, size_type N>
+            __device__ T getVariable(const char(&variable_name)[N]) const;
+            /**
+             * Returns the specified variable array element from the current message attached to the named variable
+             * @param variable_name name used for accessing the variable, this value should be a string literal e.g. "foobar"
+             * @param index Index of the element within the variable array to return
+             * @tparam T Type of the message variable being accessed
+             * @tparam N The length of the array variable, as set within the model description hierarchy
+             * @tparam M Length of variable_name, this should always be implicit if passing a string literal
+             * @throws exception::DeviceError If name is not a valid variable within the agent (flamegpu must be built with SEATBELTS enabled for device error checking)
+             * @throws exception::DeviceError If T is not the type of variable 'name' within the message (flamegpu must be built with SEATBELTS enabled for device error checking)
+             * @throws exception::DeviceError If index is out of bounds for the variable array specified by name (flamegpu must be built with SEATBELTS enabled for device error checking)
+             */
+            template<typename T, MessageNone::size_type N, unsigned int M> __device__
+            T getVariable(const char(&variable_name)[M], const unsigned int& index) const;
+            /**
+             * Returns the distance of the current message's location from the search origin
+             */
+            __device__ float getDistance() const { return sqrtf(_parent.neighbours[position].dist2); }
+            /**
+             * Returns the x displacement of the current message's location from the search origin
+             */
+            __device__ float getRelativeX() const { return _parent.neighbours[position].x - _parent.loc[0]; }
+            /**
+             * Returns the y displacement of the current message's location from the search origin
+             */
+            __device__ float getRelativeY() const { return _parent.neighbours[position].y - _parent.loc[1]; }
+            /**
+             * Returns the z displacement of the current message's location from the search origin
+             */
+            __device__ float getRelativeZ() const { return _parent.neighbours[position].z - _parent.loc[2]; }
+        };
+        /**
+         * Stock iterator for iterating MessageKNN::In::Filter::Message objects
+         */
+        class iterator {
+            /**
+             * The message returned to the user
+             */
+            Message _message;
+
+         public:
+            /**
+             * Constructor
+             * This iterator is constructed by MessageKNN::In::Filter::begin()
+             * @see MessageKNN::In::Operator()(float, float, float)
+             */
+            __device__ iterator(const Filter &parent, const unsigned int &position)
+                : _message(parent, position) { }
+            /**
+             * Moves to the next nearest message
+             */
+            __device__ iterator& operator++() { ++_message;  return *this; }
+            /**
+             * Moves to the next nearest message
+             */
+            __device__ iterator operator++(int) {
+                iterator temp = *this;
+                ++*this;
+                return temp;
+            }
+            /**
+             * Equality operator
+             * Compares message
+             */
+            __device__ bool operator==(const iterator& rhs) const { return  _message == rhs._message; }
+            /**
+             * Inequality operator
+             * Compares message
+             */
+            __device__ bool operator!=(const iterator& rhs) const { return  _message != rhs._message; }
+            /**
+             * Dereferences the iterator to return the message object, for accessing variables
+             */
+            __device__ Message& operator*() { return _message; }
+            /**
+             * Dereferences the iterator to return the message object, for accessing variables
+             */
+            __device__ Message* operator->() { return &_message; }
+        };
+        /**
+         * Constructor, takes the search parameters requried
+         * Searches the message list for the nearest messages to the search origin
+         * @param _metadata Pointer to message list metadata
+         * @param combined_hash agentfn+message hash for accessing message data
+         * @param x Search origin x coord
+         * @param y Search origin y coord
+         * @param z Search origin z coord
+         */
+        __device__ Filter(const MetaData *_metadata, const detail::curve::Curve::NamespaceHash &combined_hash, const float &x, const float &y, const float &z);
+        /**
+         * Returns an iterator to the nearest message
+         */
+        inline __device__ iterator begin(void) const { return iterator(*this, 0); }
+        /**
+         * Returns an iterator to the position beyond the furthest returned message
+         */
+        inline __device__ iterator end(void) const { return iterator(*this, count); }
+        /**
+         * Returns the number of messages found by the search
+         * This is less than k, if fewer than k messages lie within the maximum radius of the search origin
+         */
+        inline __device__ unsigned int size(void) const { return count; }
+
+     private:
+        /**
+         * Tests each message within a strip of bins, and inserts those within the maximum radius into the list of neighbours
+         * @param begin_x First bin of the strip on the x axis
+         * @param end_x Last bin of the strip on the x axis (inclusive)
+         * @param y Bin of the strip on the y axis
+         * @param z Bin of the strip on the z axis
+         */
+        __device__ void searchStrip(int begin_x, int end_x, const int &y, const int &z);
+        /**
+         * Tests each message within a bin range of the PBM
+         * @param begin_hash First bin to test
+         * @param end_hash Last bin to test (inclusive)
+         */
+        __device__ void searchBins(const unsigned int &begin_hash, const unsigned int &end_hash);
+        /**
+         * The nearest messages found, sorted by distance
+         */
+        util::detail::knn::Neighbour neighbours[MAX_K];
+        /**
+         * The number of messages held by neighbours
+         */
+        unsigned int count;
+        /**
+         * Search origin
+         */
+        float loc[3];
+        /**
+         * Pointer to message list metadata, e.g. environment bounds, k, PBM location
+         */
+        const MetaData *metadata;
+        /**
+         * CURVE hash for accessing message data
+         * agent function hash + message hash
+         */
+        detail::curve::Curve::NamespaceHash combined_hash;
+    };
+
+    /**
+     * Constructer
+     * Initialises member variables
+     * @param agentfn_hash Added to message_hash to produce combined_hash
+     * @param message_hash Added to agentfn_hash to produce combined_hash
+     * @param _metadata Reinterpreted as type MessageKNN::MetaData
+     */
+    __device__ In(detail::curve::Curve::NamespaceHash agentfn_hash, detail::curve::Curve::NamespaceHash message_hash, const void *_metadata)
+        : combined_hash(agentfn_hash + message_hash)
+        , metadata(reinterpret_cast<const MetaData*>(_metadata))
+    { }
+    /**
+     * Returns a Filter object which provides access to the k nearest messages to the search origin
+     *
+     * @param x Search origin x coord
+     * @param y Search origin y coord
+     * @param z Search origin z coord
+     */
+    inline __device__ Filter operator() (const float &x, const float &y, const float &z) const {
+        return Filter(metadata, combined_hash, x, y, z);
+    }
+    /**
+     * Returns the maximum number of neighbours returned by a search, as defined in the model description
+     */
+    __forceinline__ __device__ unsigned int k() const {
+        return metadata->k;
+    }
+    /**
+     * Returns the maximum distance of a neighbour from the search origin, as defined in the model description
+     */
+    __forceinline__ __device__ float maxRadius() const {
+        return metadata->maxRadius;
+    }
+
+ private:
+    /**
+     * CURVE hash for accessing message data
+     * agentfn_hash + message_hash
+     */
+    detail::curve::Curve::NamespaceHash combined_hash;
+    /**
+     * Device pointer to metadata required for accessing data structure
+     * e.g. PBM, environment bounds, k
+     */
+    const MetaData *metadata;
+};
+
+/**
+ * This class is accessible via DeviceAPI.message_out if MessageKNN is specified in FLAMEGPU_AGENT_FUNCTION
+ * It gives access to functionality for outputting k-nearest-neighbour messages
+ */
+class MessageKNN::Out : public MessageSpatial3D::Out {
+ public:
+    /**
+     * Constructer
+     * Initialises member variables
+     * @param agentfn_hash Added to message_hash to produce combined_hash
+     * @param message_hash Added to agentfn_hash to produce combined_hash
+     * @param scan_flag_messageOutput Scan flag array for optional message output
+     * @param message_output_max The maximum number of messages each agent may output
+     */
+    __device__ Out(detail::curve::Curve::NamespaceHash agentfn_hash, detail::curve::Curve::NamespaceHash message_hash, const void *, unsigned int *scan_flag_messageOutput, const unsigned int message_output_max)
+        : MessageSpatial3D::Out(agentfn_hash, message_hash, nullptr, scan_flag_messageOutput, message_output_max)
+    { }
+};
+
+template<typename T, unsigned int N>
+__device__ T MessageKNN::In::Filter::Message::getVariable(const char(&variable_name)[N]) const {
+#if !defined(SEATBELTS) || SEATBELTS
+    // Ensure that the message is within bounds.
+    if (position >= _parent.count) {
+        DTHROW("MessageKNN index exceeds the number of neighbours found, unable to get variable '%s'.\n", variable_name);
+        return static_cast<T>(0);
+    }
+#endif
+    // get the value from curve using the stored hashes and message index.
+    T value = detail::curve::Curve::getMessageVariable<T>(variable_name, this->_parent.combined_hash, getIndex());
+    return value;
+}
+template<typename T, MessageNone::size_type N, unsigned int M> __device__
+T MessageKNN::In::Filter::Message::getVariable(const char(&variable_name)[M], const unsigned int& array_index) const {
+#if !defined(SEATBELTS) || SEATBELTS
+    // Ensure that the message is within bounds.
+    if (position >= _parent.count) {
+        DTHROW("MessageKNN index exceeds the number of neighbours found, unable to get variable '%s'.\n", variable_name);
+        return {};
+    }
+#endif
+    // get the value from curve using the stored hashes and message index.
+    T value = detail::curve::Curve::getMessageArrayVariable<T, N>(variable_name, this->_parent.combined_hash, getIndex(), array_index);
+    return value;
+}
+
+__device__ inline MessageKNN::In::Filter::Filter(const MetaData* _metadata, const detail::curve::Curve::NamespaceHash &_combined_hash, const float& x, const float& y, const float& z)
+    : count(0)
+    , metadata(_metadata)
+    , combined_hash(_combined_hash) {
+    loc[0] = x;
+    loc[1] = y;
+    loc[2] = z;
+    const MessageSpatial3D::MetaData *md = &_metadata->spatial;
+    const MessageSpatial3D::GridPos3D cell = getGridPosition3D(md, x, y, z);
+    const int origin[3] = { cell.x, cell.y, cell.z };
+    // The nearest point of ring r to the search origin is at least (r-1) bin widths beyond the faces of the origin's bin
+    float min_width = md->environmentWidth[0] / md->gridDim[0];
+    float margin = md->environmentWidth[0];
+    int max_ring = 0;
+    for (int axis = 0; axis < 3; ++axis) {
+        const float width = md->environmentWidth[axis] / md->gridDim[axis];
+        const float bin_min = md->min[axis] + origin[axis] * width;
+        min_width = fminf(min_width, width);
+        // Origins beyond the environment bounds are clamped to the edge bin, so the margin is clamped to 0
+        margin = fminf(margin, fmaxf(0.0f, fminf(loc[axis] - bin_min, bin_min + width - loc[axis])));
+        max_ring = max(max_ring, max(origin[axis], static_cast<int>(md->gridDim[axis]) - 1 - origin[axis]));
+    }
+    const float max_dist2 = _metadata->maxRadius * _metadata->maxRadius;
+    for (int ring = 0; ring <= max_ring; ++ring) {
+        if (ring > 0) {
+            const float reach = (ring - 1) * min_width + margin;
+            // No bin of this ring, or those beyond it, can contain a nearer message
+            if (reach * reach > max_dist2 || (count == _metadata->k && reach * reach > neighbours[count - 1].dist2))
+                break;
+        }
+        for (int dz = -ring; dz <= ring; ++dz) {
+            const int z_bin = origin[2] + dz;
+            if (z_bin < 0 || z_bin >= static_cast<int>(md->gridDim[2]))
+                continue;
+            for (int dy = -ring; dy <= ring; ++dy) {
+                const int y_bin = origin[1] + dy;
+                if (y_bin < 0 || y_bin >= static_cast<int>(md->gridDim[1]))
+                    continue;
+                if (dz == -ring || dz == ring || dy == -ring || dy == ring) {
+                    // Face of the ring's shell, the full strip of bins is searched
+                    searchStrip(origin[0] - ring, origin[0] + ring, y_bin, z_bin);
+                } else {
+                    // Interior of the ring's shell, only the bins at either end of the strip are searched
+                    searchStrip(origin[0] - ring, origin[0] - ring, y_bin, z_bin);
+                    searchStrip(origin[0] + ring, origin[0] + ring, y_bin, z_bin);
+                }
+            }
+        }
+    }
+}
+__device__ inline void MessageKNN::In::Filter::searchStrip(int begin_x, int end_x, const int &y, const int &z) {
+    const MessageSpatial3D::MetaData *md = &metadata->spatial;
+    begin_x = max(begin_x, 0);
+    end_x = min(end_x, static_cast<int>(md->gridDim[0]) - 1);
+    if (begin_x > end_x)
+        return;
+    if (md->mortonOrder) {
+        // Morton ordered bins are not contiguous along a strip
+        for (int x_bin = begin_x; x_bin <= end_x; ++x_bin) {
+            const unsigned int hash = getHash3D(md, { x_bin, y, z });
+            searchBins(hash, hash);
+        }
+    } else {
+        searchBins(getHash3D(md, { begin_x, y, z }), getHash3D(md, { end_x, y, z }));
+    }
+}
+__device__ inline void MessageKNN::In::Filter::searchBins(const unsigned int &begin_hash, const unsigned int &end_hash) {
+    const MessageSpatial3D::MetaData *md = &metadata->spatial;
+    const unsigned int begin = md->PBM[begin_hash];
+    const unsigned int end = md->PBM[end_hash + 1];
+    for (unsigned int i = begin; i < end; ++i) {
+        const unsigned int index = md->permutation ? md->permutation[i] : i;
+        const float mx = detail::curve::Curve::getMessageVariable<float>("x", combined_hash, index);
+        const float my = detail::curve::Curve::getMessageVariable<float>("y", combined_hash, index);
+        const float mz = detail::curve::Curve::getMessageVariable<float>("z", combined_hash, index);
+        const float dist2 = util::detail::knn::distance2(mx, my, mz, loc[0], loc[1], loc[2]);
+        if (dist2 <= metadata->maxRadius * metadata->maxRadius) {
+            util::detail::knn::insert(neighbours, count, metadata->k, { dist2, mx, my, mz, index });
+        }
+    }
+}
+
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEKNN_MESSAGEKNNDEVICE_CUH_
@@ -0,0 +1,177 @@
+#ifndef INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEKNN_MESSAGEKNNHOST_H_
+#define INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEKNN_MESSAGEKNNHOST_H_
+
+#include <memory>
+#include <string>
+
+#include "flamegpu/gpu/CUDAMessage.h"
+#include "flamegpu/util/nvtx.h"
+#include "flamegpu/runtime/messaging/MessageKNN.h"
+#include "flamegpu/runtime/messaging/MessageSpatial3D/MessageSpatial3DHost.h"
+
+namespace flamegpu {
+
+/**
+ * CUDA host side handler of k-nearest-neighbour messages
+ * The spatial index is built by an owned MessageSpatial3D handler, this extends its metadata with the search settings
+ */
+class MessageKNN::CUDAModelHandler : public MessageSpecialisationHandler {
+ public:
+    /**
+     * Constructor
+     *
+     * Initialises metadata
+     *
+     * @param a Parent CUDAMessage, used to access message settings, data ptrs etc
+     */
+    explicit CUDAModelHandler(CUDAMessage& a);
+    /**
+     * Destructor
+     * Frees all alocated memory
+     */
+    ~CUDAModelHandler() override { }
+    /**
+     * Allocates memory for the constructed index.
+     * Sets data asthough message list is empty
+     * @param scatter Scatter instance and scan arrays to be used (CUDASimulation::singletons->scatter)
+     * @param streamId Index of stream specific structures used
+     */
+    void init(CUDAScatter &scatter, const unsigned int &streamId) override;
+    /**
+     * Reconstructs the partition boundary matrix
+     * This should be called before reading newly output messages
+     * @param scatter Scatter instance and scan arrays to be used (CUDASimulation::singletons->scatter)
+     * @param streamId The stream index to use for accessing stream specific resources such as scan compaction arrays and buffers
+     * @param stream CUDA stream to be used for async CUDA operations
+     */
+    void buildIndex(CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream) override;
+    /**
+     * Allocates memory for the constructed index.
+     * The memory allocation is checked by build index.
+     */
+    void allocateMetaDataDevicePtr() override;
+    /**
+     * Releases memory for the constructed index.
+     */
+    void freeMetaDataDevicePtr() override;
+    /**
+     * Returns a pointer to the metadata struct, this is required for reading the message data
+     */
+    const void *getMetaDataDevicePtr() const override { return d_data; }
+
+ private:
+    /**
+     * Copies the spatial index's device metadata into the device metadata struct
+     * This must follow any operation which may change the spatial index's metadata
+     */
+    void updateMetaData();
+    /**
+     * Builds and owns the spatial index
+     */
+    MessageSpatial3D::CUDAModelHandler spatial;
+    /**
+     * Host copy of metadata struct
+     * The spatial member is not maintained on the host
+     */
+    MetaData hd_data;
+    /**
+     * Pointer to device copy of metadata struct
+     */
+    MetaData *d_data = nullptr;
+};
+
+/**
+ * Internal data representation of k-nearest-neighbour messages within model description hierarchy
+ * @see Description
+ */
+struct MessageKNN::Data : public MessageSpatial3D::Data {
+    friend class ModelDescription;
+    friend struct ModelData;
+    /**
+     * The maximum number of neighbours returned by a search
+     */
+    unsigned int k;
+    /**
+     * The maximum distance of a neighbour from the search origin, defaults to radius
+     */
+    float maxRadius;
+    virtual ~Data() = default;
+
+    std::unique_ptr<MessageSpecialisationHandler> getSpecialisationHander(CUDAMessage &owner) const override;
+
+    /**
+     * Used internally to validate that the corresponding Message type is attached via the agent function shim.
+     * @return The std::type_index of the Message type which must be used.
+     */
+    std::type_index getType() const override;
+
+ protected:
+    Data *clone(const std::shared_ptr<const ModelData> &newParent) override;
+    /**
+     * Copy constructor
+     * This is unsafe, should only be used internally, use clone() instead
+     */
+    Data(const std::shared_ptr<const ModelData> &, const Data &other);
+    /**
+     * Normal constructor, only to be called by ModelDescription
+     */
+    Data(const std::shared_ptr<const ModelData> &, const std::string &message_name);
+};
+
+/**
+ * User accessible interface to k-nearest-neighbour messages within mode description hierarchy
+ * The radius, which sets the width of the bins of the spatial index, and environment bounds are inherited from MessageSpatial3D
+ * @see Data
+ */
+class MessageKNN::Description : public MessageSpatial3D::Description {
+    /**
+     * Data store class for this description, constructs instances of this class
+     */
+    friend struct Data;
+
+ protected:
+    /**
+     * Constructors
+     */
+    Description(const std::shared_ptr<const ModelData> &_model, Data *const data);
+    /**
+     * Default copy constructor, not implemented
+     */
+    Description(const Description &other_message) = delete;
+    /**
+     * Default move constructor, not implemented
+     */
+    Description(Description &&other_message) noexcept = delete;
+    /**
+     * Default copy assignment, not implemented
+     */
+    Description& operator=(const Description &other_message) = delete;
+    /**
+     * Default move assignment, not implemented
+     */
+    Description& operator=(Description &&other_message) noexcept = delete;
+
+ public:
+    /**
+     * Sets the maximum number of neighbours returned by a search
+     * @param k The maximum number of neighbours
+     * @throws exception::InvalidArgument If k is 0 or greater than MessageKNN::MAX_K
+     * @note Defaults to 1
+     */
+    void setK(const unsigned int &k);
+    /**
+     * Sets the maximum distance of a neighbour from the search origin
+     * This may exceed the radius, searches expand outwards from the search origin's bin until k neighbours are found
+     * @param r The maximum distance
+     * @throws exception::InvalidArgument If r is not a positive value
+     * @note Defaults to the radius
+     */
+    void setMaxRadius(const float &r);
+
+    unsigned int getK() const;
+    float getMaxRadius() const;
+};
+
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGEKNN_MESSAGEKNNHOST_H_
@@ -34,7 +34,7 @@ class MessageNone::Out {
      * Requires CURVE hashes for agent function and message name to retrieve variable memory locations
      * Takes a device pointer to a struct for metadata related to accessing the messages (e.g. an index data structure)
      */
-    __device__ Out(detail::curve::Curve::NamespaceHash /*agent fn hash*/, detail::curve::Curve::NamespaceHash /*message name hash*/, const void * /*metadata*/, unsigned int * /*scan_flag_messageOutput*/){
+    __device__ Out(detail::curve::Curve::NamespaceHash /*agent fn hash*/, detail::curve::Curve::NamespaceHash /*message name hash*/, const void * /*metadata*/, unsigned int * /*scan_flag_messageOutput*/, const unsigned int /*message_output_max*/){
     }
 };
 
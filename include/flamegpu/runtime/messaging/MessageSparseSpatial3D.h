@@ -0,0 +1,63 @@
+#ifndef INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGESPARSESPATIAL3D_H_
+#define INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGESPARSESPATIAL3D_H_
+
+#include "flamegpu/runtime/messaging/MessageBruteForce.h"
+
+namespace flamegpu {
+
+/**
+ * Sparse 3D Continuous spatial messaging functionality
+ *
+ * User specifies the search radius, which is also used as the width of the grid cells messages are partitioned into
+ * When accessing messages, a search origin is specified
+ * A subset of messages, including those within radius of the search origin are returned
+ * The user must distance check that they fall within the search radius manually
+ *
+ * Unlike MessageSpatial3D, only occupied grid cells are stored, within a hash table sized by the number of messages.
+ * Therefore the environment is unbounded, and large mostly empty environments do not require memory for every grid cell.
+ * However, each grid cell read requires a hash table lookup.
+ * Grid cell coordinates are clamped to the range [-2^20, 2^20), so message locations should fall within this many radii of the origin.
+ */
+class MessageSparseSpatial3D {
+    /**
+     * Common size type
+     */
+    typedef MessageNone::size_type size_type;
+
+ public:
+    // Host
+    struct Data;        // Forward declare inner classes
+    class Description;  // Forward declare inner classes
+    class CUDAModelHandler;
+    // Device
+    class In;
+    class Out;
+
+    /**
+     * MetaData required by sparse spatial partitioning during message reads
+     */
+    struct MetaData {
+        /**
+         * Search radius (also used as subdividision bin width)
+         */
+        float radius;
+        /**
+         * Pointer to the hash table of occupied grid cell keys in device memory
+         * @see util::detail::spatial_hash
+         */
+        unsigned long long *keys;
+        /**
+         * Pointer to the partition boundary matrix in device memory
+         * This is indexed by hash table slot, rather than by grid cell
+         */
+        unsigned int *PBM;
+        /**
+         * The number of slots in the hash table, this is always a power of two
+         */
+        unsigned int tableSize;
+    };
+};
+
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_MESSAGESPARSESPATIAL3D_H_
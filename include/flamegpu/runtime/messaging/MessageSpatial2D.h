@@ -12,7 +12,10 @@ namespace flamegpu {
  * When accessing messages, a search origin is specified
  * A subset of messages, including those within radius of the search origin are returned
  * The user must distance check that they fall within the search radius manually
- * Unlike FLAMEGPU1, these spatial messages do not wrap over environment bounds.
+ * By default, unlike FLAMEGPU1, these spatial messages do not wrap over environment bounds.
+ * Periodic mode wraps the search over the environment bounds, without duplicating messages.
+ * Bins can optionally be Morton ordered, to improve the locality of messages read from neighbouring bins.
+ * The message list can instead be declared as a view over an agent state's variables, so that no output function is required.
  */
 class MessageSpatial2D {
     /**
@@ -66,6 +69,28 @@ class MessageSpatial2D {
          * max-lowerBound
          */
         float environmentWidth[3];
+        /**
+         * True if bins are Morton ordered, rather than row-major
+         * @see util::detail::morton
+         */
+        bool mortonOrder;
+        /**
+         * The number of bits per axis of a Morton ordered tile of bins
+         */
+        unsigned int mortonBits;
+        /**
+         * The number of Morton ordered tiles in each dimension
+         */
+        unsigned int mortonTiles[2];
+        /**
+         * True if the environment bounds wrap, such that bins at opposite bounds are neighbours
+         */
+        bool periodic;
+        /**
+         * If the message list is a view over agent variables, the agent index of each message in bin order
+         * Otherwise nullptr, as the message data is itself stored in bin order
+         */
+        unsigned int *permutation;
     };
 };
 
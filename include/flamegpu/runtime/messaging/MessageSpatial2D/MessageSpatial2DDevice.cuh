@@ -3,6 +3,7 @@
 
 #include "flamegpu/runtime/messaging/MessageSpatial2D.h"
 #include "flamegpu/runtime/messaging/MessageBruteForce/MessageBruteForceDevice.cuh"
+#include "flamegpu/util/detail/Morton.cuh"
 
 namespace flamegpu {
 
@@ -37,6 +38,11 @@ class MessageSpatial2D::In {
              * relative_cell corresponds to y offset
              */
             int relative_cell = { -2 };
+            /**
+             * Relative cell within the current strip
+             * Only used if bins are Morton ordered or periodic, as the strip's bins may then not be contiguous
+             */
+            int relative_cell_x = 1;
             /**
              * This is the index after the final message, relative to the full message list, in the current bin
              */
@@ -69,6 +75,7 @@ class MessageSpatial2D::In {
              */
             __device__ bool operator==(const Message& rhs) const {
                 return this->relative_cell == rhs.relative_cell
+                    && this->relative_cell_x == rhs.relative_cell_x
                     && this->cell_index_max == rhs.cell_index_max
                     && this->cell_index == rhs.cell_index;
             }
@@ -95,6 +102,24 @@ class MessageSpatial2D::In {
             __device__ void nextStrip() {
                 relative_cell++;
             }
+            /**
+             * Utility function for deciding next cell to access, when bins are Morton ordered or periodic
+             */
+            __device__ void nextCell() {
+                if (relative_cell_x >= 1) {
+                    relative_cell_x = -1;
+                    nextStrip();
+                } else {
+                    relative_cell_x++;
+                }
+            }
+            /**
+             * Returns the index of the current message within the message list
+             * If the message list is a view over agent variables, this is the index of the agent which the message represents
+             */
+            __device__ unsigned int getIndex() const {
+                return _parent.metadata->permutation ? _parent.metadata->permutation[cell_index] : cell_index;
+            }
             /**
              * Returns the value for the current message attached to the named variable
              * @param variable_name Name of the variable
@@ -117,6 +142,16 @@ class MessageSpatial2D::In {
              */
             template<typename T, MessageNone::size_type N, unsigned int M> __device__
             T getVariable(const char(&variable_name)[M], const unsigned int& index) const;
+            /**
+             * Returns the x displacement of the current message's location from the search origin
+             * If the environment bounds are periodic, this is the shortest displacement across the wrapped bounds
+             */
+            __device__ float getRelativeX() const;
+            /**
+             * Returns the y displacement of the current message's location from the search origin
+             * If the environment bounds are periodic, this is the shortest displacement across the wrapped bounds
+             */
+            __device__ float getRelativeY() const;
         };
         /**
          * Stock iterator for iterating MessageSpatial3D::In::Filter::Message objects
@@ -275,9 +310,10 @@ class MessageSpatial2D::Out : public MessageBruteForce::Out {
      * @param agentfn_hash Added to message_hash to produce combined_hash
      * @param message_hash Added to agentfn_hash to produce combined_hash
      * @param scan_flag_messageOutput Scan flag array for optional message output
+     * @param message_output_max The maximum number of messages each agent may output
      */
-    __device__ Out(detail::curve::Curve::NamespaceHash agentfn_hash, detail::curve::Curve::NamespaceHash message_hash, const void *, unsigned int *scan_flag_messageOutput)
-        : MessageBruteForce::Out(agentfn_hash, message_hash, nullptr, scan_flag_messageOutput)
+    __device__ Out(detail::curve::Curve::NamespaceHash agentfn_hash, detail::curve::Curve::NamespaceHash message_hash, const void *, unsigned int *scan_flag_messageOutput, const unsigned int message_output_max)
+        : MessageBruteForce::Out(agentfn_hash, message_hash, nullptr, scan_flag_messageOutput, message_output_max)
     { }
     /**
      * Sets the location for this agents message
@@ -298,7 +334,7 @@ __device__ T MessageSpatial2D::In::Filter::Message::getVariable(const char(&vari
     }
 #endif
     // get the value from curve using the stored hashes and message index.
-    T value = detail::curve::Curve::getMessageVariable<T>(variable_name, this->_parent.combined_hash, cell_index);
+    T value = detail::curve::Curve::getMessageVariable<T>(variable_name, this->_parent.combined_hash, getIndex());
     return value;
 }
 template<typename T, MessageNone::size_type N, unsigned int M> __device__
@@ -311,17 +347,40 @@ T MessageSpatial2D::In::Filter::Message::getVariable(const char(&variable_name)[
     }
 #endif
     // get the value from curve using the stored hashes and message index.
-    T value = detail::curve::Curve::getMessageArrayVariable<T, N>(variable_name, this->_parent.combined_hash, cell_index, array_index);
+    T value = detail::curve::Curve::getMessageArrayVariable<T, N>(variable_name, this->_parent.combined_hash, getIndex(), array_index);
     return value;
 }
 
 
+/**
+ * Wraps a grid coord into the range 0<=pos<dim, for periodic environment bounds
+ */
+__device__ __forceinline__ int wrapGridPosition(int pos, const unsigned int dim) {
+    pos %= static_cast<int>(dim);
+    return pos < 0 ? pos + static_cast<int>(dim) : pos;
+}
+/**
+ * Returns the shortest displacement across periodic environment bounds
+ * @param displacement The unwrapped displacement along an axis
+ * @param width The environment width along the axis
+ */
+__device__ __forceinline__ float wrapDisplacement(const float displacement, const float width) {
+    return displacement - (width * rintf(displacement / width));
+}
 __device__ __forceinline__ MessageSpatial2D::GridPos2D getGridPosition2D(const MessageSpatial2D::MetaData *md, float x, float y) {
     // Clamp each grid coord to 0<=x<dim
     int gridPos[2] = {
         static_cast<int>(floorf(((x-md->min[0]) / md->environmentWidth[0])*md->gridDim[0])),
         static_cast<int>(floorf(((y-md->min[1]) / md->environmentWidth[1])*md->gridDim[1]))
     };
+    if (md->periodic) {
+        // Locations beyond the bounds wrap to the opposite bound
+        MessageSpatial2D::GridPos2D rtn = {
+            wrapGridPosition(gridPos[0], md->gridDim[0]),
+            wrapGridPosition(gridPos[1], md->gridDim[1])
+        };
+        return rtn;
+    }
     MessageSpatial2D::GridPos2D rtn = {
         gridPos[0] < 0 ? 0 : (gridPos[0] >= static_cast<int>(md->gridDim[0]) ? static_cast<int>(md->gridDim[0]) - 1 : gridPos[0]),
         gridPos[1] < 0 ? 0 : (gridPos[1] >= static_cast<int>(md->gridDim[1]) ? static_cast<int>(md->gridDim[1]) - 1 : gridPos[1])
@@ -334,14 +393,29 @@ __device__ __forceinline__ unsigned int getHash2D(const MessageSpatial2D::MetaDa
         (unsigned int)(xyz.x < 0 ? 0 : (xyz.x >= static_cast<int>(md->gridDim[0]) - 1 ? static_cast<int>(md->gridDim[0]) - 1 : xyz.x)),  // Only x should ever be out of bounds here
         (unsigned int) xyz.y,  // xyz.y < 0 ? 0 : (xyz.y >= md->gridDim[1] - 1 ? md->gridDim[1] - 1 : xyz.y)
     };
+    if (md->mortonOrder) {
+        return util::detail::morton::encode2D(gridPos[0], gridPos[1], md->mortonBits, md->mortonTiles);
+    }
     // Compute hash (effectivley an index for to a bin within the partitioning grid in this case)
     return (unsigned int)(
         (gridPos[1] * md->gridDim[0]) +                    // y
         gridPos[0]);                                      // x
 }
 
+__device__ inline float MessageSpatial2D::In::Filter::Message::getRelativeX() const {
+    const float displacement = getVariable<float>("x") - _parent.loc[0];
+    return _parent.metadata->periodic ? wrapDisplacement(displacement, _parent.metadata->environmentWidth[0]) : displacement;
+}
+__device__ inline float MessageSpatial2D::In::Filter::Message::getRelativeY() const {
+    const float displacement = getVariable<float>("y") - _parent.loc[1];
+    return _parent.metadata->periodic ? wrapDisplacement(displacement, _parent.metadata->environmentWidth[1]) : displacement;
+}
+
 __device__ inline void MessageSpatial2D::Out::setLocation(const float &x, const float &y) const {
-    unsigned int index = (blockDim.x * blockIdx.x) + threadIdx.x;  // + d_message_count;
+    const unsigned int index = getOutputIndex();
+    if (index == 0xffffffff) {
+        return;
+    }
 
     // set the variables using curve
     detail::curve::Curve::setMessageVariable<float>("x", combined_hash, x, index);
@@ -362,14 +436,45 @@ __device__ inline MessageSpatial2D::In::Filter::Message& MessageSpatial2D::In::F
     cell_index++;
     bool move_strip = cell_index >= cell_index_max;
     while (move_strip) {
-        nextStrip();
+        // Periodic strips may wrap part way, so are walked a cell at a time, as with Morton order
+        const bool walk_cells = _parent.metadata->mortonOrder || _parent.metadata->periodic;
+        if (walk_cells) {
+            nextCell();
+        } else {
+            nextStrip();
+        }
         cell_index = 0;
         cell_index_max = 1;
         if (relative_cell < 2) {
             // Calculate the strips start and end hash
             int absolute_cell_y = _parent.cell.y + relative_cell;
+            if (_parent.metadata->periodic) {
+                absolute_cell_y = wrapGridPosition(absolute_cell_y, _parent.metadata->gridDim[1]);
+            }
             // Skip the strip if it is completely out of bounds
             if (absolute_cell_y >= 0 && absolute_cell_y < static_cast<int>(_parent.metadata->gridDim[1])) {
+                if (walk_cells) {
+                    int absolute_cell_x = _parent.cell.x + relative_cell_x;
+                    if (_parent.metadata->periodic) {
+                        absolute_cell_x = wrapGridPosition(absolute_cell_x, _parent.metadata->gridDim[0]);
+                    }
+                    // Skip the cell if it is out of bounds
+                    if (absolute_cell_x < 0 || absolute_cell_x >= static_cast<int>(_parent.metadata->gridDim[0])) {
+                        continue;
+                    }
+                    // Merge following cells of the strip which are contiguous in the bin order
+                    unsigned int hash = getHash2D(_parent.metadata, { absolute_cell_x, absolute_cell_y });
+                    cell_index = _parent.metadata->PBM[hash];
+                    while (relative_cell_x < 1 && absolute_cell_x + 1 < static_cast<int>(_parent.metadata->gridDim[0])
+                        && getHash2D(_parent.metadata, { absolute_cell_x + 1, absolute_cell_y }) == hash + 1) {
+                        ++relative_cell_x;
+                        ++absolute_cell_x;
+                        ++hash;
+                    }
+                    cell_index_max = _parent.metadata->PBM[hash + 1];
+                    move_strip = cell_index >= cell_index_max;
+                    continue;
+                }
                 unsigned int start_hash = getHash2D(_parent.metadata, { _parent.cell.x - 1, absolute_cell_y });
                 unsigned int end_hash = getHash2D(_parent.metadata, { _parent.cell.x + 1, absolute_cell_y });
                 // Lookup start and end indicies from PBM
@@ -378,6 +483,7 @@ __device__ inline MessageSpatial2D::In::Filter::Message& MessageSpatial2D::In::F
             } else {
                 // Goto next strip
                 // Don't update move_strip
+                relative_cell_x = 1;
                 continue;
             }
         }
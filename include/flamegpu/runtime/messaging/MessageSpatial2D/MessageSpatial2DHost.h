@@ -6,6 +6,7 @@
 
 #include "flamegpu/runtime/detail/curve/curve.cuh"
 #include "flamegpu/model/Variable.h"
+#include "flamegpu/model/ModelData.h"
 #include "flamegpu/runtime/messaging/MessageSpatial2D.h"
 #include "flamegpu/runtime/messaging/MessageBruteForce/MessageBruteForceHost.h"
 
@@ -74,10 +75,49 @@ class MessageSpatial2D::CUDAModelHandler : public MessageSpecialisationHandler {
      * @note This only scales upwards, it will never reduce the size
      */
     void resizeKeysVals(const unsigned int &newSize);
+    /**
+     * Recalculates the bin of each message, and compares it against the bin it was last indexed in
+     * @param messageCount The number of messages in the message list
+     * @param stream CUDA stream to be used for async CUDA operations
+     * @return True if any message has changed bin since the index was last built
+     */
+    bool binsChanged(const unsigned int &messageCount, const cudaStream_t &stream);
     /**
      * Number of bins, arrays are +1 this length
      */
     unsigned int binCount = 0;
+    /**
+     * If true, the index is built with a stable sort rather than an atomic histogram
+     */
+    bool deterministic = false;
+    /**
+     * If true, the index is only rebuilt when a message has changed bin since the index was last built
+     */
+    bool incremental = false;
+    /**
+     * The number of index builds for which message bins are assumed static, following a full index build
+     */
+    unsigned int static_steps = 0;
+    /**
+     * The number of further index builds which will reuse the current index, without checking message bins
+     */
+    unsigned int static_builds_remaining = 0;
+    /**
+     * True if d_keys, d_vals and the PBM hold the index of the previous build
+     */
+    bool index_valid = false;
+    /**
+     * The number of messages held by the index of the previous build
+     */
+    unsigned int indexed_message_count = 0;
+    /**
+     * Device flag set by binChanges kernel, if any message has changed bin
+     */
+    unsigned int *d_bins_changed = nullptr;
+    /**
+     * If true, the message list is a view over agent variables, so the index is built as a permutation of agent indices
+     */
+    bool agent_view = false;
     /**
      * Size of currently allocated temp storage memory for cub
      */
@@ -124,6 +164,26 @@ struct MessageSpatial2D::Data : public MessageBruteForce::Data {
     float minY;
     float maxX;
     float maxY;
+    /**
+     * If true, bins are Morton ordered rather than row-major
+     */
+    bool morton_order;
+    /**
+     * If true, the environment bounds wrap
+     */
+    bool periodic;
+    /**
+     * If true, the index is built with a stable sort, so the order of messages within a bin is reproducible
+     */
+    bool deterministic;
+    /**
+     * If true, the index is only rebuilt when a message has changed bin
+     */
+    bool incremental;
+    /**
+     * The number of index builds for which message locations are declared static
+     */
+    unsigned int static_steps;
     virtual ~Data() = default;
 
     std::unique_ptr<MessageSpecialisationHandler> getSpecialisationHander(CUDAMessage &owner) const override;
@@ -187,12 +247,83 @@ class MessageSpatial2D::Description : public MessageBruteForce::Description {
     void setMaxX(const float &x);
     void setMaxY(const float &y);
     void setMax(const float &x, const float &y);
+    /**
+     * Sets whether the bins of the message list are Morton (Z-order) ordered, rather than row-major
+     * Morton ordering improves the locality of messages read from neighbouring bins, which benefits dense models
+     * @param morton_order True to use the Morton ordered bin layout
+     * @note Defaults to false
+     */
+    void setMortonOrder(const bool &morton_order);
+    /**
+     * Sets whether the environment bounds wrap (toroidal), such that the search about an origin near one bound
+     * also returns messages from bins at the opposite bound
+     * Use Message::getRelativeX/Y() to access the wrap-corrected displacement of a message from the search origin
+     * @param periodic True to wrap the environment bounds
+     * @note Defaults to false
+     * @note Each dimension of the environment must be at least 3x the radius, when the bounds are periodic
+     */
+    void setPeriodic(const bool &periodic);
+    /**
+     * Sets whether the message list's index is built deterministically
+     * By default, the order of messages within a bin depends on the scheduling of atomic operations, so varies between runs
+     * When deterministic, messages are stably sorted, so they retain the order in which they were output within each bin
+     * This makes floating point reductions over messages reproducible, at the cost of a radix sort per index build
+     * @param deterministic True to build the index deterministically
+     * @note Defaults to false
+     */
+    void setDeterministic(const bool &deterministic);
+    /**
+     * Sets whether the message list's index is only rebuilt when a message has changed bin
+     * Before each index build, the bin of every message is compared against the bin it held when the index was last built
+     * If no message has changed bin, and the message count is unchanged, the previous index is reused
+     * This suits static or slowly moving populations, the output order of messages must remain stable for the index to be reused
+     * @param incremental True to enable bin change detection
+     * @note Defaults to false
+     */
+    void setIncremental(const bool &incremental);
+    /**
+     * Declares that message locations do not change bin for the specified number of index builds
+     * The index is fully rebuilt once every steps builds, the intervening builds reuse it without checking message bins
+     * Messages are still reordered each build, so message variables other than location may change
+     * @param steps The number of index builds for which the message list is static, 0 or 1 rebuilds the index every build
+     * @note Defaults to 0
+     * @note A change in message count always forces the index to be rebuilt
+     * @note If a message does change bin during these builds, it may be missed by message iteration
+     */
+    void setStaticSteps(const unsigned int &steps);
+    /**
+     * Declares the message list as a view over the variables of an agent state, rather than being output by agent functions
+     * Each agent in the state represents one message, message variables are read directly from the agent variables of the same name
+     * The index is built as a permutation over the agent buffers, so no output function is required and no agent data is copied
+     * @param agent_name Name of the agent to view, it must provide each of the message's variables (including x, y) with matching types
+     * @param state_name Name of the agent state to view
+     * @throws exception::InvalidAgentName If the named agent does not exist within the model
+     * @throws exception::InvalidStateName If the named state does not exist within the agent
+     * @note The message list cannot be output by agent functions
+     * @note If a layer which reads the message list also contains an agent function executing over the viewed state,
+     *       the viewed variables are copied to a message list before the layer, so that writes within the layer are not observed
+     * @note Agents disabled by an agent function condition within the layer remain messages
+     */
+    void setAgentView(const std::string &agent_name, const std::string &state_name = ModelData::DEFAULT_STATE);
 
     float getRadius() const;
     float getMinX() const;
     float getMinY() const;
     float getMaxX() const;
     float getMaxY() const;
+    bool getMortonOrder() const;
+    bool getPeriodic() const;
+    bool getDeterministic() const;
+    bool getIncremental() const;
+    unsigned int getStaticSteps() const;
+    /**
+     * @return The name of the agent which the message list is a view over, or an empty string if the message list is output by agent functions
+     */
+    std::string getViewAgent() const;
+    /**
+     * @return The name of the agent state which the message list is a view over
+     */
+    std::string getViewState() const;
 };
 
 }  // namespace flamegpu
@@ -38,6 +38,11 @@ class MessageSpatial3D::In {
              * relative_cell[1] corresponds to z offset
              */
             int relative_cell[2] = { -2, 1 };
+            /**
+             * Relative cell within the current strip
+             * Only used if bins are Morton ordered or periodic, as the strip's bins may then not be contiguous
+             */
+            int relative_cell_x = 1;
             /**
              * This is the index after the final message, relative to the full message list, in the current bin
              */
@@ -72,6 +77,7 @@ class MessageSpatial3D::In {
             __device__ bool operator==(const Message &rhs) const {
                 return this->relative_cell[0] == rhs.relative_cell[0]
                     && this->relative_cell[1] == rhs.relative_cell[1]
+                    && this->relative_cell_x == rhs.relative_cell_x
                     && this->cell_index_max == rhs.cell_index_max
                     && this->cell_index == rhs.cell_index;
             }
@@ -103,6 +109,24 @@ class MessageSpatial3D::In {
                     relative_cell[1]++;
                 }
             }
+            /**
+             * Utility function for deciding next cell to access, when bins are Morton ordered or periodic
+             */
+            __device__ void nextCell() {
+                if (relative_cell_x >= 1) {
+                    relative_cell_x = -1;
+                    nextStrip();
+                } else {
+                    relative_cell_x++;
+                }
+            }
+            /**
+             * Returns the index of the current message within the message list
+             * If the message list is a view over agent variables, this is the index of the agent which the message represents
+             */
+            __device__ unsigned int getIndex() const {
+                return _parent.metadata->permutation ? _parent.metadata->permutation[cell_index] : cell_index;
+            }
             /**
              * Returns the value for the current message attached to the named variable
              * @param variable_name Name of the variable
@@ -125,6 +149,21 @@ class MessageSpatial3D::In {
              */
             template<typename T, MessageNone::size_type N, unsigned int M> __device__
             T getVariable(const char(&variable_name)[M], const unsigned int& index) const;
+            /**
+             * Returns the x displacement of the current message's location from the search origin
+             * If the environment bounds are periodic, this is the shortest displacement across the wrapped bounds
+             */
+            __device__ float getRelativeX() const;
+            /**
+             * Returns the y displacement of the current message's location from the search origin
+             * If the environment bounds are periodic, this is the shortest displacement across the wrapped bounds
+             */
+            __device__ float getRelativeY() const;
+            /**
+             * Returns the z displacement of the current message's location from the search origin
+             * If the environment bounds are periodic, this is the shortest displacement across the wrapped bounds
+             */
+            __device__ float getRelativeZ() const;
         };
         /**
          * Stock iterator for iterating MessageSpatial3D::In::Filter::Message objects
@@ -286,9 +325,10 @@ class MessageSpatial3D::Out : public MessageBruteForce::Out {
      * @param agentfn_hash Added to message_hash to produce combined_hash
      * @param message_hash Added to agentfn_hash to produce combined_hash
      * @param scan_flag_messageOutput Scan flag array for optional message output
+     * @param message_output_max The maximum number of messages each agent may output
      */
-    __device__ Out(detail::curve::Curve::NamespaceHash agentfn_hash, detail::curve::Curve::NamespaceHash message_hash, const void *, unsigned int *scan_flag_messageOutput)
-        : MessageBruteForce::Out(agentfn_hash, message_hash, nullptr, scan_flag_messageOutput)
+    __device__ Out(detail::curve::Curve::NamespaceHash agentfn_hash, detail::curve::Curve::NamespaceHash message_hash, const void *, unsigned int *scan_flag_messageOutput, const unsigned int message_output_max)
+        : MessageBruteForce::Out(agentfn_hash, message_hash, nullptr, scan_flag_messageOutput, message_output_max)
     { }
     /**
      * Sets the location for this agents message
@@ -310,7 +350,7 @@ __device__ T MessageSpatial3D::In::Filter::Message::getVariable(const char(&vari
     }
 #endif
     // get the value from curve using the stored hashes and message index.
-    T value = detail::curve::Curve::getMessageVariable<T>(variable_name, this->_parent.combined_hash, cell_index);
+    T value = detail::curve::Curve::getMessageVariable<T>(variable_name, this->_parent.combined_hash, getIndex());
     return value;
 }
 template<typename T, MessageNone::size_type N, unsigned int M> __device__
@@ -323,7 +363,7 @@ T MessageSpatial3D::In::Filter::Message::getVariable(const char(&variable_name)[
     }
 #endif
     // get the value from curve using the stored hashes and message index.
-    T value = detail::curve::Curve::getMessageArrayVariable<T, N>(variable_name, this->_parent.combined_hash, cell_index, array_index);
+    T value = detail::curve::Curve::getMessageArrayVariable<T, N>(variable_name, this->_parent.combined_hash, getIndex(), array_index);
     return value;
 }
 
@@ -335,6 +375,15 @@ __device__ __forceinline__ MessageSpatial3D::GridPos3D getGridPosition3D(const M
         static_cast<int>(floorf(((y-md->min[1]) / md->environmentWidth[1])*md->gridDim[1])),
         static_cast<int>(floorf(((z-md->min[2]) / md->environmentWidth[2])*md->gridDim[2]))
     };
+    if (md->periodic) {
+        // Locations beyond the bounds wrap to the opposite bound
+        MessageSpatial3D::GridPos3D rtn = {
+            wrapGridPosition(gridPos[0], md->gridDim[0]),
+            wrapGridPosition(gridPos[1], md->gridDim[1]),
+            wrapGridPosition(gridPos[2], md->gridDim[2])
+        };
+        return rtn;
+    }
     MessageSpatial3D::GridPos3D rtn = {
         gridPos[0] < 0 ? 0 : (gridPos[0] >= static_cast<int>(md->gridDim[0]) ? static_cast<int>(md->gridDim[0]) - 1 : gridPos[0]),
         gridPos[1] < 0 ? 0 : (gridPos[1] >= static_cast<int>(md->gridDim[1]) ? static_cast<int>(md->gridDim[1]) - 1 : gridPos[1]),
@@ -349,6 +398,9 @@ __device__ __forceinline__ unsigned int getHash3D(const MessageSpatial3D::MetaDa
         (unsigned int) xyz.y,  // xyz.y < 0 ? 0 : (xyz.y >= md->gridDim[1] - 1 ? md->gridDim[1] - 1 : xyz.y),
         (unsigned int) xyz.z,  // xyz.z < 0 ? 0 : (xyz.z >= md->gridDim[2] - 1 ? md->gridDim[2] - 1 : xyz.z)
     };
+    if (md->mortonOrder) {
+        return util::detail::morton::encode3D(gridPos[0], gridPos[1], gridPos[2], md->mortonBits, md->mortonTiles);
+    }
     // Compute hash (effectivley an index for to a bin within the partitioning grid in this case)
     return (unsigned int)(
         (gridPos[2] * md->gridDim[0] * md->gridDim[1]) +   // z
@@ -356,8 +408,24 @@ __device__ __forceinline__ unsigned int getHash3D(const MessageSpatial3D::MetaDa
         gridPos[0]);                                      // x
 }
 
+__device__ inline float MessageSpatial3D::In::Filter::Message::getRelativeX() const {
+    const float displacement = getVariable<float>("x") - _parent.loc[0];
+    return _parent.metadata->periodic ? wrapDisplacement(displacement, _parent.metadata->environmentWidth[0]) : displacement;
+}
+__device__ inline float MessageSpatial3D::In::Filter::Message::getRelativeY() const {
+    const float displacement = getVariable<float>("y") - _parent.loc[1];
+    return _parent.metadata->periodic ? wrapDisplacement(displacement, _parent.metadata->environmentWidth[1]) : displacement;
+}
+__device__ inline float MessageSpatial3D::In::Filter::Message::getRelativeZ() const {
+    const float displacement = getVariable<float>("z") - _parent.loc[2];
+    return _parent.metadata->periodic ? wrapDisplacement(displacement, _parent.metadata->environmentWidth[2]) : displacement;
+}
+
 __device__ inline void MessageSpatial3D::Out::setLocation(const float &x, const float &y, const float &z) const {
-    unsigned int index = (blockDim.x * blockIdx.x) + threadIdx.x;  // + d_message_count;
+    const unsigned int index = getOutputIndex();
+    if (index == 0xffffffff) {
+        return;
+    }
 
     // set the variables using curve
     detail::curve::Curve::setMessageVariable<float>("x", combined_hash, x, index);
@@ -380,14 +448,46 @@ __device__ inline MessageSpatial3D::In::Filter::Message& MessageSpatial3D::In::F
     cell_index++;
     bool move_strip = cell_index >= cell_index_max;
     while (move_strip) {
-        nextStrip();
+        // Periodic strips may wrap part way, so are walked a cell at a time, as with Morton order
+        const bool walk_cells = _parent.metadata->mortonOrder || _parent.metadata->periodic;
+        if (walk_cells) {
+            nextCell();
+        } else {
+            nextStrip();
+        }
         cell_index = 0;
         cell_index_max = 1;
         if (relative_cell[0] < 2) {
             // Calculate the strips start and end hash
             int absolute_cell[2] = { _parent.cell.y + relative_cell[0], _parent.cell.z + relative_cell[1] };
+            if (_parent.metadata->periodic) {
+                absolute_cell[0] = wrapGridPosition(absolute_cell[0], _parent.metadata->gridDim[1]);
+                absolute_cell[1] = wrapGridPosition(absolute_cell[1], _parent.metadata->gridDim[2]);
+            }
             // Skip the strip if it is completely out of bounds
             if (absolute_cell[0] >= 0 && absolute_cell[1] >= 0 && absolute_cell[0] < static_cast<int>(_parent.metadata->gridDim[1]) && absolute_cell[1] < static_cast<int>(_parent.metadata->gridDim[2])) {
+                if (walk_cells) {
+                    int absolute_cell_x = _parent.cell.x + relative_cell_x;
+                    if (_parent.metadata->periodic) {
+                        absolute_cell_x = wrapGridPosition(absolute_cell_x, _parent.metadata->gridDim[0]);
+                    }
+                    // Skip the cell if it is out of bounds
+                    if (absolute_cell_x < 0 || absolute_cell_x >= static_cast<int>(_parent.metadata->gridDim[0])) {
+                        continue;
+                    }
+                    // Merge following cells of the strip which are contiguous in the bin order
+                    unsigned int hash = getHash3D(_parent.metadata, { absolute_cell_x, absolute_cell[0], absolute_cell[1] });
+                    cell_index = _parent.metadata->PBM[hash];
+                    while (relative_cell_x < 1 && absolute_cell_x + 1 < static_cast<int>(_parent.metadata->gridDim[0])
+                        && getHash3D(_parent.metadata, { absolute_cell_x + 1, absolute_cell[0], absolute_cell[1] }) == hash + 1) {
+                        ++relative_cell_x;
+                        ++absolute_cell_x;
+                        ++hash;
+                    }
+                    cell_index_max = _parent.metadata->PBM[hash + 1];
+                    move_strip = cell_index >= cell_index_max;
+                    continue;
+                }
                 unsigned int start_hash = getHash3D(_parent.metadata, { _parent.cell.x - 1, absolute_cell[0], absolute_cell[1] });
                 unsigned int end_hash = getHash3D(_parent.metadata, { _parent.cell.x + 1, absolute_cell[0], absolute_cell[1] });
                 // Lookup start and end indicies from PBM
@@ -396,6 +496,7 @@ __device__ inline MessageSpatial3D::In::Filter::Message& MessageSpatial3D::In::F
             } else {
                 // Goto next strip
                 // Don't update move_strip
+                relative_cell_x = 1;
                 continue;
             }
         }
@@ -9,10 +9,13 @@
 #include "flamegpu/runtime/messaging/MessageBruteForce/MessageBruteForceDevice.cuh"
 #include "flamegpu/runtime/messaging/MessageSpatial2D/MessageSpatial2DDevice.cuh"
 #include "flamegpu/runtime/messaging/MessageSpatial3D/MessageSpatial3DDevice.cuh"
+#include "flamegpu/runtime/messaging/MessageSparseSpatial3D/MessageSparseSpatial3DDevice.cuh"
+#include "flamegpu/runtime/messaging/MessageKNN/MessageKNNDevice.cuh"
 #include "flamegpu/runtime/messaging/MessageArray/MessageArrayDevice.cuh"
 #include "flamegpu/runtime/messaging/MessageArray2D/MessageArray2DDevice.cuh"
 #include "flamegpu/runtime/messaging/MessageArray3D/MessageArray3DDevice.cuh"
 #include "flamegpu/runtime/messaging/MessageBucket/MessageBucketDevice.cuh"
+#include "flamegpu/runtime/messaging/MessageGraph/MessageGraphDevice.cuh"
 
 
 #endif  // INCLUDE_FLAMEGPU_RUNTIME_MESSAGING_DEVICE_H_
@@ -1,62 +1,178 @@
 #ifndef INCLUDE_FLAMEGPU_RUNTIME_UTILITY_AGENTRANDOM_CUH_
 #define INCLUDE_FLAMEGPU_RUNTIME_UTILITY_AGENTRANDOM_CUH_
 
-#include <curand_kernel.h>
 #include <cassert>
+#include <cstdint>
 
+#ifndef __CUDACC_RTC__
+#include "flamegpu/runtime/detail/curve/curve.cuh"
+#else
+#include "dynamic/curve_rtc_dynamic.h"
+#endif  // !_RTC
 #include "flamegpu/util/detail/StaticAssert.h"
+#include "flamegpu/util/detail/Philox.cuh"
 #include "flamegpu/exception/FLAMEGPUDeviceException.cuh"
+#include "flamegpu/defines.h"
 
 namespace flamegpu {
 
 /**
  * Utility for accessing random generation within agent functions
  * This should only be instantiated by FLAMEGPU_API
- * Wraps curand functions to access an internal curand state * 
+ *
+ * Each value is produced by the counter-based Philox generator, keyed by (seed, step, layer, agent function, agent key, draw index)
+ * An agent's key is its ID, unless it was born on the device, where IDs are allocated atomically so depend on scheduling.
+ * Agents born on the device are instead keyed by a hash of their parent's key and the step and agent function of their birth.
+ * No per-thread state is stored between kernels, so an agent's random stream does not depend on the
+ * order or concurrency of kernel launches, nor on the agent's position within the population.
+ * The floating point distributions are also available on the host, to reproduce an agent's stream.
  */
 class AgentRandom {
  public:
     /**
-     * Constructs an AgentRandom instance
-     * @param d_rng ThreadSafe device curand state instance
-     *   this is a unique instance for the thread among all concurrently executing kernels
+     * Identifies the random streams of a single agent function (or agent function condition) launch
+     * Combined with an agent's ID, this selects that agent's stream
+     * @see RandomManager::agentStream()
      */
-    __forceinline__ __device__ AgentRandom(curandState *d_rng);
+    struct Stream {
+        /**
+         * The simulation's random seed
+         */
+        uint64_t seed;
+        /**
+         * The step being executed
+         */
+        unsigned int step;
+        /**
+         * Hash identifying the agent, agent function, layer and whether it is the function's condition, independent of the simulation instance
+         */
+        unsigned int function;
+        /**
+         * True if the executing agent has the internal variable RNG_KEY_VARIABLE_NAME, so may have been born on the device
+         */
+        bool keyed;
+    };
     /**
-     * Returns a float uniformly distributed between 0.0 and 1.0. 
+     * Constructs an AgentRandom instance, the agent's key is only loaded if random is used
+     * @param _stream The random streams of the agent function launch
+     * @param _agent_func_name_hash CURVE hash of the agent function, used to load the agent's key
+     * @param _agent_index Index of the executing agent within the agent state list
+     */
+    __forceinline__ __device__ AgentRandom(const Stream &_stream, const detail::curve::Curve::NamespaceHash &_agent_func_name_hash, const unsigned int &_agent_index);
+    /**
+     * Constructs an AgentRandom instance, for an agent with a known key
+     * This allows an agent's random stream to be reproduced on the host
+     * @param _stream The random streams of the agent function launch
+     * @param _agent_key The agent's RNG_KEY_VARIABLE_NAME variable if present and non-zero, otherwise the agent's ID
+     */
+    __forceinline__ __host__ __device__ AgentRandom(const Stream &_stream, const uint64_t &_agent_key);
+    /**
+     * Returns a float uniformly distributed between 0.0 and 1.0.
      * @note It may return from 0.0 to 1.0, where 1.0 is included and 0.0 is excluded.
      * @note Available as float or double
      */
     template<typename T>
-    __forceinline__ __device__ T uniform() const;
+    __forceinline__ __host__ __device__ T uniform() const;
     /**
      * Returns a normally distributed float with mean 0.0 and standard deviation 1.0.
      * @note This result can be scaled and shifted to produce normally distributed values with any mean/stddev.
      * @note Available as float or double
      */
     template<typename T>
-    __forceinline__ __device__ T normal() const;
+    __forceinline__ __host__ __device__ T normal() const;
     /**
      * Returns a log-normally distributed float based on a normal distribution with the given mean and standard deviation.
      * @note Available as float or double
      */
     template<typename T>
-    __forceinline__ __device__ T logNormal(const T& mean, const T& stddev) const;
+    __forceinline__ __host__ __device__ T logNormal(const T& mean, const T& stddev) const;
     /**
      * Returns an integer uniformly distributed in the inclusive range [lowerBound, max]
      * @note Available as signed and unsigned: char, short, int, long long
      */
     template<typename T>
     __forceinline__ __device__ T uniform(const T& min, const T& max) const;
+    /**
+     * Returns the key of an agent born to this agent during the agent function
+     * It is derived from this agent's key, and the step and agent function, so does not depend on the newborn's ID
+     * Each agent outputs at most one agent per agent function, so siblings born in different steps or functions receive different keys
+     * The most significant bit is always set, so the key never matches an agent's ID
+     */
+    __forceinline__ __host__ __device__ uint64_t birthKey() const;
 
  private:
     /**
-     * Thread-safe index for accessing curand
+     * Returns the agent's key, loading it on first use
      */
-    curandState *d_random_state;
+    __forceinline__ __host__ __device__ uint64_t key() const;
+    /**
+     * Returns the next 128 bit block of the agent's stream
+     * Each draw consumes a whole block
+     */
+    __forceinline__ __host__ __device__ util::detail::Philox::uint32x4 next() const;
+    /**
+     * The random streams of the agent function launch
+     */
+    const Stream stream;
+    /**
+     * CURVE hash of the agent function, used to load agent_key
+     */
+    const detail::curve::Curve::NamespaceHash agent_func_name_hash;
+    /**
+     * Index of the executing agent within the agent state list, used to load agent_key
+     */
+    const unsigned int agent_index;
+    /**
+     * Key of the executing agent's stream, only valid once has_key is set
+     */
+    mutable uint64_t agent_key;
+    /**
+     * True once agent_key has been loaded
+     */
+    mutable bool has_key;
+    /**
+     * Number of values already drawn from the agent's stream
+     */
+    mutable unsigned int draw;
 };
 
-__forceinline__ __device__ AgentRandom::AgentRandom(curandState *d_rng) : d_random_state(d_rng) { }
+__forceinline__ __device__ AgentRandom::AgentRandom(const Stream &_stream, const detail::curve::Curve::NamespaceHash &_agent_func_name_hash, const unsigned int &_agent_index)
+    : stream(_stream)
+    , agent_func_name_hash(_agent_func_name_hash)
+    , agent_index(_agent_index)
+    , agent_key(0)
+    , has_key(false)
+    , draw(0) { }
+__forceinline__ __host__ __device__ AgentRandom::AgentRandom(const Stream &_stream, const uint64_t &_agent_key)
+    : stream(_stream)
+    , agent_func_name_hash(0)
+    , agent_index(0)
+    , agent_key(_agent_key)
+    , has_key(true)
+    , draw(0) { }
+__forceinline__ __host__ __device__ uint64_t AgentRandom::key() const {
+#ifdef __CUDA_ARCH__
+    if (!has_key) {
+        // Can't use RNG_KEY_VARIABLE_NAME or ID_VARIABLE_NAME inline, as they aren't of char[N] type
+        agent_key = stream.keyed ? detail::curve::Curve::getAgentVariable<uint64_t>("_rng_key", agent_func_name_hash, agent_index) : 0;
+        if (!agent_key) {
+            agent_key = detail::curve::Curve::getAgentVariable<id_t>("_id", agent_func_name_hash, agent_index);
+        }
+        has_key = true;
+    }
+#endif
+    return agent_key;
+}
+__forceinline__ __host__ __device__ uint64_t AgentRandom::birthKey() const {
+    const uint64_t birth = (static_cast<uint64_t>(stream.step) << 32) | stream.function;
+    return util::detail::Philox::mix64(util::detail::Philox::mix64(key()) ^ birth) | (1ull << 63);
+}
+__forceinline__ __host__ __device__ util::detail::Philox::uint32x4 AgentRandom::next() const {
+    const uint64_t k = key();
+    // The agent's key fills two counter words, so the function is moved into the upper word of the Philox key, as the seed is 32 bit
+    return util::detail::Philox::generate({ draw++, static_cast<uint32_t>(k), static_cast<uint32_t>(k >> 32), stream.step },
+        util::detail::Philox::key(stream.seed ^ (static_cast<uint64_t>(stream.function) << 32)));
+}
 /**
  * All templates are specialised
  */
@@ -65,35 +181,38 @@ __forceinline__ __device__ AgentRandom::AgentRandom(curandState *d_rng) : d_rand
  * Uniform floating point
  */
 template<>
-__forceinline__ __device__ float AgentRandom::uniform() const {
-    return curand_uniform(d_random_state);
+__forceinline__ __host__ __device__ float AgentRandom::uniform() const {
+    return util::detail::Philox::toFloat(next().x);
 }
 template<>
-__forceinline__ __device__ double AgentRandom::uniform() const {
-    return curand_uniform_double(d_random_state);
+__forceinline__ __host__ __device__ double AgentRandom::uniform() const {
+    const util::detail::Philox::uint32x4 r = next();
+    return util::detail::Philox::toDouble(r.x, r.y);
 }
 
 /**
  * Normal floating point
  */
 template<>
-__forceinline__ __device__ float AgentRandom::normal() const {
-    return curand_normal(d_random_state);
+__forceinline__ __host__ __device__ float AgentRandom::normal() const {
+    const util::detail::Philox::uint32x4 r = next();
+    return util::detail::Philox::toNormal(util::detail::Philox::toFloat(r.x), util::detail::Philox::toFloat(r.y));
 }
 template<>
-__forceinline__ __device__ double AgentRandom::normal() const {
-    return curand_normal_double(d_random_state);
+__forceinline__ __host__ __device__ double AgentRandom::normal() const {
+    const util::detail::Philox::uint32x4 r = next();
+    return util::detail::Philox::toNormal(util::detail::Philox::toDouble(r.x, r.y), util::detail::Philox::toDouble(r.z, r.w));
 }
 /**
  * Log Normal floating point
  */
 template<>
-__forceinline__ __device__ float AgentRandom::logNormal(const float& mean, const float& stddev) const {
-    return curand_log_normal(d_random_state, mean, stddev);
+__forceinline__ __host__ __device__ float AgentRandom::logNormal(const float& mean, const float& stddev) const {
+    return expf(mean + stddev * normal<float>());
 }
 template<>
-__forceinline__ __device__ double AgentRandom::logNormal(const double& mean, const double& stddev) const {
-    return curand_log_normal_double(d_random_state, mean, stddev);
+__forceinline__ __host__ __device__ double AgentRandom::logNormal(const double& mean, const double& stddev) const {
+    return exp(mean + stddev * normal<double>());
 }
 /**
 * Uniform Int
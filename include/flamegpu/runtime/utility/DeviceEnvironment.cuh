@@ -6,6 +6,10 @@
 #include <string>
 #include <cassert>
 
+#include "flamegpu/runtime/utility/DeviceEnvironmentField.cuh"
+#include "flamegpu/runtime/utility/DeviceEnvironmentTable.cuh"
+#include "flamegpu/runtime/utility/DeviceMacroProperty.cuh"
+
 namespace flamegpu {
 
 #ifndef __CUDACC_RTC__
@@ -21,6 +25,9 @@ namespace detail {
  * Utility for accessing environmental properties
  * These can only be read within agent functions
  * They can be set and updated within host functions
+ * Environment macro properties can additionally be updated atomically within agent functions
+ * Environment tables are read-only, and can only be read within agent functions
+ * Environment fields can be sampled and deposited into within agent functions
  */
 class DeviceEnvironment {
     /**
@@ -31,11 +38,20 @@ class DeviceEnvironment {
      * Performs runtime validation that CURVE_NAMESPACE_HASH matches host value
      */
     friend class EnvironmentManager;
+    /**
+     * Performs runtime validation that MACRO_NAMESPACE_HASH matches host value
+     */
+    friend class CUDAMacroEnvironment;
     /**
      * Device accessible copy of curve namespace hash, this is precomputed from EnvironmentManager::CURVE_NAMESPACE_HASH
      * EnvironmentManager::EnvironmentManager() validates that this value matches
      */
     __host__ __device__ static constexpr unsigned int CURVE_NAMESPACE_HASH() { return 0X1428F902u; }
+    /**
+     * Device accessible copy of the curve namespace hash of macro properties, this is precomputed from CUDAMacroEnvironment::CURVE_NAMESPACE_HASH
+     * CUDAMacroEnvironment::init() validates that this value matches
+     */
+    __host__ __device__ static constexpr unsigned int MACRO_NAMESPACE_HASH() { return 0XA1693911u; }
     /**
      * Hash of the model's name, this is added to CURVE_NAMESPACE_HASH and variable name hash to find curve hash
      */
@@ -78,6 +94,41 @@ class DeviceEnvironment {
      */
     template<unsigned int N>
     __device__ __forceinline__ bool containsProperty(const char(&name)[N]) const;
+    /**
+     * Returns a handle to an environment macro property, which can be read and atomically updated
+     * @param name name used for accessing the macro property, this value should be a string literal e.g. "foobar"
+     * @tparam T Type of the macro property being accessed
+     * @tparam I Length of the macro property's 1st dimension
+     * @tparam J Length of the macro property's 2nd dimension
+     * @tparam K Length of the macro property's 3rd dimension
+     * @tparam W Length of the macro property's 4th dimension
+     * @tparam N Length of macro property name, this should always be implicit if passing a string literal
+     * @throws exception::DeviceError If name is not a valid macro property within the environment (flamegpu must be built with SEATBELTS enabled for device error checking)
+     * @throws exception::DeviceError If T or the dimensions do not match the macro property specified by name (flamegpu must be built with SEATBELTS enabled for device error checking)
+     * @see EnvironmentDescription::newMacroProperty()
+     */
+    template<typename T, unsigned int I = 1, unsigned int J = 1, unsigned int K = 1, unsigned int W = 1, unsigned int N>
+    __device__ __forceinline__ DeviceMacroProperty<T, I, J, K, W> getMacroProperty(const char(&name)[N]) const;
+    /**
+     * Returns a handle to a read-only environment table
+     * @param name name used for accessing the table, this value should be a string literal e.g. "foobar"
+     * @tparam T Type of the table's elements
+     * @tparam N Length of table name, this should always be implicit if passing a string literal
+     * @throws exception::DeviceError If name is not a valid table within the environment (flamegpu must be built with SEATBELTS enabled for device error checking)
+     * @throws exception::DeviceError If T does not match the size of the table's elements (flamegpu must be built with SEATBELTS enabled for device error checking)
+     * @see EnvironmentDescription::newTable()
+     */
+    template<typename T, unsigned int N>
+    __device__ __forceinline__ DeviceEnvironmentTable<T> getTable(const char(&name)[N]) const;
+    /**
+     * Returns a handle to an environment field
+     * @param name name used for accessing the field, this value should be a string literal e.g. "foobar"
+     * @tparam N Length of field name, this should always be implicit if passing a string literal
+     * @throws exception::DeviceError If name is not a valid field within the environment (flamegpu must be built with SEATBELTS enabled for device error checking)
+     * @see EnvironmentDescription::newField()
+     */
+    template<unsigned int N>
+    __device__ __forceinline__ DeviceEnvironmentField getField(const char(&name)[N]) const;
 };
 
 // Mash compilation of these functions from RTC builds as this requires a dynamic implementation of the function in curve_rtc
@@ -135,6 +186,59 @@ __device__ __forceinline__ bool DeviceEnvironment::containsProperty(const char(&
     detail::curve::Curve::VariableHash cvh = CURVE_NAMESPACE_HASH() + modelname_hash + detail::curve::Curve::variableHash(name);
     return detail::curve::Curve::getVariable(cvh) != detail::curve::Curve::UNKNOWN_VARIABLE;
 }
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W, unsigned int N>
+__device__ __forceinline__ DeviceMacroProperty<T, I, J, K, W> DeviceEnvironment::getMacroProperty(const char(&name)[N]) const {
+    detail::curve::Curve::VariableHash cvh = MACRO_NAMESPACE_HASH() + modelname_hash + detail::curve::Curve::variableHash(name);
+    const auto cv = detail::curve::Curve::getVariable(cvh);
+#if !defined(SEATBELTS) || SEATBELTS
+    if (cv == detail::curve::Curve::UNKNOWN_VARIABLE) {
+        DTHROW("Environment macro property with name: %s was not found.\n", name);
+    } else if (detail::curve::detail::d_sizes[cv] != sizeof(T)) {
+        DTHROW("Environment macro property with name: %s type size mismatch %llu != %llu.\n", name, detail::curve::detail::d_sizes[cv], sizeof(T));
+    } else if (detail::curve::detail::d_lengths[cv] != I * J * K * W) {
+        DTHROW("Environment macro property with name: %s dimensions mismatch, %u elements != %u.\n", name, detail::curve::detail::d_lengths[cv], I * J * K * W);
+    } else {
+        return DeviceMacroProperty<T, I, J, K, W>(reinterpret_cast<T*>(detail::curve::detail::d_variables[cv]));
+    }
+    return DeviceMacroProperty<T, I, J, K, W>(nullptr);
+#else
+    return DeviceMacroProperty<T, I, J, K, W>(reinterpret_cast<T*>(detail::curve::detail::d_variables[cv]));
+#endif
+}
+template<typename T, unsigned int N>
+__device__ __forceinline__ DeviceEnvironmentTable<T> DeviceEnvironment::getTable(const char(&name)[N]) const {
+    // Tables share the macro property namespace, EnvironmentDescription prevents their names colliding
+    detail::curve::Curve::VariableHash cvh = MACRO_NAMESPACE_HASH() + modelname_hash + detail::curve::Curve::variableHash(name);
+    const auto cv = detail::curve::Curve::getVariable(cvh);
+#if !defined(SEATBELTS) || SEATBELTS
+    if (cv == detail::curve::Curve::UNKNOWN_VARIABLE) {
+        DTHROW("Environment table with name: %s was not found.\n", name);
+    } else if (detail::curve::detail::d_sizes[cv] != sizeof(T)) {
+        DTHROW("Environment table with name: %s type size mismatch %llu != %llu.\n", name, detail::curve::detail::d_sizes[cv], sizeof(T));
+    } else {
+        return DeviceEnvironmentTable<T>(reinterpret_cast<const T*>(detail::curve::detail::d_variables[cv]), detail::curve::detail::d_lengths[cv]);
+    }
+    return DeviceEnvironmentTable<T>(nullptr, 0);
+#else
+    return DeviceEnvironmentTable<T>(reinterpret_cast<const T*>(detail::curve::detail::d_variables[cv]), detail::curve::detail::d_lengths[cv]);
+#endif
+}
+template<unsigned int N>
+__device__ __forceinline__ DeviceEnvironmentField DeviceEnvironment::getField(const char(&name)[N]) const {
+    // Fields share the macro property namespace, EnvironmentDescription prevents their names colliding
+    detail::curve::Curve::VariableHash cvh = MACRO_NAMESPACE_HASH() + modelname_hash + detail::curve::Curve::variableHash(name);
+    const auto cv = detail::curve::Curve::getVariable(cvh);
+#if !defined(SEATBELTS) || SEATBELTS
+    if (cv == detail::curve::Curve::UNKNOWN_VARIABLE) {
+        DTHROW("Environment field with name: %s was not found.\n", name);
+        return DeviceEnvironmentField(nullptr);
+    } else if (detail::curve::detail::d_sizes[cv] != sizeof(float)) {
+        DTHROW("Environment property with name: %s is not a field.\n", name);
+        return DeviceEnvironmentField(nullptr);
+    }
+#endif
+    return DeviceEnvironmentField(detail::curve::detail::d_variables[cv]);
+}
 
 #endif  // __CUDACC_RTC__
 
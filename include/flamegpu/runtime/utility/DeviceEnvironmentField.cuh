@@ -0,0 +1,117 @@
+#ifndef INCLUDE_FLAMEGPU_RUNTIME_UTILITY_DEVICEENVIRONMENTFIELD_CUH_
+#define INCLUDE_FLAMEGPU_RUNTIME_UTILITY_DEVICEENVIRONMENTFIELD_CUH_
+
+#include "flamegpu/exception/FLAMEGPUDeviceException.cuh"
+
+namespace flamegpu {
+
+/**
+ * Device handle to an environment field
+ *
+ * Fields are 2D or 3D grids of floats stored in global memory (EnvironmentDescription::newField())
+ * Cells can be sampled, and deposited into atomically, the field's stencil is applied between layers so it does not change during an agent function
+ * @note Samples are not ordered with respect to deposits made by other threads within the same agent function
+ */
+class DeviceEnvironmentField {
+ public:
+    /**
+     * Number of bytes before the field's cells, which hold its dimensions
+     * This keeps the cells aligned, and allows the dimensions to be found from the single pointer stored by curve
+     */
+    static constexpr unsigned int HEADER_SIZE = 16;
+
+ private:
+    /**
+     * Pointer to the first cell of the field within device memory
+     */
+    float *ptr;
+    /**
+     * Length of the field's x, y and z axes
+     */
+    unsigned int dimensions[3];
+
+ public:
+    /**
+     * Constructor
+     * @param header_ptr Pointer to the field's header within device memory, nullptr produces an empty field
+     */
+    __device__ __forceinline__ explicit DeviceEnvironmentField(void *header_ptr)
+        : ptr(header_ptr ? reinterpret_cast<float*>(static_cast<char*>(header_ptr) + HEADER_SIZE) : nullptr)
+        , dimensions{ 0, 0, 0 } {
+        if (header_ptr) {
+            const unsigned int *header = static_cast<const unsigned int*>(header_ptr);
+            dimensions[0] = header[0];
+            dimensions[1] = header[1];
+            dimensions[2] = header[2];
+        }
+    }
+    /**
+     * Returns the value of the cell
+     * @param x Position along the x axis
+     * @param y Position along the y axis
+     * @param z Position along the z axis
+     * @throws exception::DeviceError If the position is out of bounds (flamegpu must be built with SEATBELTS enabled for device error checking)
+     */
+    __device__ __forceinline__ float sample(const unsigned int &x, const unsigned int &y, const unsigned int &z = 0) const;
+    /**
+     * Atomically adds val to the cell
+     * @param x Position along the x axis
+     * @param y Position along the y axis
+     * @param z Position along the z axis
+     * @param val The value to add, negative values consume from the cell
+     * @throws exception::DeviceError If the position is out of bounds (flamegpu must be built with SEATBELTS enabled for device error checking)
+     */
+    __device__ __forceinline__ void deposit(const unsigned int &x, const unsigned int &y, const unsigned int &z, const float &val);
+    /**
+     * Atomically adds val to the cell of a 2D field
+     * @see deposit(const unsigned int &, const unsigned int &, const unsigned int &, const float &)
+     */
+    __device__ __forceinline__ void deposit(const unsigned int &x, const unsigned int &y, const float &val) { deposit(x, y, 0, val); }
+    /**
+     * Returns the length of the field's x axis
+     */
+    __device__ __forceinline__ unsigned int getWidth() const { return dimensions[0]; }
+    /**
+     * Returns the length of the field's y axis
+     */
+    __device__ __forceinline__ unsigned int getHeight() const { return dimensions[1]; }
+    /**
+     * Returns the length of the field's z axis, this is 1 for 2D fields
+     */
+    __device__ __forceinline__ unsigned int getDepth() const { return dimensions[2]; }
+
+ private:
+    /**
+     * Returns the index of the cell, or UINT_MAX if the position is out of bounds
+     */
+    __device__ __forceinline__ unsigned int index(const unsigned int &x, const unsigned int &y, const unsigned int &z) const {
+#if !defined(SEATBELTS) || SEATBELTS
+        if (x >= dimensions[0] || y >= dimensions[1] || z >= dimensions[2]) {
+            DTHROW("Environment field position (%u, %u, %u) is out of bounds (%u, %u, %u).\n", x, y, z, dimensions[0], dimensions[1], dimensions[2]);
+            return 0xFFFFFFFFu;
+        }
+#endif
+        return (z * dimensions[1] + y) * dimensions[0] + x;
+    }
+};
+
+__device__ __forceinline__ float DeviceEnvironmentField::sample(const unsigned int &x, const unsigned int &y, const unsigned int &z) const {
+    const unsigned int i = index(x, y, z);
+#if !defined(SEATBELTS) || SEATBELTS
+    if (i == 0xFFFFFFFFu || !ptr)
+        return 0.0f;
+#endif
+    return ptr[i];
+}
+__device__ __forceinline__ void DeviceEnvironmentField::deposit(const unsigned int &x, const unsigned int &y, const unsigned int &z, const float &val) {
+    const unsigned int i = index(x, y, z);
+#if !defined(SEATBELTS) || SEATBELTS
+    if (i == 0xFFFFFFFFu || !ptr)
+        return;
+#endif
+    atomicAdd(ptr + i, val);
+}
+
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_RUNTIME_UTILITY_DEVICEENVIRONMENTFIELD_CUH_
@@ -0,0 +1,61 @@
+#ifndef INCLUDE_FLAMEGPU_RUNTIME_UTILITY_DEVICEENVIRONMENTTABLE_CUH_
+#define INCLUDE_FLAMEGPU_RUNTIME_UTILITY_DEVICEENVIRONMENTTABLE_CUH_
+
+#include "flamegpu/exception/FLAMEGPUDeviceException.cuh"
+
+namespace flamegpu {
+
+/**
+ * Device handle to a read-only environment table
+ *
+ * Tables are flat arrays stored in global memory, which are loaded from a binary file (EnvironmentDescription::newTable())
+ * @tparam T Type of the table's elements
+ */
+template<typename T>
+class DeviceEnvironmentTable {
+    /**
+     * Pointer to the first element of the table within device memory
+     */
+    const T *ptr;
+    /**
+     * Number of elements within the table
+     */
+    unsigned int length;
+
+ public:
+    /**
+     * Constructor
+     * @param _ptr Pointer to the first element of the table within device memory
+     * @param _length Number of elements within the table
+     */
+    __device__ __forceinline__ DeviceEnvironmentTable(const T *_ptr, const unsigned int &_length)
+        : ptr(_ptr)
+        , length(_length) { }
+    /**
+     * Returns the element at the specified index
+     * @param i Index of the element
+     * @throws exception::DeviceError If i is out of bounds (flamegpu must be built with SEATBELTS enabled for device error checking)
+     */
+    __device__ __forceinline__ T operator[](const unsigned int &i) const;
+    /**
+     * Returns the number of elements within the table
+     */
+    __device__ __forceinline__ unsigned int size() const { return length; }
+};
+
+template<typename T>
+__device__ __forceinline__ T DeviceEnvironmentTable<T>::operator[](const unsigned int &i) const {
+#if !defined(SEATBELTS) || SEATBELTS
+    if (i >= length) {
+        DTHROW("Environment table index %u is out of bounds (length %u).\n", i, length);
+        return {};
+    } else if (!ptr) {
+        return {};
+    }
+#endif
+    return ptr[i];
+}
+
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_RUNTIME_UTILITY_DEVICEENVIRONMENTTABLE_CUH_
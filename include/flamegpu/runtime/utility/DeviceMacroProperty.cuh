@@ -0,0 +1,165 @@
+#ifndef INCLUDE_FLAMEGPU_RUNTIME_UTILITY_DEVICEMACROPROPERTY_CUH_
+#define INCLUDE_FLAMEGPU_RUNTIME_UTILITY_DEVICEMACROPROPERTY_CUH_
+
+#include "flamegpu/exception/FLAMEGPUDeviceException.cuh"
+
+namespace flamegpu {
+
+/**
+ * Device handle to (a sub-array of) an environment macro property
+ *
+ * Macro properties are multi-dimensional arrays stored in global memory (EnvironmentDescription::newMacroProperty())
+ * Each use of operator[] removes the outermost dimension, once all dimensions have been indexed the element can be read or atomically updated
+ * @tparam T Type of the macro property
+ * @tparam I Length of the 1st dimension
+ * @tparam J Length of the 2nd dimension
+ * @tparam K Length of the 3rd dimension
+ * @tparam W Length of the 4th dimension
+ * @note Updates are performed with CUDA atomics, so only types supported by the corresponding atomic function may be used
+ * e.g. operator+= supports int, unsigned int, unsigned long long int, float and double (SM60+), min()/max() do not support floating point types.
+ * @note Reads are not ordered with respect to atomic updates made by other threads within the same agent function
+ */
+template<typename T, unsigned int I = 1, unsigned int J = 1, unsigned int K = 1, unsigned int W = 1>
+class DeviceMacroProperty {
+    /**
+     * Pointer to the first element of the (sub-)array within device memory
+     */
+    T *ptr;
+
+ public:
+    /**
+     * Constructor
+     * @param _ptr Pointer to the first element of the (sub-)array within device memory
+     */
+    __device__ __forceinline__ explicit DeviceMacroProperty(T *_ptr)
+        : ptr(_ptr) { }
+    /**
+     * Returns a handle to the sub-array at the specified index of the outermost dimension
+     * @param i Index within the outermost dimension
+     * @throws exception::DeviceError If i is out of bounds (flamegpu must be built with SEATBELTS enabled for device error checking)
+     */
+    __device__ __forceinline__ DeviceMacroProperty<T, J, K, W, 1> operator[](const unsigned int &i) const;
+    /**
+     * Returns the value of the element
+     * @note Only available once all dimensions have been indexed
+     */
+    __device__ __forceinline__ operator T() const;
+    /**
+     * Atomically adds val to the element
+     * @param val The value to add
+     */
+    __device__ __forceinline__ DeviceMacroProperty &operator+=(const T &val);
+    /**
+     * Atomically subtracts val from the element
+     * @param val The value to subtract
+     */
+    __device__ __forceinline__ DeviceMacroProperty &operator-=(const T &val);
+    /**
+     * Atomically sets the element to the minimum of its value and val
+     * @param val The value to compare against
+     * @return The value of the element prior to the update
+     */
+    __device__ __forceinline__ T min(const T &val);
+    /**
+     * Atomically sets the element to the maximum of its value and val
+     * @param val The value to compare against
+     * @return The value of the element prior to the update
+     */
+    __device__ __forceinline__ T max(const T &val);
+    /**
+     * Atomically replaces the value of the element with val
+     * @param val The new value
+     * @return The value of the element prior to the update
+     */
+    __device__ __forceinline__ T exchange(const T &val);
+    /**
+     * Atomically replaces the value of the element with val, if it's current value equals compare
+     * @param compare The value to compare against
+     * @param val The new value
+     * @return The value of the element prior to the (attempted) update
+     */
+    __device__ __forceinline__ T CAS(const T &compare, const T &val);
+};
+
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W>
+__device__ __forceinline__ DeviceMacroProperty<T, J, K, W, 1> DeviceMacroProperty<T, I, J, K, W>::operator[](const unsigned int &i) const {
+#if !defined(SEATBELTS) || SEATBELTS
+    if (i >= I) {
+        DTHROW("Environment macro property index %u is out of bounds (length %u).\n", i, I);
+        return DeviceMacroProperty<T, J, K, W, 1>(nullptr);
+    } else if (!ptr) {
+        return DeviceMacroProperty<T, J, K, W, 1>(nullptr);
+    }
+#endif
+    return DeviceMacroProperty<T, J, K, W, 1>(ptr + static_cast<size_t>(i) * J * K * W);
+}
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W>
+__device__ __forceinline__ DeviceMacroProperty<T, I, J, K, W>::operator T() const {
+    static_assert(I == 1 && J == 1 && K == 1 && W == 1, "Environment macro property must be fully indexed before it can be read.");
+#if !defined(SEATBELTS) || SEATBELTS
+    if (!ptr)
+        return {};
+#endif
+    return *ptr;
+}
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W>
+__device__ __forceinline__ DeviceMacroProperty<T, I, J, K, W> &DeviceMacroProperty<T, I, J, K, W>::operator+=(const T &val) {
+    static_assert(I == 1 && J == 1 && K == 1 && W == 1, "Environment macro property must be fully indexed before it can be updated.");
+#if !defined(SEATBELTS) || SEATBELTS
+    if (!ptr)
+        return *this;
+#endif
+    atomicAdd(ptr, val);
+    return *this;
+}
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W>
+__device__ __forceinline__ DeviceMacroProperty<T, I, J, K, W> &DeviceMacroProperty<T, I, J, K, W>::operator-=(const T &val) {
+    static_assert(I == 1 && J == 1 && K == 1 && W == 1, "Environment macro property must be fully indexed before it can be updated.");
+#if !defined(SEATBELTS) || SEATBELTS
+    if (!ptr)
+        return *this;
+#endif
+    // Unsigned subtraction wraps, so this is also correct for unsigned types
+    atomicAdd(ptr, static_cast<T>(static_cast<T>(0) - val));
+    return *this;
+}
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W>
+__device__ __forceinline__ T DeviceMacroProperty<T, I, J, K, W>::min(const T &val) {
+    static_assert(I == 1 && J == 1 && K == 1 && W == 1, "Environment macro property must be fully indexed before it can be updated.");
+#if !defined(SEATBELTS) || SEATBELTS
+    if (!ptr)
+        return {};
+#endif
+    return atomicMin(ptr, val);
+}
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W>
+__device__ __forceinline__ T DeviceMacroProperty<T, I, J, K, W>::max(const T &val) {
+    static_assert(I == 1 && J == 1 && K == 1 && W == 1, "Environment macro property must be fully indexed before it can be updated.");
+#if !defined(SEATBELTS) || SEATBELTS
+    if (!ptr)
+        return {};
+#endif
+    return atomicMax(ptr, val);
+}
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W>
+__device__ __forceinline__ T DeviceMacroProperty<T, I, J, K, W>::exchange(const T &val) {
+    static_assert(I == 1 && J == 1 && K == 1 && W == 1, "Environment macro property must be fully indexed before it can be updated.");
+#if !defined(SEATBELTS) || SEATBELTS
+    if (!ptr)
+        return {};
+#endif
+    return atomicExch(ptr, val);
+}
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W>
+__device__ __forceinline__ T DeviceMacroProperty<T, I, J, K, W>::CAS(const T &compare, const T &val) {
+    static_assert(I == 1 && J == 1 && K == 1 && W == 1, "Environment macro property must be fully indexed before it can be updated.");
+#if !defined(SEATBELTS) || SEATBELTS
+    if (!ptr)
+        return {};
+#endif
+    return atomicCAS(ptr, compare, val);
+}
+
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_RUNTIME_UTILITY_DEVICEMACROPROPERTY_CUH_
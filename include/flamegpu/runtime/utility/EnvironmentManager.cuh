@@ -3,6 +3,7 @@
 
 #include <cuda_runtime.h>
 
+#include <climits>
 #include <cstddef>
 #include <unordered_map>
 #include <array>
@@ -42,6 +43,9 @@ class JSONStateReader_impl;
 /**
  * Singleton manager for managing environment properties storage in constant memory
  * This is an internal class, that should not be accessed directly by modellers
+ * The properties of every CUDASimulation instance share a single process-wide __constant__ buffer, each instance's properties occupy disjoint bytes
+ * Only the changed byte ranges are uploaded by updateDevice(), so instances do not overwrite each other's properties
+ * Instances are not given private device storage, so device_mutex is still shared by every instance, to prevent defragment() moving properties whilst kernels execute
  * @see EnvironmentDescription For describing the initial state of a model's environment properties
  * @see AgentEnvironment For reading environment properties during agent functions on the device
  * @see HostEnvironment For accessing environment properties during host functions
@@ -183,6 +187,28 @@ class EnvironmentManager {
         const std::type_index type;
         ptrdiff_t rtc_offset;
     };
+    /**
+     * Index of a PropertyWrite which replaces every element of the property
+     */
+    static const size_type ALL_ELEMENTS = UINT_MAX;
+    /**
+     * A single staged write to an environment property, or an element of an environment property array
+     * @see setProperties()
+     */
+    struct PropertyWrite {
+        /**
+         * @param _name Name of the property
+         * @param _value New value of the property, or element
+         * @param _index Index of the element to write, ALL_ELEMENTS writes the whole property
+         */
+        PropertyWrite(const std::string &_name, const util::Any &_value, const size_type &_index = ALL_ELEMENTS)
+            : name(_name)
+            , value(_value)
+            , index(_index) { }
+        std::string name;
+        util::Any value;
+        size_type index;
+    };
     /**
      * Struct used by rtc_caches
      * Represents a personalised constant cache buffer for a single CUDASimulation instance
@@ -490,6 +516,19 @@ class EnvironmentManager {
      * @todo This is not a particularly efficient implementation, as it updates them all individually.
      */
     void resetModel(const unsigned int &instance_id, const EnvironmentDescription &desc);
+    /**
+     * Applies several property writes under a single lock
+     * Every write is validated before any are applied, so if an exception is thrown the environment is unchanged
+     * The changed bytes are coalesced, so the device copy is brought up to date by the next updateDevice()
+     * @param instance_id instance_id of the CUDASimulation instance the properties are attached to
+     * @param writes The writes to apply, in order
+     * @param ignoreConst If true, properties marked as const may be written (e.g. by RunPlan overrides, prior to simulation)
+     * @throws exception::InvalidEnvProperty If a property of a write's name does not exist
+     * @throws exception::InvalidEnvPropertyType If a write's type does not match the property
+     * @throws exception::ReadOnlyEnvProperty If a property is marked as const, and ignoreConst is false
+     * @throws exception::OutOfBoundsException If a write's length or index does not match the property
+     */
+    void setProperties(const unsigned int &instance_id, const std::vector<PropertyWrite> &writes, const bool &ignoreConst = false);
     /**
      * Returns whether the named env property exists
      * @param name name used for accessing the property
@@ -723,19 +762,28 @@ class EnvironmentManager {
      */
     bool deviceInitialised;
     /*
-     * Convenience fn for managing deviceRequiresUpdate
+     * Convenience fn for managing deviceRequiresUpdate and dirty_ranges
      * @param instance_id Sim instance id, UINT_MAX sets all
+     * @param offset Offset into hc_buffer of the first changed byte
+     * @param length Number of changed bytes, 0 if only the instance's flags require setting
      */
-    void setDeviceRequiresUpdateFlag(const unsigned int &instance_id = UINT_MAX);
+    void setDeviceRequiresUpdateFlag(const unsigned int &instance_id = UINT_MAX, const ptrdiff_t &offset = 0, const size_t &length = MAX_BUFFER_SIZE);
+    /**
+     * Convenience fn for managing deviceRequiresUpdate and dirty_ranges, when several ranges have changed
+     * @param instance_id Sim instance id
+     * @param ranges Byte ranges of hc_buffer which have changed
+     */
+    void setDeviceRequiresUpdateFlag(const unsigned int &instance_id, const std::vector<OffsetLen> &ranges);
+    /**
+     * Appends a range to dirty_ranges, unless it is already covered
+     * @note You must acquire a lock on deviceRequiresUpdate_mutex before calling this method
+     */
+    void addDirtyRange(const ptrdiff_t &offset, const size_t &length);
     /**
      * These flags control what happens when updateDevice() is called
      * Their primary purpose is to cause the device memory to updated as lazily as possible
      */
     struct EnvUpdateFlags {
-        /**
-         * Update the device constant cache for main C env var storage
-         */
-        bool c_update_required = true;
         /**
          * Update the RTC environment cache for a specific CUDASimulation instance
          */
@@ -752,6 +800,16 @@ class EnvironmentManager {
      * sim_instance_id:(C needs update, RTC needs update)
      */
     std::unordered_map<unsigned int, EnvUpdateFlags> deviceRequiresUpdate;
+    /**
+     * Byte ranges of hc_buffer which have changed since c_buffer was last updated
+     * c_buffer is shared by all instances, so the first instance to call updateDevice() uploads every pending range
+     * @note Protected by deviceRequiresUpdate_mutex
+     */
+    std::vector<OffsetLen> dirty_ranges;
+    /**
+     * Dirty ranges separated by a gap of at most this many bytes are uploaded as a single copy
+     */
+    static const size_t DIRTY_RANGE_MERGE_GAP = 256;
     /**
      * Function to initialise device-side portions of the environment manager
      */
@@ -767,12 +825,14 @@ class EnvironmentManager {
     std::unique_lock<std::shared_timed_mutex> getUniqueLock() const { return std::unique_lock<std::shared_timed_mutex>(mutex); }
     /**
      * This mutex exists to stop defrag being called, between curve being updated, and an agent function executing
+     * Agent functions of every instance hold it shared, so they do not block each other
+     * It is only held unique by defragment(), when properties are added or freed as instances are initialised or freed
      */
     mutable std::shared_timed_mutex device_mutex;
     std::shared_lock<std::shared_timed_mutex> getDeviceSharedLock() const { return std::shared_lock<std::shared_timed_mutex>(device_mutex); }
     std::unique_lock<std::shared_timed_mutex> getDeviceUniqueLock() const { return std::unique_lock<std::shared_timed_mutex>(device_mutex); }
     /**
-     * This mutex only protects deviceRequiresUpdate map
+     * This mutex only protects deviceRequiresUpdate map and dirty_ranges
      */
     mutable std::shared_timed_mutex deviceRequiresUpdate_mutex;
     /**
@@ -876,7 +936,7 @@ T EnvironmentManager::setProperty(const NamePair &name, const T &value) {
     // Do rtc too
     updateRTCValue(name);
     // Set device update flag
-    setDeviceRequiresUpdateFlag(name.first);
+    setDeviceRequiresUpdateFlag(name.first, buffOffset, sizeof(T));
 
     return rtn;
 }
@@ -919,7 +979,7 @@ std::array<T, N> EnvironmentManager::setProperty(const NamePair &name, const std
     // Do rtc too
     updateRTCValue(name);
     // Set device update flag
-    setDeviceRequiresUpdateFlag(name.first);
+    setDeviceRequiresUpdateFlag(name.first, buffOffset, N * sizeof(T));
 
     return rtn;
 }
@@ -968,7 +1028,7 @@ std::vector<T> EnvironmentManager::setPropertyArray(const NamePair& name, const
     // Do rtc too
     updateRTCValue(name);
     // Set device update flag
-    setDeviceRequiresUpdateFlag(name.first);
+    setDeviceRequiresUpdateFlag(name.first, buffOffset, value.size() * sizeof(T));
 
     return rtn;
 }
@@ -1009,7 +1069,7 @@ T EnvironmentManager::setProperty(const NamePair &name, const size_type &index,
     // Do rtc too
     updateRTCValue(name);
     // Set device update flag
-    setDeviceRequiresUpdateFlag(name.first);
+    setDeviceRequiresUpdateFlag(name.first, buffOffset, sizeof(T));
 
     return rtn;
 }
@@ -0,0 +1,105 @@
+#ifndef INCLUDE_FLAMEGPU_RUNTIME_UTILITY_ENVIRONMENTTABLECACHE_H_
+#define INCLUDE_FLAMEGPU_RUNTIME_UTILITY_ENVIRONMENTTABLECACHE_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+
+namespace flamegpu {
+namespace detail {
+
+/**
+ * A read-only environment table's data, uploaded to device memory
+ * The device memory is released when the last reference is destroyed
+ * @see EnvironmentDescription::newTable()
+ */
+struct EnvironmentTable {
+    /**
+     * @param _d_ptr Device allocation holding the table
+     * @param _length Length of the table in bytes
+     * @param _device_id Device which holds the allocation
+     * @param _modified Last modification time of the file when it was uploaded
+     */
+    EnvironmentTable(void *_d_ptr, const size_t &_length, const int &_device_id, const int64_t &_modified)
+        : d_ptr(_d_ptr)
+        , length(_length)
+        , device_id(_device_id)
+        , modified(_modified) { }
+    ~EnvironmentTable();
+    EnvironmentTable(const EnvironmentTable &) = delete;
+    EnvironmentTable &operator=(const EnvironmentTable &) = delete;
+    /**
+     * Pointer to the table within device memory
+     * Set to nullptr if the device is reset whilst the table is still referenced
+     */
+    void *d_ptr;
+    /**
+     * Length of the table in bytes
+     */
+    const size_t length;
+    /**
+     * Device which holds the allocation
+     */
+    const int device_id;
+    /**
+     * Last modification time of the file when it was uploaded
+     * The upload is only reused whilst the file's length and modification time are unchanged
+     */
+    const int64_t modified;
+};
+
+/**
+ * Device-wide cache of read-only environment tables
+ *
+ * Each table file is memory mapped and uploaded to a device the first time it is requested,
+ * subsequent requests on the same device share the upload for as long as any reference remains alive.
+ * If the file's length or modification time has changed since it was uploaded, it is uploaded again.
+ * This allows every CUDASimulation of a CUDAEnsemble to share a single copy of a large table.
+ */
+class EnvironmentTableCache {
+ public:
+    /**
+     * Returns the named file's table on the current device, uploading it if it is not already resident, or the file has changed
+     * @param file_path Path to the binary file which holds the table
+     * @throws exception::InvalidFilePath If the file cannot be opened
+     * @throws exception::InvalidInputFile If the file is empty, or cannot be mapped
+     */
+    std::shared_ptr<const EnvironmentTable> acquire(const std::string &file_path);
+    /**
+     * Returns whether any table is still referenced on the current device
+     */
+    bool hasResidentTables();
+    /**
+     * Forgets all resident tables, without releasing their device memory
+     * This should be called after cudaDeviceReset(), as the device memory has already been released
+     */
+    void purge();
+    /**
+     * Returns the EnvironmentTableCache singleton for the current device
+     */
+    static EnvironmentTableCache &getInstance();
+
+ private:
+    EnvironmentTableCache() = default;
+    /**
+     * Resident tables, by device and file path
+     */
+    std::map<std::pair<int, std::string>, std::weak_ptr<EnvironmentTable>> tables;
+    /**
+     * Protects tables, as concurrent ensemble runs may request the same table
+     * It is also held whilst a table is uploaded, so the same file is never uploaded twice
+     */
+    std::mutex mutex;
+    /**
+     * Protects the map of per device instances
+     */
+    static std::mutex instance_mutex;
+};
+
+}  // namespace detail
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_RUNTIME_UTILITY_ENVIRONMENTTABLECACHE_H_
@@ -13,6 +13,8 @@
 
 #include "flamegpu/gpu/detail/CUDAErrorChecking.cuh"
 #include "flamegpu/runtime/utility/EnvironmentManager.cuh"
+#include "flamegpu/runtime/utility/HostEnvironmentBatch.cuh"
+#include "flamegpu/gpu/CUDAMacroEnvironment.h"
 
 namespace flamegpu {
 
@@ -33,11 +35,15 @@ class HostEnvironment {
     /**
      * Constructor, to be called by HostAPI
      */
-    explicit HostEnvironment(const unsigned int &instance_id);
+    HostEnvironment(const unsigned int &instance_id, CUDAMacroEnvironment &macro_env);
     /**
      * Provides access to EnvironmentManager singleton
      */
     EnvironmentManager &env_mgr;
+    /**
+     * Provides access to the CUDASimulation's environment macro properties
+     */
+    CUDAMacroEnvironment &macro_env;
     /**
      * Access to instance id of the CUDASimulation
      * This is used to augment all variable names
@@ -132,6 +138,68 @@ class HostEnvironment {
     template<typename T>
     std::vector<T> setPropertyArray(const std::string &name, const std::vector<T> &value) const;
 #endif
+    /**
+     * Returns a host handle to an environment macro property
+     * Elements are read and written via a host copy, changes are uploaded once all handles to the macro property have been destroyed
+     * @param name name used for accessing the macro property
+     * @tparam T Type of the macro property
+     * @tparam I Length of the macro property's 1st dimension
+     * @tparam J Length of the macro property's 2nd dimension
+     * @tparam K Length of the macro property's 3rd dimension
+     * @tparam W Length of the macro property's 4th dimension
+     * @throws exception::InvalidEnvProperty If a macro property of the name does not exist
+     * @throws exception::InvalidEnvPropertyType If T or the dimensions do not match the macro property
+     * @see EnvironmentDescription::newMacroProperty()
+     */
+    template<typename T, unsigned int I = 1, unsigned int J = 1, unsigned int K = 1, unsigned int W = 1>
+    HostMacroProperty<T, I, J, K, W> getMacroProperty(const std::string &name) const;
+    /**
+     * Returns a copy of every element of an environment macro property, flattened in row-major order
+     * @param name name used for accessing the macro property
+     * @tparam T Type of the macro property
+     * @throws exception::InvalidEnvProperty If a macro property of the name does not exist
+     * @throws exception::InvalidEnvPropertyType If T does not match the macro property
+     */
+    template<typename T>
+    std::vector<T> getMacroPropertyData(const std::string &name) const;
+    /**
+     * Overwrites every element of an environment macro property, with a single host to device copy
+     * @param name name used for accessing the macro property
+     * @param data The new values of the macro property, flattened in row-major order
+     * @tparam T Type of the macro property
+     * @throws exception::InvalidEnvProperty If a macro property of the name does not exist
+     * @throws exception::InvalidEnvPropertyType If T or the length of data does not match the macro property
+     */
+    template<typename T>
+    void setMacroPropertyData(const std::string &name, const std::vector<T> &data) const;
+    /**
+     * Returns a copy of every cell of an environment field, in x-fastest order
+     * @param name name used for accessing the field
+     * @throws exception::InvalidEnvProperty If a field of the name does not exist
+     * @see EnvironmentDescription::newField()
+     */
+    std::vector<float> getFieldData(const std::string &name) const;
+    /**
+     * Overwrites every cell of an environment field, with a single host to device copy
+     * @param name name used for accessing the field
+     * @param data The new values of the field, in x-fastest order
+     * @throws exception::InvalidEnvProperty If a field of the name does not exist
+     * @throws exception::InvalidArgument If the length of data does not match the field
+     */
+    void setFieldData(const std::string &name, const std::vector<float> &data) const;
+    /**
+     * Returns a new transaction, which applies many property writes together when it is committed
+     * This takes a single lock and produces a single coalesced device update,
+     * rather than the lock and update of each individual setProperty() call
+     * @code
+     * HostEnvironmentBatch batch = FLAMEGPU->environment.batch();
+     * batch.setProperty<float>("a", 1.0f);
+     * batch.setProperty<int, 3>("b", {1, 2, 3});
+     * batch.commit();
+     * @endcode
+     * @see HostEnvironmentBatch
+     */
+    HostEnvironmentBatch batch() const { return HostEnvironmentBatch(env_mgr, instance_id); }
 };
 
 /**
@@ -194,6 +262,41 @@ std::vector<T> HostEnvironment::getPropertyArray(const std::string& name) const
 }
 #endif  // SWIG
 
+/**
+ * Macro properties
+ */
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W>
+HostMacroProperty<T, I, J, K, W> HostEnvironment::getMacroProperty(const std::string &name) const {
+    return macro_env.getProperty<T, I, J, K, W>(name);
+}
+template<typename T>
+std::vector<T> HostEnvironment::getMacroPropertyData(const std::string &name) const {
+    const CUDAMacroEnvironment::MacroEnvProp &prop = macro_env.getPropertyInfo(name);
+    if (prop.type != std::type_index(typeid(T))) {
+        THROW exception::InvalidEnvPropertyType("Environment macro property ('%s') type (%s) does not match template argument T (%s), "
+            "in HostEnvironment::getMacroPropertyData().",
+            name.c_str(), prop.type.name(), typeid(T).name());
+    }
+    std::vector<T> rtn(prop.elementCount());
+    macro_env.getPropertyData(name, rtn.data());
+    return rtn;
+}
+template<typename T>
+void HostEnvironment::setMacroPropertyData(const std::string &name, const std::vector<T> &data) const {
+    const CUDAMacroEnvironment::MacroEnvProp &prop = macro_env.getPropertyInfo(name);
+    if (prop.type != std::type_index(typeid(T))) {
+        THROW exception::InvalidEnvPropertyType("Environment macro property ('%s') type (%s) does not match template argument T (%s), "
+            "in HostEnvironment::setMacroPropertyData().",
+            name.c_str(), prop.type.name(), typeid(T).name());
+    }
+    if (data.size() != prop.elementCount()) {
+        THROW exception::InvalidEnvPropertyType("Environment macro property ('%s') contains %u elements, but %u were provided, "
+            "in HostEnvironment::setMacroPropertyData().",
+            name.c_str(), static_cast<unsigned int>(prop.elementCount()), static_cast<unsigned int>(data.size()));
+    }
+    macro_env.setPropertyData(name, data.data());
+}
+
 }  // namespace flamegpu
 
 #endif  // INCLUDE_FLAMEGPU_RUNTIME_UTILITY_HOSTENVIRONMENT_CUH_
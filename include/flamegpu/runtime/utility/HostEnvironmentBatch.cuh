@@ -0,0 +1,151 @@
+#ifndef INCLUDE_FLAMEGPU_RUNTIME_UTILITY_HOSTENVIRONMENTBATCH_CUH_
+#define INCLUDE_FLAMEGPU_RUNTIME_UTILITY_HOSTENVIRONMENTBATCH_CUH_
+
+#include <array>
+#include <string>
+#include <typeindex>
+#include <vector>
+
+#include "flamegpu/exception/FLAMEGPUException.h"
+#include "flamegpu/runtime/utility/EnvironmentManager.cuh"
+#include "flamegpu/util/Any.h"
+
+namespace flamegpu {
+
+class HostEnvironment;
+class SimRunner;
+
+/**
+ * A transaction of environment property writes, created by HostEnvironment::batch()
+ *
+ * Writes are staged on the host, and applied together by commit() under a single lock of EnvironmentManager,
+ * producing a single coalesced update of the device's copy of the environment
+ * Writes which have not been committed when the batch is destroyed are discarded
+ * @note Staged writes are not visible to HostEnvironment::getProperty() until they are committed
+ */
+class HostEnvironmentBatch {
+    /**
+     * This class can only be constructed by HostEnvironment
+     */
+    friend class HostEnvironment;
+    /**
+     * Applies RunPlan property overrides, which are already type erased
+     */
+    friend class SimRunner;
+
+ public:
+    /**
+     * Stages a write to an environment property
+     * @param name name used for accessing the property
+     * @param value to set the property
+     * @tparam T Type of the environment property
+     * @throws exception::ReservedName If name begins with '_'
+     */
+    template<typename T>
+    void setProperty(const std::string &name, const T &value);
+    /**
+     * Stages a write to an environment property array
+     * @param name name used for accessing the property array
+     * @param value to set the property array
+     * @tparam T Type of the elements of the environment property array
+     * @tparam N Length of the environment property array
+     * @throws exception::ReservedName If name begins with '_'
+     */
+    template<typename T, EnvironmentManager::size_type N>
+    void setProperty(const std::string &name, const std::array<T, N> &value);
+    /**
+     * Stages a write to an element of an environment property array
+     * @param name name used for accessing the property array
+     * @param index element within the environment property array to set
+     * @param value to set the element of the property array
+     * @tparam T Type of the elements of the environment property array
+     * @throws exception::ReservedName If name begins with '_'
+     */
+    template<typename T>
+    void setProperty(const std::string &name, const EnvironmentManager::size_type &index, const T &value);
+#ifdef SWIG
+    /**
+     * Stages a write to an environment property array
+     * @param name name used for accessing the property array
+     * @param value to set the property array
+     * @tparam T Type of the elements of the environment property array
+     * @throws exception::ReservedName If name begins with '_'
+     */
+    template<typename T>
+    void setPropertyArray(const std::string &name, const std::vector<T> &value);
+#endif
+    /**
+     * Applies every staged write, and clears the batch
+     * The writes are validated before any are applied, so if an exception is thrown no write has been applied
+     * @throws exception::InvalidEnvProperty If a property of a staged name does not exist
+     * @throws exception::InvalidEnvPropertyType If a staged type does not match the property
+     * @throws exception::ReadOnlyEnvProperty If a property is marked as const
+     * @throws exception::OutOfBoundsException If a staged length or index does not match the property
+     */
+    void commit();
+    /**
+     * Discards every staged write
+     */
+    void discard() { writes.clear(); }
+    /**
+     * Returns the number of staged writes
+     */
+    size_t size() const { return writes.size(); }
+
+ private:
+    /**
+     * Constructor, to be called by HostEnvironment
+     * @param _env_mgr The EnvironmentManager holding the properties
+     * @param _instance_id Instance id of the CUDASimulation which owns the properties
+     */
+    HostEnvironmentBatch(EnvironmentManager &_env_mgr, const unsigned int &_instance_id)
+        : env_mgr(_env_mgr)
+        , instance_id(_instance_id) { }
+    /**
+     * Stages a type erased write of a whole property
+     * @param name name used for accessing the property
+     * @param value to set the property
+     */
+    void stageProperty(const std::string &name, const util::Any &value) { writes.emplace_back(name, value); }
+    /**
+     * Throws exception::ReservedName if name begins with '_'
+     */
+    static void checkName(const std::string &name);
+    EnvironmentManager &env_mgr;
+    const unsigned int instance_id;
+    /**
+     * If true, commit() may write properties marked as const
+     */
+    bool ignore_const = false;
+    /**
+     * Staged writes, in the order they were made
+     */
+    std::vector<EnvironmentManager::PropertyWrite> writes;
+};
+
+template<typename T>
+void HostEnvironmentBatch::setProperty(const std::string &name, const T &value) {
+    checkName(name);
+    writes.emplace_back(name, util::Any(&value, sizeof(T), typeid(T), 1));
+}
+template<typename T, EnvironmentManager::size_type N>
+void HostEnvironmentBatch::setProperty(const std::string &name, const std::array<T, N> &value) {
+    checkName(name);
+    writes.emplace_back(name, util::Any(value.data(), sizeof(T) * N, typeid(T), N));
+}
+template<typename T>
+void HostEnvironmentBatch::setProperty(const std::string &name, const EnvironmentManager::size_type &index, const T &value) {
+    checkName(name);
+    writes.emplace_back(name, util::Any(&value, sizeof(T), typeid(T), 1), index);
+}
+#ifdef SWIG
+template<typename T>
+void HostEnvironmentBatch::setPropertyArray(const std::string &name, const std::vector<T> &value) {
+    checkName(name);
+    writes.emplace_back(name, util::Any(value.data(), sizeof(T) * value.size(), typeid(T), static_cast<unsigned int>(value.size())));
+}
+#endif  // SWIG
+
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_RUNTIME_UTILITY_HOSTENVIRONMENTBATCH_CUH_
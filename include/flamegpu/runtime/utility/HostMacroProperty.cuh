@@ -0,0 +1,166 @@
+#ifndef INCLUDE_FLAMEGPU_RUNTIME_UTILITY_HOSTMACROPROPERTY_CUH_
+#define INCLUDE_FLAMEGPU_RUNTIME_UTILITY_HOSTMACROPROPERTY_CUH_
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "flamegpu/exception/FLAMEGPUException.h"
+
+namespace flamegpu {
+
+/**
+ * Host copy of an environment macro property, shared by all HostMacroProperty handles to the macro property
+ * The device copy is downloaded on construction, and uploaded on destruction if it has been changed
+ * This allows a host function to read and write many elements, without a device transfer per element
+ */
+struct HostMacroProperty_MetaData {
+    /**
+     * Allocates a host copy of the macro property, and downloads it from the device
+     * @param _d_base_ptr Pointer to the macro property within device memory
+     * @param _elements Length of each of the macro property's 4 dimensions
+     * @param _type_size Size of the macro property's base type
+     * @param _name Name of the macro property, used for error messages
+     */
+    HostMacroProperty_MetaData(void *_d_base_ptr, const std::array<unsigned int, 4> &_elements, const size_t &_type_size, const std::string &_name);
+    /**
+     * Uploads the host copy to the device if it has been changed, and releases it
+     */
+    ~HostMacroProperty_MetaData();
+    /**
+     * Copies the device copy to the host copy
+     */
+    void download();
+    /**
+     * Copies the host copy to the device copy, if it has been changed
+     */
+    void upload();
+    /**
+     * Returns the total number of elements
+     */
+    size_t elementCount() const { return static_cast<size_t>(elements[0]) * elements[1] * elements[2] * elements[3]; }
+    char *h_base_ptr;
+    void *d_base_ptr;
+    std::array<unsigned int, 4> elements;
+    size_t type_size;
+    std::string name;
+    /**
+     * Set when the host copy is written, cleared when it is uploaded
+     */
+    bool has_changed;
+};
+
+/**
+ * Host handle to (a sub-array of) an environment macro property
+ *
+ * Each use of operator[] removes the outermost dimension, once all dimensions have been indexed the element can be read or written
+ * Handles share a host copy of the macro property, which is uploaded once the last handle has been destroyed,
+ * so handles should not be held beyond the end of the host function which created them.
+ * @tparam T Type of the macro property
+ * @tparam I Length of the 1st dimension
+ * @tparam J Length of the 2nd dimension
+ * @tparam K Length of the 3rd dimension
+ * @tparam W Length of the 4th dimension
+ * @see HostEnvironment::getMacroProperty()
+ */
+template<typename T, unsigned int I = 1, unsigned int J = 1, unsigned int K = 1, unsigned int W = 1>
+class HostMacroProperty {
+    /**
+     * The shared host copy of the macro property
+     */
+    std::shared_ptr<HostMacroProperty_MetaData> metadata;
+    /**
+     * Offset of the first element of the (sub-)array, from the start of the macro property
+     */
+    size_t offset;
+    /**
+     * Returns a pointer to the first element of the (sub-)array within the host copy
+     */
+    T *data() const { return reinterpret_cast<T*>(metadata->h_base_ptr) + offset; }
+
+ public:
+    /**
+     * Constructor
+     * @param _metadata The shared host copy of the macro property
+     * @param _offset Offset of the first element of the (sub-)array, from the start of the macro property
+     */
+    explicit HostMacroProperty(const std::shared_ptr<HostMacroProperty_MetaData> &_metadata, const size_t &_offset = 0)
+        : metadata(_metadata)
+        , offset(_offset) { }
+    /**
+     * Returns a handle to the sub-array at the specified index of the outermost dimension
+     * @param i Index within the outermost dimension
+     * @throws exception::OutOfBoundsException If i is out of bounds
+     */
+    HostMacroProperty<T, J, K, W, 1> operator[](const unsigned int &i) const;
+    /**
+     * Returns the value of the element
+     * @note Only available once all dimensions have been indexed
+     */
+    operator T() const;
+    /**
+     * Sets the value of the element
+     * @param val The new value
+     * @note Only available once all dimensions have been indexed
+     */
+    HostMacroProperty &operator=(const T &val);
+    /**
+     * Adds val to the element
+     * @param val The value to add
+     */
+    HostMacroProperty &operator+=(const T &val);
+    /**
+     * Subtracts val from the element
+     * @param val The value to subtract
+     */
+    HostMacroProperty &operator-=(const T &val);
+    /**
+     * Sets every element of the (sub-)array to zero
+     */
+    void zero();
+};
+
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W>
+HostMacroProperty<T, J, K, W, 1> HostMacroProperty<T, I, J, K, W>::operator[](const unsigned int &i) const {
+    if (i >= I) {
+        THROW exception::OutOfBoundsException("Index %u is out of bounds of environment macro property '%s' dimension (length %u), "
+            "in HostMacroProperty::operator[]().\n", i, metadata->name.c_str(), I);
+    }
+    return HostMacroProperty<T, J, K, W, 1>(metadata, offset + static_cast<size_t>(i) * J * K * W);
+}
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W>
+HostMacroProperty<T, I, J, K, W>::operator T() const {
+    static_assert(I == 1 && J == 1 && K == 1 && W == 1, "Environment macro property must be fully indexed before it can be read.");
+    return *data();
+}
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W>
+HostMacroProperty<T, I, J, K, W> &HostMacroProperty<T, I, J, K, W>::operator=(const T &val) {
+    static_assert(I == 1 && J == 1 && K == 1 && W == 1, "Environment macro property must be fully indexed before it can be written.");
+    *data() = val;
+    metadata->has_changed = true;
+    return *this;
+}
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W>
+HostMacroProperty<T, I, J, K, W> &HostMacroProperty<T, I, J, K, W>::operator+=(const T &val) {
+    static_assert(I == 1 && J == 1 && K == 1 && W == 1, "Environment macro property must be fully indexed before it can be written.");
+    *data() += val;
+    metadata->has_changed = true;
+    return *this;
+}
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W>
+HostMacroProperty<T, I, J, K, W> &HostMacroProperty<T, I, J, K, W>::operator-=(const T &val) {
+    static_assert(I == 1 && J == 1 && K == 1 && W == 1, "Environment macro property must be fully indexed before it can be written.");
+    *data() -= val;
+    metadata->has_changed = true;
+    return *this;
+}
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W>
+void HostMacroProperty<T, I, J, K, W>::zero() {
+    memset(data(), 0, static_cast<size_t>(I) * J * K * W * sizeof(T));
+    metadata->has_changed = true;
+}
+
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_RUNTIME_UTILITY_HOSTMACROPROPERTY_CUH_
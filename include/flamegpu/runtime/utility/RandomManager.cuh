@@ -1,12 +1,12 @@
 #ifndef INCLUDE_FLAMEGPU_RUNTIME_UTILITY_RANDOMMANAGER_CUH_
 #define INCLUDE_FLAMEGPU_RUNTIME_UTILITY_RANDOMMANAGER_CUH_
 
-#include <curand_kernel.h>
 #include <cstdint>
 #include <random>
 #include <string>
 
 #include "flamegpu/sim/Simulation.h"
+#include "flamegpu/runtime/utility/AgentRandom.cuh"
 
 namespace flamegpu {
 
@@ -16,7 +16,7 @@ class CUDASimulation;
 /**
  * Singleton manager for initialising simulation wide random with a common seed
  * This is an internal class, that should not be accessed directly by modellers
- * Manages the shared array of curand state use by agent functions
+ * Provides the keys of the counter-based random streams used by agent functions
  * Manages the random engine/s used by host functions
  * @see AgentRandom For random number generation during agent functions on the device
  * @see HostRandom For random number generation during host functions
@@ -31,45 +31,23 @@ class RandomManager {
      */
     friend void Simulation::applyConfig();
     /**
-     * Calls resize() during simulation execution to resize device random array
+     * Calls agentStream() and advanceSteps() during simulation execution
      */
     friend class CUDASimulation;  // bool CUDASimulation::step(const Simulation&)
  public:
-    /**
-     * Inherit size_type from include-public partner class
-     */
-    typedef unsigned int size_type;
     /**
      * Creates the random manager and calls reseed() with the return value from seedFromTime()
      */
     RandomManager();
-
-     ~RandomManager();
     /**
      * Utility for generating a psuesdo-random seed to pass to init
      */
     uint64_t seedFromTime();
     /**
      * Reseeds all owned random generators
-     * @note Can be called multiple times to reseed, doing so releases existing memory allocations
+     * @note Can be called multiple times to reseed
      */
     void reseed(const unsigned int &seed);
-    /**
-     * Resizes random array according to the rules:
-     *   while(length<_length)
-     *     length*=growthModifier
-     *   if(shrinkModifier<1.0)
-     *     while(length*shrinkModifier>_length)
-     *       length*=shrinkModifier
-     */
-    curandState *resize(const size_type &_length);
-    /**
-     * Accessors
-     */
-    void setGrowthModifier(float);
-    float getGrowthModifier();
-    void setShrinkModifier(float);
-    float getShrinkModifier();
     /**
      * Generates a random number with the provided distribution
      * @param distribution A distribution object defined by \<random\>
@@ -79,59 +57,34 @@ class RandomManager {
      */
     template<typename T, typename dist>
     T getDistribution(dist &distribution);
+    uint64_t seed();
     /**
-     * Returns length of curand state array currently allocated
+     * Returns the key of the random streams used by an agent function, or agent function condition, during a step
+     * Agent functions take no random state, so the same streams are produced regardless of launch order or concurrency
+     * @param step The step being executed
+     * @param layer Index of the layer executing the function, so a function executed in multiple layers draws distinct streams in each
+     * @param agent_name Name of the agent which owns the function
+     * @param func_name Name of the agent function
+     * @param condition If true, the streams of the agent function's condition are returned
+     * @note AgentRandom::Stream::keyed is returned false, the caller must set it if the agent has the internal variable RNG_KEY_VARIABLE_NAME
      */
-    size_type size();
-    uint64_t seed();
-    curandState *cudaRandomState();
+    AgentRandom::Stream agentStream(const unsigned int &step, const unsigned int &layer, const std::string &agent_name, const std::string &func_name, const bool &condition = false) const;
 
  private:
     /**
-     * Device array holding curand states
-     * They should always be initialised
-     */
-    curandState *d_random_state = nullptr;
-    /**
-     * Random seed used to initialise all currently allocated curand states
+     * Random seed used to key the agent function streams and seed the host generator
      */
     unsigned int mSeed = 0;
     /**
-     * Local copy of the length of d_random_state
-     */
-    size_type length = 0;
-    /**
-     * Minimum allocation length of d_random_state
-     */
-    const size_type min_length = 1024;
-    /**
-     * Rate at which d_random_state's length shrinks
-     * Must be in the range 0 < x <= 1.0
-     * A value of 1.0 means the curand array will never decrease in size 
-     */
-    float shrinkModifier = 1.0f;
-    /**
-     * Rate at which d_random_state's length grows
-     * Must be in greater than 1.0
-     */
-    float growthModifier = 1.5f;
-    /**
-     * Actually performs the resizing of the curand state array
-     * If shrinking, 'deallocated' curand states are backed up to host until next required,
-     *  this prevents them being reinitialised with the same seed.
-     */
-    void resizeDeviceArray(const size_type &_length);
-    /**
-     * Host copy of 'deallocated' curand states
-     * When the device array shrinks in size, shrunk away curand states are stored here
-     * @note h_max_random_state will be allocated to length h_max_random_size
-     * However, it will only be initialised from hd_random_size(aka length) onwards
+     * Added to the step of agent function streams
+     * Submodels are not reseeded between runs, instead this is advanced past the steps of the previous run, so each run draws fresh streams
      */
-    curandState *h_max_random_state = nullptr;
+    unsigned int step_offset = 0;
     /**
-     * Allocated length of h_max_random_state
+     * Advances step_offset by steps
+     * @param steps The number of steps executed since the last reseed() or advanceSteps()
      */
-    size_type h_max_random_size = 0;
+    void advanceSteps(const unsigned int &steps) { step_offset += steps; }
     /**
      * Seeded host random generator
      * Don't believe this to be thread-safe!
@@ -139,43 +92,11 @@ class RandomManager {
      */
     std::mt19937 host_rng;
 
-    /**
-     * Flag indicating that the device memory has been initialised, and therefore might need resetting
-     */
-    bool deviceInitialised;
-    /**
-     * Acts as destructor
-     * @note Safe to call multiple times
-     */
-    void free();
-
-    /**
-     * Destroys host stuff 
-     */
-    void freeHost();
-    /**
-     * Destroys device memory / resets the curand states
-     * @note includes cuda commands so not safe from c++ destructor
-     */
-    void freeDevice();
-    /**
-     * Wipes out host mirrors of device memory
-     * Only really to be used after calls to cudaDeviceReset()
-     * @note Only currently used after some tests
-     */
-    void purge();
-
     /**
      * Reinitialises host RNG from the current seed.
      */
     void reseedHost();
 
-    /**
-     * Reinitialises device RNG from the current seed.
-     * @note includes cuda commands.
-     */
-    void reseedDevice();
-
  public:
     // Public deleted creates better compiler errors
     RandomManager(RandomManager const&) = delete;
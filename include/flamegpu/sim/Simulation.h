@@ -6,6 +6,7 @@
 #include <ctime>
 #include <utility>
 #include <unordered_map>
+#include <vector>
 
 #include "flamegpu/sim/AgentInterface.h"
 #include "flamegpu/util/StringUint32Pair.h"
@@ -169,6 +170,11 @@ class Simulation {
      * Initial environment items if they have been loaded from file, prior to device selection
      */
     util::StringUint32PairUnorderedMap<util::Any> env_init;
+    /**
+     * Initial environment macro properties if they have been loaded from file, prior to device selection
+     * <name, raw data>
+     */
+    std::unordered_map<std::string, std::vector<char>> macro_env_init;
     /**
      * the width of the widest layer in the concrete version of the model (calculated once)
      */
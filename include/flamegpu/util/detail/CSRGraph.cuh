@@ -0,0 +1,238 @@
+#ifndef INCLUDE_FLAMEGPU_UTIL_DETAIL_CSRGRAPH_CUH_
+#define INCLUDE_FLAMEGPU_UTIL_DETAIL_CSRGRAPH_CUH_
+
+#ifndef __CUDACC_RTC__
+#include <cuda_runtime.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
+#endif  // __CUDACC_RTC__
+
+namespace flamegpu {
+namespace util {
+namespace detail {
+namespace csr {
+/**
+ * Returns the range of edge slots [begin, end) which hold the edges of a vertex
+ * @param offsets Device or host CSR offsets buffer
+ * @param degrees Device or host CSR degrees buffer
+ * @param vertex The vertex to lookup
+ * @param begin Returns the first edge slot of the vertex
+ * @param end Returns the edge slot beyond the last edge of the vertex
+ */
+__host__ __device__ __forceinline__ void adjacency(const unsigned int *offsets, const unsigned int *degrees, const unsigned int vertex, unsigned int &begin, unsigned int &end) {
+    begin = offsets[vertex];
+    end = begin + degrees[vertex];
+}
+}  // namespace csr
+#ifndef __CUDACC_RTC__
+/**
+ * Directed graph topology in compressed sparse row (CSR) form, with spare edge slots per vertex
+ *
+ * The edges of vertex v occupy the slots [offsets[v], offsets[v] + degrees[v]) of the edge list.
+ * Each vertex's slot range (up to offsets[v + 1]) is padded with spare slots, so edges can be added and removed in place.
+ * Only the degrees and edge slots of edited vertices then change, and these are reported by getDirtyRanges() for partial upload.
+ * If a vertex's spare slots are exhausted, the whole layout is rebuilt, and this is reported by getLayoutChanged().
+ *
+ * The device resident form is the offsets, degrees and edges buffers, with the same layout as getOffsets(), getDegrees() and getEdges().
+ * csr::adjacency() looks up the edges of a vertex from either form.
+ */
+class CSRGraph {
+ public:
+    /**
+     * The minimum number of spare edge slots reserved for each vertex when the layout is built
+     */
+    static constexpr unsigned int MIN_SLACK = 2;
+    /**
+     * @param vertex_count The number of vertices in the graph
+     */
+    explicit CSRGraph(const unsigned int vertex_count = 0)
+        : degrees(vertex_count, 0)
+        , dirty(vertex_count, false)
+        , layout_changed(true) {
+        relayout();
+    }
+    /**
+     * Removes all edges, and changes the number of vertices
+     * @param vertex_count The new number of vertices
+     */
+    void reset(const unsigned int vertex_count) {
+        degrees.assign(vertex_count, 0);
+        dirty.assign(vertex_count, false);
+        edges.clear();
+        relayout();
+    }
+    /**
+     * Replaces all edges, edges retain the order they are listed in within their source vertex
+     * @param new_edges List of (source, destination) pairs, both vertices must be less than getVertexCount()
+     * @note Duplicate edges are not removed
+     */
+    void build(const std::vector<std::pair<unsigned int, unsigned int>> &new_edges) {
+        std::fill(degrees.begin(), degrees.end(), 0);
+        for (const auto &e : new_edges)
+            ++degrees[e.first];
+        std::vector<unsigned int> counts(degrees.size(), 0);
+        edges.clear();
+        relayout();
+        for (const auto &e : new_edges)
+            edges[offsets[e.first] + counts[e.first]++] = e.second;
+    }
+    /**
+     * Adds a directed edge, if it does not already exist
+     * @param source The vertex which the edge leaves
+     * @param destination The vertex which the edge enters
+     * @return True if the edge was added
+     */
+    bool addEdge(const unsigned int source, const unsigned int destination) {
+        if (hasEdge(source, destination))
+            return false;
+        if (offsets[source] + degrees[source] == offsets[source + 1]) {
+            // The vertex has no spare slots, so the layout is rebuilt with fresh slack
+            ++degrees[source];
+            relayout(source);
+            edges[offsets[source] + degrees[source] - 1] = destination;
+        } else {
+            edges[offsets[source] + degrees[source]++] = destination;
+            dirty[source] = true;
+        }
+        return true;
+    }
+    /**
+     * Removes a directed edge, the remaining edges of the source vertex retain their order
+     * @param source The vertex which the edge leaves
+     * @param destination The vertex which the edge enters
+     * @return True if the edge existed
+     */
+    bool removeEdge(const unsigned int source, const unsigned int destination) {
+        const auto begin = edges.begin() + offsets[source];
+        const auto end = begin + degrees[source];
+        const auto it = std::find(begin, end, destination);
+        if (it == end)
+            return false;
+        std::copy(it + 1, end, it);
+        --degrees[source];
+        dirty[source] = true;
+        return true;
+    }
+    /**
+     * @return True if the directed edge exists
+     */
+    bool hasEdge(const unsigned int source, const unsigned int destination) const {
+        const auto begin = edges.begin() + offsets[source];
+        return std::find(begin, begin + degrees[source], destination) != begin + degrees[source];
+    }
+    /**
+     * @return The destination vertices of the edges leaving a vertex, in slot order
+     */
+    std::vector<unsigned int> getNeighbours(const unsigned int vertex) const {
+        return std::vector<unsigned int>(edges.begin() + offsets[vertex], edges.begin() + offsets[vertex] + degrees[vertex]);
+    }
+    /**
+     * @return The number of edges leaving a vertex
+     */
+    unsigned int getDegree(const unsigned int vertex) const { return degrees[vertex]; }
+    /**
+     * @return The number of vertices
+     */
+    unsigned int getVertexCount() const { return static_cast<unsigned int>(degrees.size()); }
+    /**
+     * @return The total number of edges
+     */
+    unsigned int getEdgeCount() const {
+        unsigned int count = 0;
+        for (const unsigned int &d : degrees)
+            count += d;
+        return count;
+    }
+    /**
+     * @return Host buffer of vertex_count + 1 slot offsets, in the same layout as the device resident form
+     */
+    const std::vector<unsigned int> &getOffsets() const { return offsets; }
+    /**
+     * @return Host buffer of vertex_count degrees, in the same layout as the device resident form
+     */
+    const std::vector<unsigned int> &getDegrees() const { return degrees; }
+    /**
+     * @return Host buffer of edge slots, in the same layout as the device resident form, spare slots hold unspecified values
+     */
+    const std::vector<unsigned int> &getEdges() const { return edges; }
+    /**
+     * @return True if the offsets have changed since clearDirty() was last called, so the whole topology requires upload
+     */
+    bool getLayoutChanged() const { return layout_changed; }
+    /**
+     * Returns the ranges of vertices [begin, end) edited since clearDirty() was last called
+     * Adjacent edited vertices are merged, so each range's degrees and edge slots are contiguous
+     * @note Not meaningful if getLayoutChanged() returns true
+     */
+    std::vector<std::pair<unsigned int, unsigned int>> getDirtyRanges() const {
+        std::vector<std::pair<unsigned int, unsigned int>> ranges;
+        for (unsigned int v = 0; v < dirty.size(); ++v) {
+            if (dirty[v]) {
+                if (!ranges.empty() && ranges.back().second == v) {
+                    ranges.back().second = v + 1;
+                } else {
+                    ranges.emplace_back(v, v + 1);
+                }
+            }
+        }
+        return ranges;
+    }
+    /**
+     * Marks the topology as matching its device resident form
+     */
+    void clearDirty() {
+        std::fill(dirty.begin(), dirty.end(), false);
+        layout_changed = false;
+    }
+
+ private:
+    /**
+     * Rebuilds offsets with fresh slack for every vertex, moving existing edges to their new slots
+     * @param grown A vertex whose degree has been incremented, but whose new edge has not been stored
+     */
+    void relayout(const unsigned int grown = 0xffffffff) {
+        std::vector<unsigned int> new_offsets(degrees.size() + 1, 0);
+        for (unsigned int v = 0; v < degrees.size(); ++v) {
+            const unsigned int slack = degrees[v] / 4 > MIN_SLACK ? degrees[v] / 4 : MIN_SLACK;
+            new_offsets[v + 1] = new_offsets[v] + degrees[v] + slack;
+        }
+        std::vector<unsigned int> new_edges(new_offsets.back(), 0);
+        if (!edges.empty()) {
+            for (unsigned int v = 0; v < degrees.size(); ++v) {
+                const unsigned int stored = v == grown ? degrees[v] - 1 : degrees[v];
+                std::copy(edges.begin() + offsets[v], edges.begin() + offsets[v] + stored, new_edges.begin() + new_offsets[v]);
+            }
+        }
+        offsets.swap(new_offsets);
+        edges.swap(new_edges);
+        layout_changed = true;
+    }
+    /**
+     * Slot offset of each vertex's edges, followed by the total number of slots
+     */
+    std::vector<unsigned int> offsets;
+    /**
+     * Number of edges leaving each vertex
+     */
+    std::vector<unsigned int> degrees;
+    /**
+     * Destination vertex of each edge slot
+     */
+    std::vector<unsigned int> edges;
+    /**
+     * Vertices edited since clearDirty() was last called
+     */
+    std::vector<bool> dirty;
+    /**
+     * True if the offsets have changed since clearDirty() was last called
+     */
+    bool layout_changed;
+};
+#endif  // __CUDACC_RTC__
+
+}  // namespace detail
+}  // namespace util
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_UTIL_DETAIL_CSRGRAPH_CUH_
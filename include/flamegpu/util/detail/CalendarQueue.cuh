@@ -0,0 +1,119 @@
+#ifndef INCLUDE_FLAMEGPU_UTIL_DETAIL_CALENDARQUEUE_CUH_
+#define INCLUDE_FLAMEGPU_UTIL_DETAIL_CALENDARQUEUE_CUH_
+
+#include <cuda_runtime.h>
+#include <algorithm>
+#include <vector>
+
+namespace flamegpu {
+namespace util {
+namespace detail {
+/**
+ * Bucketed calendar queue of scheduled agent wake steps
+ *
+ * Each bucket counts the events scheduled for a single step within the year of bucket_count steps following the base step.
+ * Events scheduled beyond the year are not bucketed, only the earliest of them is tracked.
+ * This allows the number of agents due to wake by any step within the year to be answered on the host, without touching the device.
+ *
+ * The device resident form is a buffer of bucket_count + 1 counters with the same layout as data(), filled using bucketOf().
+ * insert() is the equivalent host implementation.
+ */
+class CalendarQueue {
+ public:
+    /**
+     * Value returned by dueBy() and nextEvent() when the answer is not known
+     */
+    static constexpr unsigned int UNKNOWN = 0xffffffff;
+    /**
+     * @param bucket_count The number of steps covered by each year of the calendar
+     */
+    explicit CalendarQueue(const unsigned int bucket_count = 64)
+        : counts(bucket_count + 1, 0)
+        , base_step(0) {
+        counts[bucket_count] = UNKNOWN;
+    }
+    /**
+     * Returns the bucket of the calendar which an event at the specified step falls into
+     */
+    __host__ __device__ __forceinline__ static unsigned int bucketOf(const unsigned int step, const unsigned int bucket_count) {
+        return step % bucket_count;
+    }
+    /**
+     * Empties the calendar, and sets the step which it is built relative to
+     * @param step The new base step
+     */
+    void reset(const unsigned int step) {
+        std::fill(counts.begin(), counts.end() - 1, 0);
+        counts.back() = UNKNOWN;
+        base_step = step;
+    }
+    /**
+     * Inserts an event
+     * @param event_step The step of the event to insert, events at or before the base step are ignored
+     */
+    void insert(const unsigned int event_step) {
+        const unsigned int bucket_count = getBucketCount();
+        if (event_step > base_step) {
+            if (event_step - base_step <= bucket_count) {
+                ++counts[bucketOf(event_step, bucket_count)];
+            } else {
+                counts.back() = std::min(counts.back(), event_step);
+            }
+        }
+    }
+    /**
+     * Returns the number of events which fall after the base step, and at or before the specified step
+     * @param step The step to count events up to
+     * @return The number of events, or UNKNOWN if step is beyond the year and not before the earliest event beyond the year
+     */
+    unsigned int dueBy(const unsigned int step) const {
+        const unsigned int bucket_count = getBucketCount();
+        const unsigned int year_end = base_step + bucket_count;
+        if (step > year_end && step >= counts.back())
+            return UNKNOWN;
+        unsigned int due = 0;
+        for (unsigned int s = base_step + 1; s <= std::min(step, year_end); ++s) {
+            due += counts[bucketOf(s, bucket_count)];
+        }
+        return due;
+    }
+    /**
+     * @return The step of the earliest event, or UNKNOWN if the calendar is empty
+     */
+    unsigned int nextEvent() const {
+        const unsigned int bucket_count = getBucketCount();
+        for (unsigned int s = base_step + 1; s <= base_step + bucket_count; ++s) {
+            if (counts[bucketOf(s, bucket_count)])
+                return s;
+        }
+        return counts.back();
+    }
+    /**
+     * @return The step which the calendar was built relative to
+     */
+    unsigned int getBaseStep() const { return base_step; }
+    /**
+     * @return The number of steps covered by each year of the calendar
+     */
+    unsigned int getBucketCount() const { return static_cast<unsigned int>(counts.size() - 1); }
+    /**
+     * @return Host buffer of bucket_count + 1 counters, in the same layout as the device resident form
+     */
+    unsigned int *data() { return counts.data(); }
+
+ private:
+    /**
+     * Count of events in each bucket, followed by the earliest event beyond the year
+     */
+    std::vector<unsigned int> counts;
+    /**
+     * The step which the calendar was built relative to
+     */
+    unsigned int base_step;
+};
+
+}  // namespace detail
+}  // namespace util
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_UTIL_DETAIL_CALENDARQUEUE_CUH_
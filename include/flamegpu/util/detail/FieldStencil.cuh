@@ -0,0 +1,155 @@
+#ifndef INCLUDE_FLAMEGPU_UTIL_DETAIL_FIELDSTENCIL_CUH_
+#define INCLUDE_FLAMEGPU_UTIL_DETAIL_FIELDSTENCIL_CUH_
+
+#include <cuda_runtime.h>
+
+#include <utility>
+#include <vector>
+
+namespace flamegpu {
+
+/**
+ * Boundary handling of an environment field's stencil
+ */
+enum class FieldBoundary : int {
+    /**
+     * The field wraps around each axis
+     */
+    Periodic = 0,
+    /**
+     * Cells beyond the edge take the value of the nearest edge cell, so nothing flows across the boundary
+     */
+    ZeroFlux = 1,
+    /**
+     * Cells beyond the edge take a constant value (Dirichlet)
+     */
+    Fixed = 2
+};
+
+namespace util {
+namespace detail {
+
+/**
+ * A single explicit sub-step of an environment field's diffusion/decay/advection stencil
+ *
+ * Each sub-step of length dt updates a cell c as
+ * c' = c + dt * (diffusion * laplacian(c) - decay * c - velocity . upwind_gradient(c))
+ * The grid spacing is 1 cell, axes of length 1 are ignored, so 2D fields are simply 1 cell deep.
+ * This is shared by the device kernel and the host reference implementation, so their results are equivalent
+ * up to floating-point contraction (nvcc may fuse the multiply-adds, so results can differ in the last bits).
+ */
+struct FieldStencil {
+    /**
+     * Length of each of the field's 3 axes
+     */
+    unsigned int dimensions[3];
+    /**
+     * Diffusion coefficient, in cells^2 per unit time
+     */
+    float diffusion;
+    /**
+     * Decay rate, per unit time
+     */
+    float decay;
+    /**
+     * Advection velocity, in cells per unit time
+     */
+    float velocity[3];
+    /**
+     * Length of a sub-step
+     */
+    float dt;
+    /**
+     * Boundary condition applied to every axis
+     */
+    FieldBoundary boundary;
+    /**
+     * Value of cells beyond the edge, only used by FieldBoundary::Fixed
+     */
+    float boundary_value;
+    /**
+     * Returns the total number of cells
+     */
+    __host__ __device__ unsigned int cellCount() const { return dimensions[0] * dimensions[1] * dimensions[2]; }
+    /**
+     * Returns whether any of diffusion, decay or advection are enabled
+     */
+    __host__ __device__ bool isActive() const {
+        return diffusion != 0.0f || decay != 0.0f || velocity[0] != 0.0f || velocity[1] != 0.0f || velocity[2] != 0.0f;
+    }
+    /**
+     * Returns the value of the neighbour offset by +-1 along an axis, after applying the boundary condition
+     * @param src The field before the sub-step
+     * @param pos Position of the cell
+     * @param axis The axis to offset along
+     * @param offset -1 or 1
+     */
+    __host__ __device__ float neighbour(const float *src, const unsigned int pos[3], const unsigned int &axis, const int &offset) const {
+        unsigned int p[3] = { pos[0], pos[1], pos[2] };
+        const unsigned int len = dimensions[axis];
+        if (offset < 0 && p[axis] == 0) {
+            if (boundary == FieldBoundary::Fixed)
+                return boundary_value;
+            p[axis] = boundary == FieldBoundary::Periodic ? len - 1 : 0;
+        } else if (offset > 0 && p[axis] == len - 1) {
+            if (boundary == FieldBoundary::Fixed)
+                return boundary_value;
+            p[axis] = boundary == FieldBoundary::Periodic ? 0 : len - 1;
+        } else {
+            p[axis] += offset;
+        }
+        return src[(p[2] * dimensions[1] + p[1]) * dimensions[0] + p[0]];
+    }
+    /**
+     * Returns the value of the cell at index after the sub-step
+     * @param src The field before the sub-step, in x-fastest order
+     * @param index Index of the cell within src
+     */
+    __host__ __device__ float apply(const float *src, const unsigned int &index) const {
+        const unsigned int pos[3] = { index % dimensions[0], (index / dimensions[0]) % dimensions[1], index / (dimensions[0] * dimensions[1]) };
+        const float c = src[index];
+        float rate = -decay * c;
+        for (unsigned int axis = 0; axis < 3; ++axis) {
+            if (dimensions[axis] <= 1)
+                continue;
+            const float lo = neighbour(src, pos, axis, -1);
+            const float hi = neighbour(src, pos, axis, 1);
+            rate += diffusion * (lo + hi - 2.0f * c);
+            // First order upwind
+            const float v = velocity[axis];
+            rate -= v > 0.0f ? v * (c - lo) : v * (hi - c);
+        }
+        return c + dt * rate;
+    }
+};
+
+/**
+ * Applies a single sub-step of the stencil to every cell on the device
+ * @param stencil The field's stencil
+ * @param d_src The field before the sub-step, in device memory
+ * @param d_dst The field after the sub-step, in device memory
+ * @param stream The CUDA stream to launch the kernel in
+ */
+void fieldStencilDevice(const FieldStencil &stencil, const float *d_src, float *d_dst, cudaStream_t stream);
+
+/**
+ * Host reference implementation of the device stencil
+ * @param stencil The field's stencil
+ * @param field The field, in x-fastest order, this is updated in place
+ * @param sub_steps Number of sub-steps of length stencil.dt to apply
+ */
+inline void fieldStencilHost(const FieldStencil &stencil, std::vector<float> &field, const unsigned int &sub_steps) {
+    std::vector<float> back(field.size());
+    for (unsigned int s = 0; s < sub_steps; ++s) {
+        for (unsigned int i = 0; i < stencil.cellCount(); ++i) {
+            back[i] = stencil.apply(field.data(), i);
+        }
+        std::swap(field, back);
+    }
+}
+
+}  // namespace detail
+}  // namespace util
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_UTIL_DETAIL_FIELDSTENCIL_CUH_
@@ -0,0 +1,52 @@
+#ifndef INCLUDE_FLAMEGPU_UTIL_DETAIL_MAPPEDFILE_H_
+#define INCLUDE_FLAMEGPU_UTIL_DETAIL_MAPPEDFILE_H_
+
+#include <cstddef>
+#include <string>
+
+namespace flamegpu {
+namespace util {
+namespace detail {
+
+/**
+ * Read-only memory mapping of a whole file
+ * Pages are loaded by the OS as they are accessed, so the file is never parsed or copied into a separate host buffer
+ */
+class MappedFile {
+ public:
+    /**
+     * Maps the file for reading
+     * @param file_path Path to the file
+     * @throws exception::InvalidFilePath If the file cannot be opened
+     * @throws exception::InvalidInputFile If the file is empty, or cannot be mapped
+     */
+    explicit MappedFile(const std::string &file_path);
+    /**
+     * Unmaps the file
+     */
+    ~MappedFile();
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    /**
+     * Returns a pointer to the first byte of the mapped file
+     */
+    const void *data() const { return ptr; }
+    /**
+     * Returns the length of the mapped file in bytes
+     */
+    size_t size() const { return length; }
+
+ private:
+    const void *ptr;
+    size_t length;
+#ifdef _MSC_VER
+    void *file_handle;
+    void *mapping_handle;
+#endif
+};
+
+}  // namespace detail
+}  // namespace util
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_UTIL_DETAIL_MAPPEDFILE_H_
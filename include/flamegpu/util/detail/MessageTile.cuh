@@ -0,0 +1,165 @@
+#ifndef INCLUDE_FLAMEGPU_UTIL_DETAIL_MESSAGETILE_CUH_
+#define INCLUDE_FLAMEGPU_UTIL_DETAIL_MESSAGETILE_CUH_
+
+#ifndef __CUDACC_RTC__
+#include <cuda_runtime.h>
+#include <string>
+#endif  // __CUDACC_RTC__
+
+namespace flamegpu {
+namespace util {
+namespace detail {
+/**
+ * Schedule used to cooperatively stage tiles of consecutive messages within a shared memory buffer
+ *
+ * A tile holds tile_length messages, each staged variable occupies a contiguous segment of tile_length elements,
+ * so the tile mirrors the structure of arrays layout of the message list.
+ * tile_length is always a multiple of 8, so that every segment begins 8 byte aligned.
+ *
+ * stage() copies the portion of a tile assigned to a single thread, consecutive threads copy consecutive words,
+ * so that global reads are coalesced. emulate() runs stage() for every thread of a block in turn, allowing the schedule to be tested on the host.
+ */
+namespace tile {
+/**
+ * A message variable which is staged within tiles
+ */
+struct Variable {
+    /**
+     * Pointer to the variable's buffer within the message list
+     */
+    const char *data;
+    /**
+     * Size of the variable per message in bytes (type size * array length)
+     */
+    unsigned int size;
+    /**
+     * Hash of the variable's name
+     * @see hash()
+     */
+    unsigned int hash;
+    /**
+     * Sum of the sizes of the preceding staged variables, the variable's segment begins at tile_length * offset
+     */
+    unsigned int offset;
+};
+/**
+ * Returns the FNV-1a hash of a variable name
+ * @param name The variable name
+ * @param length Length of name, excluding any null terminator
+ */
+__host__ __device__ __forceinline__ unsigned int hash(const char *name, const unsigned int length) {
+    unsigned int h = 2166136261u;
+    for (unsigned int i = 0; i < length; ++i) {
+        h ^= static_cast<unsigned char>(name[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+/**
+ * Returns the hash of a string literal variable name
+ * @tparam N Length of name, this should be implicit if a string literal is passed
+ */
+template<unsigned int N>
+__host__ __device__ __forceinline__ unsigned int hash(const char(&name)[N]) {
+    return hash(name, N - 1);
+}
+/**
+ * Returns the number of messages which fit within a tile
+ * @param tile_bytes Size of the tile buffer
+ * @param message_bytes Total size of the staged variables per message
+ * @return A multiple of 8, or 0 if fewer than 8 messages fit (in which case messages should not be staged)
+ */
+__host__ __device__ __forceinline__ unsigned int length(const unsigned int tile_bytes, const unsigned int message_bytes) {
+    if (message_bytes == 0)
+        return 0;
+    const unsigned int messages = tile_bytes / message_bytes;
+    return messages - messages % 8;
+}
+/**
+ * Returns the index of the staged variable with the provided hash
+ * @param variables The staged variables
+ * @param variable_count Length of variables
+ * @param variable_hash Hash of the variable's name
+ * @return The index within variables, or -1 if the variable is not staged
+ */
+__host__ __device__ __forceinline__ int find(const Variable *variables, const unsigned int variable_count, const unsigned int variable_hash) {
+    for (unsigned int i = 0; i < variable_count; ++i) {
+        if (variables[i].hash == variable_hash)
+            return static_cast<int>(i);
+    }
+    return -1;
+}
+/**
+ * Returns a pointer to a message's value of a staged variable within the tile
+ * @param variable The staged variable
+ * @param tile The tile buffer
+ * @param tile_length The number of messages per tile
+ * @param slot Position of the message within the tile
+ */
+__host__ __device__ __forceinline__ const char *element(const Variable &variable, const char *tile, const unsigned int tile_length, const unsigned int slot) {
+    return tile + tile_length * variable.offset + slot * variable.size;
+}
+/**
+ * Copies the portion of a tile assigned to a thread
+ * Every thread of the block must call this with the same tile for the tile to be fully staged
+ * @param variables The staged variables
+ * @param variable_count Length of variables
+ * @param tile_length The number of messages per tile
+ * @param first Index of the tile's first message within the message list
+ * @param count The number of messages within the tile, this is less than tile_length for the final tile
+ * @param thread Index of the thread within the block
+ * @param threads The number of threads within the block
+ * @param tile The tile buffer
+ */
+__host__ __device__ __forceinline__ void stage(const Variable *variables, const unsigned int variable_count, const unsigned int tile_length,
+    const unsigned int first, const unsigned int count, const unsigned int thread, const unsigned int threads, char *tile) {
+    for (unsigned int v = 0; v < variable_count; ++v) {
+        const Variable &var = variables[v];
+        const char *src = var.data + static_cast<size_t>(first) * var.size;
+        char *dst = tile + tile_length * var.offset;
+        if (var.size % 4 == 0) {
+            // Variable buffers and segments are both 4 byte aligned, so whole words can be copied
+            const unsigned int words = count * (var.size / 4);
+            for (unsigned int w = thread; w < words; w += threads) {
+                reinterpret_cast<unsigned int *>(dst)[w] = reinterpret_cast<const unsigned int *>(src)[w];
+            }
+        } else {
+            const unsigned int bytes = count * var.size;
+            for (unsigned int b = thread; b < bytes; b += threads) {
+                dst[b] = src[b];
+            }
+        }
+    }
+}
+#ifndef __CUDACC_RTC__
+/**
+ * Host emulation of a block cooperatively staging a tile
+ * Calls stage() on behalf of each thread in turn
+ * @param variables The staged variables
+ * @param variable_count Length of variables
+ * @param tile_length The number of messages per tile
+ * @param first Index of the tile's first message within the message list
+ * @param count The number of messages within the tile
+ * @param threads The number of threads within the emulated block
+ * @param tile The tile buffer
+ */
+inline void emulate(const Variable *variables, const unsigned int variable_count, const unsigned int tile_length,
+    const unsigned int first, const unsigned int count, const unsigned int threads, char *tile) {
+    for (unsigned int t = 0; t < threads; ++t) {
+        stage(variables, variable_count, tile_length, first, count, t, threads, tile);
+    }
+}
+/**
+ * Returns the hash of a variable name
+ * @param name The variable name
+ */
+inline unsigned int hash(const std::string &name) {
+    return hash(name.c_str(), static_cast<unsigned int>(name.size()));
+}
+#endif  // __CUDACC_RTC__
+}  // namespace tile
+}  // namespace detail
+}  // namespace util
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_UTIL_DETAIL_MESSAGETILE_CUH_
@@ -0,0 +1,102 @@
+#ifndef INCLUDE_FLAMEGPU_UTIL_DETAIL_MORTON_CUH_
+#define INCLUDE_FLAMEGPU_UTIL_DETAIL_MORTON_CUH_
+
+#ifndef __CUDACC_RTC__
+#include <cuda_runtime.h>
+#endif  // __CUDACC_RTC__
+
+namespace flamegpu {
+namespace util {
+namespace detail {
+/**
+ * Z-order (Morton) bin layout for spatially partitioned messages
+ *
+ * The grid is divided into cubic tiles with a power of two side, which is the smallest to cover the shortest grid dimension.
+ * Bins within a tile are Morton ordered, whilst the tiles themselves are ordered row-major.
+ * This keeps neighbouring bins close in the bin order for grids of any aspect ratio, at the cost of padding bins
+ * which are never occupied where a grid dimension is not a multiple of the tile side.
+ */
+namespace morton {
+/**
+ * Maximum tile bits per axis, such that a 2D tile's Morton codes fit within 32 bits
+ */
+constexpr unsigned int MAX_TILE_BITS_2D = 16;
+/**
+ * Maximum tile bits per axis, such that a 3D tile's Morton codes fit within 32 bits
+ */
+constexpr unsigned int MAX_TILE_BITS_3D = 10;
+/**
+ * Spreads the lower 16 bits of v, so that a zero bit separates each
+ */
+__host__ __device__ __forceinline__ unsigned int spread2(unsigned int v) {
+    v &= 0x0000ffff;
+    v = (v | (v << 8)) & 0x00ff00ff;
+    v = (v | (v << 4)) & 0x0f0f0f0f;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+/**
+ * Spreads the lower 10 bits of v, so that two zero bits separate each
+ */
+__host__ __device__ __forceinline__ unsigned int spread3(unsigned int v) {
+    v &= 0x000003ff;
+    v = (v | (v << 16)) & 0x030000ff;
+    v = (v | (v << 8)) & 0x0300f00f;
+    v = (v | (v << 4)) & 0x030c30c3;
+    v = (v | (v << 2)) & 0x09249249;
+    return v;
+}
+/**
+ * Returns the number of bits per axis of a tile, for the specified grid dimensions
+ * @param gridDim The number of bins in each dimension
+ * @param dims The number of dimensions, 2 or 3
+ */
+__host__ __device__ inline unsigned int tileBits(const unsigned int *gridDim, const unsigned int dims) {
+    unsigned int min_dim = gridDim[0];
+    for (unsigned int i = 1; i < dims; ++i) {
+        min_dim = gridDim[i] < min_dim ? gridDim[i] : min_dim;
+    }
+    const unsigned int max_bits = dims == 2 ? MAX_TILE_BITS_2D : MAX_TILE_BITS_3D;
+    unsigned int bits = 0;
+    while (bits < max_bits && (1u << bits) < min_dim) {
+        ++bits;
+    }
+    return bits;
+}
+/**
+ * Returns the number of tiles required to cover a grid dimension
+ * @param dim The number of bins in the dimension
+ * @param bits The number of bits per axis of a tile
+ */
+__host__ __device__ __forceinline__ unsigned int tileCount(const unsigned int dim, const unsigned int bits) {
+    return (dim + (1u << bits) - 1) >> bits;
+}
+/**
+ * Returns the bin index of a 2D grid cell
+ * @param x, y The grid cell, which must be within the grid
+ * @param bits The number of bits per axis of a tile
+ * @param tiles The number of tiles in each dimension
+ */
+__host__ __device__ __forceinline__ unsigned int encode2D(const unsigned int x, const unsigned int y, const unsigned int bits, const unsigned int *tiles) {
+    const unsigned int mask = (1u << bits) - 1;
+    const unsigned int tile = ((y >> bits) * tiles[0]) + (x >> bits);
+    return (tile << (2 * bits)) | spread2(x & mask) | (spread2(y & mask) << 1);
+}
+/**
+ * Returns the bin index of a 3D grid cell
+ * @param x, y, z The grid cell, which must be within the grid
+ * @param bits The number of bits per axis of a tile
+ * @param tiles The number of tiles in each dimension
+ */
+__host__ __device__ __forceinline__ unsigned int encode3D(const unsigned int x, const unsigned int y, const unsigned int z, const unsigned int bits, const unsigned int *tiles) {
+    const unsigned int mask = (1u << bits) - 1;
+    const unsigned int tile = ((((z >> bits) * tiles[1]) + (y >> bits)) * tiles[0]) + (x >> bits);
+    return (tile << (3 * bits)) | spread3(x & mask) | (spread3(y & mask) << 1) | (spread3(z & mask) << 2);
+}
+}  // namespace morton
+}  // namespace detail
+}  // namespace util
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_UTIL_DETAIL_MORTON_CUH_
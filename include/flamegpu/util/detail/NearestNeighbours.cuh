@@ -0,0 +1,110 @@
+#ifndef INCLUDE_FLAMEGPU_UTIL_DETAIL_NEARESTNEIGHBOURS_CUH_
+#define INCLUDE_FLAMEGPU_UTIL_DETAIL_NEARESTNEIGHBOURS_CUH_
+
+#ifndef __CUDACC_RTC__
+#include <cuda_runtime.h>
+#include <vector>
+#endif  // __CUDACC_RTC__
+
+namespace flamegpu {
+namespace util {
+namespace detail {
+/**
+ * Bounded sorted list of the nearest messages to a search origin, used by k-nearest-neighbour messages
+ *
+ * Neighbours are ordered by squared distance from the origin, ties are broken by location (x, then y, then z) and finally by index.
+ * Therefore the selected neighbours only depend on the order of the message list if multiple messages share a location.
+ *
+ * nearest() is a brute force host reference implementation, which selects neighbours with the same ordering as the device search.
+ */
+namespace knn {
+/**
+ * A candidate neighbour of the search origin
+ */
+struct Neighbour {
+    /**
+     * Squared distance from the search origin
+     */
+    float dist2;
+    /**
+     * Location of the neighbour
+     */
+    float x, y, z;
+    /**
+     * Index of the neighbour within the message list
+     */
+    unsigned int index;
+};
+/**
+ * Returns the squared distance between two locations
+ * @param ax, ay, az The first location
+ * @param bx, by, bz The second location
+ */
+__host__ __device__ __forceinline__ float distance2(const float ax, const float ay, const float az, const float bx, const float by, const float bz) {
+    const float dx = ax - bx;
+    const float dy = ay - by;
+    const float dz = az - bz;
+    return dx * dx + dy * dy + dz * dz;
+}
+/**
+ * Returns true if neighbour a is ordered before neighbour b
+ */
+__host__ __device__ __forceinline__ bool nearer(const Neighbour &a, const Neighbour &b) {
+    if (a.dist2 != b.dist2)
+        return a.dist2 < b.dist2;
+    if (a.x != b.x)
+        return a.x < b.x;
+    if (a.y != b.y)
+        return a.y < b.y;
+    if (a.z != b.z)
+        return a.z < b.z;
+    return a.index < b.index;
+}
+/**
+ * Inserts a candidate into a sorted list of at most k neighbours, if it is nearer than the furthest held neighbour
+ * @param list The sorted list of neighbours, this must have capacity for k neighbours
+ * @param count The number of neighbours held by the list, this is updated
+ * @param k The maximum number of neighbours held by the list
+ * @param n The candidate neighbour
+ */
+__host__ __device__ __forceinline__ void insert(Neighbour *list, unsigned int &count, const unsigned int k, const Neighbour &n) {
+    if (count == k && !nearer(n, list[k - 1]))
+        return;
+    unsigned int i = count < k ? count++ : k - 1;
+    // Shift further neighbours back, to make space for the candidate
+    while (i > 0 && nearer(n, list[i - 1])) {
+        list[i] = list[i - 1];
+        --i;
+    }
+    list[i] = n;
+}
+#ifndef __CUDACC_RTC__
+/**
+ * Returns the k nearest of a set of locations to the search origin, within max_radius
+ * @param x, y, z The locations to search, each of length count
+ * @param count The number of locations
+ * @param ox, oy, oz The search origin
+ * @param k The maximum number of neighbours to return
+ * @param max_radius The maximum distance of a neighbour from the search origin
+ * @return The nearest neighbours in sorted order, their index is the index of their location
+ */
+inline std::vector<Neighbour> nearest(const float *x, const float *y, const float *z, const unsigned int count,
+    const float ox, const float oy, const float oz, const unsigned int k, const float max_radius) {
+    std::vector<Neighbour> list(k);
+    unsigned int found = 0;
+    for (unsigned int i = 0; i < count; ++i) {
+        const float d2 = distance2(x[i], y[i], z[i], ox, oy, oz);
+        if (d2 <= max_radius * max_radius) {
+            insert(list.data(), found, k, { d2, x[i], y[i], z[i], i });
+        }
+    }
+    list.resize(found);
+    return list;
+}
+#endif  // __CUDACC_RTC__
+}  // namespace knn
+}  // namespace detail
+}  // namespace util
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_UTIL_DETAIL_NEARESTNEIGHBOURS_CUH_
@@ -0,0 +1,116 @@
+#ifndef INCLUDE_FLAMEGPU_UTIL_DETAIL_PHILOX_CUH_
+#define INCLUDE_FLAMEGPU_UTIL_DETAIL_PHILOX_CUH_
+
+#include <cuda_runtime.h>
+#include <cstdint>
+#include <cmath>
+
+namespace flamegpu {
+namespace util {
+namespace detail {
+/**
+ * Counter-based Philox4x32-10 random number generator (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3", SC'11)
+ *
+ * Unlike curand's stateful generators, each output block is a pure function of a 128 bit counter and a 64 bit key.
+ * This allows any value in a stream to be produced independently on either the host or the device,
+ * so results do not depend on the order, or number of threads, used to generate them.
+ */
+namespace Philox {
+/**
+ * 4x32 bit counter/output block
+ */
+struct uint32x4 {
+    uint32_t x, y, z, w;
+};
+/**
+ * 2x32 bit key
+ */
+struct uint32x2 {
+    uint32_t x, y;
+};
+
+static constexpr uint32_t M0 = 0xD2511F53u;
+static constexpr uint32_t M1 = 0xCD9E8D57u;
+static constexpr uint32_t W0 = 0x9E3779B9u;
+static constexpr uint32_t W1 = 0xBB67AE85u;
+
+/**
+ * Returns the high 32 bits of the 64 bit product a * b
+ */
+__host__ __device__ __forceinline__ uint32_t mulhi(const uint32_t a, const uint32_t b) {
+#ifdef __CUDA_ARCH__
+    return __umulhi(a, b);
+#else
+    return static_cast<uint32_t>((static_cast<uint64_t>(a) * static_cast<uint64_t>(b)) >> 32);
+#endif
+}
+/**
+ * Perform a single Philox round
+ */
+__host__ __device__ __forceinline__ uint32x4 round(const uint32x4 &ctr, const uint32x2 &key) {
+    const uint32_t hi0 = mulhi(M0, ctr.x);
+    const uint32_t lo0 = M0 * ctr.x;
+    const uint32_t hi1 = mulhi(M1, ctr.z);
+    const uint32_t lo1 = M1 * ctr.z;
+    return {hi1 ^ ctr.y ^ key.x, lo1, hi0 ^ ctr.w ^ key.y, lo0};
+}
+/**
+ * Generate the 128 bit random block for the provided counter and key
+ * @param ctr Counter, typically composed from an item index and a stream/draw index
+ * @param key Key, typically the seed
+ */
+__host__ __device__ __forceinline__ uint32x4 generate(uint32x4 ctr, uint32x2 key) {
+    ctr = round(ctr, key);
+    for (int i = 1; i < 10; ++i) {
+        key.x += W0;
+        key.y += W1;
+        ctr = round(ctr, key);
+    }
+    return ctr;
+}
+/**
+ * Split a 64 bit seed into a Philox key
+ */
+__host__ __device__ __forceinline__ uint32x2 key(const uint64_t seed) {
+    return {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)};
+}
+/**
+ * Mix the bits of a 64 bit value, using the SplitMix64 finaliser
+ * This is a bijection, so distinct inputs produce distinct outputs
+ */
+__host__ __device__ __forceinline__ uint64_t mix64(uint64_t z) {
+    z += 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+/**
+ * Convert 32 random bits to a float in the range (0.0, 1.0]
+ * @note This matches the range of curand_uniform()
+ */
+__host__ __device__ __forceinline__ float toFloat(const uint32_t a) {
+    return static_cast<float>((a >> 8) + 1u) * (1.0f / 16777216.0f);
+}
+/**
+ * Convert 64 random bits to a double in the range (0.0, 1.0]
+ * @note This matches the range of curand_uniform_double()
+ */
+__host__ __device__ __forceinline__ double toDouble(const uint32_t a, const uint32_t b) {
+    const uint64_t t = (static_cast<uint64_t>(a) << 32) | static_cast<uint64_t>(b);
+    return static_cast<double>((t >> 11) + 1u) * (1.0 / 9007199254740992.0);
+}
+/**
+ * Box-Muller transform, converts two uniform values in the range (0.0, 1.0] to a standard normal value
+ */
+__host__ __device__ __forceinline__ float toNormal(const float u1, const float u2) {
+    return sqrtf(-2.0f * logf(u1)) * cosf(6.28318530718f * u2);
+}
+__host__ __device__ __forceinline__ double toNormal(const double u1, const double u2) {
+    return sqrt(-2.0 * log(u1)) * cos(6.283185307179586 * u2);
+}
+}  // namespace Philox
+}  // namespace detail
+}  // namespace util
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_UTIL_DETAIL_PHILOX_CUH_
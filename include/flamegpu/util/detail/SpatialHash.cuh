@@ -0,0 +1,133 @@
+#ifndef INCLUDE_FLAMEGPU_UTIL_DETAIL_SPATIALHASH_CUH_
+#define INCLUDE_FLAMEGPU_UTIL_DETAIL_SPATIALHASH_CUH_
+
+#ifndef __CUDACC_RTC__
+#include <cuda_runtime.h>
+#include <cmath>
+#endif  // __CUDACC_RTC__
+
+namespace flamegpu {
+namespace util {
+namespace detail {
+/**
+ * Open addressing hash table of occupied grid cells, used by sparse spatial messages
+ *
+ * Each occupied cell's coordinates are packed into a 64 bit key, which is inserted into a power of two sized table using linear probing.
+ * Coordinates wrap every 2^CELL_BITS cells, so cells that far apart share a key. Their messages are returned together, but any
+ * 3x3x3 block of neighbouring cells always has 27 distinct keys, so a search never visits the same cell twice.
+ * The table is sized relative to the number of messages, rather than the number of cells within the environment.
+ *
+ * Device insertion uses atomicCAS() with the same probe sequence as insert(), which is the host reference implementation.
+ */
+namespace spatial_hash {
+/**
+ * Key stored in unoccupied slots of the table
+ */
+constexpr unsigned long long EMPTY_KEY = ~0ull;
+/**
+ * Slot returned by findSlot() if the key is not in the table
+ */
+constexpr unsigned int NOT_FOUND = 0xffffffff;
+/**
+ * Number of bits used to store each cell coordinate within a key
+ */
+constexpr unsigned int CELL_BITS = 21;
+/**
+ * Mask of the bits of each cell coordinate which are stored within a key
+ */
+constexpr unsigned int CELL_MASK = (1u << CELL_BITS) - 1;
+/**
+ * Minimum number of slots in a table
+ */
+constexpr unsigned int MIN_TABLE_SIZE = 16;
+/**
+ * Returns the grid cell coordinate of a location along a single axis
+ * @param pos The location along the axis
+ * @param radius The width of a grid cell
+ */
+__host__ __device__ __forceinline__ int cellCoord(const float pos, const float radius) {
+    return static_cast<int>(floorf(pos / radius));
+}
+/**
+ * Packs a grid cell's coordinates into a key
+ * Only the low CELL_BITS bits of each coordinate are kept, so coordinates wrap rather than saturate
+ * The top bit of the key is never set, so a key never matches EMPTY_KEY
+ * @param x, y, z The coordinates of the grid cell
+ */
+__host__ __device__ __forceinline__ unsigned long long cellKey(const int x, const int y, const int z) {
+    const int c[3] = { x, y, z };
+    unsigned long long key = 0;
+    for (unsigned int i = 0; i < 3; ++i) {
+        key |= static_cast<unsigned long long>(static_cast<unsigned int>(c[i]) & CELL_MASK) << (i * CELL_BITS);
+    }
+    return key;
+}
+/**
+ * Returns the first slot of the probe sequence for a key
+ * @param key The key to be hashed
+ * @param table_size The number of slots in the table, this must be a power of two
+ */
+__host__ __device__ __forceinline__ unsigned int firstSlot(unsigned long long key, const unsigned int table_size) {
+    // splitmix64 finaliser
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+    key = key ^ (key >> 31);
+    return static_cast<unsigned int>(key) & (table_size - 1);
+}
+/**
+ * Returns the slot which holds a key
+ * @param keys The table of keys
+ * @param table_size The number of slots in the table, this must be a power of two
+ * @param key The key to find
+ * @return The slot which holds the key, or NOT_FOUND if the key is not in the table
+ */
+__host__ __device__ __forceinline__ unsigned int findSlot(const unsigned long long *keys, const unsigned int table_size, const unsigned long long key) {
+    unsigned int slot = firstSlot(key, table_size);
+    for (unsigned int i = 0; i < table_size; ++i) {
+        const unsigned long long k = keys[slot];
+        if (k == key)
+            return slot;
+        if (k == EMPTY_KEY)
+            return NOT_FOUND;
+        slot = (slot + 1) & (table_size - 1);
+    }
+    return NOT_FOUND;
+}
+#ifndef __CUDACC_RTC__
+/**
+ * Inserts a key into the table, if it is not already present
+ * @param keys The table of keys, unoccupied slots must hold EMPTY_KEY
+ * @param table_size The number of slots in the table, this must be a power of two
+ * @param key The key to insert
+ * @return The slot which holds the key, or NOT_FOUND if the table is full
+ */
+inline unsigned int insert(unsigned long long *keys, const unsigned int table_size, const unsigned long long key) {
+    unsigned int slot = firstSlot(key, table_size);
+    for (unsigned int i = 0; i < table_size; ++i) {
+        if (keys[slot] == EMPTY_KEY)
+            keys[slot] = key;
+        if (keys[slot] == key)
+            return slot;
+        slot = (slot + 1) & (table_size - 1);
+    }
+    return NOT_FOUND;
+}
+/**
+ * Returns the number of slots in a table for the specified number of messages
+ * The table is kept at most half full, so that probe sequences remain short
+ * @param message_count The maximum number of messages which will be inserted
+ */
+inline unsigned int tableSize(const unsigned int message_count) {
+    unsigned int size = MIN_TABLE_SIZE;
+    while (size < 2 * message_count) {
+        size <<= 1;
+    }
+    return size;
+}
+#endif  // __CUDACC_RTC__
+}  // namespace spatial_hash
+}  // namespace detail
+}  // namespace util
+}  // namespace flamegpu
+
+#endif  // INCLUDE_FLAMEGPU_UTIL_DETAIL_SPATIALHASH_CUH_
@@ -2,9 +2,12 @@
 
 #include <cuda_runtime.h>
 #include <device_launch_parameters.h>
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
 // If MSVC earlier than VS 2019
 #if defined(_MSC_VER) && _MSC_VER < 1920
 #include <filesystem>
@@ -31,6 +34,7 @@ using std::experimental::filesystem::v1::path;
 #include "flamegpu/gpu/CUDAAgentStateList.h"
 #include "flamegpu/gpu/detail/CUDAErrorChecking.cuh"
 #include "flamegpu/gpu/CUDASimulation.h"
+#include "flamegpu/gpu/CUDAMacroEnvironment.h"
 
 #include "flamegpu/model/AgentDescription.h"
 #include "flamegpu/model/AgentFunctionDescription.h"
@@ -83,6 +87,53 @@ CUDAAgent::CUDAAgent(
         state_map.emplace(state, slimstate);
     }
 }
+CUDAAgent::~CUDAAgent() {
+    for (auto &b : birthBuffers) {
+        if (b.second.d_meta) {
+            gpuErrchk(cudaFree(b.second.d_meta));
+        }
+        if (b.second.d_variables) {
+            gpuErrchk(cudaFree(b.second.d_variables));
+        }
+        if (b.second.d_defaults) {
+            gpuErrchk(cudaFree(b.second.d_defaults));
+        }
+    }
+    birthBuffers.clear();
+    for (auto &a : awakeIndices) {
+        if (a.second.d_index) {
+            gpuErrchk(cudaFree(a.second.d_index));
+        }
+        if (a.second.d_count) {
+            gpuErrchk(cudaFree(a.second.d_count));
+        }
+        if (a.second.d_cub_temp) {
+            gpuErrchk(cudaFree(a.second.d_cub_temp));
+        }
+    }
+    awakeIndices.clear();
+    for (auto &c : wakeCalendars) {
+        if (c.second.d_order) {
+            gpuErrchk(cudaFree(c.second.d_order));
+        }
+        if (c.second.d_keys) {
+            gpuErrchk(cudaFree(c.second.d_keys));
+        }
+        if (c.second.d_cub_temp) {
+            gpuErrchk(cudaFree(c.second.d_cub_temp));
+        }
+        if (c.second.d_counts) {
+            gpuErrchk(cudaFree(c.second.d_counts));
+        }
+        if (c.second.h_counts) {
+            gpuErrchk(cudaFreeHost(c.second.h_counts));
+        }
+        if (c.second.readback) {
+            gpuErrchk(cudaEventDestroy(c.second.readback));
+        }
+    }
+    wakeCalendars.clear();
+}
 
 void CUDAAgent::mapRuntimeVariables(const AgentFunctionData& func, const unsigned int &instance_id) const {
     // check the cuda agent state map to find the correct state list for functions starting state
@@ -181,6 +232,7 @@ void CUDAAgent::setPopulationData(const AgentVector& population, const std::stri
     }
     // Copy population data
     // This call hierarchy validates agent desc matches
+    invalidateWakeCalendars();
     our_state->second->setAgentData(population, scatter, streamId, stream);
     fat_agent->markIDsUnset();
     // Validate that there are no ID collisions
@@ -288,6 +340,16 @@ unsigned int CUDAAgent::getStateSize(const std::string &state) const {
     }
     return sm->second->getSize();
 }
+unsigned int CUDAAgent::getStateSizeWithDisabled(const std::string &state) const {
+    const auto &sm = state_map.find(state);
+
+    if (sm == state_map.end()) {
+        THROW exception::InvalidCudaAgentState("Error: Agent ('%s') state ('%s') was not found, "
+            "in CUDAAgent::getStateSizeWithDisabled()",
+            agent_description.name.c_str(), state.c_str());
+    }
+    return sm->second->getSizeWithDisabled();
+}
 /**
  * Returns the number of alive and active agents in the named state
  */
@@ -311,6 +373,7 @@ void CUDAAgent::resizeState(const std::string& state, const unsigned int& minimu
             "in CUDAAgent::getStateAllocatedSize()",
             agent_description.name.c_str(), state.c_str());
     }
+    invalidateWakeCalendars();
     sm->second->resize(minimumSize, retainData);
 }
 
@@ -323,6 +386,7 @@ void CUDAAgent::setStateAgentCount(const std::string& state, const unsigned int&
             "in CUDAAgent::getStateAllocatedSize()",
             agent_description.name.c_str(), state.c_str());
     }
+    invalidateWakeCalendars();
     sm->second->setAgentCount(newSize);
 }
 const AgentData &CUDAAgent::getAgentDescription() const {
@@ -337,22 +401,41 @@ void *CUDAAgent::getStateVariablePtr(const std::string &state_name, const std::s
             "in CUDAAgent::getStateVariablePtr()",
             agent_description.name.c_str(), state_name.c_str());
     }
+    // The caller may write to the variable
+    invalidateWakeCalendars();
     return sm->second->getVariablePointer(variable_name);
 }
+void *CUDAAgent::getStateVariableReadPtr(const std::string &state_name, const std::string &variable_name) const {
+    // check the cuda agent state map to find the correct state list for functions starting state
+    const auto &sm = state_map.find(state_name);
+
+    if (sm == state_map.end()) {
+        THROW exception::InvalidCudaAgentState("Error: Agent ('%s') state ('%s') was not found, "
+            "in CUDAAgent::getStateVariableReadPtr()",
+            agent_description.name.c_str(), state_name.c_str());
+    }
+    return sm->second->getVariablePointerWithDisabled(variable_name);
+}
 void CUDAAgent::processDeath(const AgentFunctionData& func, CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream) {
     // Optionally process agent death
     if (func.has_agent_death) {
+        invalidateWakeCalendars();
         // Agent death operates on all mapped vars, so handled by fat agent
         fat_agent->processDeath(fat_index, func.initial_state, scatter, streamId, stream);
     }
 }
 void CUDAAgent::transitionState(const std::string &_src, const std::string &_dest, CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream) {
     // All mapped vars need to transition too, so handled by fat agent
+    if (_src != _dest) {
+        invalidateWakeCalendars();
+    }
     fat_agent->transitionState(fat_index, _src, _dest, scatter, streamId, stream);
 }
 void CUDAAgent::processFunctionCondition(const AgentFunctionData& func, CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream) {
     // Optionally process function condition
     if ((func.condition) || (!func.rtc_func_condition_name.empty())) {
+        // Disabled agents are moved to the start of the state, so agent indices change
+        invalidateWakeCalendars();
         // Agent function condition operates on all mapped vars, so handled by fat agent
         fat_agent->processFunctionCondition(fat_index, func.initial_state, scatter, streamId, stream);
     }
@@ -364,6 +447,7 @@ void CUDAAgent::scatterHostCreation(const std::string &state_name, const unsigne
             "in CUDAAgent::scatterHostCreation()",
             agent_description.name.c_str(), state_name.c_str());
     }
+    invalidateWakeCalendars();
     sm->second->scatterHostCreation(newSize, d_inBuff, offsets, scatter, streamId, stream);
 }
 void CUDAAgent::scatterSort(const std::string &state_name, CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream) {
@@ -373,6 +457,7 @@ void CUDAAgent::scatterSort(const std::string &state_name, CUDAScatter &scatter,
             "in CUDAAgent::scatterHostCreation()",
             agent_description.name.c_str(), state_name.c_str());
     }
+    invalidateWakeCalendars();
     sm->second->scatterSort(scatter, streamId, stream);
 }
 void CUDAAgent::mapNewRuntimeVariables(const CUDAAgent& func_agent, const AgentFunctionData& func, const unsigned int &maxLen, CUDAScatter &scatter, const unsigned int &instance_id, const unsigned int &streamId) {
@@ -386,14 +471,68 @@ void CUDAAgent::mapNewRuntimeVariables(const CUDAAgent& func_agent, const AgentF
                 "in CUDAAgent::mapNewRuntimeVariables()",
                 agent_description.name.c_str(), func.agent_output_state.c_str());
         }
-        // Notify scan flag that it might need resizing
-        // We need a 3rd array, because a function might combine agent birth, agent death and message output
-        scatter.Scan().resize(maxLen, CUDAScanCompaction::AGENT_OUTPUT, streamId);
-        // Ensure the scan flag is zeroed
-        scatter.Scan().zero(CUDAScanCompaction::AGENT_OUTPUT, streamId);
+        // Compact birth buffers only hold slots for the expected number of births, which claim slots as they occur
+        // Births beyond the capacity spill into the swap buffers of the executing state, so this agent must be executing the function
+        unsigned int bufferLen = maxLen;
+        bool compact = false;
+        if (func.agent_output_birth_rate < 1.0f && &func_agent == this) {
+            std::lock_guard<std::mutex> guard(newBuffsMutex);
+            BirthBuffer &bb = birthBuffers[birthBufferKey(func)];
+            if (!bb.d_meta) {
+                // Gather the size and default value of each variable, in the order they are stored within the birth buffer
+                std::vector<char> defaults;
+                for (const auto &mmp : agent_description.variables) {
+                    const unsigned int hash = detail::DeviceBirthBuffer::hash(mmp.first.c_str());
+                    for (const auto &v : bb.variables) {
+                        if (v.hash == hash) {
+                            THROW exception::InvalidAgentVar("Agent ('%s') variable ('%s') has a hash collision with another variable, "
+                                "so agent function '%s' cannot use a compact birth buffer, "
+                                "in CUDAAgent::mapNewRuntimeVariables()",
+                                agent_description.name.c_str(), mmp.first.c_str(), func.name.c_str());
+                        }
+                    }
+                    const size_t var_size = mmp.second.type_size * mmp.second.elements;
+                    // The default pointer is an offset into defaults until it is uploaded
+                    bb.variables.push_back({ hash, static_cast<unsigned int>(mmp.second.type_size), mmp.second.elements, nullptr, reinterpret_cast<const char*>(defaults.size()) });
+                    defaults.resize(defaults.size() + var_size, 0);
+                    if (mmp.second.default_value) {
+                        memcpy(defaults.data() + defaults.size() - var_size, mmp.second.default_value, var_size);
+                    }
+                }
+                gpuErrchk(cudaMalloc(&bb.d_defaults, defaults.size()));
+                gpuErrchk(cudaMemcpy(bb.d_defaults, defaults.data(), defaults.size(), cudaMemcpyHostToDevice));
+                for (auto &v : bb.variables) {
+                    v.default_value = bb.d_defaults + reinterpret_cast<size_t>(v.default_value);
+                }
+                gpuErrchk(cudaMalloc(&bb.d_variables, bb.variables.size() * sizeof(detail::DeviceBirthBuffer::Variable)));
+                gpuErrchk(cudaMalloc(&bb.d_meta, sizeof(detail::DeviceBirthBuffer)));
+            }
+            // Swap buffers may be reallocated between steps, so the spill pointers are updated each time
+            const auto &exec_state = state_map.at(func.initial_state);
+            auto v = bb.variables.begin();
+            for (const auto &mmp : agent_description.variables) {
+                (v++)->spill = static_cast<char*>(exec_state->getVariableSwapPointer(mmp.first));
+            }
+            gpuErrchk(cudaMemcpy(bb.d_variables, bb.variables.data(), bb.variables.size() * sizeof(detail::DeviceBirthBuffer::Variable), cudaMemcpyHostToDevice));
+            // Size the buffer by the birth rate, or the most births previously output, whichever is larger
+            const unsigned int rate_capacity = static_cast<unsigned int>(std::ceil(static_cast<double>(func.agent_output_birth_rate) * maxLen));
+            bufferLen = std::min(maxLen, std::max(rate_capacity, bb.high_water));
+            const detail::DeviceBirthBuffer meta = { 0, bufferLen, static_cast<unsigned int>(bb.variables.size()), bb.d_variables };
+            gpuErrchk(cudaMemcpy(bb.d_meta, &meta, sizeof(detail::DeviceBirthBuffer), cudaMemcpyHostToDevice));
+            bb.capacity = bufferLen;
+            bb.count = 0;
+            compact = true;
+        }
+        if (!compact) {
+            // Notify scan flag that it might need resizing
+            // We need a 3rd array, because a function might combine agent birth, agent death and message output
+            scatter.Scan().resize(maxLen, CUDAScanCompaction::AGENT_OUTPUT, streamId);
+            // Ensure the scan flag is zeroed
+            scatter.Scan().zero(CUDAScanCompaction::AGENT_OUTPUT, streamId);
+        }
 
         // Request a buffer for new
-        char *d_new_buffer = static_cast<char*>(fat_agent->allocNewBuffer(TOTAL_AGENT_VARIABLE_SIZE, maxLen, agent_description.variables.size()));
+        char *d_new_buffer = static_cast<char*>(fat_agent->allocNewBuffer(TOTAL_AGENT_VARIABLE_SIZE, bufferLen, agent_description.variables.size()));
 
         // Store buffer so we can release it later
         {
@@ -410,7 +549,7 @@ void CUDAAgent::mapNewRuntimeVariables(const CUDAAgent& func_agent, const AgentF
             0,
             agent_description.variables,
             d_new_buffer,
-            maxLen, 0);
+            bufferLen, 0);
 
         // Map variables to curve
         const detail::curve::Curve::VariableHash _agent_birth_hash = detail::curve::Curve::variableRuntimeHash("_agent_birth");
@@ -428,7 +567,7 @@ void CUDAAgent::mapNewRuntimeVariables(const CUDAAgent& func_agent, const AgentF
             void* d_ptr = d_new_buffer;
 
             // Move the pointer along for next variable
-            d_new_buffer += type_size * maxLen;
+            d_new_buffer += type_size * bufferLen;
 
             // 64 bit align the new buffer start
             if (reinterpret_cast<size_t>(d_new_buffer)%8) {
@@ -438,12 +577,12 @@ void CUDAAgent::mapNewRuntimeVariables(const CUDAAgent& func_agent, const AgentF
             // maximum population num
             if (func.func) {
 #ifdef _DEBUG
-                const detail::curve::Curve::Variable cv = curve.registerVariableByHash(var_hash + (_agent_birth_hash ^ func_hash) + instance_id, d_ptr, type_size, maxLen);
+                const detail::curve::Curve::Variable cv = curve.registerVariableByHash(var_hash + (_agent_birth_hash ^ func_hash) + instance_id, d_ptr, type_size, bufferLen);
                 if (cv != static_cast<int>((var_hash + (_agent_birth_hash ^ func_hash) + instance_id)%detail::curve::Curve::MAX_VARIABLES)) {
                     fprintf(stderr, "detail::curve::Curve Warning: Agent Function '%s' New Agent Variable '%s' has a collision and may work improperly.\n", func.name.c_str(), mmp.first.c_str());
                 }
 #else
-                curve.registerVariableByHash(var_hash + (_agent_birth_hash ^ func_hash) + instance_id, d_ptr, type_size, maxLen);
+                curve.registerVariableByHash(var_hash + (_agent_birth_hash ^ func_hash) + instance_id, d_ptr, type_size, bufferLen);
 #endif
             } else  {
                 // Map RTC variables (these must be mapped before each function execution as the runtime pointer may have changed to the swapping)
@@ -467,6 +606,10 @@ void CUDAAgent::unmapNewRuntimeVariables(const AgentFunctionData& func, const un
             } else {
                 assert(false);  // We don't have a new buffer reserved???
             }
+            const auto b = birthBuffers.find(birthBufferKey(func));
+            if (b != birthBuffers.end()) {
+                b->second.capacity = 0;
+            }
         }
         // Skip if RTC
         if (!func.func)
@@ -486,6 +629,53 @@ void CUDAAgent::unmapNewRuntimeVariables(const AgentFunctionData& func, const un
     }
 }
 
+void CUDAAgent::gatherSpilledBirths(const AgentFunctionData& func, CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream) {
+    if (!func.agent_output.lock() || func.agent_output_birth_rate >= 1.0f)
+        return;
+    std::lock_guard<std::mutex> guard(newBuffsMutex);
+    const auto b = birthBuffers.find(birthBufferKey(func));
+    if (b == birthBuffers.end() || !b->second.capacity)
+        return;
+    BirthBuffer &bb = b->second;
+    // Births were allocated slots in order, so the count is all that is required to collect them
+    gpuErrchk(cudaMemcpyAsync(&bb.count, &bb.d_meta->count, sizeof(unsigned int), cudaMemcpyDeviceToHost, stream));
+    gpuErrchk(cudaStreamSynchronize(stream));
+    bb.high_water = std::max(bb.high_water, bb.count);
+    if (bb.count <= bb.capacity)
+        return;
+    // Births exceeded the capacity, so grow the birth buffer to hold every birth
+    const auto d_buff = newBuffs.find(func.initial_state);
+    if (d_buff == newBuffs.end()) {
+        THROW exception::InvalidAgentFunc("New buffer not present for function within init state: %s,"
+            " in CUDAAgent::gatherSpilledBirths()\n",
+            func.initial_state.c_str());
+    }
+    char *d_old_var = static_cast<char*>(d_buff->second);
+    char *const d_new_buffer = static_cast<char*>(fat_agent->allocNewBuffer(TOTAL_AGENT_VARIABLE_SIZE, bb.count, agent_description.variables.size()));
+    char *d_new_var = d_new_buffer;
+    std::vector<CUDAScatter::ScatterData> retained, spilled;
+    auto v = bb.variables.begin();
+    for (const auto &mmp : agent_description.variables) {
+        const size_t type_size = mmp.second.type_size * mmp.second.elements;
+        retained.push_back({ type_size, d_old_var, d_new_var });
+        spilled.push_back({ type_size, (v++)->spill, d_new_var });
+        // Move the pointers along for next variable, 64 bit aligned
+        d_old_var += type_size * bb.capacity;
+        if (reinterpret_cast<size_t>(d_old_var)%8) {
+            d_old_var += 8 - (reinterpret_cast<size_t>(d_old_var)%8);
+        }
+        d_new_var += type_size * bb.count;
+        if (reinterpret_cast<size_t>(d_new_var)%8) {
+            d_new_var += 8 - (reinterpret_cast<size_t>(d_new_var)%8);
+        }
+    }
+    // Births which fit in the buffer keep their slot, spilled births follow them in order of slot
+    scatter.scatterAll(streamId, stream, retained, bb.capacity, 0);
+    scatter.scatterAll(streamId, stream, spilled, bb.count - bb.capacity, bb.capacity);
+    fat_agent->freeNewBuffer(d_buff->second);
+    d_buff->second = d_new_buffer;
+    bb.capacity = bb.count;
+}
 void CUDAAgent::scatterNew(const AgentFunctionData& func, const unsigned int &newSize, CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream) {
     // Confirm agent output is set
     if (auto oa = func.agent_output.lock()) {
@@ -509,8 +699,27 @@ void CUDAAgent::scatterNew(const AgentFunctionData& func, const unsigned int &ne
                 " in CUDAAgent::scatterNew()\n",
                 func.initial_state.c_str());
         }
-        unsigned int new_births = sm->second->scatterNew(newBuff, newSize, scatter, streamId, stream);
+        // Check whether a compact birth buffer was used
+        BirthBuffer *bb = nullptr;
+        if (func.agent_output_birth_rate < 1.0f) {
+            std::lock_guard<std::mutex> guard(newBuffsMutex);
+            const auto b = birthBuffers.find(birthBufferKey(func));
+            if (b != birthBuffers.end() && b->second.capacity) {
+                bb = &b->second;
+            }
+        }
+        unsigned int new_births = 0;
+        if (bb) {
+            // Births were allocated slots in order, so no scan is required
+            // gatherSpilledBirths() has read back the number of births, and gathered any spilled births into the buffer
+            new_births = sm->second->scatterNewCompact(newBuff, bb->capacity, bb->count, scatter, streamId, stream);
+        } else {
+            new_births = sm->second->scatterNew(newBuff, newSize, scatter, streamId, stream);
+        }
         fat_agent->notifyDeviceBirths(new_births);
+        if (new_births) {
+            invalidateWakeCalendars();
+        }
     }
 }
 void CUDAAgent::clearFunctionCondition(const std::string &state) {
@@ -559,13 +768,17 @@ void CUDAAgent::addInstantitateRTCFunction(const AgentFunctionData& func, bool f
         // Scope the mutex
         auto lock = EnvironmentManager::getInstance().getSharedLock();
         const auto &prop_map = EnvironmentManager::getInstance().getPropertiesMap();
+        // Const properties cannot change after initialisation, so their values can be folded into the dynamic header
+        const bool fold_constants = cudaSimulation.getCUDAConfig().foldRTCConstants;
+        const char *h_buffer = static_cast<const char*>(EnvironmentManager::getInstance().getHostBuffer());
         for (auto p : prop_map) {
             if (p.first.first == cudaSimulation.getInstanceID()) {
                 const char* variableName = p.first.second.c_str();
                 const char* type = p.second.type.name();
                 unsigned int elements = p.second.elements;
                 ptrdiff_t offset = p.second.rtc_offset;
-                curve_header.registerEnvVariable(variableName, offset, type, p.second.length/elements, elements);
+                const void *const_value = fold_constants && p.second.isConst ? h_buffer + p.second.offset : nullptr;
+                curve_header.registerEnvVariable(variableName, offset, type, p.second.length/elements, elements, const_value);
             }
         }
         // Set mapped environment variables in curve
@@ -576,11 +789,16 @@ void CUDAAgent::addInstantitateRTCFunction(const AgentFunctionData& func, bool f
                 const char* type = p.type.name();
                 unsigned int elements = p.elements;
                 ptrdiff_t offset = p.rtc_offset;
-                curve_header.registerEnvVariable(variableName, offset, type, p.length/elements, elements);
+                // Only fold if the master property is const, otherwise the master model may change it
+                const void *const_value = fold_constants && p.isConst ? h_buffer + p.offset : nullptr;
+                curve_header.registerEnvVariable(variableName, offset, type, p.length/elements, elements, const_value);
             }
         }
     }
 
+    // Set Environment macro properties in curve
+    cudaSimulation.getMacroEnvironment().mapRTCVariables(curve_header);
+
     // get the dynamically generated header from curve rtc
     std::string curve_dynamic_header = curve_header.getDynamicHeader();
 
@@ -657,6 +875,7 @@ const CUDAAgent::CUDARTCFuncMap& CUDAAgent::getRTCFunctions() const {
 }
 
 void CUDAAgent::initUnmappedVars(CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream) {
+    invalidateWakeCalendars();
     for (auto &s : state_map) {
         s.second->initUnmappedVars(scatter, streamId, stream);
     }
@@ -670,9 +889,11 @@ void CUDAAgent::initExcludedVars(const std::string &state, const unsigned int&co
             "in CUDAAgent::initUnmappedVars()",
             agent_description.name.c_str(), state.c_str());
     }
+    invalidateWakeCalendars();
     sm->second->initExcludedVars(count, offset, scatter, streamId, stream);
 }
 void CUDAAgent::cullUnmappedStates() {
+    invalidateWakeCalendars();
     unsigned int i = 0;
     for (auto &s : state_map) {
         if (!s.second->getIsSubStatelist()) {
@@ -684,6 +905,7 @@ void CUDAAgent::cullUnmappedStates() {
         fat_agent->resetIDCounter();
 }
 void CUDAAgent::cullAllStates() {
+    invalidateWakeCalendars();
     for (auto &s : state_map) {
         s.second->clear();
     }
@@ -697,6 +919,7 @@ std::list<std::shared_ptr<VariableBuffer>> CUDAAgent::getUnboundVariableBuffers(
             "in CUDAAgent::getUnboundVariableBuffers()",
             agent_description.name.c_str(), state.c_str());
     }
+    invalidateWakeCalendars();
     return sm->second->getUnboundVariableBuffers();
 }
 id_t CUDAAgent::nextID(unsigned int count) {
@@ -705,6 +928,248 @@ id_t CUDAAgent::nextID(unsigned int count) {
 id_t* CUDAAgent::getDeviceNextID() {
     return fat_agent->getDeviceNextID();
 }
+std::string CUDAAgent::birthBufferKey(const AgentFunctionData& func) {
+    const auto parent = func.parent.lock();
+    return (parent ? parent->name : std::string()) + "::" + func.name;
+}
+detail::DeviceBirthBuffer *CUDAAgent::getDeviceBirthBuffer(const AgentFunctionData& func) {
+    std::lock_guard<std::mutex> guard(newBuffsMutex);
+    const auto b = birthBuffers.find(birthBufferKey(func));
+    if (b != birthBuffers.end() && b->second.capacity)
+        return b->second.d_meta;
+    return nullptr;
+}
+/**
+ * Selects agents whose wake step has been reached
+ */
+struct AwakeSelect {
+    const unsigned int *d_wake_step;
+    unsigned int step;
+    __device__ __forceinline__ bool operator()(const unsigned int &i) const {
+        return d_wake_step[i] <= step;
+    }
+};
+__global__ void setAliveFlags(unsigned int *d_flags, unsigned int threads) {
+    const unsigned int index = (blockIdx.x * blockDim.x) + threadIdx.x;
+    if (index < threads) {
+        d_flags[index] = 1;
+    }
+}
+/**
+ * Counts agents into the device resident form of a wake calendar, relative to step
+ * Equivalent to CalendarQueue::insert(), with the number of agents already awake counted into d_counts[bucket_count + 1]
+ * @param d_wake_step The wake step of each agent in the state
+ * @param d_index If not nullptr, the indices of the agents to count, else the first threads agents are counted
+ * @param threads The number of agents to count
+ * @param step The step the calendar is relative to
+ * @param bucket_count The number of buckets in the calendar
+ * @param d_counts The bucket_count + 2 counters to count the agents into
+ * @param d_keys If not nullptr, receives each agent's sort key: 0 if awake, else the steps until it wakes, capped at bucket_count + 1
+ * @param d_order If d_keys is not nullptr, receives each agent's index
+ */
+__global__ void buildWakeCalendar(const unsigned int *d_wake_step, const unsigned int *d_index, unsigned int threads, unsigned int step, unsigned int bucket_count,
+    unsigned int *d_counts, unsigned int *d_keys, unsigned int *d_order) {
+    const unsigned int tid = (blockIdx.x * blockDim.x) + threadIdx.x;
+    if (tid < threads) {
+        const unsigned int index = d_index ? d_index[tid] : tid;
+        const unsigned int wake_step = d_wake_step[index];
+        unsigned int key = 0;
+        if (wake_step > step) {
+            if (wake_step - step <= bucket_count) {
+                atomicAdd(d_counts + util::detail::CalendarQueue::bucketOf(wake_step, bucket_count), 1u);
+                key = wake_step - step;
+            } else {
+                atomicMin(d_counts + bucket_count, wake_step);
+                key = bucket_count + 1;
+            }
+        } else {
+            atomicAdd(d_counts + bucket_count + 1, 1u);
+        }
+        if (d_keys) {
+            d_keys[tid] = key;
+            d_order[tid] = index;
+        }
+    }
+}
+unsigned int CUDAAgent::mapAwakeIndex(const AgentFunctionData& func, const unsigned int &stepCount, unsigned int *d_deathFlags, const cudaStream_t &stream) {
+    const unsigned int state_size = getStateSize(func.initial_state);
+    AwakeIndex &a = awakeIndices[func.name];
+    a.mapped = false;
+    // State transitions apply to every agent in the state, so these functions cannot skip sleeping agents
+    if (!state_size || func.include_sleeping || func.initial_state != func.end_state
+        || agent_description.variables.find(WAKE_STEP_VARIABLE_NAME) == agent_description.variables.end()) {
+        // The function may modify the wake step of any agent in the state
+        wakeCalendars[func.initial_state].valid = false;
+        return state_size;
+    }
+    WakeCalendar &c = wakeCalendars[func.initial_state];
+    const unsigned int bucket_count = c.calendar.getBucketCount();
+    if (c.readback_pending) {
+        // Complete the read back issued by updateWakeCalendar(), this has normally completed during the previous layer
+        gpuErrchk(cudaEventSynchronize(c.readback));
+        std::copy(c.h_counts, c.h_counts + bucket_count + 1, c.popped_calendar.data());
+        c.popped_awake = c.h_counts[bucket_count + 1];
+        c.readback_pending = false;
+    }
+    // Access the buffer directly, as getStateVariablePtr() would invalidate the calendar
+    const unsigned int *d_wake_step = static_cast<const unsigned int*>(state_map.at(func.initial_state)->getVariablePointer(WAKE_STEP_VARIABLE_NAME));
+    // Pop the buckets due since the previous pop, these agents are all awake
+    // Agents popped previously may have changed their wake step, so the awake agents are selected from every popped agent
+    // Submodel agents share their buffers, so may have been modified without the calendar being invalidated
+    unsigned int awake_count = util::detail::CalendarQueue::UNKNOWN;
+    if (c.valid && c.size == state_size && stepCount >= c.popped_step && fat_agent->getMappedAgentCount() == 1) {
+        const unsigned int due = c.calendar.dueBy(stepCount);
+        const unsigned int popped_due = c.popped_calendar.dueBy(stepCount);
+        // Once the popped agents outnumber half the state, it is cheaper to rebuild the calendar
+        if (due != util::detail::CalendarQueue::UNKNOWN && popped_due != util::detail::CalendarQueue::UNKNOWN && due <= state_size / 2) {
+            awake_count = c.popped_awake + popped_due + due - c.calendar.dueBy(c.popped_step);
+            c.popped_count = c.build_awake + due;
+            c.popped_step = stepCount;
+            if (!awake_count) {
+                return 0;
+            }
+        }
+    }
+    // Sleeping agents do not write their death flag
+    if (d_deathFlags) {
+        int blockSize = 0;
+        int minGridSize = 0;
+        cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, setAliveFlags, 0, state_size);
+        const unsigned int gridSize = (state_size + blockSize - 1) / blockSize;
+        setAliveFlags<<<gridSize, blockSize, 0, stream>>>(d_deathFlags, state_size);
+        gpuErrchkLaunch();
+    }
+    if (state_size > a.capacity) {
+        if (a.d_index) {
+            gpuErrchk(cudaFree(a.d_index));
+        }
+        gpuErrchk(cudaMalloc(&a.d_index, state_size * sizeof(unsigned int)));
+        a.capacity = state_size;
+    }
+    if (awake_count != util::detail::CalendarQueue::UNKNOWN) {
+        if (!a.d_count) {
+            gpuErrchk(cudaMalloc(&a.d_count, sizeof(unsigned int)));
+        }
+        const AwakeSelect select_op = { d_wake_step, stepCount };
+        size_t temp_size = 0;
+        gpuErrchk(cub::DeviceSelect::If(nullptr, temp_size, c.d_order, a.d_index, a.d_count, c.popped_count, select_op, stream));
+        if (temp_size > a.cub_temp_size) {
+            if (a.d_cub_temp) {
+                gpuErrchk(cudaFree(a.d_cub_temp));
+            }
+            gpuErrchk(cudaMalloc(&a.d_cub_temp, temp_size));
+            a.cub_temp_size = temp_size;
+        }
+        // The number of awake agents is already known, so the stream does not need to be synchronised
+        gpuErrchk(cub::DeviceSelect::If(a.d_cub_temp, a.cub_temp_size, c.d_order, a.d_index, a.d_count, c.popped_count, select_op, stream));
+        a.mapped = true;
+        return awake_count;
+    }
+    // Rebuild the calendar, by sorting the agent indices by wake step
+    if (state_size > c.capacity) {
+        if (c.d_order) {
+            gpuErrchk(cudaFree(c.d_order));
+        }
+        if (c.d_keys) {
+            gpuErrchk(cudaFree(c.d_keys));
+        }
+        gpuErrchk(cudaMalloc(&c.d_order, 2 * state_size * sizeof(unsigned int)));
+        gpuErrchk(cudaMalloc(&c.d_keys, 2 * state_size * sizeof(unsigned int)));
+        c.capacity = state_size;
+    }
+    if (!c.d_counts) {
+        gpuErrchk(cudaMalloc(&c.d_counts, (bucket_count + 2) * sizeof(unsigned int)));
+        gpuErrchk(cudaMallocHost(&c.h_counts, (bucket_count + 2) * sizeof(unsigned int)));
+    }
+    gpuErrchk(cudaMemsetAsync(c.d_counts, 0, bucket_count * sizeof(unsigned int), stream));
+    gpuErrchk(cudaMemsetAsync(c.d_counts + bucket_count, 0xff, sizeof(unsigned int), stream));  // CalendarQueue::UNKNOWN
+    gpuErrchk(cudaMemsetAsync(c.d_counts + bucket_count + 1, 0, sizeof(unsigned int), stream));
+    {
+        int blockSize = 0;
+        int minGridSize = 0;
+        cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, buildWakeCalendar, 0, state_size);
+        const unsigned int gridSize = (state_size + blockSize - 1) / blockSize;
+        buildWakeCalendar<<<gridSize, blockSize, 0, stream>>>(d_wake_step, nullptr, state_size, stepCount, bucket_count, c.d_counts, c.d_keys + c.capacity, c.d_order + c.capacity);
+        gpuErrchkLaunch();
+    }
+    // Sort keys are at most bucket_count + 1, the sort is stable so each bucket remains in agent index order
+    int end_bit = 1;
+    while ((1u << end_bit) < bucket_count + 2) {
+        ++end_bit;
+    }
+    size_t temp_size = 0;
+    gpuErrchk(cub::DeviceRadixSort::SortPairs(nullptr, temp_size, c.d_keys + c.capacity, c.d_keys, c.d_order + c.capacity, c.d_order, state_size, 0, end_bit, stream));
+    if (temp_size > c.cub_temp_size) {
+        if (c.d_cub_temp) {
+            gpuErrchk(cudaFree(c.d_cub_temp));
+        }
+        gpuErrchk(cudaMalloc(&c.d_cub_temp, temp_size));
+        c.cub_temp_size = temp_size;
+    }
+    gpuErrchk(cub::DeviceRadixSort::SortPairs(c.d_cub_temp, c.cub_temp_size, c.d_keys + c.capacity, c.d_keys, c.d_order + c.capacity, c.d_order, state_size, 0, end_bit, stream));
+    gpuErrchk(cudaMemcpyAsync(c.h_counts, c.d_counts, (bucket_count + 2) * sizeof(unsigned int), cudaMemcpyDeviceToHost, stream));
+    gpuErrchk(cudaStreamSynchronize(stream));
+    c.calendar.reset(stepCount);
+    std::copy(c.h_counts, c.h_counts + bucket_count + 1, c.calendar.data());
+    c.popped_calendar.reset(stepCount);
+    c.build_awake = c.h_counts[bucket_count + 1];
+    c.popped_awake = c.build_awake;
+    c.popped_step = stepCount;
+    c.popped_count = c.build_awake;
+    c.size = state_size;
+    c.valid = true;
+    if (!c.build_awake) {
+        return 0;
+    }
+    // The awake agents are the front of the sorted agent indices
+    gpuErrchk(cudaMemcpyAsync(a.d_index, c.d_order, c.build_awake * sizeof(unsigned int), cudaMemcpyDeviceToDevice, stream));
+    a.mapped = true;
+    return c.build_awake;
+}
+void CUDAAgent::updateWakeCalendar(const AgentFunctionData& func, const unsigned int &stepCount, const cudaStream_t &stream) {
+    const auto a = awakeIndices.find(func.name);
+    if (a == awakeIndices.end() || !a->second.mapped) {
+        return;
+    }
+    WakeCalendar &c = wakeCalendars.at(func.initial_state);
+    // Agent death compacts the state, which invalidates the calendar
+    if (!c.valid || func.has_agent_death) {
+        return;
+    }
+    // Only popped agents have executed, so only they need to be counted again
+    const unsigned int bucket_count = c.calendar.getBucketCount();
+    const unsigned int *d_wake_step = static_cast<const unsigned int*>(state_map.at(func.initial_state)->getVariablePointer(WAKE_STEP_VARIABLE_NAME));
+    gpuErrchk(cudaMemsetAsync(c.d_counts, 0, bucket_count * sizeof(unsigned int), stream));
+    gpuErrchk(cudaMemsetAsync(c.d_counts + bucket_count, 0xff, sizeof(unsigned int), stream));  // CalendarQueue::UNKNOWN
+    gpuErrchk(cudaMemsetAsync(c.d_counts + bucket_count + 1, 0, sizeof(unsigned int), stream));
+    {
+        int blockSize = 0;
+        int minGridSize = 0;
+        cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, buildWakeCalendar, 0, c.popped_count);
+        const unsigned int gridSize = (c.popped_count + blockSize - 1) / blockSize;
+        buildWakeCalendar<<<gridSize, blockSize, 0, stream>>>(d_wake_step, c.d_order, c.popped_count, stepCount, bucket_count, c.d_counts, nullptr, nullptr);
+        gpuErrchkLaunch();
+    }
+    // The simulation synchronises the stream at the end of the layer, so mapAwakeIndex() will not normally wait on the read back
+    gpuErrchk(cudaMemcpyAsync(c.h_counts, c.d_counts, (bucket_count + 2) * sizeof(unsigned int), cudaMemcpyDeviceToHost, stream));
+    if (!c.readback) {
+        gpuErrchk(cudaEventCreateWithFlags(&c.readback, cudaEventDisableTiming));
+    }
+    gpuErrchk(cudaEventRecord(c.readback, stream));
+    c.popped_calendar.reset(stepCount);
+    c.readback_pending = true;
+}
+const unsigned int *CUDAAgent::getDeviceAwakeIndex(const AgentFunctionData& func) const {
+    const auto a = awakeIndices.find(func.name);
+    if (a != awakeIndices.end() && a->second.mapped)
+        return a->second.d_index;
+    return nullptr;
+}
+void CUDAAgent::invalidateWakeCalendars() {
+    for (auto &c : wakeCalendars) {
+        c.second.valid = false;
+    }
+}
 void CUDAAgent::assignIDs(HostAPI& hostapi) {
     fat_agent->assignIDs(hostapi);
 }
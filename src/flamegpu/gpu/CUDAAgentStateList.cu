@@ -59,6 +59,9 @@ void CUDAAgentStateList::resize(const unsigned int &minimumSize, const bool &ret
 unsigned int CUDAAgentStateList::getSize() const {
     return parent_list->getSize();
 }
+unsigned int CUDAAgentStateList::getSizeWithDisabled() const {
+    return parent_list->getSizeWithDisabled();
+}
 /**
  * Returns the maximum number of agents that can be stored based on the current buffer allocations
  */
@@ -77,6 +80,28 @@ void *CUDAAgentStateList::getVariablePointer(const std::string &variable_name) {
 
     return var->second->data_condition;
 }
+void *CUDAAgentStateList::getVariablePointerWithDisabled(const std::string &variable_name) {
+    auto var = variables.find(variable_name);
+
+    if (var == variables.end()) {
+        THROW exception::InvalidAgentVar("Error: Agent ('%s') variable ('%s') was not found "
+            "in CUDAAgentStateList::getVariablePointerWithDisabled()",
+            agent.getAgentDescription().name.c_str(), variable_name.c_str());
+    }
+
+    return var->second->data;
+}
+void *CUDAAgentStateList::getVariableSwapPointer(const std::string &variable_name) {
+    auto var = variables.find(variable_name);
+
+    if (var == variables.end()) {
+        THROW exception::InvalidAgentVar("Error: Agent ('%s') variable ('%s') was not found "
+            "in CUDAAgentStateList::getVariableSwapPointer()",
+            agent.getAgentDescription().name.c_str(), variable_name.c_str());
+    }
+
+    return var->second->data_swap;
+}
 void CUDAAgentStateList::setAgentData(const AgentVector& population, CUDAScatter& scatter, const unsigned int& streamId, const cudaStream_t& stream) {
     // Validate AgentData matches
     if (!population.matchesAgentType(agent.getAgentDescription())) {
@@ -237,6 +262,42 @@ unsigned int CUDAAgentStateList::scatterNew(void * d_newBuff, const unsigned int
     }
     return 0;
 }
+unsigned int CUDAAgentStateList::scatterNewCompact(void * d_newBuff, const unsigned int &bufferLen, const unsigned int &newCount, CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream) {
+    if (newCount) {
+        // Resize if necessary
+        resize(parent_list->getSizeWithDisabled() + newCount, true);
+        // Build scatter data
+        char * d_var = static_cast<char*>(d_newBuff);
+
+        std::vector<CUDAScatter::ScatterData> scatterdata;
+        for (const auto &v : variables) {
+            char *in_p = reinterpret_cast<char*>(d_var);
+            char *out_p = reinterpret_cast<char*>(v.second->data_condition);
+            scatterdata.push_back({ v.second->type_size * v.second->elements, in_p, out_p });
+            // Prep pointer for next var
+            d_var += v.second->type_size * v.second->elements * bufferLen;
+            // 64 bit align the new buffer start
+            if (reinterpret_cast<size_t>(d_var)%8) {
+                d_var += 8 - (reinterpret_cast<size_t>(d_var)%8);
+            }
+        }
+        // New agents are already packed, so copy them directly
+        scatter.scatterAll(
+            streamId,
+            stream,
+            scatterdata,
+            newCount, parent_list->getSizeWithDisabled());
+        // Initialise any buffers in the fat_agent which aren't part of the current agent description
+        std::set<std::shared_ptr<VariableBuffer>> exclusionSet;
+        for (auto &a : variables)
+            exclusionSet.insert(a.second);
+        parent_list->initVariables(exclusionSet, newCount, parent_list->getSize(), scatter, streamId, stream);
+        // Update number of alive agents
+        parent_list->setAgentCount(parent_list->getSize() + newCount);
+        return newCount;
+    }
+    return 0;
+}
 bool CUDAAgentStateList::getIsSubStatelist() {
     return isSubStateList;
 }
@@ -8,6 +8,7 @@
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <vector>
 
 #include "flamegpu/version.h"
 #include "flamegpu/model/ModelDescription.h"
@@ -21,6 +22,7 @@
 #include "flamegpu/sim/SimRunner.h"
 #include "flamegpu/sim/LogFrame.h"
 #include "flamegpu/sim/SimLogger.h"
+#include "flamegpu/runtime/utility/EnvironmentTableCache.h"
 
 namespace flamegpu {
 
@@ -92,6 +94,15 @@ void CUDAEnsemble::simulate(const RunPlanVector &plans) {
             gpuErrchk(cudaFree(nullptr));
         }
     }
+    // Upload each read-only environment table once per device, holding it until all runs have completed
+    // Otherwise each run would upload its own copy, as tables are released with the last simulation using them
+    std::vector<std::shared_ptr<const detail::EnvironmentTable>> resident_tables;
+    for (const auto &d : devices) {
+        gpuErrchk(cudaSetDevice(d));
+        for (const auto &t : model->environment->getTablesMap()) {
+            resident_tables.push_back(detail::EnvironmentTableCache::getInstance().acquire(t.second.file_path));
+        }
+    }
     // Return to device 0 (or check original device first?)
     gpuErrchk(cudaSetDevice(0));
 
@@ -0,0 +1,284 @@
+#include "flamegpu/gpu/CUDAMacroEnvironment.h"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "flamegpu/gpu/detail/CUDAErrorChecking.cuh"
+#include "flamegpu/gpu/CUDASimulation.h"
+#include "flamegpu/model/EnvironmentDescription.h"
+#include "flamegpu/runtime/detail/curve/curve.cuh"
+#include "flamegpu/runtime/detail/curve/curve_rtc.cuh"
+#include "flamegpu/runtime/utility/DeviceEnvironment.cuh"
+#include "flamegpu/util/nvtx.h"
+
+namespace flamegpu {
+
+const char CUDAMacroEnvironment::CURVE_NAMESPACE_STRING[29] = "MACRO_ENVIRONMENT_PROPERTIES";
+
+HostMacroProperty_MetaData::HostMacroProperty_MetaData(void *_d_base_ptr, const std::array<unsigned int, 4> &_elements, const size_t &_type_size, const std::string &_name)
+    : h_base_ptr(nullptr)
+    , d_base_ptr(_d_base_ptr)
+    , elements(_elements)
+    , type_size(_type_size)
+    , name(_name)
+    , has_changed(false) {
+    h_base_ptr = static_cast<char*>(malloc(type_size * elementCount()));
+    download();
+}
+HostMacroProperty_MetaData::~HostMacroProperty_MetaData() {
+    upload();
+    ::free(h_base_ptr);
+}
+void HostMacroProperty_MetaData::download() {
+    gpuErrchk(cudaMemcpy(h_base_ptr, d_base_ptr, type_size * elementCount(), cudaMemcpyDeviceToHost));
+    has_changed = false;
+}
+void HostMacroProperty_MetaData::upload() {
+    if (has_changed) {
+        gpuErrchk(cudaMemcpy(d_base_ptr, h_base_ptr, type_size * elementCount(), cudaMemcpyHostToDevice));
+        has_changed = false;
+    }
+}
+
+float *CUDAMacroEnvironment::FieldProp::cells() const {
+    return d_header ? reinterpret_cast<float*>(static_cast<char*>(d_header) + DeviceEnvironmentField::HEADER_SIZE) : nullptr;
+}
+
+CUDAMacroEnvironment::CUDAMacroEnvironment(const EnvironmentDescription &description, const CUDASimulation &cudaSimulation)
+    : instance_id(cudaSimulation.getInstanceID())
+    , initialised(false) {
+    for (const auto &p : description.getMacroPropertiesMap()) {
+        properties.emplace(p.first, MacroEnvProp(p.second.type, p.second.type_size, p.second.elements));
+    }
+    for (const auto &t : description.getTablesMap()) {
+        tables.emplace(t.first, TableProp(t.second.type_size, t.second.file_path));
+    }
+    for (const auto &f : description.getFieldsMap()) {
+        fields.emplace(f.first, FieldProp(f.second.getStencil(), f.second.sub_steps, f.second.initial_value));
+    }
+}
+
+unsigned int CUDAMacroEnvironment::toHash(const std::string &name) const {
+    return detail::curve::Curve::variableRuntimeHash(CURVE_NAMESPACE_STRING) + instance_id + detail::curve::Curve::variableRuntimeHash(name.c_str());
+}
+
+void CUDAMacroEnvironment::init() {
+    if (initialised)
+        return;
+    assert(detail::curve::Curve::variableRuntimeHash(CURVE_NAMESPACE_STRING) == DeviceEnvironment::MACRO_NAMESPACE_HASH());  // Host and Device namespace const's do not match
+    detail::curve::Curve &curve = detail::curve::Curve::getInstance();
+    for (auto &p : properties) {
+        const size_t buffer_size = p.second.type_size * p.second.elementCount();
+        gpuErrchk(cudaMalloc(&p.second.d_ptr, buffer_size));
+        gpuErrchk(cudaMemset(p.second.d_ptr, 0, buffer_size));
+        const detail::curve::Curve::VariableHash cvh = toHash(p.first);
+        const auto CURVE_RESULT = curve.registerVariableByHash(cvh, p.second.d_ptr, p.second.type_size, static_cast<unsigned int>(p.second.elementCount()));
+        if (CURVE_RESULT == detail::curve::Curve::UNKNOWN_VARIABLE) {
+            THROW exception::CurveException("curveRegisterVariableByHash() returned UNKNOWN_CURVE_VARIABLE, "
+                "in CUDAMacroEnvironment::init().");
+        }
+#ifdef _DEBUG
+        if (CURVE_RESULT != static_cast<int>(cvh%detail::curve::Curve::MAX_VARIABLES)) {
+            fprintf(stderr, "Curve Warning: Environment Macro Property '%s' has a collision and may work improperly.\n", p.first.c_str());
+        }
+#endif
+    }
+    detail::EnvironmentTableCache &table_cache = detail::EnvironmentTableCache::getInstance();
+    for (auto &t : tables) {
+        t.second.data = table_cache.acquire(t.second.file_path);
+        if (t.second.data->length % t.second.type_size != 0 || t.second.data->length / t.second.type_size > UINT_MAX) {
+            const size_t file_length = t.second.data->length;
+            t.second.data.reset();
+            THROW exception::InvalidInputFile("Environment table '%s' file '%s' length (%llu bytes) is not a multiple of its type size (%llu bytes), or exceeds UINT_MAX elements, "
+                "in CUDAMacroEnvironment::init().",
+                t.first.c_str(), t.second.file_path.c_str(), file_length, t.second.type_size);
+        }
+        const detail::curve::Curve::VariableHash cvh = toHash(t.first);
+        const auto CURVE_RESULT = curve.registerVariableByHash(cvh, t.second.data->d_ptr, t.second.type_size, t.second.elementCount());
+        if (CURVE_RESULT == detail::curve::Curve::UNKNOWN_VARIABLE) {
+            THROW exception::CurveException("curveRegisterVariableByHash() returned UNKNOWN_CURVE_VARIABLE, "
+                "in CUDAMacroEnvironment::init().");
+        }
+#ifdef _DEBUG
+        if (CURVE_RESULT != static_cast<int>(cvh%detail::curve::Curve::MAX_VARIABLES)) {
+            fprintf(stderr, "Curve Warning: Environment Table '%s' has a collision and may work improperly.\n", t.first.c_str());
+        }
+#endif
+    }
+    for (auto &f : fields) {
+        const size_t buffer_size = f.second.cellCount() * sizeof(float);
+        gpuErrchk(cudaMalloc(&f.second.d_header, DeviceEnvironmentField::HEADER_SIZE + buffer_size));
+        gpuErrchk(cudaMalloc(&f.second.d_back, buffer_size));
+        const unsigned int header[DeviceEnvironmentField::HEADER_SIZE / sizeof(unsigned int)] = { f.second.stencil.dimensions[0], f.second.stencil.dimensions[1], f.second.stencil.dimensions[2], 0 };
+        gpuErrchk(cudaMemcpy(f.second.d_header, header, sizeof(header), cudaMemcpyHostToDevice));
+        const std::vector<float> initial(f.second.cellCount(), f.second.initial_value);
+        gpuErrchk(cudaMemcpy(f.second.cells(), initial.data(), buffer_size, cudaMemcpyHostToDevice));
+        const detail::curve::Curve::VariableHash cvh = toHash(f.first);
+        const auto CURVE_RESULT = curve.registerVariableByHash(cvh, f.second.d_header, sizeof(float), f.second.cellCount());
+        if (CURVE_RESULT == detail::curve::Curve::UNKNOWN_VARIABLE) {
+            THROW exception::CurveException("curveRegisterVariableByHash() returned UNKNOWN_CURVE_VARIABLE, "
+                "in CUDAMacroEnvironment::init().");
+        }
+#ifdef _DEBUG
+        if (CURVE_RESULT != static_cast<int>(cvh%detail::curve::Curve::MAX_VARIABLES)) {
+            fprintf(stderr, "Curve Warning: Environment Field '%s' has a collision and may work improperly.\n", f.first.c_str());
+        }
+#endif
+    }
+    initialised = true;
+}
+
+void CUDAMacroEnvironment::free(detail::curve::Curve &curve) {
+    if (!initialised)
+        return;
+    for (auto &p : properties) {
+        curve.unregisterVariableByHash(toHash(p.first));
+        gpuErrchk(cudaFree(p.second.d_ptr));
+        p.second.d_ptr = nullptr;
+        p.second.host_cache.reset();
+    }
+    for (auto &t : tables) {
+        if (t.second.data) {
+            curve.unregisterVariableByHash(toHash(t.first));
+            t.second.data.reset();
+        }
+    }
+    for (auto &f : fields) {
+        curve.unregisterVariableByHash(toHash(f.first));
+        gpuErrchk(cudaFree(f.second.d_header));
+        gpuErrchk(cudaFree(f.second.d_back));
+        f.second.d_header = nullptr;
+        f.second.d_back = nullptr;
+    }
+    initialised = false;
+}
+
+void CUDAMacroEnvironment::reset() {
+    for (auto &p : properties) {
+        if (p.second.d_ptr) {
+            const size_t buffer_size = p.second.type_size * p.second.elementCount();
+            gpuErrchk(cudaMemset(p.second.d_ptr, 0, buffer_size));
+            if (auto cache = p.second.host_cache.lock()) {
+                memset(cache->h_base_ptr, 0, buffer_size);
+                cache->has_changed = false;
+            }
+        }
+    }
+    for (auto &f : fields) {
+        if (f.second.d_header) {
+            const std::vector<float> initial(f.second.cellCount(), f.second.initial_value);
+            gpuErrchk(cudaMemcpy(f.second.cells(), initial.data(), f.second.cellCount() * sizeof(float), cudaMemcpyHostToDevice));
+        }
+    }
+}
+
+void CUDAMacroEnvironment::stepFields(cudaStream_t stream) {
+    bool launched = false;
+    for (auto &f : fields) {
+        if (!f.second.d_header || !f.second.stencil.isActive())
+            continue;
+        NVTX_RANGE("CUDAMacroEnvironment::stepFields()");
+        // Sub-steps alternate between the two buffers, each reads every neighbour before any cell is overwritten
+        float *front = f.second.cells();
+        float *back = f.second.d_back;
+        for (unsigned int s = 0; s < f.second.sub_steps; ++s) {
+            util::detail::fieldStencilDevice(f.second.stencil, front, back, stream);
+            std::swap(front, back);
+        }
+        if (front != f.second.cells()) {
+            // An odd number of sub-steps leaves the result in the scratch buffer
+            gpuErrchk(cudaMemcpyAsync(f.second.cells(), front, f.second.cellCount() * sizeof(float), cudaMemcpyDeviceToDevice, stream));
+        }
+        launched = true;
+    }
+    if (launched) {
+        gpuErrchk(cudaStreamSynchronize(stream));
+    }
+}
+
+void CUDAMacroEnvironment::mapRTCVariables(detail::curve::CurveRTCHost &curve_header) const {
+    for (const auto &p : properties) {
+        curve_header.registerEnvMacroProperty(p.first.c_str(), p.second.d_ptr, p.second.type.name(), p.second.type_size, p.second.elements);
+    }
+    for (const auto &t : tables) {
+        curve_header.registerEnvTable(t.first.c_str(), t.second.data ? t.second.data->d_ptr : nullptr, t.second.type_size, t.second.elementCount());
+    }
+    for (const auto &f : fields) {
+        curve_header.registerEnvField(f.first.c_str(), f.second.d_header);
+    }
+}
+
+const CUDAMacroEnvironment::MacroEnvProp &CUDAMacroEnvironment::getPropertyInfo(const std::string &name) const {
+    const auto it = properties.find(name);
+    if (it == properties.end()) {
+        THROW exception::InvalidEnvProperty("Environment macro property with name '%s' does not exist, "
+            "in CUDAMacroEnvironment::getPropertyInfo().",
+            name.c_str());
+    }
+    return it->second;
+}
+
+void CUDAMacroEnvironment::getPropertyData(const std::string &name, void *dst) const {
+    const MacroEnvProp &prop = getPropertyInfo(name);
+    const size_t buffer_size = prop.type_size * prop.elementCount();
+    if (auto cache = prop.host_cache.lock()) {
+        // The host copy may contain changes which have not been uploaded
+        memcpy(dst, cache->h_base_ptr, buffer_size);
+    } else if (prop.d_ptr) {
+        gpuErrchk(cudaMemcpy(dst, prop.d_ptr, buffer_size, cudaMemcpyDeviceToHost));
+    } else {
+        // Macro properties are zero initialised
+        memset(dst, 0, buffer_size);
+    }
+}
+
+void CUDAMacroEnvironment::setPropertyData(const std::string &name, const void *src) {
+    const MacroEnvProp &prop = getPropertyInfo(name);
+    if (!prop.d_ptr) {
+        THROW exception::InvalidOperation("Environment macro property '%s' has not been allocated, "
+            "in CUDAMacroEnvironment::setPropertyData().",
+            name.c_str());
+    }
+    const size_t buffer_size = prop.type_size * prop.elementCount();
+    gpuErrchk(cudaMemcpy(prop.d_ptr, src, buffer_size, cudaMemcpyHostToDevice));
+    if (auto cache = prop.host_cache.lock()) {
+        // Keep live host handles consistent
+        memcpy(cache->h_base_ptr, src, buffer_size);
+        cache->has_changed = false;
+    }
+}
+
+const CUDAMacroEnvironment::FieldProp &CUDAMacroEnvironment::getFieldInfo(const std::string &name) const {
+    const auto it = fields.find(name);
+    if (it == fields.end()) {
+        THROW exception::InvalidEnvProperty("Environment field with name '%s' does not exist, "
+            "in CUDAMacroEnvironment::getFieldInfo().",
+            name.c_str());
+    }
+    return it->second;
+}
+
+void CUDAMacroEnvironment::getFieldData(const std::string &name, float *dst) const {
+    const FieldProp &field = getFieldInfo(name);
+    if (field.d_header) {
+        gpuErrchk(cudaMemcpy(dst, field.cells(), field.cellCount() * sizeof(float), cudaMemcpyDeviceToHost));
+    } else {
+        std::fill(dst, dst + field.cellCount(), field.initial_value);
+    }
+}
+
+void CUDAMacroEnvironment::setFieldData(const std::string &name, const float *src) {
+    const FieldProp &field = getFieldInfo(name);
+    if (!field.d_header) {
+        THROW exception::InvalidOperation("Environment field '%s' has not been allocated, "
+            "in CUDAMacroEnvironment::setFieldData().",
+            name.c_str());
+    }
+    gpuErrchk(cudaMemcpy(field.cells(), src, field.cellCount() * sizeof(float), cudaMemcpyHostToDevice));
+}
+
+}  // namespace flamegpu
@@ -1,8 +1,13 @@
 #include <cuda_runtime.h>
 #include <device_launch_parameters.h>
 
+#include <algorithm>
+#include <set>
+#include <string>
+
 #include "flamegpu/gpu/CUDAMessage.h"
 #include "flamegpu/gpu/CUDAAgent.h"
+#include "flamegpu/gpu/CUDASimulation.h"
 #include "flamegpu/gpu/CUDAMessageList.h"
 #include "flamegpu/gpu/detail/CUDAErrorChecking.cuh"
 #include "flamegpu/gpu/CUDAScatter.cuh"
@@ -11,6 +16,9 @@
 #include "flamegpu/model/AgentFunctionDescription.h"
 #include "flamegpu/runtime/detail/curve/curve.cuh"
 #include "flamegpu/model/AgentDescription.h"
+#include "flamegpu/model/AgentData.h"
+#include "flamegpu/model/AgentFunctionData.cuh"
+#include "flamegpu/model/LayerData.h"
 #include "flamegpu/runtime/messaging.h"
 
 #ifdef _MSC_VER
@@ -27,12 +35,20 @@ namespace flamegpu {
 CUDAMessage::CUDAMessage(const MessageBruteForce::Data& description, const CUDASimulation& cudaSimulation)
     : message_description(description)
     , message_count(0)
+    , indexed_message_count(0)
     , max_list_size(0)
+    , peak_message_count(0)
+    , allocations(0)
     , truncate_messagelist_flag(true)
     , pbm_construction_required(false)
+    , agent_view_copied(false)
     , specialisation_handler(description.getSpecialisationHander(*this))
     , cudaSimulation(cudaSimulation) {
     // resize(0); // Think this call is redundant
+    if (isAgentView()) {
+        validateAgentView();
+    }
+    initReadVariables();
 }
 
 CUDAMessage::~CUDAMessage(void) {
@@ -47,18 +63,18 @@ const MessageBruteForce::Data& CUDAMessage::getMessageDescription() const {
 void CUDAMessage::resize(unsigned int newSize, CUDAScatter &scatter, const unsigned int &streamId) {
     // Only grow currently
     if (newSize > max_list_size) {
-        max_list_size = std::max<unsigned int>(max_list_size, 2u);
+        // The capacity hint is only a lower bound, beyond it the list grows geometrically
+        max_list_size = std::max({ max_list_size, message_description.capacity_hint, 2u });
         while (max_list_size < newSize) {
             max_list_size = static_cast<unsigned int>(max_list_size * 1.5);
         }
-        // This drops old message data
-        message_list = std::unique_ptr<CUDAMessageList>(new CUDAMessageList(*this, scatter, streamId));
+        // The new list copies the existing messages from the old list, before it is released
+        // Messages which are about to be truncated are not retained
+        // Buffers are not zeroed, message types which expose unwritten messages (e.g. arrays) zero their own buffers
+        const unsigned int retain_count = message_list && !truncate_messagelist_flag ? message_count : 0;
+        message_list = std::unique_ptr<CUDAMessageList>(new CUDAMessageList(*this, scatter, streamId, retain_count));
+        ++allocations;
         scatter.Scan().resize(max_list_size, CUDAScanCompaction::MESSAGE_OUTPUT, streamId);
-
-// #ifdef _DEBUG
-        /**set the message list to zero*/
-        zeroAllMessageData();
-// #endif
     }
 }
 
@@ -74,6 +90,108 @@ void CUDAMessage::setMessageCount(const unsigned int &_message_count) {
         THROW exception::OutOfBoundsException("message count exceeds allocated message list size (%u > %u) in CUDAMessage::setMessageCount().", _message_count, max_list_size);
     }
     message_count = _message_count;
+    indexed_message_count = std::min(indexed_message_count, message_count);
+    peak_message_count = std::max(peak_message_count, message_count);
+}
+CUDAMessage::MemoryStats CUDAMessage::getMemoryStats() const {
+    MemoryStats rtn = { max_list_size, peak_message_count, allocations, 0 };
+    if (message_list) {
+        // The read list holds every variable, the write list only holds read variables, as the remainder share the read list's buffer
+        for (const auto &v : message_description.variables) {
+            rtn.allocated_bytes += v.second.type_size * v.second.elements * max_list_size;
+        }
+        for (const auto &v : read_variables) {
+            rtn.allocated_bytes += v.second.type_size * v.second.elements * max_list_size;
+        }
+    }
+    return rtn;
+}
+void CUDAMessage::validateAgentView() const {
+    const ModelData &model = cudaSimulation.getModelDescription();
+    const auto agent = model.agents.find(message_description.view_agent);
+    if (agent == model.agents.end() || agent->second->states.find(message_description.view_state) == agent->second->states.end()) {
+        THROW exception::InvalidMessage("Message '%s' is a view over agent '%s' state '%s', which does not exist in model '%s', "
+            "in CUDAMessage::validateAgentView().",
+            message_description.name.c_str(), message_description.view_agent.c_str(), message_description.view_state.c_str(), model.name.c_str());
+    }
+    // Each message variable is read directly from the agent variable of the same name
+    for (const auto &mmp : message_description.variables) {
+        const auto av = agent->second->variables.find(mmp.first);
+        if (av == agent->second->variables.end() || av->second.type != mmp.second.type || av->second.elements != mmp.second.elements) {
+            THROW exception::InvalidMessage("Message '%s' is a view over agent '%s', which does not have a variable '%s' of matching type and length, "
+                "in CUDAMessage::validateAgentView().",
+                message_description.name.c_str(), message_description.view_agent.c_str(), mmp.first.c_str());
+        }
+    }
+    // The message list has no storage to output to
+    for (const auto &a : model.agents) {
+        for (const auto &f : a.second->functions) {
+            const auto om = f.second->message_output.lock();
+            if (om && om->name == message_description.name) {
+                THROW exception::InvalidMessage("Message '%s' is a view over agent '%s', so it cannot be output by agent function '%s', "
+                    "in CUDAMessage::validateAgentView().",
+                    message_description.name.c_str(), message_description.view_agent.c_str(), f.first.c_str());
+            }
+        }
+    }
+}
+void CUDAMessage::initReadVariables() {
+    const ModelData &model = cudaSimulation.getModelDescription();
+    std::set<std::string> read_names = message_description.index_variables;
+    bool read_all = false;
+    for (const auto &a : model.agents) {
+        for (const auto &f : a.second->functions) {
+            const auto im = f.second->message_input.lock();
+            if (!im || im->name != message_description.name)
+                continue;
+            if (f.second->message_input_variables_declared) {
+                read_names.insert(f.second->message_input_variables.begin(), f.second->message_input_variables.end());
+            } else {
+                // Neither C++ nor RTC device code can be inspected reliably (names may be built by macros, or passed through helpers)
+                read_all = true;
+            }
+        }
+    }
+    read_variables.clear();
+    for (const auto &mmp : message_description.variables) {
+        if (read_all || read_names.find(mmp.first) != read_names.end())
+            read_variables.insert(mmp);
+    }
+}
+bool CUDAMessage::isAgentViewWritten(const LayerData &layer) const {
+    // Device code can't be inspected, so any function executing over the viewed state is assumed to write the viewed variables
+    for (const auto &f : layer.agent_functions) {
+        const auto a = f->parent.lock();
+        if (a && a->name == message_description.view_agent && f->initial_state == message_description.view_state)
+            return true;
+    }
+    return false;
+}
+void CUDAMessage::refreshAgentView(const LayerData &layer, CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream) {
+    CUDAAgent &cuda_agent = cudaSimulation.getCUDAAgent(message_description.view_agent);
+    // Agents disabled by an agent function condition are still messages
+    message_count = cuda_agent.getStateSizeWithDisabled(message_description.view_state);
+    // Index storage is sized according to the maximum list size
+    if (message_count > max_list_size) {
+        max_list_size = message_count;
+        // Any existing copy is too small, it will be reallocated if required
+        message_list.reset();
+    }
+    peak_message_count = std::max(peak_message_count, message_count);
+    pbm_construction_required = true;
+    // Functions within the layer execute concurrently, so the viewed variables must not change whilst being read
+    agent_view_copied = isAgentViewWritten(layer);
+    if (agent_view_copied) {
+        if (!message_list) {
+            message_list = std::unique_ptr<CUDAMessageList>(new CUDAMessageList(*this, scatter, streamId, 0));
+            ++allocations;
+        }
+        for (const auto &mmp : message_description.variables) {
+            gpuErrchk(cudaMemcpyAsync(message_list->getReadMessageListVariablePointer(mmp.first),
+                cuda_agent.getStateVariableReadPtr(message_description.view_state, mmp.first),
+                mmp.second.type_size * mmp.second.elements * message_count, cudaMemcpyDeviceToDevice, stream));
+        }
+    }
 }
 void CUDAMessage::init(CUDAScatter &scatter, const unsigned int &streamId) {
     specialisation_handler->init(scatter, streamId);
@@ -86,8 +204,8 @@ void CUDAMessage::zeroAllMessageData() {
 }
 
 void CUDAMessage::mapReadRuntimeVariables(const AgentFunctionData& func, const CUDAAgent& cuda_agent, const unsigned int &instance_id) const {
-    // check that the message list has been allocated
-    if (!message_list) {
+    // check that the message list has been allocated, agent views read the agent's buffers instead
+    if (!message_list && !isAgentView()) {
         if (getMessageCount() == 0) {
             return;  // Message list is empty, this should be safe
         }
@@ -103,9 +221,12 @@ void CUDAMessage::mapReadRuntimeVariables(const AgentFunctionData& func, const C
     const detail::curve::Curve::VariableHash func_hash = detail::curve::Curve::getInstance().variableRuntimeHash(func.name.c_str());
     auto &curve = detail::curve::Curve::getInstance();
     // loop through the message variables to map each variable name using cuRVE
-    for (const auto &mmp : message_description.variables) {
+    // RTC functions have a cache entry for every message variable, whereas cuRVE only maps those which are read
+    for (const auto &mmp : func.func ? read_variables : message_description.variables) {
         // get a device pointer for the message variable name
-        void* d_ptr = message_list->getReadMessageListVariablePointer(mmp.first);
+        void* d_ptr = isAgentView() && !agent_view_copied
+            ? cudaSimulation.getCUDAAgent(message_description.view_agent).getStateVariableReadPtr(message_description.view_state, mmp.first)
+            : message_list->getReadMessageListVariablePointer(mmp.first);
 
         // map using curve
         detail::curve::Curve::VariableHash var_hash = detail::curve::Curve::getInstance().variableRuntimeHash(mmp.first.c_str());
@@ -134,6 +255,9 @@ void CUDAMessage::mapReadRuntimeVariables(const AgentFunctionData& func, const C
 }
 
 void *CUDAMessage::getReadPtr(const std::string &var_name) {
+    if (isAgentView() && !agent_view_copied) {
+        return cudaSimulation.getCUDAAgent(message_description.view_agent).getStateVariableReadPtr(message_description.view_state, var_name);
+    }
     if (!message_list) {
         THROW exception::InvalidMessageData("MessageList '%s' is not yet allocated, in CUDAMessage::swap()\n", message_description.name.c_str());
     }
@@ -203,7 +327,7 @@ void CUDAMessage::unmapRuntimeVariables(const AgentFunctionData& func, const uns
     const detail::curve::Curve::VariableHash func_hash = detail::curve::Curve::getInstance().variableRuntimeHash(func.name.c_str());
     auto &curve = detail::curve::Curve::getInstance();
     // loop through the message variables to map each variable name using cuRVE
-    for (const auto &mmp : message_description.variables) {
+    for (const auto &mmp : read_variables) {
         // unmap using curve
         detail::curve::Curve::VariableHash var_hash = detail::curve::Curve::variableRuntimeHash(mmp.first.c_str());
         curve.unregisterVariableByHash(var_hash + agent_hash + func_hash + message_hash + instance_id);
@@ -213,7 +337,7 @@ void CUDAMessage::swap(bool isOptional, const unsigned int &newMessageCount, CUD
     if (!message_list) {
         THROW exception::InvalidMessageData("MessageList '%s' is not yet allocated, in CUDAMessage::swap()\n", message_description.name.c_str());
     }
-    if (isOptional && message_description.optional_outputs > 0) {
+    if (isOptional) {
         CUDAScanCompactionConfig &scanCfg = scatter.Scan().Config(CUDAScanCompaction::Type::MESSAGE_OUTPUT, streamId);
         if (newMessageCount > scanCfg.cub_temp_size_max_list_size) {
             if (scanCfg.hd_cub_temp) {
@@ -238,10 +362,13 @@ void CUDAMessage::swap(bool isOptional, const unsigned int &newMessageCount, CUD
             newMessageCount + 1));
         // Scatter
         // Update count
+        if (this->truncate_messagelist_flag)
+            indexed_message_count = 0;
         message_count = message_list->scatter(newMessageCount, scatter, streamId, !this->truncate_messagelist_flag);
     } else {
         if (this->truncate_messagelist_flag) {
             message_count = newMessageCount;
+            indexed_message_count = 0;
             message_list->swap();
         } else {
             assert(message_count + newMessageCount <= max_list_size);
@@ -249,6 +376,7 @@ void CUDAMessage::swap(bool isOptional, const unsigned int &newMessageCount, CUD
             message_count = message_list->scatterAll(newMessageCount, scatter, streamId);
         }
     }
+    peak_message_count = std::max(peak_message_count, message_count);
 }
 void CUDAMessage::swap() {
     if (!message_list) {
@@ -261,6 +389,7 @@ void CUDAMessage::buildIndex(CUDAScatter &scatter, const unsigned int &streamId,
     // Build the index if required.
     if (pbm_construction_required) {
         specialisation_handler->buildIndex(scatter, streamId, stream);
+        indexed_message_count = message_count;
         pbm_construction_required = false;
     }
 }
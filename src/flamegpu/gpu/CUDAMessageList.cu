@@ -14,22 +14,16 @@ namespace flamegpu {
 * CUDAMessageList class
 * @brief populates CUDA message map
 */
-CUDAMessageList::CUDAMessageList(CUDAMessage& cuda_message, CUDAScatter &scatter, const unsigned int &streamId)
+CUDAMessageList::CUDAMessageList(CUDAMessage& cuda_message, CUDAScatter &scatter, const unsigned int &streamId, const unsigned int &retain_count)
     : message(cuda_message) {
     // allocate message lists
-    allocateDeviceMessageList(d_list);
-    allocateDeviceMessageList(d_swap_list);
-    if (message.getMessageCount() != 0) {
-        {
-            auto &a = cuda_message.getReadList();
-            auto &_a = d_list;
-            scatter.scatterAll(streamId, 0, message.getMessageDescription().variables, a, _a, message.getMessageCount(), 0);
-        }
-        {  // Is copying writelist redundant?
-            auto &a = cuda_message.getWriteList();
-            auto &_a = d_swap_list;
-            scatter.scatterAll(streamId, 0, message.getMessageDescription().variables, a, _a, message.getMessageCount(), 0);
-        }
+    allocateDeviceMessageList(d_list, nullptr);
+    allocateDeviceMessageList(d_swap_list, &d_list);
+    if (retain_count != 0) {
+        // Only the read list holds messages between functions, the write list is always overwritten before it is read
+        auto &a = cuda_message.getReadList();
+        auto &_a = d_list;
+        scatter.scatterAll(streamId, 0, message.getReadVariables(), a, _a, retain_count, 0);
     }
 }
 
@@ -43,19 +37,26 @@ CUDAMessageList::~CUDAMessageList() {
 
 void CUDAMessageList::cleanupAllocatedData() {
     // clean up
-    releaseDeviceMessageList(d_list);
-    releaseDeviceMessageList(d_swap_list);
+    releaseDeviceMessageList(d_list, false);
+    releaseDeviceMessageList(d_swap_list, true);
 }
 
-void CUDAMessageList::allocateDeviceMessageList(CUDAMessageMap &memory_map) {
+void CUDAMessageList::allocateDeviceMessageList(CUDAMessageMap &memory_map, const CUDAMessageMap *shared_map) {
     // we use the  messages memory map to iterate the  message variables and do allocation within our GPU hash map
     const auto &mem = message.getMessageDescription().variables;
+    const auto &read_vars = message.getReadVariables();
 
     // for each variable allocate a device array and add to map
     for (const auto &mm : mem) {
         // get the variable name
         std::string var_name = mm.first;
 
+        // variables which are never read are never reordered, so they can be written in place
+        if (shared_map && read_vars.find(var_name) == read_vars.end()) {
+            memory_map.insert(CUDAMessageMap::value_type(var_name, shared_map->at(var_name)));
+            continue;
+        }
+
         // get the variable size from  message description
         size_t var_size = mm.second.type_size * mm.second.elements;
 
@@ -75,9 +76,13 @@ void CUDAMessageList::allocateDeviceMessageList(CUDAMessageMap &memory_map) {
     }
 }
 
-void CUDAMessageList::releaseDeviceMessageList(CUDAMessageMap& memory_map) {
+void CUDAMessageList::releaseDeviceMessageList(CUDAMessageMap& memory_map, const bool &shared) {
+    const auto &read_vars = message.getReadVariables();
     // for each device pointer in the cuda memory map we need to free these
     for (const CUDAMessageMapPair& mm : memory_map) {
+        // shared buffers are freed with the other list
+        if (shared && read_vars.find(mm.first) == read_vars.end())
+            continue;
         // free the memory on the device
         gpuErrchk(cudaFree(mm.second));
     }
@@ -132,7 +137,7 @@ unsigned int CUDAMessageList::scatter(const unsigned int &newCount, CUDAScatter
         return oldCount + scatter.scatter(streamId,
             0,
             CUDAScatter::Type::MESSAGE_OUTPUT,
-            message.getMessageDescription().variables,
+            message.getReadVariables(),
             d_swap_list, d_list,
             newCount,
             oldCount);
@@ -140,7 +145,7 @@ unsigned int CUDAMessageList::scatter(const unsigned int &newCount, CUDAScatter
         return scatter.scatter(streamId,
             0,
             CUDAScatter::Type::MESSAGE_OUTPUT,
-            message.getMessageDescription().variables,
+            message.getReadVariables(),
             d_swap_list, d_list,
             newCount,
             0);
@@ -150,7 +155,7 @@ unsigned int CUDAMessageList::scatterAll(const unsigned int &newCount, CUDAScatt
     unsigned int oldCount = message.getMessageCount();
     return oldCount + scatter.scatterAll(streamId,
         0,
-        message.getMessageDescription().variables,
+        message.getReadVariables(),
         d_swap_list, d_list,
         newCount,
         oldCount);
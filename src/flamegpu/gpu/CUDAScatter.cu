@@ -3,6 +3,7 @@
 #include <cuda_runtime.h>
 #include <vector>
 #include <cassert>
+#include <cstdint>
 
 #include "flamegpu/gpu/detail/CUDAErrorChecking.cuh"
 #include "flamegpu/gpu/CUDAFatAgentStateList.h"
@@ -22,7 +23,9 @@ namespace flamegpu {
 
 CUDAScatter::StreamData::StreamData()
     : d_data(nullptr)
-    , data_len(0) {
+    , data_len(0)
+    , d_sort_storage(nullptr)
+    , sort_storage_bytes(0) {
 }
 CUDAScatter::StreamData::~StreamData() {
     /* @note - Do not clear cuda memory in the destructor of singletons.
@@ -35,10 +38,17 @@ CUDAScatter::StreamData::~StreamData() {
     }
     d_data = nullptr;
     data_len = 0;
+    if (d_sort_storage) {
+        gpuErrchk(cudaFree(d_sort_storage));
+    }
+    d_sort_storage = nullptr;
+    sort_storage_bytes = 0;
 }
 void CUDAScatter::StreamData::purge() {
     d_data = nullptr;
     data_len = 0;
+    d_sort_storage = nullptr;
+    sort_storage_bytes = 0;
 }
 void CUDAScatter::StreamData::resize(const unsigned int &newLen) {
     if (newLen > data_len) {
@@ -49,6 +59,15 @@ void CUDAScatter::StreamData::resize(const unsigned int &newLen) {
         data_len = newLen;
     }
 }
+void CUDAScatter::StreamData::resizeSortStorage(const size_t &newBytes) {
+    if (newBytes > sort_storage_bytes) {
+        if (d_sort_storage) {
+            gpuErrchk(cudaFree(d_sort_storage));
+        }
+        gpuErrchk(cudaMalloc(&d_sort_storage, newBytes));
+        sort_storage_bytes = newBytes;
+    }
+}
 
 void CUDAScatter::purge() {
     for (auto &s : streamResources) {
@@ -314,6 +333,310 @@ void CUDAScatter::pbm_reorder(
     gpuErrchk(cudaStreamSynchronize(stream));  // @todo - async + sync variants.
 }
 
+__global__ void pbm_permutation_generic(
+    const unsigned int threadCount,
+    const unsigned int * __restrict__ bin_index,
+    const unsigned int * __restrict__ bin_sub_index,
+    const unsigned int * __restrict__ pbm,
+    unsigned int *permutation) {
+    // global thread index
+    int index = (blockIdx.x*blockDim.x) + threadIdx.x;
+
+    if (index >= threadCount) return;
+
+    const unsigned int sorted_index = pbm[bin_index[index]] + bin_sub_index[index];
+    permutation[sorted_index] = index;
+}
+
+void CUDAScatter::pbm_permutation(
+    const cudaStream_t &stream,
+    const unsigned int &itemCount,
+    const unsigned int *d_bin_index,
+    const unsigned int *d_bin_sub_index,
+    const unsigned int *d_pbm,
+    unsigned int *d_permutation) {
+    // If itemCount is 0, then there is no work to be done.
+    if (itemCount == 0) {
+        return;
+    }
+
+    int blockSize = 0;  // The launch configurator returned block size
+    int minGridSize = 0;  // The minimum grid size needed to achieve the // maximum occupancy for a full device // launch
+    int gridSize = 0;  // The actual grid size needed, based on input size
+
+    gpuErrchk(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, pbm_permutation_generic, 0, itemCount));
+    gridSize = (itemCount + blockSize - 1) / blockSize;
+    pbm_permutation_generic <<<gridSize, blockSize, 0, stream>>> (
+            itemCount,
+            d_bin_index,
+            d_bin_sub_index,
+            d_pbm,
+            d_permutation);
+    gpuErrchkLaunch();
+    gpuErrchk(cudaStreamSynchronize(stream));  // @todo - async + sync variants.
+}
+
+__global__ void pbm_sequence(
+    const unsigned int threadCount,
+    unsigned int *out) {
+    // global thread index
+    int index = (blockIdx.x*blockDim.x) + threadIdx.x;
+
+    if (index >= threadCount) return;
+
+    out[index] = index;
+}
+__global__ void pbm_from_sorted(
+    const unsigned int itemCount,
+    const unsigned int binCount,
+    const unsigned int * __restrict__ sorted_bin_index,
+    unsigned int *pbm) {
+    // global thread index, one thread per boundary between sorted items (inclusive of both ends)
+    unsigned int index = (blockIdx.x*blockDim.x) + threadIdx.x;
+
+    if (index > itemCount) return;
+
+    // Each bin from the bin after the previous item, to this item's bin, begins at this item
+    const unsigned int first_bin = index == 0 ? 0 : sorted_bin_index[index - 1] + 1;
+    const unsigned int last_bin = index == itemCount ? binCount : sorted_bin_index[index];
+    for (unsigned int bin = first_bin; bin <= last_bin; ++bin) {
+        pbm[bin] = index;
+    }
+}
+__global__ void pbm_sub_index_from_sorted(
+    const unsigned int itemCount,
+    const unsigned int * __restrict__ sorted_bin_index,
+    const unsigned int * __restrict__ sorted_index,
+    const unsigned int * __restrict__ pbm,
+    unsigned int *bin_sub_index) {
+    // global thread index
+    unsigned int index = (blockIdx.x*blockDim.x) + threadIdx.x;
+
+    if (index >= itemCount) return;
+
+    // The item's position within it's bin, is it's distance from the start of the bin
+    bin_sub_index[sorted_index[index]] = index - pbm[sorted_bin_index[index]];
+}
+
+void CUDAScatter::pbm_stable_sort(
+    const unsigned int &streamResourceId,
+    const cudaStream_t &stream,
+    const unsigned int &itemCount,
+    const unsigned int &binCount,
+    const unsigned int *d_bin_index,
+    unsigned int *d_bin_sub_index,
+    unsigned int *d_pbm) {
+    // If itemCount is 0, then every bin is empty
+    if (itemCount == 0) {
+        gpuErrchk(cudaMemsetAsync(d_pbm, 0x00000000, (binCount + 1) * sizeof(unsigned int), stream));
+        return;
+    }
+    // Only sort the bits which may be set in a bin index
+    int end_bit = 1;
+    while (end_bit < 32 && (1ull << end_bit) < binCount) {
+        ++end_bit;
+    }
+    // Storage is partitioned into sorted bin indices, input and output item indices, followed by cub temp storage
+    const size_t array_bytes = ((itemCount * sizeof(unsigned int) + 255) / 256) * 256;
+    size_t cub_temp_bytes = 0;
+    gpuErrchk(cub::DeviceRadixSort::SortPairs(nullptr, cub_temp_bytes,
+        d_bin_index, static_cast<unsigned int*>(nullptr), static_cast<unsigned int*>(nullptr), static_cast<unsigned int*>(nullptr),
+        itemCount, 0, end_bit, stream));
+    StreamData &sr = streamResources[streamResourceId];
+    sr.resizeSortStorage(3 * array_bytes + cub_temp_bytes);
+    char *storage = static_cast<char*>(sr.d_sort_storage);
+    unsigned int *d_sorted_bin_index = reinterpret_cast<unsigned int*>(storage);
+    unsigned int *d_index = reinterpret_cast<unsigned int*>(storage + array_bytes);
+    unsigned int *d_sorted_index = reinterpret_cast<unsigned int*>(storage + 2 * array_bytes);
+    void *d_cub_temp = storage + 3 * array_bytes;
+
+    int blockSize = 0;  // The launch configurator returned block size
+    int minGridSize = 0;  // The minimum grid size needed to achieve the // maximum occupancy for a full device // launch
+    int gridSize = 0;  // The actual grid size needed, based on input size
+    gpuErrchk(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, pbm_sequence, 0, itemCount));
+    gridSize = (itemCount + blockSize - 1) / blockSize;
+    pbm_sequence <<<gridSize, blockSize, 0, stream>>> (itemCount, d_index);
+    gpuErrchkLaunch();
+    // LSD radix sort is stable, so items with the same bin retain their original order
+    gpuErrchk(cub::DeviceRadixSort::SortPairs(d_cub_temp, cub_temp_bytes,
+        d_bin_index, d_sorted_bin_index, d_index, d_sorted_index,
+        itemCount, 0, end_bit, stream));
+    gpuErrchk(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, pbm_from_sorted, 0, itemCount + 1));
+    gridSize = (itemCount + 1 + blockSize - 1) / blockSize;
+    pbm_from_sorted <<<gridSize, blockSize, 0, stream>>> (itemCount, binCount, d_sorted_bin_index, d_pbm);
+    gpuErrchkLaunch();
+    gpuErrchk(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, pbm_sub_index_from_sorted, 0, itemCount));
+    gridSize = (itemCount + blockSize - 1) / blockSize;
+    pbm_sub_index_from_sorted <<<gridSize, blockSize, 0, stream>>> (itemCount, d_sorted_bin_index, d_sorted_index, d_pbm, d_bin_sub_index);
+    gpuErrchkLaunch();
+}
+
+__global__ void pbm_combine_first(
+    const unsigned int binCount,
+    const unsigned int * __restrict__ pbm,
+    const unsigned int * __restrict__ permutation,
+    const unsigned int * __restrict__ out_index,
+    CUDAScatter::ScatterData *scatter_data,
+    const unsigned int scatter_len) {
+    // global thread index, one thread per bin
+    unsigned int bin = (blockIdx.x*blockDim.x) + threadIdx.x;
+
+    if (bin >= binCount) return;
+
+    const unsigned int begin = pbm[bin];
+    if (begin == pbm[bin + 1]) {
+        // Empty bins are only output if bins map directly to output indices
+        if (!out_index) {
+            for (unsigned int i = 0; i < scatter_len; ++i) {
+                memset(scatter_data[i].out + (bin * scatter_data[i].typeLen), 0, scatter_data[i].typeLen);
+            }
+        }
+        return;
+    }
+    const unsigned int out_idx = out_index ? out_index[bin] : bin;
+    const unsigned int in_idx = permutation[begin];
+    for (unsigned int i = 0; i < scatter_len; ++i) {
+        memcpy(scatter_data[i].out + (out_idx * scatter_data[i].typeLen), scatter_data[i].in + (in_idx * scatter_data[i].typeLen), scatter_data[i].typeLen);
+    }
+}
+template <typename T>
+__global__ void pbm_combine_typed(
+    const unsigned int binCount,
+    const unsigned int * __restrict__ pbm,
+    const unsigned int * __restrict__ permutation,
+    const unsigned int * __restrict__ out_index,
+    const T * __restrict__ in,
+    T *out,
+    const unsigned int elements,
+    const MessageCombine op,
+    const unsigned int countBegin) {
+    // global thread index, one thread per bin
+    unsigned int bin = (blockIdx.x*blockDim.x) + threadIdx.x;
+
+    if (bin >= binCount) return;
+
+    const unsigned int begin = pbm[bin];
+    const unsigned int end = pbm[bin + 1];
+    if (begin == end) {
+        // Empty bins are only output if bins map directly to output indices
+        if (!out_index) {
+            for (unsigned int e = 0; e < elements; ++e) {
+                out[bin * elements + e] = 0;
+            }
+        }
+        return;
+    }
+    const unsigned int out_idx = out_index ? out_index[bin] : bin;
+    for (unsigned int e = 0; e < elements; ++e) {
+        T result = 0;
+        for (unsigned int i = begin; i < end; ++i) {
+            const unsigned int in_idx = permutation[i];
+            // Items which have not previously been combined are counted, regardless of the value output
+            const T v = op == MessageCombine::Count && in_idx >= countBegin ? static_cast<T>(1) : in[in_idx * elements + e];
+            if (i == begin) {
+                result = v;
+            } else if (op == MessageCombine::Min) {
+                result = v < result ? v : result;
+            } else if (op == MessageCombine::Max) {
+                result = v > result ? v : result;
+            } else {
+                result += v;
+            }
+        }
+        out[out_idx * elements + e] = result;
+    }
+}
+template <typename T>
+void pbm_combine_launch(
+    const cudaStream_t &stream,
+    const unsigned int &binCount,
+    const unsigned int *d_pbm,
+    const unsigned int *d_permutation,
+    const unsigned int *d_out_index,
+    const void *in,
+    void *out,
+    const unsigned int &elements,
+    const MessageCombine &op,
+    const unsigned int &countBegin) {
+    int blockSize = 0;  // The launch configurator returned block size
+    int minGridSize = 0;  // The minimum grid size needed to achieve the // maximum occupancy for a full device // launch
+    int gridSize = 0;  // The actual grid size needed, based on input size
+    gpuErrchk(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, pbm_combine_typed<T>, 0, binCount));
+    gridSize = (binCount + blockSize - 1) / blockSize;
+    pbm_combine_typed<T> <<<gridSize, blockSize, 0, stream>>> (
+        binCount,
+        d_pbm,
+        d_permutation,
+        d_out_index,
+        static_cast<const T*>(in),
+        static_cast<T*>(out),
+        elements,
+        op,
+        countBegin);
+    gpuErrchkLaunch();
+}
+
+void CUDAScatter::pbm_combine(
+    const unsigned int &streamResourceId,
+    const cudaStream_t &stream,
+    const VariableMap &vars,
+    const std::map<std::string, MessageCombine> &ops,
+    const std::map<std::string, void*> &in,
+    const std::map<std::string, void*> &out,
+    const unsigned int &binCount,
+    const unsigned int *d_pbm,
+    const unsigned int *d_permutation,
+    const unsigned int *d_out_index,
+    const unsigned int &countBegin) {
+    // If binCount is 0, then there is no work to be done.
+    if (binCount == 0) {
+        return;
+    }
+    // Variables which are not combined are copied from the first item in each bin
+    std::vector<ScatterData> sd;
+    for (const auto &v : vars) {
+        const auto op = ops.find(v.first);
+        const void *in_p = in.at(v.first);
+        void *out_p = out.at(v.first);
+        if (op == ops.end() || op->second == MessageCombine::None) {
+            sd.push_back({ v.second.type_size * v.second.elements, reinterpret_cast<char*>(const_cast<void*>(in_p)), reinterpret_cast<char*>(out_p) });
+        } else if (v.second.type == std::type_index(typeid(float))) {
+            pbm_combine_launch<float>(stream, binCount, d_pbm, d_permutation, d_out_index, in_p, out_p, v.second.elements, op->second, countBegin);
+        } else if (v.second.type == std::type_index(typeid(double))) {
+            pbm_combine_launch<double>(stream, binCount, d_pbm, d_permutation, d_out_index, in_p, out_p, v.second.elements, op->second, countBegin);
+        } else if (v.second.type == std::type_index(typeid(int32_t))) {
+            pbm_combine_launch<int32_t>(stream, binCount, d_pbm, d_permutation, d_out_index, in_p, out_p, v.second.elements, op->second, countBegin);
+        } else if (v.second.type == std::type_index(typeid(uint32_t))) {
+            pbm_combine_launch<uint32_t>(stream, binCount, d_pbm, d_permutation, d_out_index, in_p, out_p, v.second.elements, op->second, countBegin);
+        } else if (v.second.type == std::type_index(typeid(int64_t))) {
+            pbm_combine_launch<int64_t>(stream, binCount, d_pbm, d_permutation, d_out_index, in_p, out_p, v.second.elements, op->second, countBegin);
+        } else if (v.second.type == std::type_index(typeid(uint64_t))) {
+            pbm_combine_launch<uint64_t>(stream, binCount, d_pbm, d_permutation, d_out_index, in_p, out_p, v.second.elements, op->second, countBegin);
+        } else {
+            THROW exception::InvalidArgument("Variable '%s' has type '%s', which cannot be combined, in CUDAScatter::pbm_combine().",
+                v.first.c_str(), v.second.type.name());
+        }
+    }
+    if (!sd.empty()) {
+        int blockSize = 0;  // The launch configurator returned block size
+        int minGridSize = 0;  // The minimum grid size needed to achieve the // maximum occupancy for a full device // launch
+        int gridSize = 0;  // The actual grid size needed, based on input size
+        gpuErrchk(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, pbm_combine_first, 0, binCount));
+        gridSize = (binCount + blockSize - 1) / blockSize;
+        streamResources[streamResourceId].resize(static_cast<unsigned int>(sd.size()));
+        // Important that sd.size() is still used here, incase allocated len (data_len) is bigger
+        gpuErrchk(cudaMemcpyAsync(streamResources[streamResourceId].d_data, sd.data(), sizeof(ScatterData) * sd.size(), cudaMemcpyHostToDevice, stream));
+        pbm_combine_first <<<gridSize, blockSize, 0, stream>>> (
+            binCount,
+            d_pbm,
+            d_permutation,
+            d_out_index,
+            streamResources[streamResourceId].d_data, static_cast<unsigned int>(sd.size()));
+        gpuErrchkLaunch();
+    }
+    gpuErrchk(cudaStreamSynchronize(stream));  // @todo - async + sync variants.
+}
+
 /**
  * Scatter kernel for host agent creation
  * Input data is stored in AoS, and translated to SoA for device
@@ -1,6 +1,5 @@
 #include "flamegpu/gpu/CUDASimulation.h"
 
-#include <curand_kernel.h>
 
 #include <algorithm>
 #include <string>
@@ -17,6 +16,7 @@
 #include "flamegpu/util/detail/SignalHandlers.h"
 #include "flamegpu/util/detail/CUDAEventTimer.cuh"
 #include "flamegpu/runtime/detail/curve/curve_rtc.cuh"
+#include "flamegpu/runtime/utility/EnvironmentTableCache.h"
 #include "flamegpu/runtime/HostFunctionCallback.h"
 #include "flamegpu/gpu/CUDAAgent.h"
 #include "flamegpu/gpu/CUDAMessage.h"
@@ -55,6 +55,7 @@ CUDASimulation::CUDASimulation(const std::shared_ptr<const ModelData> &_model)
     , isPureRTC(detectPureRTC(model)) {
     ++active_instances;
     initOffsetsAndMap();
+    macro_env = std::make_unique<CUDAMacroEnvironment>(*model->environment, *this);
     // Register the signal handler.
     util::detail::SignalHandlers::registerSignalHandlers();
 
@@ -107,6 +108,7 @@ CUDASimulation::CUDASimulation(const std::shared_ptr<SubModelData> &submodel_des
     , isPureRTC(master_model->isPureRTC) {
     ++active_instances;
     initOffsetsAndMap();
+    macro_env = std::make_unique<CUDAMacroEnvironment>(*model->environment, *this);
     // Ensure submodel is valid
     if (submodel_desc->submodel->exitConditions.empty() && submodel_desc->submodel->exitConditionCallbacks.empty() && submodel_desc->max_steps == 0) {
         THROW exception::InvalidSubModel("Model '%s' does not contain any exit conditions or exit condition callbacks and submodel '%s' max steps is set to 0, SubModels must exit of their own accord, "
@@ -169,6 +171,7 @@ CUDASimulation::~CUDASimulation() {
         // unique pointers cleanup by automatically
         // Drop all constants from the constant cache linked to this model
         singletons->environment.free(singletons->curve, instance_id);
+        macro_env->free(singletons->curve);
         // if (active_instances == 1) {
         //   assert(singletons->curve.size() == 0);
         // }
@@ -195,11 +198,13 @@ CUDASimulation::~CUDASimulation() {
     if (deviceInitialised >= 0 && AUTO_CUDA_DEVICE_RESET) {
         std::shared_lock<std::shared_timed_mutex> maps_lock(active_device_maps_mutex);
         std::unique_lock<std::shared_timed_mutex> lock(active_device_mutex.at(deviceInitialised));
-        if (!--active_device_instances.at(deviceInitialised)) {
+        // Environment tables which are still referenced (e.g. pinned by CUDAEnsemble) would be lost by a reset
+        if (!--active_device_instances.at(deviceInitialised) && !detail::EnvironmentTableCache::getInstance().hasResidentTables()) {
             // Small chance that time between the atomic and body of this fn will cause a problem
             // Could mutex it with init simulation cuda stuff, but really seems unlikely
             gpuErrchk(cudaDeviceReset());
             EnvironmentManager::getInstance().purge();
+            detail::EnvironmentTableCache::getInstance().purge();
             detail::curve::Curve::getInstance().purge();
         }
     }
@@ -291,12 +296,16 @@ bool CUDASimulation::step() {
     // Execute each layer of the simulation.
     unsigned int layerIndex = 0;
     for (auto& layer : model->layers) {
-        // Execute the individual layer
-        stepLayer(layer, layerIndex);
+        // Execute the individual layer, unless it is not scheduled for this step
+        if (layer->executesAtStep(step_count))
+            stepLayer(layer, layerIndex);
         // Increment counter
         ++layerIndex;
     }
 
+    // Apply the stencil of each environment field, after the layers so fields are constant within an agent function
+    macro_env->stepFields(getStream(0));
+
     // Run the step functions (including pyhton.)
     stepStepFunctions();
 
@@ -390,13 +399,13 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
 
             // this->synchronizeAllStreams();  // Not required, the above is snchronizing.
         }
+        // Host storage is only read by the above, so other instances may now set properties whilst these kernels run
+        // Each instance's properties occupy disjoint bytes of the constant buffer, and only changed bytes are uploaded
+        // The device lock is held until the kernels complete, to prevent defrag moving the properties
+        env_shared_lock.unlock();
 
-        // Ensure RandomManager is the correct size to accommodate all threads to be launched
-        curandState *d_rng = singletons->rng.resize(totalThreads);  // @todo - stream + sync.
         // Track which stream to use for concurrency
         streamIdx = 0;
-        // Sum the total number of threads being launched in the layer, for rng offsetting.
-        totalThreads = 0;
         // Launch function condition kernels
         for (const auto &func_des : layer->agent_functions) {
             if ((func_des->condition) || (!func_des->rtc_func_condition_name.empty())) {
@@ -424,7 +433,8 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
                 detail::curve::Curve::NamespaceHash agentname_hash = detail::curve::Curve::variableRuntimeHash(agent_name.c_str());
                 detail::curve::Curve::NamespaceHash funcname_hash = detail::curve::Curve::variableRuntimeHash(func_name.c_str());
                 detail::curve::Curve::NamespaceHash agent_func_name_hash = agentname_hash + funcname_hash + instance_id;
-                curandState *t_rng = d_rng + totalThreads;
+                AgentRandom::Stream rng_stream = singletons->rng.agentStream(step_count, layerIndex, agent_name, func_name, true);
+                rng_stream.keyed = func_agent->variables.find(RNG_KEY_VARIABLE_NAME) != func_agent->variables.end();
                 unsigned int *scanFlag_agentDeath = this->singletons->scatter.Scan().Config(CUDAScanCompaction::Type::AGENT_DEATH, streamIdx).d_ptrs.scan_flag;
                 unsigned int sm_size = 0;
 #if !defined(SEATBELTS) || SEATBELTS
@@ -445,7 +455,7 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
                     instance_id,
                     agent_func_name_hash,
                     state_list_size,
-                    t_rng,
+                    rng_stream,
                     scanFlag_agentDeath);
                     gpuErrchkLaunch();
                 } else {  // RTC function
@@ -465,7 +475,7 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
                         const_cast<void*>(reinterpret_cast<const void*>(&instance_id)),
                         reinterpret_cast<void*>(&agent_func_name_hash),
                         const_cast<void *>(reinterpret_cast<const void*>(&state_list_size)),
-                        reinterpret_cast<void*>(&t_rng),
+                        const_cast<void*>(reinterpret_cast<const void*>(&rng_stream)),
                         reinterpret_cast<void*>(&scanFlag_agentDeath) });
                     if (a != CUresult::CUDA_SUCCESS) {
                         const char* err_str = nullptr;
@@ -475,7 +485,6 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
                     gpuErrchkLaunch();
                 }
 
-                totalThreads += state_list_size;
                 ++streamIdx;
             }
         }
@@ -483,7 +492,6 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
         // Ensure that each condition function has finished before unlocking the environment
         // Potentially there might be performance gains within a model by moving this until after the unmapping, although this may block other threads
         this->synchronizeAllStreams();
-        env_shared_lock.unlock();
         env_device_lock.unlock();
     }
 
@@ -523,6 +531,8 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
     streamIdx = 0;
     // Sum the total number of threads being launched in the layer
     totalThreads = 0;
+    // Number of threads launched for each agent function, this is less than the state size if sleeping agents are skipped
+    std::vector<unsigned int> launchSizes(layer->agent_functions.size(), 0);
     // for each func function - Loop through to do all mapping of agent and message variables
     for (const auto &func_des : layer->agent_functions) {
         auto func_agent = func_des->parent.lock();
@@ -531,7 +541,7 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
         }
         NVTX_RANGE(std::string("map" + func_agent->name + "::" + func_des->name).c_str());
 
-        const CUDAAgent& cuda_agent = getCUDAAgent(func_agent->name);
+        CUDAAgent& cuda_agent = getCUDAAgent(func_agent->name);
         const unsigned int state_list_size = cuda_agent.getStateSize(func_des->initial_state);
         if (state_list_size == 0) {
             ++streamIdx;
@@ -540,10 +550,29 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
         // Resize death flag array if necessary
         singletons->scatter.Scan().resize(state_list_size, CUDAScanCompaction::AGENT_DEATH, streamIdx);
 
+        // Zero the scan flag that will be written to
+        unsigned int *scanFlag_agentDeath = nullptr;
+        if (func_des->has_agent_death) {
+            singletons->scatter.Scan().CUDAScanCompaction::zero(CUDAScanCompaction::AGENT_DEATH, streamIdx);  // @todo stream?
+            scanFlag_agentDeath = singletons->scatter.Scan().Config(CUDAScanCompaction::Type::AGENT_DEATH, streamIdx).d_ptrs.scan_flag;
+        }
+
+        // Build the list of awake agents, if sleeping agents are to be skipped
+        const unsigned int launch_size = cuda_agent.mapAwakeIndex(*func_des, step_count, scanFlag_agentDeath, this->getStream(streamIdx));
+        launchSizes[streamIdx] = launch_size;
+        if (launch_size == 0) {
+            ++streamIdx;
+            continue;
+        }
+
         // check if a function has an input message
         if (auto im = func_des->message_input.lock()) {
             std::string inpMessage_name = im->name;
             CUDAMessage& cuda_message = getCUDAMessage(inpMessage_name);
+            // Agent views are not output, instead they track the current state of the viewed agents
+            if (cuda_message.isAgentView()) {
+                cuda_message.refreshAgentView(*layer, this->singletons->scatter, streamIdx, this->getStream(streamIdx));
+            }
             // Construct PBM here if required!!
             cuda_message.buildIndex(this->singletons->scatter, streamIdx, this->getStream(streamIdx));  // This is synchronous.
             // Map variables after, as index building can swap arrays
@@ -554,13 +583,15 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
         if (auto om = func_des->message_output.lock()) {
             std::string outpMessage_name = om->name;
             CUDAMessage& cuda_message = getCUDAMessage(outpMessage_name);
+            // Each agent has a slot for each message it may output
+            const unsigned int output_slots = launch_size * func_des->message_output_max;
             // Resize message list if required
             const unsigned int existingMessages = cuda_message.getTruncateMessageListFlag() ? 0 : cuda_message.getMessageCount();
-            cuda_message.resize(existingMessages + state_list_size, this->singletons->scatter, streamIdx);
-            cuda_message.mapWriteRuntimeVariables(*func_des, cuda_agent, state_list_size, instance_id);
-            singletons->scatter.Scan().resize(state_list_size, CUDAScanCompaction::MESSAGE_OUTPUT, streamIdx);
+            cuda_message.resize(existingMessages + output_slots, this->singletons->scatter, streamIdx);
+            cuda_message.mapWriteRuntimeVariables(*func_des, cuda_agent, output_slots, instance_id);
+            singletons->scatter.Scan().resize(output_slots, CUDAScanCompaction::MESSAGE_OUTPUT, streamIdx);
             // Zero the scan flag that will be written to
-            if (func_des->message_output_optional)
+            if (func_des->message_output_optional || func_des->message_output_max > 1)
                 singletons->scatter.Scan().zero(CUDAScanCompaction::MESSAGE_OUTPUT, streamIdx);  // @todo - do this in a stream?
         }
 
@@ -571,17 +602,12 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
             CUDAAgent& output_agent = getCUDAAgent(oa->name);
 
             // Map vars with curve (this allocates/requests enough new buffer space if an existing version is not available/suitable)
-            output_agent.mapNewRuntimeVariables(cuda_agent, *func_des, state_list_size, this->singletons->scatter, instance_id, streamIdx);  // @todo - stream?
+            output_agent.mapNewRuntimeVariables(cuda_agent, *func_des, launch_size, this->singletons->scatter, instance_id, streamIdx);  // @todo - stream?
         }
 
         // Configure runtime access of the functions variables within the FLAME_API object
         cuda_agent.mapRuntimeVariables(*func_des, instance_id);
 
-        // Zero the scan flag that will be written to
-        if (func_des->has_agent_death) {
-            singletons->scatter.Scan().CUDAScanCompaction::zero(CUDAScanCompaction::AGENT_DEATH, streamIdx);  // @todo stream?
-        }
-
         // Push function's RTC cache to device if using RTC
         if (!func_des->rtc_func_name.empty()) {
             has_rtc_func = true;
@@ -593,7 +619,7 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
         }
 
         // Count total threads being launched
-        totalThreads += cuda_agent.getStateSize(func_des->initial_state);
+        totalThreads += launch_size;
         ++streamIdx;
     }
 
@@ -606,11 +632,11 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
             this->singletons->curve.updateDevice();
             this->synchronizeAllStreams();  // This is not strictly required as updateDevice is synchronous.
         }
+        // Host storage is only read by the above, so other instances may now set properties whilst these kernels run
+        // Each instance's properties occupy disjoint bytes of the constant buffer, and only changed bytes are uploaded
+        // The device lock is held until the kernels complete, to prevent defrag moving the properties
+        env_shared_lock.unlock();
 
-        // Ensure RandomManager is the correct size to accommodate all threads to be launched
-        curandState *d_rng = singletons->rng.resize(totalThreads);
-        // Total threads is now used to provide kernel launches an offset to thread-safe thread-index
-        totalThreads = 0;
         streamIdx = 0;
 
         // for each func function - Loop through to launch all agent functions
@@ -623,6 +649,7 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
             const void *d_in_messagelist_metadata = nullptr;
             const void *d_out_messagelist_metadata = nullptr;
             id_t *d_agentOut_nextID = nullptr;
+            detail::DeviceBirthBuffer *d_agentOut_birthBuffer = nullptr;
             std::string agent_name = func_agent->name;
             std::string func_name = func_des->name;
             detail::curve::Curve::NamespaceHash agentname_hash = detail::curve::Curve::variableRuntimeHash(agent_name.c_str());
@@ -658,12 +685,13 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
                 agentoutput_hash = (detail::curve::Curve::variableRuntimeHash("_agent_birth") ^ funcname_hash) + instance_id;
                 CUDAAgent& output_agent = getCUDAAgent(oa->name);
                 d_agentOut_nextID = output_agent.getDeviceNextID();
+                d_agentOut_birthBuffer = output_agent.getDeviceBirthBuffer(*func_des);
             }
 
             const CUDAAgent& cuda_agent = getCUDAAgent(agent_name);
 
-            const unsigned int state_list_size = cuda_agent.getStateSize(func_des->initial_state);
-            if (state_list_size == 0) {
+            const unsigned int launch_size = launchSizes[streamIdx];
+            if (launch_size == 0) {
                 ++streamIdx;
                 continue;
             }
@@ -673,9 +701,12 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
             int gridSize = 0;  // The actual grid size needed, based on input size
 
             // Agent function kernel wrapper args
-            curandState * t_rng = d_rng + totalThreads;
+            const unsigned int *d_awake_index = cuda_agent.getDeviceAwakeIndex(*func_des);
+            AgentRandom::Stream rng_stream = singletons->rng.agentStream(step_count, layerIndex, agent_name, func_name);
+            rng_stream.keyed = func_agent->variables.find(RNG_KEY_VARIABLE_NAME) != func_agent->variables.end();
             unsigned int *scanFlag_agentDeath = func_des->has_agent_death ? this->singletons->scatter.Scan().Config(CUDAScanCompaction::Type::AGENT_DEATH, streamIdx).d_ptrs.scan_flag : nullptr;
             unsigned int *scanFlag_messageOutput = this->singletons->scatter.Scan().Config(CUDAScanCompaction::Type::MESSAGE_OUTPUT, streamIdx).d_ptrs.scan_flag;
+            const unsigned int messageOutput_max = func_des->message_output_max;
             unsigned int *scanFlag_agentOutput = this->singletons->scatter.Scan().Config(CUDAScanCompaction::Type::AGENT_OUTPUT, streamIdx).d_ptrs.scan_flag;
             unsigned int sm_size = 0;
     #if !defined(SEATBELTS) || SEATBELTS
@@ -685,9 +716,9 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
 
             if (func_des->func) {   // compile time specified agent function launch
                 // calculate the grid block size for main agent function
-                cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, func_des->func, 0, state_list_size);
+                cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, func_des->func, 0, launch_size);
                 //! Round up according to CUDAAgent state list size
-                gridSize = (state_list_size + blockSize - 1) / blockSize;
+                gridSize = (launch_size + blockSize - 1) / blockSize;
 
                 (func_des->func) << <gridSize, blockSize, sm_size, this->getStream(streamIdx) >> > (
     #if !defined(SEATBELTS) || SEATBELTS
@@ -699,12 +730,15 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
                     message_name_outp_hash,
                     agentoutput_hash,
                     d_agentOut_nextID,
-                    state_list_size,
+                    d_agentOut_birthBuffer,
+                    launch_size,
+                    d_awake_index,
                     d_in_messagelist_metadata,
                     d_out_messagelist_metadata,
-                    t_rng,
+                    rng_stream,
                     scanFlag_agentDeath,
                     scanFlag_messageOutput,
+                    messageOutput_max,
                     scanFlag_agentOutput);
                 gpuErrchkLaunch();
             } else {      // assume this is a runtime specified agent function
@@ -712,9 +746,9 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
                 const jitify::experimental::KernelInstantiation& instance = cuda_agent.getRTCInstantiation(func_name);
                 // calculate the grid block size for main agent function
                 CUfunction cu_func = (CUfunction)instance;
-                cuOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, cu_func, 0, 0, state_list_size);
+                cuOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, cu_func, 0, 0, launch_size);
                 //! Round up according to CUDAAgent state list size
-                gridSize = (state_list_size + blockSize - 1) / blockSize;
+                gridSize = (launch_size + blockSize - 1) / blockSize;
                 // launch the kernel
                 CUresult a = instance.configure(gridSize, blockSize, sm_size, this->getStream(streamIdx)).launch({
 #if !defined(SEATBELTS) || SEATBELTS
@@ -726,12 +760,15 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
                     reinterpret_cast<void*>(&message_name_outp_hash),
                     reinterpret_cast<void*>(&agentoutput_hash),
                     reinterpret_cast<void*>(&d_agentOut_nextID),
-                    const_cast<void*>(reinterpret_cast<const void*>(&state_list_size)),
+                    reinterpret_cast<void*>(&d_agentOut_birthBuffer),
+                    const_cast<void*>(reinterpret_cast<const void*>(&launch_size)),
+                    const_cast<void*>(reinterpret_cast<const void*>(&d_awake_index)),
                     const_cast<void*>(reinterpret_cast<const void*>(&d_in_messagelist_metadata)),
                     const_cast<void*>(reinterpret_cast<const void*>(&d_out_messagelist_metadata)),
-                    const_cast<void*>(reinterpret_cast<const void*>(&t_rng)),
+                    const_cast<void*>(reinterpret_cast<const void*>(&rng_stream)),
                     reinterpret_cast<void*>(&scanFlag_agentDeath),
                     reinterpret_cast<void*>(&scanFlag_messageOutput),
+                    const_cast<void*>(reinterpret_cast<const void*>(&messageOutput_max)),
                     reinterpret_cast<void*>(&scanFlag_agentOutput)});
                 if (a != CUresult::CUDA_SUCCESS) {
                     const char* err_str = nullptr;
@@ -740,13 +777,11 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
                 }
                 gpuErrchkLaunch();
             }
-            totalThreads += state_list_size;
             ++streamIdx;
         }
 
         // Ensure that each stream of work has finished before releasing the environment lock.
         this->synchronizeAllStreams();
-        env_shared_lock.unlock();
         env_device_lock.unlock();
     }
 
@@ -760,9 +795,12 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
         NVTX_RANGE(std::string("unmap" + func_agent->name + "::" + func_des->name).c_str());
         CUDAAgent& cuda_agent = getCUDAAgent(func_agent->name);
 
-        const unsigned int state_list_size = cuda_agent.getStateSize(func_des->initial_state);
+        const unsigned int launch_size = launchSizes[streamIdx];
         // If agent function wasn't executed, these are redundant
-        if (state_list_size > 0) {
+        if (launch_size > 0) {
+            // Reinsert the agents which executed into the wake calendar, this MUST occur before agent death, as it reads the agent indices
+            cuda_agent.updateWakeCalendar(*func_des, step_count, this->getStream(streamIdx));
+
             // check if a function has an input message
             if (auto im = func_des->message_input.lock()) {
                 std::string inpMessage_name = im->name;
@@ -775,11 +813,17 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
                 std::string outpMessage_name = om->name;
                 CUDAMessage& cuda_message = getCUDAMessage(outpMessage_name);
                 cuda_message.unmapRuntimeVariables(*func_des, instance_id);
-                cuda_message.swap(func_des->message_output_optional, state_list_size, this->singletons->scatter, streamIdx);
+                // Agents which may output multiple messages leave unused slots, so are compacted as though optional
+                cuda_message.swap(func_des->message_output_optional || func_des->message_output_max > 1, launch_size * func_des->message_output_max, this->singletons->scatter, streamIdx);
                 cuda_message.clearTruncateMessageListFlag();
                 cuda_message.setPBMConstructionRequiredFlag();
             }
 
+            // Gather births which spilled beyond a compact birth buffer, this MUST occur before agent death, as spilled births occupy the swap buffers
+            if (auto oa = func_des->agent_output.lock()) {
+                getCUDAAgent(oa->name).gatherSpilledBirths(*func_des, this->singletons->scatter, streamIdx, this->getStream(streamIdx));
+            }
+
             // Process agent death (has agent death check is handled by the method)
             // This MUST occur before agent_output, as if agent_output triggers resize then scan_flag for death will be purged
             cuda_agent.processDeath(*func_des, this->singletons->scatter, streamIdx, this->getStream(streamIdx));
@@ -792,14 +836,14 @@ void CUDASimulation::stepLayer(const std::shared_ptr<LayerData>& layer, const un
         cuda_agent.clearFunctionCondition(func_des->initial_state);
 
         // If agent function wasn't executed, these are redundant
-        if (state_list_size > 0) {
+        if (launch_size > 0) {
             // check if a function has an output agent
             if (auto oa = func_des->agent_output.lock()) {
                 // This will act as a reserve word
                 // which is added to variable hashes for agent creation on device
                 CUDAAgent& output_agent = getCUDAAgent(oa->name);
                 // Scatter the agent birth
-                output_agent.scatterNew(*func_des, state_list_size, this->singletons->scatter, streamIdx, this->getStream(streamIdx));
+                output_agent.scatterNew(*func_des, launch_size, this->singletons->scatter, streamIdx, this->getStream(streamIdx));
                 // unmap vars with curve
                 output_agent.unmapNewRuntimeVariables(*func_des, instance_id);
             }
@@ -1004,6 +1048,14 @@ void CUDASimulation::simulate() {
         // Resolution is 0.5 microseconds, so print to 1 us.
         fprintf(stdout, "Total Processing time: %.3f ms\n", elapsedMillisecondsSimulation);
     }
+    if (getSimulationConfig().verbose) {
+        // Report message list memory usage, to inform capacity hints
+        for (const auto &m : message_map) {
+            const CUDAMessage::MemoryStats stats = m.second->getMemoryStats();
+            fprintf(stdout, "Message '%s' list: capacity %u, peak %u messages, %u allocations, %.3f MiB\n",
+                m.first.c_str(), stats.capacity, stats.peak_message_count, stats.allocations, stats.allocated_bytes / (1024.0 * 1024.0));
+        }
+    }
     // Export logs
     if (!SimulationConfig().step_log_file.empty())
         exportLog(SimulationConfig().step_log_file, true, false);
@@ -1014,12 +1066,17 @@ void CUDASimulation::simulate() {
 }
 
 void CUDASimulation::reset(bool submodelReset) {
+    // Submodels are not reseeded between runs, so agent random must skip past the steps already taken
+    if (submodelReset && singletonsInitialised) {
+        singletons->rng.advanceSteps(step_count);
+    }
     // Reset step counter
     resetStepCounter();
 
     if (singletonsInitialised) {
         // Reset environment properties
         singletons->environment.resetModel(instance_id, *model->environment);
+        macro_env->reset();
 
         // Reseed random, unless performing submodel reset
         if (!submodelReset) {
@@ -1220,6 +1277,7 @@ void CUDASimulation::applyConfig_derived() {
         // We're not actually going to use this value, but it might be useful there later
         // Calling apply config a second time would reinit GPU, which might clear existing gpu allocations etc
         sm.second->CUDAConfig().device_id = config.device_id;
+        sm.second->CUDAConfig().foldRTCConstants = config.foldRTCConstants;
     }
 
     // Initialise singletons once a device has been selected.
@@ -1277,10 +1335,10 @@ void CUDASimulation::initialiseSingletons() {
             // Device has been reset, purge host mirrors of static objects/singletons
             detail::curve::Curve::getInstance().purge();
             if (singletons) {
-                singletons->rng.purge();
                 singletons->scatter.purge();
             }
             EnvironmentManager::getInstance().purge();
+            detail::EnvironmentTableCache::getInstance().purge();
             // Reset flag
             DEVICE_HAS_RESET_CHECK = 0;  // Any value that doesnt match DEVICE_HAS_RESET_FLAG
             gpuErrchk(cudaMemcpyToSymbol(DEVICE_HAS_RESET, &DEVICE_HAS_RESET_CHECK, sizeof(unsigned int)));
@@ -1295,6 +1353,9 @@ void CUDASimulation::initialiseSingletons() {
         // Reinitialise random for this simulation instance
         singletons->rng.reseed(getSimulationConfig().random_seed);
 
+        // Allocate environment macro properties
+        macro_env->init();
+
         // Pass created RandomManager to host api
         host_api = std::make_unique<HostAPI>(*this, singletons->rng, singletons->scatter, agentOffsets, agentData, 0, getStream(0));  // Host fns are currently all serial
 
@@ -1539,42 +1600,27 @@ void CUDASimulation::initEnvironmentMgr() {
         THROW exception::UnknownInternalError("CUDASimulation::initEnvironmentMgr() called before singletons member initialised.");
     }
 
-    // Set any properties loaded from file during arg parse stage
+    // Set any properties loaded from file during arg parse stage, as a single batch
+    // Const properties may be initialised from file, so const is ignored (as with RunPlan overrides)
+    std::vector<EnvironmentManager::PropertyWrite> env_writes;
+    env_writes.reserve(env_init.size());
     for (const auto &prop : env_init) {
-        const EnvironmentManager::NamePair np = { instance_id , prop.first.first };
-        if (!singletons->environment.containsProperty(np)) {
-            THROW exception::InvalidEnvProperty("Environment init data contains unexpected environment property '%s', "
-                "in CUDASimulation::initEnvironmentMgr()\n", prop.first.first.c_str());
-        }
-        const std::type_index val_type = singletons->environment.type(np);
-        if (val_type == std::type_index(typeid(float))) {
-            singletons->environment.setProperty<float>(np, prop.first.second, *static_cast<float*>(prop.second.ptr));
-        } else if (val_type == std::type_index(typeid(double))) {
-            singletons->environment.setProperty<double>(np, prop.first.second, *static_cast<double*>(prop.second.ptr));
-        } else if (val_type == std::type_index(typeid(int64_t))) {
-            singletons->environment.setProperty<int64_t>(np, prop.first.second, *static_cast<int64_t*>(prop.second.ptr));
-        } else if (val_type == std::type_index(typeid(uint64_t))) {
-            singletons->environment.setProperty<uint64_t>(np, prop.first.second, *static_cast<uint64_t*>(prop.second.ptr));
-        } else if (val_type == std::type_index(typeid(int32_t))) {
-            singletons->environment.setProperty<int32_t>(np, prop.first.second, *static_cast<int32_t*>(prop.second.ptr));
-        } else if (val_type == std::type_index(typeid(uint32_t))) {
-            singletons->environment.setProperty<uint32_t>(np, prop.first.second, *static_cast<uint32_t*>(prop.second.ptr));
-        } else if (val_type == std::type_index(typeid(int16_t))) {
-            singletons->environment.setProperty<int16_t>(np, prop.first.second, *static_cast<int16_t*>(prop.second.ptr));
-        } else if (val_type == std::type_index(typeid(uint16_t))) {
-            singletons->environment.setProperty<uint16_t>(np, prop.first.second, *static_cast<uint16_t*>(prop.second.ptr));
-        } else if (val_type == std::type_index(typeid(int8_t))) {
-            singletons->environment.setProperty<int8_t>(np, prop.first.second, *static_cast<int8_t*>(prop.second.ptr));
-        } else if (val_type == std::type_index(typeid(uint8_t))) {
-            singletons->environment.setProperty<uint8_t>(np, prop.first.second, *static_cast<uint8_t*>(prop.second.ptr));
-        } else {
-            THROW exception::InvalidEnvProperty("Environment init data contains environment property '%s' of unsupported type '%s', "
-                "this should have been caught during file parsing, "
-                "in CUDASimulation::initEnvironmentMgr()\n", prop.first.first.c_str(), val_type.name());
-        }
+        env_writes.emplace_back(prop.first.first, prop.second, prop.first.second);
     }
+    singletons->environment.setProperties(instance_id, env_writes, true);
     // Clear init
     env_init.clear();
+
+    // Set any macro properties loaded from file during arg parse stage
+    for (const auto &prop : macro_env_init) {
+        const CUDAMacroEnvironment::MacroEnvProp &info = macro_env->getPropertyInfo(prop.first);
+        if (prop.second.size() != info.type_size * info.elementCount()) {
+            THROW exception::InvalidEnvProperty("Environment init data for macro property '%s' has the wrong length, "
+                "in CUDASimulation::initEnvironmentMgr()\n", prop.first.c_str());
+        }
+        macro_env->setPropertyData(prop.first, prop.second.data());
+    }
+    macro_env_init.clear();
 }
 void CUDASimulation::resetLog() {
     run_log->step.clear();
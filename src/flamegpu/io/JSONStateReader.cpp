@@ -7,6 +7,7 @@
 #include <fstream>
 #include <string>
 #include <unordered_map>
+#include <vector>
 #include <cerrno>
 
 #include "flamegpu/exception/FLAMEGPUException.h"
@@ -22,21 +23,25 @@ JSONStateReader::JSONStateReader(
     const std::string &model_name,
     const std::unordered_map<std::string, EnvironmentDescription::PropData> &env_desc,
     util::StringUint32PairUnorderedMap<util::Any> &env_init,
+    const std::unordered_map<std::string, EnvironmentDescription::MacroPropData> &macro_env_desc,
+    std::unordered_map<std::string, std::vector<char>> &macro_env_init,
     util::StringPairUnorderedMap<std::shared_ptr<AgentVector>> &model_state,
     const std::string &input,
     Simulation *sim_instance)
-    : StateReader(model_name, env_desc, env_init, model_state, input, sim_instance) {}
+    : StateReader(model_name, env_desc, env_init, macro_env_desc, macro_env_init, model_state, input, sim_instance) {}
 /**
  * This is the main sax style parser for the json state
  * It stores it's current position within the hierarchy with mode, lastKey and current_variable_array_index
  */
 class JSONStateReader_impl : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, JSONStateReader_impl>  {
-    enum Mode{ Nop, Root, Config, Stats, SimCfg, CUDACfg, Environment, Agents, Agent, State, AgentInstance, VariableArray };
+    enum Mode{ Nop, Root, Config, Stats, SimCfg, CUDACfg, Environment, MacroEnvironment, Agents, Agent, State, AgentInstance, VariableArray };
     std::stack<Mode> mode;
     std::string lastKey;
     std::string filename;
     const std::unordered_map<std::string, EnvironmentDescription::PropData> env_desc;
     util::StringUint32PairUnorderedMap<util::Any> &env_init;
+    const std::unordered_map<std::string, EnvironmentDescription::MacroPropData> &macro_env_desc;
+    std::unordered_map<std::string, std::vector<char>> &macro_env_init;
     /**
      * Used for setting agent values
      */
@@ -58,10 +63,14 @@ class JSONStateReader_impl : public rapidjson::BaseReaderHandler<rapidjson::UTF8
     JSONStateReader_impl(const std::string &_filename,
         const std::unordered_map<std::string, EnvironmentDescription::PropData> &_env_desc,
         util::StringUint32PairUnorderedMap<util::Any> &_env_init,
+        const std::unordered_map<std::string, EnvironmentDescription::MacroPropData> &_macro_env_desc,
+        std::unordered_map<std::string, std::vector<char>> &_macro_env_init,
         util::StringPairUnorderedMap<std::shared_ptr<AgentVector>> &_model_state)
         : filename(_filename)
         , env_desc(_env_desc)
         , env_init(_env_init)
+        , macro_env_desc(_macro_env_desc)
+        , macro_env_init(_macro_env_init)
         , model_state(_model_state) { }
     template<typename T>
     bool processValue(const T&val) {
@@ -115,6 +124,61 @@ class JSONStateReader_impl : public rapidjson::BaseReaderHandler<rapidjson::UTF8
                 THROW exception::RapidJSONError("Model contains environment property '%s' of unsupported type '%s', "
                     "in JSONStateReader::parse()\n", lastKey.c_str(), val_type.name());
             }
+        } else if (mode.top() == MacroEnvironment) {
+            const auto it = macro_env_desc.find(lastKey);
+            if (it == macro_env_desc.end()) {
+                THROW exception::RapidJSONError("Input file contains unrecognised environment macro property '%s',"
+                    "in JSONStateReader::parse()\n", lastKey.c_str());
+            }
+            const size_t elements = static_cast<size_t>(it->second.elements[0]) * it->second.elements[1] * it->second.elements[2] * it->second.elements[3];
+            if (current_variable_array_index >= elements) {
+                THROW exception::RapidJSONError("Input file contains too many elements for environment macro property '%s', expected %u, "
+                    "in JSONStateReader::parse()\n", lastKey.c_str(), static_cast<unsigned int>(elements));
+            }
+            std::vector<char> &data = macro_env_init[lastKey];
+            if (current_variable_array_index == 0) {
+                if (!data.empty()) {
+                    THROW exception::RapidJSONError("Input file contains environment macro property '%s' multiple times, "
+                        "in JSONStateReader::parse()\n", lastKey.c_str());
+                }
+                data.resize(it->second.type_size * elements);
+            }
+            char *dst = data.data() + it->second.type_size * current_variable_array_index++;
+            const std::type_index val_type = it->second.type;
+            if (val_type == std::type_index(typeid(float))) {
+                const float t = static_cast<float>(val);
+                memcpy(dst, &t, sizeof(float));
+            } else if (val_type == std::type_index(typeid(double))) {
+                const double t = static_cast<double>(val);
+                memcpy(dst, &t, sizeof(double));
+            } else if (val_type == std::type_index(typeid(int64_t))) {
+                const int64_t t = static_cast<int64_t>(val);
+                memcpy(dst, &t, sizeof(int64_t));
+            } else if (val_type == std::type_index(typeid(uint64_t))) {
+                const uint64_t t = static_cast<uint64_t>(val);
+                memcpy(dst, &t, sizeof(uint64_t));
+            } else if (val_type == std::type_index(typeid(int32_t))) {
+                const int32_t t = static_cast<int32_t>(val);
+                memcpy(dst, &t, sizeof(int32_t));
+            } else if (val_type == std::type_index(typeid(uint32_t))) {
+                const uint32_t t = static_cast<uint32_t>(val);
+                memcpy(dst, &t, sizeof(uint32_t));
+            } else if (val_type == std::type_index(typeid(int16_t))) {
+                const int16_t t = static_cast<int16_t>(val);
+                memcpy(dst, &t, sizeof(int16_t));
+            } else if (val_type == std::type_index(typeid(uint16_t))) {
+                const uint16_t t = static_cast<uint16_t>(val);
+                memcpy(dst, &t, sizeof(uint16_t));
+            } else if (val_type == std::type_index(typeid(int8_t))) {
+                const int8_t t = static_cast<int8_t>(val);
+                memcpy(dst, &t, sizeof(int8_t));
+            } else if (val_type == std::type_index(typeid(uint8_t))) {
+                const uint8_t t = static_cast<uint8_t>(val);
+                memcpy(dst, &t, sizeof(uint8_t));
+            } else {
+                THROW exception::RapidJSONError("Model contains environment macro property '%s' of unsupported type '%s', "
+                    "in JSONStateReader::parse()\n", lastKey.c_str(), val_type.name());
+            }
         } else if (mode.top() == AgentInstance) {
             const std::shared_ptr<AgentVector> &pop = model_state.at({current_agent, current_state});
             AgentVector::Agent instance = pop->back();
@@ -194,6 +258,8 @@ class JSONStateReader_impl : public rapidjson::BaseReaderHandler<rapidjson::UTF8
                 mode.push(Stats);
             } else if (lastKey == "environment") {
                 mode.push(Environment);
+            } else if (lastKey == "macro_environment") {
+                mode.push(MacroEnvironment);
             } else if (lastKey == "agents") {
                 mode.push(Agents);
             } else {
@@ -236,7 +302,7 @@ class JSONStateReader_impl : public rapidjson::BaseReaderHandler<rapidjson::UTF8
         }
         if (mode.top() == AgentInstance) {
             mode.push(VariableArray);
-        } else if (mode.top() == Environment) {
+        } else if (mode.top() == Environment || mode.top() == MacroEnvironment) {
             mode.push(VariableArray);
         } else if (mode.top() == Agent) {
             current_state = lastKey;
@@ -260,7 +326,7 @@ class JSONStateReader_impl : public rapidjson::BaseReaderHandler<rapidjson::UTF8
  * It also reads the config blocks, so that device can be init before we do environment
  */
 class JSONStateReader_agentsize_counter : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, JSONStateReader_impl>  {
-    enum Mode{ Nop, Root, Config, Stats, SimCfg, CUDACfg, Environment, Agents, Agent, State, AgentInstance, VariableArray };
+    enum Mode{ Nop, Root, Config, Stats, SimCfg, CUDACfg, Environment, MacroEnvironment, Agents, Agent, State, AgentInstance, VariableArray };
     std::stack<Mode> mode;
     std::string lastKey;
     unsigned int currentIndex = 0;
@@ -355,6 +421,8 @@ class JSONStateReader_agentsize_counter : public rapidjson::BaseReaderHandler<ra
                 mode.push(Stats);
             } else if (lastKey == "environment") {
                 mode.push(Environment);
+            } else if (lastKey == "macro_environment") {
+                mode.push(MacroEnvironment);
             } else if (lastKey == "agents") {
                 mode.push(Agents);
             } else {
@@ -393,7 +461,7 @@ class JSONStateReader_agentsize_counter : public rapidjson::BaseReaderHandler<ra
         }
         if (mode.top() == AgentInstance) {
             mode.push(VariableArray);
-        } else if (mode.top() == Environment) {
+        } else if (mode.top() == Environment || mode.top() == MacroEnvironment) {
             mode.push(VariableArray);
         } else if (mode.top() == Agent) {
             current_state = lastKey;
@@ -418,7 +486,7 @@ int JSONStateReader::parse() {
         THROW exception::RapidJSONError("Unable to open file '%s' for reading.\n", inputFile.c_str());
     }
     JSONStateReader_agentsize_counter agentcounter(inputFile, sim_instance);
-    JSONStateReader_impl handler(inputFile, env_desc, env_init, model_state);
+    JSONStateReader_impl handler(inputFile, env_desc, env_init, macro_env_desc, macro_env_init, model_state);
     std::string filestring = std::string((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
     rapidjson::StringStream filess(filestring.c_str());
     rapidjson::Reader reader;
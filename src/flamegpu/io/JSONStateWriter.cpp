@@ -6,6 +6,7 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <vector>
 
 #include "flamegpu/exception/FLAMEGPUException.h"
 #include "flamegpu/model/AgentDescription.h"
@@ -142,6 +143,52 @@ void JSONStateWriter::doWrite(T &writer) {
     }
     writer.EndObject();
 
+    // Environment macro properties
+    const CUDASimulation *cudasim_instance = dynamic_cast<const CUDASimulation*>(sim_instance);
+    if (cudasim_instance && !cudasim_instance->getMacroEnvironment().getPropertiesMap().empty()) {
+        writer.Key("macro_environment");
+        writer.StartObject();
+        const CUDAMacroEnvironment &macro_env = cudasim_instance->getMacroEnvironment();
+        for (const auto &a : macro_env.getPropertiesMap()) {
+            // Set name
+            writer.Key(a.first.c_str());
+            // Macro properties are always output as a flat array
+            const size_t elements = a.second.elementCount();
+            std::vector<char> macro_buffer(a.second.type_size * elements);
+            macro_env.getPropertyData(a.first, macro_buffer.data());
+            const char *buffer = macro_buffer.data();
+            writer.StartArray();
+            for (size_t el = 0; el < elements; ++el) {
+                if (a.second.type == std::type_index(typeid(float))) {
+                    writer.Double(reinterpret_cast<const float*>(buffer)[el]);
+                } else if (a.second.type == std::type_index(typeid(double))) {
+                    writer.Double(reinterpret_cast<const double*>(buffer)[el]);
+                } else if (a.second.type == std::type_index(typeid(int64_t))) {
+                    writer.Int64(reinterpret_cast<const int64_t*>(buffer)[el]);
+                } else if (a.second.type == std::type_index(typeid(uint64_t))) {
+                    writer.Uint64(reinterpret_cast<const uint64_t*>(buffer)[el]);
+                } else if (a.second.type == std::type_index(typeid(int32_t))) {
+                    writer.Int(reinterpret_cast<const int32_t*>(buffer)[el]);
+                } else if (a.second.type == std::type_index(typeid(uint32_t))) {
+                    writer.Uint(reinterpret_cast<const uint32_t*>(buffer)[el]);
+                } else if (a.second.type == std::type_index(typeid(int16_t))) {
+                    writer.Int(reinterpret_cast<const int16_t*>(buffer)[el]);
+                } else if (a.second.type == std::type_index(typeid(uint16_t))) {
+                    writer.Uint(reinterpret_cast<const uint16_t*>(buffer)[el]);
+                } else if (a.second.type == std::type_index(typeid(int8_t))) {
+                    writer.Int(static_cast<int32_t>(reinterpret_cast<const int8_t*>(buffer)[el]));  // Char outputs weird if being used as an integer
+                } else if (a.second.type == std::type_index(typeid(uint8_t))) {
+                    writer.Uint(static_cast<uint32_t>(reinterpret_cast<const uint8_t*>(buffer)[el]));  // Char outputs weird if being used as an integer
+                } else {
+                    THROW exception::RapidJSONError("Model contains environment macro property '%s' of unsupported type '%s', "
+                        "in JSONStateWriter::writeStates()\n", a.first.c_str(), a.second.type.name());
+                }
+            }
+            writer.EndArray();
+        }
+        writer.EndObject();
+    }
+
     // AgentStates
     writer.Key("agents");
     writer.StartObject();
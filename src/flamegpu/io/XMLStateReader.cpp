@@ -12,6 +12,7 @@
 #include <sstream>
 #include <algorithm>
 #include <tuple>
+#include <vector>
 #include "tinyxml2/tinyxml2.h"              // downloaded from https:// github.com/leethomason/tinyxml2, the list of xml parsers : http:// lars.ruoff.free.fr/xmlcpp/
 #include "flamegpu/exception/FLAMEGPUException.h"
 #include "flamegpu/pop/AgentVector.h"
@@ -68,10 +69,12 @@ XMLStateReader::XMLStateReader(
     const std::string &model_name,
     const std::unordered_map<std::string, EnvironmentDescription::PropData> &env_desc,
     util::StringUint32PairUnorderedMap<util::Any> &env_init,
+    const std::unordered_map<std::string, EnvironmentDescription::MacroPropData> &macro_env_desc,
+    std::unordered_map<std::string, std::vector<char>> &macro_env_init,
     util::StringPairUnorderedMap<std::shared_ptr<AgentVector>> &model_state,
     const std::string &input,
     Simulation *sim_instance)
-    : StateReader(model_name, env_desc, env_init, model_state, input, sim_instance) {}
+    : StateReader(model_name, env_desc, env_init, macro_env_desc, macro_env_init, model_state, input, sim_instance) {}
 
 std::string XMLStateReader::getInitialState(const std::string &agent_name) const {
     for (const auto &i : model_state) {
@@ -243,6 +246,75 @@ int XMLStateReader::parse() {
         fprintf(stderr, "Warning: Input file '%s' does not contain environment node.\n", inputFile.c_str());
     }
 
+    // Read environment macro property data
+    pElement = pRoot->FirstChildElement("macro_environment");
+    if (pElement) {
+        for (auto envElement = pElement->FirstChildElement(); envElement; envElement = envElement->NextSiblingElement()) {
+            const char *key = envElement->Value();
+            std::stringstream ss(envElement->GetText() ? envElement->GetText() : "");
+            std::string token;
+            const auto it = macro_env_desc.find(std::string(key));
+            if (it == macro_env_desc.end()) {
+                THROW exception::TinyXMLError("Input file contains unrecognised environment macro property '%s',"
+                    "in XMLStateReader::parse()\n", key);
+            }
+            if (macro_env_init.find(key) != macro_env_init.end()) {
+                THROW exception::TinyXMLError("Input file contains environment macro property '%s' multiple times, "
+                    "in XMLStateReader::parse()\n", key);
+            }
+            const std::type_index val_type = it->second.type;
+            const size_t elements = static_cast<size_t>(it->second.elements[0]) * it->second.elements[1] * it->second.elements[2] * it->second.elements[3];
+            std::vector<char> &data = macro_env_init[key];
+            data.resize(it->second.type_size * elements);
+            size_t el = 0;
+            while (getline(ss, token, ',')) {
+                if (el >= elements) {
+                    THROW exception::TinyXMLError("Input file contains too many elements for environment macro property '%s', expected %u, "
+                        "in XMLStateReader::parse()\n", key, static_cast<unsigned int>(elements));
+                }
+                char *dst = data.data() + it->second.type_size * el++;
+                if (val_type == std::type_index(typeid(float))) {
+                    const float t = stof(token);
+                    memcpy(dst, &t, sizeof(float));
+                } else if (val_type == std::type_index(typeid(double))) {
+                    const double t = stod(token);
+                    memcpy(dst, &t, sizeof(double));
+                } else if (val_type == std::type_index(typeid(int64_t))) {
+                    const int64_t t = stoll(token);
+                    memcpy(dst, &t, sizeof(int64_t));
+                } else if (val_type == std::type_index(typeid(uint64_t))) {
+                    const uint64_t t = stoull(token);
+                    memcpy(dst, &t, sizeof(uint64_t));
+                } else if (val_type == std::type_index(typeid(int32_t))) {
+                    const int32_t t = static_cast<int32_t>(stoll(token));
+                    memcpy(dst, &t, sizeof(int32_t));
+                } else if (val_type == std::type_index(typeid(uint32_t))) {
+                    const uint32_t t = static_cast<uint32_t>(stoull(token));
+                    memcpy(dst, &t, sizeof(uint32_t));
+                } else if (val_type == std::type_index(typeid(int16_t))) {
+                    const int16_t t = static_cast<int16_t>(stoll(token));
+                    memcpy(dst, &t, sizeof(int16_t));
+                } else if (val_type == std::type_index(typeid(uint16_t))) {
+                    const uint16_t t = static_cast<uint16_t>(stoull(token));
+                    memcpy(dst, &t, sizeof(uint16_t));
+                } else if (val_type == std::type_index(typeid(int8_t))) {
+                    const int8_t t = static_cast<int8_t>(stoll(token));
+                    memcpy(dst, &t, sizeof(int8_t));
+                } else if (val_type == std::type_index(typeid(uint8_t))) {
+                    const uint8_t t = static_cast<uint8_t>(stoull(token));
+                    memcpy(dst, &t, sizeof(uint8_t));
+                } else {
+                    THROW exception::TinyXMLError("Model contains environment macro property '%s' of unsupported type '%s', "
+                        "in XMLStateReader::parse()\n", key, val_type.name());
+                }
+            }
+            if (el != elements) {
+                fprintf(stderr, "Warning: Environment macro property '%s' expects '%u' elements, input file '%s' contains '%u' elements.\n",
+                    key, static_cast<unsigned int>(elements), inputFile.c_str(), static_cast<unsigned int>(el));
+            }
+        }
+    }
+
     // Count how many of each agent are in the file and resize state lists
     util::StringPairUnorderedMap<unsigned int> cts;
     for (pElement = pRoot->FirstChildElement("xagent"); pElement != nullptr; pElement = pElement->NextSiblingElement("xagent")) {
@@ -9,6 +9,7 @@
  */
 #include "flamegpu/io/XMLStateWriter.h"
 #include <sstream>
+#include <vector>
 #include "tinyxml2/tinyxml2.h"              // downloaded from https:// github.com/leethomason/tinyxml2, the list of xml parsers : http:// lars.ruoff.free.fr/xmlcpp/
 #include "flamegpu/exception/FLAMEGPUException.h"
 #include "flamegpu/model/AgentDescription.h"
@@ -190,6 +191,53 @@ int XMLStateWriter::writeStates(bool prettyPrint) {
     }
     pRoot->InsertEndChild(pElement);
 
+    // Environment macro properties are output as flat csv strings
+    const CUDASimulation *cudasim_instance = dynamic_cast<const CUDASimulation*>(sim_instance);
+    if (cudasim_instance && !cudasim_instance->getMacroEnvironment().getPropertiesMap().empty()) {
+        pElement = doc.NewElement("macro_environment");
+        const CUDAMacroEnvironment &macro_env = cudasim_instance->getMacroEnvironment();
+        for (const auto &a : macro_env.getPropertiesMap()) {
+            tinyxml2::XMLElement* pListElement = doc.NewElement(a.first.c_str());
+            pListElement->SetAttribute("type", a.second.type.name());
+            const size_t elements = a.second.elementCount();
+            std::vector<char> macro_buffer(a.second.type_size * elements);
+            macro_env.getPropertyData(a.first, macro_buffer.data());
+            const char *buffer = macro_buffer.data();
+            std::stringstream ss;
+            for (size_t el = 0; el < elements; ++el) {
+                if (a.second.type == std::type_index(typeid(float))) {
+                    ss << reinterpret_cast<const float*>(buffer)[el];
+                } else if (a.second.type == std::type_index(typeid(double))) {
+                    ss << reinterpret_cast<const double*>(buffer)[el];
+                } else if (a.second.type == std::type_index(typeid(int64_t))) {
+                    ss << reinterpret_cast<const int64_t*>(buffer)[el];
+                } else if (a.second.type == std::type_index(typeid(uint64_t))) {
+                    ss << reinterpret_cast<const uint64_t*>(buffer)[el];
+                } else if (a.second.type == std::type_index(typeid(int32_t))) {
+                    ss << reinterpret_cast<const int32_t*>(buffer)[el];
+                } else if (a.second.type == std::type_index(typeid(uint32_t))) {
+                    ss << reinterpret_cast<const uint32_t*>(buffer)[el];
+                } else if (a.second.type == std::type_index(typeid(int16_t))) {
+                    ss << reinterpret_cast<const int16_t*>(buffer)[el];
+                } else if (a.second.type == std::type_index(typeid(uint16_t))) {
+                    ss << reinterpret_cast<const uint16_t*>(buffer)[el];
+                } else if (a.second.type == std::type_index(typeid(int8_t))) {
+                    ss << static_cast<int32_t>(reinterpret_cast<const int8_t*>(buffer)[el]);  // Char outputs weird if being used as an integer
+                } else if (a.second.type == std::type_index(typeid(uint8_t))) {
+                    ss << static_cast<uint32_t>(reinterpret_cast<const uint8_t*>(buffer)[el]);  // Char outputs weird if being used as an integer
+                } else {
+                    THROW exception::TinyXMLError("Model contains environment macro property '%s' of unsupported type '%s', "
+                        "in XMLStateWriter::writeStates()\n", a.first.c_str(), a.second.type.name());
+                }
+                if (el + 1 != elements)
+                    ss << ",";
+            }
+            pListElement->SetText(ss.str().c_str());
+            pElement->InsertEndChild(pListElement);
+        }
+        pRoot->InsertEndChild(pElement);
+    }
+
     unsigned int populationSize;
 
     // for each agent types
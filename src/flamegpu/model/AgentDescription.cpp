@@ -62,6 +62,14 @@ void AgentDescription::setInitialState(const std::string &init_state) {
         agent->name.c_str(), init_state.c_str());
 }
 
+void AgentDescription::setSleepEnabled(const bool enabled) {
+    if (enabled) {
+        agent->variables.emplace(WAKE_STEP_VARIABLE_NAME, Variable(std::array<unsigned int, 1>{ 0 }));
+    } else {
+        agent->variables.erase(WAKE_STEP_VARIABLE_NAME);
+    }
+}
+
 AgentFunctionDescription &AgentDescription::Function(const std::string &function_name) {
     auto f = agent->functions.find(function_name);
     if (f != agent->functions.end()) {
@@ -151,5 +159,8 @@ bool AgentDescription::hasFunction(const std::string &function_name) const {
 bool AgentDescription::isOutputOnDevice() const {
     return agent->isOutputOnDevice();
 }
+bool AgentDescription::isSleepEnabled() const {
+    return agent->variables.find(WAKE_STEP_VARIABLE_NAME) != agent->variables.end();
+}
 
 }  // namespace flamegpu
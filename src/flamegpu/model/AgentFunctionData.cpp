@@ -13,8 +13,12 @@ AgentFunctionData::AgentFunctionData(std::shared_ptr<AgentData> _parent, const s
     , rtc_func_name("")
     , initial_state(_parent->initial_state)
     , end_state(_parent->initial_state)
+    , message_input_variables_declared(false)
     , message_output_optional(false)
+    , message_output_max(1)
+    , agent_output_birth_rate(1.0f)
     , has_agent_death(false)
+    , include_sleeping(false)
     , condition(nullptr)
     , rtc_condition_source("")
     , rtc_func_condition_name("")
@@ -29,8 +33,12 @@ AgentFunctionData::AgentFunctionData(std::shared_ptr<AgentData> _parent, const s
     , rtc_func_name(code_func_name)
     , initial_state(_parent->initial_state)
     , end_state(_parent->initial_state)
+    , message_input_variables_declared(false)
     , message_output_optional(false)
+    , message_output_max(1)
+    , agent_output_birth_rate(1.0f)
     , has_agent_death(false)
+    , include_sleeping(false)
     , condition(nullptr)
     , rtc_condition_source("")
     , rtc_func_condition_name("")
@@ -46,9 +54,14 @@ AgentFunctionData::AgentFunctionData(const std::shared_ptr<const ModelData> &mod
     , rtc_func_name(other.rtc_func_name)
     , initial_state(other.initial_state)
     , end_state(other.end_state)
+    , message_input_variables(other.message_input_variables)
+    , message_input_variables_declared(other.message_input_variables_declared)
     , message_output_optional(other.message_output_optional)
+    , message_output_max(other.message_output_max)
     , agent_output_state(other.agent_output_state)
+    , agent_output_birth_rate(other.agent_output_birth_rate)
     , has_agent_death(other.has_agent_death)
+    , include_sleeping(other.include_sleeping)
     , condition(other.condition)
     , rtc_condition_source(other.rtc_condition_source)
     , rtc_func_condition_name(other.rtc_func_condition_name)
@@ -99,9 +112,14 @@ bool AgentFunctionData::operator==(const AgentFunctionData &rhs) const {
         && (rtc_func_name == rhs.rtc_func_name)
         && (initial_state == rhs.initial_state)
         && (end_state == rhs.end_state)
+        && (message_input_variables_declared == rhs.message_input_variables_declared)
+        && (message_input_variables == rhs.message_input_variables)
         && (message_output_optional == rhs.message_output_optional)
+        && (message_output_max == rhs.message_output_max)
         && (agent_output_state == rhs.agent_output_state)
+        && (agent_output_birth_rate == rhs.agent_output_birth_rate)
         && (has_agent_death == rhs.has_agent_death)
+        && (include_sleeping == rhs.include_sleeping)
         && (condition == rhs.condition)
         && (rtc_condition_source == rhs.rtc_condition_source)
         && (rtc_func_condition_name == rhs.rtc_func_condition_name)) {
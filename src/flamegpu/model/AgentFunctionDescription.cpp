@@ -1,9 +1,12 @@
 #include <nvrtc.h>
 #include <cuda.h>
+#include <array>
 #include <fstream>
 #include <iostream>
+#include <set>
 #include <sstream>
 #include <string>
+#include <vector>
 #include <regex>
 
 #include "flamegpu/model/AgentFunctionDescription.h"
@@ -144,6 +147,8 @@ void AgentFunctionDescription::setMessageInput(const std::string &message_name)
         auto demangledClassName = util::detail::cxxname::getUnqualifiedName(detail::curve::CurveRTCHost::demangle(a->second->getType()));
         if (message_in_classname == demangledClassName) {
             this->function->message_input = a->second;
+            this->function->message_input_variables.clear();
+            this->function->message_input_variables_declared = false;
         } else {
             THROW exception::InvalidMessageType("Message ('%s') type '%s' does not match type '%s' applied to FLAMEGPU_AGENT_FUNCTION ('%s'), "
                 "in AgentFunctionDescription::setMessageInput().",
@@ -180,6 +185,8 @@ void AgentFunctionDescription::setMessageInput(MessageBruteForce::Description &m
             auto demangledClassName = util::detail::cxxname::getUnqualifiedName(detail::curve::CurveRTCHost::demangle(a->second->getType()));
             if (message_in_classname == demangledClassName) {
                 this->function->message_input = a->second;
+                this->function->message_input_variables.clear();
+                this->function->message_input_variables_declared = false;
             } else {
                 THROW exception::InvalidMessageType("Message ('%s') type '%s' does not match type '%s' applied to FLAMEGPU_AGENT_FUNCTION ('%s'), "
                     "in AgentFunctionDescription::setMessageInput().",
@@ -196,6 +203,25 @@ void AgentFunctionDescription::setMessageInput(MessageBruteForce::Description &m
             mdl->name.c_str(), message.getName().c_str());
     }
 }
+void AgentFunctionDescription::setMessageInputVariables(const std::vector<std::string> &variable_names) {
+    auto m = function->message_input.lock();
+    if (!m) {
+        THROW exception::InvalidMessageName("Message input has not been set for agent function '%s', "
+            "in AgentFunctionDescription::setMessageInputVariables().",
+            function->name.c_str());
+    }
+    std::set<std::string> names;
+    for (const auto &variable_name : variable_names) {
+        if (m->variables.find(variable_name) == m->variables.end()) {
+            THROW exception::InvalidMessageVar("Message '%s' does not contain variable '%s', "
+                "in AgentFunctionDescription::setMessageInputVariables().",
+                m->name.c_str(), variable_name.c_str());
+        }
+        names.insert(variable_name);
+    }
+    function->message_input_variables = names;
+    function->message_input_variables_declared = true;
+}
 void AgentFunctionDescription::setMessageOutput(const std::string &message_name) {
     if (auto other = function->message_input.lock()) {
         if (message_name == other->name) {
@@ -297,6 +323,13 @@ void AgentFunctionDescription::setMessageOutputOptional(const bool &output_is_op
         }
     }
 }
+void AgentFunctionDescription::setMessageOutputMax(const unsigned int &max_messages) {
+    if (max_messages == 0) {
+        THROW exception::InvalidArgument("Maximum messages output per agent must be at least 1, "
+            "in AgentFunctionDescription::setMessageOutputMax().");
+    }
+    this->function->message_output_max = max_messages;
+}
 void AgentFunctionDescription::setAgentOutput(const std::string &agent_name, const std::string state) {
     // Set new
     auto mdl = model.lock();
@@ -313,6 +346,8 @@ void AgentFunctionDescription::setAgentOutput(const std::string &agent_name, con
             this->function->agent_output = a->second;
             this->function->agent_output_state = state;
             a->second->agent_outputs++;  // Mark inside agent that we are using it as an output
+            // Agents born on the device require a random key, as their IDs depend on scheduling
+            a->second->variables.emplace(RNG_KEY_VARIABLE_NAME, Variable(std::array<uint64_t, 1>{ 0 }));
         } else {
             THROW exception::InvalidStateName("Agent ('%s') does not contain state '%s', "
                 "in AgentFunctionDescription::setAgentOutput().",
@@ -346,6 +381,8 @@ void AgentFunctionDescription::setAgentOutput(AgentDescription &agent, const std
                 this->function->agent_output = a->second;
                 this->function->agent_output_state = state;
                 a->second->agent_outputs++;  // Mark inside agent that we are using it as an output
+                // Agents born on the device require a random key, as their IDs depend on scheduling
+                a->second->variables.emplace(RNG_KEY_VARIABLE_NAME, Variable(std::array<uint64_t, 1>{ 0 }));
             } else {
                 THROW exception::InvalidStateName("Agent ('%s') does not contain state '%s', "
                     "in AgentFunctionDescription::setAgentOutput().",
@@ -362,9 +399,20 @@ void AgentFunctionDescription::setAgentOutput(AgentDescription &agent, const std
             mdl->name.c_str(), agent.getName().c_str());
     }
 }
+void AgentFunctionDescription::setAgentOutputBirthRate(const float &birth_rate) {
+    if (!(birth_rate > 0.0f && birth_rate <= 1.0f)) {
+        THROW exception::InvalidArgument("Agent output birth rate must be in the range (0.0, 1.0], %f was provided, "
+            "in AgentFunctionDescription::setAgentOutputBirthRate().",
+            birth_rate);
+    }
+    function->agent_output_birth_rate = birth_rate;
+}
 void AgentFunctionDescription::setAllowAgentDeath(const bool &has_death) {
     function->has_agent_death = has_death;
 }
+void AgentFunctionDescription::setIncludeSleeping(const bool &include_sleeping) {
+    function->include_sleeping = include_sleeping;
+}
 
 void AgentFunctionDescription::setRTCFunctionCondition(std::string func_cond_src) {
     // Use Regex to get agent function name
@@ -441,6 +489,9 @@ const MessageBruteForce::Description &AgentFunctionDescription::getMessageOutput
 bool AgentFunctionDescription::getMessageOutputOptional() const {
     return this->function->message_output_optional;
 }
+unsigned int AgentFunctionDescription::getMessageOutputMax() const {
+    return this->function->message_output_max;
+}
 const AgentDescription &AgentFunctionDescription::getAgentOutput() const {
     if (auto a = function->agent_output.lock())
         return *a->description;
@@ -453,9 +504,21 @@ std::string AgentFunctionDescription::getAgentOutputState() const {
     THROW exception::OutOfBoundsException("Agent output has not been set, "
         "in AgentFunctionDescription::getAgentOutputState().");
 }
+float AgentFunctionDescription::getAgentOutputBirthRate() const {
+    return function->agent_output_birth_rate;
+}
 bool AgentFunctionDescription::getAllowAgentDeath() const {
     return function->has_agent_death;
 }
+bool AgentFunctionDescription::getIncludeSleeping() const {
+    return function->include_sleeping;
+}
+std::vector<std::string> AgentFunctionDescription::getMessageInputVariables() const {
+    return std::vector<std::string>(function->message_input_variables.begin(), function->message_input_variables.end());
+}
+bool AgentFunctionDescription::hasMessageInputVariables() const {
+    return function->message_input_variables_declared;
+}
 
 bool AgentFunctionDescription::hasMessageInput() const {
     return function->message_input.lock() != nullptr;
@@ -1,5 +1,7 @@
 #include "flamegpu/model/EnvironmentDescription.h"
 
+#include <cmath>
+
 namespace flamegpu {
 
 EnvironmentDescription::EnvironmentDescription() {
@@ -32,7 +34,7 @@ bool EnvironmentDescription::operator==(const EnvironmentDescription& rhs) const
             }
             return false;
         }
-        return true;
+        return macro_properties == rhs.macro_properties && tables == rhs.tables && fields == rhs.fields;
     }
     return false;
 }
@@ -58,5 +60,54 @@ bool EnvironmentDescription::getConst(const std::string &name) {
 const std::unordered_map<std::string, EnvironmentDescription::PropData> EnvironmentDescription::getPropertiesMap() const {
     return properties;
 }
+const std::unordered_map<std::string, EnvironmentDescription::MacroPropData> &EnvironmentDescription::getMacroPropertiesMap() const {
+    return macro_properties;
+}
+const std::unordered_map<std::string, EnvironmentDescription::TableData> &EnvironmentDescription::getTablesMap() const {
+    return tables;
+}
+const std::unordered_map<std::string, EnvironmentDescription::FieldData> &EnvironmentDescription::getFieldsMap() const {
+    return fields;
+}
+
+void EnvironmentDescription::newField(const std::string &name, const FieldData &field) {
+    if (!name.empty() && name[0] == '_') {
+        THROW exception::ReservedName("Environment field names cannot begin with '_', this is reserved for internal usage, "
+            "in EnvironmentDescription::newField().");
+    }
+    if (hasName(name)) {
+        THROW exception::DuplicateEnvProperty("Environmental property with name '%s' already exists, "
+            "in EnvironmentDescription::newField().",
+            name.c_str());
+    }
+    if (!field.dimensions[0] || !field.dimensions[1] || !field.dimensions[2] || !field.sub_steps) {
+        THROW exception::InvalidArgument("Environment field '%s' dimensions and sub_steps must be greater than 0, "
+            "in EnvironmentDescription::newField().",
+            name.c_str());
+    }
+    if (field.diffusion < 0.0f || field.decay < 0.0f) {
+        THROW exception::InvalidArgument("Environment field '%s' diffusion and decay must not be negative, "
+            "in EnvironmentDescription::newField().",
+            name.c_str());
+    }
+    // The explicit stencil is only stable (and non-negative) if no cell can lose more than its value per sub-step
+    float rate = field.decay;
+    for (unsigned int axis = 0; axis < 3; ++axis) {
+        if (field.dimensions[axis] > 1)
+            rate += 2.0f * field.diffusion + std::fabs(field.velocity[axis]);
+    }
+    if (rate / field.sub_steps > 1.0f) {
+        THROW exception::InvalidArgument("Environment field '%s' stencil is unstable, sub_steps must be at least %u, "
+            "in EnvironmentDescription::newField().",
+            name.c_str(), static_cast<unsigned int>(std::ceil(rate)));
+    }
+    fields.emplace(name, field);
+}
+bool EnvironmentDescription::hasName(const std::string &name) const {
+    return properties.find(name) != properties.end()
+        || macro_properties.find(name) != macro_properties.end()
+        || tables.find(name) != tables.end()
+        || fields.find(name) != fields.end();
+}
 
 }  // namespace flamegpu
@@ -8,14 +8,18 @@ namespace flamegpu {
 LayerData::LayerData(const std::shared_ptr<const ModelData> &model, const std::string &layer_name, const ModelData::size_type &layer_index)
     : description(new LayerDescription(model, this))
     , name(layer_name)
-    , index(layer_index) { }
+    , index(layer_index)
+    , execution_interval(1)
+    , execution_phase(0) { }
 
 LayerData::LayerData(const std::shared_ptr<const ModelData> &model, const LayerData &other)
     : host_functions(other.host_functions)
     , host_functions_callbacks(other.host_functions_callbacks)
     , description(model ? new LayerDescription(model, this) : nullptr)
     , name(other.name)
-    , index(other.index) {
+    , index(other.index)
+    , execution_interval(other.execution_interval)
+    , execution_phase(other.execution_phase) {
     // Manually perform lookup copies
     for (auto &_f : other.agent_functions) {
         for (auto &a : model->agents) {
@@ -42,6 +46,8 @@ bool LayerData::operator==(const LayerData &rhs) const {
         return true;
     if (name == rhs.name
     && index == rhs.index
+    && execution_interval == rhs.execution_interval
+    && execution_phase == rhs.execution_phase
     && agent_functions.size() == rhs.agent_functions.size()
     && host_functions.size() == rhs.host_functions.size()
     && host_functions_callbacks.size() == rhs.host_functions_callbacks.size()
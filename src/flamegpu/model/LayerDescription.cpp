@@ -188,6 +188,19 @@ void LayerDescription::addSubModel(const SubModelDescription &submodel) {
         submodel.data->submodel->name.c_str(), mdl->name.c_str());
 }
 
+void LayerDescription::setExecutionInterval(const unsigned int every_n, const unsigned int phase) {
+    if (every_n == 0) {
+        THROW exception::InvalidArgument("Layer execution interval must be greater than 0, "
+            "in LayerDescription::setExecutionInterval()\n");
+    }
+    if (phase >= every_n) {
+        THROW exception::InvalidArgument("Layer execution phase (%u) must be less than the execution interval (%u), "
+            "in LayerDescription::setExecutionInterval()\n", phase, every_n);
+    }
+    layer->execution_interval = every_n;
+    layer->execution_phase = phase;
+}
+
 std::string LayerDescription::getName() const {
     return layer->name;
 }
@@ -195,6 +208,12 @@ std::string LayerDescription::getName() const {
 ModelData::size_type LayerDescription::getIndex() const {
     return layer->index;
 }
+unsigned int LayerDescription::getExecutionInterval() const {
+    return layer->execution_interval;
+}
+unsigned int LayerDescription::getExecutionPhase() const {
+    return layer->execution_phase;
+}
 
 
 ModelData::size_type LayerDescription::getAgentFunctionsCount() const {
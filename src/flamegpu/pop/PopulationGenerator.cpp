@@ -0,0 +1,104 @@
+#include "flamegpu/pop/PopulationGenerator.h"
+
+#include <thread>
+
+namespace flamegpu {
+
+const PopulationGenerator::size_type PopulationGenerator::MIN_AGENTS_PER_THREAD = 65536;
+
+PopulationGenerator::PopulationGenerator()
+    : thread_count(0) { }
+
+void PopulationGenerator::setThreadCount(const unsigned int threads) {
+    thread_count = threads;
+}
+unsigned int PopulationGenerator::getThreadCount() const {
+    if (thread_count)
+        return thread_count;
+    const unsigned int hw = std::thread::hardware_concurrency();
+    return hw ? hw : 1;
+}
+void PopulationGenerator::validateAxes(const size_t axes, const size_t a, const size_t b, const char *caller) {
+    if (axes == 0 || axes != a || axes != b) {
+        THROW exception::InvalidArgument("The number of axis variables (%u) must be non-zero and match the length of each argument vector (%u, %u), "
+            "in %s.", static_cast<unsigned int>(axes), static_cast<unsigned int>(a), static_cast<unsigned int>(b), caller);
+    }
+}
+float PopulationGenerator::sampleNormal(const util::detail::Philox::uint32x4 &r, float) {
+    return util::detail::Philox::toNormal(util::detail::Philox::toFloat(r.x), util::detail::Philox::toFloat(r.y));
+}
+double PopulationGenerator::sampleNormal(const util::detail::Philox::uint32x4 &r, double) {
+    return util::detail::Philox::toNormal(util::detail::Philox::toDouble(r.x, r.y), util::detail::Philox::toDouble(r.z, r.w));
+}
+
+void PopulationGenerator::generate(AgentVector &population, const size_type count, const uint64_t seed) const {
+    // Validate all generators before modifying the population
+    const VariableMap &vars = population.getVariableMetaData();
+    for (const auto &g : generators) {
+        if (!g.variable_name.empty() && g.variable_name[0] == '_') {
+            THROW exception::ReservedName("Agent variable names that begin with '_' are reserved for internal usage and cannot be generated, "
+                "in PopulationGenerator::generate().");
+        }
+        const auto var = vars.find(g.variable_name);
+        if (var == vars.end()) {
+            THROW exception::InvalidAgentVar("Variable with name '%s' was not found in agent '%s', "
+                "in PopulationGenerator::generate().",
+                g.variable_name.c_str(), population.getAgentName().c_str());
+        }
+        if (var->second.type != g.type) {
+            THROW exception::InvalidVarType("Variable '%s' is of a different type. "
+                "'%s' was expected, but '%s' was requested, "
+                "in PopulationGenerator::generate().",
+                g.variable_name.c_str(), var->second.type.name(), g.type.name());
+        }
+        if (g.max_count && count > g.max_count) {
+            THROW exception::OutOfBoundsException("%u agents requested, but the lattice for variable '%s' only has %u points, "
+                "in PopulationGenerator::generate().",
+                static_cast<unsigned int>(count), g.variable_name.c_str(), static_cast<unsigned int>(g.max_count));
+        }
+    }
+    if (!count)
+        return;
+    // Allocate and default initialise the new agents
+    const size_type offset = population.size();
+    population.resize(offset + count);
+    if (generators.empty())
+        return;
+    // Collect raw buffers, this also notifies DeviceAgentVector that the variables have changed
+    std::vector<void*> buffers;
+    std::vector<unsigned int> elements;
+    buffers.reserve(generators.size());
+    elements.reserve(generators.size());
+    for (const auto &g : generators) {
+        buffers.push_back(population.data(g.variable_name));
+        elements.push_back(vars.at(g.variable_name).elements);
+    }
+    const util::detail::Philox::uint32x2 key = util::detail::Philox::key(seed);
+    auto fill_range = [&](const size_type begin, const size_type end) {
+        for (size_t g = 0; g < generators.size(); ++g) {
+            generators[g].fill(buffers[g], elements[g], offset, begin, end, key, static_cast<uint32_t>(g));
+        }
+    };
+    // Split the range into contiguous chunks, one per thread
+    const size_type max_threads = (count + MIN_AGENTS_PER_THREAD - 1) / MIN_AGENTS_PER_THREAD;
+    const size_type threads = std::min<size_type>(getThreadCount(), max_threads);
+    if (threads <= 1) {
+        fill_range(0, count);
+        return;
+    }
+    const size_type chunk = (count + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (size_type t = 0; t < threads; ++t) {
+        const size_type begin = t * chunk;
+        const size_type end = std::min(begin + chunk, count);
+        if (begin >= end)
+            break;
+        workers.emplace_back(fill_range, begin, end);
+    }
+    for (auto &w : workers) {
+        w.join();
+    }
+}
+
+}  // namespace flamegpu
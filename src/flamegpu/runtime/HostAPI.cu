@@ -4,6 +4,7 @@
 #include "flamegpu/sim/Simulation.h"
 #include "flamegpu/util/nvtx.h"
 #include "flamegpu/gpu/CUDASimulation.h"
+#include "flamegpu/runtime/messaging/MessageGraph/MessageGraphHost.h"
 
 namespace flamegpu {
 
@@ -15,7 +16,7 @@ HostAPI::HostAPI(CUDASimulation &_agentModel,
     const unsigned int& _streamId,
     cudaStream_t _stream)
     : random(rng)
-    , environment(_agentModel.getInstanceID())
+    , environment(_agentModel.getInstanceID(), _agentModel.getMacroEnvironment())
     , agentModel(_agentModel)
     , d_cub_temp(nullptr)
     , d_cub_temp_size(0)
@@ -51,6 +52,15 @@ HostAgentAPI HostAPI::agent(const std::string &agent_name, const std::string &st
     return HostAgentAPI(*this, agentModel.getAgent(agent_name), state_name, agentOffsets.at(agent_name), state->second);
 }
 
+MessageGraph::Topology HostAPI::graph(const std::string &message_name) {
+    CUDAMessage &cuda_message = agentModel.getCUDAMessage(message_name);
+    auto *handler = dynamic_cast<MessageGraph::CUDAModelHandler *>(cuda_message.getSpecialisationHander());
+    if (!handler) {
+        THROW exception::InvalidMessageType("Message '%s' is not of type MessageGraph, in HostAPI::graph().\n", message_name.c_str());
+    }
+    return MessageGraph::Topology(*handler);
+}
+
 bool HostAPI::tempStorageRequiresResize(const CUB_Config &cc, const unsigned int &items) {
     auto lao = cub_largestAllocatedOp.find(cc);
     if (lao != cub_largestAllocatedOp.end()) {
@@ -1,4 +1,11 @@
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <limits>
+#include <map>
 #include <sstream>
+#include <string>
 
 #include "flamegpu/runtime/detail/curve/curve_rtc.cuh"
 #include "flamegpu/exception/FLAMEGPUException.h"
@@ -189,6 +196,21 @@ __device__ __forceinline__ bool DeviceEnvironment::containsProperty(const char(&
 $DYNAMIC_ENV_CONTAINTS_IMPL
 }
 
+template<typename T, unsigned int I, unsigned int J, unsigned int K, unsigned int W, unsigned int N>
+__device__ __forceinline__ DeviceMacroProperty<T, I, J, K, W> DeviceEnvironment::getMacroProperty(const char(&name)[N]) const {
+$DYNAMIC_ENV_GETMACROPROPERTY_IMPL
+}
+
+template<typename T, unsigned int N>
+__device__ __forceinline__ DeviceEnvironmentTable<T> DeviceEnvironment::getTable(const char(&name)[N]) const {
+$DYNAMIC_ENV_GETTABLE_IMPL
+}
+
+template<unsigned int N>
+__device__ __forceinline__ DeviceEnvironmentField DeviceEnvironment::getField(const char(&name)[N]) const {
+$DYNAMIC_ENV_GETFIELD_IMPL
+}
+
 }  // namespace flamegpu
 
 #endif  // CURVE_RTC_DYNAMIC_H_
@@ -310,12 +332,23 @@ void* CurveRTCHost::getNewAgentVariableCachePtr(const char* variableName) {
     THROW exception::UnknownInternalError("Variable '%s' not found when accessing variable, in CurveRTCHost::getNewAgentVariableCachePtr()", variableName);
 }
 
-void CurveRTCHost::registerEnvVariable(const char* propertyName, ptrdiff_t offset, const char* type, size_t type_size, unsigned int elements) {
+void CurveRTCHost::registerEnvVariable(const char* propertyName, ptrdiff_t offset, const char* type, size_t type_size, unsigned int elements, const void *const_value) {
     RTCEnvVariableProperties props;
     props.type = CurveRTCHost::demangle(type);
     props.elements = elements;
     props.offset = offset;
     props.type_size = type_size;
+    // Only values which can be written as a literal of the property's type can be folded
+    if (const_value && !getFoldedEnvType(props.type).empty()) {
+        props.const_value.resize(type_size * elements);
+        memcpy(props.const_value.data(), const_value, props.const_value.size());
+        for (unsigned int i = 0; i < elements; ++i) {
+            if (getFoldedEnvLiteral(props, i).empty()) {
+                props.const_value.clear();
+                break;
+            }
+        }
+    }
     if (!RTCEnvVariables.emplace(propertyName, props).second) {
         THROW exception::UnknownInternalError("Environment property with name '%s' is already registered, in CurveRTCHost::registerEnvVariable()", propertyName);
     }
@@ -330,6 +363,37 @@ void CurveRTCHost::unregisterEnvVariable(const char* propertyName) {
     }
 }
 
+void CurveRTCHost::registerEnvMacroProperty(const char* propertyName, void *d_ptr, const char* type, size_t type_size, const std::array<unsigned int, 4> &dimensions) {
+    RTCEnvMacroPropertyProperties props;
+    props.type = CurveRTCHost::demangle(type);
+    props.dimensions = dimensions;
+    props.type_size = type_size;
+    props.d_ptr = d_ptr;
+    props.h_data_ptr = nullptr;
+    if (!RTCEnvMacroProperties.emplace(propertyName, props).second) {
+        THROW exception::UnknownInternalError("Environment macro property with name '%s' is already registered, in CurveRTCHost::registerEnvMacroProperty()", propertyName);
+    }
+}
+
+void CurveRTCHost::registerEnvTable(const char* tableName, const void *d_ptr, size_t type_size, unsigned int length) {
+    RTCEnvTableProperties props;
+    props.type_size = type_size;
+    props.length = length;
+    props.d_ptr = d_ptr;
+    props.h_data_ptr = nullptr;
+    if (!RTCEnvTables.emplace(tableName, props).second) {
+        THROW exception::UnknownInternalError("Environment table with name '%s' is already registered, in CurveRTCHost::registerEnvTable()", tableName);
+    }
+}
+
+void CurveRTCHost::registerEnvField(const char* fieldName, void *d_ptr) {
+    RTCEnvFieldProperties props;
+    props.d_ptr = d_ptr;
+    props.h_data_ptr = nullptr;
+    if (!RTCEnvFields.emplace(fieldName, props).second) {
+        THROW exception::UnknownInternalError("Environment field with name '%s' is already registered, in CurveRTCHost::registerEnvField()", fieldName);
+    }
+}
 
 void CurveRTCHost::initHeaderEnvironment() {
     // Calculate size of, and generate dynamic variables buffer
@@ -342,7 +406,19 @@ void CurveRTCHost::initHeaderEnvironment() {
     messageOut_data_offset = data_buffer_size;    data_buffer_size += messageOut_variables.size() * sizeof(void*);
     messageIn_data_offset = data_buffer_size;     data_buffer_size += messageIn_variables.size() * sizeof(void*);
     newAgent_data_offset = data_buffer_size;  data_buffer_size += newAgent_variables.size() * sizeof(void*);
+    envMacro_data_offset = data_buffer_size;  data_buffer_size += RTCEnvMacroProperties.size() * sizeof(void*);
+    envTable_data_offset = data_buffer_size;  data_buffer_size += RTCEnvTables.size() * sizeof(void*);
+    envField_data_offset = data_buffer_size;  data_buffer_size += RTCEnvFields.size() * sizeof(void*);
     variables << "__constant__  char " << getVariableSymbolName() << "[" << data_buffer_size << "];\n";
+    // Folded environment properties are declared as arrays of their own type, so they can be read without type punning
+    std::map<std::string, std::string> folded_symbols;
+    for (const auto &element : RTCEnvVariables) {
+        if (!element.second.const_value.empty()) {
+            const std::string symbol = "rtc_env_folded_" + std::to_string(folded_symbols.size());
+            variables << getFoldedEnvValue(symbol, element.second);
+            folded_symbols.emplace(element.first, symbol);
+        }
+    }
     setHeaderPlaceholder("$DYNAMIC_VARIABLES", variables.str());
     // generate Environment::get func implementation ($DYNAMIC_ENV_GETVARIABLE_IMPL)
     {
@@ -354,6 +430,8 @@ void CurveRTCHost::initHeaderEnvironment() {
 #else
             {
 #endif
+                // GLM types are read whole from array properties, so folded arrays are only used by the array getter
+                const auto folded = props.elements == 1 ? folded_symbols.find(element.first) : folded_symbols.end();
                 getEnvVariableImpl <<   "    if (strings_equal(name, \"" << element.first << "\")) {\n";
                 getEnvVariableImpl <<   "#if !defined(SEATBELTS) || SEATBELTS\n";
 #if !defined(USE_GLM)
@@ -365,7 +443,11 @@ void CurveRTCHost::initHeaderEnvironment() {
                 getEnvVariableImpl <<   "            return {};\n";
                 getEnvVariableImpl <<   "        }\n";
                 getEnvVariableImpl <<   "#endif\n";
-                getEnvVariableImpl <<   "        return *reinterpret_cast<T*>(reinterpret_cast<void*>(flamegpu::detail::curve::" << getVariableSymbolName() <<" + " << props.offset << "));\n";
+                if (folded != folded_symbols.end()) {
+                    getEnvVariableImpl << "        return static_cast<T>(flamegpu::detail::curve::" << folded->second << "[0]);\n";
+                } else {
+                    getEnvVariableImpl << "        return *reinterpret_cast<T*>(reinterpret_cast<void*>(flamegpu::detail::curve::" << getVariableSymbolName() <<" + " << props.offset << "));\n";
+                }
                 getEnvVariableImpl <<   "    };\n";
             }
         }
@@ -395,7 +477,12 @@ void CurveRTCHost::initHeaderEnvironment() {
                 getEnvArrayVariableImpl << "            return {};\n";
                 getEnvArrayVariableImpl << "        }\n";
                 getEnvArrayVariableImpl << "#endif\n";
-                getEnvArrayVariableImpl << "        return reinterpret_cast<T*>(reinterpret_cast<void*>(flamegpu::detail::curve::" << getVariableSymbolName() <<" + " << props.offset << "))[index];\n";
+                const auto folded = folded_symbols.find(element.first);
+                if (folded != folded_symbols.end()) {
+                    getEnvArrayVariableImpl << "        return static_cast<T>(flamegpu::detail::curve::" << folded->second << "[index]);\n";
+                } else {
+                    getEnvArrayVariableImpl << "        return reinterpret_cast<T*>(reinterpret_cast<void*>(flamegpu::detail::curve::" << getVariableSymbolName() <<" + " << props.offset << "))[index];\n";
+                }
                 getEnvArrayVariableImpl << "    };\n";
             }
         }
@@ -418,6 +505,69 @@ void CurveRTCHost::initHeaderEnvironment() {
         containsEnvVariableImpl <<           "    return false;\n";
         setHeaderPlaceholder("$DYNAMIC_ENV_CONTAINTS_IMPL", containsEnvVariableImpl.str());
     }
+    // generate Environment::getMacroProperty func implementation ($DYNAMIC_ENV_GETMACROPROPERTY_IMPL)
+    {
+        size_t ct = 0;
+        std::stringstream getMacroPropertyImpl;
+        for (const auto &element : RTCEnvMacroProperties) {
+            const RTCEnvMacroPropertyProperties &props = element.second;
+            getMacroPropertyImpl <<   "    if (strings_equal(name, \"" << element.first << "\")) {\n";
+            getMacroPropertyImpl <<   "#if !defined(SEATBELTS) || SEATBELTS\n";
+            getMacroPropertyImpl <<   "        if(sizeof(T) != " << props.type_size << ") {\n";
+            getMacroPropertyImpl <<   "            DTHROW(\"Environment macro property '%s' type mismatch.\\n\", name);\n";
+            getMacroPropertyImpl <<   "            return DeviceMacroProperty<T, I, J, K, W>(nullptr);\n";
+            getMacroPropertyImpl <<   "        } else if (I != " << props.dimensions[0] << " || J != " << props.dimensions[1]
+                                 <<   " || K != " << props.dimensions[2] << " || W != " << props.dimensions[3] << ") {\n";
+            getMacroPropertyImpl <<   "            DTHROW(\"Environment macro property '%s' dimensions mismatch.\\n\", name);\n";
+            getMacroPropertyImpl <<   "            return DeviceMacroProperty<T, I, J, K, W>(nullptr);\n";
+            getMacroPropertyImpl <<   "        }\n";
+            getMacroPropertyImpl <<   "#endif\n";
+            getMacroPropertyImpl <<   "        return DeviceMacroProperty<T, I, J, K, W>(*static_cast<T**>(static_cast<void*>(flamegpu::detail::curve::" << getVariableSymbolName() << " + " << envMacro_data_offset + (ct++ * sizeof(void*)) << ")));\n";
+            getMacroPropertyImpl <<   "    };\n";
+        }
+        getMacroPropertyImpl <<       "#if !defined(SEATBELTS) || SEATBELTS\n";
+        getMacroPropertyImpl <<       "    DTHROW(\"Environment macro property '%s' was not found.\\n\", name);\n";
+        getMacroPropertyImpl <<       "#endif\n";
+        getMacroPropertyImpl <<       "    return DeviceMacroProperty<T, I, J, K, W>(nullptr);\n";
+        setHeaderPlaceholder("$DYNAMIC_ENV_GETMACROPROPERTY_IMPL", getMacroPropertyImpl.str());
+    }
+    // generate Environment::getTable func implementation ($DYNAMIC_ENV_GETTABLE_IMPL)
+    {
+        size_t ct = 0;
+        std::stringstream getTableImpl;
+        for (const auto &element : RTCEnvTables) {
+            const RTCEnvTableProperties &props = element.second;
+            getTableImpl <<   "    if (strings_equal(name, \"" << element.first << "\")) {\n";
+            getTableImpl <<   "#if !defined(SEATBELTS) || SEATBELTS\n";
+            getTableImpl <<   "        if(sizeof(T) != " << props.type_size << ") {\n";
+            getTableImpl <<   "            DTHROW(\"Environment table '%s' type mismatch.\\n\", name);\n";
+            getTableImpl <<   "            return DeviceEnvironmentTable<T>(nullptr, 0);\n";
+            getTableImpl <<   "        }\n";
+            getTableImpl <<   "#endif\n";
+            getTableImpl <<   "        return DeviceEnvironmentTable<T>(*static_cast<const T**>(static_cast<void*>(flamegpu::detail::curve::" << getVariableSymbolName() << " + " << envTable_data_offset + (ct++ * sizeof(void*)) << ")), " << props.length << "u);\n";
+            getTableImpl <<   "    };\n";
+        }
+        getTableImpl <<       "#if !defined(SEATBELTS) || SEATBELTS\n";
+        getTableImpl <<       "    DTHROW(\"Environment table '%s' was not found.\\n\", name);\n";
+        getTableImpl <<       "#endif\n";
+        getTableImpl <<       "    return DeviceEnvironmentTable<T>(nullptr, 0);\n";
+        setHeaderPlaceholder("$DYNAMIC_ENV_GETTABLE_IMPL", getTableImpl.str());
+    }
+    // generate Environment::getField func implementation ($DYNAMIC_ENV_GETFIELD_IMPL)
+    {
+        size_t ct = 0;
+        std::stringstream getFieldImpl;
+        for (const auto &element : RTCEnvFields) {
+            getFieldImpl <<   "    if (strings_equal(name, \"" << element.first << "\")) {\n";
+            getFieldImpl <<   "        return DeviceEnvironmentField(*static_cast<void**>(static_cast<void*>(flamegpu::detail::curve::" << getVariableSymbolName() << " + " << envField_data_offset + (ct++ * sizeof(void*)) << ")));\n";
+            getFieldImpl <<   "    };\n";
+        }
+        getFieldImpl <<       "#if !defined(SEATBELTS) || SEATBELTS\n";
+        getFieldImpl <<       "    DTHROW(\"Environment field '%s' was not found.\\n\", name);\n";
+        getFieldImpl <<       "#endif\n";
+        getFieldImpl <<       "    return DeviceEnvironmentField(nullptr);\n";
+        setHeaderPlaceholder("$DYNAMIC_ENV_GETFIELD_IMPL", getFieldImpl.str());
+    }
 }
 void CurveRTCHost::initHeaderSetters() {
     // generate setAgentVariable func implementation ($DYNAMIC_SETAGENTVARIABLE_IMPL)
@@ -918,6 +1068,24 @@ void CurveRTCHost::initDataBuffer() {
     for (auto &element : newAgent_variables) {
         element.second.h_data_ptr = h_data_buffer + newAgent_data_offset + (ct++ * sizeof(void*));
     }
+    // Macro property buffers do not move after allocation, so they can be written immediately
+    ct = 0;
+    for (auto &element : RTCEnvMacroProperties) {
+        element.second.h_data_ptr = h_data_buffer + envMacro_data_offset + (ct++ * sizeof(void*));
+        memcpy(element.second.h_data_ptr, &element.second.d_ptr, sizeof(void*));
+    }
+    // Table buffers are likewise fixed for as long as they are referenced
+    ct = 0;
+    for (auto &element : RTCEnvTables) {
+        element.second.h_data_ptr = h_data_buffer + envTable_data_offset + (ct++ * sizeof(void*));
+        memcpy(element.second.h_data_ptr, &element.second.d_ptr, sizeof(void*));
+    }
+    // Field buffers do not move after allocation, the stencil only ever copies its result back into them
+    ct = 0;
+    for (auto &element : RTCEnvFields) {
+        element.second.h_data_ptr = h_data_buffer + envField_data_offset + (ct++ * sizeof(void*));
+        memcpy(element.second.h_data_ptr, &element.second.d_ptr, sizeof(void*));
+    }
 }
 
 std::string CurveRTCHost::getDynamicHeader() {
@@ -944,6 +1112,72 @@ std::string CurveRTCHost::getVariableSymbolName() {
     return name.str();
 }
 
+std::string CurveRTCHost::getFoldedEnvType(const std::string &type) {
+    // MSVC names 64 bit integers differently
+    static const std::map<std::string, std::string> types = {
+        {"float", "float"}, {"double", "double"}, {"bool", "bool"},
+        {"char", "char"}, {"signed char", "signed char"}, {"unsigned char", "unsigned char"},
+        {"short", "short"}, {"unsigned short", "unsigned short"},
+        {"int", "int"}, {"unsigned int", "unsigned int"},
+        {"long", "long"}, {"unsigned long", "unsigned long"},
+        {"long long", "long long"}, {"unsigned long long", "unsigned long long"},
+        {"__int64", "long long"}, {"unsigned __int64", "unsigned long long"},
+    };
+    const auto t = types.find(type);
+    return t != types.end() ? t->second : "";
+}
+
+std::string CurveRTCHost::getFoldedEnvLiteral(const RTCEnvVariableProperties &props, const unsigned int index) {
+    const std::string type = getFoldedEnvType(props.type);
+    const char *bits = props.const_value.data() + index * props.type_size;
+    std::stringstream literal;
+    if (type == "float" || type == "double") {
+        double value;
+        if (props.type_size == sizeof(float)) {
+            float f;
+            memcpy(&f, bits, sizeof(float));
+            value = f;
+        } else {
+            memcpy(&value, bits, sizeof(double));
+        }
+        // Non-finite values have no literal
+        if (!std::isfinite(value))
+            return "";
+        // max_digits10 significant digits reproduce the value exactly
+        literal << std::scientific << std::setprecision(props.type_size == sizeof(float) ? std::numeric_limits<float>::max_digits10 : std::numeric_limits<double>::max_digits10);
+        literal << value << (props.type_size == sizeof(float) ? "f" : "");
+    } else if (type == "bool") {
+        literal << (bits[0] ? "true" : "false");
+    } else if (type.compare(0, 8, "unsigned") == 0) {
+        uint64_t value = 0;
+        memcpy(&value, bits, props.type_size);  // Little endian
+        literal << "static_cast<" << type << ">(" << value << "ull)";
+    } else {
+        uint64_t raw = 0;
+        memcpy(&raw, bits, props.type_size);  // Little endian
+        // Sign extend
+        const unsigned int shift = static_cast<unsigned int>(64 - 8 * props.type_size);
+        const int64_t value = static_cast<int64_t>(raw << shift) >> shift;
+        // The most negative value has no literal, as the literal is negated after it is parsed
+        if (value == std::numeric_limits<int64_t>::min()) {
+            literal << "static_cast<" << type << ">(-" << std::numeric_limits<int64_t>::max() << "ll - 1)";
+        } else {
+            literal << "static_cast<" << type << ">(" << value << "ll)";
+        }
+    }
+    return literal.str();
+}
+
+std::string CurveRTCHost::getFoldedEnvValue(const std::string &symbol, const RTCEnvVariableProperties &props) {
+    std::stringstream decl;
+    decl << "static constexpr __device__ " << getFoldedEnvType(props.type) << " " << symbol << "[" << props.elements << "] = {";
+    for (unsigned int i = 0; i < props.elements; ++i) {
+        decl << (i ? ", " : " ") << getFoldedEnvLiteral(props, i);
+    }
+    decl << " };\n";
+    return decl.str();
+}
+
 std::string CurveRTCHost::demangle(const char* verbose_name) {
 #ifndef _MSC_VER
     std::string s = jitify::reflection::detail::demangle_cuda_symbol(verbose_name);
@@ -62,7 +62,7 @@ void MessageArray::CUDAModelHandler::buildIndex(CUDAScatter &scatter, const unsi
     // Zero the output arrays
     auto &read_list = this->sim_message.getReadList();
     auto &write_list = this->sim_message.getWriteList();
-    for (auto &var : this->sim_message.getMessageDescription().variables) {
+    for (auto &var : this->sim_message.getReadVariables()) {
         // Elements is harmless, futureproof for arrays support
         // hd_metadata.length is used, as message array can be longer than message count
         gpuErrchk(cudaMemset(write_list.at(var.first), 0, var.second.type_size * var.second.elements * hd_metadata.length));
@@ -82,7 +82,7 @@ void MessageArray::CUDAModelHandler::buildIndex(CUDAScatter &scatter, const unsi
         }
         t_d_write_flag = d_write_flag;
     }
-    scatter.arrayMessageReorder(streamId, stream, this->sim_message.getMessageDescription().variables, read_list, write_list, MESSAGE_COUNT, hd_metadata.length, t_d_write_flag);
+    scatter.arrayMessageReorder(streamId, stream, this->sim_message.getReadVariables(), read_list, write_list, MESSAGE_COUNT, hd_metadata.length, t_d_write_flag);
     this->sim_message.swap();
     // Reset message count back to full array length
     // Array message exposes not output messages as 0
@@ -98,6 +98,7 @@ MessageArray::Data::Data(const std::shared_ptr<const ModelData>&model, const std
     , length(0) {
     description = std::unique_ptr<MessageArray::Description>(new MessageArray::Description(model, this));
     variables.emplace("___INDEX", Variable(1, size_type()));
+    index_variables.insert("___INDEX");
 }
 MessageArray::Data::Data(const std::shared_ptr<const ModelData>&model, const Data &other)
     : MessageBruteForce::Data(model, other)
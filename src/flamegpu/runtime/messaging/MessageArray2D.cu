@@ -18,8 +18,14 @@ MessageArray2D::CUDAModelHandler::CUDAModelHandler(CUDAMessage &a)
     , d_metadata(nullptr)
     , sim_message(a)
     , d_write_flag(nullptr)
-    , d_write_flag_len(0) {
+    , d_write_flag_len(0)
+    , d_keys(nullptr)
+    , d_vals(nullptr)
+    , d_permutation(nullptr)
+    , d_keys_vals_len(0)
+    , d_pbm(nullptr) {
     const Data& d = static_cast<const Data &>(a.getMessageDescription());
+    combined = d.isCombined();
     memcpy(&hd_metadata.dimensions, d.dimensions.data(), d.dimensions.size() * sizeof(unsigned int));
     hd_metadata.length = d.dimensions[0] * d.dimensions[1];
 }
@@ -57,13 +63,100 @@ void MessageArray2D::CUDAModelHandler::freeMetaDataDevicePtr() {
     }
     d_write_flag = nullptr;
     d_write_flag_len = 0;
+
+    if (d_keys) {
+        gpuErrchk(cudaFree(d_keys));
+        gpuErrchk(cudaFree(d_vals));
+        gpuErrchk(cudaFree(d_permutation));
+    }
+    d_keys = nullptr;
+    d_vals = nullptr;
+    d_permutation = nullptr;
+    d_keys_vals_len = 0;
+    if (d_pbm) {
+        gpuErrchk(cudaFree(d_pbm));
+    }
+    d_pbm = nullptr;
+}
+__global__ void arrayMessageCombineBin(
+    const unsigned int message_count,
+    const unsigned int length,
+    const MessageArray2D::size_type * __restrict__ index,
+    unsigned int *bin_index) {
+    unsigned int i = (blockIdx.x * blockDim.x) + threadIdx.x;
+    // Kill excess threads
+    if (i >= message_count) return;
+
+    // Messages with an out of bounds index, including empty elements which were previously combined, are placed in the final bin
+    bin_index[i] = index[i] < length ? index[i] : length;
+}
+__global__ void arrayMessageCombineMarkEmpty(
+    const unsigned int length,
+    const unsigned int * __restrict__ pbm,
+    MessageArray2D::size_type *index) {
+    unsigned int i = (blockIdx.x * blockDim.x) + threadIdx.x;
+    // Kill excess threads
+    if (i >= length) return;
+
+    // Empty elements are given an out of bounds index, so they are not combined again if further messages are appended
+    if (pbm[i + 1] == pbm[i])
+        index[i] = length;
+}
+void MessageArray2D::CUDAModelHandler::combine(CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream) {
+    const unsigned int MESSAGE_COUNT = this->sim_message.getMessageCount();
+    if (d_keys_vals_len < this->sim_message.getMaximumListSize()) {
+        // Resize based on allocated amount rather than message count
+        if (d_keys) {
+            gpuErrchk(cudaFree(d_keys));
+            gpuErrchk(cudaFree(d_vals));
+            gpuErrchk(cudaFree(d_permutation));
+        }
+        d_keys_vals_len = this->sim_message.getMaximumListSize();
+        gpuErrchk(cudaMalloc(&d_keys, sizeof(unsigned int) * d_keys_vals_len));
+        gpuErrchk(cudaMalloc(&d_vals, sizeof(unsigned int) * d_keys_vals_len));
+        gpuErrchk(cudaMalloc(&d_permutation, sizeof(unsigned int) * d_keys_vals_len));
+    }
+    if (!d_pbm) {
+        gpuErrchk(cudaMalloc(&d_pbm, sizeof(unsigned int) * (hd_metadata.length + 2)));
+    }
+    auto &read_list = this->sim_message.getReadList();
+    if (MESSAGE_COUNT) {
+        int blockSize = 0;  // The launch configurator returned block size
+        int minGridSize = 0;  // The minimum grid size needed to achieve the // maximum occupancy for a full device // launch
+        gpuErrchk(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, arrayMessageCombineBin, 0, MESSAGE_COUNT));
+        const int gridSize = (MESSAGE_COUNT + blockSize - 1) / blockSize;
+        arrayMessageCombineBin <<<gridSize, blockSize, 0, stream >>>(MESSAGE_COUNT, hd_metadata.length, static_cast<size_type*>(read_list.at("___INDEX")), d_keys);
+        gpuErrchkLaunch();
+    }
+    // Stable sort, so that messages are combined in the order they were output, regardless of scheduling
+    scatter.pbm_stable_sort(streamId, stream, MESSAGE_COUNT, hd_metadata.length + 1, d_keys, d_vals, d_pbm);
+    scatter.pbm_permutation(stream, MESSAGE_COUNT, d_keys, d_vals, d_pbm, d_permutation);
+    // Messages before the indexed message count were combined by the previous index build
+    const MessageBruteForce::Data &d = this->sim_message.getMessageDescription();
+    scatter.pbm_combine(streamId, stream, this->sim_message.getReadVariables(), d.combine_ops, read_list, this->sim_message.getWriteList(),
+        hd_metadata.length, d_pbm, d_permutation, nullptr, this->sim_message.getIndexedMessageCount());
+    this->sim_message.swap();
+    {
+        int blockSize = 0;  // The launch configurator returned block size
+        int minGridSize = 0;  // The minimum grid size needed to achieve the // maximum occupancy for a full device // launch
+        gpuErrchk(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, arrayMessageCombineMarkEmpty, 0, hd_metadata.length));
+        const int gridSize = (hd_metadata.length + blockSize - 1) / blockSize;
+        arrayMessageCombineMarkEmpty <<<gridSize, blockSize, 0, stream >>>(hd_metadata.length, d_pbm, static_cast<size_type*>(this->sim_message.getReadList().at("___INDEX")));
+        gpuErrchkLaunch();
+        gpuErrchk(cudaStreamSynchronize(stream));
+    }
+    this->sim_message.setMessageCount(hd_metadata.length);
 }
 void MessageArray2D::CUDAModelHandler::buildIndex(CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream) {
+    if (combined) {
+        combine(scatter, streamId, stream);
+        return;
+    }
     const unsigned int MESSAGE_COUNT = this->sim_message.getMessageCount();
     // Zero the output arrays
     auto &read_list = this->sim_message.getReadList();
     auto &write_list = this->sim_message.getWriteList();
-    for (auto &var : this->sim_message.getMessageDescription().variables) {
+    for (auto &var : this->sim_message.getReadVariables()) {
         // Elements is harmless, futureproof for arrays support
         // hd_metadata.length is used, as message array can be longer than message count
         gpuErrchk(cudaMemset(write_list.at(var.first), 0, var.second.type_size * var.second.elements * hd_metadata.length));
@@ -83,7 +176,7 @@ void MessageArray2D::CUDAModelHandler::buildIndex(CUDAScatter &scatter, const un
         }
         t_d_write_flag = d_write_flag;
     }
-    scatter.arrayMessageReorder(streamId, stream, this->sim_message.getMessageDescription().variables, read_list, write_list, MESSAGE_COUNT, hd_metadata.length, t_d_write_flag);
+    scatter.arrayMessageReorder(streamId, stream, this->sim_message.getReadVariables(), read_list, write_list, MESSAGE_COUNT, hd_metadata.length, t_d_write_flag);
     this->sim_message.swap();
     // Reset message count back to full array length
     // Array message exposes not output messages as 0
@@ -99,6 +192,7 @@ MessageArray2D::Data::Data(const std::shared_ptr<const ModelData> &model, const
     , dimensions({ 0, 0 }) {
     description = std::unique_ptr<MessageArray2D::Description>(new MessageArray2D::Description(model, this));
     variables.emplace("___INDEX", Variable(1, size_type()));
+    index_variables.insert("___INDEX");
 }
 MessageArray2D::Data::Data(const std::shared_ptr<const ModelData> &model, const Data &other)
     : MessageBruteForce::Data(model, other)
@@ -138,5 +232,11 @@ MessageArray2D::size_type MessageArray2D::Description::getDimX() const {
 MessageArray2D::size_type MessageArray2D::Description::getDimY() const {
     return reinterpret_cast<Data *>(message)->dimensions[1];
 }
+void MessageArray2D::Description::setCombine(const std::string &variable_name, const MessageCombine &op) {
+    setVariableCombine(variable_name, op);
+}
+MessageCombine MessageArray2D::Description::getCombine(const std::string &variable_name) const {
+    return getVariableCombine(variable_name);
+}
 
 }  // namespace flamegpu
@@ -63,7 +63,7 @@ void MessageArray3D::CUDAModelHandler::buildIndex(CUDAScatter &scatter, const un
     // Zero the output arrays
     auto &read_list = this->sim_message.getReadList();
     auto &write_list = this->sim_message.getWriteList();
-    for (auto &var : this->sim_message.getMessageDescription().variables) {
+    for (auto &var : this->sim_message.getReadVariables()) {
         // Elements is harmless, futureproof for arrays support
         // hd_metadata.length is used, as message array can be longer than message count
         gpuErrchk(cudaMemset(write_list.at(var.first), 0, var.second.type_size * var.second.elements * hd_metadata.length));
@@ -83,7 +83,7 @@ void MessageArray3D::CUDAModelHandler::buildIndex(CUDAScatter &scatter, const un
         }
         t_d_write_flag = d_write_flag;
     }
-    scatter.arrayMessageReorder(streamId, stream, this->sim_message.getMessageDescription().variables, read_list, write_list, MESSAGE_COUNT, hd_metadata.length, t_d_write_flag);
+    scatter.arrayMessageReorder(streamId, stream, this->sim_message.getReadVariables(), read_list, write_list, MESSAGE_COUNT, hd_metadata.length, t_d_write_flag);
     this->sim_message.swap();
     // Reset message count back to full array length
     // Array message exposes not output messages as 0
@@ -99,6 +99,7 @@ MessageArray3D::Data::Data(const std::shared_ptr<const ModelData> &model, const
     , dimensions({0, 0, 0}) {
     description = std::unique_ptr<MessageArray3D::Description>(new MessageArray3D::Description(model, this));
     variables.emplace("___INDEX", Variable(1, size_type()));
+    index_variables.insert("___INDEX");
 }
 MessageArray3D::Data::Data(const std::shared_ptr<const ModelData> &model, const Data &other)
     : MessageBruteForce::Data(model, other)
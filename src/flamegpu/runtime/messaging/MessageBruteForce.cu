@@ -1,3 +1,5 @@
+#include <cstring>
+
 #include "flamegpu/runtime/messaging/MessageBruteForce/MessageBruteForceHost.h"
 #include "flamegpu/runtime/messaging/MessageBruteForce/MessageBruteForceDevice.cuh"
 #include "flamegpu/model/AgentDescription.h"  // Used by Move-Assign
@@ -7,8 +9,8 @@ namespace flamegpu {
 
 void MessageBruteForce::CUDAModelHandler::init(CUDAScatter &, const unsigned int &) {
     allocateMetaDataDevicePtr();
-    // Allocate messages
-    hd_metadata.length = 0;  // This value should already be 0
+    // Allocate messages, padding is also zeroed so that metadata can be compared bytewise
+    memset(&hd_metadata, 0, sizeof(MetaData));
     gpuErrchk(cudaMemcpy(d_metadata, &hd_metadata, sizeof(MetaData), cudaMemcpyHostToDevice));
 }
 
@@ -26,9 +28,32 @@ void MessageBruteForce::CUDAModelHandler::freeMetaDataDevicePtr() {
 }
 
 void MessageBruteForce::CUDAModelHandler::buildIndex(CUDAScatter &, const unsigned int &, const cudaStream_t &) {
-    unsigned int newLength = this->sim_message.getMessageCount();
-    if (newLength != hd_metadata.length) {
-        hd_metadata.length = newLength;
+    MetaData newMetadata;
+    memset(&newMetadata, 0, sizeof(MetaData));
+    newMetadata.length = this->sim_message.getMessageCount();
+    if (newMetadata.length) {
+        // The read variables' buffers are swapped as messages are output, so the tile schedule is rebuilt alongside the length
+        const VariableMap &read_variables = this->sim_message.getReadVariables();
+        unsigned int message_bytes = 0;
+        if (read_variables.size() <= MAX_TILE_VARIABLES) {
+            for (const auto &v : read_variables) {
+                util::detail::tile::Variable &tv = newMetadata.tile_variables[newMetadata.tile_variable_count++];
+                tv.data = static_cast<const char *>(this->sim_message.getReadPtr(v.first));
+                tv.size = static_cast<unsigned int>(v.second.type_size * v.second.elements);
+                tv.hash = util::detail::tile::hash(v.first);
+                tv.offset = message_bytes;
+                message_bytes += tv.size;
+            }
+        }
+        newMetadata.tile_length = util::detail::tile::length(TILE_BYTES, message_bytes);
+        if (!newMetadata.tile_length) {
+            // Too many or too large variables, tiled iteration falls back to reading global memory
+            memset(&newMetadata, 0, sizeof(MetaData));
+            newMetadata.length = this->sim_message.getMessageCount();
+        }
+    }
+    if (memcmp(&newMetadata, &hd_metadata, sizeof(MetaData)) != 0) {
+        hd_metadata = newMetadata;
         gpuErrchk(cudaMemcpy(d_metadata, &hd_metadata, sizeof(MetaData), cudaMemcpyHostToDevice));
     }
 }
@@ -36,13 +61,19 @@ void MessageBruteForce::CUDAModelHandler::buildIndex(CUDAScatter &, const unsign
 MessageBruteForce::Data::Data(const std::shared_ptr<const ModelData> &model, const std::string &message_name)
     : description(new Description(model, this))
     , name(message_name)
+    , capacity_hint(0)
     , optional_outputs(0) { }
 MessageBruteForce::Data::~Data() {}
 MessageBruteForce::Data::Data(const std::shared_ptr<const ModelData> &model, const MessageBruteForce::Data &other)
     : variables(other.variables)
+    , index_variables(other.index_variables)
+    , combine_ops(other.combine_ops)
     , description(model ? new Description(model, this) : nullptr)
     , name(other.name)
-    , optional_outputs(other.optional_outputs) { }
+    , capacity_hint(other.capacity_hint)
+    , optional_outputs(other.optional_outputs)
+    , view_agent(other.view_agent)
+    , view_state(other.view_state) { }
 MessageBruteForce::Data *MessageBruteForce::Data::clone(const std::shared_ptr<const ModelData> &newParent) {
     return new MessageBruteForce::Data(newParent, *this);
 }
@@ -50,6 +81,10 @@ bool MessageBruteForce::Data::operator==(const MessageBruteForce::Data& rhs) con
     if (this == &rhs)  // They point to same object
         return true;
     if (name == rhs.name
+        && view_agent == rhs.view_agent
+        && view_state == rhs.view_state
+        && capacity_hint == rhs.capacity_hint
+        && combine_ops == rhs.combine_ops
         && variables.size() == rhs.variables.size()) {
             {  // Compare variables
                 for (auto &v : variables) {
@@ -124,5 +159,42 @@ ModelData::size_type MessageBruteForce::Description::getVariablesCount() const {
 bool MessageBruteForce::Description::hasVariable(const std::string &variable_name) const {
     return message->variables.find(variable_name) != message->variables.end();
 }
+void MessageBruteForce::Description::setCapacityHint(const unsigned int &capacity) {
+    message->capacity_hint = capacity;
+}
+unsigned int MessageBruteForce::Description::getCapacityHint() const {
+    return message->capacity_hint;
+}
+
+void MessageBruteForce::Description::setVariableCombine(const std::string &variable_name, const MessageCombine &op) {
+    auto f = message->variables.find(variable_name);
+    if (f == message->variables.end() || variable_name[0] == '_') {
+        THROW exception::InvalidMessageVar("Message ('%s') does not contain variable '%s', "
+            "in MessageDescription::setCombine().",
+            message->name.c_str(), variable_name.c_str());
+    }
+    if (op == MessageCombine::None) {
+        message->combine_ops.erase(variable_name);
+        return;
+    }
+    const std::type_index &t = f->second.type;
+    if (t != std::type_index(typeid(int32_t)) && t != std::type_index(typeid(uint32_t))
+        && t != std::type_index(typeid(int64_t)) && t != std::type_index(typeid(uint64_t))
+        && t != std::type_index(typeid(float)) && t != std::type_index(typeid(double))) {
+        THROW exception::InvalidArgument("Message ('%s') variable '%s' has type '%s', only int32_t, uint32_t, int64_t, uint64_t, float and double variables can be combined, "
+            "in MessageDescription::setCombine().",
+            message->name.c_str(), variable_name.c_str(), t.name());
+    }
+    message->combine_ops[variable_name] = op;
+}
+MessageCombine MessageBruteForce::Description::getVariableCombine(const std::string &variable_name) const {
+    if (message->variables.find(variable_name) == message->variables.end()) {
+        THROW exception::InvalidMessageVar("Message ('%s') does not contain variable '%s', "
+            "in MessageDescription::getCombine().",
+            message->name.c_str(), variable_name.c_str());
+    }
+    auto f = message->combine_ops.find(variable_name);
+    return f != message->combine_ops.end() ? f->second : MessageCombine::None;
+}
 
 }  // namespace flamegpu
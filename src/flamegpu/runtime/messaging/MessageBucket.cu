@@ -28,6 +28,8 @@ MessageBucket::CUDAModelHandler::CUDAModelHandler(CUDAMessage &a)
     // Here we convert it so that upperBound is one greater than the final valid index
     hd_data.max = d.upperBound + 1;
     bucketCount = d.upperBound - d.lowerBound  + 1;
+    deterministic = d.deterministic;
+    combined = d.isCombined();
 }
 MessageBucket::CUDAModelHandler::~CUDAModelHandler() { }
 
@@ -44,8 +46,22 @@ __global__ void atomicHistogram1D(
 
     const unsigned int hash = key[index] - md->min;
     bin_index[index] = hash;
-    unsigned int bin_idx = atomicInc((unsigned int*)&pbm_counts[hash], 0xFFFFFFFF);
-    bin_sub_index[index] = bin_idx;
+    // pbm_counts is not provided when the index is built deterministically, the sub index is then found by sorting
+    if (pbm_counts) {
+        unsigned int bin_idx = atomicInc((unsigned int*)&pbm_counts[hash], 0xFFFFFFFF);
+        bin_sub_index[index] = bin_idx;
+    }
+}
+
+__global__ void bucketNonEmpty(
+    const unsigned int bucket_count,
+    const unsigned int * __restrict__ pbm,
+    unsigned int *flags) {
+    unsigned int index = (blockIdx.x * blockDim.x) + threadIdx.x;
+    // Kill excess threads, the final flag is always 0 so that the scan produces the total
+    if (index > bucket_count) return;
+
+    flags[index] = index < bucket_count && pbm[index + 1] > pbm[index] ? 1 : 0;
 }
 
 void MessageBucket::CUDAModelHandler::init(CUDAScatter &, const unsigned int &) {
@@ -58,6 +74,9 @@ void MessageBucket::CUDAModelHandler::allocateMetaDataDevicePtr() {
     if (d_data == nullptr) {
         gpuErrchk(cudaMalloc(&d_histogram, (bucketCount + 1) * sizeof(unsigned int)));
         gpuErrchk(cudaMalloc(&hd_data.PBM, (bucketCount + 1) * sizeof(unsigned int)));
+        if (combined) {
+            gpuErrchk(cudaMalloc(&d_combined_pbm, (bucketCount + 1) * sizeof(unsigned int)));
+        }
         gpuErrchk(cudaMalloc(&d_data, sizeof(MetaData)));
         gpuErrchk(cudaMemcpy(d_data, &hd_data, sizeof(MetaData), cudaMemcpyHostToDevice));
         resizeCubTemp();
@@ -75,6 +94,10 @@ void MessageBucket::CUDAModelHandler::freeMetaDataDevicePtr() {
         d_histogram = nullptr;
         hd_data.PBM = nullptr;
         d_data = nullptr;
+        if (d_combined_pbm) {
+            gpuErrchk(cudaFree(d_combined_pbm));
+            d_combined_pbm = nullptr;
+        }
         if (d_keys) {
             d_keys_vals_storage_bytes = 0;
             gpuErrchk(cudaFree(d_keys));
@@ -82,6 +105,10 @@ void MessageBucket::CUDAModelHandler::freeMetaDataDevicePtr() {
             d_keys = nullptr;
             d_vals = nullptr;
         }
+        if (d_permutation) {
+            gpuErrchk(cudaFree(d_permutation));
+            d_permutation = nullptr;
+        }
     }
 }
 
@@ -91,20 +118,46 @@ void MessageBucket::CUDAModelHandler::buildIndex(CUDAScatter &scatter, const uns
     const unsigned int MESSAGE_COUNT = this->sim_message.getMessageCount();
     resizeKeysVals(this->sim_message.getMaximumListSize());  // Resize based on allocated amount rather than message count
     {  // Build atomic histogram
-        gpuErrchk(cudaMemsetAsync(d_histogram, 0x00000000, (bucketCount + 1) * sizeof(unsigned int), stream));
+        if (!deterministic) {
+            gpuErrchk(cudaMemsetAsync(d_histogram, 0x00000000, (bucketCount + 1) * sizeof(unsigned int), stream));
+        }
         int blockSize;  // The launch configurator returned block size
         gpuErrchk(cudaOccupancyMaxActiveBlocksPerMultiprocessor(&blockSize, atomicHistogram1D, 32, 0));  // Randomly 32
                                                                                                          // Round up according to array size
         int gridSize = (MESSAGE_COUNT + blockSize - 1) / blockSize;
-        atomicHistogram1D <<<gridSize, blockSize, 0, stream >>>(d_data, d_keys, d_vals, d_histogram, MESSAGE_COUNT,
+        atomicHistogram1D <<<gridSize, blockSize, 0, stream >>>(d_data, d_keys, d_vals, deterministic ? nullptr : d_histogram, MESSAGE_COUNT,
             reinterpret_cast<IntT*>(this->sim_message.getReadPtr("_key")));
     }
-    {  // Scan (sum), to finalise PBM
+    if (deterministic) {  // Stable sort by bin, to build the sub index and PBM without atomics
+        scatter.pbm_stable_sort(streamId, stream, MESSAGE_COUNT, bucketCount, d_keys, d_vals, hd_data.PBM);
+    } else {  // Scan (sum), to finalise PBM
         gpuErrchk(cub::DeviceScan::ExclusiveSum(d_CUB_temp_storage, d_CUB_temp_storage_bytes, d_histogram, hd_data.PBM, bucketCount + 1, stream));
     }
-    {  // Reorder messages
+    if (combined) {  // Combine messages
+        // Messages are not reordered, instead the messages within each bucket are reduced in bucket order
+        scatter.pbm_permutation(stream, MESSAGE_COUNT, d_keys, d_vals, hd_data.PBM, d_permutation);
+        // Each bucket's combined message is output to the index of the bucket amongst non-empty buckets
+        int blockSize = 0;  // The launch configurator returned block size
+        int minGridSize = 0;  // The minimum grid size needed to achieve the // maximum occupancy for a full device // launch
+        gpuErrchk(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, bucketNonEmpty, 0, bucketCount + 1));
+        const int gridSize = (bucketCount + 1 + blockSize - 1) / blockSize;
+        bucketNonEmpty <<<gridSize, blockSize, 0, stream >>>(bucketCount, hd_data.PBM, d_histogram);
+        gpuErrchkLaunch();
+        gpuErrchk(cub::DeviceScan::ExclusiveSum(d_CUB_temp_storage, d_CUB_temp_storage_bytes, d_histogram, d_combined_pbm, bucketCount + 1, stream));
+        // Messages before the indexed message count were combined by the previous index build
+        const MessageBruteForce::Data &d = this->sim_message.getMessageDescription();
+        scatter.pbm_combine(streamId, stream, this->sim_message.getReadVariables(), d.combine_ops, this->sim_message.getReadList(), this->sim_message.getWriteList(),
+            bucketCount, hd_data.PBM, d_permutation, d_combined_pbm, this->sim_message.getIndexedMessageCount());
+        this->sim_message.swap();
+        // The PBM of combined messages replaces the PBM, so the device metadata is unchanged
+        gpuErrchk(cudaMemcpyAsync(hd_data.PBM, d_combined_pbm, (bucketCount + 1) * sizeof(unsigned int), cudaMemcpyDeviceToDevice, stream));
+        unsigned int combined_count = 0;
+        gpuErrchk(cudaMemcpyAsync(&combined_count, d_combined_pbm + bucketCount, sizeof(unsigned int), cudaMemcpyDeviceToHost, stream));
+        gpuErrchk(cudaStreamSynchronize(stream));
+        this->sim_message.setMessageCount(combined_count);
+    } else {  // Reorder messages
        // Copy messages from d_messages to d_messages_swap, in hash order
-        scatter.pbm_reorder(streamId, stream, this->sim_message.getMessageDescription().variables, this->sim_message.getReadList(), this->sim_message.getWriteList(), MESSAGE_COUNT, d_keys, d_vals, hd_data.PBM);
+        scatter.pbm_reorder(streamId, stream, this->sim_message.getReadVariables(), this->sim_message.getReadList(), this->sim_message.getWriteList(), MESSAGE_COUNT, d_keys, d_vals, hd_data.PBM);
         this->sim_message.swap();
         gpuErrchk(cudaStreamSynchronize(stream));  // Not striclty neceesary while pbm_reorder is synchronous.
     }
@@ -136,6 +189,12 @@ void MessageBucket::CUDAModelHandler::resizeKeysVals(const unsigned int &newSize
         d_keys_vals_storage_bytes = bytesCheck;
         gpuErrchk(cudaMalloc(&d_keys, d_keys_vals_storage_bytes));
         gpuErrchk(cudaMalloc(&d_vals, d_keys_vals_storage_bytes));
+        if (combined) {
+            if (d_permutation) {
+                gpuErrchk(cudaFree(d_permutation));
+            }
+            gpuErrchk(cudaMalloc(&d_permutation, d_keys_vals_storage_bytes));
+        }
     }
 }
 
@@ -143,14 +202,17 @@ void MessageBucket::CUDAModelHandler::resizeKeysVals(const unsigned int &newSize
 MessageBucket::Data::Data(const std::shared_ptr<const ModelData> &model, const std::string &message_name)
     : MessageBruteForce::Data(model, message_name)
     , lowerBound(0)
-    , upperBound(std::numeric_limits<IntT>::max()) {
+    , upperBound(std::numeric_limits<IntT>::max())
+    , deterministic(false) {
     description = std::unique_ptr<MessageBucket::Description>(new MessageBucket::Description(model, this));
     variables.emplace("_key", Variable(1, static_cast<IntT>(0)));
+    index_variables.insert("_key");
 }
 MessageBucket::Data::Data(const std::shared_ptr<const ModelData> &model, const Data &other)
     : MessageBruteForce::Data(model, other)
     , lowerBound(other.lowerBound)
-    , upperBound(other.upperBound) {
+    , upperBound(other.upperBound)
+    , deterministic(other.deterministic) {
     description = std::unique_ptr<MessageBucket::Description>(model ? new MessageBucket::Description(model, this) : nullptr);
     if (lowerBound == std::numeric_limits<IntT>::max()) {
         THROW exception::InvalidMessage("Minimum bound has not been set for bucket message '%s.", other.name.c_str());
@@ -191,6 +253,12 @@ void MessageBucket::Description::setBounds(const IntT &min, const IntT &max) {
     reinterpret_cast<Data *>(message)->lowerBound = min;
     reinterpret_cast<Data *>(message)->upperBound = max;
 }
+void MessageBucket::Description::setDeterministic(const bool &deterministic) {
+    reinterpret_cast<Data *>(message)->deterministic = deterministic;
+}
+void MessageBucket::Description::setCombine(const std::string &variable_name, const MessageCombine &op) {
+    setVariableCombine(variable_name, op);
+}
 
 IntT MessageBucket::Description::getLowerBound() const {
     return reinterpret_cast<Data *>(message)->lowerBound;
@@ -198,5 +266,11 @@ IntT MessageBucket::Description::getLowerBound() const {
 IntT MessageBucket::Description::getUpperBound() const {
     return reinterpret_cast<Data *>(message)->upperBound;
 }
+bool MessageBucket::Description::getDeterministic() const {
+    return reinterpret_cast<Data *>(message)->deterministic;
+}
+MessageCombine MessageBucket::Description::getCombine(const std::string &variable_name) const {
+    return getVariableCombine(variable_name);
+}
 
 }  // namespace flamegpu
@@ -0,0 +1,193 @@
+#include "flamegpu/runtime/messaging/MessageGraph/MessageGraphHost.h"
+#include "flamegpu/runtime/messaging/MessageGraph/MessageGraphDevice.cuh"
+
+namespace flamegpu {
+
+MessageGraph::CUDAModelHandler::CUDAModelHandler(CUDAMessage &a)
+    : MessageSpecialisationHandler()
+    , array(a) {
+    const Data &d = static_cast<const Data &>(a.getMessageDescription());
+    topology = d.topology;
+    hd_data.array.length = d.length;
+    hd_data.offsets = nullptr;
+    hd_data.degrees = nullptr;
+    hd_data.edges = nullptr;
+}
+
+void MessageGraph::CUDAModelHandler::init(CUDAScatter &scatter, const unsigned int &streamId) {
+    array.init(scatter, streamId);
+    allocateMetaDataDevicePtr();
+}
+void MessageGraph::CUDAModelHandler::buildIndex(CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream) {
+    array.buildIndex(scatter, streamId, stream);
+}
+void MessageGraph::CUDAModelHandler::allocateMetaDataDevicePtr() {
+    array.allocateMetaDataDevicePtr();
+    if (d_data == nullptr) {
+        gpuErrchk(cudaMalloc(&hd_data.offsets, topology.getOffsets().size() * sizeof(unsigned int)));
+        gpuErrchk(cudaMalloc(&hd_data.degrees, topology.getDegrees().size() * sizeof(unsigned int)));
+        gpuErrchk(cudaMalloc(&d_data, sizeof(MetaData)));
+        // Force a full upload, which allocates the edges
+        d_edges_len = 0;
+        uploadTopology();
+    }
+}
+void MessageGraph::CUDAModelHandler::freeMetaDataDevicePtr() {
+    array.freeMetaDataDevicePtr();
+    if (d_data != nullptr) {
+        gpuErrchk(cudaFree(const_cast<unsigned int *>(hd_data.offsets)));
+        gpuErrchk(cudaFree(const_cast<unsigned int *>(hd_data.degrees)));
+        if (hd_data.edges) {
+            gpuErrchk(cudaFree(const_cast<unsigned int *>(hd_data.edges)));
+        }
+        gpuErrchk(cudaFree(d_data));
+        hd_data.offsets = nullptr;
+        hd_data.degrees = nullptr;
+        hd_data.edges = nullptr;
+        d_edges_len = 0;
+        d_data = nullptr;
+    }
+}
+void MessageGraph::CUDAModelHandler::uploadTopology() {
+    if (d_data == nullptr)
+        return;
+    const std::vector<unsigned int> &offsets = topology.getOffsets();
+    const std::vector<unsigned int> &degrees = topology.getDegrees();
+    const std::vector<unsigned int> &edges = topology.getEdges();
+    if (topology.getLayoutChanged() || d_edges_len == 0) {
+        // Offsets have moved, so the full topology is uploaded
+        if (edges.size() > d_edges_len) {
+            if (hd_data.edges) {
+                gpuErrchk(cudaFree(const_cast<unsigned int *>(hd_data.edges)));
+            }
+            unsigned int *t_edges = nullptr;
+            gpuErrchk(cudaMalloc(&t_edges, edges.size() * sizeof(unsigned int)));
+            hd_data.edges = t_edges;
+            d_edges_len = edges.size();
+            gpuErrchk(cudaMemcpy(d_data, &hd_data, sizeof(MetaData), cudaMemcpyHostToDevice));
+        }
+        gpuErrchk(cudaMemcpy(const_cast<unsigned int *>(hd_data.offsets), offsets.data(), offsets.size() * sizeof(unsigned int), cudaMemcpyHostToDevice));
+        gpuErrchk(cudaMemcpy(const_cast<unsigned int *>(hd_data.degrees), degrees.data(), degrees.size() * sizeof(unsigned int), cudaMemcpyHostToDevice));
+        gpuErrchk(cudaMemcpy(const_cast<unsigned int *>(hd_data.edges), edges.data(), edges.size() * sizeof(unsigned int), cudaMemcpyHostToDevice));
+    } else {
+        // Only the degrees and edge slots of edited vertices have changed
+        for (const auto &range : topology.getDirtyRanges()) {
+            gpuErrchk(cudaMemcpy(const_cast<unsigned int *>(hd_data.degrees) + range.first, degrees.data() + range.first,
+                (range.second - range.first) * sizeof(unsigned int), cudaMemcpyHostToDevice));
+            const unsigned int slot_begin = offsets[range.first];
+            const unsigned int slot_end = offsets[range.second];
+            gpuErrchk(cudaMemcpy(const_cast<unsigned int *>(hd_data.edges) + slot_begin, edges.data() + slot_begin,
+                (slot_end - slot_begin) * sizeof(unsigned int), cudaMemcpyHostToDevice));
+        }
+    }
+    topology.clearDirty();
+}
+
+MessageGraph::Topology::Topology(CUDAModelHandler &_handler)
+    : handler(_handler) { }
+MessageGraph::size_type MessageGraph::Topology::getVertexCount() const {
+    return handler.getTopology().getVertexCount();
+}
+MessageGraph::size_type MessageGraph::Topology::getEdgeCount() const {
+    return handler.getTopology().getEdgeCount();
+}
+MessageGraph::size_type MessageGraph::Topology::getDegree(const size_type &vertex) const {
+    validate({ vertex }, { vertex });
+    return handler.getTopology().getDegree(vertex);
+}
+std::vector<MessageGraph::size_type> MessageGraph::Topology::getNeighbours(const size_type &vertex) const {
+    validate({ vertex }, { vertex });
+    return handler.getTopology().getNeighbours(vertex);
+}
+bool MessageGraph::Topology::addEdge(const size_type &source, const size_type &destination) {
+    return addEdges({ source }, { destination }) != 0;
+}
+MessageGraph::size_type MessageGraph::Topology::addEdges(const std::vector<size_type> &sources, const std::vector<size_type> &destinations) {
+    validate(sources, destinations);
+    size_type added = 0;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (handler.getTopology().addEdge(sources[i], destinations[i]))
+            ++added;
+    }
+    handler.uploadTopology();
+    return added;
+}
+bool MessageGraph::Topology::removeEdge(const size_type &source, const size_type &destination) {
+    return removeEdges({ source }, { destination }) != 0;
+}
+MessageGraph::size_type MessageGraph::Topology::removeEdges(const std::vector<size_type> &sources, const std::vector<size_type> &destinations) {
+    validate(sources, destinations);
+    size_type removed = 0;
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (handler.getTopology().removeEdge(sources[i], destinations[i]))
+            ++removed;
+    }
+    handler.uploadTopology();
+    return removed;
+}
+void MessageGraph::Topology::validate(const std::vector<size_type> &sources, const std::vector<size_type> &destinations) const {
+    if (sources.size() != destinations.size()) {
+        THROW exception::InvalidArgument("Graph edge lists differ in length (%u != %u), in MessageGraph::Topology.\n",
+            static_cast<unsigned int>(sources.size()), static_cast<unsigned int>(destinations.size()));
+    }
+    const size_type vertex_count = handler.getTopology().getVertexCount();
+    for (size_t i = 0; i < sources.size(); ++i) {
+        if (sources[i] >= vertex_count || destinations[i] >= vertex_count) {
+            THROW exception::OutOfBoundsException("Graph edge (%u, %u) exceeds the vertex count (%u), in MessageGraph::Topology.\n",
+                sources[i], destinations[i], vertex_count);
+        }
+    }
+}
+
+MessageGraph::Data::Data(const std::shared_ptr<const ModelData> &model, const std::string &message_name)
+    : MessageArray::Data(model, message_name) {
+    description = std::unique_ptr<Description>(new Description(model, this));
+}
+MessageGraph::Data::Data(const std::shared_ptr<const ModelData> &model, const Data &other)
+    : MessageArray::Data(model, other)
+    , topology(other.topology) {
+    description = std::unique_ptr<Description>(model ? new Description(model, this) : nullptr);
+}
+MessageGraph::Data *MessageGraph::Data::clone(const std::shared_ptr<const ModelData> &newParent) {
+    return new Data(newParent, *this);
+}
+std::unique_ptr<MessageSpecialisationHandler> MessageGraph::Data::getSpecialisationHander(CUDAMessage &owner) const {
+    return std::unique_ptr<MessageSpecialisationHandler>(new CUDAModelHandler(owner));
+}
+std::type_index MessageGraph::Data::getType() const { return std::type_index(typeid(MessageGraph)); }
+
+MessageGraph::Description::Description(const std::shared_ptr<const ModelData> &_model, Data *const data)
+    : MessageBruteForce::Description(_model, data) { }
+
+void MessageGraph::Description::setVertexCount(const size_type &count) {
+    if (count == 0) {
+        THROW exception::InvalidArgument("Graph messaging vertex count must not be zero.\n");
+    }
+    Data *d = reinterpret_cast<Data *>(message);
+    d->length = count;
+    d->topology.reset(count);
+}
+bool MessageGraph::Description::addEdge(const size_type &source, const size_type &destination) {
+    Data *d = reinterpret_cast<Data *>(message);
+    if (source >= d->length || destination >= d->length) {
+        THROW exception::OutOfBoundsException("Graph edge (%u, %u) exceeds the vertex count (%u), in MessageGraph::Description::addEdge().\n",
+            source, destination, d->length);
+    }
+    return d->topology.addEdge(source, destination);
+}
+MessageGraph::size_type MessageGraph::Description::getVertexCount() const {
+    return reinterpret_cast<Data *>(message)->length;
+}
+MessageGraph::size_type MessageGraph::Description::getEdgeCount() const {
+    return reinterpret_cast<Data *>(message)->topology.getEdgeCount();
+}
+std::vector<MessageGraph::size_type> MessageGraph::Description::getNeighbours(const size_type &vertex) const {
+    const Data *d = reinterpret_cast<Data *>(message);
+    if (vertex >= d->length) {
+        THROW exception::OutOfBoundsException("Graph vertex (%u) exceeds the vertex count (%u), in MessageGraph::Description::getNeighbours().\n",
+            vertex, d->length);
+    }
+    return d->topology.getNeighbours(vertex);
+}
+
+}  // namespace flamegpu
@@ -0,0 +1,98 @@
+#include "flamegpu/runtime/messaging/MessageKNN/MessageKNNHost.h"
+#include "flamegpu/runtime/messaging/MessageKNN/MessageKNNDevice.cuh"
+
+namespace flamegpu {
+
+constexpr unsigned int MessageKNN::MAX_K;
+
+MessageKNN::CUDAModelHandler::CUDAModelHandler(CUDAMessage &a)
+  : MessageSpecialisationHandler()
+  , spatial(a) {
+    NVTX_RANGE("KNN::CUDAModelHandler");
+    const Data &d = (const Data &)a.getMessageDescription();
+    hd_data.k = d.k;
+    hd_data.maxRadius = d.maxRadius;
+    // Device allocation occurs in allocateMetaDataDevicePtr rather than the constructor.
+}
+
+void MessageKNN::CUDAModelHandler::init(CUDAScatter &scatter, const unsigned int &streamId) {
+    spatial.init(scatter, streamId);
+    allocateMetaDataDevicePtr();
+    updateMetaData();
+}
+
+void MessageKNN::CUDAModelHandler::buildIndex(CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream) {
+    spatial.buildIndex(scatter, streamId, stream);
+    // Building the index may reallocate buffers referenced by the spatial metadata
+    updateMetaData();
+}
+
+void MessageKNN::CUDAModelHandler::allocateMetaDataDevicePtr() {
+    spatial.allocateMetaDataDevicePtr();
+    if (d_data == nullptr) {
+        gpuErrchk(cudaMalloc(&d_data, sizeof(MetaData)));
+        gpuErrchk(cudaMemcpy(d_data, &hd_data, sizeof(MetaData), cudaMemcpyHostToDevice));
+        updateMetaData();
+    }
+}
+
+void MessageKNN::CUDAModelHandler::freeMetaDataDevicePtr() {
+    spatial.freeMetaDataDevicePtr();
+    if (d_data != nullptr) {
+        gpuErrchk(cudaFree(d_data));
+        d_data = nullptr;
+    }
+}
+
+void MessageKNN::CUDAModelHandler::updateMetaData() {
+    gpuErrchk(cudaMemcpy(&d_data->spatial, spatial.getMetaDataDevicePtr(), sizeof(MessageSpatial3D::MetaData), cudaMemcpyDeviceToDevice));
+}
+
+MessageKNN::Data::Data(const std::shared_ptr<const ModelData> &model, const std::string &message_name)
+    : MessageSpatial3D::Data(model, message_name)
+    , k(1)
+    , maxRadius(NAN) {
+    description = std::unique_ptr<Description>(new Description(model, this));
+}
+MessageKNN::Data::Data(const std::shared_ptr<const ModelData> &model, const Data &other)
+    : MessageSpatial3D::Data(model, other)
+    , k(other.k)
+    , maxRadius(isnan(other.maxRadius) ? other.radius : other.maxRadius) {
+    description = std::unique_ptr<Description>(model ? new Description(model, this) : nullptr);
+    if (periodic) {
+        THROW exception::InvalidMessage("K-nearest-neighbour message '%s' does not support periodic environment bounds.", other.name.c_str());
+    }
+}
+MessageKNN::Data *MessageKNN::Data::clone(const std::shared_ptr<const ModelData> &newParent) {
+    return new Data(newParent, *this);
+}
+std::unique_ptr<MessageSpecialisationHandler> MessageKNN::Data::getSpecialisationHander(CUDAMessage &owner) const {
+    return std::unique_ptr<MessageSpecialisationHandler>(new CUDAModelHandler(owner));
+}
+std::type_index MessageKNN::Data::getType() const { return std::type_index(typeid(MessageKNN)); }
+
+MessageKNN::Description::Description(const std::shared_ptr<const ModelData> &_model, Data *const data)
+    : MessageSpatial3D::Description(_model, data) { }
+
+void MessageKNN::Description::setK(const unsigned int &k) {
+    if (k == 0 || k > MAX_K) {
+        THROW exception::InvalidArgument("K-nearest-neighbour messaging k must be in the range [1, %u], %u is not valid.", MAX_K, k);
+    }
+    reinterpret_cast<Data *>(message)->k = k;
+}
+void MessageKNN::Description::setMaxRadius(const float &r) {
+    if (r <= 0) {
+        THROW exception::InvalidArgument("K-nearest-neighbour messaging max radius must be a positive value, %f is not valid.", r);
+    }
+    reinterpret_cast<Data *>(message)->maxRadius = r;
+}
+
+unsigned int MessageKNN::Description::getK() const {
+    return reinterpret_cast<Data *>(message)->k;
+}
+float MessageKNN::Description::getMaxRadius() const {
+    const Data *d = reinterpret_cast<Data *>(message);
+    return isnan(d->maxRadius) ? d->radius : d->maxRadius;
+}
+
+}  // namespace flamegpu
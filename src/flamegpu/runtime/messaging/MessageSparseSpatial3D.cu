@@ -0,0 +1,209 @@
+#include "flamegpu/runtime/messaging/MessageSparseSpatial3D/MessageSparseSpatial3DHost.h"
+#include "flamegpu/runtime/messaging/MessageSparseSpatial3D/MessageSparseSpatial3DDevice.cuh"
+
+#include "flamegpu/gpu/CUDAScatter.cuh"
+#ifdef _MSC_VER
+#pragma warning(push, 1)
+#pragma warning(disable : 4706 4834)
+#include <cub/cub.cuh>
+#pragma warning(pop)
+#else
+#include <cub/cub.cuh>
+#endif
+
+
+namespace flamegpu {
+
+
+MessageSparseSpatial3D::CUDAModelHandler::CUDAModelHandler(CUDAMessage &a)
+  : MessageSpecialisationHandler()
+  , sim_message(a) {
+    NVTX_RANGE("SparseSpatial3D::CUDAModelHandler");
+    const Data &d = (const Data &)a.getMessageDescription();
+    hd_data.radius = d.radius;
+    hd_data.keys = nullptr;
+    hd_data.PBM = nullptr;
+    hd_data.tableSize = 0;
+    // Device allocation occurs in allocateMetaDataDevicePtr rather than the constructor.
+}
+
+__global__ void atomicHashHistogram3D(
+    const MessageSparseSpatial3D::MetaData *md,
+    unsigned int* bin_index,
+    unsigned int* bin_sub_index,
+    unsigned int *pbm_counts,
+    unsigned int message_count,
+    const float * __restrict__ x,
+    const float * __restrict__ y,
+    const float * __restrict__ z) {
+    unsigned int index = (blockIdx.x * blockDim.x) + threadIdx.x;
+    // Kill excess threads
+    if (index >= message_count) return;
+
+    const unsigned long long key = util::detail::spatial_hash::cellKey(
+        util::detail::spatial_hash::cellCoord(x[index], md->radius),
+        util::detail::spatial_hash::cellCoord(y[index], md->radius),
+        util::detail::spatial_hash::cellCoord(z[index], md->radius));
+    // Claim a slot for the cell, using the same probe sequence as spatial_hash::insert()
+    // The table holds at least twice as many slots as messages, so this always terminates
+    unsigned int slot = util::detail::spatial_hash::firstSlot(key, md->tableSize);
+    while (true) {
+        const unsigned long long prev = atomicCAS(&md->keys[slot], util::detail::spatial_hash::EMPTY_KEY, key);
+        if (prev == util::detail::spatial_hash::EMPTY_KEY || prev == key)
+            break;
+        slot = (slot + 1) & (md->tableSize - 1);
+    }
+    bin_index[index] = slot;
+    unsigned int bin_idx = atomicInc((unsigned int*)&pbm_counts[slot], 0xFFFFFFFF);
+    bin_sub_index[index] = bin_idx;
+}
+
+void MessageSparseSpatial3D::CUDAModelHandler::init(CUDAScatter &, const unsigned int &) {
+    allocateMetaDataDevicePtr();
+    // Set table to empty and PBM to 0
+    gpuErrchk(cudaMemset(hd_data.keys, 0xff, hd_data.tableSize * sizeof(unsigned long long)));
+    gpuErrchk(cudaMemset(hd_data.PBM, 0x00000000, (hd_data.tableSize + 1) * sizeof(unsigned int)));
+}
+
+void MessageSparseSpatial3D::CUDAModelHandler::allocateMetaDataDevicePtr() {
+    if (d_data == nullptr) {
+        gpuErrchk(cudaMalloc(&d_data, sizeof(MetaData)));
+        resizeTable(this->sim_message.getMaximumListSize());
+        gpuErrchk(cudaMemcpy(d_data, &hd_data, sizeof(MetaData), cudaMemcpyHostToDevice));
+    }
+}
+
+void MessageSparseSpatial3D::CUDAModelHandler::freeMetaDataDevicePtr() {
+    if (d_data != nullptr) {
+        d_CUB_temp_storage_bytes = 0;
+        gpuErrchk(cudaFree(d_CUB_temp_storage));
+        gpuErrchk(cudaFree(d_histogram));
+        gpuErrchk(cudaFree(hd_data.keys));
+        gpuErrchk(cudaFree(hd_data.PBM));
+        gpuErrchk(cudaFree(d_data));
+        d_CUB_temp_storage = nullptr;
+        d_histogram = nullptr;
+        hd_data.keys = nullptr;
+        hd_data.PBM = nullptr;
+        hd_data.tableSize = 0;
+        d_data = nullptr;
+        if (d_keys) {
+            d_keys_vals_storage_bytes = 0;
+            gpuErrchk(cudaFree(d_keys));
+            gpuErrchk(cudaFree(d_vals));
+            d_keys = nullptr;
+            d_vals = nullptr;
+        }
+    }
+}
+
+void MessageSparseSpatial3D::CUDAModelHandler::buildIndex(CUDAScatter &scatter, const unsigned int &streamId, const cudaStream_t &stream) {
+    NVTX_RANGE("MessageSparseSpatial3D::CUDAModelHandler::buildIndex");
+    const unsigned int MESSAGE_COUNT = this->sim_message.getMessageCount();
+    resizeKeysVals(this->sim_message.getMaximumListSize());  // Resize based on allocated amount rather than message count
+    resizeTable(this->sim_message.getMaximumListSize());
+    {  // Build hash table and atomic histogram
+        gpuErrchk(cudaMemsetAsync(hd_data.keys, 0xff, hd_data.tableSize * sizeof(unsigned long long), stream));
+        gpuErrchk(cudaMemsetAsync(d_histogram, 0x00000000, (hd_data.tableSize + 1) * sizeof(unsigned int), stream));
+        if (MESSAGE_COUNT) {
+            int blockSize;  // The launch configurator returned block size
+            gpuErrchk(cudaOccupancyMaxActiveBlocksPerMultiprocessor(&blockSize, atomicHashHistogram3D, 32, 0));  // Randomly 32
+                                                                                                                 // Round up according to array size
+            int gridSize = (MESSAGE_COUNT + blockSize - 1) / blockSize;
+            atomicHashHistogram3D <<<gridSize, blockSize, 0, stream >>>(d_data, d_keys, d_vals, d_histogram, MESSAGE_COUNT,
+                reinterpret_cast<float*>(this->sim_message.getReadPtr("x")),
+                reinterpret_cast<float*>(this->sim_message.getReadPtr("y")),
+                reinterpret_cast<float*>(this->sim_message.getReadPtr("z")));
+        }
+    }
+    {  // Scan (sum), to finalise PBM
+        gpuErrchk(cub::DeviceScan::ExclusiveSum(d_CUB_temp_storage, d_CUB_temp_storage_bytes, d_histogram, hd_data.PBM, hd_data.tableSize + 1, stream));
+    }
+    {  // Reorder messages
+       // Copy messages from d_messages to d_messages_swap, in slot order
+        scatter.pbm_reorder(streamId, stream, this->sim_message.getReadVariables(), this->sim_message.getReadList(), this->sim_message.getWriteList(), MESSAGE_COUNT, d_keys, d_vals, hd_data.PBM);
+        this->sim_message.swap();  // Stream id is unused here
+        gpuErrchk(cudaStreamSynchronize(stream));  // Not striclty neceesary while pbm_reorder is synchronous.
+    }
+}
+
+void MessageSparseSpatial3D::CUDAModelHandler::resizeTable(const unsigned int &messageCount) {
+    const unsigned int newSize = util::detail::spatial_hash::tableSize(messageCount);
+    if (newSize > hd_data.tableSize) {
+        if (hd_data.keys) {
+            gpuErrchk(cudaFree(hd_data.keys));
+            gpuErrchk(cudaFree(hd_data.PBM));
+            gpuErrchk(cudaFree(d_histogram));
+        }
+        hd_data.tableSize = newSize;
+        gpuErrchk(cudaMalloc(&hd_data.keys, hd_data.tableSize * sizeof(unsigned long long)));
+        gpuErrchk(cudaMalloc(&hd_data.PBM, (hd_data.tableSize + 1) * sizeof(unsigned int)));
+        gpuErrchk(cudaMalloc(&d_histogram, (hd_data.tableSize + 1) * sizeof(unsigned int)));
+        // Resize cub temp to match the new PBM length
+        size_t bytesCheck = 0;
+        gpuErrchk(cub::DeviceScan::ExclusiveSum(nullptr, bytesCheck, hd_data.PBM, d_histogram, hd_data.tableSize + 1));
+        if (bytesCheck > d_CUB_temp_storage_bytes) {
+            if (d_CUB_temp_storage) {
+                gpuErrchk(cudaFree(d_CUB_temp_storage));
+            }
+            d_CUB_temp_storage_bytes = bytesCheck;
+            gpuErrchk(cudaMalloc(&d_CUB_temp_storage, d_CUB_temp_storage_bytes));
+        }
+        // Update the device copy of the metadata, as the table has moved
+        gpuErrchk(cudaMemcpy(d_data, &hd_data, sizeof(MetaData), cudaMemcpyHostToDevice));
+    }
+}
+
+void MessageSparseSpatial3D::CUDAModelHandler::resizeKeysVals(const unsigned int &newSize) {
+    size_t bytesCheck = newSize * sizeof(unsigned int);
+    if (bytesCheck > d_keys_vals_storage_bytes) {
+        if (d_keys) {
+            gpuErrchk(cudaFree(d_keys));
+            gpuErrchk(cudaFree(d_vals));
+        }
+        d_keys_vals_storage_bytes = bytesCheck;
+        gpuErrchk(cudaMalloc(&d_keys, d_keys_vals_storage_bytes));
+        gpuErrchk(cudaMalloc(&d_vals, d_keys_vals_storage_bytes));
+    }
+}
+
+MessageSparseSpatial3D::Data::Data(const std::shared_ptr<const ModelData> &model, const std::string &message_name)
+    : MessageBruteForce::Data(model, message_name)
+    , radius(NAN) {
+    description = std::unique_ptr<Description>(new Description(model, this));
+    description->newVariable<float>("x");
+    description->newVariable<float>("y");
+    description->newVariable<float>("z");
+    index_variables.insert({"x", "y", "z"});
+}
+MessageSparseSpatial3D::Data::Data(const std::shared_ptr<const ModelData> &model, const Data &other)
+    : MessageBruteForce::Data(model, other)
+    , radius(other.radius) {
+    description = std::unique_ptr<Description>(model ? new Description(model, this) : nullptr);
+    if (isnan(radius)) {
+        THROW exception::InvalidMessage("Radius has not been set in sparse spatial message '%s'\n", other.name.c_str());
+    }
+}
+MessageSparseSpatial3D::Data *MessageSparseSpatial3D::Data::clone(const std::shared_ptr<const ModelData> &newParent) {
+    return new Data(newParent, *this);
+}
+std::unique_ptr<MessageSpecialisationHandler> MessageSparseSpatial3D::Data::getSpecialisationHander(CUDAMessage &owner) const {
+    return std::unique_ptr<MessageSpecialisationHandler>(new CUDAModelHandler(owner));
+}
+std::type_index MessageSparseSpatial3D::Data::getType() const { return std::type_index(typeid(MessageSparseSpatial3D)); }
+
+MessageSparseSpatial3D::Description::Description(const std::shared_ptr<const ModelData> &_model, Data *const data)
+    : MessageBruteForce::Description(_model, data) { }
+
+void MessageSparseSpatial3D::Description::setRadius(const float &r) {
+    if (r <= 0) {
+        THROW exception::InvalidArgument("Spatial messaging radius must be a positive value, %f is not valid.", r);
+    }
+    reinterpret_cast<Data *>(message)->radius = r;
+}
+
+float MessageSparseSpatial3D::Description::getRadius() const {
+    return reinterpret_cast<Data *>(message)->radius;
+}
+
+}  // namespace flamegpu
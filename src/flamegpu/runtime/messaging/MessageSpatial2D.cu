@@ -15,6 +15,7 @@
 #include "flamegpu/gpu/CUDAMessage.h"
 #include "flamegpu/gpu/CUDAScatter.cuh"
 #include "flamegpu/util/nvtx.h"
+#include "flamegpu/model/AgentData.h"
 
 
 namespace flamegpu {
@@ -34,9 +35,29 @@ MessageSpatial2D::CUDAModelHandler::CUDAModelHandler(CUDAMessage &a)
     binCount = 1;
     for (unsigned int axis = 0; axis < 2; ++axis) {
         hd_data.environmentWidth[axis] = hd_data.max[axis] - hd_data.min[axis];
-        hd_data.gridDim[axis] = static_cast<unsigned int>(ceil(hd_data.environmentWidth[axis] / hd_data.radius));
+        // Periodic bins must not be narrower than radius, as the final bin neighbours the first
+        hd_data.gridDim[axis] = d.periodic
+            ? static_cast<unsigned int>(floor(hd_data.environmentWidth[axis] / hd_data.radius))
+            : static_cast<unsigned int>(ceil(hd_data.environmentWidth[axis] / hd_data.radius));
         binCount *= hd_data.gridDim[axis];
     }
+    hd_data.periodic = d.periodic;
+    deterministic = d.deterministic;
+    incremental = d.incremental;
+    static_steps = d.static_steps;
+    agent_view = d.isAgentView();
+    hd_data.permutation = nullptr;
+    hd_data.mortonOrder = d.morton_order;
+    hd_data.mortonBits = 0;
+    if (d.morton_order) {
+        // Morton tiles are padded to a power of two, so the bin count includes bins which are never occupied
+        hd_data.mortonBits = util::detail::morton::tileBits(hd_data.gridDim, 2);
+        binCount = 1 << (2 * hd_data.mortonBits);
+        for (unsigned int axis = 0; axis < 2; ++axis) {
+            hd_data.mortonTiles[axis] = util::detail::morton::tileCount(hd_data.gridDim[axis], hd_data.mortonBits);
+            binCount *= hd_data.mortonTiles[axis];
+        }
+    }
 }
 MessageSpatial2D::CUDAModelHandler::~CUDAModelHandler() { }
 __global__ void atomicHistogram2D(
@@ -54,8 +75,30 @@ __global__ void atomicHistogram2D(
     MessageSpatial2D::GridPos2D gridPos = getGridPosition2D(md, x[index], y[index]);
     unsigned int hash = getHash2D(md, gridPos);
     bin_index[index] = hash;
-    unsigned int bin_idx = atomicInc((unsigned int*)&pbm_counts[hash], 0xFFFFFFFF);
-    bin_sub_index[index] = bin_idx;
+    // pbm_counts is not provided when the index is built deterministically, the sub index is then found by sorting
+    if (pbm_counts) {
+        unsigned int bin_idx = atomicInc((unsigned int*)&pbm_counts[hash], 0xFFFFFFFF);
+        bin_sub_index[index] = bin_idx;
+    }
+}
+
+__global__ void binChanges2D(
+    const MessageSpatial2D::MetaData *md,
+    unsigned int* bin_index,
+    unsigned int *bins_changed,
+    unsigned int message_count,
+    const float * __restrict__ x,
+    const float * __restrict__ y) {
+    unsigned int index = (blockIdx.x * blockDim.x) + threadIdx.x;
+    // Kill excess threads
+    if (index >= message_count) return;
+
+    const unsigned int hash = getHash2D(md, getGridPosition2D(md, x[index], y[index]));
+    // Only messages which have left the bin they were indexed in write
+    if (hash != bin_index[index]) {
+        bin_index[index] = hash;
+        *bins_changed = 1;
+    }
 }
 
 void MessageSpatial2D::CUDAModelHandler::init(CUDAScatter &, const unsigned int &) {
@@ -67,6 +110,7 @@ void MessageSpatial2D::CUDAModelHandler::init(CUDAScatter &, const unsigned int
 void MessageSpatial2D::CUDAModelHandler::allocateMetaDataDevicePtr() {
     if (d_data == nullptr) {
         gpuErrchk(cudaMalloc(&d_histogram, (binCount + 1) * sizeof(unsigned int)));
+        gpuErrchk(cudaMalloc(&d_bins_changed, sizeof(unsigned int)));
         gpuErrchk(cudaMalloc(&hd_data.PBM, (binCount + 1) * sizeof(unsigned int)));
         gpuErrchk(cudaMalloc(&d_data, sizeof(MetaData)));
         gpuErrchk(cudaMemcpy(d_data, &hd_data, sizeof(MetaData), cudaMemcpyHostToDevice));
@@ -79,10 +123,12 @@ void MessageSpatial2D::CUDAModelHandler::freeMetaDataDevicePtr() {
         d_CUB_temp_storage_bytes = 0;
         gpuErrchk(cudaFree(d_CUB_temp_storage));
         gpuErrchk(cudaFree(d_histogram));
+        gpuErrchk(cudaFree(d_bins_changed));
         gpuErrchk(cudaFree(hd_data.PBM));
         gpuErrchk(cudaFree(d_data));
         d_CUB_temp_storage = nullptr;
         d_histogram = nullptr;
+        d_bins_changed = nullptr;
         hd_data.PBM = nullptr;
         d_data = nullptr;
         if (d_keys) {
@@ -92,6 +138,11 @@ void MessageSpatial2D::CUDAModelHandler::freeMetaDataDevicePtr() {
             d_keys = nullptr;
             d_vals = nullptr;
         }
+        if (hd_data.permutation) {
+            gpuErrchk(cudaFree(hd_data.permutation));
+            hd_data.permutation = nullptr;
+        }
+        index_valid = false;
     }
 }
 
@@ -99,22 +150,45 @@ void MessageSpatial2D::CUDAModelHandler::buildIndex(CUDAScatter &scatter, const
     NVTX_RANGE("MessageSpatial2D::CUDAModelHandler::buildIndex");
     const unsigned int MESSAGE_COUNT = this->sim_message.getMessageCount();
     resizeKeysVals(this->sim_message.getMaximumListSize());  // Resize based on allocated amount rather than message count
-    {  // Build atomic histogram
-        gpuErrchk(cudaMemsetAsync(d_histogram, 0x00000000, (binCount + 1) * sizeof(unsigned int), stream));
-        int blockSize;  // The launch configurator returned block size
-        gpuErrchk(cudaOccupancyMaxActiveBlocksPerMultiprocessor(&blockSize, atomicHistogram2D, 32, 0));  // Randomly 32
-                                                                                                         // Round up according to array size
-        int gridSize = (MESSAGE_COUNT + blockSize - 1) / blockSize;
-        atomicHistogram2D <<<gridSize, blockSize, 0, stream >>>(d_data, d_keys, d_vals, d_histogram, MESSAGE_COUNT,
-            reinterpret_cast<float*>(this->sim_message.getReadPtr("x")),
-            reinterpret_cast<float*>(this->sim_message.getReadPtr("y")));
+    // The previous index can be reused if the message count is unchanged, and no message has left the bin it was indexed in
+    bool reuse_index = false;
+    if (index_valid && MESSAGE_COUNT == indexed_message_count) {
+        if (static_builds_remaining) {
+            --static_builds_remaining;
+            reuse_index = true;
+        } else if (incremental) {
+            reuse_index = !binsChanged(MESSAGE_COUNT, stream);
+        }
     }
-    {  // Scan (sum), to finalise PBM
-        gpuErrchk(cub::DeviceScan::ExclusiveSum(d_CUB_temp_storage, d_CUB_temp_storage_bytes, d_histogram, hd_data.PBM, binCount + 1, stream));
+    if (!reuse_index) {
+        {  // Build atomic histogram
+            if (!deterministic) {
+                gpuErrchk(cudaMemsetAsync(d_histogram, 0x00000000, (binCount + 1) * sizeof(unsigned int), stream));
+            }
+            int blockSize;  // The launch configurator returned block size
+            gpuErrchk(cudaOccupancyMaxActiveBlocksPerMultiprocessor(&blockSize, atomicHistogram2D, 32, 0));  // Randomly 32
+                                                                                                             // Round up according to array size
+            int gridSize = (MESSAGE_COUNT + blockSize - 1) / blockSize;
+            atomicHistogram2D <<<gridSize, blockSize, 0, stream >>>(d_data, d_keys, d_vals, deterministic ? nullptr : d_histogram, MESSAGE_COUNT,
+                reinterpret_cast<float*>(this->sim_message.getReadPtr("x")),
+                reinterpret_cast<float*>(this->sim_message.getReadPtr("y")));
+        }
+        if (deterministic) {  // Stable sort by bin, to build the sub index and PBM without atomics
+            scatter.pbm_stable_sort(streamId, stream, MESSAGE_COUNT, binCount, d_keys, d_vals, hd_data.PBM);
+        } else {  // Scan (sum), to finalise PBM
+            gpuErrchk(cub::DeviceScan::ExclusiveSum(d_CUB_temp_storage, d_CUB_temp_storage_bytes, d_histogram, hd_data.PBM, binCount + 1, stream));
+        }
+        index_valid = true;
+        indexed_message_count = MESSAGE_COUNT;
+        static_builds_remaining = static_steps > 1 ? static_steps - 1 : 0;
     }
-    {  // Reorder messages
+    if (agent_view) {  // Sort agent indices, the agent data is then read in place
+        if (!reuse_index) {
+            scatter.pbm_permutation(stream, MESSAGE_COUNT, d_keys, d_vals, hd_data.PBM, hd_data.permutation);
+        }
+    } else {  // Reorder messages
        // Copy messages from d_messages to d_messages_swap, in hash order
-        scatter.pbm_reorder(streamId, stream, this->sim_message.getMessageDescription().variables, this->sim_message.getReadList(), this->sim_message.getWriteList(), MESSAGE_COUNT, d_keys, d_vals, hd_data.PBM);
+        scatter.pbm_reorder(streamId, stream, this->sim_message.getReadVariables(), this->sim_message.getReadList(), this->sim_message.getWriteList(), MESSAGE_COUNT, d_keys, d_vals, hd_data.PBM);
         this->sim_message.swap();
         gpuErrchk(cudaStreamSynchronize(stream));  // Not striclty neceesary while pbm_reorder is synchronous.
     }
@@ -124,6 +198,23 @@ void MessageSpatial2D::CUDAModelHandler::buildIndex(CUDAScatter &scatter, const
     }
 }
 
+bool MessageSpatial2D::CUDAModelHandler::binsChanged(const unsigned int &messageCount, const cudaStream_t &stream) {
+    if (messageCount == 0) {
+        return false;
+    }
+    gpuErrchk(cudaMemsetAsync(d_bins_changed, 0x00000000, sizeof(unsigned int), stream));
+    int blockSize;  // The launch configurator returned block size
+    gpuErrchk(cudaOccupancyMaxActiveBlocksPerMultiprocessor(&blockSize, binChanges2D, 32, 0));  // Randomly 32
+    int gridSize = (messageCount + blockSize - 1) / blockSize;
+    binChanges2D <<<gridSize, blockSize, 0, stream >>>(d_data, d_keys, d_bins_changed, messageCount,
+            reinterpret_cast<float*>(this->sim_message.getReadPtr("x")),
+            reinterpret_cast<float*>(this->sim_message.getReadPtr("y")));
+    unsigned int bins_changed = 0;
+    gpuErrchk(cudaMemcpyAsync(&bins_changed, d_bins_changed, sizeof(unsigned int), cudaMemcpyDeviceToHost, stream));
+    gpuErrchk(cudaStreamSynchronize(stream));
+    return bins_changed != 0;
+}
+
 void MessageSpatial2D::CUDAModelHandler::resizeCubTemp() {
     size_t bytesCheck = 0;
     gpuErrchk(cub::DeviceScan::ExclusiveSum(nullptr, bytesCheck, hd_data.PBM, d_histogram, binCount + 1));
@@ -146,6 +237,15 @@ void MessageSpatial2D::CUDAModelHandler::resizeKeysVals(const unsigned int &newS
         d_keys_vals_storage_bytes = bytesCheck;
         gpuErrchk(cudaMalloc(&d_keys, d_keys_vals_storage_bytes));
         gpuErrchk(cudaMalloc(&d_vals, d_keys_vals_storage_bytes));
+        // The previous index was lost with the old arrays
+        index_valid = false;
+        if (agent_view) {
+            if (hd_data.permutation) {
+                gpuErrchk(cudaFree(hd_data.permutation));
+            }
+            gpuErrchk(cudaMalloc(&hd_data.permutation, d_keys_vals_storage_bytes));
+            gpuErrchk(cudaMemcpy(d_data, &hd_data, sizeof(MetaData), cudaMemcpyHostToDevice));
+        }
     }
 }
 
@@ -156,10 +256,16 @@ MessageSpatial2D::Data::Data(const std::shared_ptr<const ModelData> &model, cons
     , minX(NAN)
     , minY(NAN)
     , maxX(NAN)
-    , maxY(NAN) {
+    , maxY(NAN)
+    , morton_order(false)
+    , periodic(false)
+    , deterministic(false)
+    , incremental(false)
+    , static_steps(0) {
     description = std::unique_ptr<MessageSpatial2D::Description>(new MessageSpatial2D::Description(model, this));
     description->newVariable<float>("x");
     description->newVariable<float>("y");
+    index_variables.insert({"x", "y"});
 }
 MessageSpatial2D::Data::Data(const std::shared_ptr<const ModelData> &model, const Data &other)
     : MessageBruteForce::Data(model, other)
@@ -167,7 +273,12 @@ MessageSpatial2D::Data::Data(const std::shared_ptr<const ModelData> &model, cons
     , minX(other.minX)
     , minY(other.minY)
     , maxX(other.maxX)
-    , maxY(other.maxY) {
+    , maxY(other.maxY)
+    , morton_order(other.morton_order)
+    , periodic(other.periodic)
+    , deterministic(other.deterministic)
+    , incremental(other.incremental)
+    , static_steps(other.static_steps) {
     description = std::unique_ptr<MessageSpatial2D::Description>(model ? new MessageSpatial2D::Description(model, this) : nullptr);
     if (isnan(radius)) {
         THROW exception::InvalidMessage("Radius has not been set in spatial message '%s'.", other.name.c_str());
@@ -184,6 +295,9 @@ MessageSpatial2D::Data::Data(const std::shared_ptr<const ModelData> &model, cons
     if (isnan(maxY)) {
         THROW exception::InvalidMessage("Environment maximum y bound has not been set in spatial message '%s'.", other.name.c_str());
     }
+    if (periodic && (floor((maxX - minX) / radius) < 3 || floor((maxY - minY) / radius) < 3)) {
+        THROW exception::InvalidMessage("Periodic spatial message '%s' requires each environment dimension to be at least 3x the radius.", other.name.c_str());
+    }
 }
 MessageSpatial2D::Data *MessageSpatial2D::Data::clone(const std::shared_ptr<const ModelData> &newParent) {
     return new Data(newParent, *this);
@@ -256,6 +370,41 @@ void MessageSpatial2D::Description::setMax(const float &x, const float &y) {
     reinterpret_cast<Data *>(message)->maxY = y;
 }
 
+void MessageSpatial2D::Description::setMortonOrder(const bool &morton_order) {
+    reinterpret_cast<Data *>(message)->morton_order = morton_order;
+}
+void MessageSpatial2D::Description::setPeriodic(const bool &periodic) {
+    reinterpret_cast<Data *>(message)->periodic = periodic;
+}
+void MessageSpatial2D::Description::setDeterministic(const bool &deterministic) {
+    reinterpret_cast<Data *>(message)->deterministic = deterministic;
+}
+void MessageSpatial2D::Description::setIncremental(const bool &incremental) {
+    reinterpret_cast<Data *>(message)->incremental = incremental;
+}
+void MessageSpatial2D::Description::setStaticSteps(const unsigned int &steps) {
+    reinterpret_cast<Data *>(message)->static_steps = steps;
+}
+void MessageSpatial2D::Description::setAgentView(const std::string &agent_name, const std::string &state_name) {
+    auto mdl = model.lock();
+    if (!mdl) {
+        THROW exception::ExpiredWeakPtr();
+    }
+    auto a = mdl->agents.find(agent_name);
+    if (a == mdl->agents.end()) {
+        THROW exception::InvalidAgentName("Model ('%s') does not contain agent '%s', "
+            "in MessageSpatial2D::Description::setAgentView().",
+            mdl->name.c_str(), agent_name.c_str());
+    }
+    if (a->second->states.find(state_name) == a->second->states.end()) {
+        THROW exception::InvalidStateName("Agent ('%s') does not contain state '%s', "
+            "in MessageSpatial2D::Description::setAgentView().",
+            agent_name.c_str(), state_name.c_str());
+    }
+    reinterpret_cast<Data *>(message)->view_agent = agent_name;
+    reinterpret_cast<Data *>(message)->view_state = state_name;
+}
+
 float MessageSpatial2D::Description::getRadius() const {
     return reinterpret_cast<Data *>(message)->radius;
 }
@@ -271,5 +420,26 @@ float MessageSpatial2D::Description::getMaxX() const {
 float MessageSpatial2D::Description::getMaxY() const {
     return reinterpret_cast<Data *>(message)->maxY;
 }
+bool MessageSpatial2D::Description::getMortonOrder() const {
+    return reinterpret_cast<Data *>(message)->morton_order;
+}
+bool MessageSpatial2D::Description::getPeriodic() const {
+    return reinterpret_cast<Data *>(message)->periodic;
+}
+bool MessageSpatial2D::Description::getDeterministic() const {
+    return reinterpret_cast<Data *>(message)->deterministic;
+}
+bool MessageSpatial2D::Description::getIncremental() const {
+    return reinterpret_cast<Data *>(message)->incremental;
+}
+unsigned int MessageSpatial2D::Description::getStaticSteps() const {
+    return reinterpret_cast<Data *>(message)->static_steps;
+}
+std::string MessageSpatial2D::Description::getViewAgent() const {
+    return reinterpret_cast<Data *>(message)->view_agent;
+}
+std::string MessageSpatial2D::Description::getViewState() const {
+    return reinterpret_cast<Data *>(message)->view_state;
+}
 
 }  // namespace flamegpu
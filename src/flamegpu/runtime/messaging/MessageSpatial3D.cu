@@ -2,6 +2,7 @@
 #include "flamegpu/runtime/messaging/MessageSpatial3D/MessageSpatial3DDevice.cuh"
 
 #include "flamegpu/gpu/CUDAScatter.cuh"
+#include "flamegpu/model/AgentData.h"
 #ifdef _MSC_VER
 #pragma warning(push, 1)
 #pragma warning(disable : 4706 4834)
@@ -30,9 +31,29 @@ MessageSpatial3D::CUDAModelHandler::CUDAModelHandler(CUDAMessage &a)
     binCount = 1;
     for (unsigned int axis = 0; axis < 3; ++axis) {
         hd_data.environmentWidth[axis] = hd_data.max[axis] - hd_data.min[axis];
-        hd_data.gridDim[axis] = static_cast<unsigned int>(ceil(hd_data.environmentWidth[axis] / hd_data.radius));
+        // Periodic bins must not be narrower than radius, as the final bin neighbours the first
+        hd_data.gridDim[axis] = d.periodic
+            ? static_cast<unsigned int>(floor(hd_data.environmentWidth[axis] / hd_data.radius))
+            : static_cast<unsigned int>(ceil(hd_data.environmentWidth[axis] / hd_data.radius));
         binCount *= hd_data.gridDim[axis];
     }
+    hd_data.periodic = d.periodic;
+    deterministic = d.deterministic;
+    incremental = d.incremental;
+    static_steps = d.static_steps;
+    agent_view = d.isAgentView();
+    hd_data.permutation = nullptr;
+    hd_data.mortonOrder = d.morton_order;
+    hd_data.mortonBits = 0;
+    if (d.morton_order) {
+        // Morton tiles are padded to a power of two, so the bin count includes bins which are never occupied
+        hd_data.mortonBits = util::detail::morton::tileBits(hd_data.gridDim, 3);
+        binCount = 1 << (3 * hd_data.mortonBits);
+        for (unsigned int axis = 0; axis < 3; ++axis) {
+            hd_data.mortonTiles[axis] = util::detail::morton::tileCount(hd_data.gridDim[axis], hd_data.mortonBits);
+            binCount *= hd_data.mortonTiles[axis];
+        }
+    }
     // Device allocation occurs in allocateMetaDataDevicePtr rather than the constructor.
 }
 
@@ -52,8 +73,31 @@ __global__ void atomicHistogram3D(
     MessageSpatial3D::GridPos3D gridPos = getGridPosition3D(md, x[index], y[index], z[index]);
     unsigned int hash = getHash3D(md, gridPos);
     bin_index[index] = hash;
-    unsigned int bin_idx = atomicInc((unsigned int*)&pbm_counts[hash], 0xFFFFFFFF);
-    bin_sub_index[index] = bin_idx;
+    // pbm_counts is not provided when the index is built deterministically, the sub index is then found by sorting
+    if (pbm_counts) {
+        unsigned int bin_idx = atomicInc((unsigned int*)&pbm_counts[hash], 0xFFFFFFFF);
+        bin_sub_index[index] = bin_idx;
+    }
+}
+
+__global__ void binChanges3D(
+    const MessageSpatial3D::MetaData *md,
+    unsigned int* bin_index,
+    unsigned int *bins_changed,
+    unsigned int message_count,
+    const float * __restrict__ x,
+    const float * __restrict__ y,
+    const float * __restrict__ z) {
+    unsigned int index = (blockIdx.x * blockDim.x) + threadIdx.x;
+    // Kill excess threads
+    if (index >= message_count) return;
+
+    const unsigned int hash = getHash3D(md, getGridPosition3D(md, x[index], y[index], z[index]));
+    // Only messages which have left the bin they were indexed in write
+    if (hash != bin_index[index]) {
+        bin_index[index] = hash;
+        *bins_changed = 1;
+    }
 }
 
 void MessageSpatial3D::CUDAModelHandler::init(CUDAScatter &, const unsigned int &) {
@@ -65,6 +109,7 @@ void MessageSpatial3D::CUDAModelHandler::init(CUDAScatter &, const unsigned int
 void MessageSpatial3D::CUDAModelHandler::allocateMetaDataDevicePtr() {
     if (d_data == nullptr) {
         gpuErrchk(cudaMalloc(&d_histogram, (binCount + 1) * sizeof(unsigned int)));
+        gpuErrchk(cudaMalloc(&d_bins_changed, sizeof(unsigned int)));
         gpuErrchk(cudaMalloc(&hd_data.PBM, (binCount + 1) * sizeof(unsigned int)));
         gpuErrchk(cudaMalloc(&d_data, sizeof(MetaData)));
         gpuErrchk(cudaMemcpy(d_data, &hd_data, sizeof(MetaData), cudaMemcpyHostToDevice));
@@ -77,10 +122,12 @@ void MessageSpatial3D::CUDAModelHandler::freeMetaDataDevicePtr() {
         d_CUB_temp_storage_bytes = 0;
         gpuErrchk(cudaFree(d_CUB_temp_storage));
         gpuErrchk(cudaFree(d_histogram));
+        gpuErrchk(cudaFree(d_bins_changed));
         gpuErrchk(cudaFree(hd_data.PBM));
         gpuErrchk(cudaFree(d_data));
         d_CUB_temp_storage = nullptr;
         d_histogram = nullptr;
+        d_bins_changed = nullptr;
         hd_data.PBM = nullptr;
         d_data = nullptr;
         if (d_keys) {
@@ -90,6 +137,11 @@ void MessageSpatial3D::CUDAModelHandler::freeMetaDataDevicePtr() {
             d_keys = nullptr;
             d_vals = nullptr;
         }
+        if (hd_data.permutation) {
+            gpuErrchk(cudaFree(hd_data.permutation));
+            hd_data.permutation = nullptr;
+        }
+        index_valid = false;
     }
 }
 
@@ -97,23 +149,46 @@ void MessageSpatial3D::CUDAModelHandler::buildIndex(CUDAScatter &scatter, const
     NVTX_RANGE("MessageSpatial3D::CUDAModelHandler::buildIndex");
     const unsigned int MESSAGE_COUNT = this->sim_message.getMessageCount();
     resizeKeysVals(this->sim_message.getMaximumListSize());  // Resize based on allocated amount rather than message count
-    {  // Build atomic histogram
-        gpuErrchk(cudaMemsetAsync(d_histogram, 0x00000000, (binCount + 1) * sizeof(unsigned int), stream));
-        int blockSize;  // The launch configurator returned block size
-        gpuErrchk(cudaOccupancyMaxActiveBlocksPerMultiprocessor(&blockSize, atomicHistogram3D, 32, 0));  // Randomly 32
-                                                                                                         // Round up according to array size
-        int gridSize = (MESSAGE_COUNT + blockSize - 1) / blockSize;
-        atomicHistogram3D <<<gridSize, blockSize, 0, stream >>>(d_data, d_keys, d_vals, d_histogram, MESSAGE_COUNT,
-            reinterpret_cast<float*>(this->sim_message.getReadPtr("x")),
-            reinterpret_cast<float*>(this->sim_message.getReadPtr("y")),
-            reinterpret_cast<float*>(this->sim_message.getReadPtr("z")));
+    // The previous index can be reused if the message count is unchanged, and no message has left the bin it was indexed in
+    bool reuse_index = false;
+    if (index_valid && MESSAGE_COUNT == indexed_message_count) {
+        if (static_builds_remaining) {
+            --static_builds_remaining;
+            reuse_index = true;
+        } else if (incremental) {
+            reuse_index = !binsChanged(MESSAGE_COUNT, stream);
+        }
     }
-    {  // Scan (sum), to finalise PBM
-        gpuErrchk(cub::DeviceScan::ExclusiveSum(d_CUB_temp_storage, d_CUB_temp_storage_bytes, d_histogram, hd_data.PBM, binCount + 1, stream));
+    if (!reuse_index) {
+        {  // Build atomic histogram
+            if (!deterministic) {
+                gpuErrchk(cudaMemsetAsync(d_histogram, 0x00000000, (binCount + 1) * sizeof(unsigned int), stream));
+            }
+            int blockSize;  // The launch configurator returned block size
+            gpuErrchk(cudaOccupancyMaxActiveBlocksPerMultiprocessor(&blockSize, atomicHistogram3D, 32, 0));  // Randomly 32
+                                                                                                             // Round up according to array size
+            int gridSize = (MESSAGE_COUNT + blockSize - 1) / blockSize;
+            atomicHistogram3D <<<gridSize, blockSize, 0, stream >>>(d_data, d_keys, d_vals, deterministic ? nullptr : d_histogram, MESSAGE_COUNT,
+                reinterpret_cast<float*>(this->sim_message.getReadPtr("x")),
+                reinterpret_cast<float*>(this->sim_message.getReadPtr("y")),
+                reinterpret_cast<float*>(this->sim_message.getReadPtr("z")));
+        }
+        if (deterministic) {  // Stable sort by bin, to build the sub index and PBM without atomics
+            scatter.pbm_stable_sort(streamId, stream, MESSAGE_COUNT, binCount, d_keys, d_vals, hd_data.PBM);
+        } else {  // Scan (sum), to finalise PBM
+            gpuErrchk(cub::DeviceScan::ExclusiveSum(d_CUB_temp_storage, d_CUB_temp_storage_bytes, d_histogram, hd_data.PBM, binCount + 1, stream));
+        }
+        index_valid = true;
+        indexed_message_count = MESSAGE_COUNT;
+        static_builds_remaining = static_steps > 1 ? static_steps - 1 : 0;
     }
-    {  // Reorder messages
+    if (agent_view) {  // Sort agent indices, the agent data is then read in place
+        if (!reuse_index) {
+            scatter.pbm_permutation(stream, MESSAGE_COUNT, d_keys, d_vals, hd_data.PBM, hd_data.permutation);
+        }
+    } else {  // Reorder messages
        // Copy messages from d_messages to d_messages_swap, in hash order
-        scatter.pbm_reorder(streamId, stream, this->sim_message.getMessageDescription().variables, this->sim_message.getReadList(), this->sim_message.getWriteList(), MESSAGE_COUNT, d_keys, d_vals, hd_data.PBM);
+        scatter.pbm_reorder(streamId, stream, this->sim_message.getReadVariables(), this->sim_message.getReadList(), this->sim_message.getWriteList(), MESSAGE_COUNT, d_keys, d_vals, hd_data.PBM);
         this->sim_message.swap();  // Stream id is unused here
         gpuErrchk(cudaStreamSynchronize(stream));  // Not striclty neceesary while pbm_reorder is synchronous.
     }
@@ -123,6 +198,24 @@ void MessageSpatial3D::CUDAModelHandler::buildIndex(CUDAScatter &scatter, const
     }
 }
 
+bool MessageSpatial3D::CUDAModelHandler::binsChanged(const unsigned int &messageCount, const cudaStream_t &stream) {
+    if (messageCount == 0) {
+        return false;
+    }
+    gpuErrchk(cudaMemsetAsync(d_bins_changed, 0x00000000, sizeof(unsigned int), stream));
+    int blockSize;  // The launch configurator returned block size
+    gpuErrchk(cudaOccupancyMaxActiveBlocksPerMultiprocessor(&blockSize, binChanges3D, 32, 0));  // Randomly 32
+    int gridSize = (messageCount + blockSize - 1) / blockSize;
+    binChanges3D <<<gridSize, blockSize, 0, stream >>>(d_data, d_keys, d_bins_changed, messageCount,
+            reinterpret_cast<float*>(this->sim_message.getReadPtr("x")),
+            reinterpret_cast<float*>(this->sim_message.getReadPtr("y")),
+            reinterpret_cast<float*>(this->sim_message.getReadPtr("z")));
+    unsigned int bins_changed = 0;
+    gpuErrchk(cudaMemcpyAsync(&bins_changed, d_bins_changed, sizeof(unsigned int), cudaMemcpyDeviceToHost, stream));
+    gpuErrchk(cudaStreamSynchronize(stream));
+    return bins_changed != 0;
+}
+
 void MessageSpatial3D::CUDAModelHandler::resizeCubTemp() {
     size_t bytesCheck = 0;
     gpuErrchk(cub::DeviceScan::ExclusiveSum(nullptr, bytesCheck, hd_data.PBM, d_histogram, binCount + 1));
@@ -145,6 +238,15 @@ void MessageSpatial3D::CUDAModelHandler::resizeKeysVals(const unsigned int &newS
         d_keys_vals_storage_bytes = bytesCheck;
         gpuErrchk(cudaMalloc(&d_keys, d_keys_vals_storage_bytes));
         gpuErrchk(cudaMalloc(&d_vals, d_keys_vals_storage_bytes));
+        // The previous index was lost with the old arrays
+        index_valid = false;
+        if (agent_view) {
+            if (hd_data.permutation) {
+                gpuErrchk(cudaFree(hd_data.permutation));
+            }
+            gpuErrchk(cudaMalloc(&hd_data.permutation, d_keys_vals_storage_bytes));
+            gpuErrchk(cudaMemcpy(d_data, &hd_data, sizeof(MetaData), cudaMemcpyHostToDevice));
+        }
     }
 }
 
@@ -154,6 +256,7 @@ MessageSpatial3D::Data::Data(const std::shared_ptr<const ModelData> &model, cons
     , maxZ(NAN) {
     description = std::unique_ptr<Description>(new Description(model, this));
     description->newVariable<float>("z");
+    index_variables.insert("z");
 }
 MessageSpatial3D::Data::Data(const std::shared_ptr<const ModelData> &model, const Data &other)
     : MessageSpatial2D::Data(model, other)
@@ -166,6 +269,9 @@ MessageSpatial3D::Data::Data(const std::shared_ptr<const ModelData> &model, cons
     if (isnan(maxZ)) {
         THROW exception::InvalidMessage("Environment maximum z bound has not been set in spatial message '%s'\n", other.name.c_str());
     }
+    if (periodic && floor((maxZ - minZ) / radius) < 3) {
+        THROW exception::InvalidMessage("Periodic spatial message '%s' requires each environment dimension to be at least 3x the radius.", other.name.c_str());
+    }
 }
 MessageSpatial3D::Data *MessageSpatial3D::Data::clone(const std::shared_ptr<const ModelData> &newParent) {
     return new Data(newParent, *this);
@@ -261,6 +367,41 @@ void MessageSpatial3D::Description::setMax(const float &x, const float &y, const
     reinterpret_cast<Data *>(message)->maxZ = z;
 }
 
+void MessageSpatial3D::Description::setMortonOrder(const bool &morton_order) {
+    reinterpret_cast<Data *>(message)->morton_order = morton_order;
+}
+void MessageSpatial3D::Description::setPeriodic(const bool &periodic) {
+    reinterpret_cast<Data *>(message)->periodic = periodic;
+}
+void MessageSpatial3D::Description::setDeterministic(const bool &deterministic) {
+    reinterpret_cast<Data *>(message)->deterministic = deterministic;
+}
+void MessageSpatial3D::Description::setIncremental(const bool &incremental) {
+    reinterpret_cast<Data *>(message)->incremental = incremental;
+}
+void MessageSpatial3D::Description::setStaticSteps(const unsigned int &steps) {
+    reinterpret_cast<Data *>(message)->static_steps = steps;
+}
+void MessageSpatial3D::Description::setAgentView(const std::string &agent_name, const std::string &state_name) {
+    auto mdl = model.lock();
+    if (!mdl) {
+        THROW exception::ExpiredWeakPtr();
+    }
+    auto a = mdl->agents.find(agent_name);
+    if (a == mdl->agents.end()) {
+        THROW exception::InvalidAgentName("Model ('%s') does not contain agent '%s', "
+            "in MessageSpatial3D::Description::setAgentView().",
+            mdl->name.c_str(), agent_name.c_str());
+    }
+    if (a->second->states.find(state_name) == a->second->states.end()) {
+        THROW exception::InvalidStateName("Agent ('%s') does not contain state '%s', "
+            "in MessageSpatial3D::Description::setAgentView().",
+            agent_name.c_str(), state_name.c_str());
+    }
+    reinterpret_cast<Data *>(message)->view_agent = agent_name;
+    reinterpret_cast<Data *>(message)->view_state = state_name;
+}
+
 float MessageSpatial3D::Description::getRadius() const {
     return reinterpret_cast<Data *>(message)->radius;
 }
@@ -282,5 +423,26 @@ float MessageSpatial3D::Description::getMaxY() const {
 float MessageSpatial3D::Description::getMaxZ() const {
     return reinterpret_cast<Data *>(message)->maxZ;
 }
+bool MessageSpatial3D::Description::getMortonOrder() const {
+    return reinterpret_cast<Data *>(message)->morton_order;
+}
+bool MessageSpatial3D::Description::getPeriodic() const {
+    return reinterpret_cast<Data *>(message)->periodic;
+}
+bool MessageSpatial3D::Description::getDeterministic() const {
+    return reinterpret_cast<Data *>(message)->deterministic;
+}
+bool MessageSpatial3D::Description::getIncremental() const {
+    return reinterpret_cast<Data *>(message)->incremental;
+}
+unsigned int MessageSpatial3D::Description::getStaticSteps() const {
+    return reinterpret_cast<Data *>(message)->static_steps;
+}
+std::string MessageSpatial3D::Description::getViewAgent() const {
+    return reinterpret_cast<Data *>(message)->view_agent;
+}
+std::string MessageSpatial3D::Description::getViewState() const {
+    return reinterpret_cast<Data *>(message)->view_state;
+}
 
 }  // namespace flamegpu
@@ -1,5 +1,6 @@
 #include "flamegpu/runtime/utility/EnvironmentManager.cuh"
 
+#include <algorithm>
 #include <cassert>
 #include <memory>
 
@@ -24,6 +25,7 @@ namespace detail {
 
 std::mutex EnvironmentManager::instance_mutex;
 const char EnvironmentManager::CURVE_NAMESPACE_STRING[23] = "ENVIRONMENT_PROPERTIES";
+const EnvironmentManager::size_type EnvironmentManager::ALL_ELEMENTS;
 
 EnvironmentManager::EnvironmentManager() :
     CURVE_NAMESPACE_HASH(detail::curve::Curve::variableRuntimeHash(CURVE_NAMESPACE_STRING)),
@@ -37,10 +39,12 @@ void EnvironmentManager::purge() {
     std::unique_lock<std::shared_timed_mutex> deviceRequiresUpdate_lock(deviceRequiresUpdate_mutex);
     deviceInitialised = false;
     for (auto &a : deviceRequiresUpdate) {
-        a.second.c_update_required = true;
         a.second.rtc_update_required = true;
         a.second.curve_registration_required = true;
     }
+    // Device memory has been reset, so the whole buffer must be uploaded
+    dirty_ranges.clear();
+    dirty_ranges.push_back(OffsetLen(0, MAX_BUFFER_SIZE));
     deviceRequiresUpdate_lock.unlock();
     // We are now able to only purge the device stuff after device reset?
     // freeFragments.clear();
@@ -314,7 +318,7 @@ void EnvironmentManager::newProperty(const NamePair &name, const char *ptr, cons
     }
 #endif
     addRTCOffset(name);
-    setDeviceRequiresUpdateFlag();
+    setDeviceRequiresUpdateFlag(UINT_MAX, buffOffset, length);
 }
 
 #ifdef _DEBUG
@@ -597,7 +601,8 @@ void EnvironmentManager::removeProperty(const NamePair &name) {
     } else {
         mapped_properties.erase(name);
     }
-    setDeviceRequiresUpdateFlag(name.first);
+    // The freed bytes are no longer read, so there is nothing to upload
+    setDeviceRequiresUpdateFlag(name.first, 0, 0);
 }
 void EnvironmentManager::removeProperty(const unsigned int &instance_id, const std::string &var_name) {
     removeProperty({instance_id, var_name});
@@ -617,44 +622,139 @@ void EnvironmentManager::resetModel(const unsigned int &instance_id, const Envir
             void *rtc_ptr = rtc_caches.at(instance_id)->hc_buffer + p.rtc_offset;
             memcpy(rtc_ptr, d.second.data.ptr, d.second.data.length);
             assert(d.second.data.length == p.length);
+            setDeviceRequiresUpdateFlag(instance_id, p.offset, p.length);
         }
     }
-    setDeviceRequiresUpdateFlag(instance_id);
 }
-void EnvironmentManager::setDeviceRequiresUpdateFlag(const unsigned int &instance_id) {
+void EnvironmentManager::setProperties(const unsigned int &instance_id, const std::vector<PropertyWrite> &writes, const bool &ignoreConst) {
+    if (writes.empty())
+        return;
+    std::unique_lock<std::shared_timed_mutex> lock(mutex);
+    // Validate every write before applying any, so a failed batch leaves the environment unchanged
+    std::vector<OffsetLen> ranges;
+    ranges.reserve(writes.size());
+    for (const auto &w : writes) {
+        const NamePair name = toName(instance_id, w.name);
+        const EnvProp *prop = nullptr;
+        bool prop_is_const = false;
+        const auto a = properties.find(name);
+        if (a != properties.end()) {
+            prop = &a->second;
+            prop_is_const = a->second.isConst;
+        } else {
+            const auto b = mapped_properties.find(name);
+            if (b == mapped_properties.end()) {
+                THROW exception::InvalidEnvProperty("Environmental property with name '%u:%s' does not exist, "
+                    "in EnvironmentManager::setProperties().",
+                    name.first, name.second.c_str());
+            }
+            prop = &properties.at(b->second.masterProp);
+            prop_is_const = b->second.isConst;
+        }
+        if (prop->type != w.value.type) {
+            THROW exception::InvalidEnvPropertyType("Environmental property ('%u:%s') type (%s) does not match the provided type (%s), "
+                "in EnvironmentManager::setProperties().",
+                name.first, name.second.c_str(), prop->type.name(), w.value.type.name());
+        }
+        if (prop_is_const && !ignoreConst) {
+            THROW exception::ReadOnlyEnvProperty("Environmental property ('%u:%s') is marked as const and cannot be changed, "
+                "in EnvironmentManager::setProperties().",
+                name.first, name.second.c_str());
+        }
+        if (w.index == ALL_ELEMENTS) {
+            if (w.value.elements != prop->elements) {
+                THROW exception::OutOfBoundsException("Length of named environmental property array ('%u:%s') (%u) does not match length of provided value (%u), "
+                    "in EnvironmentManager::setProperties().",
+                    name.first, name.second.c_str(), prop->elements, w.value.elements);
+            }
+            ranges.push_back(OffsetLen(prop->offset, prop->length));
+        } else {
+            if (w.index >= prop->elements || w.value.elements != 1) {
+                THROW exception::OutOfBoundsException("Index(%u) exceeds named environmental property array's ('%u:%s') length (%u), "
+                    "in EnvironmentManager::setProperties().",
+                    w.index, name.first, name.second.c_str(), prop->elements);
+            }
+            const size_t element_size = prop->length / prop->elements;
+            ranges.push_back(OffsetLen(prop->offset + w.index * element_size, element_size));
+        }
+    }
+    // Store data
+    for (size_t i = 0; i < writes.size(); ++i) {
+        memcpy(hc_buffer + ranges[i].first, writes[i].value.ptr, ranges[i].second);
+        // Do rtc too
+        updateRTCValue(toName(instance_id, writes[i].name));
+    }
+    // Set device update flag, once for the whole batch
+    setDeviceRequiresUpdateFlag(instance_id, ranges);
+}
+void EnvironmentManager::setDeviceRequiresUpdateFlag(const unsigned int &instance_id, const ptrdiff_t &offset, const size_t &length) {
     std::unique_lock<std::shared_timed_mutex> deviceRequiresUpdate_lock(deviceRequiresUpdate_mutex);
     // Don't lock mutex here, lock it in the calling function
     // Increment host version
     if (instance_id == UINT_MAX) {
         // Set required version for all, we have defragged
         for (auto &a : deviceRequiresUpdate) {
-            a.second.c_update_required = true;
             a.second.rtc_update_required = true;
         }
     } else {
         // Set individual
-        auto &flags = deviceRequiresUpdate.at(instance_id);
-        flags.c_update_required = true;
-        flags.rtc_update_required = true;
+        deviceRequiresUpdate.at(instance_id).rtc_update_required = true;
+    }
+    if (length) {
+        addDirtyRange(offset, length);
     }
 }
+void EnvironmentManager::setDeviceRequiresUpdateFlag(const unsigned int &instance_id, const std::vector<OffsetLen> &ranges) {
+    std::unique_lock<std::shared_timed_mutex> deviceRequiresUpdate_lock(deviceRequiresUpdate_mutex);
+    // Don't lock mutex here, lock it in the calling function
+    deviceRequiresUpdate.at(instance_id).rtc_update_required = true;
+    for (const auto &r : ranges) {
+        addDirtyRange(r.first, r.second);
+    }
+}
+void EnvironmentManager::addDirtyRange(const ptrdiff_t &offset, const size_t &length) {
+    // Repeatedly setting the same property should not grow the list
+    for (const auto &r : dirty_ranges) {
+        if (r.first <= offset && offset + static_cast<ptrdiff_t>(length) <= r.first + static_cast<ptrdiff_t>(r.second))
+            return;
+    }
+    dirty_ranges.push_back(OffsetLen(offset, length));
+}
 void EnvironmentManager::updateDevice(const unsigned int &instance_id) {
     // Lock shared mutex of mutex in calling method first!!!
     // Device must be init first
     assert(deviceInitialised);
+    {
+        // Most calls have nothing to do, so check without blocking other instances
+        std::shared_lock<std::shared_timed_mutex> deviceRequiresUpdate_lock(deviceRequiresUpdate_mutex);
+        const auto &flags = deviceRequiresUpdate.at(instance_id);
+        if (dirty_ranges.empty() && !flags.rtc_update_required && !flags.curve_registration_required)
+            return;
+    }
     std::unique_lock<std::shared_timed_mutex> deviceRequiresUpdate_lock(deviceRequiresUpdate_mutex);
     NVTX_RANGE("EnvironmentManager::updateDevice()");
     auto &flags = deviceRequiresUpdate.at(instance_id);
-    auto &c_update_required = flags.c_update_required;
     auto &rtc_update_required = flags.rtc_update_required;
     auto &curve_registration_required = flags.curve_registration_required;
-    if (c_update_required) {
-        // Store data
-        gpuErrchk(cudaMemcpy(reinterpret_cast<void*>(const_cast<char*>(c_buffer)), reinterpret_cast<void*>(const_cast<char*>(hc_buffer)), MAX_BUFFER_SIZE, cudaMemcpyHostToDevice));
-        // Update C update flag for all instances
-        for (auto &a : deviceRequiresUpdate) {
-            a.second.c_update_required = false;
+    if (!dirty_ranges.empty()) {
+        // Upload only the changed bytes, merging ranges which overlap or are close together
+        std::sort(dirty_ranges.begin(), dirty_ranges.end());
+        ptrdiff_t copy_begin = dirty_ranges.front().first;
+        ptrdiff_t copy_end = copy_begin + dirty_ranges.front().second;
+        for (size_t i = 1; i <= dirty_ranges.size(); ++i) {
+            if (i < dirty_ranges.size() && dirty_ranges[i].first <= copy_end + static_cast<ptrdiff_t>(DIRTY_RANGE_MERGE_GAP)) {
+                copy_end = std::max(copy_end, dirty_ranges[i].first + static_cast<ptrdiff_t>(dirty_ranges[i].second));
+                continue;
+            }
+            // Store data
+            gpuErrchk(cudaMemcpy(reinterpret_cast<void*>(const_cast<char*>(c_buffer + copy_begin)), reinterpret_cast<void*>(const_cast<char*>(hc_buffer + copy_begin)), copy_end - copy_begin, cudaMemcpyHostToDevice));
+            if (i < dirty_ranges.size()) {
+                copy_begin = dirty_ranges[i].first;
+                copy_end = copy_begin + dirty_ranges[i].second;
+            }
         }
+        // c_buffer is shared, so this clears the pending update for all instances
+        dirty_ranges.clear();
     }
     if (rtc_update_required) {
         // RTC is nolonger updated here, it's always updated before the CurveRTCHost is pushed to device.
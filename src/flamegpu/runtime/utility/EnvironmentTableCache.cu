@@ -0,0 +1,115 @@
+#include "flamegpu/runtime/utility/EnvironmentTableCache.h"
+
+#include <cuda_runtime.h>
+#include <sys/stat.h>
+
+#include "flamegpu/gpu/detail/CUDAErrorChecking.cuh"
+#include "flamegpu/util/detail/MappedFile.h"
+#include "flamegpu/util/nvtx.h"
+
+namespace flamegpu {
+namespace detail {
+
+std::mutex EnvironmentTableCache::instance_mutex;
+
+namespace {
+/**
+ * Returns the length and last modification time of a file
+ * @param file_path Path to the file
+ * @param length Returns the length of the file in bytes
+ * @param modified Returns the last modification time of the file
+ * @return false if the file could not be found
+ */
+bool statFile(const std::string &file_path, size_t &length, int64_t &modified) {
+#ifdef _MSC_VER
+    struct _stat64 s;
+    if (_stat64(file_path.c_str(), &s))
+        return false;
+#else
+    struct stat s;
+    if (stat(file_path.c_str(), &s))
+        return false;
+#endif
+    length = static_cast<size_t>(s.st_size);
+#ifdef __linux__
+    // Nanosecond resolution, so a file rewritten within the same second is still detected
+    modified = static_cast<int64_t>(s.st_mtim.tv_sec) * 1000000000 + s.st_mtim.tv_nsec;
+#else
+    modified = static_cast<int64_t>(s.st_mtime);
+#endif
+    return true;
+}
+}  // namespace
+
+EnvironmentTable::~EnvironmentTable() {
+    if (d_ptr) {
+        int t_device_id = -1;
+        gpuErrchk(cudaGetDevice(&t_device_id));
+        if (t_device_id != device_id) {
+            gpuErrchk(cudaSetDevice(device_id));
+        }
+        gpuErrchk(cudaFree(d_ptr));
+        if (t_device_id != device_id) {
+            gpuErrchk(cudaSetDevice(t_device_id));
+        }
+    }
+}
+
+std::shared_ptr<const EnvironmentTable> EnvironmentTableCache::acquire(const std::string &file_path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    // Key by device too, as the device may have changed since this instance was fetched
+    int device_id = -1;
+    gpuErrchk(cudaGetDevice(&device_id));
+    auto &entry = tables[{device_id, file_path}];
+    size_t length = 0;
+    int64_t modified = 0;
+    const bool found = statFile(file_path, length, modified);
+    if (auto table = entry.lock()) {
+        // Only reuse the upload if the file is unchanged, simulations still using a stale upload keep their reference
+        if (found && table->length == length && table->modified == modified)
+            return table;
+    }
+    NVTX_RANGE("EnvironmentTableCache::acquire()");
+    // Copy straight from the mapped pages, the file is never parsed or staged in a separate host buffer
+    util::detail::MappedFile file(file_path);
+    void *d_ptr = nullptr;
+    gpuErrchk(cudaMalloc(&d_ptr, file.size()));
+    gpuErrchk(cudaMemcpy(d_ptr, file.data(), file.size(), cudaMemcpyHostToDevice));
+    auto table = std::make_shared<EnvironmentTable>(d_ptr, file.size(), device_id, modified);
+    entry = table;
+    return table;
+}
+
+bool EnvironmentTableCache::hasResidentTables() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto &t : tables) {
+        if (!t.second.expired())
+            return true;
+    }
+    return false;
+}
+
+void EnvironmentTableCache::purge() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &t : tables) {
+        if (auto table = t.second.lock()) {
+            table->d_ptr = nullptr;
+        }
+    }
+    tables.clear();
+}
+
+EnvironmentTableCache &EnvironmentTableCache::getInstance() {
+    std::lock_guard<std::mutex> lock(instance_mutex);
+    static std::map<int, std::unique_ptr<EnvironmentTableCache>> instances = {};  // Instantiated on first use.
+    int device_id = -1;
+    gpuErrchk(cudaGetDevice(&device_id));
+    // Can't use operator[] here, constructor is private
+    const auto f = instances.find(device_id);
+    if (f != instances.end())
+        return *f->second;
+    return *(instances.emplace(device_id, std::unique_ptr<EnvironmentTableCache>(new EnvironmentTableCache())).first->second);
+}
+
+}  // namespace detail
+}  // namespace flamegpu
@@ -2,8 +2,24 @@
 
 namespace flamegpu {
 
-HostEnvironment::HostEnvironment(const unsigned int &_instance_id)
+HostEnvironment::HostEnvironment(const unsigned int &_instance_id, CUDAMacroEnvironment &_macro_env)
     : env_mgr(EnvironmentManager::getInstance())
+    , macro_env(_macro_env)
     , instance_id(_instance_id) { }
 
+std::vector<float> HostEnvironment::getFieldData(const std::string &name) const {
+    std::vector<float> rtn(macro_env.getFieldInfo(name).cellCount());
+    macro_env.getFieldData(name, rtn.data());
+    return rtn;
+}
+void HostEnvironment::setFieldData(const std::string &name, const std::vector<float> &data) const {
+    const CUDAMacroEnvironment::FieldProp &field = macro_env.getFieldInfo(name);
+    if (data.size() != field.cellCount()) {
+        THROW exception::InvalidArgument("Environment field ('%s') contains %u cells, but %u were provided, "
+            "in HostEnvironment::setFieldData().",
+            name.c_str(), field.cellCount(), static_cast<unsigned int>(data.size()));
+    }
+    macro_env.setFieldData(name, data.data());
+}
+
 }  // namespace flamegpu
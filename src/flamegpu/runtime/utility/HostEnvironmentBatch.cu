@@ -0,0 +1,19 @@
+#include "flamegpu/runtime/utility/HostEnvironmentBatch.cuh"
+
+namespace flamegpu {
+
+void HostEnvironmentBatch::commit() {
+    // Clear the batch even if validation fails, the writes were not applied so they should not be retried
+    std::vector<EnvironmentManager::PropertyWrite> t_writes;
+    t_writes.swap(writes);
+    env_mgr.setProperties(instance_id, t_writes, ignore_const);
+}
+
+void HostEnvironmentBatch::checkName(const std::string &name) {
+    if (!name.empty() && name[0] == '_') {
+        THROW exception::ReservedName("Environment property names cannot begin with '_', this is reserved for internal usage, "
+            "in HostEnvironmentBatch::setProperty().");
+    }
+}
+
+}  // namespace flamegpu
@@ -4,6 +4,7 @@
 
 #include "flamegpu/model/ModelData.h"
 #include "flamegpu/gpu/CUDASimulation.h"
+#include "flamegpu/runtime/HostAPI.h"
 #include "flamegpu/sim/RunPlanVector.h"
 
 #ifdef _MSC_VER
@@ -67,12 +68,6 @@ void SimRunner::start() {
     // While there are still plans to process
     while ((this->run_id = next_run++) < plans.size()) {
         try {
-            // Update environment (this might be worth moving into CUDASimulation)
-            auto &prop_map = model->environment->properties;
-            for (auto &ovrd : plans[run_id].property_overrides) {
-                auto &prop = prop_map.at(ovrd.first);
-                memcpy(prop.data.ptr, ovrd.second.ptr, prop.data.length);
-            }
             // Set simulation device
             std::unique_ptr<CUDASimulation> simulation = std::unique_ptr<CUDASimulation>(new CUDASimulation(model));
             // Copy steps and seed from runplan
@@ -82,6 +77,17 @@ void SimRunner::start() {
             simulation->SimulationConfig().timing = false;
             simulation->CUDAConfig().device_id = this->device_id;
             simulation->applyConfig();
+            // Update environment, as a single batch so the device copy is only updated once
+            if (!plans[run_id].property_overrides.empty()) {
+                simulation->initialiseSingletons();
+                HostEnvironmentBatch batch = simulation->host_api->environment.batch();
+                // RunPlan validated the overrides against the model, and may override const properties
+                batch.ignore_const = true;
+                for (const auto &ovrd : plans[run_id].property_overrides) {
+                    batch.stageProperty(ovrd.first, ovrd.second);
+                }
+                batch.commit();
+            }
             // Set the step config directly, to bypass validation
             simulation->step_log_config = step_log_config;
             simulation->exit_log_config = exit_log_config;
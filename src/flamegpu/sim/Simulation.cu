@@ -56,8 +56,10 @@ void Simulation::applyConfig() {
         }
 
         env_init.clear();
+        macro_env_init.clear();
         const auto env_desc = model->environment->getPropertiesMap();  // For some reason this method returns a copy, not a reference
-        io::StateReader *read__ = io::StateReaderFactory::createReader(model->name, env_desc, env_init, pops, config.input_file.c_str(), this);
+        const auto &macro_env_desc = model->environment->getMacroPropertiesMap();
+        io::StateReader *read__ = io::StateReaderFactory::createReader(model->name, env_desc, env_init, macro_env_desc, macro_env_init, pops, config.input_file.c_str(), this);
         if (read__) {
             read__->parse();
             for (auto &agent : pops) {
@@ -161,8 +163,10 @@ int Simulation::checkArgs(int argc, const char** argv) {
                     }
                 }
                 env_init.clear();
+                macro_env_init.clear();
                 const auto env_desc = model->environment->getPropertiesMap();  // For some reason this method returns a copy, not a reference
-                io::StateReader *read__ = io::StateReaderFactory::createReader(model->name, env_desc, env_init, pops, config.input_file.c_str(), this);
+                const auto &macro_env_desc = model->environment->getMacroPropertiesMap();
+                io::StateReader *read__ = io::StateReaderFactory::createReader(model->name, env_desc, env_init, macro_env_desc, macro_env_init, pops, config.input_file.c_str(), this);
                 if (read__) {
                     read__->parse();
                     for (auto &agent : pops) {
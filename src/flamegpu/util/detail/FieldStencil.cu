@@ -0,0 +1,29 @@
+#include "flamegpu/util/detail/FieldStencil.cuh"
+
+#include "flamegpu/gpu/detail/CUDAErrorChecking.cuh"
+
+namespace flamegpu {
+namespace util {
+namespace detail {
+
+namespace {
+__global__ void fieldStencilKernel(const FieldStencil stencil, const float *__restrict__ src, float *__restrict__ dst) {
+    const unsigned int index = blockIdx.x * blockDim.x + threadIdx.x;
+    if (index < stencil.cellCount()) {
+        dst[index] = stencil.apply(src, index);
+    }
+}
+}  // namespace
+
+void fieldStencilDevice(const FieldStencil &stencil, const float *d_src, float *d_dst, cudaStream_t stream) {
+    int blockSize = 0;  // The launch configurator returned block size
+    int minGridSize = 0;  // The minimum grid size needed to achieve the // maximum occupancy for a full device // launch
+    gpuErrchk(cudaOccupancyMaxPotentialBlockSize(&minGridSize, &blockSize, fieldStencilKernel, 0, stencil.cellCount()));
+    const unsigned int gridSize = (stencil.cellCount() + blockSize - 1) / blockSize;
+    fieldStencilKernel<<<gridSize, blockSize, 0, stream>>>(stencil, d_src, d_dst);
+    gpuErrchkLaunch();
+}
+
+}  // namespace detail
+}  // namespace util
+}  // namespace flamegpu
@@ -0,0 +1,94 @@
+#include "flamegpu/util/detail/MappedFile.h"
+
+#ifdef _MSC_VER
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "flamegpu/exception/FLAMEGPUException.h"
+
+namespace flamegpu {
+namespace util {
+namespace detail {
+
+#ifdef _MSC_VER
+MappedFile::MappedFile(const std::string &file_path)
+    : ptr(nullptr)
+    , length(0)
+    , file_handle(INVALID_HANDLE_VALUE)
+    , mapping_handle(nullptr) {
+    file_handle = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE) {
+        THROW exception::InvalidFilePath("Unable to open file '%s', "
+            "in MappedFile::MappedFile().",
+            file_path.c_str());
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle, &file_size) || file_size.QuadPart == 0) {
+        CloseHandle(file_handle);
+        THROW exception::InvalidInputFile("File '%s' is empty, "
+            "in MappedFile::MappedFile().",
+            file_path.c_str());
+    }
+    length = static_cast<size_t>(file_size.QuadPart);
+    mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle) {
+        ptr = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    }
+    if (!ptr) {
+        if (mapping_handle)
+            CloseHandle(mapping_handle);
+        CloseHandle(file_handle);
+        THROW exception::InvalidInputFile("Unable to memory map file '%s', "
+            "in MappedFile::MappedFile().",
+            file_path.c_str());
+    }
+}
+MappedFile::~MappedFile() {
+    UnmapViewOfFile(ptr);
+    CloseHandle(mapping_handle);
+    CloseHandle(file_handle);
+}
+#else
+MappedFile::MappedFile(const std::string &file_path)
+    : ptr(nullptr)
+    , length(0) {
+    const int fd = open(file_path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        THROW exception::InvalidFilePath("Unable to open file '%s', "
+            "in MappedFile::MappedFile().",
+            file_path.c_str());
+    }
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) == -1 || file_stat.st_size == 0) {
+        close(fd);
+        THROW exception::InvalidInputFile("File '%s' is empty, "
+            "in MappedFile::MappedFile().",
+            file_path.c_str());
+    }
+    length = static_cast<size_t>(file_stat.st_size);
+    void *t_ptr = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping remains valid after the descriptor is closed
+    close(fd);
+    if (t_ptr == MAP_FAILED) {
+        THROW exception::InvalidInputFile("Unable to memory map file '%s', "
+            "in MappedFile::MappedFile().",
+            file_path.c_str());
+    }
+    // The file is only read once, front to back, when it is uploaded
+    madvise(t_ptr, length, MADV_SEQUENTIAL);
+    ptr = t_ptr;
+}
+MappedFile::~MappedFile() {
+    munmap(const_cast<void*>(ptr), length);
+}
+#endif
+
+}  // namespace detail
+}  // namespace util
+}  // namespace flamegpu
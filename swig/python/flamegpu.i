@@ -77,6 +77,7 @@ using namespace flamegpu; // @todo - is this required? Ideally it shouldn't be,
 %template(UInt64Vector) std::vector<uint64_t>;
 %template(FloatVector) std::vector<float>;
 %template(DoubleVector) std::vector<double>;
+%template(StringVector) std::vector<std::string>;
 //%template(BoolVector) std::vector<bool>;
 //%template(DoubleVector) std::vector<double>;
 
@@ -328,6 +329,8 @@ class FLAMEGPURuntimeException : public std::exception {
 %ignore flamegpu::AgentVector::getVariableMetaData;
 %ignore flamegpu::AgentVector::data;
 
+%ignore flamegpu::PopulationGenerator::Generator;
+
 %ignore flamegpu::VarOffsetStruct; // not required but defined in HostNewAgentAPI
 
 // Disable functions which use C++ iterators/type_index
@@ -386,10 +389,16 @@ class FLAMEGPURuntimeException : public std::exception {
     %rename (MessageSpatial2D_Description) flamegpu::MessageSpatial2D::Description;
     %rename (MessageSpatial3D_Description) flamegpu::MessageSpatial3D::Description;
     %rename (MessageSpatial3D_MetaData) flamegpu::MessageSpatial3D::MetaData;
+    %rename (MessageSparseSpatial3D_Description) flamegpu::MessageSparseSpatial3D::Description;
+    %rename (MessageSparseSpatial3D_MetaData) flamegpu::MessageSparseSpatial3D::MetaData;
+    %rename (MessageKNN_Description) flamegpu::MessageKNN::Description;
+    %rename (MessageKNN_MetaData) flamegpu::MessageKNN::MetaData;
     %rename (MessageArray_Description) flamegpu::MessageArray::Description;
     %rename (MessageArray2D_Description) flamegpu::MessageArray2D::Description;
     %rename (MessageArray3D_Description) flamegpu::MessageArray3D::Description;
     %rename (MessageBucket_Description) flamegpu::MessageBucket::Description;
+    %rename (MessageGraph_Description) flamegpu::MessageGraph::Description;
+    %rename (MessageGraph_Topology) flamegpu::MessageGraph::Topology;
 
     %rename (CUDAEnsembleConfig) flamegpu::CUDAEnsemble::EnsembleConfig;
 %feature("flatnested", ""); // flat nested off
@@ -468,6 +477,10 @@ class ModelVis;
 %include "flamegpu/runtime/messaging/MessageSpatial2D/MessageSpatial2DHost.h"
 %include "flamegpu/runtime/messaging/MessageSpatial3D.h"
 %include "flamegpu/runtime/messaging/MessageSpatial3D/MessageSpatial3DHost.h"
+%include "flamegpu/runtime/messaging/MessageSparseSpatial3D.h"
+%include "flamegpu/runtime/messaging/MessageSparseSpatial3D/MessageSparseSpatial3DHost.h"
+%include "flamegpu/runtime/messaging/MessageKNN.h"
+%include "flamegpu/runtime/messaging/MessageKNN/MessageKNNHost.h"
 %include "flamegpu/runtime/messaging/MessageArray.h"
 %include "flamegpu/runtime/messaging/MessageArray/MessageArrayHost.h"
 %include "flamegpu/runtime/messaging/MessageArray2D.h"
@@ -476,6 +489,8 @@ class ModelVis;
 %include "flamegpu/runtime/messaging/MessageArray3D/MessageArray3DHost.h"
 %include "flamegpu/runtime/messaging/MessageBucket.h"
 %include "flamegpu/runtime/messaging/MessageBucket/MessageBucketHost.h"
+%include "flamegpu/runtime/messaging/MessageGraph.h"
+%include "flamegpu/runtime/messaging/MessageGraph/MessageGraphHost.h"
 %feature("flatnested", "");     // flat nested off
 
 %include "flamegpu/model/DependencyNode.h"
@@ -512,9 +527,11 @@ class ModelVis;
 %include "flamegpu/pop/AgentInstance.h"
 %include "flamegpu/pop/DeviceAgentVector_impl.h"
 %include "flamegpu/pop/DeviceAgentVector.h"
+%include "flamegpu/pop/PopulationGenerator.h"
 
 // Must wrap these prior to HostAPI where they are used to avoid issues with no default constructors etc.
 %include "flamegpu/runtime/utility/HostRandom.cuh"
+%include "flamegpu/runtime/utility/HostEnvironmentBatch.cuh"
 %include "flamegpu/runtime/utility/HostEnvironment.cuh"
 
 %include "flamegpu/runtime/HostNewAgentAPI.h"
@@ -648,6 +665,8 @@ TEMPLATE_VARIABLE_INSTANTIATE_ID(getProperty, flamegpu::HostEnvironment::getProp
 TEMPLATE_VARIABLE_INSTANTIATE_ID(getPropertyArray, flamegpu::HostEnvironment::getPropertyArray)
 TEMPLATE_VARIABLE_INSTANTIATE_ID(setProperty, flamegpu::HostEnvironment::setProperty)
 TEMPLATE_VARIABLE_INSTANTIATE_ID(setPropertyArray, flamegpu::HostEnvironment::setPropertyArray)
+TEMPLATE_VARIABLE_INSTANTIATE_ID(setProperty, flamegpu::HostEnvironmentBatch::setProperty)
+TEMPLATE_VARIABLE_INSTANTIATE_ID(setPropertyArray, flamegpu::HostEnvironmentBatch::setPropertyArray)
 
 // Instantiate template versions of host agent functions from the API
 TEMPLATE_VARIABLE_INSTANTIATE_ID(getVariable, flamegpu::HostNewAgentAPI::getVariable)
@@ -679,6 +698,14 @@ TEMPLATE_VARIABLE_INSTANTIATE(setPropertyUniformRandomDistribution, flamegpu::Ru
 TEMPLATE_VARIABLE_INSTANTIATE_FLOATS(setPropertyNormalRandomDistribution, flamegpu::RunPlanVector::setPropertyNormalRandom)
 TEMPLATE_VARIABLE_INSTANTIATE_FLOATS(setPropertyLogNormalRandomDistribution, flamegpu::RunPlanVector::setPropertyLogNormalRandom)
 
+// Instantiate template versions of PopulationGenerator functions from the API
+TEMPLATE_VARIABLE_INSTANTIATE(uniform, flamegpu::PopulationGenerator::uniform)
+TEMPLATE_VARIABLE_INSTANTIATE_FLOATS(normal, flamegpu::PopulationGenerator::normal)
+TEMPLATE_VARIABLE_INSTANTIATE_FLOATS(uniformBox, flamegpu::PopulationGenerator::uniformBox)
+TEMPLATE_VARIABLE_INSTANTIATE_FLOATS(normalBox, flamegpu::PopulationGenerator::normalBox)
+TEMPLATE_VARIABLE_INSTANTIATE_FLOATS(lattice, flamegpu::PopulationGenerator::lattice)
+TEMPLATE_VARIABLE_INSTANTIATE_INTS(lattice, flamegpu::PopulationGenerator::lattice)
+
 // Instantiate template versions of AgentLoggingConfig functions from the API
 TEMPLATE_VARIABLE_INSTANTIATE(logMean, flamegpu::AgentLoggingConfig::logMean)
 TEMPLATE_VARIABLE_INSTANTIATE(logMin, flamegpu::AgentLoggingConfig::logMin)
@@ -699,35 +726,47 @@ TEMPLATE_VARIABLE_INSTANTIATE(getSum, flamegpu::AgentLogFrame::getSum)
 %template(newMessageBruteForce) flamegpu::ModelDescription::newMessage<flamegpu::MessageBruteForce>;
 %template(newMessageSpatial2D) flamegpu::ModelDescription::newMessage<flamegpu::MessageSpatial2D>;
 %template(newMessageSpatial3D) flamegpu::ModelDescription::newMessage<flamegpu::MessageSpatial3D>;
+%template(newMessageSparseSpatial3D) flamegpu::ModelDescription::newMessage<flamegpu::MessageSparseSpatial3D>;
+%template(newMessageKNN) flamegpu::ModelDescription::newMessage<flamegpu::MessageKNN>;
 %template(newMessageArray) flamegpu::ModelDescription::newMessage<flamegpu::MessageArray>;
 %template(newMessageArray2D) flamegpu::ModelDescription::newMessage<flamegpu::MessageArray2D>;
 %template(newMessageArray3D) flamegpu::ModelDescription::newMessage<flamegpu::MessageArray3D>;
 %template(newMessageBucket) flamegpu::ModelDescription::newMessage<flamegpu::MessageBucket>;
+%template(newMessageGraph) flamegpu::ModelDescription::newMessage<flamegpu::MessageGraph>;
 
 %template(getMessageBruteForce) flamegpu::ModelDescription::getMessage<MessageBruteForce>;
 %template(getMessageSpatial2D) flamegpu::ModelDescription::getMessage<MessageSpatial2D>;
 %template(getMessageSpatial3D) flamegpu::ModelDescription::getMessage<MessageSpatial3D>;
+%template(getMessageSparseSpatial3D) flamegpu::ModelDescription::getMessage<MessageSparseSpatial3D>;
+%template(getMessageKNN) flamegpu::ModelDescription::getMessage<MessageKNN>;
 %template(getMessageArray) flamegpu::ModelDescription::getMessage<MessageArray>;
 %template(getMessageArray2D) flamegpu::ModelDescription::getMessage<MessageArray2D>;
 %template(getMessageArray3D) flamegpu::ModelDescription::getMessage<MessageArray3D>;
 %template(getMessageBucket) flamegpu::ModelDescription::getMessage<MessageBucket>;
+%template(getMessageGraph) flamegpu::ModelDescription::getMessage<MessageGraph>;
 
 
 // Instantiate template versions of message functions from the API
 TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariable, flamegpu::MessageBruteForce::Description::newVariable)
 TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariable, flamegpu::MessageSpatial2D::Description::newVariable)
 TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariable, flamegpu::MessageSpatial3D::Description::newVariable)
+TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariable, flamegpu::MessageSparseSpatial3D::Description::newVariable)
+TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariable, flamegpu::MessageKNN::Description::newVariable)
 TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariable, flamegpu::MessageArray::Description::newVariable)
 TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariable, flamegpu::MessageArray2D::Description::newVariable)
 TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariable, flamegpu::MessageArray3D::Description::newVariable)
 TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariable, flamegpu::MessageBucket::Description::newVariable)
+TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariable, flamegpu::MessageGraph::Description::newVariable)
 TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariableArray, flamegpu::MessageBruteForce::Description::newVariableArray)
 TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariableArray, flamegpu::MessageSpatial2D::Description::newVariableArray)
 TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariableArray, flamegpu::MessageSpatial3D::Description::newVariableArray)
+TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariableArray, flamegpu::MessageSparseSpatial3D::Description::newVariableArray)
+TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariableArray, flamegpu::MessageKNN::Description::newVariableArray)
 TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariableArray, flamegpu::MessageArray::Description::newVariableArray)
 TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariableArray, flamegpu::MessageArray2D::Description::newVariableArray)
 TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariableArray, flamegpu::MessageArray3D::Description::newVariableArray)
 TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariableArray, flamegpu::MessageBucket::Description::newVariableArray)
+TEMPLATE_VARIABLE_INSTANTIATE_ID(newVariableArray, flamegpu::MessageGraph::Description::newVariableArray)
 
 // Instantiate template versions of host random functions from the API
 
@@ -129,6 +129,8 @@ class AgentRandomTest(TestCase):
         # Test Model 3
         # Different seed produces different random numbers
         results2.clear()
+        # Agent random is keyed by agent ID, so reset the ID counter to reissue the IDs of Test Model 1
+        cudaSimulation.reset()
         # Seed random
         cudaSimulation.initialise(args_1)
         cudaSimulation.setPopulationData(init_population)
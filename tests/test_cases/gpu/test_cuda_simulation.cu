@@ -604,6 +604,39 @@ TEST(TestCUDASimulation, AgentID_MultipleStatesUniqueIDs) {
     ASSERT_EQ(ids_copy.size(), pop_out_a.size() + pop_out_b.size());
 }
 
+FLAMEGPU_AGENT_FUNCTION(IncrementX, MessageNone, MessageNone) {
+    FLAMEGPU->setVariable<unsigned int>("x", FLAMEGPU->getVariable<unsigned int>("x") + 1);
+    return ALIVE;
+}
+FLAMEGPU_HOST_FUNCTION(IncrementCounterLayer) {
+    externalCounter++;
+}
+TEST(TestCUDASimulation, LayerExecutionInterval) {
+    ModelDescription m(MODEL_NAME);
+    AgentDescription &a = m.newAgent(AGENT_NAME);
+    a.newVariable<unsigned int>("x", 0);
+    AgentFunctionDescription &f = a.newFunction(FUNCTION_NAME, IncrementX);
+    // Agent function layer executes on steps 1, 4 and 7
+    LayerDescription &l1 = m.newLayer();
+    l1.addAgentFunction(f);
+    l1.setExecutionInterval(3, 1);
+    // Host function layer executes on steps 0 and 4
+    LayerDescription &l2 = m.newLayer();
+    l2.addHostFunction(IncrementCounterLayer);
+    l2.setExecutionInterval(4);
+    AgentVector pop(a, AGENT_COUNT);
+    CUDASimulation c(m);
+    c.SimulationConfig().steps = 8;
+    c.setPopulationData(pop);
+    externalCounter = 0;
+    c.simulate();
+    c.getPopulationData(pop);
+    for (const auto &ai : pop) {
+        EXPECT_EQ(ai.getVariable<unsigned int>("x"), 3u);
+    }
+    EXPECT_EQ(externalCounter, 2);
+}
+
 }  // namespace test_cuda_simulation
 }  // namespace tests
 }  // namespace flamegpu
@@ -391,5 +391,42 @@ TEST(IOTest2, AgentID_FileInput_IDCollision) {
     // Cleanup
     ASSERT_EQ(::remove(JSON_FILE_NAME), 0);
 }
+// Const environment properties can be loaded from an exported file
+float const_env_loaded = 0.0f;
+FLAMEGPU_HOST_FUNCTION(ReadConstEnv) {
+    const_env_loaded = FLAMEGPU->environment.getProperty<float>("const_float");
+}
+void runConstEnvExportImport(const char *file_name) {
+    {
+        ModelDescription model("test_constenv");
+        model.Environment().newProperty<float>("const_float", 12.0f, true);
+        model.newAgent("agent");
+        model.newLayer().addHostFunction(DoNothing);
+        CUDASimulation sim(model);
+        sim.step();
+        sim.exportData(file_name);
+    }
+    {
+        // Same model, but with a different default for the const property
+        ModelDescription model("test_constenv");
+        model.Environment().newProperty<float>("const_float", 3.0f, true);
+        model.newAgent("agent");
+        model.newLayer().addHostFunction(ReadConstEnv);
+        CUDASimulation sim(model);
+        sim.SimulationConfig().input_file = file_name;
+        EXPECT_NO_THROW(sim.applyConfig());
+        const_env_loaded = 0.0f;
+        EXPECT_NO_THROW(sim.step());
+        EXPECT_EQ(const_env_loaded, 12.0f);
+    }
+    // Cleanup
+    ASSERT_EQ(::remove(file_name), 0);
+}
+TEST(IOTest2, ConstEnv_JSON_ExportImport) {
+    runConstEnvExportImport(JSON_FILE_NAME);
+}
+TEST(IOTest2, ConstEnv_XML_ExportImport) {
+    runConstEnvExportImport(XML_FILE_NAME);
+}
 }  // namespace test_io
 }  // namespace flamegpu
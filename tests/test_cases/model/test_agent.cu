@@ -180,6 +180,26 @@ TEST(AgentDescriptionTest, agent_outputs) {
     f2.setAgentOutput(b);
     EXPECT_EQ(a.getAgentOutputsCount(), 1u);
 }
+TEST(AgentDescriptionTest, sleep_enabled) {
+    ModelDescription m(MODEL_NAME);
+    AgentDescription &a = m.newAgent(AGENT_NAME1);
+    const ModelData::size_type var_count = a.getVariablesCount();
+    EXPECT_FALSE(a.isSleepEnabled());
+    EXPECT_FALSE(a.hasVariable(WAKE_STEP_VARIABLE_NAME));
+    // Enabling sleep adds the internal wake step variable
+    a.setSleepEnabled(true);
+    EXPECT_TRUE(a.isSleepEnabled());
+    EXPECT_TRUE(a.hasVariable(WAKE_STEP_VARIABLE_NAME));
+    EXPECT_EQ(a.getVariableType(WAKE_STEP_VARIABLE_NAME), std::type_index(typeid(unsigned int)));
+    EXPECT_EQ(a.getVariablesCount(), var_count + 1);
+    // Enabling twice has no further effect
+    a.setSleepEnabled(true);
+    EXPECT_EQ(a.getVariablesCount(), var_count + 1);
+    // Disabling removes it
+    a.setSleepEnabled(false);
+    EXPECT_FALSE(a.isSleepEnabled());
+    EXPECT_EQ(a.getVariablesCount(), var_count);
+}
 TEST(AgentDescriptionTest, reserved_name) {
     ModelDescription m(MODEL_NAME);
     AgentDescription &a = m.newAgent(AGENT_NAME1);
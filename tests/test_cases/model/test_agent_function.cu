@@ -217,6 +217,63 @@ TEST(AgentFunctionDescriptionTest, AllowAgentDeath) {
     EXPECT_FALSE(f.getAllowAgentDeath());
     EXPECT_FALSE(f.AllowAgentDeath());
 }
+TEST(AgentFunctionDescriptionTest, AgentOutputBirthRate) {
+    ModelDescription _m(MODEL_NAME);
+    AgentDescription &a = _m.newAgent(AGENT_NAME);
+    AgentFunctionDescription &f = a.newFunction(FUNCTION_NAME1, agent_fn1);
+    // Begins as full size
+    EXPECT_EQ(f.getAgentOutputBirthRate(), 1.0f);
+    // Can be updated
+    f.setAgentOutputBirthRate(0.25f);
+    EXPECT_EQ(f.getAgentOutputBirthRate(), 0.25f);
+    // Must be in range (0, 1]
+    EXPECT_THROW(f.setAgentOutputBirthRate(0.0f), exception::InvalidArgument);
+    EXPECT_THROW(f.setAgentOutputBirthRate(-0.5f), exception::InvalidArgument);
+    EXPECT_THROW(f.setAgentOutputBirthRate(1.5f), exception::InvalidArgument);
+    EXPECT_EQ(f.getAgentOutputBirthRate(), 0.25f);
+}
+
+TEST(AgentFunctionDescriptionTest, IncludeSleeping) {
+    ModelDescription _m(MODEL_NAME);
+    AgentDescription &a = _m.newAgent(AGENT_NAME);
+    AgentFunctionDescription &f = a.newFunction(FUNCTION_NAME1, agent_fn1);
+    EXPECT_FALSE(f.getIncludeSleeping());
+    f.setIncludeSleeping(true);
+    EXPECT_TRUE(f.getIncludeSleeping());
+    f.setIncludeSleeping(false);
+    EXPECT_FALSE(f.getIncludeSleeping());
+}
+TEST(AgentFunctionDescriptionTest, MessageInputVariables) {
+    ModelDescription _m(MODEL_NAME);
+    AgentDescription &a = _m.newAgent(AGENT_NAME);
+    MessageBruteForce::Description &m = _m.newMessage(MESSAGE_NAME1);
+    m.newVariable<float>(VARIABLE_NAME1);
+    m.newVariable<int>(VARIABLE_NAME2);
+    m.newVariable<int>(VARIABLE_NAME3);
+    MessageBruteForce::Description &m2 = _m.newMessage(MESSAGE_NAME2);
+    AgentFunctionDescription &f = a.newFunction(FUNCTION_NAME1, agent_fn1);
+    // Requires message input
+    EXPECT_THROW(f.setMessageInputVariables({ VARIABLE_NAME1 }), exception::InvalidMessageName);
+    f.setMessageInput(m);
+    // Begins undeclared
+    EXPECT_FALSE(f.hasMessageInputVariables());
+    EXPECT_TRUE(f.getMessageInputVariables().empty());
+    // Can be set
+    f.setMessageInputVariables({ VARIABLE_NAME3, VARIABLE_NAME1 });
+    EXPECT_TRUE(f.hasMessageInputVariables());
+    const std::vector<std::string> vars = f.getMessageInputVariables();
+    ASSERT_EQ(vars.size(), 2u);
+    EXPECT_EQ(vars[0], VARIABLE_NAME1);
+    EXPECT_EQ(vars[1], VARIABLE_NAME3);
+    // Variables must belong to the message input
+    EXPECT_THROW(f.setMessageInputVariables({ VARIABLE_NAME1, "missing" }), exception::InvalidMessageVar);
+    EXPECT_EQ(f.getMessageInputVariables().size(), 2u);
+    // Updating the message input clears the declaration
+    f.setMessageInput(m2);
+    EXPECT_FALSE(f.hasMessageInputVariables());
+    EXPECT_TRUE(f.getMessageInputVariables().empty());
+    EXPECT_THROW(f.setMessageInputVariables({ VARIABLE_NAME1 }), exception::InvalidMessageVar);
+}
 
 TEST(AgentFunctionDescriptionTest, MessageInput_WrongModel) {
     ModelDescription _m(MODEL_NAME);
@@ -359,4 +359,73 @@ TEST(EnvironmentDescriptionTest, reserved_name) {
     EXPECT_THROW((ed.*add)("_", { 1, 2 }, false), exception::ReservedName);
     EXPECT_THROW((ed.*set)("_", { 1, 2 }), exception::ReservedName);
 }
+
+TEST(EnvironmentDescriptionTest, MacroProperty) {
+    EnvironmentDescription ed;
+    EXPECT_NO_THROW((ed.newMacroProperty<float, 2, 3, 4, 5>("a")));
+    EXPECT_NO_THROW(ed.newMacroProperty<int>("b"));
+    const auto &macro_map = ed.getMacroPropertiesMap();
+    ASSERT_EQ(macro_map.size(), 2u);
+    EXPECT_EQ(macro_map.at("a").type, std::type_index(typeid(float)));
+    EXPECT_EQ(macro_map.at("a").type_size, sizeof(float));
+    EXPECT_EQ(macro_map.at("a").elements, (std::array<unsigned int, 4>{ 2, 3, 4, 5 }));
+    EXPECT_EQ(macro_map.at("b").elements, (std::array<unsigned int, 4>{ 1, 1, 1, 1 }));
+    // Macro properties share a namespace with regular properties
+    EXPECT_THROW(ed.newMacroProperty<int>("a"), exception::DuplicateEnvProperty);
+    EXPECT_THROW(ed.newProperty<int>("b", 1), exception::DuplicateEnvProperty);
+    ed.newProperty<int>("c", 1);
+    EXPECT_THROW(ed.newMacroProperty<int>("c"), exception::DuplicateEnvProperty);
+    EXPECT_THROW(ed.newMacroProperty<int>("_"), exception::ReservedName);
+}
+TEST(EnvironmentDescriptionTest, Table) {
+    EnvironmentDescription ed;
+    // The file is not opened until a simulation requires it
+    EXPECT_NO_THROW(ed.newTable<float>("a", "does_not_exist.bin"));
+    const auto &table_map = ed.getTablesMap();
+    ASSERT_EQ(table_map.size(), 1u);
+    EXPECT_EQ(table_map.at("a").type, std::type_index(typeid(float)));
+    EXPECT_EQ(table_map.at("a").type_size, sizeof(float));
+    EXPECT_EQ(table_map.at("a").file_path, "does_not_exist.bin");
+    // Tables share a namespace with regular and macro properties
+    EXPECT_THROW(ed.newTable<int>("a", "b.bin"), exception::DuplicateEnvProperty);
+    EXPECT_THROW(ed.newProperty<int>("a", 1), exception::DuplicateEnvProperty);
+    EXPECT_THROW(ed.newMacroProperty<int>("a"), exception::DuplicateEnvProperty);
+    ed.newMacroProperty<int>("b");
+    EXPECT_THROW(ed.newTable<int>("b", "b.bin"), exception::DuplicateEnvProperty);
+    EXPECT_THROW(ed.newTable<int>("_", "b.bin"), exception::ReservedName);
+}
+TEST(EnvironmentDescriptionTest, Field) {
+    EnvironmentDescription ed;
+    EnvironmentDescription::FieldData config({ 32, 16, 1 });
+    config.diffusion = 0.25f;
+    config.decay = 0.1f;
+    EXPECT_NO_THROW(ed.newField("a", config));
+    const auto &field_map = ed.getFieldsMap();
+    ASSERT_EQ(field_map.size(), 1u);
+    EXPECT_TRUE(field_map.at("a") == config);
+    // Fields share a namespace with regular and macro properties, and tables
+    EXPECT_THROW(ed.newField("a", config), exception::DuplicateEnvProperty);
+    EXPECT_THROW(ed.newProperty<float>("a", 1.0f), exception::DuplicateEnvProperty);
+    EXPECT_THROW(ed.newTable<float>("a", "b.bin"), exception::DuplicateEnvProperty);
+    ed.newMacroProperty<int>("b");
+    EXPECT_THROW(ed.newField("b", config), exception::DuplicateEnvProperty);
+    EXPECT_THROW(ed.newField("_", config), exception::ReservedName);
+    // Invalid dimensions and coefficients
+    EXPECT_THROW(ed.newField("c", EnvironmentDescription::FieldData({ 32, 0, 1 })), exception::InvalidArgument);
+    EnvironmentDescription::FieldData bad = config;
+    bad.sub_steps = 0;
+    EXPECT_THROW(ed.newField("c", bad), exception::InvalidArgument);
+    bad = config;
+    bad.decay = -1.0f;
+    EXPECT_THROW(ed.newField("c", bad), exception::InvalidArgument);
+    // 2D diffusion of 0.5 is at the stability limit, any more requires sub-steps
+    bad = config;
+    bad.diffusion = 0.5f;
+    bad.decay = 0.0f;
+    EXPECT_NO_THROW(ed.newField("c", bad));
+    bad.diffusion = 2.0f;
+    EXPECT_THROW(ed.newField("d", bad), exception::InvalidArgument);
+    bad.sub_steps = 8;
+    EXPECT_NO_THROW(ed.newField("d", bad));
+}
 }  // namespace flamegpu
@@ -130,6 +130,25 @@ TEST(LayerDescriptionTest, HostFunction) {
     EXPECT_THROW(l.addHostFunction(host_fn), exception::InvalidLayerMember);
 }
 
+TEST(LayerDescriptionTest, ExecutionInterval) {
+    ModelDescription _m(MODEL_NAME);
+    LayerDescription &l = _m.newLayer(LAYER_NAME);
+    // Defaults to every step
+    EXPECT_EQ(l.getExecutionInterval(), 1u);
+    EXPECT_EQ(l.getExecutionPhase(), 0u);
+    l.setExecutionInterval(24, 7);
+    EXPECT_EQ(l.getExecutionInterval(), 24u);
+    EXPECT_EQ(l.getExecutionPhase(), 7u);
+    l.setExecutionInterval(3);
+    EXPECT_EQ(l.getExecutionInterval(), 3u);
+    EXPECT_EQ(l.getExecutionPhase(), 0u);
+    // Invalid interval or phase
+    EXPECT_THROW(l.setExecutionInterval(0), exception::InvalidArgument);
+    EXPECT_THROW(l.setExecutionInterval(4, 4), exception::InvalidArgument);
+    EXPECT_EQ(l.getExecutionInterval(), 3u);
+    EXPECT_EQ(l.getExecutionPhase(), 0u);
+}
+
 TEST(LayerDescriptionTest, AgentFunction_WrongModel) {
     ModelDescription _m(MODEL_NAME);
     ModelDescription _m2(WRONG_MODEL_NAME);
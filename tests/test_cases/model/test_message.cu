@@ -33,6 +33,15 @@ TEST(MessageDescriptionTest, variables) {
     EXPECT_EQ(sizeof(int16_t), m.getVariableSize(VARIABLE_NAME2));
     EXPECT_EQ(std::type_index(typeid(int16_t)), m.getVariableType(VARIABLE_NAME2));
 }
+TEST(MessageDescriptionTest, CapacityHint) {
+    ModelDescription _m(MODEL_NAME);
+    MessageBruteForce::Description &m = _m.newMessage(MESSAGE_NAME1);
+    EXPECT_EQ(m.getCapacityHint(), 0u);
+    m.setCapacityHint(1024);
+    EXPECT_EQ(m.getCapacityHint(), 1024u);
+    m.setCapacityHint(0);
+    EXPECT_EQ(m.getCapacityHint(), 0u);
+}
 TEST(MessageDescriptionTest, variables_array) {
     ModelDescription _m(MODEL_NAME);
     MessageBruteForce::Description &m = _m.newMessage(MESSAGE_NAME1);
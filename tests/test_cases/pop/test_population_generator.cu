@@ -0,0 +1,217 @@
+#include "flamegpu/flamegpu.h"
+#include "gtest/gtest.h"
+
+namespace flamegpu {
+
+namespace {
+const unsigned int POP_SIZE = 200000;  // Large enough to be split across multiple threads
+const uint64_t SEED = 12;
+}  // namespace
+
+TEST(PopulationGeneratorTest, uniform) {
+    ModelDescription model("model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<float>("float", 0.0f);
+    agent.newVariable<double>("double", 0.0);
+    agent.newVariable<int>("int", 0);
+    agent.newVariable<unsigned int, 3>("uint_array", {0, 0, 0});
+    agent.newVariable<int>("untouched", 7);
+    PopulationGenerator gen;
+    gen.uniform<float>("float", -1.0f, 1.0f)
+        .uniform<double>("double", 10.0, 20.0)
+        .uniform<int>("int", -5, 5)
+        .uniform<unsigned int>("uint_array", 2, 4);
+    AgentVector pop(agent);
+    gen.generate(pop, POP_SIZE, SEED);
+    ASSERT_EQ(pop.size(), POP_SIZE);
+    double float_sum = 0;
+    bool int_min = false, int_max = false;
+    for (const auto &a : pop) {
+        const float f = a.getVariable<float>("float");
+        EXPECT_GE(f, -1.0f);
+        EXPECT_LT(f, 1.0f);
+        float_sum += f;
+        const double d = a.getVariable<double>("double");
+        EXPECT_GE(d, 10.0);
+        EXPECT_LT(d, 20.0);
+        const int i = a.getVariable<int>("int");
+        EXPECT_GE(i, -5);
+        EXPECT_LE(i, 5);
+        int_min |= i == -5;
+        int_max |= i == 5;
+        for (const unsigned int &u : a.getVariable<unsigned int, 3>("uint_array")) {
+            EXPECT_GE(u, 2u);
+            EXPECT_LE(u, 4u);
+        }
+        EXPECT_EQ(a.getVariable<int>("untouched"), 7);
+    }
+    // Integer range is inclusive
+    EXPECT_TRUE(int_min);
+    EXPECT_TRUE(int_max);
+    EXPECT_NEAR(float_sum / POP_SIZE, 0.0, 0.01);
+}
+TEST(PopulationGeneratorTest, uniform_unbiased) {
+    ModelDescription model("model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<uint64_t>("uint64", 0);
+    agent.newVariable<float>("float", 0.0f);
+    // 2^64 % range == 2^62, so a modulo reduction would make the lowest third twice as likely
+    const uint64_t range = 3ull << 62;
+    PopulationGenerator gen;
+    gen.uniform<uint64_t>("uint64", 0, range - 1)
+        .uniform<float>("float", 1.0f, 1.0f);
+    AgentVector pop(agent);
+    gen.generate(pop, POP_SIZE, SEED);
+    unsigned int lowest_third = 0;
+    for (const auto &a : pop) {
+        const uint64_t u = a.getVariable<uint64_t>("uint64");
+        EXPECT_LT(u, range);
+        lowest_third += u < (range / 3);
+        // An empty range returns min
+        EXPECT_EQ(a.getVariable<float>("float"), 1.0f);
+    }
+    EXPECT_NEAR(static_cast<double>(lowest_third) / POP_SIZE, 1.0 / 3.0, 0.01);
+}
+TEST(PopulationGeneratorTest, normal) {
+    ModelDescription model("model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<float>("float", 0.0f);
+    agent.newVariable<double>("double", 0.0);
+    PopulationGenerator gen;
+    gen.normal<float>("float", 5.0f, 2.0f)
+        .normal<double>("double", -3.0, 0.5);
+    AgentVector pop(agent);
+    gen.generate(pop, POP_SIZE, SEED);
+    double f_sum = 0, f_sq = 0, d_sum = 0, d_sq = 0;
+    for (const auto &a : pop) {
+        const double f = a.getVariable<float>("float");
+        const double d = a.getVariable<double>("double");
+        f_sum += f;
+        f_sq += f * f;
+        d_sum += d;
+        d_sq += d * d;
+    }
+    const double f_mean = f_sum / POP_SIZE;
+    const double d_mean = d_sum / POP_SIZE;
+    EXPECT_NEAR(f_mean, 5.0, 0.05);
+    EXPECT_NEAR(sqrt(f_sq / POP_SIZE - f_mean * f_mean), 2.0, 0.05);
+    EXPECT_NEAR(d_mean, -3.0, 0.05);
+    EXPECT_NEAR(sqrt(d_sq / POP_SIZE - d_mean * d_mean), 0.5, 0.05);
+}
+TEST(PopulationGeneratorTest, boxes) {
+    ModelDescription model("model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<float>("x");
+    agent.newVariable<float>("y");
+    agent.newVariable<float>("z");
+    agent.newVariable<float>("vx");
+    agent.newVariable<float>("vy");
+    PopulationGenerator gen;
+    gen.uniformBox<float>({"x", "y", "z"}, {0.0f, 10.0f, 20.0f}, {1.0f, 11.0f, 21.0f})
+        .normalBox<float>({"vx", "vy"}, {0.0f, 0.0f}, {1.0f, 1.0f}, {-0.5f, -0.5f}, {0.5f, 0.5f});
+    AgentVector pop(agent);
+    gen.generate(pop, POP_SIZE, SEED);
+    for (const auto &a : pop) {
+        EXPECT_GE(a.getVariable<float>("x"), 0.0f);
+        EXPECT_LT(a.getVariable<float>("x"), 1.0f);
+        EXPECT_GE(a.getVariable<float>("y"), 10.0f);
+        EXPECT_LT(a.getVariable<float>("y"), 11.0f);
+        EXPECT_GE(a.getVariable<float>("z"), 20.0f);
+        EXPECT_LT(a.getVariable<float>("z"), 21.0f);
+        EXPECT_GE(a.getVariable<float>("vx"), -0.5f);
+        EXPECT_LE(a.getVariable<float>("vx"), 0.5f);
+        EXPECT_GE(a.getVariable<float>("vy"), -0.5f);
+        EXPECT_LE(a.getVariable<float>("vy"), 0.5f);
+    }
+    // Independent axes must not produce identical values
+    EXPECT_NE(pop[0].getVariable<float>("x"), pop[0].getVariable<float>("y") - 10.0f);
+}
+TEST(PopulationGeneratorTest, lattice) {
+    ModelDescription model("model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<float>("x");
+    agent.newVariable<float>("y");
+    agent.newVariable<int>("z");
+    PopulationGenerator gen;
+    gen.lattice<float>({"x", "y"}, {1.0f, 2.0f}, {0.5f, 2.0f}, {4, 3});
+    AgentVector pop(agent);
+    gen.generate(pop, 12, SEED);
+    for (unsigned int i = 0; i < 12; ++i) {
+        EXPECT_EQ(pop[i].getVariable<float>("x"), 1.0f + 0.5f * (i % 4));
+        EXPECT_EQ(pop[i].getVariable<float>("y"), 2.0f + 2.0f * (i / 4));
+    }
+    // Too many agents for the lattice
+    AgentVector pop2(agent);
+    EXPECT_THROW(gen.generate(pop2, 13, SEED), exception::OutOfBoundsException);
+    EXPECT_EQ(pop2.size(), 0u);
+    // Integer lattice
+    PopulationGenerator gen2;
+    gen2.lattice<int>({"z"}, {-2}, {3}, {5});
+    gen2.generate(pop2, 5, SEED);
+    for (unsigned int i = 0; i < 5; ++i) {
+        EXPECT_EQ(pop2[i].getVariable<int>("z"), -2 + 3 * static_cast<int>(i));
+    }
+}
+TEST(PopulationGeneratorTest, thread_count_independent) {
+    ModelDescription model("model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<float>("x");
+    agent.newVariable<double>("y");
+    agent.newVariable<int64_t, 2>("z");
+    PopulationGenerator gen;
+    gen.uniform<float>("x", 0.0f, 100.0f)
+        .normal<double>("y", 0.0, 1.0)
+        .uniform<int64_t>("z", -1000000, 1000000);
+    AgentVector pop1(agent), pop2(agent), pop3(agent);
+    gen.setThreadCount(1);
+    EXPECT_EQ(gen.getThreadCount(), 1u);
+    gen.generate(pop1, POP_SIZE, SEED);
+    gen.setThreadCount(7);
+    gen.generate(pop2, POP_SIZE, SEED);
+    EXPECT_EQ(pop1, pop2);
+    // Different seed produces a different population
+    gen.generate(pop3, POP_SIZE, SEED + 1);
+    EXPECT_NE(pop1, pop3);
+}
+TEST(PopulationGeneratorTest, append) {
+    ModelDescription model("model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<float>("x", -1.0f);
+    PopulationGenerator gen;
+    gen.uniform<float>("x", 0.0f, 1.0f);
+    AgentVector pop(agent, 10);
+    gen.generate(pop, 100, SEED);
+    AgentVector pop2(agent);
+    gen.generate(pop2, 100, SEED);
+    ASSERT_EQ(pop.size(), 110u);
+    for (unsigned int i = 0; i < 10; ++i) {
+        EXPECT_EQ(pop[i].getVariable<float>("x"), -1.0f);
+    }
+    // Generated values are independent of the existing contents of the vector
+    for (unsigned int i = 0; i < 100; ++i) {
+        EXPECT_EQ(pop[10 + i].getVariable<float>("x"), pop2[i].getVariable<float>("x"));
+    }
+}
+TEST(PopulationGeneratorTest, exceptions) {
+    ModelDescription model("model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<float>("x");
+    AgentVector pop(agent);
+    PopulationGenerator gen;
+    EXPECT_THROW(gen.uniform<float>("x", 1.0f, 0.0f), exception::InvalidArgument);
+    EXPECT_THROW(gen.normal<float>("x", 1.0f, -1.0f), exception::InvalidArgument);
+    EXPECT_THROW(gen.uniformBox<float>({"x", "y"}, {0.0f}, {1.0f}), exception::InvalidArgument);
+    EXPECT_THROW(gen.lattice<float>({"x"}, {0.0f}, {1.0f}, {0}), exception::InvalidArgument);
+    PopulationGenerator bad_name;
+    bad_name.uniform<float>("y", 0.0f, 1.0f);
+    EXPECT_THROW(bad_name.generate(pop, 10, SEED), exception::InvalidAgentVar);
+    PopulationGenerator bad_type;
+    bad_type.uniform<double>("x", 0.0, 1.0);
+    EXPECT_THROW(bad_type.generate(pop, 10, SEED), exception::InvalidVarType);
+    PopulationGenerator reserved;
+    reserved.uniform<id_t>(ID_VARIABLE_NAME, 0, 1);
+    EXPECT_THROW(reserved.generate(pop, 10, SEED), exception::ReservedName);
+    EXPECT_EQ(pop.size(), 0u);
+}
+
+}  // namespace flamegpu
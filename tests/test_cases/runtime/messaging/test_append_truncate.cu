@@ -242,5 +242,63 @@ namespace test_message_AppendTruncate {
             ASSERT_EQ(ai.getVariable<unsigned int>("count1"), result_count);
         }
     }
+    /**
+     * Runs the Append_KeepData model, and returns the message list's memory stats
+     * @param capacity_hint The capacity hint of the message list
+     */
+    CUDAMessage::MemoryStats runAppendKeepData(const unsigned int &capacity_hint) {
+        ModelDescription m(MODEL_NAME);
+        MessageBruteForce::Description &message = m.newMessage(MESSAGE_NAME);
+        message.newVariable<int>("x");
+        message.setCapacityHint(capacity_hint);
+        AgentDescription &a = m.newAgent(AGENT_NAME);
+        a.newVariable<unsigned int>("count0");
+        a.newVariable<unsigned int>("count1");
+        AgentFunctionDescription &fo = a.newFunction(OUT_FUNCTION_NAME, Out_AppendTruncate);
+        fo.setMessageOutput(message);
+        AgentFunctionDescription &fo2 = a.newFunction(OUT_FUNCTION_NAME2, Out_AppendTruncate2);
+        fo2.setMessageOutput(message);
+        AgentFunctionDescription &fi = a.newFunction(IN_FUNCTION_NAME, In_AppendTruncate2);
+        fi.setMessageInput(message);
+        m.newLayer(OUT_LAYER_NAME).addAgentFunction(fo);
+        m.newLayer(OUT_LAYER2_NAME).addAgentFunction(fo2);
+        m.newLayer(IN_LAYER_NAME).addAgentFunction(fi);
+        AgentVector pop(a, AGENT_COUNT);
+        CUDASimulation c(m);
+        c.setPopulationData(pop);
+        for (unsigned int step = 0; step < 2; ++step) {
+            c.step();
+            c.getPopulationData(pop);
+            for (AgentVector::Agent ai : pop) {
+                EXPECT_EQ(ai.getVariable<unsigned int>("count0"), AGENT_COUNT);
+                EXPECT_EQ(ai.getVariable<unsigned int>("count1"), AGENT_COUNT);
+            }
+        }
+        return c.getCUDAMessage(MESSAGE_NAME).getMemoryStats();
+    }
+    TEST(TestMessage_AppendTruncate, Append_Growth) {
+        // The list grows while appending, retaining the messages output by the first function
+        const CUDAMessage::MemoryStats stats = runAppendKeepData(0);
+        EXPECT_EQ(stats.peak_message_count, 2 * AGENT_COUNT);
+        EXPECT_GE(stats.capacity, 2 * AGENT_COUNT);
+        EXPECT_GT(stats.allocations, 1u);
+        // Read and write buffers of the single variable
+        EXPECT_EQ(stats.allocated_bytes, 2 * sizeof(int) * stats.capacity);
+    }
+    TEST(TestMessage_AppendTruncate, Append_CapacityHint) {
+        // A sufficient capacity hint requires a single allocation
+        const CUDAMessage::MemoryStats stats = runAppendKeepData(2 * AGENT_COUNT);
+        EXPECT_EQ(stats.peak_message_count, 2 * AGENT_COUNT);
+        EXPECT_EQ(stats.capacity, 2 * AGENT_COUNT);
+        EXPECT_EQ(stats.allocations, 1u);
+        EXPECT_EQ(stats.allocated_bytes, 2 * sizeof(int) * stats.capacity);
+    }
+    TEST(TestMessage_AppendTruncate, Append_CapacityHintExceeded) {
+        // An insufficient capacity hint is grown beyond, retaining messages
+        const CUDAMessage::MemoryStats stats = runAppendKeepData(AGENT_COUNT);
+        EXPECT_EQ(stats.peak_message_count, 2 * AGENT_COUNT);
+        EXPECT_GE(stats.capacity, 2 * AGENT_COUNT);
+        EXPECT_EQ(stats.allocations, 2u);
+    }
 }  // namespace test_message_AppendTruncate
 }  // namespace flamegpu
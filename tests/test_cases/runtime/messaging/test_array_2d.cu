@@ -408,6 +408,70 @@ TEST(TestMessage_Array2D, ReadEmpty) {
     auto ai = pop_out[0];
     EXPECT_EQ(ai.getVariable<unsigned int>("value"), 0u);  // Unset array messages should be 0
 }
+FLAMEGPU_AGENT_FUNCTION(OutCombine, MessageNone, MessageArray2D) {
+    const unsigned int index = FLAMEGPU->getVariable<unsigned int>("index");
+    FLAMEGPU->message_out.setVariable<float>("value", 0.5f);
+    FLAMEGPU->message_out.setVariable<unsigned int>("min", index);
+    // Final element is left empty
+    const unsigned int element = index % (dSQRT_AGENT_COUNT * dSQRT_AGENT_COUNT - 1);
+    FLAMEGPU->message_out.setIndex(element % dSQRT_AGENT_COUNT, element / dSQRT_AGENT_COUNT);
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(InCombine, MessageArray2D, MessageNone) {
+    const unsigned int element = FLAMEGPU->getVariable<unsigned int>("index") % (dSQRT_AGENT_COUNT * dSQRT_AGENT_COUNT);
+    const auto &message = FLAMEGPU->message_in.at(element % dSQRT_AGENT_COUNT, element / dSQRT_AGENT_COUNT);
+    FLAMEGPU->setVariable<float>("value", message.getVariable<float>("value"));
+    FLAMEGPU->setVariable<unsigned int>("min", message.getVariable<unsigned int>("min"));
+    FLAMEGPU->setVariable<unsigned int>("count", message.getVariable<unsigned int>("count"));
+    return ALIVE;
+}
+TEST(TestMessage_Array2D, Combine) {
+    ModelDescription m(MODEL_NAME);
+    MessageArray2D::Description &message = m.newMessage<MessageArray2D>(MESSAGE_NAME);
+    message.setDimensions(SQRT_AGENT_COUNT, SQRT_AGENT_COUNT);
+    message.newVariable<float>("value");
+    message.newVariable<unsigned int>("min");
+    message.newVariable<unsigned int>("count");
+    message.setCombine("value", MessageCombine::Sum);
+    message.setCombine("min", MessageCombine::Min);
+    message.setCombine("count", MessageCombine::Count);
+    EXPECT_EQ(message.getCombine("count"), MessageCombine::Count);
+    EXPECT_THROW(message.setCombine("___INDEX", MessageCombine::Sum), exception::InvalidMessageVar);
+    AgentDescription &a = m.newAgent(AGENT_NAME);
+    a.newVariable<unsigned int>("index");
+    a.newVariable<float>("value", -1.0f);
+    a.newVariable<unsigned int>("min", UINT_MAX);
+    a.newVariable<unsigned int>("count", UINT_MAX);
+    AgentFunctionDescription &fo = a.newFunction(OUT_FUNCTION_NAME, OutCombine);
+    fo.setMessageOutput(message);
+    AgentFunctionDescription &fi = a.newFunction(IN_FUNCTION_NAME, InCombine);
+    fi.setMessageInput(message);
+    LayerDescription &lo = m.newLayer(OUT_LAYER_NAME);
+    lo.addAgentFunction(fo);
+    LayerDescription &li = m.newLayer(IN_LAYER_NAME);
+    li.addAgentFunction(fi);
+    // More agents than array elements, so multiple messages are output to each element
+    AgentVector pop(a, AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+        pop[i].setVariable<unsigned int>("index", i);
+    }
+    CUDASimulation c(m);
+    c.setPopulationData(pop);
+    c.step();
+    c.getPopulationData(pop);
+    const unsigned int ELEMENTS = SQRT_AGENT_COUNT * SQRT_AGENT_COUNT;
+    for (AgentVector::Agent ai : pop) {
+        const unsigned int element = ai.getVariable<unsigned int>("index") % ELEMENTS;
+        unsigned int count = 0;
+        for (unsigned int i = element; i < AGENT_COUNT && element < ELEMENTS - 1; i += ELEMENTS - 1) {
+            ++count;
+        }
+        EXPECT_EQ(ai.getVariable<unsigned int>("count"), count);
+        EXPECT_EQ(ai.getVariable<float>("value"), 0.5f * count);
+        // Empty elements read as 0
+        EXPECT_EQ(ai.getVariable<unsigned int>("min"), count ? element : 0u);
+    }
+}
 #if !defined(SEATBELTS) || SEATBELTS
 FLAMEGPU_AGENT_FUNCTION(InMooreWOutOfBoundsX, MessageArray2D, MessageNone) {
     for (auto a : FLAMEGPU->message_in.wrap(dSQRT_AGENT_COUNT, 0)) {
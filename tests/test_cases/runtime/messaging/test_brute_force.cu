@@ -308,6 +308,89 @@ TEST(TestMessage_BruteForce, reserved_name) {
     EXPECT_THROW(message.newVariable<int>("_"), exception::ReservedName);
 }
 
+FLAMEGPU_AGENT_FUNCTION(OutFunction_Multiple, MessageNone, MessageBruteForce) {
+    const int x = FLAMEGPU->getVariable<int>("x");
+    // Each agent outputs between 0 and 3 messages
+    for (int i = 0; i < x % 4; ++i) {
+        FLAMEGPU->message_out.setVariable<int>("x", x * 10 + i);
+        FLAMEGPU->message_out.emit();
+    }
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(InFunction_Multiple, MessageBruteForce, MessageNone) {
+    int sum = 0;
+    int count = 0;
+    for (auto &message : FLAMEGPU->message_in) {
+        sum += message.getVariable<int>("x");
+        ++count;
+    }
+    FLAMEGPU->setVariable<int>("sum", sum);
+    FLAMEGPU->setVariable<int>("product", count);
+    return ALIVE;
+}
+TEST(TestMessage_BruteForce, MultipleOutput) {
+    ModelDescription m(MODEL_NAME);
+    MessageBruteForce::Description &message = m.newMessage(MESSAGE_NAME);
+    message.newVariable<int>("x");
+    AgentDescription &a = m.newAgent(AGENT_NAME);
+    a.newVariable<int>("x");
+    a.newVariable<int>("sum");
+    a.newVariable<int>("product");
+    AgentFunctionDescription &fo = a.newFunction(OUT_FUNCTION_NAME, OutFunction_Multiple);
+    fo.setMessageOutput(message);
+    EXPECT_EQ(fo.getMessageOutputMax(), 1u);
+    EXPECT_THROW(fo.setMessageOutputMax(0), exception::InvalidArgument);
+    fo.setMessageOutputMax(3);
+    EXPECT_EQ(fo.getMessageOutputMax(), 3u);
+    AgentFunctionDescription &fi = a.newFunction(IN_FUNCTION_NAME, InFunction_Multiple);
+    fi.setMessageInput(message);
+    AgentVector pop(a, AGENT_COUNT);
+    int sum = 0;
+    int count = 0;
+    for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+        const int x = static_cast<int>(i);
+        for (int j = 0; j < x % 4; ++j) {
+            sum += x * 10 + j;
+            ++count;
+        }
+        pop[i].setVariable<int>("x", x);
+    }
+    m.newLayer(OUT_LAYER_NAME).addAgentFunction(fo);
+    m.newLayer(IN_LAYER_NAME).addAgentFunction(fi);
+    CUDASimulation c(m);
+    c.SimulationConfig().steps = 2;
+    c.setPopulationData(pop);
+    c.simulate();
+    c.getPopulationData(pop);
+    for (AgentVector::Agent ai : pop) {
+        ASSERT_EQ(ai.getVariable<int>("sum"), sum);
+        ASSERT_EQ(ai.getVariable<int>("product"), count);
+    }
+}
+#if !defined(SEATBELTS) || SEATBELTS
+TEST(TestMessage_BruteForce, MultipleOutputExceedsMax) {
+#else
+TEST(TestMessage_BruteForce, DISABLED_MultipleOutputExceedsMax) {
+#endif
+    ModelDescription m(MODEL_NAME);
+    MessageBruteForce::Description &message = m.newMessage(MESSAGE_NAME);
+    message.newVariable<int>("x");
+    AgentDescription &a = m.newAgent(AGENT_NAME);
+    a.newVariable<int>("x");
+    AgentFunctionDescription &fo = a.newFunction(OUT_FUNCTION_NAME, OutFunction_Multiple);
+    fo.setMessageOutput(message);
+    // Agents with x % 4 == 3 output 3 messages
+    fo.setMessageOutputMax(2);
+    m.newLayer(OUT_LAYER_NAME).addAgentFunction(fo);
+    AgentVector pop(a, AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+        pop[i].setVariable<int>("x", static_cast<int>(i));
+    }
+    CUDASimulation c(m);
+    c.setPopulationData(pop);
+    EXPECT_THROW(c.step(), exception::DeviceError);
+}
+
 FLAMEGPU_AGENT_FUNCTION(countBF, MessageBruteForce, MessageNone) {
     unsigned int count = 0;
     // Count how many messages we received (including our own)
@@ -582,5 +665,142 @@ TEST(TestMessage_BruteForce, DISABLED_ArrayVariable_glm) { }
 TEST(TestRTCMessage_BruteForce, DISABLED_ArrayVariable_glm) { }
 #endif
 
+FLAMEGPU_AGENT_FUNCTION(OutTiled, MessageNone, MessageBruteForce) {
+    const unsigned int index = FLAMEGPU->getVariable<unsigned int>("index");
+    FLAMEGPU->message_out.setVariable<unsigned int>("index", index);
+    FLAMEGPU->message_out.setVariable<int>("x", FLAMEGPU->getVariable<int>("x"));
+    FLAMEGPU->message_out.setVariable<double>("y", index * 0.5);
+    FLAMEGPU->message_out.setVariable<unsigned int, 3>("v", 0, index * 3);
+    FLAMEGPU->message_out.setVariable<unsigned int, 3>("v", 1, index * 7);
+    FLAMEGPU->message_out.setVariable<unsigned int, 3>("v", 2, index * 11);
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(InTiled, MessageBruteForce, MessageNone) {
+    const unsigned int my_index = FLAMEGPU->getVariable<unsigned int>("index");
+    int sum = 0;
+    unsigned int count = 0;
+    unsigned int badCount = 0;
+    // The full list is iterated by every agent, so the loop is not exited early
+    for (const auto &message : FLAMEGPU->message_in.tiled()) {
+        const unsigned int index = message.getVariable<unsigned int>("index");
+        sum += message.getVariable<int>("x");
+        if (message.getVariable<double>("y") != index * 0.5)
+            ++badCount;
+        if (index == my_index) {
+            FLAMEGPU->setVariable<unsigned int, 3>("message_read", 0, message.getVariable<unsigned int, 3>("v", 0));
+            FLAMEGPU->setVariable<unsigned int, 3>("message_read", 1, message.getVariable<unsigned int, 3>("v", 1));
+            FLAMEGPU->setVariable<unsigned int, 3>("message_read", 2, message.getVariable<unsigned int, 3>("v", 2));
+        }
+        ++count;
+    }
+    FLAMEGPU->setVariable<int>("sum", sum);
+    FLAMEGPU->setVariable<unsigned int>("count", count);
+    FLAMEGPU->setVariable<unsigned int>("badCount", badCount);
+    return ALIVE;
+}
+/**
+ * Runs the tiled message test model
+ * @param tile_agent_count The number of agents
+ */
+void runTiled(const unsigned int tile_agent_count) {
+    ModelDescription m(MODEL_NAME);
+    MessageBruteForce::Description &message = m.newMessage<MessageBruteForce>(MESSAGE_NAME);
+    message.newVariable<unsigned int>("index");
+    message.newVariable<int>("x");
+    message.newVariable<double>("y");
+    message.newVariable<unsigned int, 3>("v");
+    AgentDescription &a = m.newAgent(AGENT_NAME);
+    a.newVariable<unsigned int>("index");
+    a.newVariable<int>("x");
+    a.newVariable<int>("sum");
+    a.newVariable<unsigned int>("count");
+    a.newVariable<unsigned int>("badCount");
+    a.newVariable<unsigned int, 3>("message_read", {UINT_MAX, UINT_MAX, UINT_MAX});
+    AgentFunctionDescription &fo = a.newFunction(OUT_FUNCTION_NAME, OutTiled);
+    fo.setMessageOutput(message);
+    AgentFunctionDescription &fi = a.newFunction(IN_FUNCTION_NAME, InTiled);
+    fi.setMessageInput(message);
+    m.newLayer(OUT_LAYER_NAME).addAgentFunction(fo);
+    m.newLayer(IN_LAYER_NAME).addAgentFunction(fi);
+    AgentVector pop(a, tile_agent_count);
+    int sum = 0;
+    for (unsigned int i = 0; i < tile_agent_count; ++i) {
+        const int x = static_cast<int>(i % 7) - 3;
+        pop[i].setVariable<unsigned int>("index", i);
+        pop[i].setVariable<int>("x", x);
+        sum += x;
+    }
+    CUDASimulation c(m);
+    c.setPopulationData(pop);
+    // Messages are output to alternate buffers each step, so the tile schedule must follow them
+    for (unsigned int step = 0; step < 2; ++step) {
+        c.step();
+        c.getPopulationData(pop);
+        for (AgentVector::Agent ai : pop) {
+            const unsigned int index = ai.getVariable<unsigned int>("index");
+            ASSERT_EQ(ai.getVariable<int>("sum"), sum);
+            ASSERT_EQ(ai.getVariable<unsigned int>("count"), tile_agent_count);
+            ASSERT_EQ(ai.getVariable<unsigned int>("badCount"), 0u);
+            std::array<unsigned int, 3> v = ai.getVariable<unsigned int, 3>("message_read");
+            ASSERT_EQ(v[0], index * 3);
+            ASSERT_EQ(v[1], index * 7);
+            ASSERT_EQ(v[2], index * 11);
+        }
+    }
+}
+TEST(TestMessage_BruteForce, Tiled) {
+    // The message list spans several tiles, and the final block is partial
+    runTiled(1234);
+}
+TEST(TestMessage_BruteForce, TiledPartialFinalBlock) {
+    // Block sizes are a multiple of the warp size, so full blocks stage tiles whilst the partial final block reads from global memory
+    runTiled(4099);
+}
+TEST(TestMessage_BruteForce, TiledSmall) {
+    // Fewer messages than a single tile
+    runTiled(5);
+}
+FLAMEGPU_AGENT_FUNCTION(OutTiledLarge, MessageNone, MessageBruteForce) {
+    const unsigned int index = FLAMEGPU->getVariable<unsigned int>("index");
+    FLAMEGPU->message_out.setVariable<unsigned int, 1024>("large", 1023, index);
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(InTiledLarge, MessageBruteForce, MessageNone) {
+    unsigned int sum = 0;
+    for (const auto &message : FLAMEGPU->message_in.tiled()) {
+        sum += message.getVariable<unsigned int, 1024>("large", 1023);
+    }
+    FLAMEGPU->setVariable<unsigned int>("sum", sum);
+    return ALIVE;
+}
+TEST(TestMessage_BruteForce, TiledTooLarge) {
+    // Messages too large to stage are read from global memory
+    ModelDescription m(MODEL_NAME);
+    MessageBruteForce::Description &message = m.newMessage<MessageBruteForce>(MESSAGE_NAME);
+    message.newVariable<unsigned int, 1024>("large");
+    AgentDescription &a = m.newAgent(AGENT_NAME);
+    a.newVariable<unsigned int>("index");
+    a.newVariable<unsigned int>("sum");
+    AgentFunctionDescription &fo = a.newFunction(OUT_FUNCTION_NAME, OutTiledLarge);
+    fo.setMessageOutput(message);
+    AgentFunctionDescription &fi = a.newFunction(IN_FUNCTION_NAME, InTiledLarge);
+    fi.setMessageInput(message);
+    m.newLayer(OUT_LAYER_NAME).addAgentFunction(fo);
+    m.newLayer(IN_LAYER_NAME).addAgentFunction(fi);
+    AgentVector pop(a, AGENT_COUNT);
+    unsigned int sum = 0;
+    for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+        pop[i].setVariable<unsigned int>("index", i);
+        sum += i;
+    }
+    CUDASimulation c(m);
+    c.setPopulationData(pop);
+    c.step();
+    c.getPopulationData(pop);
+    for (AgentVector::Agent ai : pop) {
+        ASSERT_EQ(ai.getVariable<unsigned int>("sum"), sum);
+    }
+}
+
 }  // namespace test_message_brute_force
 }  // namespace flamegpu
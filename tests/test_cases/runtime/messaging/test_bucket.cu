@@ -3,8 +3,12 @@
 *
 * Tests cover:
 * > validation on MessageBucket::Description
+* > deterministic index build
+* > combined messages
 */
-
+#include <algorithm>
+#include <cmath>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "flamegpu/flamegpu.h"
@@ -370,6 +374,184 @@ TEST(BucketMessageTest, Mandatory_Range) {
     }
 }
 
+FLAMEGPU_AGENT_FUNCTION(out_deterministic, MessageNone, MessageBucket) {
+    const int id = FLAMEGPU->getVariable<int>("id");
+    FLAMEGPU->message_out.setVariable<int>("id", id);
+    FLAMEGPU->message_out.setVariable<float>("value", FLAMEGPU->getVariable<float>("value"));
+    FLAMEGPU->message_out.setKey(12 + (id % 8));
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(in_deterministic, MessageBucket, MessageNone) {
+    const int id = FLAMEGPU->getVariable<int>("id");
+    int last_id = -1;
+    unsigned int badCount = 0;
+    float sum = 0;
+    for (auto &m : FLAMEGPU->message_in(12 + (id % 8))) {
+        // Messages within a bucket should be in the order they were output
+        const int message_id = m.getVariable<int>("id");
+        if (message_id <= last_id)
+            badCount++;
+        last_id = message_id;
+        sum += m.getVariable<float>("value");
+    }
+    FLAMEGPU->setVariable<unsigned int>("badCount", badCount);
+    FLAMEGPU->setVariable<float>("sum", sum);
+    return ALIVE;
+}
+TEST(BucketMessageTest, Deterministic) {
+    // Construct model
+    ModelDescription model("BucketMessageTest");
+    {   // MessageBucket::Description
+        MessageBucket::Description &message = model.newMessage<MessageBucket>("bucket");
+        message.setBounds(12, 19);
+        EXPECT_FALSE(message.getDeterministic());
+        message.setDeterministic(true);
+        EXPECT_TRUE(message.getDeterministic());
+        message.newVariable<int>("id");
+        message.newVariable<float>("value");
+    }
+    {   // AgentDescription
+        AgentDescription &agent = model.newAgent("agent");
+        agent.newVariable<int>("id");
+        agent.newVariable<float>("value");
+        agent.newVariable<unsigned int>("badCount", 0);  // Number of messages out of order
+        agent.newVariable<float>("sum", 0);  // Order sensitive sum of message values
+        agent.newFunction("out", out_deterministic).setMessageOutput("bucket");
+        agent.newFunction("in", in_deterministic).setMessageInput("bucket");
+    }
+    {   // Layer #1
+        LayerDescription &layer = model.newLayer();
+        layer.addAgentFunction(out_deterministic);
+    }
+    {   // Layer #2
+        LayerDescription &layer = model.newLayer();
+        layer.addAgentFunction(in_deterministic);
+    }
+    // Values span many orders of magnitude, so their float sum depends on the order of summation
+    AgentVector population(model.Agent("agent"), AGENT_COUNT);
+    std::default_random_engine rng;
+    std::uniform_real_distribution<float> dist(-20.0f, 20.0f);
+    for (unsigned int i = 0; i < AGENT_COUNT; i++) {
+        AgentVector::Agent ai = population[i];
+        ai.setVariable<int>("id", i);
+        ai.setVariable<float>("value", std::pow(2.0f, dist(rng)));
+    }
+    // Run the model twice, results should be identical
+    std::vector<float> sums[2];
+    for (auto &s : sums) {
+        CUDASimulation cudaSimulation(model);
+        cudaSimulation.setPopulationData(population);
+        cudaSimulation.step();
+        AgentVector result(model.Agent("agent"));
+        cudaSimulation.getPopulationData(result);
+        for (AgentVector::Agent ai : result) {
+            EXPECT_EQ(ai.getVariable<unsigned int>("badCount"), 0u);
+            s.push_back(ai.getVariable<float>("sum"));
+        }
+    }
+    ASSERT_EQ(sums[0].size(), sums[1].size());
+    for (size_t i = 0; i < sums[0].size(); ++i) {
+        EXPECT_EQ(sums[0][i], sums[1][i]);
+    }
+}
+
+FLAMEGPU_AGENT_FUNCTION(out_combine, MessageNone, MessageBucket) {
+    const int id = FLAMEGPU->getVariable<int>("id");
+    FLAMEGPU->message_out.setVariable<int>("min", id);
+    FLAMEGPU->message_out.setVariable<int>("max", id);
+    FLAMEGPU->message_out.setVariable<int64_t>("sum", id);
+    // Final bucket is left empty
+    FLAMEGPU->message_out.setKey(12 + (id % 7));
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(in_combine, MessageBucket, MessageNone) {
+    const int id = FLAMEGPU->getVariable<int>("id");
+    unsigned int messages = 0;
+    for (auto &m : FLAMEGPU->message_in(12 + (id % 8))) {
+        FLAMEGPU->setVariable<int>("min", m.getVariable<int>("min"));
+        FLAMEGPU->setVariable<int>("max", m.getVariable<int>("max"));
+        FLAMEGPU->setVariable<int64_t>("sum", m.getVariable<int64_t>("sum"));
+        FLAMEGPU->setVariable<unsigned int>("count", m.getVariable<unsigned int>("count"));
+        ++messages;
+    }
+    FLAMEGPU->setVariable<unsigned int>("messages", messages);
+    return ALIVE;
+}
+TEST(BucketMessageTest, CombineValidation) {
+    ModelDescription model("BucketMessageTest");
+    MessageBucket::Description &message = model.newMessage<MessageBucket>("bucket");
+    message.newVariable<float>("a");
+    message.newVariable<char>("b");
+    EXPECT_EQ(message.getCombine("a"), MessageCombine::None);
+    EXPECT_NO_THROW(message.setCombine("a", MessageCombine::Sum));
+    EXPECT_EQ(message.getCombine("a"), MessageCombine::Sum);
+    EXPECT_THROW(message.setCombine("b", MessageCombine::Sum), exception::InvalidArgument);  // Type not supported
+    EXPECT_THROW(message.setCombine("c", MessageCombine::Sum), exception::InvalidMessageVar);  // Variable does not exist
+    EXPECT_THROW(message.setCombine("_key", MessageCombine::Sum), exception::InvalidMessageVar);  // Internal variable
+    EXPECT_THROW(message.getCombine("c"), exception::InvalidMessageVar);
+}
+TEST(BucketMessageTest, Combine) {
+    // Construct model
+    ModelDescription model("BucketMessageTest");
+    {   // MessageBucket::Description
+        MessageBucket::Description &message = model.newMessage<MessageBucket>("bucket");
+        message.setBounds(12, 19);
+        message.newVariable<int>("min");
+        message.newVariable<int>("max");
+        message.newVariable<int64_t>("sum");
+        message.newVariable<unsigned int>("count");
+        message.setCombine("min", MessageCombine::Min);
+        message.setCombine("max", MessageCombine::Max);
+        message.setCombine("sum", MessageCombine::Sum);
+        message.setCombine("count", MessageCombine::Count);
+    }
+    {   // AgentDescription
+        AgentDescription &agent = model.newAgent("agent");
+        agent.newVariable<int>("id");
+        agent.newVariable<int>("min", -1);
+        agent.newVariable<int>("max", -1);
+        agent.newVariable<int64_t>("sum", 0);
+        agent.newVariable<unsigned int>("count", 0);
+        agent.newVariable<unsigned int>("messages", 0);  // Number of messages in the bucket
+        agent.newFunction("out", out_combine).setMessageOutput("bucket");
+        agent.newFunction("in", in_combine).setMessageInput("bucket");
+    }
+    {   // Layer #1
+        LayerDescription &layer = model.newLayer();
+        layer.addAgentFunction(out_combine);
+    }
+    {   // Layer #2
+        LayerDescription &layer = model.newLayer();
+        layer.addAgentFunction(in_combine);
+    }
+    AgentVector population(model.Agent("agent"), AGENT_COUNT);
+    // Calculate the expected result of each bucket
+    std::vector<int> min(8, -1), max(8, -1);
+    std::vector<int64_t> sum(8, 0);
+    std::vector<unsigned int> count(8, 0);
+    for (unsigned int i = 0; i < AGENT_COUNT; i++) {
+        population[i].setVariable<int>("id", i);
+        const unsigned int b = i % 7;
+        min[b] = min[b] == -1 ? i : std::min<int>(min[b], i);
+        max[b] = std::max<int>(max[b], i);
+        sum[b] += i;
+        ++count[b];
+    }
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.setPopulationData(population);
+    cudaSimulation.step();
+    cudaSimulation.getPopulationData(population);
+    for (AgentVector::Agent ai : population) {
+        const unsigned int b = ai.getVariable<int>("id") % 8;
+        // Each non-empty bucket holds a single combined message
+        EXPECT_EQ(ai.getVariable<unsigned int>("messages"), count[b] ? 1u : 0u);
+        EXPECT_EQ(ai.getVariable<int>("min"), min[b]);
+        EXPECT_EQ(ai.getVariable<int>("max"), max[b]);
+        EXPECT_EQ(ai.getVariable<int64_t>("sum"), sum[b]);
+        EXPECT_EQ(ai.getVariable<unsigned int>("count"), count[b]);
+    }
+}
+
 FLAMEGPU_AGENT_FUNCTION(ArrayOut, MessageNone, MessageBucket) {
     const unsigned int index = FLAMEGPU->getVariable<unsigned int>("index");
     FLAMEGPU->message_out.setVariable<unsigned int, 3>("v", 0, index * 3);
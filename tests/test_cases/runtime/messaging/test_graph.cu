@@ -0,0 +1,152 @@
+/**
+* Tests of feature graph messaging
+*
+* Tests cover:
+* > messages are read from the neighbours of a vertex, following the initial topology
+* > topology edits made by host functions are visible to the following agent functions
+* > description and topology validation
+*/
+#include <vector>
+
+#include "flamegpu/flamegpu.h"
+
+#include "gtest/gtest.h"
+
+namespace flamegpu {
+
+
+namespace test_message_graph {
+const unsigned int VERTEX_COUNT = 100;
+
+FLAMEGPU_AGENT_FUNCTION(OutVertex, MessageNone, MessageGraph) {
+    const unsigned int vertex = FLAMEGPU->getVariable<unsigned int>("vertex");
+    FLAMEGPU->message_out.setVariable<unsigned int>("value", vertex * 3);
+    FLAMEGPU->message_out.setIndex(vertex);
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(InNeighbours, MessageGraph, MessageNone) {
+    const unsigned int vertex = FLAMEGPU->getVariable<unsigned int>("vertex");
+    unsigned int count = 0;
+    unsigned int sum = 0;
+    unsigned int badCount = 0;
+    for (const auto &message : FLAMEGPU->message_in(vertex)) {
+        const unsigned int value = message.getVariable<unsigned int>("value");
+        // The message was output by the neighbouring vertex
+        if (value != message.getIndex() * 3)
+            ++badCount;
+        sum += value;
+        ++count;
+    }
+    if (count != FLAMEGPU->message_in.degree(vertex))
+        ++badCount;
+    FLAMEGPU->setVariable<unsigned int>("count", count);
+    FLAMEGPU->setVariable<unsigned int>("sum", sum);
+    FLAMEGPU->setVariable<unsigned int>("badCount", badCount);
+    return ALIVE;
+}
+FLAMEGPU_STEP_FUNCTION(AddSkipEdges) {
+    // Each vertex gains an edge to the vertex two beyond it, and loses its edge to the previous vertex
+    std::vector<unsigned int> sources, destinations, previous;
+    for (unsigned int v = 0; v < VERTEX_COUNT; ++v) {
+        sources.push_back(v);
+        destinations.push_back((v + 2) % VERTEX_COUNT);
+        previous.push_back((v + VERTEX_COUNT - 1) % VERTEX_COUNT);
+    }
+    MessageGraph::Topology topology = FLAMEGPU->graph("graph");
+    EXPECT_EQ(topology.addEdges(sources, destinations), VERTEX_COUNT);
+    EXPECT_EQ(topology.removeEdges(sources, previous), VERTEX_COUNT);
+    // Existing edges are not duplicated
+    EXPECT_FALSE(topology.addEdge(0, 1));
+    EXPECT_EQ(topology.getEdgeCount(), 2 * VERTEX_COUNT);
+}
+TEST(TestMessage_Graph, Neighbours) {
+    ModelDescription model("GraphMessageTestModel");
+    MessageGraph::Description &message = model.newMessage<MessageGraph>("graph");
+    message.setVertexCount(VERTEX_COUNT);
+    message.newVariable<unsigned int>("value");
+    // A ring, where each vertex neighbours the vertices either side of it
+    for (unsigned int v = 0; v < VERTEX_COUNT; ++v) {
+        message.addEdge(v, (v + 1) % VERTEX_COUNT);
+        message.addEdge(v, (v + VERTEX_COUNT - 1) % VERTEX_COUNT);
+    }
+    EXPECT_EQ(message.getEdgeCount(), 2 * VERTEX_COUNT);
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<unsigned int>("vertex");
+    agent.newVariable<unsigned int>("count");
+    agent.newVariable<unsigned int>("sum");
+    agent.newVariable<unsigned int>("badCount");
+    agent.newFunction("out", OutVertex).setMessageOutput(message);
+    agent.newFunction("in", InNeighbours).setMessageInput(message);
+    model.newLayer().addAgentFunction(OutVertex);
+    model.newLayer().addAgentFunction(InNeighbours);
+    model.addStepFunction(AddSkipEdges);
+
+    // Agents are not stored in vertex order
+    AgentVector population(agent, VERTEX_COUNT);
+    for (unsigned int i = 0; i < VERTEX_COUNT; ++i) {
+        population[i].setVariable<unsigned int>("vertex", VERTEX_COUNT - 1 - i);
+    }
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.setPopulationData(population);
+
+    // The first step reads the initial ring topology
+    cudaSimulation.step();
+    cudaSimulation.getPopulationData(population);
+    for (AgentVector::Agent ai : population) {
+        const unsigned int v = ai.getVariable<unsigned int>("vertex");
+        EXPECT_EQ(ai.getVariable<unsigned int>("count"), 2u);
+        EXPECT_EQ(ai.getVariable<unsigned int>("sum"), ((v + 1) % VERTEX_COUNT + (v + VERTEX_COUNT - 1) % VERTEX_COUNT) * 3);
+        EXPECT_EQ(ai.getVariable<unsigned int>("badCount"), 0u);
+    }
+    // The second step reads the topology edited by the step function
+    cudaSimulation.step();
+    cudaSimulation.getPopulationData(population);
+    for (AgentVector::Agent ai : population) {
+        const unsigned int v = ai.getVariable<unsigned int>("vertex");
+        EXPECT_EQ(ai.getVariable<unsigned int>("count"), 2u);
+        EXPECT_EQ(ai.getVariable<unsigned int>("sum"), ((v + 1) % VERTEX_COUNT + (v + 2) % VERTEX_COUNT) * 3);
+        EXPECT_EQ(ai.getVariable<unsigned int>("badCount"), 0u);
+    }
+}
+TEST(TestMessage_Graph, Description) {
+    ModelDescription model("GraphMessageTestModel");
+    MessageGraph::Description &message = model.newMessage<MessageGraph>("graph");
+    EXPECT_THROW(message.setVertexCount(0), exception::InvalidArgument);
+    message.setVertexCount(4);
+    EXPECT_EQ(message.getVertexCount(), 4u);
+    EXPECT_TRUE(message.addEdge(0, 3));
+    EXPECT_TRUE(message.addEdge(0, 1));
+    EXPECT_FALSE(message.addEdge(0, 3));
+    EXPECT_EQ(message.getNeighbours(0), std::vector<unsigned int>({ 3, 1 }));
+    EXPECT_EQ(message.getEdgeCount(), 2u);
+    EXPECT_THROW(message.addEdge(4, 0), exception::OutOfBoundsException);
+    EXPECT_THROW(message.addEdge(0, 4), exception::OutOfBoundsException);
+    EXPECT_THROW(message.getNeighbours(4), exception::OutOfBoundsException);
+    // Changing the vertex count removes all edges
+    message.setVertexCount(8);
+    EXPECT_EQ(message.getEdgeCount(), 0u);
+}
+TEST(TestMessage_Graph, NoVertices) {
+    ModelDescription model("GraphMessageTestModel");
+    model.newMessage<MessageGraph>("graph");
+    EXPECT_THROW(CUDASimulation m(model), exception::InvalidMessage);
+}
+FLAMEGPU_STEP_FUNCTION(BadEdge) {
+    MessageGraph::Topology topology = FLAMEGPU->graph("graph");
+    EXPECT_THROW(topology.addEdge(0, VERTEX_COUNT), exception::OutOfBoundsException);
+    EXPECT_THROW(topology.addEdges({ 0, 1 }, { 1 }), exception::InvalidArgument);
+    EXPECT_THROW(FLAMEGPU->graph("not_graph"), exception::InvalidMessageType);
+    EXPECT_THROW(FLAMEGPU->graph("missing"), exception::InvalidCudaMessage);
+}
+TEST(TestMessage_Graph, BadTopologyEdit) {
+    ModelDescription model("GraphMessageTestModel");
+    model.newMessage<MessageGraph>("graph").setVertexCount(VERTEX_COUNT);
+    model.newMessage<MessageBruteForce>("not_graph");
+    model.newAgent("agent");
+    model.addStepFunction(BadEdge);
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.step();
+}
+
+}  // namespace test_message_graph
+}  // namespace flamegpu
@@ -0,0 +1,169 @@
+/**
+* Tests of feature k-nearest-neighbour messaging
+*
+* Tests cover:
+* > k nearest messages match a brute force host reference, with row-major and Morton ordered bins
+* > messages beyond the maximum radius are not returned
+* > description validation
+*/
+#include <algorithm>
+#include <array>
+#include <random>
+#include <vector>
+
+#include "flamegpu/flamegpu.h"
+#include "flamegpu/util/detail/NearestNeighbours.cuh"
+
+#include "gtest/gtest.h"
+
+namespace flamegpu {
+
+
+namespace test_message_knn {
+const unsigned int K = 6;
+
+FLAMEGPU_AGENT_FUNCTION(out_knn, MessageNone, MessageKNN) {
+    FLAMEGPU->message_out.setVariable<int>("id", FLAMEGPU->getVariable<int>("id"));
+    FLAMEGPU->message_out.setLocation(
+        FLAMEGPU->getVariable<float>("x"),
+        FLAMEGPU->getVariable<float>("y"),
+        FLAMEGPU->getVariable<float>("z"));
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(in_knn, MessageKNN, MessageNone) {
+    const float x1 = FLAMEGPU->getVariable<float>("x");
+    const float y1 = FLAMEGPU->getVariable<float>("y");
+    const float z1 = FLAMEGPU->getVariable<float>("z");
+    unsigned int count = 0;
+    unsigned int badCount = 0;
+    float last_distance = 0;
+    for (const auto &message : FLAMEGPU->message_in(x1, y1, z1)) {
+        const float distance = message.getDistance();
+        // Messages are returned in order of distance, within the max radius
+        if (distance < last_distance || distance > FLAMEGPU->message_in.maxRadius())
+            badCount++;
+        last_distance = distance;
+        FLAMEGPU->setVariable<int, K>("neighbours", count++, message.getVariable<int>("id"));
+    }
+    FLAMEGPU->setVariable<unsigned int>("count", count);
+    FLAMEGPU->setVariable<unsigned int>("badCount", badCount);
+    return ALIVE;
+}
+void knn(const bool morton_order, const float max_radius) {
+    const unsigned int AGENT_COUNT = 1000;
+    const int DIM = 16;
+    ModelDescription model("KNNMessageTestModel");
+    {   // Location message
+        MessageKNN::Description &message = model.newMessage<MessageKNN>("location");
+        message.setMin(0, 0, 0);
+        message.setMax(DIM, DIM, DIM);
+        message.setRadius(2);
+        message.setMortonOrder(morton_order);
+        message.setK(K);
+        message.setMaxRadius(max_radius);
+        message.newVariable<int>("id");
+    }
+    {   // Circle agent
+        AgentDescription &agent = model.newAgent("agent");
+        agent.newVariable<int>("id");
+        agent.newVariable<float>("x");
+        agent.newVariable<float>("y");
+        agent.newVariable<float>("z");
+        agent.newVariable<int, K>("neighbours", {-1, -1, -1, -1, -1, -1});
+        agent.newVariable<unsigned int>("count");
+        agent.newVariable<unsigned int>("badCount");
+        agent.newFunction("out", out_knn).setMessageOutput("location");
+        agent.newFunction("in", in_knn).setMessageInput("location");
+    }
+    {   // Layer #1
+        LayerDescription &layer = model.newLayer();
+        layer.addAgentFunction(out_knn);
+    }
+    {   // Layer #2
+        LayerDescription &layer = model.newLayer();
+        layer.addAgentFunction(in_knn);
+    }
+    CUDASimulation cudaSimulation(model);
+
+    // Agents occupy distinct integer lattice points, so distances are exact and ties are only broken by location
+    std::vector<float> x, y, z;
+    {
+        std::vector<int> points(DIM * DIM * DIM);
+        for (int i = 0; i < DIM * DIM * DIM; ++i)
+            points[i] = i;
+        std::shuffle(points.begin(), points.end(), std::default_random_engine(31313131));
+        for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+            x.push_back(static_cast<float>(points[i] % DIM));
+            y.push_back(static_cast<float>((points[i] / DIM) % DIM));
+            z.push_back(static_cast<float>(points[i] / (DIM * DIM)));
+        }
+    }
+    AgentVector population(model.Agent("agent"), AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+        AgentVector::Agent instance = population[i];
+        instance.setVariable<int>("id", i);
+        instance.setVariable<float>("x", x[i]);
+        instance.setVariable<float>("y", y[i]);
+        instance.setVariable<float>("z", z[i]);
+    }
+    cudaSimulation.setPopulationData(population);
+
+    // Execute a single step of the model
+    cudaSimulation.step();
+
+    // Recover the results and check they match the host reference
+    cudaSimulation.getPopulationData(population);
+    unsigned int badCountWrong = 0;
+    for (AgentVector::Agent ai : population) {
+        const int id = ai.getVariable<int>("id");
+        const std::vector<util::detail::knn::Neighbour> expected = util::detail::knn::nearest(
+            x.data(), y.data(), z.data(), AGENT_COUNT, x[id], y[id], z[id], K, max_radius);
+        ASSERT_EQ(ai.getVariable<unsigned int>("count"), expected.size());
+        const std::array<int, K> neighbours = ai.getVariable<int, K>("neighbours");
+        for (unsigned int i = 0; i < expected.size(); ++i) {
+            EXPECT_EQ(neighbours[i], static_cast<int>(expected[i].index));
+        }
+        if (ai.getVariable<unsigned int>("badCount"))
+            badCountWrong++;
+    }
+    EXPECT_EQ(badCountWrong, 0u);
+}
+TEST(KNNMessageTest, Nearest) {
+    // The max radius spans several bins, so searches expand beyond the Moore neighbourhood
+    knn(false, 7.0f);
+}
+TEST(KNNMessageTest, NearestMorton) {
+    knn(true, 7.0f);
+}
+TEST(KNNMessageTest, MaxRadius) {
+    // Most agents have fewer than k neighbours within the max radius
+    knn(false, 1.5f);
+}
+TEST(KNNMessageTest, Description) {
+    ModelDescription model("KNNMessageTestModel");
+    MessageKNN::Description &message = model.newMessage<MessageKNN>("location");
+    message.setRadius(2);
+    EXPECT_EQ(message.getK(), 1u);
+    // Max radius defaults to the radius
+    EXPECT_EQ(message.getMaxRadius(), 2.0f);
+    message.setK(MessageKNN::MAX_K);
+    EXPECT_EQ(message.getK(), MessageKNN::MAX_K);
+    message.setMaxRadius(10.0f);
+    EXPECT_EQ(message.getMaxRadius(), 10.0f);
+    EXPECT_THROW(message.setK(0), exception::InvalidArgument);
+    EXPECT_THROW(message.setK(MessageKNN::MAX_K + 1), exception::InvalidArgument);
+    EXPECT_THROW(message.setMaxRadius(0), exception::InvalidArgument);
+    EXPECT_THROW(message.setMaxRadius(-1), exception::InvalidArgument);
+}
+TEST(KNNMessageTest, Periodic) {
+    ModelDescription model("KNNMessageTestModel");
+    MessageKNN::Description &message = model.newMessage<MessageKNN>("location");
+    message.setMin(0, 0, 0);
+    message.setMax(10, 10, 10);
+    message.setRadius(1);
+    message.setPeriodic(true);
+    EXPECT_THROW(CUDASimulation m(model), exception::InvalidMessage);
+}
+
+}  // namespace test_message_knn
+}  // namespace flamegpu
@@ -0,0 +1,245 @@
+/**
+* Tests of feature sparse Spatial 3D messaging
+*
+* Tests cover:
+* > mandatory messaging, send/recieve, within a large sparsely occupied domain
+* > mandatory messaging, with cell coordinates beyond the range stored in a cell key
+* > optional messaging, with no messages output
+* > radius validation
+*/
+#include <array>
+#include <cmath>
+#include <map>
+
+#include "flamegpu/flamegpu.h"
+
+#include "gtest/gtest.h"
+
+namespace flamegpu {
+
+
+namespace test_message_sparse_spatial3d {
+
+FLAMEGPU_AGENT_FUNCTION(out_mandatory3D, MessageNone, MessageSparseSpatial3D) {
+    FLAMEGPU->message_out.setVariable<int>("id", FLAMEGPU->getVariable<int>("id"));
+    FLAMEGPU->message_out.setLocation(
+        FLAMEGPU->getVariable<float>("x"),
+        FLAMEGPU->getVariable<float>("y"),
+        FLAMEGPU->getVariable<float>("z"));
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(out_optional3DNone, MessageNone, MessageSparseSpatial3D) {
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(in3D, MessageSparseSpatial3D, MessageNone) {
+    const float x1 = FLAMEGPU->getVariable<float>("x");
+    const float y1 = FLAMEGPU->getVariable<float>("y");
+    const float z1 = FLAMEGPU->getVariable<float>("z");
+    const float r = FLAMEGPU->message_in.radius();
+    unsigned int count = 0;
+    unsigned int badCount = 0;
+    int myBin[3] = {
+        static_cast<int>(floorf(x1 / r)),
+        static_cast<int>(floorf(y1 / r)),
+        static_cast<int>(floorf(z1 / r))
+    };
+    // Count how many messages we received (including our own)
+    // This is all those which fall within the 3x3x3 Moore neighbourhood
+    // Not our search radius
+    for (const auto &message : FLAMEGPU->message_in(x1, y1, z1)) {
+        int messageBin[3] = {
+            static_cast<int>(floorf(message.getVariable<float>("x") / r)),
+            static_cast<int>(floorf(message.getVariable<float>("y") / r)),
+            static_cast<int>(floorf(message.getVariable<float>("z") / r))
+        };
+        bool isBad = false;
+        for (unsigned int i = 0; i < 3; ++i) {  // Iterate axis
+            int binDiff = myBin[i] - messageBin[i];
+            if (binDiff > 1 || binDiff < -1) {
+                isBad = true;
+            }
+        }
+        count++;
+        badCount = isBad ? badCount + 1 : badCount;
+    }
+    FLAMEGPU->setVariable<unsigned int>("count", count);
+    FLAMEGPU->setVariable<unsigned int>("badCount", badCount);
+    return ALIVE;
+}
+/**
+ * Agents in clusters scattered across [-extent, extent) on each axis, read the messages within their Moore neighbourhood
+ */
+void runMandatory(const float RADIUS, const float extent) {
+    std::map<std::array<int, 3>, unsigned int> bin_counts;
+    // Construct model
+    ModelDescription model("SparseSpatial3DMessageTestModel");
+    {   // Location message
+        MessageSparseSpatial3D::Description &message = model.newMessage<MessageSparseSpatial3D>("location");
+        message.setRadius(RADIUS);
+        message.newVariable<int>("id");  // unused by current test
+    }
+    {   // Circle agent
+        AgentDescription &agent = model.newAgent("agent");
+        agent.newVariable<int>("id");
+        agent.newVariable<float>("x");
+        agent.newVariable<float>("y");
+        agent.newVariable<float>("z");
+        agent.newVariable<unsigned int>("count");  // Store the number of messages read, for validation
+        agent.newVariable<unsigned int>("badCount");  // Store how many messages are out of range
+        agent.newFunction("out", out_mandatory3D).setMessageOutput("location");
+        agent.newFunction("in", in3D).setMessageInput("location");
+    }
+    {   // Layer #1
+        LayerDescription &layer = model.newLayer();
+        layer.addAgentFunction(out_mandatory3D);
+    }
+    {   // Layer #2
+        LayerDescription &layer = model.newLayer();
+        layer.addAgentFunction(in3D);
+    }
+    CUDASimulation cudaSimulation(model);
+
+    const int AGENT_COUNT = 2049;
+    AgentVector population(model.Agent("agent"), AGENT_COUNT);
+    {
+        // Agents are grouped into small clusters, scattered across a domain far larger than a dense grid could cover
+        std::default_random_engine rng;
+        std::uniform_real_distribution<float> cluster_dist(-extent, extent);
+        std::uniform_real_distribution<float> dist(0.0f, 3 * RADIUS);
+        float cluster[3] = { 0.0f, 0.0f, 0.0f };
+        for (unsigned int i = 0; i < AGENT_COUNT; i++) {
+            if (i % 64 == 0) {
+                for (unsigned int j = 0; j < 3; ++j) {
+                    cluster[j] = cluster_dist(rng);
+                }
+            }
+            AgentVector::Agent instance = population[i];
+            instance.setVariable<int>("id", i);
+            float pos[3] = { cluster[0] + dist(rng), cluster[1] + dist(rng), cluster[2] + dist(rng) };
+            instance.setVariable<float>("x", pos[0]);
+            instance.setVariable<float>("y", pos[1]);
+            instance.setVariable<float>("z", pos[2]);
+            // Solve the bin
+            const std::array<int, 3> bin = {
+                static_cast<int>(floorf(pos[0] / RADIUS)),
+                static_cast<int>(floorf(pos[1] / RADIUS)),
+                static_cast<int>(floorf(pos[2] / RADIUS))
+            };
+            bin_counts[bin] += 1;
+        }
+        cudaSimulation.setPopulationData(population);
+    }
+
+    // Execute a single step of the model
+    cudaSimulation.step();
+
+    // Recover the results and check they match what was expected
+    cudaSimulation.getPopulationData(population);
+    // Validate each agent has same result
+    unsigned int badCountWrong = 0;
+    for (AgentVector::Agent ai : population) {
+        const std::array<int, 3> bin = {
+            static_cast<int>(floorf(ai.getVariable<float>("x") / RADIUS)),
+            static_cast<int>(floorf(ai.getVariable<float>("y") / RADIUS)),
+            static_cast<int>(floorf(ai.getVariable<float>("z") / RADIUS))
+        };
+        // Count our neighbours
+        unsigned int count_sum = 0;
+        for (int x2 = -1; x2 <= 1; x2++) {
+            for (int y2 = -1; y2 <= 1; y2++) {
+                for (int z2 = -1; z2 <= 1; z2++) {
+                    const auto it = bin_counts.find({ bin[0] + x2, bin[1] + y2, bin[2] + z2 });
+                    if (it != bin_counts.end()) {
+                        count_sum += it->second;
+                    }
+                }
+            }
+        }
+        EXPECT_EQ(ai.getVariable<unsigned int>("count"), count_sum);
+        if (ai.getVariable<unsigned int>("badCount"))
+            badCountWrong++;
+    }
+    EXPECT_EQ(badCountWrong, 0u);
+}
+TEST(SparseSpatial3DMessageTest, Mandatory) {
+    runMandatory(2.0f, 100000.0f);
+}
+TEST(SparseSpatial3DMessageTest, MandatoryBeyondKeyRange) {
+    // Cell coordinates exceed 2^20 in both directions, so the 3x3x3 neighbourhood must not visit any cell twice
+    runMandatory(1.0f, 4194304.0f);
+}
+// Test optional message output, with no messages
+TEST(SparseSpatial3DMessageTest, OptionalNone) {
+    // Construct model
+    ModelDescription model("SparseSpatial3DMessageTestModel");
+    {   // Location message
+        MessageSparseSpatial3D::Description &message = model.newMessage<MessageSparseSpatial3D>("location");
+        message.setRadius(1);
+        message.newVariable<int>("id");  // unused by current test
+    }
+    {   // Circle agent
+        AgentDescription &agent = model.newAgent("agent");
+        agent.newVariable<int>("id");
+        agent.newVariable<float>("x");
+        agent.newVariable<float>("y");
+        agent.newVariable<float>("z");
+        agent.newVariable<unsigned int>("count");
+        agent.newVariable<unsigned int>("badCount");
+        auto &af = agent.newFunction("out", out_optional3DNone);
+        af.setMessageOutput("location");
+        af.setMessageOutputOptional(true);
+        agent.newFunction("in", in3D).setMessageInput("location");
+    }
+    {   // Layer #1
+        LayerDescription &layer = model.newLayer();
+        layer.addAgentFunction(out_optional3DNone);
+    }
+    {   // Layer #2
+        LayerDescription &layer = model.newLayer();
+        layer.addAgentFunction(in3D);
+    }
+    CUDASimulation cudaSimulation(model);
+
+    const int AGENT_COUNT = 2049;
+    AgentVector population(model.Agent("agent"), AGENT_COUNT);
+    {
+        std::default_random_engine rng;
+        std::uniform_real_distribution<float> dist(-5.0f, 5.0f);
+        for (unsigned int i = 0; i < AGENT_COUNT; i++) {
+            AgentVector::Agent instance = population[i];
+            instance.setVariable<int>("id", i);
+            instance.setVariable<float>("x", dist(rng));
+            instance.setVariable<float>("y", dist(rng));
+            instance.setVariable<float>("z", dist(rng));
+            instance.setVariable<unsigned int>("count", 1);
+        }
+        cudaSimulation.setPopulationData(population);
+    }
+
+    // Execute a single step of the model
+    cudaSimulation.step();
+
+    // No agent should have read a message
+    cudaSimulation.getPopulationData(population);
+    for (AgentVector::Agent ai : population) {
+        EXPECT_EQ(ai.getVariable<unsigned int>("count"), 0u);
+        EXPECT_EQ(ai.getVariable<unsigned int>("badCount"), 0u);
+    }
+}
+TEST(SparseSpatial3DMessageTest, BadRadius) {
+    ModelDescription model("SparseSpatial3DMessageTestModel");
+    MessageSparseSpatial3D::Description &message = model.newMessage<MessageSparseSpatial3D>("location");
+    EXPECT_THROW(message.setRadius(0), exception::InvalidArgument);
+    EXPECT_THROW(message.setRadius(-10), exception::InvalidArgument);
+    EXPECT_NO_THROW(message.setRadius(0.5f));
+    EXPECT_EQ(message.getRadius(), 0.5f);
+}
+TEST(SparseSpatial3DMessageTest, UnsetRadius) {
+    ModelDescription model("SparseSpatial3DMessageTestModel");
+    model.newMessage<MessageSparseSpatial3D>("location");
+    // Radius must be set before the model can be used
+    EXPECT_THROW(CUDASimulation m(model), exception::InvalidMessage);
+}
+
+}  // namespace test_message_sparse_spatial3d
+}  // namespace flamegpu
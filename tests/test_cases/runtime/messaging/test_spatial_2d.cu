@@ -3,7 +3,17 @@
 *
 * Tests cover:
 * > mandatory messaging, send/recieve
+* > mandatory messaging with Morton ordered bins
+* > periodic messaging, with row-major and Morton ordered bins
+* > deterministic index build
+* > incremental index build, and static message lists
+* > message lists which are views over agent variables
+* > declared message input variables, where unread variables are not reordered
+* > RTC agent functions without declared message input variables read every message variable
 */
+#include <cmath>
+#include <vector>
+
 #include "flamegpu/flamegpu.h"
 
 #include "gtest/gtest.h"
@@ -63,7 +73,7 @@ FLAMEGPU_AGENT_FUNCTION(in2D, MessageSpatial2D, MessageNone) {
     FLAMEGPU->setVariable<unsigned int>("badCount", badCount);
     return ALIVE;
 }
-TEST(Spatial2DMessageTest, Mandatory) {
+void mandatory2D(const bool morton_order) {
     std::unordered_map<int, unsigned int> bin_counts;
     // Construct model
     ModelDescription model("Spatial2DMessageTestModel");
@@ -72,6 +82,7 @@ TEST(Spatial2DMessageTest, Mandatory) {
         message.setMin(0, 0);
         message.setMax(11, 11);
         message.setRadius(1);
+        message.setMortonOrder(morton_order);
         // 11x11 bins, total 121
         message.newVariable<int>("id");  // unused by current test
     }
@@ -185,6 +196,13 @@ TEST(Spatial2DMessageTest, Mandatory) {
     EXPECT_EQ(badCountWrong, 0u);
 }
 
+TEST(Spatial2DMessageTest, Mandatory) {
+    mandatory2D(false);
+}
+TEST(Spatial2DMessageTest, MandatoryMorton) {
+    mandatory2D(true);
+}
+
 TEST(Spatial2DMessageTest, Optional) {
     /**
      * This test is same as Mandatory, however extra flag has been added to block certain agents from outputting messages
@@ -413,6 +431,137 @@ TEST(Spatial2DMessageTest, OptionalNone) {
     EXPECT_EQ(badCountWrong, 0u);
 }
 
+FLAMEGPU_AGENT_FUNCTION(in2DPeriodic, MessageSpatial2D, MessageNone) {
+    const float x1 = FLAMEGPU->getVariable<float>("x");
+    const float y1 = FLAMEGPU->getVariable<float>("y");
+    unsigned int count = 0;
+    unsigned int badCount = 0;
+    // Count how many messages we recieved (including our own)
+    // The wrap-corrected displacement of each must fall within the 3x3 Moore neighbourhood
+    for (const auto &message : FLAMEGPU->message_in(x1, y1)) {
+        const float relative[2] = { message.getRelativeX(), message.getRelativeY() };
+        bool isBad = false;
+        for (unsigned int i = 0; i < 2; ++i) {  // Iterate axis
+            if (relative[i] >= 2.0f || relative[i] <= -2.0f) {
+                isBad = true;
+            }
+        }
+        count++;
+        badCount = isBad ? badCount + 1 : badCount;
+    }
+    FLAMEGPU->setVariable<unsigned int>("count", count);
+    FLAMEGPU->setVariable<unsigned int>("badCount", badCount);
+    return ALIVE;
+}
+void periodic2D(const bool morton_order) {
+    const unsigned int GRID_DIM = 5;
+    std::unordered_map<int, unsigned int> bin_counts;
+    // Construct model
+    ModelDescription model("Spatial2DMessageTestModel");
+    {   // Location message
+        MessageSpatial2D::Description &message = model.newMessage<MessageSpatial2D>("location");
+        message.setMin(0, 0);
+        message.setMax(GRID_DIM, GRID_DIM);
+        message.setRadius(1);
+        message.setMortonOrder(morton_order);
+        message.setPeriodic(true);
+        // 5x5 bins, total 25, every bin neighbours 8 others
+        message.newVariable<int>("id");  // unused by current test
+    }
+    {   // Circle agent
+        AgentDescription &agent = model.newAgent("agent");
+        agent.newVariable<int>("id");
+        agent.newVariable<float>("x");
+        agent.newVariable<float>("y");
+        agent.newVariable<unsigned int>("myBin");
+        agent.newVariable<unsigned int>("count");  // Store the number of messages read, for validation
+        agent.newVariable<unsigned int>("badCount");  // Store how many messages are out of range
+        agent.newFunction("out", out_mandatory2D).setMessageOutput("location");
+        agent.newFunction("in", in2DPeriodic).setMessageInput("location");
+    }
+    {   // Layer #1
+        LayerDescription &layer = model.newLayer();
+        layer.addAgentFunction(out_mandatory2D);
+    }
+    {   // Layer #2
+        LayerDescription &layer = model.newLayer();
+        layer.addAgentFunction(in2DPeriodic);
+    }
+    CUDASimulation cudaSimulation(model);
+
+    const int AGENT_COUNT = 2049;
+    AgentVector population(model.Agent("agent"), AGENT_COUNT);
+    {
+        std::default_random_engine rng;
+        std::uniform_real_distribution<float> dist(0.0f, static_cast<float>(GRID_DIM));
+        for (unsigned int i = 0; i < AGENT_COUNT; i++) {
+            AgentVector::Agent instance = population[i];
+            instance.setVariable<int>("id", i);
+            float pos[2] = { dist(rng), dist(rng) };
+            instance.setVariable<float>("x", pos[0]);
+            instance.setVariable<float>("y", pos[1]);
+            // Solve the bin index
+            const unsigned int bin_index =
+                static_cast<unsigned int>(pos[1]) * GRID_DIM +
+                static_cast<unsigned int>(pos[0]);
+            instance.setVariable<unsigned int>("myBin", bin_index);
+            bin_counts[bin_index] += 1;
+        }
+        cudaSimulation.setPopulationData(population);
+    }
+
+    // Generate results expectation, neighbouring bins wrap over the environment bounds
+    std::unordered_map<int, unsigned int> bin_results;
+    for (int x1 = 0; x1 < static_cast<int>(GRID_DIM); x1++) {
+        for (int y1 = 0; y1 < static_cast<int>(GRID_DIM); y1++) {
+            unsigned int count_sum = 0;
+            for (int x2 = -1; x2 <= 1; x2++) {
+                for (int y2 = -1; y2 <= 1; y2++) {
+                    const int bin_pos2[2] = {
+                        (x1 + x2 + static_cast<int>(GRID_DIM)) % static_cast<int>(GRID_DIM),
+                        (y1 + y2 + static_cast<int>(GRID_DIM)) % static_cast<int>(GRID_DIM)
+                    };
+                    count_sum += bin_counts[bin_pos2[1] * GRID_DIM + bin_pos2[0]];
+                }
+            }
+            bin_results.emplace(y1 * GRID_DIM + x1, count_sum);
+        }
+    }
+
+    // Execute a single step of the model
+    cudaSimulation.step();
+
+    // Recover the results and check they match what was expected
+    cudaSimulation.getPopulationData(population);
+    unsigned int badCountWrong = 0;
+    for (AgentVector::Agent ai : population) {
+        unsigned int myBin = ai.getVariable<unsigned int>("myBin");
+        unsigned int myResult = ai.getVariable<unsigned int>("count");
+        EXPECT_EQ(myResult, bin_results.at(myBin));
+        if (ai.getVariable<unsigned int>("badCount"))
+            badCountWrong++;
+    }
+    EXPECT_EQ(badCountWrong, 0u);
+}
+TEST(Spatial2DMessageTest, Periodic) {
+    periodic2D(false);
+}
+TEST(Spatial2DMessageTest, PeriodicMorton) {
+    periodic2D(true);
+}
+TEST(Spatial2DMessageTest, PeriodicTooSmall) {
+    ModelDescription model("Spatial2DMessageTestModel");
+    MessageSpatial2D::Description &message = model.newMessage<MessageSpatial2D>("location");
+    message.setMin(0, 0);
+    message.setMax(10, 2.5f);
+    message.setRadius(1);
+    EXPECT_FALSE(message.getPeriodic());
+    message.setPeriodic(true);
+    EXPECT_TRUE(message.getPeriodic());
+    // The y axis is too narrow to hold 3 bins
+    EXPECT_THROW(CUDASimulation m(model), exception::InvalidMessage);
+}
+
 TEST(Spatial2DMessageTest, BadRadius) {
     ModelDescription model("Spatial2DMessageTestModel");
     MessageSpatial2D::Description &message = model.newMessage<MessageSpatial2D>("location");
@@ -498,6 +647,407 @@ TEST(Spatial2DMessageTest, ReadEmpty) {
     EXPECT_EQ(pop_out[0].getVariable<unsigned int>("count"), 0u);
 }
 
+FLAMEGPU_AGENT_FUNCTION(out_deterministic2D, MessageNone, MessageSpatial2D) {
+    FLAMEGPU->message_out.setVariable<int>("id", FLAMEGPU->getVariable<int>("id"));
+    FLAMEGPU->message_out.setVariable<float>("value", FLAMEGPU->getVariable<float>("value"));
+    FLAMEGPU->message_out.setLocation(
+        FLAMEGPU->getVariable<float>("x"),
+        FLAMEGPU->getVariable<float>("y"));
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(in_deterministic2D, MessageSpatial2D, MessageNone) {
+    const float x1 = FLAMEGPU->getVariable<float>("x");
+    const float y1 = FLAMEGPU->getVariable<float>("y");
+    int last_bin = -1;
+    int last_id = -1;
+    unsigned int badCount = 0;
+    float sum = 0;
+    for (const auto &message : FLAMEGPU->message_in(x1, y1)) {
+        // Messages within a bin should be in the order they were output
+        const int bin = static_cast<int>(message.getVariable<float>("y")) * 5 + static_cast<int>(message.getVariable<float>("x"));
+        const int id = message.getVariable<int>("id");
+        if (bin == last_bin && id <= last_id)
+            badCount++;
+        last_bin = bin;
+        last_id = id;
+        sum += message.getVariable<float>("value");
+    }
+    FLAMEGPU->setVariable<unsigned int>("badCount", badCount);
+    FLAMEGPU->setVariable<float>("sum", sum);
+    return ALIVE;
+}
+TEST(Spatial2DMessageTest, Deterministic) {
+    // Construct model
+    ModelDescription model("Spatial2DMessageTestModel");
+    {   // Location message
+        MessageSpatial2D::Description &message = model.newMessage<MessageSpatial2D>("location");
+        message.setMin(0, 0);
+        message.setMax(5, 5);
+        message.setRadius(1);
+        EXPECT_FALSE(message.getDeterministic());
+        message.setDeterministic(true);
+        EXPECT_TRUE(message.getDeterministic());
+        message.newVariable<int>("id");
+        message.newVariable<float>("value");
+    }
+    {   // Circle agent
+        AgentDescription &agent = model.newAgent("agent");
+        agent.newVariable<int>("id");
+        agent.newVariable<float>("x");
+        agent.newVariable<float>("y");
+        agent.newVariable<float>("value");
+        agent.newVariable<unsigned int>("badCount");  // Store how many messages are out of order
+        agent.newVariable<float>("sum");  // Order sensitive sum of message values
+        agent.newFunction("out", out_deterministic2D).setMessageOutput("location");
+        agent.newFunction("in", in_deterministic2D).setMessageInput("location");
+    }
+    {   // Layer #1
+        LayerDescription &layer = model.newLayer();
+        layer.addAgentFunction(out_deterministic2D);
+    }
+    {   // Layer #2
+        LayerDescription &layer = model.newLayer();
+        layer.addAgentFunction(in_deterministic2D);
+    }
+    const int AGENT_COUNT = 2049;
+    // Values span many orders of magnitude, so their float sum depends on the order of summation
+    AgentVector population(model.Agent("agent"), AGENT_COUNT);
+    std::default_random_engine rng;
+    std::uniform_real_distribution<float> pos_dist(0.0f, 5.0f);
+    std::uniform_real_distribution<float> dist(-20.0f, 20.0f);
+    for (unsigned int i = 0; i < AGENT_COUNT; i++) {
+        AgentVector::Agent ai = population[i];
+        ai.setVariable<int>("id", i);
+        ai.setVariable<float>("x", pos_dist(rng));
+        ai.setVariable<float>("y", pos_dist(rng));
+        ai.setVariable<float>("value", std::pow(2.0f, dist(rng)));
+    }
+    // Run the model twice, results should be identical
+    std::vector<float> sums[2];
+    for (auto &s : sums) {
+        CUDASimulation cudaSimulation(model);
+        cudaSimulation.setPopulationData(population);
+        cudaSimulation.step();
+        AgentVector result(model.Agent("agent"));
+        cudaSimulation.getPopulationData(result);
+        for (AgentVector::Agent ai : result) {
+            EXPECT_EQ(ai.getVariable<unsigned int>("badCount"), 0u);
+            s.push_back(ai.getVariable<float>("sum"));
+        }
+    }
+    ASSERT_EQ(sums[0].size(), sums[1].size());
+    for (size_t i = 0; i < sums[0].size(); ++i) {
+        EXPECT_EQ(sums[0][i], sums[1][i]);
+    }
+}
+
+FLAMEGPU_AGENT_FUNCTION(move_incremental2D, MessageNone, MessageNone) {
+    // A single agent changes bin, part way through the simulation
+    if (FLAMEGPU->getVariable<int>("id") == 0 && FLAMEGPU->getStepCounter() == 3) {
+        FLAMEGPU->setVariable<float>("x", FLAMEGPU->getVariable<float>("x") + 5.0f);
+    }
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(out_incremental2D, MessageNone, MessageSpatial2D) {
+    FLAMEGPU->message_out.setVariable<unsigned int>("step", FLAMEGPU->getStepCounter());
+    FLAMEGPU->message_out.setLocation(
+        FLAMEGPU->getVariable<float>("x"),
+        FLAMEGPU->getVariable<float>("y"));
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(in_incremental2D, MessageSpatial2D, MessageNone) {
+    const float x1 = FLAMEGPU->getVariable<float>("x");
+    const float y1 = FLAMEGPU->getVariable<float>("y");
+    unsigned int count = 0;
+    unsigned int staleCount = 0;
+    for (const auto &message : FLAMEGPU->message_in(x1, y1)) {
+        // Only count messages within the Moore neighbourhood, as iteration may return messages from further bins
+        if (fabsf(floorf(message.getVariable<float>("x")) - floorf(x1)) <= 1.0f &&
+            fabsf(floorf(message.getVariable<float>("y")) - floorf(y1)) <= 1.0f) {
+            count++;
+        }
+        // Message data must be from the current step, even when the index is reused
+        if (message.getVariable<unsigned int>("step") != FLAMEGPU->getStepCounter()) {
+            staleCount++;
+        }
+    }
+    FLAMEGPU->setVariable<unsigned int>("count", count);
+    FLAMEGPU->setVariable<unsigned int>("staleCount", staleCount);
+    return ALIVE;
+}
+/**
+ * Builds a model where one agent sits at the centre of each bin, and runs it for several steps
+ * After each step, the number of messages each agent read from its Moore neighbourhood is compared against a brute force count
+ */
+void runIncremental2D(const bool incremental, const unsigned int static_steps, const bool move) {
+    ModelDescription model("Spatial2DMessageTestModel");
+    {   // Location message
+        MessageSpatial2D::Description &message = model.newMessage<MessageSpatial2D>("location");
+        message.setMin(0, 0);
+        message.setMax(10, 10);
+        message.setRadius(1);
+        message.setIncremental(incremental);
+        message.setStaticSteps(static_steps);
+        message.newVariable<unsigned int>("step");
+    }
+    {   // Circle agent
+        AgentDescription &agent = model.newAgent("agent");
+        agent.newVariable<int>("id");
+        agent.newVariable<float>("x");
+        agent.newVariable<float>("y");
+        agent.newVariable<unsigned int>("count", 0);
+        agent.newVariable<unsigned int>("staleCount", 0);
+        agent.newFunction("move", move_incremental2D);
+        agent.newFunction("out", out_incremental2D).setMessageOutput("location");
+        agent.newFunction("in", in_incremental2D).setMessageInput("location");
+    }
+    if (move) {
+        model.newLayer().addAgentFunction(move_incremental2D);
+    }
+    model.newLayer().addAgentFunction(out_incremental2D);
+    model.newLayer().addAgentFunction(in_incremental2D);
+    AgentVector population(model.Agent("agent"), 100);
+    for (unsigned int i = 0; i < 100; i++) {
+        AgentVector::Agent ai = population[i];
+        ai.setVariable<int>("id", i);
+        ai.setVariable<float>("x", static_cast<float>(i % 10) + 0.5f);
+        ai.setVariable<float>("y", static_cast<float>(i / 10) + 0.5f);
+    }
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.setPopulationData(population);
+    for (unsigned int step = 0; step < 6; ++step) {
+        cudaSimulation.step();
+        AgentVector result(model.Agent("agent"));
+        cudaSimulation.getPopulationData(result);
+        ASSERT_EQ(result.size(), 100u);
+        for (AgentVector::Agent ai : result) {
+            const float x = floorf(ai.getVariable<float>("x"));
+            const float y = floorf(ai.getVariable<float>("y"));
+            unsigned int expected = 0;
+            for (AgentVector::Agent aj : result) {
+                if (fabsf(floorf(aj.getVariable<float>("x")) - x) <= 1.0f &&
+                    fabsf(floorf(aj.getVariable<float>("y")) - y) <= 1.0f) {
+                    expected++;
+                }
+            }
+            EXPECT_EQ(ai.getVariable<unsigned int>("count"), expected);
+            EXPECT_EQ(ai.getVariable<unsigned int>("staleCount"), 0u);
+        }
+    }
+}
+TEST(Spatial2DMessageTest, Incremental) {
+    ModelDescription model("Spatial2DMessageTestModel");
+    MessageSpatial2D::Description &message = model.newMessage<MessageSpatial2D>("location");
+    EXPECT_FALSE(message.getIncremental());
+    message.setIncremental(true);
+    EXPECT_TRUE(message.getIncremental());
+    runIncremental2D(true, 0, true);
+}
+TEST(Spatial2DMessageTest, StaticSteps) {
+    ModelDescription model("Spatial2DMessageTestModel");
+    MessageSpatial2D::Description &message = model.newMessage<MessageSpatial2D>("location");
+    EXPECT_EQ(message.getStaticSteps(), 0u);
+    message.setStaticSteps(4);
+    EXPECT_EQ(message.getStaticSteps(), 4u);
+    runIncremental2D(false, 4, false);
+}
+TEST(Spatial2DMessageTest, IncrementalStaticSteps) {
+    // Bin changes are detected once the declared static steps have elapsed, the agent moves on the first such step
+    runIncremental2D(true, 3, true);
+}
+
+FLAMEGPU_AGENT_FUNCTION(in_view2D, MessageSpatial2D, MessageNone) {
+    const float x1 = FLAMEGPU->getVariable<float>("x");
+    const float y1 = FLAMEGPU->getVariable<float>("y");
+    unsigned int count = 0;
+    int idSum = 0;
+    for (const auto &message : FLAMEGPU->message_in(x1, y1)) {
+        // Only count messages within the Moore neighbourhood, as iteration may return messages from further bins
+        if (fabsf(floorf(message.getVariable<float>("x")) - floorf(x1)) <= 1.0f &&
+            fabsf(floorf(message.getVariable<float>("y")) - floorf(y1)) <= 1.0f) {
+            count++;
+            idSum += message.getVariable<int>("id");
+        }
+    }
+    FLAMEGPU->setVariable<unsigned int>("count", count);
+    FLAMEGPU->setVariable<int>("idSum", idSum);
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(move_view2D, MessageNone, MessageNone) {
+    // Agents drift between bins, so the view's index must follow the agent variables
+    FLAMEGPU->setVariable<float>("x", fmodf(FLAMEGPU->getVariable<float>("x") + 0.75f, 10.0f));
+    return ALIVE;
+}
+TEST(Spatial2DMessageTest, AgentView) {
+    ModelDescription model("Spatial2DMessageTestModel");
+    {   // Circle agent
+        AgentDescription &agent = model.newAgent("agent");
+        agent.newVariable<int>("id");
+        agent.newVariable<float>("x");
+        agent.newVariable<float>("y");
+        agent.newVariable<unsigned int>("count", 0);
+        agent.newVariable<int>("idSum", 0);
+        agent.newFunction("in", in_view2D).setMessageInput("location");
+        agent.newFunction("move", move_view2D);
+    }
+    {   // Location message, with no output function
+        MessageSpatial2D::Description &message = model.newMessage<MessageSpatial2D>("location");
+        message.setMin(0, 0);
+        message.setMax(10, 10);
+        message.setRadius(1);
+        EXPECT_EQ(message.getViewAgent(), "");
+        message.setAgentView("agent");
+        EXPECT_EQ(message.getViewAgent(), "agent");
+        EXPECT_EQ(message.getViewState(), ModelData::DEFAULT_STATE);
+        message.newVariable<int>("id");
+    }
+    model.newLayer().addAgentFunction(in_view2D);
+    model.newLayer().addAgentFunction(move_view2D);
+    const unsigned int AGENT_COUNT = 200;
+    AgentVector population(model.Agent("agent"), AGENT_COUNT);
+    std::default_random_engine rng;
+    std::uniform_real_distribution<float> dist(0.0f, 10.0f);
+    for (unsigned int i = 0; i < AGENT_COUNT; i++) {
+        AgentVector::Agent ai = population[i];
+        ai.setVariable<int>("id", i);
+        ai.setVariable<float>("x", dist(rng));
+        ai.setVariable<float>("y", dist(rng));
+    }
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.setPopulationData(population);
+    for (unsigned int step = 0; step < 3; ++step) {
+        // Agents read the view before they move, so compare against the locations prior to the step
+        AgentVector before(model.Agent("agent"));
+        cudaSimulation.getPopulationData(before);
+        cudaSimulation.step();
+        AgentVector result(model.Agent("agent"));
+        cudaSimulation.getPopulationData(result);
+        ASSERT_EQ(result.size(), AGENT_COUNT);
+        for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+            const float x = floorf(before[i].getVariable<float>("x"));
+            const float y = floorf(before[i].getVariable<float>("y"));
+            unsigned int expectedCount = 0;
+            int expectedIdSum = 0;
+            for (AgentVector::Agent aj : before) {
+                if (fabsf(floorf(aj.getVariable<float>("x")) - x) <= 1.0f &&
+                    fabsf(floorf(aj.getVariable<float>("y")) - y) <= 1.0f) {
+                    expectedCount++;
+                    expectedIdSum += aj.getVariable<int>("id");
+                }
+            }
+            EXPECT_EQ(result[i].getVariable<int>("id"), before[i].getVariable<int>("id"));
+            EXPECT_EQ(result[i].getVariable<unsigned int>("count"), expectedCount);
+            EXPECT_EQ(result[i].getVariable<int>("idSum"), expectedIdSum);
+        }
+    }
+}
+TEST(Spatial2DMessageTest, AgentViewBadAgent) {
+    ModelDescription model("Spatial2DMessageTestModel");
+    AgentDescription &agent = model.newAgent("agent");
+    MessageSpatial2D::Description &message = model.newMessage<MessageSpatial2D>("location");
+    EXPECT_THROW(message.setAgentView("agent2"), exception::InvalidAgentName);
+    EXPECT_THROW(message.setAgentView("agent", "state2"), exception::InvalidStateName);
+    EXPECT_EQ(message.getViewAgent(), "");
+    agent.newVariable<float>("x");
+    message.setMin(0, 0);
+    message.setMax(10, 10);
+    message.setRadius(1);
+    EXPECT_NO_THROW(message.setAgentView("agent"));
+    // The agent has no variable 'y'
+    EXPECT_THROW(CUDASimulation c(model), exception::InvalidMessage);
+}
+TEST(Spatial2DMessageTest, AgentViewOutput) {
+    ModelDescription model("Spatial2DMessageTestModel");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<int>("id");
+    agent.newVariable<float>("x");
+    agent.newVariable<float>("y");
+    MessageSpatial2D::Description &message = model.newMessage<MessageSpatial2D>("location");
+    message.setMin(0, 0);
+    message.setMax(10, 10);
+    message.setRadius(1);
+    message.newVariable<int>("id");
+    message.setAgentView("agent");
+    agent.newFunction("out", out_mandatory2D).setMessageOutput("location");
+    model.newLayer().addAgentFunction(out_mandatory2D);
+    // A view has no message list to output to
+    EXPECT_THROW(CUDASimulation c(model), exception::InvalidMessage);
+}
+FLAMEGPU_AGENT_FUNCTION(out_readset2D, MessageNone, MessageSpatial2D) {
+    const int id = FLAMEGPU->getVariable<int>("id");
+    FLAMEGPU->message_out.setVariable<int>("id", id);
+    // These variables are never read, so are not reordered during the index build
+    FLAMEGPU->message_out.setVariable<int>("unread_id", -id);
+    FLAMEGPU->message_out.setVariable<float, 4>("unread", 0, static_cast<float>(id));
+    FLAMEGPU->message_out.setLocation(
+        FLAMEGPU->getVariable<float>("x"),
+        FLAMEGPU->getVariable<float>("y"));
+    return ALIVE;
+}
+TEST(Spatial2DMessageTest, MessageInputVariables) {
+    ModelDescription model("Spatial2DMessageTestModel");
+    {   // Location message
+        MessageSpatial2D::Description &message = model.newMessage<MessageSpatial2D>("location");
+        message.setMin(0, 0);
+        message.setMax(10, 10);
+        message.setRadius(1);
+        message.newVariable<int>("id");
+        message.newVariable<int>("unread_id");
+        message.newVariable<float, 4>("unread");
+    }
+    {   // Circle agent
+        AgentDescription &agent = model.newAgent("agent");
+        agent.newVariable<int>("id");
+        agent.newVariable<float>("x");
+        agent.newVariable<float>("y");
+        agent.newVariable<unsigned int>("count", 0);
+        agent.newVariable<int>("idSum", 0);
+        agent.newFunction("out", out_readset2D).setMessageOutput("location");
+        AgentFunctionDescription &in = agent.newFunction("in", in_view2D);
+        in.setMessageInput("location");
+        in.setMessageInputVariables({ "id" });
+        agent.newFunction("move", move_view2D);
+    }
+    model.newLayer().addAgentFunction(out_readset2D);
+    model.newLayer().addAgentFunction(in_view2D);
+    model.newLayer().addAgentFunction(move_view2D);
+    const unsigned int AGENT_COUNT = 200;
+    AgentVector population(model.Agent("agent"), AGENT_COUNT);
+    std::default_random_engine rng;
+    std::uniform_real_distribution<float> dist(0.0f, 10.0f);
+    for (unsigned int i = 0; i < AGENT_COUNT; i++) {
+        AgentVector::Agent ai = population[i];
+        ai.setVariable<int>("id", i);
+        ai.setVariable<float>("x", dist(rng));
+        ai.setVariable<float>("y", dist(rng));
+    }
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.setPopulationData(population);
+    for (unsigned int step = 0; step < 3; ++step) {
+        AgentVector before(model.Agent("agent"));
+        cudaSimulation.getPopulationData(before);
+        cudaSimulation.step();
+        AgentVector result(model.Agent("agent"));
+        cudaSimulation.getPopulationData(result);
+        ASSERT_EQ(result.size(), AGENT_COUNT);
+        for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+            const float x = floorf(before[i].getVariable<float>("x"));
+            const float y = floorf(before[i].getVariable<float>("y"));
+            unsigned int expectedCount = 0;
+            int expectedIdSum = 0;
+            for (AgentVector::Agent aj : before) {
+                if (fabsf(floorf(aj.getVariable<float>("x")) - x) <= 1.0f &&
+                    fabsf(floorf(aj.getVariable<float>("y")) - y) <= 1.0f) {
+                    expectedCount++;
+                    expectedIdSum += aj.getVariable<int>("id");
+                }
+            }
+            EXPECT_EQ(result[i].getVariable<unsigned int>("count"), expectedCount);
+            EXPECT_EQ(result[i].getVariable<int>("idSum"), expectedIdSum);
+        }
+    }
+}
+
 FLAMEGPU_AGENT_FUNCTION(ArrayOut, MessageNone, MessageSpatial2D) {
     const unsigned int x = FLAMEGPU->getVariable<unsigned int, 2>("index", 0);
     const unsigned int y = FLAMEGPU->getVariable<unsigned int, 2>("index", 1);
@@ -645,6 +1195,69 @@ TEST(RTCSpatial2DMessageTest, ArrayVariable) {
     }
 }
 
+const char* rtc_SplitNameOut_func = R"###(
+FLAMEGPU_AGENT_FUNCTION(SplitNameOut, flamegpu::MessageNone, flamegpu::MessageSpatial2D) {
+    const unsigned int x = FLAMEGPU->getVariable<unsigned int, 2>("index", 0);
+    const unsigned int y = FLAMEGPU->getVariable<unsigned int, 2>("index", 1);
+    FLAMEGPU->message_out.setVariable<unsigned int>("value", x * 3 + y * 7);
+    FLAMEGPU->message_out.setLocation(static_cast<float>(x), static_cast<float>(y));
+    return flamegpu::ALIVE;
+}
+)###";
+const char* rtc_SplitNameIn_func = R"###(
+// The message variable's name never appears as a single string literal
+#define VALUE_NAME "val" "ue"
+FLAMEGPU_AGENT_FUNCTION(SplitNameIn, flamegpu::MessageSpatial2D, flamegpu::MessageNone) {
+    const unsigned int x = FLAMEGPU->getVariable<unsigned int, 2>("index", 0);
+    const unsigned int y = FLAMEGPU->getVariable<unsigned int, 2>("index", 1);
+    for (auto &message : FLAMEGPU->message_in(static_cast<float>(x), static_cast<float>(y))) {
+        if (static_cast<unsigned int>(message.getVariable<float>("x")) == x &&
+            static_cast<unsigned int>(message.getVariable<float>("y")) == y) {
+            FLAMEGPU->setVariable<unsigned int>("message_read", message.getVariable<unsigned int>(VALUE_NAME));
+            break;
+        }
+    }
+    return flamegpu::ALIVE;
+}
+)###";
+/**
+ * RTC agent functions which do not declare their message input variables must be assumed to read every message variable
+ */
+TEST(RTCSpatial2DMessageTest, UndeclaredInputVariables) {
+    const unsigned int SQRT_AGENT_COUNT = 32;
+    ModelDescription m("Model");
+    MessageSpatial2D::Description& message = m.newMessage<MessageSpatial2D>("Message");
+    message.setMin(0, 0);
+    message.setMax(static_cast<float>(SQRT_AGENT_COUNT), static_cast<float>(SQRT_AGENT_COUNT));
+    message.setRadius(1);
+    message.newVariable<unsigned int>("value");
+    AgentDescription& a = m.newAgent("Agent");
+    a.newVariable<unsigned int, 2>("index");
+    a.newVariable<unsigned int>("message_read", UINT_MAX);
+    AgentFunctionDescription& fo = a.newRTCFunction("OutFunction", rtc_SplitNameOut_func);
+    fo.setMessageOutput(message);
+    AgentFunctionDescription& fi = a.newRTCFunction("InFunction", rtc_SplitNameIn_func);
+    fi.setMessageInput(message);
+    m.newLayer().addAgentFunction(fo);
+    m.newLayer().addAgentFunction(fi);
+    // Agents are created in reverse order of their bin, so the message list must be reordered when the index is built
+    AgentVector pop(a, SQRT_AGENT_COUNT * SQRT_AGENT_COUNT);
+    int k = 0;
+    for (unsigned int i = SQRT_AGENT_COUNT; i > 0; --i) {
+        for (unsigned int j = SQRT_AGENT_COUNT; j > 0; --j) {
+            pop[k++].setVariable<unsigned int, 2>("index", { i - 1, j - 1 });
+        }
+    }
+    CUDASimulation c(m);
+    c.setPopulationData(pop);
+    c.step();
+    c.getPopulationData(pop);
+    for (AgentVector::Agent ai : pop) {
+        const std::array<unsigned int, 2> index = ai.getVariable<unsigned int, 2>("index");
+        ASSERT_EQ(ai.getVariable<unsigned int>("message_read"), index[0] * 3 + index[1] * 7);
+    }
+}
+
 #if defined(USE_GLM)
 FLAMEGPU_AGENT_FUNCTION(ArrayOut_glm, MessageNone, MessageSpatial2D) {
     const unsigned int x = FLAMEGPU->getVariable<unsigned int, 2>("index", 0);
@@ -3,7 +3,16 @@
 *
 * Tests cover:
 * > mandatory messaging, send/recieve
+* > mandatory messaging with Morton ordered bins
+* > periodic messaging, with row-major and Morton ordered bins
+* > deterministic index build
+* > incremental index build, and static message lists
+* > message lists which are views over agent variables
 */
+#include <cmath>
+#include <map>
+#include <vector>
+
 #include "flamegpu/flamegpu.h"
 
 #include "gtest/gtest.h"
@@ -69,7 +78,7 @@ FLAMEGPU_AGENT_FUNCTION(in3D, MessageSpatial3D, MessageNone) {
     FLAMEGPU->setVariable<unsigned int>("badCount", badCount);
     return ALIVE;
 }
-TEST(Spatial3DMessageTest, Mandatory) {
+void mandatory3D(const bool morton_order) {
     std::unordered_map<int, unsigned int> bin_counts;
     // Construct model
     ModelDescription model("Spatial3DMessageTestModel");
@@ -78,6 +87,7 @@ TEST(Spatial3DMessageTest, Mandatory) {
         message.setMin(0, 0, 0);
         message.setMax(5, 5, 5);
         message.setRadius(1);
+        message.setMortonOrder(morton_order);
         // 5x5x5 bins, total 125
         message.newVariable<int>("id");  // unused by current test
     }
@@ -206,6 +216,13 @@ TEST(Spatial3DMessageTest, Mandatory) {
     EXPECT_EQ(badCountWrong, 0u);
 }
 
+TEST(Spatial3DMessageTest, Mandatory) {
+    mandatory3D(false);
+}
+TEST(Spatial3DMessageTest, MandatoryMorton) {
+    mandatory3D(true);
+}
+
 TEST(Spatial3DMessageTest, Optional) {
     /**
      * This test is same as Mandatory, however extra flag has been added to block certain agents from outputting messages
@@ -454,6 +471,147 @@ TEST(Spatial3DMessageTest, OptionalNone) {
 
 
 
+FLAMEGPU_AGENT_FUNCTION(in3DPeriodic, MessageSpatial3D, MessageNone) {
+    const float x1 = FLAMEGPU->getVariable<float>("x");
+    const float y1 = FLAMEGPU->getVariable<float>("y");
+    const float z1 = FLAMEGPU->getVariable<float>("z");
+    unsigned int count = 0;
+    unsigned int badCount = 0;
+    // Count how many messages we received (including our own)
+    // The wrap-corrected displacement of each must fall within the 3x3x3 Moore neighbourhood
+    for (const auto &message : FLAMEGPU->message_in(x1, y1, z1)) {
+        const float relative[3] = { message.getRelativeX(), message.getRelativeY(), message.getRelativeZ() };
+        bool isBad = false;
+        for (unsigned int i = 0; i < 3; ++i) {  // Iterate axis
+            if (relative[i] >= 2.0f || relative[i] <= -2.0f) {
+                isBad = true;
+            }
+        }
+        count++;
+        badCount = isBad ? badCount + 1 : badCount;
+    }
+    FLAMEGPU->setVariable<unsigned int>("count", count);
+    FLAMEGPU->setVariable<unsigned int>("badCount", badCount);
+    return ALIVE;
+}
+void periodic3D(const bool morton_order) {
+    const unsigned int GRID_DIM = 5;
+    std::unordered_map<int, unsigned int> bin_counts;
+    // Construct model
+    ModelDescription model("Spatial3DMessageTestModel");
+    {   // Location message
+        MessageSpatial3D::Description &message = model.newMessage<MessageSpatial3D>("location");
+        message.setMin(0, 0, 0);
+        message.setMax(GRID_DIM, GRID_DIM, GRID_DIM);
+        message.setRadius(1);
+        message.setMortonOrder(morton_order);
+        message.setPeriodic(true);
+        // 5x5x5 bins, total 125, every bin neighbours 26 others
+        message.newVariable<int>("id");  // unused by current test
+    }
+    {   // Circle agent
+        AgentDescription &agent = model.newAgent("agent");
+        agent.newVariable<int>("id");
+        agent.newVariable<float>("x");
+        agent.newVariable<float>("y");
+        agent.newVariable<float>("z");
+        agent.newVariable<unsigned int>("myBin");
+        agent.newVariable<unsigned int>("count");  // Store the number of messages read, for validation
+        agent.newVariable<unsigned int>("badCount");  // Store how many messages are out of range
+        agent.newFunction("out", out_mandatory3D).setMessageOutput("location");
+        agent.newFunction("in", in3DPeriodic).setMessageInput("location");
+    }
+    {   // Layer #1
+        LayerDescription &layer = model.newLayer();
+        layer.addAgentFunction(out_mandatory3D);
+    }
+    {   // Layer #2
+        LayerDescription &layer = model.newLayer();
+        layer.addAgentFunction(in3DPeriodic);
+    }
+    CUDASimulation cudaSimulation(model);
+
+    const int AGENT_COUNT = 2049;
+    AgentVector population(model.Agent("agent"), AGENT_COUNT);
+    {
+        std::default_random_engine rng;
+        std::uniform_real_distribution<float> dist(0.0f, static_cast<float>(GRID_DIM));
+        for (unsigned int i = 0; i < AGENT_COUNT; i++) {
+            AgentVector::Agent instance = population[i];
+            instance.setVariable<int>("id", i);
+            float pos[3] = { dist(rng), dist(rng), dist(rng) };
+            instance.setVariable<float>("x", pos[0]);
+            instance.setVariable<float>("y", pos[1]);
+            instance.setVariable<float>("z", pos[2]);
+            // Solve the bin index
+            const unsigned int bin_index =
+                static_cast<unsigned int>(pos[2]) * GRID_DIM * GRID_DIM +
+                static_cast<unsigned int>(pos[1]) * GRID_DIM +
+                static_cast<unsigned int>(pos[0]);
+            instance.setVariable<unsigned int>("myBin", bin_index);
+            bin_counts[bin_index] += 1;
+        }
+        cudaSimulation.setPopulationData(population);
+    }
+
+    // Generate results expectation, neighbouring bins wrap over the environment bounds
+    const int DIM = static_cast<int>(GRID_DIM);
+    std::unordered_map<int, unsigned int> bin_results;
+    for (int x1 = 0; x1 < DIM; x1++) {
+        for (int y1 = 0; y1 < DIM; y1++) {
+            for (int z1 = 0; z1 < DIM; z1++) {
+                unsigned int count_sum = 0;
+                for (int x2 = -1; x2 <= 1; x2++) {
+                    for (int y2 = -1; y2 <= 1; y2++) {
+                        for (int z2 = -1; z2 <= 1; z2++) {
+                            const int bin_pos2[3] = {
+                                (x1 + x2 + DIM) % DIM,
+                                (y1 + y2 + DIM) % DIM,
+                                (z1 + z2 + DIM) % DIM
+                            };
+                            count_sum += bin_counts[(bin_pos2[2] * DIM + bin_pos2[1]) * DIM + bin_pos2[0]];
+                        }
+                    }
+                }
+                bin_results.emplace((z1 * DIM + y1) * DIM + x1, count_sum);
+            }
+        }
+    }
+
+    // Execute a single step of the model
+    cudaSimulation.step();
+
+    // Recover the results and check they match what was expected
+    cudaSimulation.getPopulationData(population);
+    unsigned int badCountWrong = 0;
+    for (AgentVector::Agent ai : population) {
+        unsigned int myBin = ai.getVariable<unsigned int>("myBin");
+        unsigned int myResult = ai.getVariable<unsigned int>("count");
+        EXPECT_EQ(myResult, bin_results.at(myBin));
+        if (ai.getVariable<unsigned int>("badCount"))
+            badCountWrong++;
+    }
+    EXPECT_EQ(badCountWrong, 0u);
+}
+TEST(Spatial3DMessageTest, Periodic) {
+    periodic3D(false);
+}
+TEST(Spatial3DMessageTest, PeriodicMorton) {
+    periodic3D(true);
+}
+TEST(Spatial3DMessageTest, PeriodicTooSmall) {
+    ModelDescription model("Spatial3DMessageTestModel");
+    MessageSpatial3D::Description &message = model.newMessage<MessageSpatial3D>("location");
+    message.setMin(0, 0, 0);
+    message.setMax(10, 10, 2.5f);
+    message.setRadius(1);
+    EXPECT_FALSE(message.getPeriodic());
+    message.setPeriodic(true);
+    EXPECT_TRUE(message.getPeriodic());
+    // The z axis is too narrow to hold 3 bins
+    EXPECT_THROW(CUDASimulation m(model), exception::InvalidMessage);
+}
+
 TEST(Spatial3DMessageTest, BadRadius) {
     ModelDescription model("Spatial3DMessageTestModel");
     MessageSpatial3D::Description &message = model.newMessage<MessageSpatial3D>("location");
@@ -545,6 +703,414 @@ TEST(Spatial3DMessageTest, ReadEmpty) {
 
 
 
+FLAMEGPU_AGENT_FUNCTION(out_deterministic3D, MessageNone, MessageSpatial3D) {
+    FLAMEGPU->message_out.setVariable<int>("id", FLAMEGPU->getVariable<int>("id"));
+    FLAMEGPU->message_out.setVariable<float>("value", FLAMEGPU->getVariable<float>("value"));
+    FLAMEGPU->message_out.setLocation(
+        FLAMEGPU->getVariable<float>("x"),
+        FLAMEGPU->getVariable<float>("y"),
+        FLAMEGPU->getVariable<float>("z"));
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(in_deterministic3D, MessageSpatial3D, MessageNone) {
+    const float x1 = FLAMEGPU->getVariable<float>("x");
+    const float y1 = FLAMEGPU->getVariable<float>("y");
+    const float z1 = FLAMEGPU->getVariable<float>("z");
+    int last_bin = -1;
+    int last_id = -1;
+    unsigned int badCount = 0;
+    float sum = 0;
+    for (const auto &message : FLAMEGPU->message_in(x1, y1, z1)) {
+        // Messages within a bin should be in the order they were output
+        const int bin = (static_cast<int>(message.getVariable<float>("z")) * 5
+            + static_cast<int>(message.getVariable<float>("y"))) * 5
+            + static_cast<int>(message.getVariable<float>("x"));
+        const int id = message.getVariable<int>("id");
+        if (bin == last_bin && id <= last_id)
+            badCount++;
+        last_bin = bin;
+        last_id = id;
+        sum += message.getVariable<float>("value");
+    }
+    FLAMEGPU->setVariable<unsigned int>("badCount", badCount);
+    FLAMEGPU->setVariable<float>("sum", sum);
+    return ALIVE;
+}
+TEST(Spatial3DMessageTest, Deterministic) {
+    // Construct model
+    ModelDescription model("Spatial3DMessageTestModel");
+    {   // Location message
+        MessageSpatial3D::Description &message = model.newMessage<MessageSpatial3D>("location");
+        message.setMin(0, 0, 0);
+        message.setMax(5, 5, 5);
+        message.setRadius(1);
+        EXPECT_FALSE(message.getDeterministic());
+        message.setDeterministic(true);
+        EXPECT_TRUE(message.getDeterministic());
+        message.newVariable<int>("id");
+        message.newVariable<float>("value");
+    }
+    {   // Circle agent
+        AgentDescription &agent = model.newAgent("agent");
+        agent.newVariable<int>("id");
+        agent.newVariable<float>("x");
+        agent.newVariable<float>("y");
+        agent.newVariable<float>("z");
+        agent.newVariable<float>("value");
+        agent.newVariable<unsigned int>("badCount");  // Store how many messages are out of order
+        agent.newVariable<float>("sum");  // Order sensitive sum of message values
+        agent.newFunction("out", out_deterministic3D).setMessageOutput("location");
+        agent.newFunction("in", in_deterministic3D).setMessageInput("location");
+    }
+    {   // Layer #1
+        LayerDescription &layer = model.newLayer();
+        layer.addAgentFunction(out_deterministic3D);
+    }
+    {   // Layer #2
+        LayerDescription &layer = model.newLayer();
+        layer.addAgentFunction(in_deterministic3D);
+    }
+    const int AGENT_COUNT = 2049;
+    // Values span many orders of magnitude, so their float sum depends on the order of summation
+    AgentVector population(model.Agent("agent"), AGENT_COUNT);
+    std::default_random_engine rng;
+    std::uniform_real_distribution<float> pos_dist(0.0f, 5.0f);
+    std::uniform_real_distribution<float> dist(-20.0f, 20.0f);
+    for (unsigned int i = 0; i < AGENT_COUNT; i++) {
+        AgentVector::Agent ai = population[i];
+        ai.setVariable<int>("id", i);
+        ai.setVariable<float>("x", pos_dist(rng));
+        ai.setVariable<float>("y", pos_dist(rng));
+        ai.setVariable<float>("z", pos_dist(rng));
+        ai.setVariable<float>("value", std::pow(2.0f, dist(rng)));
+    }
+    // Run the model twice, results should be identical
+    std::vector<float> sums[2];
+    for (auto &s : sums) {
+        CUDASimulation cudaSimulation(model);
+        cudaSimulation.setPopulationData(population);
+        cudaSimulation.step();
+        AgentVector result(model.Agent("agent"));
+        cudaSimulation.getPopulationData(result);
+        for (AgentVector::Agent ai : result) {
+            EXPECT_EQ(ai.getVariable<unsigned int>("badCount"), 0u);
+            s.push_back(ai.getVariable<float>("sum"));
+        }
+    }
+    ASSERT_EQ(sums[0].size(), sums[1].size());
+    for (size_t i = 0; i < sums[0].size(); ++i) {
+        EXPECT_EQ(sums[0][i], sums[1][i]);
+    }
+}
+
+FLAMEGPU_AGENT_FUNCTION(move_incremental3D, MessageNone, MessageNone) {
+    // A single agent changes bin, part way through the simulation
+    if (FLAMEGPU->getVariable<int>("id") == 0 && FLAMEGPU->getStepCounter() == 3) {
+        FLAMEGPU->setVariable<float>("x", FLAMEGPU->getVariable<float>("x") + 2.0f);
+    }
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(out_incremental3D, MessageNone, MessageSpatial3D) {
+    FLAMEGPU->message_out.setVariable<unsigned int>("step", FLAMEGPU->getStepCounter());
+    FLAMEGPU->message_out.setLocation(
+        FLAMEGPU->getVariable<float>("x"),
+        FLAMEGPU->getVariable<float>("y"),
+        FLAMEGPU->getVariable<float>("z"));
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(in_incremental3D, MessageSpatial3D, MessageNone) {
+    const float x1 = FLAMEGPU->getVariable<float>("x");
+    const float y1 = FLAMEGPU->getVariable<float>("y");
+    const float z1 = FLAMEGPU->getVariable<float>("z");
+    unsigned int count = 0;
+    unsigned int staleCount = 0;
+    for (const auto &message : FLAMEGPU->message_in(x1, y1, z1)) {
+        // Only count messages within the Moore neighbourhood, as iteration may return messages from further bins
+        if (fabsf(floorf(message.getVariable<float>("x")) - floorf(x1)) <= 1.0f &&
+            fabsf(floorf(message.getVariable<float>("y")) - floorf(y1)) <= 1.0f &&
+            fabsf(floorf(message.getVariable<float>("z")) - floorf(z1)) <= 1.0f) {
+            count++;
+        }
+        // Message data must be from the current step, even when the index is reused
+        if (message.getVariable<unsigned int>("step") != FLAMEGPU->getStepCounter()) {
+            staleCount++;
+        }
+    }
+    FLAMEGPU->setVariable<unsigned int>("count", count);
+    FLAMEGPU->setVariable<unsigned int>("staleCount", staleCount);
+    return ALIVE;
+}
+/**
+ * Builds a model where one agent sits at the centre of each bin, and runs it for several steps
+ * After each step, the number of messages each agent read from its Moore neighbourhood is compared against a brute force count
+ */
+void runIncremental3D(const bool incremental, const unsigned int static_steps, const bool move) {
+    ModelDescription model("Spatial3DMessageTestModel");
+    {   // Location message
+        MessageSpatial3D::Description &message = model.newMessage<MessageSpatial3D>("location");
+        message.setMin(0, 0, 0);
+        message.setMax(5, 5, 4);
+        message.setRadius(1);
+        message.setIncremental(incremental);
+        message.setStaticSteps(static_steps);
+        message.newVariable<unsigned int>("step");
+    }
+    {   // Circle agent
+        AgentDescription &agent = model.newAgent("agent");
+        agent.newVariable<int>("id");
+        agent.newVariable<float>("x");
+        agent.newVariable<float>("y");
+        agent.newVariable<float>("z");
+        agent.newVariable<unsigned int>("count", 0);
+        agent.newVariable<unsigned int>("staleCount", 0);
+        agent.newFunction("move", move_incremental3D);
+        agent.newFunction("out", out_incremental3D).setMessageOutput("location");
+        agent.newFunction("in", in_incremental3D).setMessageInput("location");
+    }
+    if (move) {
+        model.newLayer().addAgentFunction(move_incremental3D);
+    }
+    model.newLayer().addAgentFunction(out_incremental3D);
+    model.newLayer().addAgentFunction(in_incremental3D);
+    AgentVector population(model.Agent("agent"), 100);
+    for (unsigned int i = 0; i < 100; i++) {
+        AgentVector::Agent ai = population[i];
+        ai.setVariable<int>("id", i);
+        ai.setVariable<float>("x", static_cast<float>(i % 5) + 0.5f);
+        ai.setVariable<float>("y", static_cast<float>((i / 5) % 5) + 0.5f);
+        ai.setVariable<float>("z", static_cast<float>(i / 25) + 0.5f);
+    }
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.setPopulationData(population);
+    for (unsigned int step = 0; step < 6; ++step) {
+        cudaSimulation.step();
+        AgentVector result(model.Agent("agent"));
+        cudaSimulation.getPopulationData(result);
+        ASSERT_EQ(result.size(), 100u);
+        for (AgentVector::Agent ai : result) {
+            const float x = floorf(ai.getVariable<float>("x"));
+            const float y = floorf(ai.getVariable<float>("y"));
+            const float z = floorf(ai.getVariable<float>("z"));
+            unsigned int expected = 0;
+            for (AgentVector::Agent aj : result) {
+                if (fabsf(floorf(aj.getVariable<float>("x")) - x) <= 1.0f &&
+                    fabsf(floorf(aj.getVariable<float>("y")) - y) <= 1.0f &&
+                    fabsf(floorf(aj.getVariable<float>("z")) - z) <= 1.0f) {
+                    expected++;
+                }
+            }
+            EXPECT_EQ(ai.getVariable<unsigned int>("count"), expected);
+            EXPECT_EQ(ai.getVariable<unsigned int>("staleCount"), 0u);
+        }
+    }
+}
+TEST(Spatial3DMessageTest, Incremental) {
+    ModelDescription model("Spatial3DMessageTestModel");
+    MessageSpatial3D::Description &message = model.newMessage<MessageSpatial3D>("location");
+    EXPECT_FALSE(message.getIncremental());
+    message.setIncremental(true);
+    EXPECT_TRUE(message.getIncremental());
+    runIncremental3D(true, 0, true);
+}
+TEST(Spatial3DMessageTest, StaticSteps) {
+    ModelDescription model("Spatial3DMessageTestModel");
+    MessageSpatial3D::Description &message = model.newMessage<MessageSpatial3D>("location");
+    EXPECT_EQ(message.getStaticSteps(), 0u);
+    message.setStaticSteps(4);
+    EXPECT_EQ(message.getStaticSteps(), 4u);
+    runIncremental3D(false, 4, false);
+}
+TEST(Spatial3DMessageTest, IncrementalStaticSteps) {
+    // Bin changes are detected once the declared static steps have elapsed, the agent moves on the first such step
+    runIncremental3D(true, 3, true);
+}
+
+FLAMEGPU_AGENT_FUNCTION(in_view3D, MessageSpatial3D, MessageNone) {
+    const float x1 = FLAMEGPU->getVariable<float>("x");
+    const float y1 = FLAMEGPU->getVariable<float>("y");
+    const float z1 = FLAMEGPU->getVariable<float>("z");
+    unsigned int count = 0;
+    int idSum = 0;
+    for (const auto &message : FLAMEGPU->message_in(x1, y1, z1)) {
+        // Only count messages within the Moore neighbourhood, as iteration may return messages from further bins
+        if (fabsf(floorf(message.getVariable<float>("x")) - floorf(x1)) <= 1.0f &&
+            fabsf(floorf(message.getVariable<float>("y")) - floorf(y1)) <= 1.0f &&
+            fabsf(floorf(message.getVariable<float>("z")) - floorf(z1)) <= 1.0f) {
+            count++;
+            idSum += message.getVariable<int>("id");
+        }
+    }
+    FLAMEGPU->setVariable<unsigned int>("count", count);
+    FLAMEGPU->setVariable<int>("idSum", idSum);
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(move_view3D, MessageNone, MessageNone) {
+    // Agents drift between bins, so the view's index must follow the agent variables
+    FLAMEGPU->setVariable<float>("x", fmodf(FLAMEGPU->getVariable<float>("x") + 0.75f, 10.0f));
+    return ALIVE;
+}
+TEST(Spatial3DMessageTest, AgentView) {
+    ModelDescription model("Spatial3DMessageTestModel");
+    {   // Circle agent
+        AgentDescription &agent = model.newAgent("agent");
+        agent.newVariable<int>("id");
+        agent.newVariable<float>("x");
+        agent.newVariable<float>("y");
+        agent.newVariable<float>("z");
+        agent.newVariable<unsigned int>("count", 0);
+        agent.newVariable<int>("idSum", 0);
+        agent.newFunction("in", in_view3D).setMessageInput("location");
+        agent.newFunction("move", move_view3D);
+    }
+    {   // Location message, with no output function
+        MessageSpatial3D::Description &message = model.newMessage<MessageSpatial3D>("location");
+        message.setMin(0, 0, 0);
+        message.setMax(10, 10, 10);
+        message.setRadius(1);
+        EXPECT_EQ(message.getViewAgent(), "");
+        message.setAgentView("agent");
+        EXPECT_EQ(message.getViewAgent(), "agent");
+        EXPECT_EQ(message.getViewState(), ModelData::DEFAULT_STATE);
+        message.newVariable<int>("id");
+    }
+    model.newLayer().addAgentFunction(in_view3D);
+    model.newLayer().addAgentFunction(move_view3D);
+    const unsigned int AGENT_COUNT = 200;
+    AgentVector population(model.Agent("agent"), AGENT_COUNT);
+    std::default_random_engine rng;
+    std::uniform_real_distribution<float> dist(0.0f, 10.0f);
+    for (unsigned int i = 0; i < AGENT_COUNT; i++) {
+        AgentVector::Agent ai = population[i];
+        ai.setVariable<int>("id", i);
+        ai.setVariable<float>("x", dist(rng));
+        ai.setVariable<float>("y", dist(rng));
+        ai.setVariable<float>("z", dist(rng));
+    }
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.setPopulationData(population);
+    for (unsigned int step = 0; step < 3; ++step) {
+        // Agents read the view before they move, so compare against the locations prior to the step
+        AgentVector before(model.Agent("agent"));
+        cudaSimulation.getPopulationData(before);
+        cudaSimulation.step();
+        AgentVector result(model.Agent("agent"));
+        cudaSimulation.getPopulationData(result);
+        ASSERT_EQ(result.size(), AGENT_COUNT);
+        for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+            const float x = floorf(before[i].getVariable<float>("x"));
+            const float y = floorf(before[i].getVariable<float>("y"));
+            const float z = floorf(before[i].getVariable<float>("z"));
+            unsigned int expectedCount = 0;
+            int expectedIdSum = 0;
+            for (AgentVector::Agent aj : before) {
+                if (fabsf(floorf(aj.getVariable<float>("x")) - x) <= 1.0f &&
+                    fabsf(floorf(aj.getVariable<float>("y")) - y) <= 1.0f &&
+                    fabsf(floorf(aj.getVariable<float>("z")) - z) <= 1.0f) {
+                    expectedCount++;
+                    expectedIdSum += aj.getVariable<int>("id");
+                }
+            }
+            EXPECT_EQ(result[i].getVariable<int>("id"), before[i].getVariable<int>("id"));
+            EXPECT_EQ(result[i].getVariable<unsigned int>("count"), expectedCount);
+            EXPECT_EQ(result[i].getVariable<int>("idSum"), expectedIdSum);
+        }
+    }
+}
+FLAMEGPU_AGENT_FUNCTION_CONDITION(even_view3D) {
+    return FLAMEGPU->getVariable<int>("id") % 2 == 0;
+}
+FLAMEGPU_AGENT_FUNCTION(in_move_view3D, MessageSpatial3D, MessageNone) {
+    const float x1 = FLAMEGPU->getVariable<float>("x");
+    const float y1 = FLAMEGPU->getVariable<float>("y");
+    const float z1 = FLAMEGPU->getVariable<float>("z");
+    unsigned int count = 0;
+    int idSum = 0;
+    for (const auto &message : FLAMEGPU->message_in(x1, y1, z1)) {
+        if (fabsf(floorf(message.getVariable<float>("x")) - floorf(x1)) <= 1.0f &&
+            fabsf(floorf(message.getVariable<float>("y")) - floorf(y1)) <= 1.0f &&
+            fabsf(floorf(message.getVariable<float>("z")) - floorf(z1)) <= 1.0f) {
+            count++;
+            idSum += message.getVariable<int>("id");
+        }
+    }
+    FLAMEGPU->setVariable<unsigned int>("count", count);
+    FLAMEGPU->setVariable<int>("idSum", idSum);
+    // Move within the same function, whilst other agents may still be reading the view
+    FLAMEGPU->setVariable<float>("x", fmodf(x1 + 0.75f, 10.0f));
+    return ALIVE;
+}
+TEST(Spatial3DMessageTest, AgentView_SameLayerWriteCondition) {
+    ModelDescription model("Spatial3DMessageTestModel");
+    {
+        AgentDescription &agent = model.newAgent("agent");
+        agent.newVariable<int>("id");
+        agent.newVariable<float>("x");
+        agent.newVariable<float>("y");
+        agent.newVariable<float>("z");
+        agent.newVariable<unsigned int>("count", 0);
+        agent.newVariable<int>("idSum", 0);
+        AgentFunctionDescription &fn = agent.newFunction("in_move", in_move_view3D);
+        fn.setMessageInput("location");
+        fn.setFunctionCondition(even_view3D);
+    }
+    {
+        MessageSpatial3D::Description &message = model.newMessage<MessageSpatial3D>("location");
+        message.setMin(0, 0, 0);
+        message.setMax(10, 10, 10);
+        message.setRadius(1);
+        message.setAgentView("agent");
+        message.newVariable<int>("id");
+    }
+    model.newLayer().addAgentFunction(in_move_view3D);
+    const unsigned int AGENT_COUNT = 200;
+    AgentVector population(model.Agent("agent"), AGENT_COUNT);
+    std::default_random_engine rng;
+    std::uniform_real_distribution<float> dist(0.0f, 10.0f);
+    for (unsigned int i = 0; i < AGENT_COUNT; i++) {
+        AgentVector::Agent ai = population[i];
+        ai.setVariable<int>("id", i);
+        ai.setVariable<float>("x", dist(rng));
+        ai.setVariable<float>("y", dist(rng));
+        ai.setVariable<float>("z", dist(rng));
+    }
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.setPopulationData(population);
+    for (unsigned int step = 0; step < 3; ++step) {
+        AgentVector before(model.Agent("agent"));
+        cudaSimulation.getPopulationData(before);
+        cudaSimulation.step();
+        AgentVector result(model.Agent("agent"));
+        cudaSimulation.getPopulationData(result);
+        ASSERT_EQ(result.size(), AGENT_COUNT);
+        // Agent order may change when the condition is applied, so match agents by id
+        std::map<int, unsigned int> result_index;
+        for (unsigned int i = 0; i < result.size(); ++i) {
+            result_index.emplace(result[i].getVariable<int>("id"), i);
+        }
+        for (AgentVector::Agent ai : before) {
+            const int id = ai.getVariable<int>("id");
+            if (id % 2 != 0)
+                continue;
+            const float x = floorf(ai.getVariable<float>("x"));
+            const float y = floorf(ai.getVariable<float>("y"));
+            const float z = floorf(ai.getVariable<float>("z"));
+            unsigned int expectedCount = 0;
+            int expectedIdSum = 0;
+            // Every agent is a message, including those which failed the condition, at their location prior to the layer
+            for (AgentVector::Agent aj : before) {
+                if (fabsf(floorf(aj.getVariable<float>("x")) - x) <= 1.0f &&
+                    fabsf(floorf(aj.getVariable<float>("y")) - y) <= 1.0f &&
+                    fabsf(floorf(aj.getVariable<float>("z")) - z) <= 1.0f) {
+                    expectedCount++;
+                    expectedIdSum += aj.getVariable<int>("id");
+                }
+            }
+            const unsigned int r = result_index.at(id);
+            EXPECT_EQ(result[r].getVariable<unsigned int>("count"), expectedCount);
+            EXPECT_EQ(result[r].getVariable<int>("idSum"), expectedIdSum);
+        }
+    }
+}
 FLAMEGPU_AGENT_FUNCTION(ArrayOut, MessageNone, MessageSpatial3D) {
     const unsigned int x = FLAMEGPU->getVariable<unsigned int, 3>("index", 0);
     const unsigned int y = FLAMEGPU->getVariable<unsigned int, 3>("index", 1);
@@ -1,6 +1,9 @@
 #ifndef TESTS_TEST_CASES_RUNTIME_TEST_AGENT_RANDOM_H_
 #define TESTS_TEST_CASES_RUNTIME_TEST_AGENT_RANDOM_H_
 
+#include <cmath>
+#include <map>
+#include <set>
 #include <string>
 #include <tuple>
 #include <vector>
@@ -129,6 +132,8 @@ TEST(AgentRandomTest, AgentRandomCheck) {
         * Different seed produces different random numbers
         */
         results2.clear();
+        // Agent random is keyed by agent ID, so reset the ID counter to reissue the IDs of Test Model 1
+        cudaSimulation.reset();
         // Seed random
         cudaSimulation.initialise(5, args_1);
         cudaSimulation.setPopulationData(init_population);
@@ -225,6 +230,169 @@ TEST(AgentRandomTest, AgentRandomFunctionsNoExcept) {
     // Success if we get this far without an exception being thrown.
 }
 
+FLAMEGPU_AGENT_FUNCTION_CONDITION(random_host_condition) {
+    return FLAMEGPU->random.uniform<float>() < 0.5f;
+}
+FLAMEGPU_AGENT_FUNCTION(random_host_func, MessageNone, MessageNone) {
+    FLAMEGPU->setVariable<float>("uniform_float", FLAMEGPU->random.uniform<float>());
+    FLAMEGPU->setVariable<double>("uniform_double", FLAMEGPU->random.uniform<double>());
+    FLAMEGPU->setVariable<float>("normal_float", FLAMEGPU->random.normal<float>());
+    FLAMEGPU->setVariable<double>("normal_double", FLAMEGPU->random.normal<double>());
+    return ALIVE;
+}
+/**
+ * Each agent's stream depends only on (seed, step, layer, function, agent ID), so it can be reproduced on the host
+ * The condition reorders agents which fail it, so this also checks that the stream does not depend on the agent's index
+ */
+TEST(AgentRandomTest, AgentRandomHostReproducible) {
+    const unsigned int AGENT_COUNT = 1024;
+    const unsigned int STEPS = 3;
+    const unsigned int SEED = 12345;
+
+    ModelDescription model("random_model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<float>("uniform_float", -1.0f);
+    agent.newVariable<double>("uniform_double", -1.0);
+    agent.newVariable<float>("normal_float", -1.0f);
+    agent.newVariable<double>("normal_double", -1.0);
+    AgentFunctionDescription &af = agent.newFunction("random_host", random_host_func);
+    af.setFunctionCondition(random_host_condition);
+    model.newLayer().addAgentFunction(af);
+
+    AgentVector population(agent, AGENT_COUNT);
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.SimulationConfig().steps = STEPS;
+    cudaSimulation.SimulationConfig().random_seed = SEED;
+    cudaSimulation.setPopulationData(population);
+    ASSERT_NO_THROW(cudaSimulation.simulate());
+    cudaSimulation.getPopulationData(population);
+    ASSERT_EQ(population.size(), AGENT_COUNT);
+
+    RandomManager rng;
+    rng.reseed(SEED);
+    unsigned int executed = 0;
+    for (AgentVector::Agent instance : population) {
+        float uniform_float = -1.0f, normal_float = -1.0f;
+        double uniform_double = -1.0, normal_double = -1.0;
+        for (unsigned int step = 0; step < STEPS; ++step) {
+            AgentRandom condition(rng.agentStream(step, 0, "agent", "random_host", true), instance.getID());
+            if (condition.uniform<float>() < 0.5f) {
+                AgentRandom random(rng.agentStream(step, 0, "agent", "random_host"), instance.getID());
+                uniform_float = random.uniform<float>();
+                uniform_double = random.uniform<double>();
+                normal_float = random.normal<float>();
+                normal_double = random.normal<double>();
+                ++executed;
+            }
+        }
+        // Uniform conversions are exact, normal relies on device maths functions which may differ in the last bits
+        EXPECT_EQ(instance.getVariable<float>("uniform_float"), uniform_float);
+        EXPECT_EQ(instance.getVariable<double>("uniform_double"), uniform_double);
+        EXPECT_NEAR(instance.getVariable<float>("normal_float"), normal_float, 1e-5f * (1.0f + std::abs(normal_float)));
+        EXPECT_NEAR(instance.getVariable<double>("normal_double"), normal_double, 1e-12 * (1.0 + std::abs(normal_double)));
+    }
+    // Roughly half of the agents pass the condition each step
+    EXPECT_GT(executed, AGENT_COUNT * STEPS / 4);
+    EXPECT_LT(executed, AGENT_COUNT * STEPS * 3 / 4);
+}
+
+FLAMEGPU_AGENT_FUNCTION(random_layer_func, MessageNone, MessageNone) {
+    // The first execution writes a, the second writes b
+    if (FLAMEGPU->getVariable<double>("a") < 0) {
+        FLAMEGPU->setVariable<double>("a", FLAMEGPU->random.uniform<double>());
+    } else {
+        FLAMEGPU->setVariable<double>("b", FLAMEGPU->random.uniform<double>());
+    }
+    return ALIVE;
+}
+/**
+ * An agent function executed in multiple layers of a step draws a distinct stream in each layer
+ */
+TEST(AgentRandomTest, AgentRandomSameFunctionTwoLayers) {
+    const unsigned int AGENT_COUNT = 1024;
+    const unsigned int SEED = 12345;
+
+    ModelDescription model("random_model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<double>("a", -1.0);
+    agent.newVariable<double>("b", -1.0);
+    AgentFunctionDescription &af = agent.newFunction("random_layer", random_layer_func);
+    model.newLayer().addAgentFunction(af);
+    model.newLayer().addAgentFunction(af);
+
+    AgentVector population(agent, AGENT_COUNT);
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.SimulationConfig().random_seed = SEED;
+    cudaSimulation.setPopulationData(population);
+    ASSERT_NO_THROW(cudaSimulation.step());
+    cudaSimulation.getPopulationData(population);
+    ASSERT_EQ(population.size(), AGENT_COUNT);
+
+    RandomManager rng;
+    rng.reseed(SEED);
+    unsigned int matching = 0;
+    for (AgentVector::Agent instance : population) {
+        const double a = instance.getVariable<double>("a");
+        const double b = instance.getVariable<double>("b");
+        EXPECT_EQ(a, AgentRandom(rng.agentStream(0, 0, "agent", "random_layer"), instance.getID()).uniform<double>());
+        EXPECT_EQ(b, AgentRandom(rng.agentStream(0, 1, "agent", "random_layer"), instance.getID()).uniform<double>());
+        if (a == b)
+            ++matching;
+    }
+    EXPECT_EQ(matching, 0u);
+}
+
+FLAMEGPU_AGENT_FUNCTION(random_birth_func, MessageNone, MessageNone) {
+    if (FLAMEGPU->getStepCounter() == 0) {
+        // Births race for output slots, so the order (and ID) of newborns differs between runs
+        FLAMEGPU->agent_out.setVariable<id_t>("parent", FLAMEGPU->getID());
+    } else if (FLAMEGPU->getVariable<id_t>("parent") != ID_NOT_SET) {
+        FLAMEGPU->setVariable<double>("a", FLAMEGPU->random.uniform<double>());
+    }
+    return ALIVE;
+}
+/**
+ * Agents born on the device draw the same random stream each run, regardless of the order they were born in
+ */
+TEST(AgentRandomTest, AgentRandomDeviceBirthReproducible) {
+    const unsigned int AGENT_COUNT = 1024;
+    const unsigned int SEED = 12345;
+
+    ModelDescription model("random_model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<id_t>("parent", ID_NOT_SET);
+    agent.newVariable<double>("a", -1.0);
+    AgentFunctionDescription &af = agent.newFunction("random_birth", random_birth_func);
+    af.setAgentOutput(agent);
+    model.newLayer().addAgentFunction(af);
+
+    std::map<id_t, double> draws[2];
+    for (int run = 0; run < 2; ++run) {
+        AgentVector population(agent, AGENT_COUNT);
+        CUDASimulation cudaSimulation(model);
+        cudaSimulation.SimulationConfig().random_seed = SEED;
+        cudaSimulation.SimulationConfig().steps = 2;
+        cudaSimulation.setPopulationData(population);
+        ASSERT_NO_THROW(cudaSimulation.simulate());
+        cudaSimulation.getPopulationData(population);
+        ASSERT_EQ(population.size(), 2 * AGENT_COUNT);
+        for (AgentVector::Agent instance : population) {
+            const id_t parent = instance.getVariable<id_t>("parent");
+            if (parent != ID_NOT_SET) {
+                draws[run][parent] = instance.getVariable<double>("a");
+            }
+        }
+        ASSERT_EQ(draws[run].size(), AGENT_COUNT);
+    }
+    std::set<double> unique;
+    for (const auto &d : draws[0]) {
+        EXPECT_EQ(d.second, draws[1].at(d.first));
+        unique.insert(d.second);
+    }
+    // Siblings of different parents must not share a stream
+    EXPECT_EQ(unique.size(), AGENT_COUNT);
+}
+
 TEST(AgentRandomTest, AgentRandomArrayResizeNoExcept) {
     GTEST_COUT << "Testing d_random scales up / down without breaking" << std::endl;
 
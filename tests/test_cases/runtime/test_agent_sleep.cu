@@ -0,0 +1,330 @@
+/**
+* Tests of sleeping agents
+*
+* Tests cover:
+* > sleeping agents do not execute agent functions until their wake step
+* > functions which include sleeping agents can observe and wake them
+* > sleeping agents survive agent functions with agent death
+* > sleeping agents do not output messages
+* > RTC agent functions skip sleeping agents
+* > agents scheduling their next activation step, including beyond the wake calendar's year
+* > agents which have woken are reinserted into the wake calendar, including within the same step
+* > the wake calendar does not skip agents added whilst all agents are asleep
+*/
+
+#include "flamegpu/flamegpu.h"
+
+#include "gtest/gtest.h"
+
+namespace flamegpu {
+
+
+namespace test_agent_sleep {
+    const unsigned int AGENT_COUNT = 1024;
+    const char *MODEL_NAME = "Model";
+    const char *AGENT_NAME = "Agent";
+    const char *MESSAGE_NAME = "Message";
+
+FLAMEGPU_AGENT_FUNCTION(CountSleepOdd, MessageNone, MessageNone) {
+    FLAMEGPU->setVariable<unsigned int>("count", FLAMEGPU->getVariable<unsigned int>("count") + 1);
+    if (FLAMEGPU->getVariable<unsigned int>("i") % 2 == 1) {
+        FLAMEGPU->sleep(2);
+    }
+    return ALIVE;
+}
+TEST(AgentSleepTest, SleepSkipsAgents) {
+    ModelDescription model(MODEL_NAME);
+    AgentDescription &agent = model.newAgent(AGENT_NAME);
+    agent.newVariable<unsigned int>("i");
+    agent.newVariable<unsigned int>("count", 0);
+    agent.setSleepEnabled(true);
+    AgentFunctionDescription &fn = agent.newFunction("count", CountSleepOdd);
+    model.newLayer().addAgentFunction(fn);
+    AgentVector population(agent, AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+        population[i].setVariable<unsigned int>("i", i);
+    }
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.SimulationConfig().steps = 4;
+    cudaSimulation.setPopulationData(population);
+    cudaSimulation.simulate();
+    cudaSimulation.getPopulationData(population);
+    // Odd agents execute in step 0, sleep through steps 1 and 2, then execute in step 3
+    ASSERT_EQ(population.size(), AGENT_COUNT);
+    for (const auto &ai : population) {
+        const unsigned int i = ai.getVariable<unsigned int>("i");
+        EXPECT_EQ(ai.getVariable<unsigned int>("count"), i % 2 == 1 ? 2u : 4u);
+        EXPECT_EQ(ai.getVariable<unsigned int>(WAKE_STEP_VARIABLE_NAME), i % 2 == 1 ? 6u : 0u);
+    }
+}
+FLAMEGPU_AGENT_FUNCTION(WakeEven, MessageNone, MessageNone) {
+    if (FLAMEGPU->isAsleep()) {
+        FLAMEGPU->setVariable<unsigned int>("observed", FLAMEGPU->getVariable<unsigned int>("observed") + 1);
+        if (FLAMEGPU->getVariable<unsigned int>("i") % 2 == 0) {
+            FLAMEGPU->wake();
+        }
+    }
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(CountSleepAll, MessageNone, MessageNone) {
+    FLAMEGPU->setVariable<unsigned int>("count", FLAMEGPU->getVariable<unsigned int>("count") + 1);
+    FLAMEGPU->sleep(100);
+    return ALIVE;
+}
+TEST(AgentSleepTest, IncludeSleepingWake) {
+    ModelDescription model(MODEL_NAME);
+    AgentDescription &agent = model.newAgent(AGENT_NAME);
+    agent.newVariable<unsigned int>("i");
+    agent.newVariable<unsigned int>("count", 0);
+    agent.newVariable<unsigned int>("observed", 0);
+    agent.setSleepEnabled(true);
+    AgentFunctionDescription &wake = agent.newFunction("wake", WakeEven);
+    wake.setIncludeSleeping(true);
+    AgentFunctionDescription &count = agent.newFunction("count", CountSleepAll);
+    model.newLayer().addAgentFunction(wake);
+    model.newLayer().addAgentFunction(count);
+    AgentVector population(agent, AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+        population[i].setVariable<unsigned int>("i", i);
+    }
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.SimulationConfig().steps = 3;
+    cudaSimulation.setPopulationData(population);
+    cudaSimulation.simulate();
+    cudaSimulation.getPopulationData(population);
+    // All agents fall asleep in step 0, even agents are woken in each following step
+    ASSERT_EQ(population.size(), AGENT_COUNT);
+    for (const auto &ai : population) {
+        const unsigned int i = ai.getVariable<unsigned int>("i");
+        EXPECT_EQ(ai.getVariable<unsigned int>("count"), i % 2 == 0 ? 3u : 1u);
+        EXPECT_EQ(ai.getVariable<unsigned int>("observed"), 2u);
+    }
+}
+FLAMEGPU_AGENT_FUNCTION(SleepOdd, MessageNone, MessageNone) {
+    if (FLAMEGPU->getVariable<unsigned int>("i") % 2 == 1) {
+        FLAMEGPU->sleep(10);
+    }
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(KillAll, MessageNone, MessageNone) {
+    return DEAD;
+}
+TEST(AgentSleepTest, SleepingAgentsSurviveDeath) {
+    ModelDescription model(MODEL_NAME);
+    AgentDescription &agent = model.newAgent(AGENT_NAME);
+    agent.newVariable<unsigned int>("i");
+    agent.setSleepEnabled(true);
+    AgentFunctionDescription &sleep = agent.newFunction("sleep", SleepOdd);
+    AgentFunctionDescription &kill = agent.newFunction("kill", KillAll);
+    kill.setAllowAgentDeath(true);
+    model.newLayer().addAgentFunction(sleep);
+    model.newLayer().addAgentFunction(kill);
+    AgentVector population(agent, AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+        population[i].setVariable<unsigned int>("i", i);
+    }
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.setPopulationData(population);
+    cudaSimulation.step();
+    cudaSimulation.getPopulationData(population);
+    // Only the sleeping odd agents remain
+    ASSERT_EQ(population.size(), AGENT_COUNT / 2);
+    for (const auto &ai : population) {
+        EXPECT_EQ(ai.getVariable<unsigned int>("i") % 2, 1u);
+    }
+    // Whilst all agents are asleep, the function is not launched
+    cudaSimulation.step();
+    cudaSimulation.getPopulationData(population);
+    EXPECT_EQ(population.size(), AGENT_COUNT / 2);
+}
+FLAMEGPU_AGENT_FUNCTION(OutputMessage, MessageNone, MessageBruteForce) {
+    FLAMEGPU->message_out.setVariable<unsigned int>("i", FLAMEGPU->getVariable<unsigned int>("i"));
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(ReadMessages, MessageBruteForce, MessageNone) {
+    unsigned int count = 0;
+    unsigned int odd = 0;
+    for (const auto &message : FLAMEGPU->message_in) {
+        ++count;
+        odd += message.getVariable<unsigned int>("i") % 2;
+    }
+    FLAMEGPU->setVariable<unsigned int>("count", count);
+    FLAMEGPU->setVariable<unsigned int>("observed", odd);
+    return ALIVE;
+}
+TEST(AgentSleepTest, SleepingAgentsDoNotOutputMessages) {
+    ModelDescription model(MODEL_NAME);
+    MessageBruteForce::Description &message = model.newMessage(MESSAGE_NAME);
+    message.newVariable<unsigned int>("i");
+    AgentDescription &agent = model.newAgent(AGENT_NAME);
+    agent.newVariable<unsigned int>("i");
+    agent.newVariable<unsigned int>("count", 0);
+    agent.newVariable<unsigned int>("observed", 0);
+    agent.setSleepEnabled(true);
+    AgentFunctionDescription &sleep = agent.newFunction("sleep", SleepOdd);
+    AgentFunctionDescription &output = agent.newFunction("output", OutputMessage);
+    output.setMessageOutput(message);
+    AgentFunctionDescription &read = agent.newFunction("read", ReadMessages);
+    read.setMessageInput(message);
+    read.setIncludeSleeping(true);
+    model.newLayer().addAgentFunction(sleep);
+    model.newLayer().addAgentFunction(output);
+    model.newLayer().addAgentFunction(read);
+    AgentVector population(agent, AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+        population[i].setVariable<unsigned int>("i", i);
+    }
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.setPopulationData(population);
+    cudaSimulation.step();
+    cudaSimulation.getPopulationData(population);
+    // Only the awake even agents output a message
+    ASSERT_EQ(population.size(), AGENT_COUNT);
+    for (const auto &ai : population) {
+        EXPECT_EQ(ai.getVariable<unsigned int>("count"), AGENT_COUNT / 2);
+        EXPECT_EQ(ai.getVariable<unsigned int>("observed"), 0u);
+    }
+}
+const char *rtc_CountSleepOdd = R"###(
+FLAMEGPU_AGENT_FUNCTION(CountSleepOdd, flamegpu::MessageNone, flamegpu::MessageNone) {
+    FLAMEGPU->setVariable<unsigned int>("count", FLAMEGPU->getVariable<unsigned int>("count") + 1);
+    if (FLAMEGPU->getVariable<unsigned int>("i") % 2 == 1) {
+        FLAMEGPU->sleep(2);
+    }
+    return flamegpu::ALIVE;
+}
+)###";
+TEST(AgentSleepTest, SleepSkipsAgents_RTC) {
+    ModelDescription model(MODEL_NAME);
+    AgentDescription &agent = model.newAgent(AGENT_NAME);
+    agent.newVariable<unsigned int>("i");
+    agent.newVariable<unsigned int>("count", 0);
+    agent.setSleepEnabled(true);
+    AgentFunctionDescription &fn = agent.newRTCFunction("count", rtc_CountSleepOdd);
+    model.newLayer().addAgentFunction(fn);
+    AgentVector population(agent, AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+        population[i].setVariable<unsigned int>("i", i);
+    }
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.SimulationConfig().steps = 4;
+    cudaSimulation.setPopulationData(population);
+    cudaSimulation.simulate();
+    cudaSimulation.getPopulationData(population);
+    ASSERT_EQ(population.size(), AGENT_COUNT);
+    for (const auto &ai : population) {
+        const unsigned int i = ai.getVariable<unsigned int>("i");
+        EXPECT_EQ(ai.getVariable<unsigned int>("count"), i % 2 == 1 ? 2u : 4u);
+    }
+}
+FLAMEGPU_AGENT_FUNCTION(ScheduleNext, MessageNone, MessageNone) {
+    FLAMEGPU->setVariable<unsigned int>("count", FLAMEGPU->getVariable<unsigned int>("count") + 1);
+    FLAMEGPU->sleepUntil(FLAMEGPU->getStepCounter() + 1 + FLAMEGPU->getVariable<unsigned int>("period"));
+    return ALIVE;
+}
+TEST(AgentSleepTest, SleepUntil) {
+    ModelDescription model(MODEL_NAME);
+    AgentDescription &agent = model.newAgent(AGENT_NAME);
+    agent.newVariable<unsigned int>("period");
+    agent.newVariable<unsigned int>("count", 0);
+    agent.setSleepEnabled(true);
+    AgentFunctionDescription &fn = agent.newFunction("schedule", ScheduleNext);
+    model.newLayer().addAgentFunction(fn);
+    AgentVector population(agent, AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+        // Periods of 130 steps are scheduled beyond the year of the wake calendar
+        population[i].setVariable<unsigned int>("period", 10 + (i % 4) * 40);
+    }
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.SimulationConfig().steps = 200;
+    cudaSimulation.setPopulationData(population);
+    cudaSimulation.simulate();
+    cudaSimulation.getPopulationData(population);
+    // Agents execute in step 0, and every period + 1 steps thereafter
+    ASSERT_EQ(population.size(), AGENT_COUNT);
+    for (const auto &ai : population) {
+        const unsigned int period = ai.getVariable<unsigned int>("period");
+        EXPECT_EQ(ai.getVariable<unsigned int>("count"), 199 / (period + 1) + 1);
+    }
+}
+FLAMEGPU_AGENT_FUNCTION(CountAwake, MessageNone, MessageNone) {
+    FLAMEGPU->setVariable<unsigned int>("count_after", FLAMEGPU->getVariable<unsigned int>("count_after") + 1);
+    return ALIVE;
+}
+TEST(AgentSleepTest, CalendarReinsertsWokenAgents) {
+    ModelDescription model(MODEL_NAME);
+    AgentDescription &agent = model.newAgent(AGENT_NAME);
+    agent.newVariable<unsigned int>("period");
+    agent.newVariable<unsigned int>("count", 0);
+    agent.newVariable<unsigned int>("count_after", 0);
+    agent.setSleepEnabled(true);
+    AgentFunctionDescription &fn = agent.newFunction("schedule", ScheduleNext);
+    AgentFunctionDescription &fn2 = agent.newFunction("count_awake", CountAwake);
+    model.newLayer().addAgentFunction(fn);
+    model.newLayer().addAgentFunction(fn2);
+    AgentVector population(agent, AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+        // Some agents are awake every step, whilst others wake within and beyond the calendar's year
+        const unsigned int periods[5] = {0, 1, 3, 7, 100};
+        population[i].setVariable<unsigned int>("period", periods[i % 5]);
+    }
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.SimulationConfig().steps = 200;
+    cudaSimulation.setPopulationData(population);
+    cudaSimulation.simulate();
+    cudaSimulation.getPopulationData(population);
+    // Every agent sleeps during the first layer, so none execute the second layer
+    ASSERT_EQ(population.size(), AGENT_COUNT);
+    for (const auto &ai : population) {
+        const unsigned int period = ai.getVariable<unsigned int>("period");
+        EXPECT_EQ(ai.getVariable<unsigned int>("count"), 199 / (period + 1) + 1);
+        EXPECT_EQ(ai.getVariable<unsigned int>("count_after"), 0u);
+    }
+}
+FLAMEGPU_HOST_FUNCTION(CreateAgent) {
+    if (FLAMEGPU->getStepCounter() == 2) {
+        FLAMEGPU->agent(AGENT_NAME).newAgent().setVariable<unsigned int>("period", 1000);
+    }
+}
+TEST(AgentSleepTest, CalendarInvalidatedByNewAgents) {
+    ModelDescription model(MODEL_NAME);
+    AgentDescription &agent = model.newAgent(AGENT_NAME);
+    agent.newVariable<unsigned int>("period");
+    agent.newVariable<unsigned int>("count", 0);
+    agent.setSleepEnabled(true);
+    AgentFunctionDescription &fn = agent.newFunction("schedule", ScheduleNext);
+    model.newLayer().addAgentFunction(fn);
+    model.addStepFunction(CreateAgent);
+    AgentVector population(agent, AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+        population[i].setVariable<unsigned int>("period", 1000);
+    }
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.setPopulationData(population);
+    // All agents are asleep after step 0, so step 1 is skipped by the calendar
+    cudaSimulation.step();
+    cudaSimulation.step();
+    // Step 2 creates an awake agent, which executes in step 3
+    cudaSimulation.step();
+    cudaSimulation.step();
+    cudaSimulation.getPopulationData(population);
+    ASSERT_EQ(population.size(), AGENT_COUNT + 1);
+    for (const auto &ai : population) {
+        EXPECT_EQ(ai.getVariable<unsigned int>("count"), 1u);
+    }
+    // Replacing the population also makes the new agents execute
+    AgentVector new_population(agent, AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+        new_population[i].setVariable<unsigned int>("period", 1000);
+    }
+    cudaSimulation.setPopulationData(new_population);
+    cudaSimulation.step();
+    cudaSimulation.getPopulationData(new_population);
+    ASSERT_EQ(new_population.size(), AGENT_COUNT);
+    for (const auto &ai : new_population) {
+        EXPECT_EQ(ai.getVariable<unsigned int>("count"), 1u);
+    }
+}
+
+}  // namespace test_agent_sleep
+}  // namespace flamegpu
@@ -8,6 +8,7 @@
 * > With birthing agent transitioning state
 * > With birthing agent conditional state change
 */
+#include <array>
 #include <set>
 
 #include "flamegpu/flamegpu.h"
@@ -1479,6 +1480,231 @@ TEST(DeviceAgentCreationTest, Output_Array) {
     EXPECT_EQ(is_1, AGENT_COUNT);
     EXPECT_EQ(is_12, AGENT_COUNT);
 }
+TEST(DeviceAgentCreationTest, Compact_Output) {
+    // Define model
+    ModelDescription model("Spatial3DMessageTestModel");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<float>("x");
+    agent.newVariable<unsigned int>("id");
+    AgentFunctionDescription &function = agent.newFunction("output", OptionalOutput);
+    function.setAgentOutput(agent);
+    // Exactly half of agents give birth
+    function.setAgentOutputBirthRate(0.5f);
+    LayerDescription &layer1 = model.newLayer();
+    layer1.addAgentFunction(function);
+    // Init agent pop
+    CUDASimulation cudaSimulation(model);
+    AgentVector population(model.Agent("agent"), AGENT_COUNT);
+    // Initialise agents
+    for (unsigned int i = 0; i < AGENT_COUNT; i++) {
+        AgentVector::Agent instance = population[i];
+        instance.setVariable<float>("x", i + 1.0f);
+        instance.setVariable<unsigned int>("id", i);
+    }
+    cudaSimulation.setPopulationData(population);
+    // Execute model
+    cudaSimulation.step();
+    // Test output
+    cudaSimulation.getPopulationData(population);
+    EXPECT_EQ(population.size(), AGENT_COUNT + AGENT_COUNT / 2);
+    unsigned int is_1 = 0;
+    unsigned int is_12 = 0;
+    std::set<id_t> ids;
+    for (AgentVector::Agent ai : population) {
+        const unsigned int id = ai.getVariable<unsigned int>("id");
+        const float val = ai.getVariable<float>("x") - id;
+        if (val == 1.0f)
+            is_1++;
+        else if (val == 12.0f)
+            is_12++;
+        ids.insert(ai.getID());
+    }
+    EXPECT_EQ(is_1, AGENT_COUNT);
+    EXPECT_EQ(is_12, AGENT_COUNT / 2);
+    // New agents received unique IDs
+    EXPECT_EQ(ids.size(), population.size());
+}
+TEST(DeviceAgentCreationTest, Compact_Output_ExceedsRate) {
+    // Define model
+    ModelDescription model("Spatial3DMessageTestModel");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<float>("x");
+    agent.newVariable<unsigned int>("id");
+    AgentFunctionDescription &function = agent.newFunction("output", OptionalOutput);
+    function.setAgentOutput(agent);
+    // Half of agents give birth, which exceeds the rate provided
+    function.setAgentOutputBirthRate(0.25f);
+    LayerDescription &layer1 = model.newLayer();
+    layer1.addAgentFunction(function);
+    // Init agent pop
+    CUDASimulation cudaSimulation(model);
+    AgentVector population(model.Agent("agent"), AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; i++) {
+        AgentVector::Agent instance = population[i];
+        instance.setVariable<float>("x", i + 1.0f);
+        instance.setVariable<unsigned int>("id", i);
+    }
+    cudaSimulation.setPopulationData(population);
+    // Every birth survives, the rate only selects how births are collected
+    EXPECT_NO_THROW(cudaSimulation.step());
+    cudaSimulation.getPopulationData(population);
+    const unsigned int STEP1_COUNT = AGENT_COUNT + AGENT_COUNT / 2;
+    EXPECT_EQ(population.size(), STEP1_COUNT);
+    unsigned int is_12 = 0;
+    for (AgentVector::Agent ai : population) {
+        const unsigned int id = ai.getVariable<unsigned int>("id");
+        if (ai.getVariable<float>("x") - id == 12.0f)
+            is_12++;
+    }
+    EXPECT_EQ(is_12, AGENT_COUNT / 2);
+    EXPECT_NO_THROW(cudaSimulation.step());
+    cudaSimulation.getPopulationData(population);
+    EXPECT_EQ(population.size(), STEP1_COUNT + STEP1_COUNT / 2);
+    std::set<id_t> ids;
+    for (AgentVector::Agent ai : population) {
+        ids.insert(ai.getID());
+    }
+    EXPECT_EQ(ids.size(), population.size());
+}
+TEST(DeviceAgentCreationTest, Compact_Output_Overflow) {
+    // Define model
+    ModelDescription model("Spatial3DMessageTestModel");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<float, 2>("x");
+    agent.newVariable<unsigned int>("id");
+    agent.newVariable<int>("d", 7);
+    AgentFunctionDescription &function = agent.newFunction("output", MandatoryOutputArray);
+    function.setAgentOutput(agent);
+    // Every agent gives birth, so almost every birth overflows the buffer
+    function.setAgentOutputBirthRate(0.01f);
+    LayerDescription &layer1 = model.newLayer();
+    layer1.addAgentFunction(function);
+    // Init agent pop
+    CUDASimulation cudaSimulation(model);
+    AgentVector population(model.Agent("agent"), AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; i++) {
+        AgentVector::Agent instance = population[i];
+        instance.setVariable<float, 2>("x", { i + 1.0f, i + 2.0f });
+        instance.setVariable<unsigned int>("id", i);
+        instance.setVariable<int>("d", 0);
+    }
+    cudaSimulation.setPopulationData(population);
+    // Execute model
+    EXPECT_NO_THROW(cudaSimulation.step());
+    // Test output
+    cudaSimulation.getPopulationData(population);
+    EXPECT_EQ(population.size(), 2 * AGENT_COUNT);
+    unsigned int is_1 = 0;
+    unsigned int is_12 = 0;
+    std::set<id_t> ids;
+    for (AgentVector::Agent ai : population) {
+        const unsigned int id = ai.getVariable<unsigned int>("id");
+        const std::array<float, 2> x = ai.getVariable<float, 2>("x");
+        if (x[0] - id == 1.0f && x[1] - id == 2.0f && ai.getVariable<int>("d") == 0) {
+            is_1++;
+        } else if (x[0] - id == 12.0f && x[1] - id == 13.0f && ai.getVariable<int>("d") == 7) {
+            // Births which overflowed still receive default values
+            is_12++;
+        }
+        ids.insert(ai.getID());
+    }
+    EXPECT_EQ(is_1, AGENT_COUNT);
+    EXPECT_EQ(is_12, AGENT_COUNT);
+    // New agents received unique IDs
+    EXPECT_EQ(ids.size(), population.size());
+    // The buffer grows to the most births previously output, so the second step does not overflow
+    EXPECT_NO_THROW(cudaSimulation.step());
+    cudaSimulation.getPopulationData(population);
+    EXPECT_EQ(population.size(), 4 * AGENT_COUNT);
+}
+const char* rtc_OptionalOutput = R"###(
+FLAMEGPU_AGENT_FUNCTION(OptionalOutput, flamegpu::MessageNone, flamegpu::MessageNone) {
+    unsigned int id = FLAMEGPU->getVariable<unsigned int>("id") + 1;
+    if (threadIdx.x % 2 == 0) {
+        FLAMEGPU->agent_out.setVariable<float>("x", id + 12.0f);
+        FLAMEGPU->agent_out.setVariable<unsigned int>("id", id);
+    }
+    return flamegpu::ALIVE;
+}
+)###";
+TEST(DeviceRTCAgentCreationTest, Compact_Output) {
+    // Define model
+    ModelDescription model("Spatial3DMessageTestModel");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<float>("x");
+    agent.newVariable<unsigned int>("id");
+    AgentFunctionDescription &function = agent.newRTCFunction("output", rtc_OptionalOutput);
+    function.setAgentOutput(agent);
+    function.setAgentOutputBirthRate(0.5f);
+    LayerDescription &layer1 = model.newLayer();
+    layer1.addAgentFunction(function);
+    // Init agent pop
+    CUDASimulation cudaSimulation(model);
+    AgentVector population(model.Agent("agent"), AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; i++) {
+        AgentVector::Agent instance = population[i];
+        instance.setVariable<float>("x", i + 1.0f);
+        instance.setVariable<unsigned int>("id", i);
+    }
+    cudaSimulation.setPopulationData(population);
+    // Execute model
+    cudaSimulation.step();
+    // Test output
+    cudaSimulation.getPopulationData(population);
+    EXPECT_EQ(population.size(), AGENT_COUNT + AGENT_COUNT / 2);
+    unsigned int is_12 = 0;
+    for (AgentVector::Agent ai : population) {
+        const unsigned int id = ai.getVariable<unsigned int>("id");
+        if (ai.getVariable<float>("x") - id == 12.0f)
+            is_12++;
+    }
+    EXPECT_EQ(is_12, AGENT_COUNT / 2);
+}
+const char* rtc_MandatoryOutputArray = R"###(
+FLAMEGPU_AGENT_FUNCTION(MandatoryOutputArray, flamegpu::MessageNone, flamegpu::MessageNone) {
+    unsigned int id = FLAMEGPU->getVariable<unsigned int>("id") + 1;
+    FLAMEGPU->agent_out.setVariable<float, 2>("x", 0, id + 12.0f);
+    FLAMEGPU->agent_out.setVariable<float, 2>("x", 1, id + 13.0f);
+    FLAMEGPU->agent_out.setVariable<unsigned int>("id", id);
+    return flamegpu::ALIVE;
+}
+)###";
+TEST(DeviceRTCAgentCreationTest, Compact_Output_Overflow) {
+    // Define model
+    ModelDescription model("Spatial3DMessageTestModel");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<float, 2>("x");
+    agent.newVariable<unsigned int>("id");
+    agent.newVariable<int>("d", 7);
+    AgentFunctionDescription &function = agent.newRTCFunction("output", rtc_MandatoryOutputArray);
+    function.setAgentOutput(agent);
+    function.setAgentOutputBirthRate(0.01f);
+    LayerDescription &layer1 = model.newLayer();
+    layer1.addAgentFunction(function);
+    // Init agent pop
+    CUDASimulation cudaSimulation(model);
+    AgentVector population(model.Agent("agent"), AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; i++) {
+        AgentVector::Agent instance = population[i];
+        instance.setVariable<float, 2>("x", { i + 1.0f, i + 2.0f });
+        instance.setVariable<unsigned int>("id", i);
+        instance.setVariable<int>("d", 0);
+    }
+    cudaSimulation.setPopulationData(population);
+    // Execute model
+    EXPECT_NO_THROW(cudaSimulation.step());
+    // Test output
+    cudaSimulation.getPopulationData(population);
+    EXPECT_EQ(population.size(), 2 * AGENT_COUNT);
+    unsigned int is_12 = 0;
+    for (AgentVector::Agent ai : population) {
+        const unsigned int id = ai.getVariable<unsigned int>("id");
+        const std::array<float, 2> x = ai.getVariable<float, 2>("x");
+        if (x[0] - id == 12.0f && x[1] - id == 13.0f && ai.getVariable<int>("d") == 7)
+            is_12++;
+    }
+    EXPECT_EQ(is_12, AGENT_COUNT);
+}
 #ifdef USE_GLM
 FLAMEGPU_AGENT_FUNCTION(MandatoryOutputArray_glm, MessageNone, MessageNone) {
     unsigned int id = FLAMEGPU->getVariable<unsigned int>("id") + 1;
@@ -0,0 +1,217 @@
+/**
+ * Tests of environment fields
+ *
+ * Tests cover:
+ * > Device stencil matches the host reference implementation [2D, 3D, each boundary, advection, sub-steps]
+ * > DeviceEnvironment::getField() [sample, deposit, dimensions]
+ * > HostEnvironment::getFieldData()/setFieldData()
+ * > CUDASimulation::reset() restores the initial value
+ * exceptions
+ */
+#include <vector>
+
+#include "flamegpu/flamegpu.h"
+
+#include "gtest/gtest.h"
+
+namespace flamegpu {
+
+namespace test_environment_field {
+const unsigned int STEPS = 20;
+const unsigned int GRID_DIM = 16;
+
+std::vector<float> initial_field;
+std::vector<float> final_field;
+FLAMEGPU_INIT_FUNCTION(SetField) {
+    FLAMEGPU->environment.setFieldData("field", initial_field);
+}
+FLAMEGPU_EXIT_FUNCTION(GetField) {
+    final_field = FLAMEGPU->environment.getFieldData("field");
+}
+/**
+ * Runs the field for STEPS steps from a pattern with a single hot cell, and compares the result against fieldStencilHost()
+ */
+void runHostReference(const EnvironmentDescription::FieldData &config) {
+    ModelDescription model("model");
+    model.newAgent("agent");
+    model.Environment().newField("field", config);
+    model.addInitFunction(SetField);
+    model.addExitFunction(GetField);
+    const unsigned int cells = config.dimensions[0] * config.dimensions[1] * config.dimensions[2];
+    initial_field.assign(cells, 0.0f);
+    for (unsigned int i = 0; i < cells; ++i)
+        initial_field[i] = static_cast<float>(i % 7) * 0.25f;
+    initial_field[cells / 2 + config.dimensions[0] / 2] = 100.0f;
+    CUDASimulation sim(model);
+    sim.SimulationConfig().steps = STEPS;
+    ASSERT_NO_THROW(sim.simulate());
+    // Host reference
+    std::vector<float> expected = initial_field;
+    const util::detail::FieldStencil stencil = config.getStencil();
+    for (unsigned int s = 0; s < STEPS; ++s)
+        util::detail::fieldStencilHost(stencil, expected, config.sub_steps);
+    ASSERT_EQ(final_field.size(), expected.size());
+    float expected_total = 0.0f, final_total = 0.0f;
+    for (unsigned int i = 0; i < cells; ++i) {
+        // Device may contract to FMA, so allow for rounding
+        EXPECT_NEAR(final_field[i], expected[i], 1e-4f * (1.0f + expected[i]));
+        expected_total += expected[i];
+        final_total += final_field[i];
+    }
+    EXPECT_NEAR(final_total, expected_total, 1e-3f * expected_total);
+}
+TEST(EnvironmentFieldTest, HostReference2D_ZeroFlux) {
+    EnvironmentDescription::FieldData config({ GRID_DIM, GRID_DIM, 1 });
+    config.diffusion = 0.2f;
+    config.boundary = FieldBoundary::ZeroFlux;
+    runHostReference(config);
+}
+TEST(EnvironmentFieldTest, HostReference2D_Periodic) {
+    EnvironmentDescription::FieldData config({ GRID_DIM, GRID_DIM / 2, 1 });
+    config.diffusion = 0.2f;
+    config.decay = 0.05f;
+    config.boundary = FieldBoundary::Periodic;
+    runHostReference(config);
+}
+TEST(EnvironmentFieldTest, HostReference2D_Fixed) {
+    EnvironmentDescription::FieldData config({ GRID_DIM, GRID_DIM, 1 });
+    config.diffusion = 0.2f;
+    config.boundary = FieldBoundary::Fixed;
+    config.boundary_value = 2.0f;
+    runHostReference(config);
+}
+TEST(EnvironmentFieldTest, HostReference2D_Advection) {
+    EnvironmentDescription::FieldData config({ GRID_DIM, GRID_DIM, 1 });
+    config.diffusion = 0.1f;
+    config.velocity = { 0.5f, -0.25f, 0.0f };
+    config.boundary = FieldBoundary::Periodic;
+    runHostReference(config);
+}
+TEST(EnvironmentFieldTest, HostReference3D_SubSteps) {
+    EnvironmentDescription::FieldData config({ GRID_DIM, GRID_DIM / 2, GRID_DIM / 4 });
+    config.diffusion = 1.0f;
+    config.decay = 0.1f;
+    config.sub_steps = 7;
+    config.boundary = FieldBoundary::ZeroFlux;
+    runHostReference(config);
+}
+TEST(EnvironmentFieldTest, StaticFieldUnchanged) {
+    EnvironmentDescription::FieldData config({ GRID_DIM, GRID_DIM, 1 });
+    config.initial_value = 3.0f;
+    ModelDescription model("model");
+    model.newAgent("agent");
+    model.Environment().newField("field", config);
+    model.addExitFunction(GetField);
+    CUDASimulation sim(model);
+    sim.SimulationConfig().steps = STEPS;
+    ASSERT_NO_THROW(sim.simulate());
+    ASSERT_EQ(final_field.size(), GRID_DIM * GRID_DIM);
+    for (const float &f : final_field)
+        EXPECT_EQ(f, 3.0f);
+}
+
+FLAMEGPU_AGENT_FUNCTION(Deposit, MessageNone, MessageNone) {
+    auto field = FLAMEGPU->environment.getField("field");
+    field.deposit(FLAMEGPU->getVariable<unsigned int>("x"), FLAMEGPU->getVariable<unsigned int>("y"), 1.0f);
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(Sample, MessageNone, MessageNone) {
+    const auto field = FLAMEGPU->environment.getField("field");
+    FLAMEGPU->setVariable<float>("sample", field.sample(FLAMEGPU->getVariable<unsigned int>("x"), FLAMEGPU->getVariable<unsigned int>("y")));
+    FLAMEGPU->setVariable<unsigned int>("dims", field.getWidth() * 10000 + field.getHeight() * 100 + field.getDepth());
+    return ALIVE;
+}
+const char *rtc_deposit_func = R"###(
+FLAMEGPU_AGENT_FUNCTION(rtc_deposit_func, flamegpu::MessageNone, flamegpu::MessageNone) {
+    auto field = FLAMEGPU->environment.getField("field");
+    field.deposit(FLAMEGPU->getVariable<unsigned int>("x"), FLAMEGPU->getVariable<unsigned int>("y"), 1.0f);
+    return flamegpu::ALIVE;
+}
+)###";
+const char *rtc_sample_func = R"###(
+FLAMEGPU_AGENT_FUNCTION(rtc_sample_func, flamegpu::MessageNone, flamegpu::MessageNone) {
+    const auto field = FLAMEGPU->environment.getField("field");
+    FLAMEGPU->setVariable<float>("sample", field.sample(FLAMEGPU->getVariable<unsigned int>("x"), FLAMEGPU->getVariable<unsigned int>("y")));
+    FLAMEGPU->setVariable<unsigned int>("dims", field.getWidth() * 10000 + field.getHeight() * 100 + field.getDepth());
+    return flamegpu::ALIVE;
+}
+)###";
+/**
+ * 4 agents per cell of the first 2 rows deposit into a static field, and then sample their cell
+ */
+void runDepositSample(const bool &rtc) {
+    const unsigned int AGENT_COUNT = GRID_DIM * 2 * 4;
+    ModelDescription model("model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<unsigned int>("x");
+    agent.newVariable<unsigned int>("y");
+    agent.newVariable<float>("sample", -1.0f);
+    agent.newVariable<unsigned int>("dims", 0);
+    model.Environment().newField("field", EnvironmentDescription::FieldData({ GRID_DIM, GRID_DIM, 1 }));
+    model.addExitFunction(GetField);
+    if (rtc) {
+        model.newLayer().addAgentFunction(agent.newRTCFunction("rtc_deposit_func", rtc_deposit_func));
+        model.newLayer().addAgentFunction(agent.newRTCFunction("rtc_sample_func", rtc_sample_func));
+    } else {
+        model.newLayer().addAgentFunction(agent.newFunction("Deposit", Deposit));
+        model.newLayer().addAgentFunction(agent.newFunction("Sample", Sample));
+    }
+    AgentVector population(agent, AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; ++i) {
+        population[i].setVariable<unsigned int>("x", (i / 4) % GRID_DIM);
+        population[i].setVariable<unsigned int>("y", (i / 4) / GRID_DIM);
+    }
+    CUDASimulation sim(model);
+    sim.SimulationConfig().steps = 1;
+    sim.setPopulationData(population);
+    ASSERT_NO_THROW(sim.simulate());
+    sim.getPopulationData(population);
+    for (const auto &a : population) {
+        EXPECT_EQ(a.getVariable<float>("sample"), 4.0f);
+        EXPECT_EQ(a.getVariable<unsigned int>("dims"), GRID_DIM * 10000 + GRID_DIM * 100 + 1);
+    }
+    ASSERT_EQ(final_field.size(), GRID_DIM * GRID_DIM);
+    for (unsigned int i = 0; i < GRID_DIM * GRID_DIM; ++i)
+        EXPECT_EQ(final_field[i], i < GRID_DIM * 2 ? 4.0f : 0.0f);
+}
+TEST(EnvironmentFieldTest, DepositSample) {
+    runDepositSample(false);
+}
+TEST(EnvironmentFieldTest, DepositSample_RTC) {
+    runDepositSample(true);
+}
+TEST(EnvironmentFieldTest, Reset) {
+    EnvironmentDescription::FieldData config({ GRID_DIM, GRID_DIM, 1 });
+    config.initial_value = 1.5f;
+    config.decay = 0.5f;
+    ModelDescription model("model");
+    model.newAgent("agent");
+    model.Environment().newField("field", config);
+    model.addExitFunction(GetField);
+    CUDASimulation sim(model);
+    sim.SimulationConfig().steps = 2;
+    ASSERT_NO_THROW(sim.simulate());
+    for (const float &f : final_field)
+        EXPECT_EQ(f, 1.5f * 0.5f * 0.5f);
+    sim.reset();
+    sim.SimulationConfig().steps = 1;
+    ASSERT_NO_THROW(sim.simulate());
+    for (const float &f : final_field)
+        EXPECT_EQ(f, 1.5f * 0.5f);
+}
+FLAMEGPU_STEP_FUNCTION(SetFieldWrongLength) {
+    EXPECT_THROW(FLAMEGPU->environment.setFieldData("field", std::vector<float>(GRID_DIM)), exception::InvalidArgument);
+    EXPECT_THROW(FLAMEGPU->environment.getFieldData("missing"), exception::InvalidEnvProperty);
+}
+TEST(EnvironmentFieldTest, HostExceptions) {
+    ModelDescription model("model");
+    model.newAgent("agent");
+    model.Environment().newField("field", EnvironmentDescription::FieldData({ GRID_DIM, GRID_DIM, 1 }));
+    model.addStepFunction(SetFieldWrongLength);
+    CUDASimulation sim(model);
+    sim.SimulationConfig().steps = 1;
+    ASSERT_NO_THROW(sim.simulate());
+}
+
+}  // namespace test_environment_field
+}  // namespace flamegpu
@@ -0,0 +1,263 @@
+/**
+ * Tests of environment macro properties
+ *
+ * Tests cover:
+ * > DeviceEnvironment::getMacroProperty() [read, +=, -=, min(), max(), exchange()]
+ * > HostEnvironment::getMacroProperty() [read, write, zero()]
+ * > HostEnvironment::getMacroPropertyData()/setMacroPropertyData()
+ * > Macro properties are zeroed by reset()
+ * > Macro properties are included in state export/import
+ * exceptions
+ */
+#include <string>
+#include <vector>
+
+#include "flamegpu/flamegpu.h"
+
+#include "gtest/gtest.h"
+
+namespace flamegpu {
+
+namespace test_environment_macro_property {
+const unsigned int AGENT_COUNT = 1024;
+const char *JSON_FILE_NAME = "macro_test.json";
+const char *XML_FILE_NAME = "macro_test.xml";
+
+FLAMEGPU_AGENT_FUNCTION(DeviceUpdate, MessageNone, MessageNone) {
+    const unsigned int x = FLAMEGPU->getVariable<unsigned int>("x");
+    FLAMEGPU->environment.getMacroProperty<unsigned int, 2, 3>("count")[x % 2][x % 3] += 1;
+    FLAMEGPU->environment.getMacroProperty<int>("sub") -= 2;
+    FLAMEGPU->environment.getMacroProperty<int>("lo").min(static_cast<int>(x));
+    FLAMEGPU->environment.getMacroProperty<int>("hi").max(static_cast<int>(x));
+    FLAMEGPU->environment.getMacroProperty<float>("sum") += 0.5f;
+    const unsigned int old = FLAMEGPU->environment.getMacroProperty<unsigned int>("last").exchange(x + 1);
+    FLAMEGPU->setVariable<unsigned int>("old", old);
+    return ALIVE;
+}
+FLAMEGPU_AGENT_FUNCTION(DeviceRead, MessageNone, MessageNone) {
+    FLAMEGPU->setVariable<unsigned int>("old", FLAMEGPU->environment.getMacroProperty<unsigned int, 2, 3>("count")[1][2]);
+    return ALIVE;
+}
+FLAMEGPU_INIT_FUNCTION(InitMacro) {
+    // lo must start above the smallest agent value to be updated by min()
+    FLAMEGPU->environment.getMacroProperty<int>("lo") = static_cast<int>(AGENT_COUNT);
+}
+FLAMEGPU_STEP_FUNCTION(CheckDevice) {
+    auto count = FLAMEGPU->environment.getMacroProperty<unsigned int, 2, 3>("count");
+    unsigned int total = 0;
+    for (unsigned int i = 0; i < 2; ++i) {
+        for (unsigned int j = 0; j < 3; ++j) {
+            unsigned int expected = 0;
+            for (unsigned int x = 0; x < AGENT_COUNT; ++x) {
+                if (x % 2 == i && x % 3 == j)
+                    ++expected;
+            }
+            EXPECT_EQ(static_cast<unsigned int>(count[i][j]), expected);
+            total += count[i][j];
+        }
+    }
+    EXPECT_EQ(total, AGENT_COUNT);
+    EXPECT_EQ(static_cast<int>(FLAMEGPU->environment.getMacroProperty<int>("sub")), -2 * static_cast<int>(AGENT_COUNT));
+    EXPECT_EQ(static_cast<int>(FLAMEGPU->environment.getMacroProperty<int>("lo")), 0);
+    EXPECT_EQ(static_cast<int>(FLAMEGPU->environment.getMacroProperty<int>("hi")), static_cast<int>(AGENT_COUNT) - 1);
+    EXPECT_EQ(static_cast<float>(FLAMEGPU->environment.getMacroProperty<float>("sum")), AGENT_COUNT * 0.5f);
+    const unsigned int last = FLAMEGPU->environment.getMacroProperty<unsigned int>("last");
+    EXPECT_GT(last, 0u);
+    EXPECT_LE(last, AGENT_COUNT);
+}
+TEST(EnvironmentMacroPropertyTest, DeviceAtomics) {
+    ModelDescription model("model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<unsigned int>("x");
+    agent.newVariable<unsigned int>("old");
+    EnvironmentDescription &env = model.Environment();
+    env.newMacroProperty<unsigned int, 2, 3>("count");
+    env.newMacroProperty<int>("sub");
+    env.newMacroProperty<int>("lo");
+    env.newMacroProperty<int>("hi");
+    env.newMacroProperty<float>("sum");
+    env.newMacroProperty<unsigned int>("last");
+    model.newLayer().addAgentFunction(agent.newFunction("DeviceUpdate", DeviceUpdate));
+    model.addInitFunction(InitMacro);
+    model.addStepFunction(CheckDevice);
+    AgentVector population(agent, AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; ++i)
+        population[i].setVariable<unsigned int>("x", i);
+    CUDASimulation sim(model);
+    sim.setPopulationData(population);
+    ASSERT_NO_THROW(sim.step());
+    // Each agent received the value exchanged by a different agent, or the initial 0
+    ASSERT_NO_THROW(sim.getPopulationData(population));
+    std::vector<unsigned int> seen(AGENT_COUNT + 1, 0);
+    for (auto a : population)
+        seen[a.getVariable<unsigned int>("old")]++;
+    EXPECT_EQ(seen[0], 1u);
+    for (unsigned int i = 1; i <= AGENT_COUNT; ++i)
+        EXPECT_LE(seen[i], 1u);
+}
+
+FLAMEGPU_STEP_FUNCTION(HostWrite) {
+    auto a = FLAMEGPU->environment.getMacroProperty<unsigned int, 2, 3>("count");
+    for (unsigned int i = 0; i < 2; ++i) {
+        for (unsigned int j = 0; j < 3; ++j) {
+            a[i][j] = i * 3 + j + 1;
+        }
+    }
+}
+FLAMEGPU_STEP_FUNCTION(HostRead) {
+    auto a = FLAMEGPU->environment.getMacroProperty<unsigned int, 2, 3>("count");
+    for (unsigned int i = 0; i < 2; ++i) {
+        for (unsigned int j = 0; j < 3; ++j) {
+            EXPECT_EQ(static_cast<unsigned int>(a[i][j]), i * 3 + j + 1);
+        }
+    }
+    // Bulk read observes changes made through a live handle
+    a[0][0] = 100;
+    const std::vector<unsigned int> data = FLAMEGPU->environment.getMacroPropertyData<unsigned int>("count");
+    ASSERT_EQ(data.size(), 6u);
+    EXPECT_EQ(data[0], 100u);
+    EXPECT_EQ(data[5], 6u);
+    a.zero();
+}
+FLAMEGPU_STEP_FUNCTION(HostBulkWrite) {
+    FLAMEGPU->environment.setMacroPropertyData<unsigned int>("count", { 6, 5, 4, 3, 2, 1 });
+}
+TEST(EnvironmentMacroPropertyTest, HostReadWrite) {
+    ModelDescription model("model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<unsigned int>("old");
+    model.Environment().newMacroProperty<unsigned int, 2, 3>("count");
+    model.newLayer().addHostFunction(HostWrite);
+    model.newLayer().addHostFunction(HostRead);
+    model.newLayer().addHostFunction(HostBulkWrite);
+    model.newLayer().addAgentFunction(agent.newFunction("DeviceRead", DeviceRead));
+    AgentVector population(agent, 1);
+    CUDASimulation sim(model);
+    sim.setPopulationData(population);
+    ASSERT_NO_THROW(sim.step());
+    // The device observes the bulk write
+    ASSERT_NO_THROW(sim.getPopulationData(population));
+    EXPECT_EQ(population[0].getVariable<unsigned int>("old"), 1u);
+}
+
+FLAMEGPU_STEP_FUNCTION(HostIncrement) {
+    FLAMEGPU->environment.getMacroProperty<int, 4>("a")[3] += 5;
+}
+TEST(EnvironmentMacroPropertyTest, Reset) {
+    ModelDescription model("model");
+    model.newAgent("agent");
+    model.Environment().newMacroProperty<int, 4>("a");
+    model.addStepFunction(HostIncrement);
+    CUDASimulation sim(model);
+    ASSERT_NO_THROW(sim.step());
+    ASSERT_NO_THROW(sim.step());
+    int data[4];
+    sim.getMacroEnvironment().getPropertyData("a", data);
+    EXPECT_EQ(data[3], 10);
+    // Reset zeroes macro properties
+    Simulation &base = sim;
+    ASSERT_NO_THROW(base.reset());
+    sim.getMacroEnvironment().getPropertyData("a", data);
+    EXPECT_EQ(data[3], 0);
+    ASSERT_NO_THROW(sim.step());
+    sim.getMacroEnvironment().getPropertyData("a", data);
+    EXPECT_EQ(data[3], 5);
+}
+
+FLAMEGPU_STEP_FUNCTION(HostExportInit) {
+    FLAMEGPU->environment.setMacroPropertyData<int>("i", { -1, 2, -3, 4, -5, 6 });
+    FLAMEGPU->environment.getMacroProperty<double>("d") = 0.125;
+}
+FLAMEGPU_INIT_FUNCTION(HostImportCheck) {
+    const std::vector<int> i = FLAMEGPU->environment.getMacroPropertyData<int>("i");
+    EXPECT_EQ(i, std::vector<int>({ -1, 2, -3, 4, -5, 6 }));
+    EXPECT_EQ(static_cast<double>(FLAMEGPU->environment.getMacroProperty<double>("d")), 0.125);
+}
+void exportImport(const std::string &file_name) {
+    {  // Export
+        ModelDescription model("model");
+        model.newAgent("agent");
+        model.Environment().newMacroProperty<int, 3, 2>("i");
+        model.Environment().newMacroProperty<double>("d");
+        model.addStepFunction(HostExportInit);
+        CUDASimulation sim(model);
+        ASSERT_NO_THROW(sim.step());
+        ASSERT_NO_THROW(sim.exportData(file_name));
+    }
+    {  // Import
+        ModelDescription model("model");
+        model.newAgent("agent");
+        model.Environment().newMacroProperty<int, 3, 2>("i");
+        model.Environment().newMacroProperty<double>("d");
+        model.addInitFunction(HostImportCheck);
+        CUDASimulation sim(model);
+        sim.SimulationConfig().input_file = file_name;
+        ASSERT_NO_THROW(sim.applyConfig());
+        sim.SimulationConfig().steps = 1;
+        ASSERT_NO_THROW(sim.simulate());
+    }
+    ASSERT_EQ(::remove(file_name.c_str()), 0);
+}
+TEST(EnvironmentMacroPropertyTest, ExportImport_JSON) {
+    exportImport(JSON_FILE_NAME);
+}
+TEST(EnvironmentMacroPropertyTest, ExportImport_XML) {
+    exportImport(XML_FILE_NAME);
+}
+
+FLAMEGPU_STEP_FUNCTION(HostBadType) {
+    EXPECT_THROW((FLAMEGPU->environment.getMacroProperty<float, 2, 3>("count")), exception::InvalidEnvPropertyType);
+    EXPECT_THROW((FLAMEGPU->environment.getMacroProperty<unsigned int, 3, 2>("count")), exception::InvalidEnvPropertyType);
+    EXPECT_THROW(FLAMEGPU->environment.getMacroProperty<unsigned int>("missing"), exception::InvalidEnvProperty);
+    EXPECT_THROW(FLAMEGPU->environment.getMacroPropertyData<float>("count"), exception::InvalidEnvPropertyType);
+    EXPECT_THROW((FLAMEGPU->environment.setMacroPropertyData<unsigned int>("count", { 1, 2 })), exception::InvalidEnvPropertyType);
+    auto a = FLAMEGPU->environment.getMacroProperty<unsigned int, 2, 3>("count");
+    EXPECT_THROW(a[2], exception::OutOfBoundsException);
+    EXPECT_THROW(a[1][3], exception::OutOfBoundsException);
+}
+TEST(EnvironmentMacroPropertyTest, HostExceptions) {
+    ModelDescription model("model");
+    model.newAgent("agent");
+    model.Environment().newMacroProperty<unsigned int, 2, 3>("count");
+    model.addStepFunction(HostBadType);
+    CUDASimulation sim(model);
+    ASSERT_NO_THROW(sim.step());
+}
+
+const char *rtc_macro_func = R"###(
+FLAMEGPU_AGENT_FUNCTION(rtc_macro_func, flamegpu::MessageNone, flamegpu::MessageNone) {
+    const unsigned int x = FLAMEGPU->getVariable<unsigned int>("x");
+    FLAMEGPU->environment.getMacroProperty<unsigned int, 2, 3>("count")[x % 2][x % 3] += 1;
+    FLAMEGPU->environment.getMacroProperty<int>("sub") -= 2;
+    FLAMEGPU->environment.getMacroProperty<int>("lo").min(static_cast<int>(x));
+    FLAMEGPU->environment.getMacroProperty<int>("hi").max(static_cast<int>(x));
+    FLAMEGPU->environment.getMacroProperty<float>("sum") += 0.5f;
+    FLAMEGPU->setVariable<unsigned int>("old", FLAMEGPU->environment.getMacroProperty<unsigned int>("last").exchange(x + 1));
+    return flamegpu::ALIVE;
+}
+)###";
+TEST(EnvironmentMacroPropertyTest, DeviceAtomics_RTC) {
+    ModelDescription model("model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<unsigned int>("x");
+    agent.newVariable<unsigned int>("old");
+    EnvironmentDescription &env = model.Environment();
+    env.newMacroProperty<unsigned int, 2, 3>("count");
+    env.newMacroProperty<int>("sub");
+    env.newMacroProperty<int>("lo");
+    env.newMacroProperty<int>("hi");
+    env.newMacroProperty<float>("sum");
+    env.newMacroProperty<unsigned int>("last");
+    model.newLayer().addAgentFunction(agent.newRTCFunction("rtc_macro_func", rtc_macro_func));
+    model.addInitFunction(InitMacro);
+    model.addStepFunction(CheckDevice);
+    AgentVector population(agent, AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; ++i)
+        population[i].setVariable<unsigned int>("x", i);
+    CUDASimulation sim(model);
+    sim.setPopulationData(population);
+    ASSERT_NO_THROW(sim.step());
+}
+
+}  // namespace test_environment_macro_property
+}  // namespace flamegpu
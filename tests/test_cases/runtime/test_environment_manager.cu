@@ -6,6 +6,7 @@
  * > init() [does it work, can we host multiple models]
  * > free() [does it work, can we re-host a model]
  * > Out of space exception
+ * > updateDevice() [only changed bytes are uploaded, concurrent models see their own changes]
  * Implied tests: (Covered as a result of other tests)
  * > defrag() [init uses this]
  */
@@ -43,6 +44,17 @@ FLAMEGPU_STEP_FUNCTION(Multi_ms2) {
     ASSERT_EQ(FLAMEGPU->environment.getProperty<float>("ms1_float"), static_cast<float>(MS2_VAL));
     ASSERT_EQ(FLAMEGPU->environment.getProperty<double>("ms1_float2"), MS2_VAL);
 }
+FLAMEGPU_STEP_FUNCTION(IncrementElement) {
+    const unsigned int step = FLAMEGPU->getStepCounter();
+    FLAMEGPU->environment.setProperty<int>("array", step % 4, FLAMEGPU->environment.getProperty<int>("array", step % 4) + 1);
+}
+FLAMEGPU_AGENT_FUNCTION(ReadArray, MessageNone, MessageNone) {
+    int total = 0;
+    for (int i = 0; i < 4; ++i)
+        total += FLAMEGPU->environment.getProperty<int>("array", i);
+    FLAMEGPU->setVariable<int>("total", total + FLAMEGPU->environment.getProperty<int>("offset"));
+    return ALIVE;
+}
 
 class MiniSim {
  public:
@@ -133,4 +145,38 @@ TEST(EnvironmentManagerTest2, MultipleModels) {
     delete ms1;
     delete ms2;
 }
+// Two simulations which share the device, interleaving steps which each change a single element
+TEST(EnvironmentManagerTest2, InterleavedPartialUpdates) {
+    ModelDescription m1("m1");
+    ModelDescription m2("m2");
+    int offset = 0;
+    for (ModelDescription *m : {&m1, &m2}) {
+        AgentDescription &a = m->newAgent("agent");
+        a.newVariable<int>("total", 0);
+        a.newFunction("ReadArray", ReadArray);
+        m->newLayer().addAgentFunction(ReadArray);
+        m->addStepFunction(IncrementElement);
+        m->Environment().newProperty<int, 4>("array", {0, 0, 0, 0});
+        m->Environment().newProperty<int>("offset", offset);
+        offset += 1000;
+    }
+    CUDASimulation s1(m1);
+    CUDASimulation s2(m2);
+    AgentVector pop1(m1.Agent("agent"), TEST_LEN);
+    AgentVector pop2(m2.Agent("agent"), TEST_LEN);
+    s1.setPopulationData(pop1);
+    s2.setPopulationData(pop2);
+    for (int i = 0; i < 10; ++i) {
+        // Each step, the agents read the totals from before the step function
+        ASSERT_TRUE(s1.step());
+        s1.getPopulationData(pop1);
+        for (const auto &agent : pop1)
+            ASSERT_EQ(agent.getVariable<int>("total"), i);
+        ASSERT_TRUE(s2.step());
+        ASSERT_TRUE(s2.step());
+        s2.getPopulationData(pop2);
+        for (const auto &agent : pop2)
+            ASSERT_EQ(agent.getVariable<int>("total"), 1000 + 2 * i + 1);
+    }
+}
 }  // namespace flamegpu
@@ -0,0 +1,158 @@
+/**
+ * Tests of read-only environment tables
+ *
+ * Tests cover:
+ * > DeviceEnvironment::getTable() [read, size()]
+ * > Tables are shared by simulations on the same device
+ * > Tables are uploaded again if the file changes
+ * exceptions
+ */
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+#include "flamegpu/flamegpu.h"
+#include "flamegpu/runtime/utility/EnvironmentTableCache.h"
+
+#include "gtest/gtest.h"
+
+namespace flamegpu {
+
+namespace test_environment_table {
+const unsigned int AGENT_COUNT = 1024;
+const unsigned int TABLE_LEN = 4096;
+const char *TABLE_FILE_NAME = "env_table_test.bin";
+const char *BAD_TABLE_FILE_NAME = "env_table_test_bad.bin";
+
+/**
+ * Writes the table i*0.5f to TABLE_FILE_NAME
+ */
+void writeTable() {
+    std::vector<float> table(TABLE_LEN);
+    for (unsigned int i = 0; i < TABLE_LEN; ++i)
+        table[i] = i * 0.5f;
+    std::ofstream out(TABLE_FILE_NAME, std::ios::binary);
+    out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(float));
+}
+
+FLAMEGPU_AGENT_FUNCTION(DeviceRead, MessageNone, MessageNone) {
+    const auto table = FLAMEGPU->environment.getTable<float>("table");
+    const unsigned int x = FLAMEGPU->getVariable<unsigned int>("x");
+    FLAMEGPU->setVariable<float>("y", table[(x * 3) % table.size()]);
+    FLAMEGPU->setVariable<unsigned int>("len", table.size());
+    return ALIVE;
+}
+const char *rtc_table_func = R"###(
+FLAMEGPU_AGENT_FUNCTION(rtc_table_func, flamegpu::MessageNone, flamegpu::MessageNone) {
+    const auto table = FLAMEGPU->environment.getTable<float>("table");
+    const unsigned int x = FLAMEGPU->getVariable<unsigned int>("x");
+    FLAMEGPU->setVariable<float>("y", table[(x * 3) % table.size()]);
+    FLAMEGPU->setVariable<unsigned int>("len", table.size());
+    return flamegpu::ALIVE;
+}
+)###";
+
+/**
+ * Builds a model which reads TABLE_FILE_NAME, and checks the results of a single step
+ */
+void runDeviceRead(const bool &rtc) {
+    writeTable();
+    ModelDescription model("model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<unsigned int>("x");
+    agent.newVariable<float>("y", 0.0f);
+    agent.newVariable<unsigned int>("len", 0);
+    model.Environment().newTable<float>("table", TABLE_FILE_NAME);
+    if (rtc) {
+        model.newLayer().addAgentFunction(agent.newRTCFunction("rtc_table_func", rtc_table_func));
+    } else {
+        model.newLayer().addAgentFunction(agent.newFunction("DeviceRead", DeviceRead));
+    }
+    AgentVector population(agent, AGENT_COUNT);
+    for (unsigned int i = 0; i < AGENT_COUNT; ++i)
+        population[i].setVariable<unsigned int>("x", i);
+    {
+        CUDASimulation sim(model);
+        sim.setPopulationData(population);
+        ASSERT_NO_THROW(sim.step());
+        sim.getPopulationData(population);
+    }
+    std::remove(TABLE_FILE_NAME);
+    for (const auto &a : population) {
+        const unsigned int x = a.getVariable<unsigned int>("x");
+        EXPECT_EQ(a.getVariable<float>("y"), ((x * 3) % TABLE_LEN) * 0.5f);
+        EXPECT_EQ(a.getVariable<unsigned int>("len"), TABLE_LEN);
+    }
+}
+TEST(EnvironmentTableTest, DeviceRead) {
+    runDeviceRead(false);
+}
+TEST(EnvironmentTableTest, DeviceRead_RTC) {
+    runDeviceRead(true);
+}
+TEST(EnvironmentTableTest, SharedBetweenSimulations) {
+    writeTable();
+    ModelDescription model("model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<unsigned int>("x");
+    agent.newVariable<float>("y", 0.0f);
+    agent.newVariable<unsigned int>("len", 0);
+    model.Environment().newTable<float>("table", TABLE_FILE_NAME);
+    model.newLayer().addAgentFunction(agent.newFunction("DeviceRead", DeviceRead));
+    AgentVector population(agent, AGENT_COUNT);
+    {
+        CUDASimulation sim1(model);
+        CUDASimulation sim2(model);
+        sim1.setPopulationData(population);
+        sim2.setPopulationData(population);
+        ASSERT_NO_THROW(sim1.step());
+        ASSERT_NO_THROW(sim2.step());
+        // Both simulations, and this test, hold the same upload
+        const auto table = detail::EnvironmentTableCache::getInstance().acquire(TABLE_FILE_NAME);
+        EXPECT_EQ(table.use_count(), 3);
+        EXPECT_EQ(table->length, TABLE_LEN * sizeof(float));
+    }
+    std::remove(TABLE_FILE_NAME);
+}
+TEST(EnvironmentTableTest, ReloadedWhenFileChanges) {
+    writeTable();
+    const auto table1 = detail::EnvironmentTableCache::getInstance().acquire(TABLE_FILE_NAME);
+    EXPECT_EQ(table1->length, TABLE_LEN * sizeof(float));
+    EXPECT_EQ(detail::EnvironmentTableCache::getInstance().acquire(TABLE_FILE_NAME), table1);
+    {
+        // Rewrite the file with a different length
+        std::vector<float> table(TABLE_LEN / 2, 1.0f);
+        std::ofstream out(TABLE_FILE_NAME, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(float));
+    }
+    // The stale upload is not returned, but remains valid for its existing holders
+    const auto table2 = detail::EnvironmentTableCache::getInstance().acquire(TABLE_FILE_NAME);
+    EXPECT_NE(table2, table1);
+    EXPECT_EQ(table2->length, TABLE_LEN / 2 * sizeof(float));
+    EXPECT_EQ(table1->length, TABLE_LEN * sizeof(float));
+    EXPECT_NE(table1->d_ptr, nullptr);
+    std::remove(TABLE_FILE_NAME);
+}
+TEST(EnvironmentTableTest, MissingFile) {
+    ModelDescription model("model");
+    model.newAgent("agent");
+    model.Environment().newTable<float>("table", "env_table_test_missing.bin");
+    CUDASimulation sim(model);
+    EXPECT_THROW(sim.step(), exception::InvalidFilePath);
+}
+TEST(EnvironmentTableTest, BadFileLength) {
+    {
+        // 6 bytes is not a multiple of sizeof(float)
+        std::ofstream out(BAD_TABLE_FILE_NAME, std::ios::binary);
+        out.write("abcdef", 6);
+    }
+    ModelDescription model("model");
+    model.newAgent("agent");
+    model.Environment().newTable<float>("table", BAD_TABLE_FILE_NAME);
+    CUDASimulation sim(model);
+    EXPECT_THROW(sim.step(), exception::InvalidInputFile);
+    std::remove(BAD_TABLE_FILE_NAME);
+}
+
+}  // namespace test_environment_table
+}  // namespace flamegpu
@@ -6,6 +6,7 @@
  * > set() [per supported type, individual/array/element]
  * > add() [per supported type, individual/array]
  * > remove() (implied by exception tests)
+ * > batch() [individual/array/element, transactional commit, ensemble run plan overrides]
  * exceptions
  */
 
@@ -1257,4 +1258,144 @@ TEST_F(HostEnvironmentTest, reserved_name_set_array) {
     EXPECT_THROW(sim.step(), exception::ReservedName);
 }
 
+FLAMEGPU_STEP_FUNCTION(batch_set_step) {
+    HostEnvironmentBatch batch = FLAMEGPU->environment.batch();
+    batch.setProperty<float>("float_", 3.0f);
+    batch.setProperty<int32_t, TEST_ARRAY_LEN>("int32_t_a_", MiniSim::makeInit<int32_t>(10));
+    batch.setProperty<uint8_t>("uint8_t_a_", TEST_ARRAY_OFFSET, 99);
+    EXPECT_EQ(batch.size(), 3u);
+    // Writes are not visible until committed
+    EXPECT_EQ(FLAMEGPU->environment.getProperty<float>("float_"), static_cast<float>(TEST_VALUE));
+    EXPECT_NO_THROW(batch.commit());
+    EXPECT_EQ(batch.size(), 0u);
+    EXPECT_EQ(FLAMEGPU->environment.getProperty<float>("float_"), 3.0f);
+    const std::array<int32_t, TEST_ARRAY_LEN> int32_a = FLAMEGPU->environment.getProperty<int32_t, TEST_ARRAY_LEN>("int32_t_a_");
+    EXPECT_EQ(int32_a, MiniSim::makeInit<int32_t>(10));
+    std::array<uint8_t, TEST_ARRAY_LEN> uint8_a = MiniSim::makeInit<uint8_t>();
+    uint8_a[TEST_ARRAY_OFFSET] = 99;
+    EXPECT_EQ((FLAMEGPU->environment.getProperty<uint8_t, TEST_ARRAY_LEN>("uint8_t_a_")), uint8_a);
+}
+FLAMEGPU_STEP_FUNCTION(batch_exception_step) {
+    // A failed commit applies none of its writes
+    HostEnvironmentBatch batch = FLAMEGPU->environment.batch();
+    batch.setProperty<float>("float_", 3.0f);
+    batch.setProperty<float>("read_only", 3.0f);
+    EXPECT_THROW(batch.commit(), exception::ReadOnlyEnvProperty);
+    EXPECT_EQ(FLAMEGPU->environment.getProperty<float>("float_"), static_cast<float>(TEST_VALUE));
+    batch.setProperty<float>("float_", 3.0f);
+    batch.setProperty<double>("int32_t_", 3.0);
+    EXPECT_THROW(batch.commit(), exception::InvalidEnvPropertyType);
+    batch.setProperty<float>("float_", 3.0f);
+    batch.setProperty<int32_t>("int32_t_a_", TEST_ARRAY_LEN, 3);
+    EXPECT_THROW(batch.commit(), exception::OutOfBoundsException);
+    batch.setProperty<float>("float_", 3.0f);
+    batch.setProperty<int32_t, 2>("int32_t_a_", { 1, 2 });
+    EXPECT_THROW(batch.commit(), exception::OutOfBoundsException);
+    batch.setProperty<float>("float_", 3.0f);
+    batch.setProperty<float>("does_not_exist", 3.0f);
+    EXPECT_THROW(batch.commit(), exception::InvalidEnvProperty);
+    EXPECT_EQ(FLAMEGPU->environment.getProperty<float>("float_"), static_cast<float>(TEST_VALUE));
+    EXPECT_THROW(batch.setProperty<int>("_", 1), exception::ReservedName);
+    // Uncommitted writes are discarded
+    {
+        HostEnvironmentBatch discarded = FLAMEGPU->environment.batch();
+        discarded.setProperty<float>("float_", 3.0f);
+    }
+    EXPECT_EQ(FLAMEGPU->environment.getProperty<float>("float_"), static_cast<float>(TEST_VALUE));
+}
+TEST_F(HostEnvironmentTest, Batch) {
+    ms->model.addStepFunction(batch_set_step);
+    ms->run(1);
+}
+TEST_F(HostEnvironmentTest, BatchExceptions) {
+    ms->model.addStepFunction(batch_exception_step);
+    ms->run(1);
+}
+FLAMEGPU_INIT_FUNCTION(batch_device_init) {
+    HostEnvironmentBatch batch = FLAMEGPU->environment.batch();
+    batch.setProperty<float>("a", 2.0f);
+    batch.setProperty<int, 3>("b", { 4, 5, 6 });
+    batch.commit();
+}
+FLAMEGPU_AGENT_FUNCTION(batch_device_read, MessageNone, MessageNone) {
+    FLAMEGPU->setVariable<float>("a", FLAMEGPU->environment.getProperty<float>("a"));
+    FLAMEGPU->setVariable<int>("b", FLAMEGPU->environment.getProperty<int>("b", 2));
+    return ALIVE;
+}
+TEST(HostEnvironmentBatchTest, DeviceVisible) {
+    ModelDescription model("model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<float>("a", 0.0f);
+    agent.newVariable<int>("b", 0);
+    model.Environment().newProperty<float>("a", 1.0f);
+    model.Environment().newProperty<int, 3>("b", { 1, 2, 3 });
+    model.addInitFunction(batch_device_init);
+    model.newLayer().addAgentFunction(agent.newFunction("batch_device_read", batch_device_read));
+    AgentVector population(agent, TEST_LEN);
+    CUDASimulation sim(model);
+    sim.SimulationConfig().steps = 1;
+    sim.setPopulationData(population);
+    ASSERT_NO_THROW(sim.simulate());
+    sim.getPopulationData(population);
+    for (const auto &a : population) {
+        EXPECT_EQ(a.getVariable<float>("a"), 2.0f);
+        EXPECT_EQ(a.getVariable<int>("b"), 6);
+    }
+}
+
+FLAMEGPU_INIT_FUNCTION(ensemble_override_init) {
+    for (unsigned int i = 0; i < 10; ++i) {
+        FLAMEGPU->agent("agent").newAgent();
+    }
+}
+/**
+ * Overrides applied to one run of an ensemble must not leak into later runs, which reuse the same runner thread
+ */
+TEST(HostEnvironmentBatchTest, EnsembleOverrideNotRetained) {
+    ModelDescription model("model");
+    AgentDescription &agent = model.newAgent("agent");
+    agent.newVariable<float>("a", 0.0f);
+    agent.newVariable<int>("b", 0);
+    model.Environment().newProperty<float>("a", 1.0f);
+    model.Environment().newProperty<int, 3>("b", { 1, 2, 3 });
+    model.Environment().newProperty<int>("c", 7, true);
+    model.addInitFunction(ensemble_override_init);
+    model.newLayer().addAgentFunction(agent.newFunction("batch_device_read", batch_device_read));
+    LoggingConfig exit_log(model);
+    exit_log.logEnvironment("a");
+    exit_log.logEnvironment("b");
+    exit_log.logEnvironment("c");
+    exit_log.agent("agent").logMean<float>("a");
+    exit_log.agent("agent").logMean<int>("b");
+    // Only the first run overrides properties, including a const property
+    RunPlanVector plans(model, 2);
+    plans.setSteps(1);
+    plans[0].setProperty<float>("a", 2.0f);
+    plans[0].setProperty<int, 3>("b", { 4, 5, 6 });
+    plans[0].setProperty<int>("c", 8);
+    CUDAEnsemble ensemble(model);
+    ensemble.Config().concurrent_runs = 1;
+    ensemble.Config().quiet = true;
+    ensemble.setExitLog(exit_log);
+    ensemble.simulate(plans);
+    const auto &logs = ensemble.getLogs();
+    ASSERT_EQ(logs.size(), 2u);
+    {
+        const auto &exit = logs[0].getExitLog();
+        EXPECT_EQ(exit.getEnvironmentProperty<float>("a"), 2.0f);
+        EXPECT_EQ((exit.getEnvironmentProperty<int, 3>("b")), (std::array<int, 3>{ 4, 5, 6 }));
+        EXPECT_EQ(exit.getEnvironmentProperty<int>("c"), 8);
+        EXPECT_EQ(exit.getAgent("agent").getMean("a"), 2.0);
+        EXPECT_EQ(exit.getAgent("agent").getMean("b"), 6.0);
+    }
+    {
+        const auto &exit = logs[1].getExitLog();
+        EXPECT_EQ(exit.getEnvironmentProperty<float>("a"), 1.0f);
+        EXPECT_EQ((exit.getEnvironmentProperty<int, 3>("b")), (std::array<int, 3>{ 1, 2, 3 }));
+        EXPECT_EQ(exit.getEnvironmentProperty<int>("c"), 7);
+        EXPECT_EQ(exit.getAgent("agent").getMean("a"), 1.0);
+        EXPECT_EQ(exit.getAgent("agent").getMean("b"), 3.0);
+    }
+}
+
 }  // namespace flamegpu
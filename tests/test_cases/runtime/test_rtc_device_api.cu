@@ -1,3 +1,5 @@
+#include <limits>
+
 #include "flamegpu/flamegpu.h"
 
 #include "gtest/gtest.h"
@@ -669,6 +671,78 @@ TEST(DeviceRTCAPITest, AgentFunction_env) {
     }
 }
 
+const char* rtc_env_folded_func = R"###(
+FLAMEGPU_AGENT_FUNCTION(rtc_env_folded_func, flamegpu::MessageNone, flamegpu::MessageNone) {
+    // Const properties are folded, so the loop bound is a compile time constant
+    const unsigned int count = FLAMEGPU->environment.getProperty<unsigned int>("count");
+    int total = 0;
+    for (unsigned int i = 0; i < count; ++i) {
+        total += FLAMEGPU->environment.getProperty<int>("weights", i);
+    }
+    FLAMEGPU->setVariable<int>("total", total);
+    FLAMEGPU->setVariable<double>("scale", FLAMEGPU->environment.getProperty<double>("scale"));
+    FLAMEGPU->setVariable<char>("flag", FLAMEGPU->environment.getProperty<char>("flag"));
+    FLAMEGPU->setVariable<float>("offset", FLAMEGPU->environment.getProperty<float>("offsets", 0) + FLAMEGPU->environment.getProperty<float>("offsets", 1));
+    FLAMEGPU->setVariable<int64_t>("lowest", FLAMEGPU->environment.getProperty<int64_t>("lowest"));
+    // Non-const properties are still read at runtime
+    FLAMEGPU->setVariable<int>("mutable_out", FLAMEGPU->getVariable<int>("mutable_out") + FLAMEGPU->environment.getProperty<int>("mutable"));
+    return flamegpu::ALIVE;
+}
+)###";
+FLAMEGPU_STEP_FUNCTION(rtc_env_folded_step) {
+    FLAMEGPU->environment.setProperty<int>("mutable", 10);
+}
+/**
+ * Runs rtc_env_folded_func with the const properties folded into the dynamic header
+ */
+void runFoldedConstants(const double &scale) {
+    ModelDescription model("model");
+    AgentDescription& agent = model.newAgent("agent_name");
+    agent.newVariable<int>("total", 0);
+    agent.newVariable<double>("scale", 0);
+    agent.newVariable<char>("flag", 0);
+    agent.newVariable<float>("offset", 0);
+    agent.newVariable<int64_t>("lowest", 0);
+    agent.newVariable<int>("mutable_out", 0);
+    model.newLayer().addAgentFunction(agent.newRTCFunction("rtc_env_folded_func", rtc_env_folded_func));
+    model.addStepFunction(rtc_env_folded_step);
+    EnvironmentDescription& env = model.Environment();
+    env.newProperty<unsigned int>("count", 3, true);
+    env.newProperty<int, 4>("weights", { 1, 2, 4, 8 }, true);
+    env.newProperty<double>("scale", scale, true);
+    env.newProperty<char>("flag", 'F', true);
+    env.newProperty<float, 2>("offsets", { 0.1f, -2.5f }, true);
+    env.newProperty<int64_t>("lowest", std::numeric_limits<int64_t>::min(), true);
+    env.newProperty<int>("mutable", 5);
+    CUDASimulation cudaSimulation(model);
+    cudaSimulation.CUDAConfig().foldRTCConstants = true;
+    cudaSimulation.applyConfig();
+    AgentVector init_population(agent, AGENT_COUNT);
+    cudaSimulation.setPopulationData(init_population);
+    cudaSimulation.SimulationConfig().steps = 2;
+    ASSERT_NO_THROW(cudaSimulation.simulate());
+    AgentVector population(agent);
+    cudaSimulation.getPopulationData(population);
+    ASSERT_EQ(population.size(), AGENT_COUNT);
+    for (AgentVector::Agent instance : population) {
+        EXPECT_EQ(instance.getVariable<int>("total"), 7);
+        EXPECT_EQ(instance.getVariable<double>("scale"), scale);
+        EXPECT_EQ(instance.getVariable<char>("flag"), 'F');
+        EXPECT_EQ(instance.getVariable<float>("offset"), 0.1f + -2.5f);
+        EXPECT_EQ(instance.getVariable<int64_t>("lowest"), std::numeric_limits<int64_t>::min());
+        // 5 (from step 1) + 10 (from step 2)
+        EXPECT_EQ(instance.getVariable<int>("mutable_out"), 15);
+    }
+}
+/**
+ * Test const environment properties folded into RTC agent functions
+ * The second run has a different folded value, so must not reuse the first run's cached kernel
+ */
+TEST(DeviceRTCAPITest, AgentFunction_env_folded) {
+    runFoldedConstants(0.125);
+    runFoldedConstants(-3.75e10);
+}
+
 const char* rtc_agent_output_func = R"###(
 FLAMEGPU_AGENT_FUNCTION(rtc_agent_output_func, flamegpu::MessageNone, flamegpu::MessageNone) {
     unsigned int id = FLAMEGPU->getVariable<unsigned int>("id") + 1;
@@ -0,0 +1,83 @@
+#include <utility>
+#include <vector>
+
+#include "flamegpu/util/detail/CSRGraph.cuh"
+
+#include "gtest/gtest.h"
+namespace flamegpu {
+
+using util::detail::CSRGraph;
+
+TEST(TestCSRGraph, Build) {
+    CSRGraph graph(4);
+    EXPECT_EQ(graph.getVertexCount(), 4u);
+    EXPECT_EQ(graph.getEdgeCount(), 0u);
+    graph.build({ {2, 0}, {0, 3}, {2, 1}, {0, 1} });
+    EXPECT_EQ(graph.getEdgeCount(), 4u);
+    // Edges retain their listed order within their source vertex
+    EXPECT_EQ(graph.getNeighbours(0), std::vector<unsigned int>({ 3, 1 }));
+    EXPECT_EQ(graph.getNeighbours(1), std::vector<unsigned int>());
+    EXPECT_EQ(graph.getNeighbours(2), std::vector<unsigned int>({ 0, 1 }));
+    EXPECT_EQ(graph.getDegree(3), 0u);
+    // Each vertex's slot range holds its edges, and spare slots
+    const std::vector<unsigned int> &offsets = graph.getOffsets();
+    ASSERT_EQ(offsets.size(), 5u);
+    for (unsigned int v = 0; v < 4; ++v) {
+        unsigned int begin, end;
+        util::detail::csr::adjacency(offsets.data(), graph.getDegrees().data(), v, begin, end);
+        EXPECT_EQ(end - begin, graph.getDegree(v));
+        EXPECT_GE(offsets[v + 1] - end, CSRGraph::MIN_SLACK + 0);
+    }
+    EXPECT_EQ(graph.getEdges().size(), offsets[4]);
+    EXPECT_TRUE(graph.getLayoutChanged());
+}
+TEST(TestCSRGraph, EditInPlace) {
+    CSRGraph graph(6);
+    graph.build({ {1, 2}, {4, 5} });
+    graph.clearDirty();
+    const std::vector<unsigned int> offsets = graph.getOffsets();
+    // Edits within the spare slots do not move the layout
+    EXPECT_TRUE(graph.addEdge(1, 3));
+    EXPECT_FALSE(graph.addEdge(1, 3));
+    EXPECT_TRUE(graph.removeEdge(4, 5));
+    EXPECT_FALSE(graph.removeEdge(4, 5));
+    EXPECT_TRUE(graph.addEdge(2, 0));
+    EXPECT_FALSE(graph.getLayoutChanged());
+    EXPECT_EQ(graph.getOffsets(), offsets);
+    EXPECT_EQ(graph.getNeighbours(1), std::vector<unsigned int>({ 2, 3 }));
+    EXPECT_TRUE(graph.hasEdge(2, 0));
+    EXPECT_FALSE(graph.hasEdge(4, 5));
+    // Adjacent edited vertices are merged into a single range
+    const std::vector<std::pair<unsigned int, unsigned int>> expected = { {1, 3}, {4, 5} };
+    EXPECT_EQ(graph.getDirtyRanges(), expected);
+    graph.clearDirty();
+    EXPECT_TRUE(graph.getDirtyRanges().empty());
+}
+TEST(TestCSRGraph, Relayout) {
+    CSRGraph graph(12);
+    graph.build({ {1, 0} });
+    graph.clearDirty();
+    // Filling a vertex's spare slots rebuilds the layout, without losing edges
+    std::vector<unsigned int> expected = { 0 };
+    for (unsigned int i = 0; i < 10; ++i) {
+        graph.addEdge(1, 2 + i);
+        expected.push_back(2 + i);
+    }
+    EXPECT_TRUE(graph.getLayoutChanged());
+    EXPECT_EQ(graph.getNeighbours(1), expected);
+    EXPECT_EQ(graph.getDegree(0), 0u);
+    EXPECT_EQ(graph.getDegree(2), 0u);
+    EXPECT_EQ(graph.getEdgeCount(), 11u);
+    // Edges removed retain the order of the remaining edges
+    graph.removeEdge(1, 0);
+    graph.removeEdge(1, 7);
+    expected.erase(expected.begin() + 6);
+    expected.erase(expected.begin());
+    EXPECT_EQ(graph.getNeighbours(1), expected);
+    // Reset removes all edges
+    graph.reset(2);
+    EXPECT_EQ(graph.getVertexCount(), 2u);
+    EXPECT_EQ(graph.getEdgeCount(), 0u);
+}
+
+}  // namespace flamegpu
@@ -0,0 +1,68 @@
+#include "flamegpu/util/detail/CalendarQueue.cuh"
+
+#include "gtest/gtest.h"
+namespace flamegpu {
+
+using util::detail::CalendarQueue;
+
+TEST(TestCalendarQueue, Empty) {
+    CalendarQueue calendar(8);
+    EXPECT_EQ(calendar.getBucketCount(), 8u);
+    EXPECT_EQ(calendar.getBaseStep(), 0u);
+    EXPECT_EQ(calendar.nextEvent(), CalendarQueue::UNKNOWN);
+    EXPECT_EQ(calendar.dueBy(0), 0u);
+    EXPECT_EQ(calendar.dueBy(8), 0u);
+    EXPECT_EQ(calendar.dueBy(1000), 0u);
+}
+TEST(TestCalendarQueue, InsertWithinYear) {
+    CalendarQueue calendar(8);
+    calendar.reset(10);
+    // Events at or before the base step are not scheduled
+    calendar.insert(0);
+    calendar.insert(10);
+    calendar.insert(12);
+    calendar.insert(12);
+    calendar.insert(15);
+    calendar.insert(18);
+    EXPECT_EQ(calendar.getBaseStep(), 10u);
+    EXPECT_EQ(calendar.nextEvent(), 12u);
+    EXPECT_EQ(calendar.dueBy(10), 0u);
+    EXPECT_EQ(calendar.dueBy(11), 0u);
+    EXPECT_EQ(calendar.dueBy(12), 2u);
+    EXPECT_EQ(calendar.dueBy(14), 2u);
+    EXPECT_EQ(calendar.dueBy(15), 3u);
+    EXPECT_EQ(calendar.dueBy(18), 4u);
+    // Nothing was scheduled beyond the year
+    EXPECT_EQ(calendar.dueBy(100), 4u);
+    // Buckets wrap around the year
+    EXPECT_EQ(calendar.data()[CalendarQueue::bucketOf(12, 8)], 2u);
+    EXPECT_EQ(calendar.data()[CalendarQueue::bucketOf(18, 8)], 1u);
+    EXPECT_EQ(CalendarQueue::bucketOf(18, 8), 2u);
+}
+TEST(TestCalendarQueue, InsertBeyondYear) {
+    CalendarQueue calendar(8);
+    calendar.reset(10);
+    calendar.insert(30);
+    calendar.insert(25);
+    EXPECT_EQ(calendar.nextEvent(), 25u);
+    // Events beyond the year are only tracked by the earliest of them
+    EXPECT_EQ(calendar.dueBy(18), 0u);
+    EXPECT_EQ(calendar.dueBy(24), 0u);
+    EXPECT_EQ(calendar.dueBy(25), CalendarQueue::UNKNOWN);
+    calendar.insert(14);
+    EXPECT_EQ(calendar.nextEvent(), 14u);
+    EXPECT_EQ(calendar.dueBy(24), 1u);
+}
+TEST(TestCalendarQueue, Reset) {
+    CalendarQueue calendar(8);
+    calendar.reset(10);
+    calendar.insert(12);
+    calendar.insert(40);
+    calendar.reset(20);
+    EXPECT_EQ(calendar.getBaseStep(), 20u);
+    EXPECT_EQ(calendar.nextEvent(), CalendarQueue::UNKNOWN);
+    EXPECT_EQ(calendar.dueBy(28), 0u);
+    EXPECT_EQ(calendar.data()[8], CalendarQueue::UNKNOWN);
+}
+
+}  // namespace flamegpu
@@ -0,0 +1,96 @@
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "flamegpu/util/detail/MessageTile.cuh"
+
+#include "gtest/gtest.h"
+namespace flamegpu {
+
+namespace tile = util::detail::tile;
+
+TEST(TestMessageTile, Hash) {
+    // Literal and runtime names hash identically
+    EXPECT_EQ(tile::hash("x"), tile::hash(std::string("x")));
+    EXPECT_EQ(tile::hash("velocity"), tile::hash(std::string("velocity")));
+    EXPECT_NE(tile::hash("x"), tile::hash("y"));
+    EXPECT_NE(tile::hash("xy"), tile::hash("yx"));
+}
+TEST(TestMessageTile, Length) {
+    // Tiles hold a multiple of 8 messages, which fit within the buffer
+    EXPECT_EQ(tile::length(8192, 28), 288u);
+    EXPECT_LE(tile::length(8192, 28) * 28, 8192u);
+    EXPECT_EQ(tile::length(256, 15), 16u);
+    EXPECT_EQ(tile::length(256, 4), 64u);
+    // Messages which do not fit 8 to a tile are not staged
+    EXPECT_EQ(tile::length(256, 33), 0u);
+    EXPECT_EQ(tile::length(256, 0), 0u);
+}
+TEST(TestMessageTile, Find) {
+    tile::Variable variables[2] = {
+        { nullptr, 4, tile::hash("a"), 0 },
+        { nullptr, 8, tile::hash("b"), 4 } };
+    EXPECT_EQ(tile::find(variables, 2, tile::hash("a")), 0);
+    EXPECT_EQ(tile::find(variables, 2, tile::hash("b")), 1);
+    EXPECT_EQ(tile::find(variables, 2, tile::hash("c")), -1);
+    EXPECT_EQ(tile::find(variables, 0, tile::hash("a")), -1);
+}
+TEST(TestMessageTile, Emulate) {
+    const unsigned int MESSAGE_COUNT = 50;
+    const unsigned int TILE_BYTES = 256;
+    const unsigned int THREADS = 7;
+    // Structure of arrays message list, with word and byte sized variables
+    std::vector<int> a(MESSAGE_COUNT);
+    std::vector<double> b(MESSAGE_COUNT);
+    std::vector<char> c(MESSAGE_COUNT * 3);
+    for (unsigned int i = 0; i < MESSAGE_COUNT; ++i) {
+        a[i] = static_cast<int>(i) * 3;
+        b[i] = i * 0.5;
+        for (unsigned int j = 0; j < 3; ++j)
+            c[i * 3 + j] = static_cast<char>(i + j);
+    }
+    tile::Variable variables[3] = {
+        { reinterpret_cast<const char*>(a.data()), sizeof(int), tile::hash("a"), 0 },
+        { reinterpret_cast<const char*>(b.data()), sizeof(double), tile::hash("b"), sizeof(int) },
+        { c.data(), 3, tile::hash("c"), sizeof(int) + sizeof(double) } };
+    const unsigned int tile_length = tile::length(TILE_BYTES, sizeof(int) + sizeof(double) + 3);
+    ASSERT_EQ(tile_length, 16u);
+    alignas(16) char buffer[TILE_BYTES];
+    unsigned int messages_read = 0;
+    for (unsigned int first = 0; first < MESSAGE_COUNT; first += tile_length) {
+        const unsigned int count = MESSAGE_COUNT - first < tile_length ? MESSAGE_COUNT - first : tile_length;
+        memset(buffer, 0xff, TILE_BYTES);
+        tile::emulate(variables, 3, tile_length, first, count, THREADS, buffer);
+        for (unsigned int slot = 0; slot < count; ++slot) {
+            const unsigned int i = first + slot;
+            EXPECT_EQ(*reinterpret_cast<const int*>(tile::element(variables[0], buffer, tile_length, slot)), a[i]);
+            EXPECT_EQ(*reinterpret_cast<const double*>(tile::element(variables[1], buffer, tile_length, slot)), b[i]);
+            EXPECT_EQ(memcmp(tile::element(variables[2], buffer, tile_length, slot), &c[i * 3], 3), 0);
+            ++messages_read;
+        }
+        // Slots beyond the final message are not written
+        if (count < tile_length) {
+            EXPECT_EQ(*reinterpret_cast<const unsigned int*>(tile::element(variables[0], buffer, tile_length, count)), 0xffffffffu);
+        }
+    }
+    EXPECT_EQ(messages_read, MESSAGE_COUNT);
+}
+TEST(TestMessageTile, Coalesced) {
+    // Consecutive threads copy consecutive words of each variable
+    const unsigned int MESSAGE_COUNT = 16;
+    std::vector<unsigned int> a(MESSAGE_COUNT * 2);
+    for (unsigned int i = 0; i < a.size(); ++i)
+        a[i] = i;
+    tile::Variable variable = { reinterpret_cast<const char*>(a.data()), 2 * sizeof(unsigned int), tile::hash("a"), 0 };
+    alignas(16) char buffer[MESSAGE_COUNT * 2 * sizeof(unsigned int)];
+    for (unsigned int t = 0; t < 8; ++t) {
+        memset(buffer, 0xff, sizeof(buffer));
+        tile::stage(&variable, 1, MESSAGE_COUNT, 0, MESSAGE_COUNT, t, 8, buffer);
+        const unsigned int *words = reinterpret_cast<const unsigned int*>(buffer);
+        for (unsigned int w = 0; w < a.size(); ++w) {
+            EXPECT_EQ(words[w], w % 8 == t ? a[w] : 0xffffffffu);
+        }
+    }
+}
+
+}  // namespace flamegpu
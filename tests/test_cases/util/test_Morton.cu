@@ -0,0 +1,78 @@
+#include <set>
+
+#include "flamegpu/util/detail/Morton.cuh"
+
+#include "gtest/gtest.h"
+namespace flamegpu {
+
+namespace morton = util::detail::morton;
+
+TEST(TestMorton, Spread) {
+    EXPECT_EQ(morton::spread2(0x0000ffffu), 0x55555555u);
+    EXPECT_EQ(morton::spread2(0x5u), 0x11u);
+    EXPECT_EQ(morton::spread3(0x000003ffu), 0x09249249u);
+    EXPECT_EQ(morton::spread3(0x5u), 0x41u);
+    // Bits beyond the supported range are discarded
+    EXPECT_EQ(morton::spread2(0x10000u), 0u);
+    EXPECT_EQ(morton::spread3(0x400u), 0u);
+}
+TEST(TestMorton, TileBits) {
+    const unsigned int cube[3] = { 5, 5, 5 };
+    EXPECT_EQ(morton::tileBits(cube, 3), 3u);
+    const unsigned int slab[3] = { 100, 100, 3 };
+    EXPECT_EQ(morton::tileBits(slab, 3), 2u);
+    EXPECT_EQ(morton::tileCount(100, 2), 25u);
+    EXPECT_EQ(morton::tileCount(3, 2), 1u);
+    const unsigned int square[2] = { 16, 16 };
+    EXPECT_EQ(morton::tileBits(square, 2), 4u);
+    const unsigned int line[2] = { 1, 100 };
+    EXPECT_EQ(morton::tileBits(line, 2), 0u);
+    // Tiles are limited, so that codes within a tile fit within 32 bits
+    const unsigned int huge[3] = { 5000, 5000, 5000 };
+    EXPECT_EQ(morton::tileBits(huge, 3), morton::MAX_TILE_BITS_3D);
+}
+TEST(TestMorton, Encode2D) {
+    const unsigned int tiles[2] = { 1, 1 };
+    EXPECT_EQ(morton::encode2D(0, 0, 2, tiles), 0u);
+    EXPECT_EQ(morton::encode2D(1, 0, 2, tiles), 1u);
+    EXPECT_EQ(morton::encode2D(0, 1, 2, tiles), 2u);
+    EXPECT_EQ(morton::encode2D(1, 1, 2, tiles), 3u);
+    EXPECT_EQ(morton::encode2D(2, 0, 2, tiles), 4u);
+    EXPECT_EQ(morton::encode2D(3, 3, 2, tiles), 15u);
+}
+TEST(TestMorton, Encode3D) {
+    const unsigned int tiles[3] = { 1, 1, 1 };
+    EXPECT_EQ(morton::encode3D(1, 0, 0, 2, tiles), 1u);
+    EXPECT_EQ(morton::encode3D(0, 1, 0, 2, tiles), 2u);
+    EXPECT_EQ(morton::encode3D(0, 0, 1, 2, tiles), 4u);
+    EXPECT_EQ(morton::encode3D(1, 1, 1, 2, tiles), 7u);
+    EXPECT_EQ(morton::encode3D(2, 0, 0, 2, tiles), 8u);
+    EXPECT_EQ(morton::encode3D(3, 3, 3, 2, tiles), 63u);
+}
+TEST(TestMorton, Encode3DTiled) {
+    // Each bin of a grid which is not a multiple of the tile side receives a unique index within the padded bin count
+    const unsigned int gridDim[3] = { 5, 12, 3 };
+    const unsigned int bits = morton::tileBits(gridDim, 3);
+    const unsigned int tiles[3] = {
+        morton::tileCount(gridDim[0], bits),
+        morton::tileCount(gridDim[1], bits),
+        morton::tileCount(gridDim[2], bits)
+    };
+    const unsigned int bin_count = (tiles[0] * tiles[1] * tiles[2]) << (3 * bits);
+    std::set<unsigned int> hashes;
+    for (unsigned int z = 0; z < gridDim[2]; ++z) {
+        for (unsigned int y = 0; y < gridDim[1]; ++y) {
+            for (unsigned int x = 0; x < gridDim[0]; ++x) {
+                const unsigned int hash = morton::encode3D(x, y, z, bits, tiles);
+                EXPECT_LT(hash, bin_count);
+                hashes.insert(hash);
+            }
+        }
+    }
+    EXPECT_EQ(hashes.size(), gridDim[0] * gridDim[1] * gridDim[2]);
+    // Tiles are row-major
+    EXPECT_EQ(morton::encode3D(4, 0, 0, bits, tiles), 1u << (3 * bits));
+    EXPECT_EQ(morton::encode3D(0, 4, 0, bits, tiles), tiles[0] << (3 * bits));
+}
+
+}  // namespace flamegpu
@@ -0,0 +1,64 @@
+#include <vector>
+
+#include "flamegpu/util/detail/NearestNeighbours.cuh"
+
+#include "gtest/gtest.h"
+namespace flamegpu {
+
+namespace knn = util::detail::knn;
+
+TEST(TestNearestNeighbours, Nearer) {
+    // Nearer neighbours are ordered first
+    EXPECT_TRUE(knn::nearer({ 1.0f, 5.0f, 5.0f, 5.0f, 9 }, { 2.0f, 0.0f, 0.0f, 0.0f, 0 }));
+    EXPECT_FALSE(knn::nearer({ 2.0f, 0.0f, 0.0f, 0.0f, 0 }, { 1.0f, 5.0f, 5.0f, 5.0f, 9 }));
+    // Ties are broken by location, then by index
+    EXPECT_TRUE(knn::nearer({ 1.0f, 0.0f, 1.0f, 1.0f, 9 }, { 1.0f, 1.0f, 0.0f, 0.0f, 0 }));
+    EXPECT_TRUE(knn::nearer({ 1.0f, 1.0f, 0.0f, 1.0f, 9 }, { 1.0f, 1.0f, 1.0f, 0.0f, 0 }));
+    EXPECT_TRUE(knn::nearer({ 1.0f, 1.0f, 1.0f, 0.0f, 9 }, { 1.0f, 1.0f, 1.0f, 1.0f, 0 }));
+    EXPECT_TRUE(knn::nearer({ 1.0f, 1.0f, 1.0f, 1.0f, 0 }, { 1.0f, 1.0f, 1.0f, 1.0f, 9 }));
+    // A neighbour is not nearer than itself
+    EXPECT_FALSE(knn::nearer({ 1.0f, 1.0f, 1.0f, 1.0f, 3 }, { 1.0f, 1.0f, 1.0f, 1.0f, 3 }));
+}
+TEST(TestNearestNeighbours, Insert) {
+    const unsigned int K = 3;
+    knn::Neighbour list[K];
+    unsigned int count = 0;
+    knn::insert(list, count, K, { 4.0f, 2.0f, 0.0f, 0.0f, 0 });
+    EXPECT_EQ(count, 1u);
+    knn::insert(list, count, K, { 9.0f, 3.0f, 0.0f, 0.0f, 1 });
+    knn::insert(list, count, K, { 1.0f, 1.0f, 0.0f, 0.0f, 2 });
+    EXPECT_EQ(count, 3u);
+    EXPECT_EQ(list[0].index, 2u);
+    EXPECT_EQ(list[1].index, 0u);
+    EXPECT_EQ(list[2].index, 1u);
+    // A further neighbour than the furthest held is discarded
+    knn::insert(list, count, K, { 16.0f, 4.0f, 0.0f, 0.0f, 3 });
+    EXPECT_EQ(count, 3u);
+    EXPECT_EQ(list[2].index, 1u);
+    // A nearer neighbour displaces the furthest held
+    knn::insert(list, count, K, { 1.0f, -1.0f, 0.0f, 0.0f, 4 });
+    EXPECT_EQ(count, 3u);
+    EXPECT_EQ(list[0].index, 4u);
+    EXPECT_EQ(list[1].index, 2u);
+    EXPECT_EQ(list[2].index, 0u);
+}
+TEST(TestNearestNeighbours, Nearest) {
+    const std::vector<float> x = { 0.0f, 1.0f, -1.0f, 0.0f, 3.0f, 0.0f };
+    const std::vector<float> y = { 0.0f, 0.0f, 0.0f, 2.0f, 0.0f, 0.0f };
+    const std::vector<float> z = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, -0.5f };
+    // The nearest neighbour of an origin which coincides with a location is that location
+    std::vector<knn::Neighbour> result = knn::nearest(x.data(), y.data(), z.data(), 6, 0.0f, 0.0f, 0.0f, 4, 10.0f);
+    ASSERT_EQ(result.size(), 4u);
+    EXPECT_EQ(result[0].index, 0u);
+    EXPECT_EQ(result[1].index, 5u);
+    // Equidistant locations are ordered by x
+    EXPECT_EQ(result[2].index, 2u);
+    EXPECT_EQ(result[3].index, 1u);
+    // Locations beyond the max radius are not returned
+    result = knn::nearest(x.data(), y.data(), z.data(), 6, 0.0f, 0.0f, 0.0f, 6, 2.0f);
+    ASSERT_EQ(result.size(), 5u);
+    EXPECT_EQ(result[4].index, 3u);
+    EXPECT_EQ(result[4].dist2, 4.0f);
+}
+
+}  // namespace flamegpu
@@ -0,0 +1,104 @@
+#include <set>
+#include <vector>
+
+#include "flamegpu/util/detail/SpatialHash.cuh"
+
+#include "gtest/gtest.h"
+namespace flamegpu {
+
+namespace spatial_hash = util::detail::spatial_hash;
+
+TEST(TestSpatialHash, CellCoord) {
+    EXPECT_EQ(spatial_hash::cellCoord(0.0f, 1.0f), 0);
+    EXPECT_EQ(spatial_hash::cellCoord(0.5f, 1.0f), 0);
+    EXPECT_EQ(spatial_hash::cellCoord(2.5f, 1.0f), 2);
+    // Negative locations round towards negative infinity
+    EXPECT_EQ(spatial_hash::cellCoord(-0.5f, 1.0f), -1);
+    EXPECT_EQ(spatial_hash::cellCoord(-2.0f, 1.0f), -2);
+    EXPECT_EQ(spatial_hash::cellCoord(1000.0f, 10.0f), 100);
+}
+TEST(TestSpatialHash, CellKey) {
+    // Neighbouring cells have distinct keys
+    std::set<unsigned long long> keys;
+    for (int x = -1; x <= 1; ++x) {
+        for (int y = -1; y <= 1; ++y) {
+            for (int z = -1; z <= 1; ++z) {
+                const unsigned long long key = spatial_hash::cellKey(x, y, z);
+                EXPECT_NE(key, spatial_hash::EMPTY_KEY);
+                keys.insert(key);
+            }
+        }
+    }
+    EXPECT_EQ(keys.size(), 27u);
+    // Axis are not interchangeable
+    EXPECT_NE(spatial_hash::cellKey(1, 0, 0), spatial_hash::cellKey(0, 1, 0));
+    EXPECT_NE(spatial_hash::cellKey(0, 1, 0), spatial_hash::cellKey(0, 0, 1));
+    // Coordinates beyond the representable range wrap
+    const int wrap = 1 << spatial_hash::CELL_BITS;
+    EXPECT_EQ(spatial_hash::cellKey(5, 0, 0), spatial_hash::cellKey(5 + wrap, 0, 0));
+    EXPECT_EQ(spatial_hash::cellKey(0, -5, 0), spatial_hash::cellKey(0, -5 - wrap, 0));
+    EXPECT_NE(spatial_hash::cellKey(wrap, 0, 0), spatial_hash::cellKey(wrap + 1, 0, 0));
+}
+TEST(TestSpatialHash, CellKeyLargeCoordinates) {
+    // Neighbourhoods beyond 2^20 cells, and across the wrap, still have 27 distinct keys
+    const int centres[] = { (1 << 20) - 1, 1 << 20, -(1 << 20) - 1, (1 << 21) - 1, 1 << 21, 1 << 24, -(1 << 24), 0x7ffffffe, -0x7ffffffe };
+    for (const int c : centres) {
+        std::set<unsigned long long> keys;
+        for (int x = -1; x <= 1; ++x) {
+            for (int y = -1; y <= 1; ++y) {
+                for (int z = -1; z <= 1; ++z) {
+                    const unsigned long long key = spatial_hash::cellKey(c + x, c + y, -c + z);
+                    EXPECT_NE(key, spatial_hash::EMPTY_KEY);
+                    keys.insert(key);
+                }
+            }
+        }
+        EXPECT_EQ(keys.size(), 27u);
+    }
+}
+TEST(TestSpatialHash, TableSize) {
+    EXPECT_EQ(spatial_hash::tableSize(0), spatial_hash::MIN_TABLE_SIZE);
+    EXPECT_EQ(spatial_hash::tableSize(8), 16u);
+    EXPECT_EQ(spatial_hash::tableSize(9), 32u);
+    EXPECT_EQ(spatial_hash::tableSize(1000), 2048u);
+    EXPECT_EQ(spatial_hash::tableSize(1024), 2048u);
+    EXPECT_EQ(spatial_hash::tableSize(1025), 4096u);
+}
+TEST(TestSpatialHash, InsertFind) {
+    const unsigned int TABLE_SIZE = spatial_hash::tableSize(100);
+    std::vector<unsigned long long> table(TABLE_SIZE, spatial_hash::EMPTY_KEY);
+    // Cells spread sparsely across a large domain
+    std::vector<unsigned long long> keys;
+    for (int i = 0; i < 100; ++i) {
+        keys.push_back(spatial_hash::cellKey(i * 977 - 50000, -i * 31, i * i));
+    }
+    std::set<unsigned int> slots;
+    for (const auto &key : keys) {
+        const unsigned int slot = spatial_hash::insert(table.data(), TABLE_SIZE, key);
+        ASSERT_NE(slot, spatial_hash::NOT_FOUND);
+        slots.insert(slot);
+    }
+    // Each key has it's own slot
+    EXPECT_EQ(slots.size(), keys.size());
+    // Reinserting a key returns the existing slot
+    for (const auto &key : keys) {
+        const unsigned int slot = spatial_hash::findSlot(table.data(), TABLE_SIZE, key);
+        EXPECT_EQ(table[slot], key);
+        EXPECT_EQ(spatial_hash::insert(table.data(), TABLE_SIZE, key), slot);
+    }
+    // Unoccupied cells are not found
+    EXPECT_EQ(spatial_hash::findSlot(table.data(), TABLE_SIZE, spatial_hash::cellKey(1, 1, 1)), spatial_hash::NOT_FOUND);
+    EXPECT_EQ(spatial_hash::findSlot(table.data(), TABLE_SIZE, spatial_hash::cellKey(-50001, 0, 0)), spatial_hash::NOT_FOUND);
+}
+TEST(TestSpatialHash, Full) {
+    const unsigned int TABLE_SIZE = spatial_hash::MIN_TABLE_SIZE;
+    std::vector<unsigned long long> table(TABLE_SIZE, spatial_hash::EMPTY_KEY);
+    for (unsigned int i = 0; i < TABLE_SIZE; ++i) {
+        EXPECT_NE(spatial_hash::insert(table.data(), TABLE_SIZE, spatial_hash::cellKey(i, 0, 0)), spatial_hash::NOT_FOUND);
+    }
+    // A full table rejects new keys, and lookup of missing keys terminates
+    EXPECT_EQ(spatial_hash::insert(table.data(), TABLE_SIZE, spatial_hash::cellKey(0, 1, 0)), spatial_hash::NOT_FOUND);
+    EXPECT_EQ(spatial_hash::findSlot(table.data(), TABLE_SIZE, spatial_hash::cellKey(0, 1, 0)), spatial_hash::NOT_FOUND);
+}
+
+}  // namespace flamegpu